@@ -82,6 +82,7 @@ void AbstractConfig::loadDefaults(bool addDashes)
    configMapRedefine("connUseRDMA",                "true", addDashes);
    configMapRedefine("connBacklogTCP",             "64", addDashes);
    configMapRedefine("connMaxInternodeNum",        "6", addDashes);
+   configMapRedefine("connMultiplexedRequests",    "0", addDashes);
    configMapRedefine("connFallbackExpirationSecs", "900", addDashes);
    configMapRedefine("connTCPRcvBufSize",          "0", addDashes);
    configMapRedefine("connUDPRcvBufSize",          "0", addDashes);
@@ -177,6 +178,8 @@ void AbstractConfig::applyConfigMap(bool enableException, bool addDashes)
          connBacklogTCP = StringTk::strToUInt(iter->second);
       else if (testConfigMapKeyMatch(iter, "connMaxInternodeNum", addDashes))
          connMaxInternodeNum = StringTk::strToUInt(iter->second);
+      else if (testConfigMapKeyMatch(iter, "connMultiplexedRequests", addDashes))
+         connMultiplexedRequests = StringTk::strToUInt(iter->second);
       else if (testConfigMapKeyMatch(iter, "connNonPrimaryExpiration", addDashes))
       {
          // superseded by connFallbackExpirationSecs, ignored here for config file compatibility
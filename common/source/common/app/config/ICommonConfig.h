@@ -29,6 +29,7 @@ class ICommonConfig
       bool        connUseRDMA;
       unsigned    connBacklogTCP;
       unsigned    connMaxInternodeNum;
+      unsigned    connMultiplexedRequests; // max requests in flight per multiplexed conn (0=off)
       unsigned    connFallbackExpirationSecs;
       int         connTCPRcvBufSize;
       int         connUDPRcvBufSize;
@@ -134,6 +135,11 @@ class ICommonConfig
          return connMaxInternodeNum;
       }
 
+      unsigned getConnMultiplexedRequests() const
+      {
+         return connMultiplexedRequests;
+      }
+
       int getConnFallbackExpirationSecs() const
       {
          return connFallbackExpirationSecs;
@@ -11,12 +11,17 @@
 #define EPOLL_EVENTS_NUM             (8) /* how many events we can take at once from epoll_wait */
 
 
+/**
+ * @param acceptTCP false to only accept RDMA connections (e.g. because TCP connections are accepted
+ *    by the stream listeners, see StreamListenerV2::initTCPListenSock() ).
+ */
 ConnAcceptor::ConnAcceptor(AbstractApp* app, NicAddressList& localNicList,
-   unsigned short listenPort)
+   unsigned short listenPort, bool acceptTCP)
     : PThread("ConnAccept"),
       app(app),
       log("ConnAccept"),
       listenPort(listenPort),
+      acceptTCP(acceptTCP),
       localNicCapsUpdated(false)
 {
 
@@ -92,6 +97,13 @@ bool ConnAcceptor::initSocks()
       return false;
 
    // TCP
+   if(!acceptTCP)
+   {
+      log.log(Log_NOTICE, std::string("Listening for TCP connections in stream listeners: Port ") +
+         StringTk::intToStr(listenPort) );
+      return true;
+   }
+
    try
    {
       tcpListenSock = new StandardSocket(SOCK_STREAM);
@@ -270,10 +282,8 @@ void ConnAcceptor::onIncomingStandardConnection(StandardSocket* sock)
       // hand the socket over to a stream listener
 
       StreamListenerV2* listener = app->getStreamListenerByFD(acceptedSock->getFD() );
-      StreamListenerV2::SockReturnPipeInfo returnInfo(
-         StreamListenerV2::SockPipeReturn_NEWCONN, acceptedSock);
 
-      listener->getSockReturnFD()->write(&returnInfo, sizeof(returnInfo) );
+      listener->returnSock(StreamListenerV2::SockPipeReturn_NEWCONN, acceptedSock);
 
    }
    catch(SocketException& se)
@@ -328,10 +338,8 @@ void ConnAcceptor::onIncomingRDMAConnection(RDMASocket* sock)
          // hand the socket over to a stream listener
 
          StreamListenerV2* listener = app->getStreamListenerByFD(acceptedSock->getFD() );
-         StreamListenerV2::SockReturnPipeInfo returnInfo(
-            StreamListenerV2::SockPipeReturn_NEWCONN, acceptedSock);
 
-         listener->getSockReturnFD()->write(&returnInfo, sizeof(returnInfo) );
+         listener->returnSock(StreamListenerV2::SockPipeReturn_NEWCONN, acceptedSock);
 
       }
       catch(SocketException& se)
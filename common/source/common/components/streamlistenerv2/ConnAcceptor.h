@@ -19,14 +19,18 @@ class AbstractApp; // forward declaration
 class ConnAcceptor : public PThread
 {
    public:
-      ConnAcceptor(AbstractApp* app, NicAddressList& localNicList, unsigned short listenPort);
+      ConnAcceptor(AbstractApp* app, NicAddressList& localNicList, unsigned short listenPort,
+         bool acceptTCP = true);
       virtual ~ConnAcceptor();
 
+      static void applySocketOptions(StandardSocket* sock);
+
 
    private:
       AbstractApp*      app;
       LogContext        log;
       unsigned short    listenPort;
+      bool              acceptTCP; // false if the stream listeners accept TCP conns themselves
 
       StandardSocket*   tcpListenSock;
       RDMASocket*       rdmaListenSock;
@@ -47,8 +51,6 @@ class ConnAcceptor : public PThread
       void onIncomingStandardConnection(StandardSocket* sock);
       void onIncomingRDMAConnection(RDMASocket* sock);
 
-      void applySocketOptions(StandardSocket* sock);
-
    public:
       void updateLocalNicList(NicAddressList& nicList);
       // getters & setters
@@ -157,6 +157,12 @@ void IncomingPreprocessedMsgWork::releaseSocket(AbstractApp* app, Socket** sock,
 
    sockCopy->unsetStats();
 
+   if(sockCopy->getIsMultiplexedRequest() )
+   { // the multiplexed conn stays with its stream listener, the response is sent on delete
+      delete(sockCopy);
+      return;
+   }
+
    // check for immediate data on rdma sockets
 
    bool gotImmediateDataAvailable = checkRDMASocketImmediateData(app, sockCopy);
@@ -168,11 +174,9 @@ void IncomingPreprocessedMsgWork::releaseSocket(AbstractApp* app, Socket** sock,
 
    // no immediate data available => return the socket to a stream listener
 
-   StreamListenerV2* listener = app->getStreamListenerByFD(sockCopy->getFD() );
-   StreamListenerV2::SockReturnPipeInfo returnInfo(
-      StreamListenerV2::SockPipeReturn_MSGDONE_NOIMMEDIATE, sockCopy);
+   StreamListenerV2* listener = StreamListenerV2::getStreamListenerForSock(app, sockCopy);
 
-   listener->getSockReturnFD()->write(&returnInfo, sizeof(returnInfo) );
+   listener->returnSock(StreamListenerV2::SockPipeReturn_MSGDONE_NOIMMEDIATE, sockCopy);
 }
 
 void IncomingPreprocessedMsgWork::invalidateConnection(Socket* sock)
@@ -228,11 +232,9 @@ bool IncomingPreprocessedMsgWork::checkRDMASocketImmediateData(AbstractApp* app,
       LOG_DEBUG(logContextStr, Log_SPAM,
          std::string("Got immediate data: ") + sock->getPeername() );
 
-      StreamListenerV2* listener = app->getStreamListenerByFD(sock->getFD() );
-      StreamListenerV2::SockReturnPipeInfo returnInfo(
-         StreamListenerV2::SockPipeReturn_MSGDONE_WITHIMMEDIATE, sock);
+      StreamListenerV2* listener = StreamListenerV2::getStreamListenerForSock(app, sock);
 
-      listener->getSockReturnFD()->write(&returnInfo, sizeof(returnInfo) );
+      listener->returnSock(StreamListenerV2::SockPipeReturn_MSGDONE_WITHIMMEDIATE, sock);
 
       return true;
    }
@@ -0,0 +1,207 @@
+#include <common/app/log/LogContext.h>
+#include <common/components/streamlistenerv2/StreamListenerV2.h>
+#include <common/net/message/control/SetChannelMultiplexedMsg.h>
+#include "MultiplexedRequestSocket.h"
+
+#include <endian.h>
+
+
+/**
+ * @param conn the multiplexed conn on which the request was received; the stream listener doesn't
+ *    receive from it before the payload was received and doesn't delete it before this socket
+ *    was deleted.
+ * @param payloadLen length of the msg payload (i.e. everything after the msg header), which is
+ *    still to be received from the conn.
+ */
+MultiplexedRequestSocket::MultiplexedRequestSocket(StreamListenerV2* listener, PooledSocket* conn,
+   uint64_t tag, size_t payloadLen) :
+   listener(listener), conn(conn), tag(tag), numPayloadLeft(payloadLen), failed(false)
+{
+   this->sockType = conn->getSockType();
+   this->peerIP = conn->getPeerIP();
+   this->peername = conn->getPeername();
+
+   setIsDirect(conn->getIsDirect() );
+   setNodeType(conn->getNodeType() );
+   setNodeID(conn->getNodeID() );
+
+   if(conn->getIsAuthenticated() )
+      setIsAuthenticated();
+}
+
+/**
+ * Sends the response and hands the conn back to the stream listener (which disconnects it if the
+ * request failed).
+ */
+MultiplexedRequestSocket::~MultiplexedRequestSocket()
+{
+   bool sendRes = sendResponse();
+
+   listener->returnSock(sendRes ?
+      StreamListenerV2::SockPipeReturn_MULTIPLEXED_DONE :
+      StreamListenerV2::SockPipeReturn_MULTIPLEXED_FAILED, conn);
+}
+
+/**
+ * Send the collected response, tagged like the request.
+ *
+ * @return false if the conn must be disconnected (because the request or the send failed).
+ */
+bool MultiplexedRequestSocket::sendResponse()
+{
+   const char* logContextStr = "MultiplexedRequestSocket (send response)";
+
+   if(failed || numPayloadLeft)
+      return false; // (the worker already logged the reason)
+
+   // the response must be exactly one msg, otherwise the peer would lose track of the stream
+
+   if(unlikely( (responseBuf.size() < NETMSG_MIN_LENGTH) ||
+      (NetMessageHeader::extractMsgLengthFromBuf(&responseBuf[0], responseBuf.size() ) !=
+         responseBuf.size() ) ) )
+   {
+      LogContext(logContextStr).log(Log_NOTICE, "Problem encountered during processing of a "
+         "multiplexed request. Disconnecting: " + peername);
+      return false;
+   }
+
+   try
+   {
+      uint64_t tagLE = htole64(tag);
+
+      struct iovec iov[2] = {
+         {&tagLE, NETMSG_MULTIPLEXED_TAG_LENGTH},
+         {&responseBuf[0], responseBuf.size()} };
+
+      const std::lock_guard<Mutex> sendLock(conn->getMultiplexSendMutex() );
+
+      conn->sendv(iov, 2, 0);
+   }
+   catch(SocketException& e)
+   {
+      LogContext(logContextStr).log(Log_NOTICE,
+         "Connection error: " + peername + ": " + std::string(e.what() ) );
+      return false;
+   }
+
+   return true;
+}
+
+void MultiplexedRequestSocket::connect(const char* hostname, uint16_t port)
+{
+   throw SocketException("Multiplexed request doesn't support connect");
+}
+
+void MultiplexedRequestSocket::connect(const SocketAddress& serv_addr)
+{
+   throw SocketException("Multiplexed request doesn't support connect");
+}
+
+void MultiplexedRequestSocket::bindToAddr(const SocketAddress& ipAddr)
+{
+   throw SocketException("Multiplexed request doesn't support bind");
+}
+
+void MultiplexedRequestSocket::listen()
+{
+   throw SocketException("Multiplexed request doesn't support listen");
+}
+
+Socket* MultiplexedRequestSocket::accept(struct sockaddr_storage* addr, socklen_t* addrLen)
+{
+   throw SocketException("Multiplexed request doesn't support accept");
+}
+
+/**
+ * Note: The multiplexed conn will be disconnected by its stream listener when this socket is
+ * deleted.
+ */
+void MultiplexedRequestSocket::shutdown()
+{
+   failed = true;
+}
+
+void MultiplexedRequestSocket::shutdownAndRecvDisconnect(int timeoutMS)
+{
+   failed = true;
+}
+
+#ifdef BEEGFS_NVFS
+ssize_t MultiplexedRequestSocket::read(const void *buf, size_t len, unsigned lkey,
+   const uint64_t rbuf, unsigned rkey)
+{
+   throw SocketException("Multiplexed request doesn't support RDMA read");
+}
+
+ssize_t MultiplexedRequestSocket::write(const void *buf, size_t len, unsigned lkey,
+   const uint64_t rbuf, unsigned rkey)
+{
+   throw SocketException("Multiplexed request doesn't support RDMA write");
+}
+#endif /* BEEGFS_NVFS */
+
+/**
+ * Append to the response (which is sent on delete).
+ *
+ * @throw SocketException if the request processing failed before
+ */
+ssize_t MultiplexedRequestSocket::send(const void *buf, size_t len, int flags)
+{
+   if(unlikely(failed) )
+      throw SocketDisconnectException("Multiplexed request was already shut down: " + peername);
+
+   responseBuf.insert(responseBuf.end(), (const char*)buf, (const char*)buf + len);
+
+   stats->incVals.netSendBytes += len;
+
+   return len;
+}
+
+ssize_t MultiplexedRequestSocket::sendto(const void *buf, size_t len, int flags,
+   const SocketAddress* to)
+{
+   if(unlikely(to) )
+      throw SocketException("Multiplexed request doesn't support sendto with address");
+
+   return send(buf, len, flags);
+}
+
+ssize_t MultiplexedRequestSocket::recv(void *buf, size_t len, int flags)
+{
+   return recvT(buf, len, flags, -1);
+}
+
+/**
+ * Receive from the request payload. The stream listener is notified when the payload is complete,
+ * so that it can receive the next request from the conn.
+ *
+ * @throw SocketException if the payload was already received completely (there is no more data
+ *    for this request on a multiplexed conn)
+ */
+ssize_t MultiplexedRequestSocket::recvT(void *buf, size_t len, int flags, int timeoutMS)
+{
+   if(unlikely(!numPayloadLeft || failed) )
+      throw SocketException("Multiplexed request has no more data: " + peername);
+
+   ssize_t recvRes;
+
+   try
+   {
+      recvRes = conn->recvT(buf, std::min(len, numPayloadLeft), flags, timeoutMS);
+   }
+   catch(SocketException& e)
+   {
+      failed = true; // (the position in the stream is unknown now)
+      throw;
+   }
+
+   numPayloadLeft -= recvRes;
+
+   stats->incVals.netRecvBytes += recvRes;
+
+   if(!numPayloadLeft)
+      listener->returnSock(StreamListenerV2::SockPipeReturn_MULTIPLEXED_RECVDONE, conn);
+
+   return recvRes;
+}
+
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <common/net/sock/PooledSocket.h>
+#include <common/Common.h>
+
+
+class StreamListenerV2; // forward declaration
+
+
+/**
+ * Stands in for a multiplexed conn during the processing of a single request that was received
+ * on it. The conn itself stays with its stream listener (which keeps receiving more requests from
+ * it), so that the request handlers can't interfere with each other.
+ *
+ * The stream listener only receives tag and msg header of the request. recv() receives the
+ * payload directly from the conn and tells the stream listener when it is complete, so that the
+ * next request can be received. The response is collected from send() and sent (under the send
+ * mutex of the conn) when this socket is deleted, which includes the normal release of a socket
+ * after msg processing (see IncomingPreprocessedMsgWork::releaseSocket() ).
+ *
+ * Note: Raw data streams before or after the messages are not possible on multiplexed conns, so
+ * the client side only multiplexes simple request/response messages.
+ */
+class MultiplexedRequestSocket : public Socket
+{
+   public:
+      MultiplexedRequestSocket(StreamListenerV2* listener, PooledSocket* conn, uint64_t tag,
+         size_t payloadLen);
+      virtual ~MultiplexedRequestSocket();
+
+      virtual void connect(const char* hostname, uint16_t port);
+      virtual void connect(const SocketAddress& serv_addr);
+      virtual void bindToAddr(const SocketAddress& ipAddr);
+      virtual void listen();
+      virtual Socket* accept(struct sockaddr_storage* addr, socklen_t* addrLen);
+      virtual void shutdown();
+      virtual void shutdownAndRecvDisconnect(int timeoutMS);
+
+#ifdef BEEGFS_NVFS
+      virtual ssize_t read(const void *buf, size_t len, unsigned lkey, const uint64_t rbuf, unsigned rkey);
+      virtual ssize_t write(const void *buf, size_t len, unsigned lkey, const uint64_t rbuf, unsigned rkey);
+#endif /* BEEGFS_NVFS */
+
+      virtual ssize_t send(const void *buf, size_t len, int flags);
+      virtual ssize_t sendto(const void *buf, size_t len, int flags, const SocketAddress* to);
+
+      virtual ssize_t recv(void *buf, size_t len, int flags);
+      virtual ssize_t recvT(void *buf, size_t len, int flags, int timeoutMS);
+
+
+   private:
+      StreamListenerV2* listener; // owner of the multiplexed conn
+      PooledSocket* conn; // not deleted by the stream listener before we returned it
+      uint64_t tag;
+
+      size_t numPayloadLeft; // payload bytes that were not received yet
+
+      std::vector<char> responseBuf;
+      bool failed; // true if the conn was shut down during processing
+
+      bool sendResponse();
+
+
+   public:
+      // getters & setters
+      virtual int getFD() const
+      {
+         return conn->getFD();
+      }
+
+      virtual bool getIsMultiplexedRequest() const
+      {
+         return true;
+      }
+};
+
@@ -1,9 +1,13 @@
 #include <common/app/AbstractApp.h>
+#include <common/components/streamlistenerv2/ConnAcceptor.h>
 #include <common/components/streamlistenerv2/IncomingPreprocessedMsgWork.h>
+#include <common/net/message/control/SetChannelMultiplexedMsg.h>
 #include <common/toolkit/StringTk.h>
 #include "StreamListenerV2.h"
 
+#include <endian.h>
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
 
 
 #define EPOLL_EVENTS_NUM             (512) /* make it big to avoid starvation of higher FDs */
@@ -11,7 +15,6 @@
 #define RDMA_CHECK_INTERVAL_MS       (150*60*1000) /* 150mins (must be more than double of the
                                      client-side idle disconnect interval to avoid cases where
                                      server disconnects first) */
-#define SOCKRETURN_SOCKS_NUM         (32)
 
 
 StreamListenerV2::StreamListenerV2(const std::string& listenerID, AbstractApp* app,
@@ -20,6 +23,10 @@ StreamListenerV2::StreamListenerV2(const std::string& listenerID, AbstractApp* a
       app(app),
       log("StreamLisV2"),
       workQueue(workQueue),
+      sockReturnStack(NULL),
+      sockReturnDoorbellRung(false),
+      sockReturnDoorbell(NULL),
+      tcpListenSock(NULL),
       rdmaCheckForceCounter(0),
       useAggressivePoll(false)
 {
@@ -31,30 +38,58 @@ StreamListenerV2::StreamListenerV2(const std::string& listenerID, AbstractApp* a
          System::getErrString() );
    }
 
-   if(!initSockReturnPipe() )
-      throw ComponentInitException("Unable to initialize sock return pipe");
+   if(!initSockReturnDoorbell() )
+      throw ComponentInitException("Unable to initialize sock return doorbell");
 }
 
 StreamListenerV2::~StreamListenerV2()
 {
-   delete(sockReturnPipe);
+   // sockets that were returned, but not handled yet
+   for(SockReturnEntry* entry = sockReturnStack.exchange(NULL); entry; )
+   {
+      SockReturnEntry* nextEntry = entry->next;
+
+      // (multiplexed conns are still in our poll list, see deleteAllConns() )
+      if(!isMultiplexedSockReturn(entry->returnType) )
+         delete(entry->sock);
+
+      delete(entry);
+
+      entry = nextEntry;
+   }
+
+   if(sockReturnDoorbell)
+   {
+      close(sockReturnDoorbell->getFD() );
+      delete(sockReturnDoorbell);
+   }
 
    deleteAllConns();
 
+   SAFE_DELETE(tcpListenSock);
+
    if(epollFD != -1)
       close(epollFD);
 }
 
-bool StreamListenerV2::initSockReturnPipe()
+bool StreamListenerV2::initSockReturnDoorbell()
 {
-   this->sockReturnPipe = new Pipe(false, true);
+   int eventFD = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+   if(eventFD == -1)
+   {
+      log.logErr(std::string("Unable to create sock return eventfd: ") +
+         System::getErrString() );
+      return false;
+   }
+
+   this->sockReturnDoorbell = new FileDescriptor(eventFD, false);
 
    struct epoll_event epollEvent;
    epollEvent.events = EPOLLIN;
-   epollEvent.data.ptr = sockReturnPipe->getReadFD();
-   if(epoll_ctl(epollFD, EPOLL_CTL_ADD, sockReturnPipe->getReadFD()->getFD(), &epollEvent) == -1)
+   epollEvent.data.ptr = sockReturnDoorbell;
+   if(epoll_ctl(epollFD, EPOLL_CTL_ADD, eventFD, &epollEvent) == -1)
    {
-      log.logErr(std::string("Unable to add sock return pipe (read side) to epoll set: ") +
+      log.logErr(std::string("Unable to add sock return eventfd to epoll set: ") +
          System::getErrString() );
       return false;
    }
@@ -62,6 +97,120 @@ bool StreamListenerV2::initSockReturnPipe()
    return true;
 }
 
+/**
+ * Check that no other socket is bound to the TCP port yet, because a listen socket with
+ * SO_REUSEPORT would silently join the group of another process's listen socket (if that one also
+ * uses SO_REUSEPORT and runs as the same user) and share the incoming connections with it.
+ *
+ * Note: To be called once before initTCPListenSock() of the first stream listener. This leaves a
+ * small window between the check and the bind of our own listen sockets, and a process that is
+ * started later with SO_REUSEPORT under the same user can still join our group.
+ *
+ * @throw ComponentInitException if the port is in use.
+ */
+void StreamListenerV2::checkTCPListenPortUnused(unsigned short listenPort)
+{
+   try
+   {
+      StandardSocket probeSock(SOCK_STREAM);
+      probeSock.setSoReuseAddr(true); // (without SO_REUSEPORT to fail on any bound socket)
+      probeSock.bind(listenPort);
+   }
+   catch(SocketException& e)
+   {
+      throw ComponentInitException("TCP port " + StringTk::uintToStr(listenPort) +
+         " is already in use: " + e.what() );
+   }
+}
+
+/**
+ * Find the stream listener that polls the given socket: the one that accepted it through its own
+ * TCP listen socket or otherwise the one that is responsible for its FD.
+ */
+StreamListenerV2* StreamListenerV2::getStreamListenerForSock(AbstractApp* app, Socket* sock)
+{
+   StreamListenerV2* listener = sock->getStreamListener();
+
+   if(listener)
+      return listener;
+
+   return app->getStreamListenerByFD(sock->getFD() );
+}
+
+/**
+ * Accept TCP connections in this stream listener through an own listen socket with SO_REUSEPORT,
+ * so that the kernel distributes incoming connections over all stream listeners instead of a
+ * single ConnAcceptor thread. (RDMA connections are still accepted by the ConnAcceptor.)
+ *
+ * Note: Must be called before this component is started.
+ * Note: See checkTCPListenPortUnused() for the risk of sharing the port with another process.
+ *
+ * @throw ComponentInitException
+ */
+void StreamListenerV2::initTCPListenSock(unsigned short listenPort)
+{
+   try
+   {
+      tcpListenSock = new StandardSocket(SOCK_STREAM);
+      tcpListenSock->setSoReuseAddr(true);
+      tcpListenSock->setSoReusePort(true);
+
+      int bufsize = app->getCommonConfig()->getConnTCPRcvBufSize();
+      if(bufsize > 0)
+         tcpListenSock->setSoRcvBuf(bufsize);
+
+      tcpListenSock->bind(listenPort);
+      tcpListenSock->listen();
+   }
+   catch(SocketException& e)
+   {
+      SAFE_DELETE(tcpListenSock);
+      throw ComponentInitException(std::string("TCP listen socket: ") + e.what() );
+   }
+
+   struct epoll_event epollEvent;
+   epollEvent.events = EPOLLIN;
+   epollEvent.data.ptr = tcpListenSock;
+   if(epoll_ctl(epollFD, EPOLL_CTL_ADD, tcpListenSock->getFD(), &epollEvent) == -1)
+      throw ComponentInitException(std::string("Unable to add TCP listen sock to epoll set: ") +
+         System::getErrString() );
+
+   log.log(Log_DEBUG, std::string("Listening for TCP connections: Port ") +
+      StringTk::intToStr(listenPort) );
+}
+
+/**
+ * Hand a socket over to this stream listener, e.g. from a worker after msg processing or from the
+ * ConnAcceptor for a new connection.
+ *
+ * This is lock-free: The socket is pushed to a stack, which the listener takes as a whole when it
+ * is woken up by the eventfd doorbell. The doorbell is only written if no wakeup is pending yet,
+ * so sockets that are returned while the listener is busy don't cost a syscall.
+ *
+ * Note: Thread-safe.
+ */
+void StreamListenerV2::returnSock(SockPipeReturnType returnType, Socket* sock)
+{
+   pushSockReturnEntry(new SockReturnEntry{returnType, sock, NULL} );
+}
+
+void StreamListenerV2::pushSockReturnEntry(SockReturnEntry* entry)
+{
+   entry->next = sockReturnStack.load();
+
+   while(!sockReturnStack.compare_exchange_weak(entry->next, entry) )
+      ; // (entry->next was updated to the current top of the stack)
+
+   /* note: the listener resets the flag before it takes the stack, so if we see it set here, our
+      entry will be taken by the pending wakeup */
+   if(sockReturnDoorbellRung.exchange(true) )
+      return;
+
+   uint64_t increment = 1;
+   ssize_t writeRes = write(sockReturnDoorbell->getFD(), &increment, sizeof(increment) );
+   IGNORE_UNUSED_VARIABLE(writeRes); // (can't fail with a counter that is reset on every read)
+}
+
 void StreamListenerV2::run()
 {
    try
@@ -86,9 +235,11 @@ void StreamListenerV2::listenLoop()
 
    // (just to have these values on the stack...)
    const int epollFD = this->epollFD;
-   FileDescriptor* sockReturnPipeReadEnd = this->sockReturnPipe->getReadFD();
+   FileDescriptor* sockReturnDoorbell = this->sockReturnDoorbell;
+   StandardSocket* tcpListenSock = this->tcpListenSock;
 
    bool runRDMAConnIdleCheck = false; // true just means we call the method (not enforce the check)
+   bool gotSockReturn;
 
    // wait for incoming events and handle them...
 
@@ -116,18 +267,28 @@ void StreamListenerV2::listenLoop()
          runRDMAConnIdleCheck = true;
       }
 
+      gotSockReturn = false;
+
       // handle incoming data & connection attempts
       for(size_t i=0; i < (size_t)epollRes; i++)
       {
          struct epoll_event* currentEvent = &epollEvents[i];
          Pollable* currentPollable = (Pollable*)currentEvent->data.ptr;
 
-         if(currentPollable == sockReturnPipeReadEnd)
-            onSockReturn();
+         if(currentPollable == sockReturnDoorbell)
+            gotSockReturn = true;
+         else
+         if(currentPollable == tcpListenSock)
+            onIncomingConnection();
          else
             onIncomingData( (Socket*)currentPollable);
       }
 
+      /* note: returned sockets are handled after the other events, because a multiplexed conn
+         might be deleted here while it still has an event in this round */
+      if(gotSockReturn)
+         onSockReturn();
+
       if(unlikely(runRDMAConnIdleCheck) )
       { // note: whether check actually happens depends on elapsed time since last check
          runRDMAConnIdleCheck = false;
@@ -150,6 +311,13 @@ void StreamListenerV2::onIncomingData(Socket* sock)
       return;
    }
 
+   if( (sock->getSockType() == NICADDRTYPE_STANDARD) &&
+      static_cast<PooledSocket*>(sock)->getIsMultiplexed() )
+   {
+      onIncomingMultiplexedData(static_cast<PooledSocket*>(sock) );
+      return;
+   }
+
    try
    {
       const int recvTimeoutMS = 5000;
@@ -228,125 +396,337 @@ void StreamListenerV2::onIncomingData(Socket* sock)
 }
 
 /**
- * Receive pointer to returned socket through the sockReturnPipe and re-add it to the pollList.
+ * Receive tag and msg header of a request from a multiplexed conn and add it to the work queue.
+ *
+ * Other than normal conns, a multiplexed conn stays in our poll set during msg processing: The
+ * worker receives the payload and sends the response itself, and the conn is re-armed as soon as
+ * the payload was received (as long as the peer has credits left), so that more requests can be
+ * received while the previous ones are processed (see onMultiplexedSockReturn() ).
  */
-void StreamListenerV2::onSockReturn()
+void StreamListenerV2::onIncomingMultiplexedData(PooledSocket* sock)
+{
+   try
+   {
+      const int recvTimeoutMS = 5000;
+
+      char frameHeadBuf[NETMSG_MULTIPLEXED_TAG_LENGTH + NETMSG_HEADER_LENGTH];
+      uint64_t tag;
+      NetMessageHeader msgHeader;
+
+      // receive tag & msg header
+
+      sock->recvExactT(frameHeadBuf, sizeof(frameHeadBuf), 0, recvTimeoutMS);
+
+      memcpy(&tag, frameHeadBuf, sizeof(tag) );
+      tag = le64toh(tag);
+
+      NetMessage::deserializeHeader(&frameHeadBuf[NETMSG_MULTIPLEXED_TAG_LENGTH],
+         NETMSG_HEADER_LENGTH, &msgHeader);
+
+      if(unlikely( (msgHeader.msgLength < NETMSG_HEADER_LENGTH) ||
+         (msgHeader.msgLength > NETMSG_MULTIPLEXED_REQUEST_MAXLEN) ) )
+      {
+         log.log(Log_NOTICE, "Received a multiplexed request with invalid length. "
+            "Disconnecting: " + sock->getPeername() );
+
+         disconnectMultiplexedSock(sock);
+         return;
+      }
+
+      const size_t payloadLen = msgHeader.msgLength - NETMSG_HEADER_LENGTH;
+
+      // create work and add it to queue
+
+      IncomingPreprocessedMsgWork* work = new IncomingPreprocessedMsgWork(app,
+         new MultiplexedRequestSocket(this, sock, tag, payloadLen), &msgHeader);
+
+      sock->setHasActivity(); // mark sock as active (for idle disconnect check)
+
+      sock->setMultiplexNumInFlight(sock->getMultiplexNumInFlight() + 1);
+      sock->setMultiplexIsRecvPending(payloadLen != 0);
+
+      LOG_DEBUG("StreamListenerV2::onIncomingMultiplexedData", Log_DEBUG,
+         "Incoming multiplexed message: " + netMessageTypeToStr(msgHeader.msgType) + "; "
+         "from: " + sock->getPeername() + "; "
+         "tag: " + StringTk::uint64ToStr(tag) );
+
+      if (sock->getIsDirect())
+         getWorkQueue(msgHeader.msgTargetID)->addDirectWork(work, msgHeader.msgUserID);
+      else
+         getWorkQueue(msgHeader.msgTargetID)->addIndirectWork(work, msgHeader.msgUserID);
+
+      // payload pending => the next request can't be received before the worker received it
+      if(sock->getMultiplexIsRecvPending() )
+         return;
+
+      // credits exhausted => peer must wait for a response anyways
+      if(sock->getMultiplexNumInFlight() >= sock->getMultiplexCredits() )
+         return;
+
+      if(!rearmMultiplexedSock(sock) )
+         disconnectMultiplexedSock(sock);
+
+      return;
+   }
+   catch(SocketTimeoutException& e)
+   {
+      log.log(Log_NOTICE, "Connection timed out: " + sock->getPeername() );
+   }
+   catch(SocketDisconnectException& e)
+   {
+      // (note: level Log_DEBUG here to avoid spamming the log until we have log topics)
+      log.log(Log_DEBUG, std::string(e.what() ) );
+   }
+   catch(SocketException& e)
+   {
+      log.log(Log_NOTICE,
+         "Connection error: " + sock->getPeername() + ": " + std::string(e.what() ) );
+   }
+
+   // socket exception occurred => cleanup
+
+   disconnectMultiplexedSock(sock);
+}
+
+/**
+ * A worker received the payload of a request of a multiplexed conn or is done with the request
+ * (see MultiplexedRequestSocket).
+ *
+ * Note: The conn is re-armed here if it wasn't re-armed after the last request because the
+ * payload was still pending or the peer had no credits left.
+ */
+void StreamListenerV2::onMultiplexedSockReturn(SockPipeReturnType returnType, PooledSocket* sock)
 {
-   SockReturnPipeInfo returnInfos[SOCKRETURN_SOCKS_NUM];
+   bool wasCreditsExhausted =
+      (sock->getMultiplexNumInFlight() >= sock->getMultiplexCredits() );
 
-   // try to get multiple returnInfos at once (if available)
+   if(returnType == SockPipeReturn_MULTIPLEXED_RECVDONE)
+      sock->setMultiplexIsRecvPending(false);
+   else
+      sock->setMultiplexNumInFlight(sock->getMultiplexNumInFlight() - 1);
+
+   if( (returnType == SockPipeReturn_MULTIPLEXED_FAILED) || sock->getMultiplexIsBroken() )
+   { // (the worker already logged the reason)
+      disconnectMultiplexedSock(sock);
+      return;
+   }
 
-   ssize_t readRes = sockReturnPipe->getReadFD()->read(&returnInfos, sizeof(SockReturnPipeInfo) );
+   if(sock->getMultiplexIsRecvPending() )
+      return; // (re-armed when the payload was received)
 
-   // loop: walk over each info and handle the contained socket
+   if(sock->getMultiplexNumInFlight() >= sock->getMultiplexCredits() )
+      return; // (re-armed when the next response was sent)
 
-   for(size_t i=0; ; i++)
+   // conn wasn't re-armed before if we get here for a received payload or for the first free credit
+   if( (returnType == SockPipeReturn_MULTIPLEXED_RECVDONE) || wasCreditsExhausted)
    {
-      SockReturnPipeInfo& currentReturnInfo = returnInfos[i];
+      if(!rearmMultiplexedSock(sock) )
+         disconnectMultiplexedSock(sock);
+   }
+}
+
+/**
+ * @return false on error (caller should disconnect)
+ */
+bool StreamListenerV2::rearmMultiplexedSock(PooledSocket* sock)
+{
+   struct epoll_event epollEvent;
+   epollEvent.events = EPOLLIN | EPOLLONESHOT | EPOLLET;
+   epollEvent.data.ptr = sock;
 
-      // make sure we have a complete SockReturnPipeInfo
+   if(unlikely(epoll_ctl(epollFD, EPOLL_CTL_MOD, sock->getFD(), &epollEvent) == -1) )
+   {
+      log.logErr("Unable to re-arm multiplexed sock in epoll set. "
+         "FD: " + StringTk::uintToStr(sock->getFD() ) + "; "
+         "SysErr: " + System::getErrString() );
+      return false;
+   }
 
-      if(unlikely(readRes < (ssize_t)sizeof(SockReturnPipeInfo) ) )
-      { // only got a partial SockReturnPipeInfo => recv the rest
-         char* currentReturnInfoChar = (char*)&currentReturnInfo;
+   return true;
+}
 
-         sockReturnPipe->getReadFD()->readExact(
-            &currentReturnInfoChar[readRes], sizeof(SockReturnPipeInfo)-readRes);
+/**
+ * Note: If workers are still processing requests of the conn, it is only shut down (so that the
+ * workers fail quickly) and deleted when the last one returned it (see onMultiplexedSockReturn() ).
+ */
+void StreamListenerV2::disconnectMultiplexedSock(PooledSocket* sock)
+{
+   if(sock->getMultiplexNumInFlight() )
+   {
+      if(!sock->getMultiplexIsBroken() )
+      {
+         sock->setMultiplexIsBroken();
 
-         readRes = sizeof(SockReturnPipeInfo);
+         epoll_ctl(epollFD, EPOLL_CTL_DEL, sock->getFD(), NULL);
+         ::shutdown(sock->getFD(), SHUT_RDWR); // (wakes up workers that receive or send)
       }
 
-      // handle returnInfo depending on contained returnType...
+      return;
+   }
 
-      Socket* currentSock = currentReturnInfo.sock;
-      SockPipeReturnType returnType = currentReturnInfo.returnType;
+   pollList.removeByFD(sock->getFD() );
 
-      switch(returnType)
-      {
-         case SockPipeReturn_MSGDONE_NOIMMEDIATE:
-         { // most likely case: worker is done with a msg and now returns the sock to the epoll set
+   IncomingPreprocessedMsgWork::invalidateConnection(sock); // also includes delete(sock)
+}
 
-            struct epoll_event epollEvent;
-            epollEvent.events = EPOLLIN | EPOLLONESHOT | EPOLLET;
-            epollEvent.data.ptr = currentSock;
+/**
+ * Accept a new connection on our own TCP listen socket (see initTCPListenSock() ).
+ *
+ * The new socket stays with this stream listener (instead of the one that is responsible for its
+ * FD), so that the kernel's distribution of connections is kept and no handover is needed.
+ */
+void StreamListenerV2::onIncomingConnection()
+{
+   try
+   {
+      struct sockaddr_storage peerAddr;
+      socklen_t peerAddrLen = sizeof(peerAddr);
 
-            int epollRes = epoll_ctl(epollFD, EPOLL_CTL_MOD, currentSock->getFD(), &epollEvent);
+      StandardSocket* acceptedSock =
+         reinterpret_cast<StandardSocket*>(tcpListenSock->accept(&peerAddr, &peerAddrLen) );
 
-            if(likely(!epollRes) )
-            { // sock was successfully re-armed in epoll set
-               pollList.add(currentSock);
+      // (note: level Log_DEBUG to avoid spamming the log until we have log topics)
+      log.log(Log_DEBUG, std::string("Accepted new connection from ") +
+         SocketAddress(&peerAddr).toString() +
+         std::string(" [SockFD: ") + StringTk::intToStr(acceptedSock->getFD() ) +
+         std::string("]") );
 
-               break; // break out of switch
-            }
-            else
-            if(errno != ENOENT)
-            { // error
-               log.logErr("Unable to re-arm sock in epoll set. "
-                  "FD: " + StringTk::uintToStr(currentSock->getFD() ) + "; "
-                  "SockTypeNum: " + StringTk::uintToStr(currentSock->getSockType() ) + "; "
-                  "SysErr: " + System::getErrString() );
-               log.log(Log_NOTICE, "Disconnecting: " + currentSock->getPeername() );
+      ConnAcceptor::applySocketOptions(acceptedSock);
 
-               delete(currentSock);
+      acceptedSock->setStreamListener(this); // (workers return the socket to us)
+      handleSockReturn(SockPipeReturn_NEWCONN, acceptedSock);
+   }
+   catch(SocketException& se)
+   {
+      log.logErr(std::string("Trying to continue after connection accept error: ") +
+         se.what() );
+   }
+}
 
-               break; // break out of switch
-            }
+/**
+ * Take all sockets that were handed over through returnSock() and handle them in the order in
+ * which they were returned.
+ */
+void StreamListenerV2::onSockReturn()
+{
+   uint64_t doorbellCounter;
 
-            /* for ENOENT, we fall through to NEWCONN, because this socket appearently wasn't
-               used with this stream listener yet, so we need to add it (instead of modify it) */
+   ssize_t readRes = read(sockReturnDoorbell->getFD(), &doorbellCounter, sizeof(doorbellCounter) );
+   IGNORE_UNUSED_VARIABLE(readRes); // (may be EAGAIN if the doorbell was already consumed)
 
-         } // might fall through here on ENOENT
-         BEEGFS_FALLTHROUGH;
+   sockReturnDoorbellRung = false; // must be reset before we take the stack (see returnSock() )
 
-         case SockPipeReturn_NEWCONN:
-         { // new conn from ConnAcceptor (or wasn't used with this stream listener yet)
+   // the stack is in reverse return order => reverse it to handle the oldest entry first
 
-            // add new socket file descriptor to epoll set
+   SockReturnEntry* entries = NULL;
 
-            struct epoll_event epollEvent;
-            epollEvent.events = EPOLLIN | EPOLLONESHOT | EPOLLET;
-            epollEvent.data.ptr = currentSock;
+   for(SockReturnEntry* entry = sockReturnStack.exchange(NULL); entry; )
+   {
+      SockReturnEntry* nextEntry = entry->next;
 
-            int epollRes = epoll_ctl(epollFD, EPOLL_CTL_ADD, currentSock->getFD(), &epollEvent);
-            if(likely(!epollRes) )
-            { // socket was successfully added to epoll set
-               pollList.add(currentSock);
-            }
-            else
-            { // adding to epoll set failed => unrecoverable error
-               log.logErr("Unable to add sock to epoll set. "
-                  "FD: " + StringTk::uintToStr(currentSock->getFD() ) + " "
-                  "SockTypeNum: " + StringTk::uintToStr(currentSock->getSockType() ) + " "
-                  "SysErr: " + System::getErrString() );
-               log.log(Log_NOTICE, "Disconnecting: " + currentSock->getPeername() );
+      entry->next = entries;
+      entries = entry;
 
-               delete(currentSock);
-            }
+      entry = nextEntry;
+   }
 
-         } break;
+   while(entries)
+   {
+      SockReturnEntry* nextEntry = entries->next;
 
-         case SockPipeReturn_MSGDONE_WITHIMMEDIATE:
-         { // special case: worker detected that immediate data is available after msg processing
-            // data immediately available => recv header and so on
-            onIncomingData(currentSock);
-         } break;
+      if(isMultiplexedSockReturn(entries->returnType) )
+         onMultiplexedSockReturn(entries->returnType, static_cast<PooledSocket*>(entries->sock) );
+      else
+         handleSockReturn(entries->returnType, entries->sock);
 
-         default:
-         { // should never happen: unknown/unhandled returnType
-            log.logErr("Should never happen: "
-               "Unknown socket return type: " + StringTk::uintToStr(returnType) );
-         } break;
+      delete(entries);
 
-      } // end of switch(returnType)
+      entries = nextEntry;
+   }
+}
 
+/**
+ * Re-add a returned socket to the epoll set (or add a new one).
+ */
+void StreamListenerV2::handleSockReturn(SockPipeReturnType returnType, Socket* currentSock)
+{
+   switch(returnType)
+   {
+      case SockPipeReturn_MSGDONE_NOIMMEDIATE:
+      { // most likely case: worker is done with a msg and now returns the sock to the epoll set
+
+         struct epoll_event epollEvent;
+         epollEvent.events = EPOLLIN | EPOLLONESHOT | EPOLLET;
+         epollEvent.data.ptr = currentSock;
+
+         int epollRes = epoll_ctl(epollFD, EPOLL_CTL_MOD, currentSock->getFD(), &epollEvent);
+
+         if(likely(!epollRes) )
+         { // sock was successfully re-armed in epoll set
+            pollList.add(currentSock);
+
+            break; // break out of switch
+         }
+         else
+         if(errno != ENOENT)
+         { // error
+            log.logErr("Unable to re-arm sock in epoll set. "
+               "FD: " + StringTk::uintToStr(currentSock->getFD() ) + "; "
+               "SockTypeNum: " + StringTk::uintToStr(currentSock->getSockType() ) + "; "
+               "SysErr: " + System::getErrString() );
+            log.log(Log_NOTICE, "Disconnecting: " + currentSock->getPeername() );
+
+            delete(currentSock);
+
+            break; // break out of switch
+         }
+
+         /* for ENOENT, we fall through to NEWCONN, because this socket appearently wasn't
+            used with this stream listener yet, so we need to add it (instead of modify it) */
+
+      } // might fall through here on ENOENT
+      BEEGFS_FALLTHROUGH;
+
+      case SockPipeReturn_NEWCONN:
+      { // new conn from ConnAcceptor (or wasn't used with this stream listener yet)
+
+         // add new socket file descriptor to epoll set
+
+         struct epoll_event epollEvent;
+         epollEvent.events = EPOLLIN | EPOLLONESHOT | EPOLLET;
+         epollEvent.data.ptr = currentSock;
+
+         int epollRes = epoll_ctl(epollFD, EPOLL_CTL_ADD, currentSock->getFD(), &epollEvent);
+         if(likely(!epollRes) )
+         { // socket was successfully added to epoll set
+            pollList.add(currentSock);
+         }
+         else
+         { // adding to epoll set failed => unrecoverable error
+            log.logErr("Unable to add sock to epoll set. "
+               "FD: " + StringTk::uintToStr(currentSock->getFD() ) + " "
+               "SockTypeNum: " + StringTk::uintToStr(currentSock->getSockType() ) + " "
+               "SysErr: " + System::getErrString() );
+            log.log(Log_NOTICE, "Disconnecting: " + currentSock->getPeername() );
+
+            delete(currentSock);
+         }
 
+      } break;
 
-      readRes -= sizeof(SockReturnPipeInfo);
-      if(!readRes)
-         break; // all received returnInfos have been processed
+      case SockPipeReturn_MSGDONE_WITHIMMEDIATE:
+      { // special case: worker detected that immediate data is available after msg processing
+         // data immediately available => recv header and so on
+         onIncomingData(currentSock);
+      } break;
 
-   } // end of "for each received SockReturnPipeInfo" loop
+      default:
+      { // should never happen: unknown/unhandled returnType
+         log.logErr("Should never happen: "
+            "Unknown socket return type: " + StringTk::uintToStr(returnType) );
+      } break;
 
+   } // end of switch(returnType)
 }
 
 /**
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <common/app/log/LogContext.h>
+#include <common/components/streamlistenerv2/MultiplexedRequestSocket.h>
 #include <common/components/worker/queue/StreamListenerWorkQueue.h>
 #include <common/components/ComponentInitException.h>
 #include <common/net/sock/StandardSocket.h>
@@ -9,9 +10,11 @@
 #include <common/nodes/Node.h>
 #include <common/threading/PThread.h>
 #include <common/toolkit/poll/PollList.h>
-#include <common/toolkit/Pipe.h>
+#include <common/toolkit/FileDescriptor.h>
 #include <common/Common.h>
 
+#include <atomic>
+
 
 class AbstractApp; // forward declaration
 
@@ -26,26 +29,9 @@ class StreamListenerV2 : public PThread
          SockPipeReturn_NEWCONN = 0, /* a new connection from ConnAcceptor */
          SockPipeReturn_MSGDONE_NOIMMEDIATE = 1, /* returned from msg worker, no immediate data */
          SockPipeReturn_MSGDONE_WITHIMMEDIATE = 2, /* from worker with immediate data available */
-      };
-
-      /**
-       * This is what we will send over the socket return pipe
-       */
-      struct SockReturnPipeInfo
-      {
-         /**
-          * Standard constructor for creating/sending a returnInfo.
-          */
-         SockReturnPipeInfo(SockPipeReturnType returnType, Socket* sock) :
-            returnType(returnType), sock(sock) {}
-
-         /**
-          * For receiving only (no initialization of members).
-          */
-         SockReturnPipeInfo() {}
-
-         SockPipeReturnType returnType;
-         Socket* sock;
+         SockPipeReturn_MULTIPLEXED_RECVDONE = 3, /* worker received a multiplexed request */
+         SockPipeReturn_MULTIPLEXED_DONE = 4, /* worker sent the response to a multiplexed req */
+         SockPipeReturn_MULTIPLEXED_FAILED = 5, /* multiplexed request failed => disconnect */
       };
 
 
@@ -54,8 +40,24 @@ class StreamListenerV2 : public PThread
          StreamListenerWorkQueue* workQueue);
       virtual ~StreamListenerV2();
 
+      static void checkTCPListenPortUnused(unsigned short listenPort);
+      static StreamListenerV2* getStreamListenerForSock(AbstractApp* app, Socket* sock);
+
+      void initTCPListenSock(unsigned short listenPort);
+      void returnSock(SockPipeReturnType returnType, Socket* sock);
+
 
    private:
+      /**
+       * A socket that was handed over to us (see returnSock() ).
+       */
+      struct SockReturnEntry
+      {
+         SockPipeReturnType returnType;
+         Socket* sock; // the multiplexed conn for SockPipeReturn_MULTIPLEXED_...
+         SockReturnEntry* next;
+      };
+
       AbstractApp*      app;
       LogContext        log;
 
@@ -63,34 +65,49 @@ class StreamListenerV2 : public PThread
 
       int               epollFD;
       PollList          pollList;
-      Pipe*             sockReturnPipe;
+
+      std::atomic<SockReturnEntry*> sockReturnStack; // lock-free, we always take all entries
+      std::atomic<bool> sockReturnDoorbellRung; // true while an eventfd wakeup is pending
+      FileDescriptor*   sockReturnDoorbell; // eventfd to wake us up for returned sockets
+
+      StandardSocket*   tcpListenSock; // NULL if TCP connections are accepted by ConnAcceptor
 
       Time              rdmaCheckT;
       int               rdmaCheckForceCounter;
 
       bool              useAggressivePoll; // true to not sleep on epoll and burn CPU
 
-      bool initSockReturnPipe();
+      bool initSockReturnDoorbell();
       bool initSocks(unsigned short listenPort, NicListCapabilities* localNicCaps);
 
       virtual void run();
       void listenLoop();
 
       void onIncomingData(Socket* sock);
+      void onIncomingMultiplexedData(PooledSocket* sock);
+      void onMultiplexedSockReturn(SockPipeReturnType returnType, PooledSocket* sock);
+      void pushSockReturnEntry(SockReturnEntry* entry);
+      bool rearmMultiplexedSock(PooledSocket* sock);
+      void disconnectMultiplexedSock(PooledSocket* sock);
+      void onIncomingConnection();
       void onSockReturn();
+      void handleSockReturn(SockPipeReturnType returnType, Socket* sock);
       void rdmaConnIdleCheck();
 
       bool isFalseAlarm(RDMASocket* sock);
 
+      static bool isMultiplexedSockReturn(SockPipeReturnType returnType)
+      {
+         return (returnType == SockPipeReturn_MULTIPLEXED_RECVDONE) ||
+            (returnType == SockPipeReturn_MULTIPLEXED_DONE) ||
+            (returnType == SockPipeReturn_MULTIPLEXED_FAILED);
+      }
+
       void deleteAllConns();
 
 
    public:
       // getters & setters
-      FileDescriptor* getSockReturnFD() const
-      {
-         return sockReturnPipe->getWriteFD();
-      }
 
       /**
        * Only effective when set before running this component.
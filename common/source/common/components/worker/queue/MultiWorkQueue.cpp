@@ -28,6 +28,9 @@ MultiWorkQueue::~MultiWorkQueue()
 Work* MultiWorkQueue::waitForDirectWork(HighResolutionStats& newStats,
    PersonalWorkQueue* personalWorkQueue)
 {
+   if(workStealingQueue)
+      return workStealingQueue->waitForDirectWork(newStats, personalWorkQueue);
+
    std::lock_guard<Mutex> mutexLock(mutex);
 
    HighResolutionStatsTk::addHighResIncStats(newStats, stats);
@@ -79,6 +82,9 @@ Work* MultiWorkQueue::waitForDirectWork(HighResolutionStats& newStats,
 Work* MultiWorkQueue::waitForAnyWork(HighResolutionStats& newStats,
    PersonalWorkQueue* personalWorkQueue)
 {
+   if(workStealingQueue)
+      return workStealingQueue->waitForAnyWork(newStats, personalWorkQueue);
+
    std::lock_guard<Mutex> mutexLock(mutex);
 
    HighResolutionStatsTk::addHighResIncStats(newStats, stats);
@@ -168,6 +174,12 @@ Work* MultiWorkQueue::waitForAnyWork(HighResolutionStats& newStats,
  */
 void MultiWorkQueue::incNumWorkers()
 {
+   if(workStealingQueue)
+   {
+      workStealingQueue->incNumWorkers();
+      return;
+   }
+
    std::lock_guard<Mutex> mutesLock(mutex);
 
    /* note: we increase number of busy workers here, because this value will be decreased
@@ -200,12 +212,40 @@ void MultiWorkQueue::setIndirectWorkList(AbstractWorkContainer* newWorkList)
    workListVec[QueueWorkType_INDIRECT] = indirectWorkList;
 }
 
+/**
+ * Switches this queue to the WorkStealingQueue backend, which uses per-worker lock-free rings
+ * instead of the mutex-protected work lists.
+ *
+ * Note: Unlocked, because this is intended to be called during queue preparation (i.e. before
+ * any work is added and before workers are started). Per-user work lists (setIndirectWorkList)
+ * are not used by the WorkStealingQueue.
+ *
+ * @param numSlots number of lock-free ring pairs; usually the number of workers of this queue.
+ */
+void MultiWorkQueue::enableWorkStealing(unsigned numSlots)
+{
+   #ifdef BEEGFS_DEBUG
+      // sanity check
+      if(numPendingWorks)
+         throw MultiWorkQueueException("Unexpected in " + std::string(__func__) + ": "
+            "Queue to be replaced is not empty.");
+   #endif // BEEGFS_DEBUG
+
+   workStealingQueue.reset(new WorkStealingQueue(numSlots) );
+}
+
 /**
  * Note: Holds lock while generating stats strings => slow => use carefully
  */
 void MultiWorkQueue::getStatsAsStr(std::string& outIndirectQueueStats,
    std::string& outDirectQueueStats, std::string& outBusyStats)
 {
+   if(workStealingQueue)
+   {
+      workStealingQueue->getStatsAsStr(outIndirectQueueStats, outDirectQueueStats, outBusyStats);
+      return;
+   }
+
    std::lock_guard<Mutex> mutexLock(mutex);
 
    // get queue stats
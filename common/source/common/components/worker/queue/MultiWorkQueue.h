@@ -11,7 +11,9 @@
 #include <common/Common.h>
 #include "ListWorkContainer.h"
 #include "PersonalWorkQueue.h"
+#include "WorkStealingQueue.h"
 
+#include <memory>
 #include <mutex>
 
 
@@ -63,6 +65,7 @@ class MultiWorkQueue : public StreamListenerWorkQueue
       void incNumWorkers();
 
       void setIndirectWorkList(AbstractWorkContainer* newWorkList);
+      void enableWorkStealing(unsigned numSlots);
 
       void getStatsAsStr(std::string& outIndirectQueueStats, std::string& outDirectQueueStats,
          std::string& outBusyStats);
@@ -82,6 +85,9 @@ class MultiWorkQueue : public StreamListenerWorkQueue
 
       HighResolutionStats stats;
 
+      // if set, all work is handled by this instead of the lists above (see enableWorkStealing)
+      std::unique_ptr<WorkStealingQueue> workStealingQueue;
+
    public:
       void addDirectWork(Work* work, unsigned userID = MULTIWORKQUEUE_DEFAULT_USERID)
       {
@@ -89,6 +95,12 @@ class MultiWorkQueue : public StreamListenerWorkQueue
          LOG(WORKQUEUES, DEBUG, "Adding direct work item.", work);
 #endif
 
+         if(workStealingQueue)
+         {
+            workStealingQueue->addDirectWork(work);
+            return;
+         }
+
          std::lock_guard<Mutex> mutexLock(mutex);
 
          directWorkList->addWork(work, userID);
@@ -105,6 +117,12 @@ class MultiWorkQueue : public StreamListenerWorkQueue
          LOG(WORKQUEUES, DEBUG, "Adding indirect work item.", work);
 #endif
 
+         if(workStealingQueue)
+         {
+            workStealingQueue->addIndirectWork(work);
+            return;
+         }
+
          std::lock_guard<Mutex> mutexLock(mutex);
 
          indirectWorkList->addWork(work, userID);
@@ -119,6 +137,12 @@ class MultiWorkQueue : public StreamListenerWorkQueue
          /* note: this is in the here (instead of the PersonalWorkQueue) because the MultiWorkQueue
             mutex also syncs the personal queue. */
 
+         if(workStealingQueue)
+         {
+            workStealingQueue->addPersonalWork(work, personalQ);
+            return;
+         }
+
          std::lock_guard<Mutex> mutexLock(mutex);
 
          personalQ->addWork(work);
@@ -132,24 +156,36 @@ class MultiWorkQueue : public StreamListenerWorkQueue
 
       size_t getDirectWorkListSize()
       {
+         if(workStealingQueue)
+            return workStealingQueue->getDirectWorkListSize();
+
          std::lock_guard<Mutex> mutexLock(mutex);
          return directWorkList->getSize();
       }
 
       size_t getIndirectWorkListSize()
       {
+         if(workStealingQueue)
+            return workStealingQueue->getIndirectWorkListSize();
+
          std::lock_guard<Mutex> mutexLock(mutex);
          return indirectWorkList->getSize();
       }
 
       bool getIsPersonalQueueEmpty(PersonalWorkQueue* personalQ)
       {
+         if(workStealingQueue)
+            return workStealingQueue->getIsPersonalQueueEmpty(personalQ);
+
          std::lock_guard<Mutex> mutexLock(mutex);
          return personalQ->getIsWorkListEmpty();
       }
 
       size_t getNumPendingWorks()
       {
+         if(workStealingQueue)
+            return workStealingQueue->getNumPendingWorks();
+
          std::lock_guard<Mutex> mutexLock(mutex);
          return numPendingWorks;
       }
@@ -159,6 +195,12 @@ class MultiWorkQueue : public StreamListenerWorkQueue
        */
       void getAndResetStats(HighResolutionStats* outStats)
       {
+         if(workStealingQueue)
+         {
+            workStealingQueue->getAndResetStats(outStats);
+            return;
+         }
+
          std::lock_guard<Mutex> mutexLock(mutex);
 
          *outStats = stats;
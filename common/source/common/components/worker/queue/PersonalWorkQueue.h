@@ -5,6 +5,9 @@
 #include <common/Common.h>
 
 
+#define PERSONALWORKQUEUE_NO_SLOT  (~0U) // workStealingSlot value if no slot assigned yet
+
+
 DECLARE_NAMEDEXCEPTION(PersonalWorkQueueException, "PersonalWorkQueueException")
 
 
@@ -17,6 +20,9 @@ DECLARE_NAMEDEXCEPTION(PersonalWorkQueueException, "PersonalWorkQueueException")
  * This class has no own mutex for thread-safety, it is sync'ed via the MultiWorkQueue mutex.
  * So adding work to it is done via MultiWorkQueue methods.
  *
+ * As there is one personal queue per worker, it also holds the per-worker state of the
+ * WorkStealingQueue.
+ *
  * Note: Workers always prefer requests in the personal queue over requests in the other queues,
  * so keep possible starvation of requests in other queues in mind when you use personal queues.
  */
@@ -24,9 +30,11 @@ class PersonalWorkQueue
 {
    friend class MultiWorkQueue; /* to make sure that our methods are not called without the
                                    MultiWorkQueue mutex being held. */
+   friend class WorkStealingQueue;
 
    public:
-      PersonalWorkQueue() {}
+      PersonalWorkQueue() :
+         workStealingSlot(PERSONALWORKQUEUE_NO_SLOT), lastWorkStealingType(0) {}
 
       ~PersonalWorkQueue()
       {
@@ -39,6 +47,9 @@ class PersonalWorkQueue
    private:
       WorkList workList;
 
+      unsigned workStealingSlot; // home slot of the worker in a WorkStealingQueue
+      unsigned lastWorkStealingType; // toggles work types of indirect workers
+
 
    private:
       // inliners
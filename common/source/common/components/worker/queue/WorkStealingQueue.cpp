@@ -0,0 +1,435 @@
+#include <common/app/log/Logger.h>
+#include "WorkStealingQueue.h"
+
+#include <climits>
+#include <mutex>
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+
+static_assert( (WORKSTEALINGQUEUE_RING_SIZE & (WORKSTEALINGQUEUE_RING_SIZE - 1) ) == 0,
+   "WORKSTEALINGQUEUE_RING_SIZE must be a power of 2");
+
+
+WorkStealingQueue::WorkRing::WorkRing() :
+   cells(new Cell[WORKSTEALINGQUEUE_RING_SIZE]), enqueuePos(0), dequeuePos(0)
+{
+   for(size_t i = 0; i < WORKSTEALINGQUEUE_RING_SIZE; i++)
+      cells[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+/**
+ * @return false if the ring is full.
+ */
+bool WorkStealingQueue::WorkRing::push(Work* work)
+{
+   size_t pos = enqueuePos.load(std::memory_order_relaxed);
+   Cell* cell;
+
+   for( ; ; )
+   {
+      cell = &cells[pos & (WORKSTEALINGQUEUE_RING_SIZE - 1)];
+
+      const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+      const intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+
+      if(diff == 0)
+      { // cell is free => try to claim it
+         if(enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed) )
+            break;
+      }
+      else
+      if(diff < 0)
+         return false; // cell still holds the work of the previous round => ring is full
+      else
+         pos = enqueuePos.load(std::memory_order_relaxed); // another producer was faster
+   }
+
+   cell->work = work;
+   cell->sequence.store(pos + 1, std::memory_order_release);
+
+   return true;
+}
+
+/**
+ * @return false if the ring is empty.
+ */
+bool WorkStealingQueue::WorkRing::pop(Work** outWork)
+{
+   size_t pos = dequeuePos.load(std::memory_order_relaxed);
+   Cell* cell;
+
+   for( ; ; )
+   {
+      cell = &cells[pos & (WORKSTEALINGQUEUE_RING_SIZE - 1)];
+
+      const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+      const intptr_t diff = (intptr_t)sequence - (intptr_t)(pos + 1);
+
+      if(diff == 0)
+      { // cell is filled => try to claim it
+         if(dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed) )
+            break;
+      }
+      else
+      if(diff < 0)
+         return false; // cell not filled yet => ring is empty
+      else
+         pos = dequeuePos.load(std::memory_order_relaxed); // another consumer was faster
+   }
+
+   *outWork = cell->work;
+   cell->sequence.store(pos + WORKSTEALINGQUEUE_RING_SIZE, std::memory_order_release);
+
+   return true;
+}
+
+
+/**
+ * @return epoch to be passed to wait().
+ */
+uint32_t WorkStealingQueue::EventCount::prepareWait()
+{
+   numWaiters.fetch_add(1, std::memory_order_seq_cst);
+
+   /* pairs with the fence in notify(): either the notifier sees us waiting or our following
+      check for work sees the new work */
+   std::atomic_thread_fence(std::memory_order_seq_cst);
+
+   return epoch.load(std::memory_order_acquire);
+}
+
+void WorkStealingQueue::EventCount::cancelWait()
+{
+   numWaiters.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void WorkStealingQueue::EventCount::wait(uint32_t waitEpoch)
+{
+   static_assert(sizeof(epoch) == sizeof(uint32_t), "futex word must be 32bit");
+
+   // (returns immediately if the epoch has changed since prepareWait)
+   syscall(SYS_futex, (uint32_t*)&epoch, FUTEX_WAIT_PRIVATE, waitEpoch, NULL, NULL, 0);
+
+   numWaiters.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void WorkStealingQueue::EventCount::notify(bool notifyAll)
+{
+   std::atomic_thread_fence(std::memory_order_seq_cst);
+
+   if(!numWaiters.load(std::memory_order_relaxed) )
+      return;
+
+   epoch.fetch_add(1, std::memory_order_release);
+
+   syscall(SYS_futex, (uint32_t*)&epoch, FUTEX_WAKE_PRIVATE, notifyAll ? INT_MAX : 1,
+      NULL, NULL, 0);
+}
+
+
+/**
+ * @param numSlots number of ring pairs; usually the number of workers of this queue.
+ */
+WorkStealingQueue::WorkStealingQueue(unsigned numSlots) :
+   numSlots(BEEGFS_MAX(numSlots, 1u) ),
+   slots(new Slot[this->numSlots]),
+   nextWorkerSlot(0),
+   numBusyWorkers(0),
+   numPersonalWorks(0),
+   numOverflowWorks(0)
+{
+   for(unsigned i = 0; i < WorkType_FINAL_DONTUSE; i++)
+      numPendingWorks[i].store(0, std::memory_order_relaxed);
+}
+
+WorkStealingQueue::~WorkStealingQueue()
+{
+   // delete remaining work packets (personal queues are cleaned up by their owners)
+
+   for(unsigned i = 0; i < numSlots; i++)
+   {
+      for(unsigned type = 0; type < WorkType_FINAL_DONTUSE; type++)
+      {
+         Work* work;
+
+         while(slots[i].rings[type].pop(&work) )
+            delete(work);
+      }
+   }
+
+   for(unsigned type = 0; type < WorkType_FINAL_DONTUSE; type++)
+   {
+      for(WorkListIter iter = overflowLists[type].begin(); iter != overflowLists[type].end(); iter++)
+         delete(*iter);
+   }
+}
+
+void WorkStealingQueue::addDirectWork(Work* work)
+{
+   addWork(WorkType_DIRECT, work);
+
+   directWorkEvent.notify(false);
+   anyWorkEvent.notify(false);
+}
+
+void WorkStealingQueue::addIndirectWork(Work* work)
+{
+   addWork(WorkType_INDIRECT, work);
+
+   anyWorkEvent.notify(false);
+}
+
+void WorkStealingQueue::addWork(WorkType workType, Work* work)
+{
+   // each producer thread walks over the slots on its own to avoid a shared counter
+   static thread_local unsigned nextProducerSlot = 0;
+
+   // (inc before the push, so that the counter can't underflow when a worker is quick)
+   numPendingWorks[workType].fetch_add(1, std::memory_order_relaxed);
+
+   const unsigned startSlot = nextProducerSlot++;
+
+   for(unsigned i = 0; i < numSlots; i++)
+   {
+      if(slots[(startSlot + i) % numSlots].rings[workType].push(work) )
+         return;
+   }
+
+   // all rings full => fall back to the overflow list
+
+   std::lock_guard<Mutex> mutexLock(mutex);
+
+   overflowLists[workType].push_back(work);
+   numOverflowWorks.fetch_add(1, std::memory_order_relaxed);
+}
+
+void WorkStealingQueue::addPersonalWork(Work* work, PersonalWorkQueue* personalQ)
+{
+   {
+      std::lock_guard<Mutex> mutexLock(mutex);
+
+      personalQ->addWork(work);
+      numPersonalWorks.fetch_add(1, std::memory_order_relaxed);
+   }
+
+   // we assume this method is rarely used, so we just wake up all wokers (inefficient)
+   directWorkEvent.notify(true);
+   anyWorkEvent.notify(true);
+}
+
+Work* WorkStealingQueue::waitForDirectWork(HighResolutionStats& newStats,
+   PersonalWorkQueue* personalQ)
+{
+   return waitForWork(newStats, personalQ, true);
+}
+
+Work* WorkStealingQueue::waitForAnyWork(HighResolutionStats& newStats,
+   PersonalWorkQueue* personalQ)
+{
+   return waitForWork(newStats, personalQ, false);
+}
+
+/**
+ * @param directOnly true for direct workers, false for indirect workers.
+ */
+Work* WorkStealingQueue::waitForWork(HighResolutionStats& newStats, PersonalWorkQueue* personalQ,
+   bool directOnly)
+{
+   Slot& homeSlot = getHomeSlot(personalQ);
+   EventCount& workEvent = directOnly ? directWorkEvent : anyWorkEvent;
+
+   {
+      std::lock_guard<Mutex> statsLock(homeSlot.statsMutex);
+      HighResolutionStatsTk::addHighResIncStats(newStats, homeSlot.stats);
+   }
+
+   numBusyWorkers.fetch_sub(1, std::memory_order_relaxed);
+
+   Work* work;
+
+   while(!(work = tryGetWork(personalQ, directOnly) ) )
+   {
+      const uint32_t waitEpoch = workEvent.prepareWait();
+
+      // check again, something might have been added before we registered as waiter
+      work = tryGetWork(personalQ, directOnly);
+      if(work)
+      {
+         workEvent.cancelWait();
+         break;
+      }
+
+      workEvent.wait(waitEpoch);
+   }
+
+   numBusyWorkers.fetch_add(1, std::memory_order_relaxed);
+
+#ifdef BEEGFS_DEBUG_PROFILING
+   const auto workAgeMS = work->getAgeTime()->elapsedMS();
+   if (workAgeMS > 10)
+      LOG(WORKQUEUES, DEBUG, "Fetching work item.", work, ("age (ms)", workAgeMS));
+   else
+      LOG(WORKQUEUES, DEBUG, "Fetching work item.", work,
+         ("age (us)", work->getAgeTime()->elapsedMicro()));
+#endif
+
+   return work;
+}
+
+/**
+ * @return NULL if no work is available for the calling worker right now.
+ */
+Work* WorkStealingQueue::tryGetWork(PersonalWorkQueue* personalQ, bool directOnly)
+{
+   // personal is always first
+   if(unlikely(numPersonalWorks.load(std::memory_order_acquire) ) )
+   {
+      std::lock_guard<Mutex> mutexLock(mutex);
+
+      if(!personalQ->getIsWorkListEmpty() )
+      {
+         numPersonalWorks.fetch_sub(1, std::memory_order_relaxed);
+         return personalQ->getAndPopFirstWork();
+      }
+   }
+
+   if(directOnly)
+      return tryGetWorkByType(personalQ, WorkType_DIRECT);
+
+   // indirect workers toggle between work types to check them in a fair way
+
+   for(unsigned i = 0; i < WorkType_FINAL_DONTUSE; i++)
+   {
+      personalQ->lastWorkStealingType =
+         (personalQ->lastWorkStealingType + 1) % WorkType_FINAL_DONTUSE;
+
+      Work* work = tryGetWorkByType(personalQ, (WorkType)personalQ->lastWorkStealingType);
+      if(work)
+         return work;
+   }
+
+   return NULL;
+}
+
+/**
+ * Pop from the home slot of the worker first and steal from the other slots if it is empty.
+ */
+Work* WorkStealingQueue::tryGetWorkByType(PersonalWorkQueue* personalQ, WorkType workType)
+{
+   const unsigned homeSlotIdx = personalQ->workStealingSlot;
+   Work* work;
+
+   for(unsigned i = 0; i < numSlots; i++)
+   {
+      if(slots[(homeSlotIdx + i) % numSlots].rings[workType].pop(&work) )
+      {
+         numPendingWorks[workType].fetch_sub(1, std::memory_order_relaxed);
+         return work;
+      }
+   }
+
+   if(unlikely(numOverflowWorks.load(std::memory_order_acquire) ) )
+   {
+      std::lock_guard<Mutex> mutexLock(mutex);
+
+      if(!overflowLists[workType].empty() )
+      {
+         work = overflowLists[workType].front();
+         overflowLists[workType].pop_front();
+
+         numOverflowWorks.fetch_sub(1, std::memory_order_relaxed);
+         numPendingWorks[workType].fetch_sub(1, std::memory_order_relaxed);
+         return work;
+      }
+   }
+
+   return NULL;
+}
+
+/**
+ * Assigns a home slot to the worker on its first call.
+ */
+WorkStealingQueue::Slot& WorkStealingQueue::getHomeSlot(PersonalWorkQueue* personalQ)
+{
+   if(unlikely(personalQ->workStealingSlot == PERSONALWORKQUEUE_NO_SLOT) )
+      personalQ->workStealingSlot =
+         nextWorkerSlot.fetch_add(1, std::memory_order_relaxed) % numSlots;
+
+   return slots[personalQ->workStealingSlot];
+}
+
+/**
+ * See MultiWorkQueue::incNumWorkers().
+ */
+void WorkStealingQueue::incNumWorkers()
+{
+   numBusyWorkers.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool WorkStealingQueue::getIsPersonalQueueEmpty(PersonalWorkQueue* personalQ)
+{
+   std::lock_guard<Mutex> mutexLock(mutex);
+   return personalQ->getIsWorkListEmpty();
+}
+
+/**
+ * Returns current stats and _resets_ them.
+ */
+void WorkStealingQueue::getAndResetStats(HighResolutionStats* outStats)
+{
+   HighResolutionStatsTk::resetStats(outStats);
+
+   for(unsigned i = 0; i < numSlots; i++)
+   {
+      std::lock_guard<Mutex> statsLock(slots[i].statsMutex);
+
+      HighResolutionStatsTk::addHighResIncStats(slots[i].stats, *outStats);
+      HighResolutionStatsTk::resetIncStats(&slots[i].stats);
+   }
+
+   outStats->rawVals.busyWorkers = numBusyWorkers.load(std::memory_order_relaxed);
+   outStats->rawVals.queuedRequests = getNumPendingWorks();
+}
+
+void WorkStealingQueue::getStatsAsStr(std::string& outIndirectQueueStats,
+   std::string& outDirectQueueStats, std::string& outBusyStats)
+{
+   HighResolutionStats stats;
+
+   HighResolutionStatsTk::resetStats(&stats);
+
+   for(unsigned i = 0; i < numSlots; i++)
+   {
+      std::lock_guard<Mutex> statsLock(slots[i].statsMutex);
+      HighResolutionStatsTk::addHighResIncStats(slots[i].stats, stats);
+   }
+
+   std::ostringstream indirectStream;
+
+   indirectStream << "* Queue type: WorkStealingQueue (" << numSlots << " slots)" << std::endl;
+   indirectStream << "* Queue len: " << getIndirectWorkListSize() << std::endl;
+
+   outIndirectQueueStats = indirectStream.str();
+
+   std::ostringstream directStream;
+
+   directStream << "* Queue type: WorkStealingQueue (" << numSlots << " slots)" << std::endl;
+   directStream << "* Queue len: " << getDirectWorkListSize() << std::endl;
+
+   outDirectQueueStats = directStream.str();
+
+   // number of busy workers
+   std::ostringstream busyStream;
+
+   busyStream << "* Busy workers:  " << numBusyWorkers.load(std::memory_order_relaxed) << std::endl;
+   busyStream << "* Work Requests: " << StringTk::uintToStr(stats.incVals.workRequests) << " "
+      "(reset every second)" << std::endl;
+   busyStream << "* Bytes read:    " << StringTk::uintToStr(stats.incVals.diskReadBytes) << " "
+      "(reset every second)" << std::endl;
+   busyStream << "* Bytes written: " << StringTk::uintToStr(stats.incVals.diskWriteBytes) << " "
+      "(reset every second)" << std::endl;
+
+   outBusyStats = busyStream.str();
+}
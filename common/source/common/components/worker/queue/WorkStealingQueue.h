@@ -0,0 +1,159 @@
+#pragma once
+
+#include <common/components/worker/queue/PersonalWorkQueue.h>
+#include <common/components/worker/Work.h>
+#include <common/threading/Mutex.h>
+#include <common/toolkit/HighResolutionStats.h>
+#include <common/Common.h>
+
+#include <atomic>
+#include <memory>
+
+
+#define WORKSTEALINGQUEUE_RING_SIZE    (1024) /* works per slot and work type (power of 2) */
+
+
+/**
+ * Alternative backend for the MultiWorkQueue (see MultiWorkQueue::enableWorkStealing() ), which
+ * avoids the single queue mutex that all workers and stream listeners contend on.
+ *
+ * Work is spread over a fixed number of slots (usually one per worker), each with a bounded
+ * lock-free ring for direct and one for indirect work. Producers push round-robin to the slots,
+ * workers pop from their home slot first and steal from the other slots when their own rings are
+ * empty. Idle workers park on a futex-based event count, so producers only pay for a wakeup
+ * syscall if a worker is actually sleeping.
+ *
+ * Semantics are the same as for the mutex-based queue: direct workers only take direct work,
+ * indirect workers take both types alternately and personal work is always preferred.
+ * Works are not strictly processed in order of arrival, though, and there is no per-user
+ * fairness (UserWorkContainer).
+ */
+class WorkStealingQueue
+{
+   public:
+      WorkStealingQueue(unsigned numSlots);
+      ~WorkStealingQueue();
+
+      WorkStealingQueue(const WorkStealingQueue&) = delete;
+      WorkStealingQueue& operator=(const WorkStealingQueue&) = delete;
+
+      void addDirectWork(Work* work);
+      void addIndirectWork(Work* work);
+      void addPersonalWork(Work* work, PersonalWorkQueue* personalQ);
+
+      Work* waitForDirectWork(HighResolutionStats& newStats, PersonalWorkQueue* personalQ);
+      Work* waitForAnyWork(HighResolutionStats& newStats, PersonalWorkQueue* personalQ);
+
+      void incNumWorkers();
+
+      bool getIsPersonalQueueEmpty(PersonalWorkQueue* personalQ);
+      void getAndResetStats(HighResolutionStats* outStats);
+      void getStatsAsStr(std::string& outIndirectQueueStats, std::string& outDirectQueueStats,
+         std::string& outBusyStats);
+
+
+   private:
+      enum WorkType
+      {
+         WorkType_DIRECT = 0,
+         WorkType_INDIRECT,
+
+         WorkType_FINAL_DONTUSE
+      };
+
+      /**
+       * Bounded multi-producer/multi-consumer ring (D. Vyukov's algorithm): each cell has a
+       * sequence number that tells producers and consumers whether it is their turn.
+       */
+      class WorkRing
+      {
+         public:
+            WorkRing();
+
+            bool push(Work* work);
+            bool pop(Work** outWork);
+
+         private:
+            struct Cell
+            {
+               std::atomic<size_t> sequence;
+               Work* work;
+            };
+
+            std::unique_ptr<Cell[]> cells;
+
+            alignas(64) std::atomic<size_t> enqueuePos;
+            alignas(64) std::atomic<size_t> dequeuePos;
+      };
+
+      /**
+       * Futex-based event count to park idle workers.
+       *
+       * A waiter calls prepareWait(), checks for work once more and then either calls
+       * cancelWait() or wait(). notify() only does a syscall if someone is waiting.
+       */
+      class EventCount
+      {
+         public:
+            EventCount() : epoch(0), numWaiters(0) {}
+
+            uint32_t prepareWait();
+            void cancelWait();
+            void wait(uint32_t waitEpoch);
+            void notify(bool notifyAll);
+
+         private:
+            alignas(64) std::atomic<uint32_t> epoch;
+            std::atomic<uint32_t> numWaiters;
+      };
+
+      struct Slot
+      {
+         WorkRing rings[WorkType_FINAL_DONTUSE];
+
+         Mutex statsMutex; // only contended by workers sharing this slot and the stats collector
+         HighResolutionStats stats;
+      };
+
+      unsigned numSlots;
+      std::unique_ptr<Slot[]> slots;
+      std::atomic<unsigned> nextWorkerSlot; // to assign home slots to workers
+
+      std::atomic<size_t> numPendingWorks[WorkType_FINAL_DONTUSE]; // not incl personal works
+      std::atomic<unsigned> numBusyWorkers;
+
+      EventCount directWorkEvent; // direct workers wait only on this
+      EventCount anyWorkEvent; // for any type of work (indirect workers wait on this)
+
+      Mutex mutex; // for personal queues and overflow lists
+      std::atomic<size_t> numPersonalWorks; // total over all personal queues
+      std::atomic<size_t> numOverflowWorks;
+      WorkList overflowLists[WorkType_FINAL_DONTUSE]; // for works that didn't fit into the rings
+
+      void addWork(WorkType workType, Work* work);
+      Work* waitForWork(HighResolutionStats& newStats, PersonalWorkQueue* personalQ,
+         bool directOnly);
+      Work* tryGetWork(PersonalWorkQueue* personalQ, bool directOnly);
+      Work* tryGetWorkByType(PersonalWorkQueue* personalQ, WorkType workType);
+      Slot& getHomeSlot(PersonalWorkQueue* personalQ);
+
+
+   public:
+      // getters & setters
+
+      size_t getNumPendingWorks() const
+      {
+         return getDirectWorkListSize() + getIndirectWorkListSize();
+      }
+
+      size_t getDirectWorkListSize() const
+      {
+         return numPendingWorks[WorkType_DIRECT].load(std::memory_order_relaxed);
+      }
+
+      size_t getIndirectWorkListSize() const
+      {
+         return numPendingWorks[WorkType_INDIRECT].load(std::memory_order_relaxed);
+      }
+};
+
@@ -116,6 +116,24 @@ class NetMessage
 
             void sendResponse(const NetMessage& response) const
             {
+               const auto trailingData = response.getTrailingData();
+
+               if(trailingData.second && !fromAddr)
+               { // stream socket => send trailing data from its own buffer
+                  auto headRes = response.serializeMessageHead(responseBuffer,
+                     responseBufferLength);
+
+                  if(headRes.first)
+                  {
+                     struct iovec iov[2] = {
+                        {responseBuffer, headRes.second},
+                        {(void*)trailingData.first, trailingData.second} };
+
+                     socket->sendv(iov, 2, 0);
+                     return;
+                  }
+               }
+
                unsigned msgLength =
                   response.serializeMessage(responseBuffer, responseBufferLength).second;
 
@@ -181,6 +199,18 @@ class NetMessage
 
       virtual bool supportsMirroring() const { return false; }
 
+      /**
+       * Raw data that is appended to the serialized payload, but is not written by
+       * serializePayload(), so that it can be sent directly from its own buffer instead of being
+       * copied into the message buffer (see serializeMessageHead() ). Defaults to "none".
+       *
+       * @return data pointer and length
+       */
+      virtual std::pair<const char*, unsigned> getTrailingData() const
+      {
+         return {NULL, 0};
+      }
+
    protected:
       NetMessage(unsigned short msgType)
       {
@@ -218,12 +248,33 @@ class NetMessage
          ser % msgHeader;
          serializePayload(ser);
 
+         const auto trailingData = getTrailingData();
+         ser.putBlock(trailingData.first, trailingData.second);
+
          // fix message length in header and serialize header again to fix the message length
          NetMessageHeader::fixLengthField(atStart, ser.size() );
 
          return std::make_pair(ser.good(), ser.size() );
       }
 
+      /**
+       * Like serializeMessage(), but without the trailing data (see getTrailingData() ), which
+       * has to be sent by the caller right after the returned number of bytes from buf.
+       * The length field in the header includes the trailing data.
+       */
+      std::pair<bool, unsigned> serializeMessageHead(char* buf, size_t bufLen) const
+      {
+         Serializer ser(buf, bufLen);
+         Serializer atStart = ser.mark();
+
+         ser % msgHeader;
+         serializePayload(ser);
+
+         NetMessageHeader::fixLengthField(atStart, ser.size() + getTrailingData().second);
+
+         return std::make_pair(ser.good(), ser.size() );
+      }
+
       /**
        * Check if the msg sender has set an incompatible feature flag.
        *
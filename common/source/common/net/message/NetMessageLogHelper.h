@@ -193,6 +193,10 @@ inline std::string netMessageTypeToStr(int type)
       case NETMSGTYPE_SetFileStateResp: return "SetFileStateResp (2132)";
       case NETMSGTYPE_GetChunkBalanceJobStats: return "GetChunkBalanceJobStats (2133)";
       case NETMSGTYPE_GetChunkBalanceJobStatsResp: return "GetChunkBalanceJobStatsResp (2134)";
+      case NETMSGTYPE_GetChunkBlockDigests: return "GetChunkBlockDigests (2135)";
+      case NETMSGTYPE_GetChunkBlockDigestsResp: return "GetChunkBlockDigestsResp (2136)";
+      case NETMSGTYPE_GetChunkFileAttribsBatch: return "GetChunkFileAttribsBatch (2137)";
+      case NETMSGTYPE_GetChunkFileAttribsBatchResp: return "GetChunkFileAttribsBatchResp (2138)";
       case NETMSGTYPE_OpenFile: return "OpenFile (3001)";
       case NETMSGTYPE_OpenFileResp: return "OpenFileResp (3002)";
       case NETMSGTYPE_CloseFile: return "CloseFile (3003)";
@@ -233,6 +237,8 @@ inline std::string netMessageTypeToStr(int type)
       case NETMSGTYPE_AuthenticateChannel: return "AuthenticateChannel (4007)";
       case NETMSGTYPE_GenericResponse: return "GenericResponse (4009)";
       case NETMSGTYPE_PeerInfo: return "PeerInfo (4011)";
+      case NETMSGTYPE_SetChannelMultiplexed: return "SetChannelMultiplexed (4013)";
+      case NETMSGTYPE_SetChannelMultiplexedResp: return "SetChannelMultiplexedResp (4014)";
       case NETMSGTYPE_GetNodesFromRootMetaNode: return "GetNodesFromRootMetaNode (6001)";
       case NETMSGTYPE_SendNodesList: return "SendNodesList (6002)";
       case NETMSGTYPE_RequestMetaData: return "RequestMetaData (6003)";
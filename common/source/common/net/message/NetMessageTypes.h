@@ -186,6 +186,10 @@
 #define NETMSGTYPE_SetFileStateResp                2132
 #define NETMSGTYPE_GetChunkBalanceJobStats         2133
 #define NETMSGTYPE_GetChunkBalanceJobStatsResp     2134
+#define NETMSGTYPE_GetChunkBlockDigests            2135
+#define NETMSGTYPE_GetChunkBlockDigestsResp        2136
+#define NETMSGTYPE_GetChunkFileAttribsBatch        2137
+#define NETMSGTYPE_GetChunkFileAttribsBatchResp    2138
 
 // session messages
 #define NETMSGTYPE_OpenFile                        3001
@@ -230,6 +234,8 @@
 #define NETMSGTYPE_AuthenticateChannel             4007
 #define NETMSGTYPE_GenericResponse                 4009
 #define NETMSGTYPE_PeerInfo                        4011
+#define NETMSGTYPE_SetChannelMultiplexed           4013
+#define NETMSGTYPE_SetChannelMultiplexedResp       4014
 
 // mon messages
 #define NETMSGTYPE_GetNodesFromRootMetaNode        6001
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <common/net/message/SimpleIntMsg.h>
+
+
+/* on a multiplexed connection, each message (request and response) is preceded by a tag, which
+   the requester chooses freely to match responses that may arrive out of order.
+   (note: the header msgSequence can't be used for this, it belongs to buddy mirroring.) */
+#define NETMSG_MULTIPLEXED_TAG_LENGTH        8 // little endian uint64
+#define NETMSG_MULTIPLEXED_REQUEST_MAXLEN    (64*1024) // larger requests use exclusive conns
+
+
+/**
+ * Switch a connection to multiplexed mode, in which the peer may have multiple requests in
+ * flight on this connection (see NETMSG_MULTIPLEXED_TAG_LENGTH).
+ *
+ * The value is the max number of requests in flight that the peer asks for. The response grants
+ * the number of requests in flight that will be accepted; 0 means that the connection stays in
+ * normal mode.
+ */
+class SetChannelMultiplexedMsg : public SimpleIntMsg
+{
+   public:
+      SetChannelMultiplexedMsg(int numCredits) :
+         SimpleIntMsg(NETMSGTYPE_SetChannelMultiplexed, numCredits)
+      {
+      }
+
+      /**
+       * For deserialization only
+       */
+      SetChannelMultiplexedMsg() : SimpleIntMsg(NETMSGTYPE_SetChannelMultiplexed)
+      {
+      }
+};
+
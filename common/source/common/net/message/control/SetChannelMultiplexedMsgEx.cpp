@@ -0,0 +1,52 @@
+#include <common/app/config/ICommonConfig.h>
+#include <common/app/log/Logger.h>
+#include <common/app/AbstractApp.h>
+#include <common/net/message/control/SetChannelMultiplexedRespMsg.h>
+#include <common/net/sock/PooledSocket.h>
+#include "SetChannelMultiplexedMsgEx.h"
+
+bool SetChannelMultiplexedMsgEx::processIncoming(ResponseContext& ctx)
+{
+   AbstractApp* app = PThread::getCurrentThreadApp();
+   auto cfg = app->getCommonConfig();
+
+   unsigned numCredits = grantCredits(ctx.getSocket(), getValue(),
+      cfg->getConnMultiplexedRequests(), ctx.isLocallyGenerated() );
+
+   LOG(COMMUNICATION, DEBUG, "Multiplexed connection requested.", ("peer", ctx.peerName() ),
+      ("requested", getValue() ), ("granted", numCredits) );
+
+   ctx.sendResponse(SetChannelMultiplexedRespMsg(numCredits) );
+
+   return true;
+}
+
+/**
+ * Decide how many requests in flight the peer may have on the conn and switch the conn to
+ * multiplexed mode if any.
+ *
+ * Note: Only TCP conns of a StreamListenerV2 can be multiplexed, because the stream listener
+ * receives the headers of the requests of multiplexed conns. (Datagram listeners don't accept this
+ * msg type.)
+ *
+ * @param numRequested as requested by the peer.
+ * @param maxCredits from the config, 0 if multiplexed conns are disabled.
+ * @return the number of credits (0 means "conn stays in normal mode").
+ */
+unsigned SetChannelMultiplexedMsgEx::grantCredits(Socket* sock, int numRequested,
+   unsigned maxCredits, bool isLocallyGenerated)
+{
+   if(!maxCredits || (numRequested <= 0) ||
+      (sock->getSockType() != NICADDRTYPE_STANDARD) ||
+      sock->getIsMultiplexedRequest() ||
+      isLocallyGenerated)
+      return 0;
+
+   unsigned numCredits = std::min<unsigned>(numRequested, maxCredits);
+
+   /* (the stream listener switches to multiplexed mode when the conn is returned after our
+      response, so the response is still sent in normal mode) */
+   static_cast<PooledSocket*>(sock)->setMultiplexCredits(numCredits);
+
+   return numCredits;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <common/net/message/control/SetChannelMultiplexedMsg.h>
+
+
+class SetChannelMultiplexedMsgEx : public SetChannelMultiplexedMsg
+{
+   public:
+      virtual bool processIncoming(ResponseContext& ctx);
+
+      static unsigned grantCredits(Socket* sock, int numRequested, unsigned maxCredits,
+         bool isLocallyGenerated);
+};
+
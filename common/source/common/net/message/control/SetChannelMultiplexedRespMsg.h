@@ -0,0 +1,24 @@
+#pragma once
+
+#include <common/net/message/SimpleIntMsg.h>
+
+
+class SetChannelMultiplexedRespMsg : public SimpleIntMsg
+{
+   public:
+      /**
+       * @param numCredits granted max number of requests in flight (0 if not multiplexed)
+       */
+      SetChannelMultiplexedRespMsg(int numCredits) :
+         SimpleIntMsg(NETMSGTYPE_SetChannelMultiplexedResp, numCredits)
+      {
+      }
+
+      /**
+       * For deserialization only
+       */
+      SetChannelMultiplexedRespMsg() : SimpleIntMsg(NETMSGTYPE_SetChannelMultiplexedResp)
+      {
+      }
+};
+
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <common/net/message/NetMessage.h>
+#include <common/storage/PathInfo.h>
+
+
+#define GETCHUNKFILEATTRSBATCHMSG_FLAG_BUDDYMIRROR        1 /* targetID is a buddymirrorgroup ID */
+#define GETCHUNKFILEATTRSBATCHMSG_FLAG_BUDDYMIRROR_SECOND 2 /* secondary of group, otherwise primary */
+
+#define GETCHUNKFILEATTRSBATCHMSG_MAX_ENTRIES             1024
+
+
+/**
+ * Batched variant of GetChunkFileAttribsMsg: requests the attribs of the chunk files of many
+ * entries from a single storage target, so that stat-heavy workloads (e.g. "ls -l" of a large
+ * dir) don't need a round trip per file and target.
+ */
+class GetChunkFileAttribsBatchMsg : public NetMessageSerdes<GetChunkFileAttribsBatchMsg>
+{
+   public:
+      struct Entry
+      {
+         std::string entryID;
+         PathInfo pathInfo;
+
+         template<typename This, typename Ctx>
+         static void serialize(This obj, Ctx& ctx)
+         {
+            ctx
+               % serdes::stringAlign4(obj->entryID)
+               % obj->pathInfo;
+         }
+      };
+
+      typedef std::vector<Entry> EntryVec;
+
+      /**
+       * @param entries max GETCHUNKFILEATTRSBATCHMSG_MAX_ENTRIES; not owned by this object!
+       */
+      GetChunkFileAttribsBatchMsg(uint16_t targetID, EntryVec* entries) :
+         BaseType(NETMSGTYPE_GetChunkFileAttribsBatch), targetID(targetID), entriesPtr(entries)
+      {
+      }
+
+      /**
+       * For deserialization only
+       */
+      GetChunkFileAttribsBatchMsg() : BaseType(NETMSGTYPE_GetChunkFileAttribsBatch)
+      {
+      }
+
+      template<typename This, typename Ctx>
+      static void serialize(This obj, Ctx& ctx)
+      {
+         ctx
+            % obj->targetID
+            % serdes::backedPtr(obj->entriesPtr, obj->entries);
+
+         serdesCheck(obj, ctx);
+      }
+
+      unsigned getSupportedHeaderFeatureFlagsMask() const
+      {
+         return GETCHUNKFILEATTRSBATCHMSG_FLAG_BUDDYMIRROR |
+            GETCHUNKFILEATTRSBATCHMSG_FLAG_BUDDYMIRROR_SECOND;
+      }
+
+   private:
+      uint16_t targetID;
+
+      static void serdesCheck(const GetChunkFileAttribsBatchMsg*, Serializer&) {}
+
+      static void serdesCheck(GetChunkFileAttribsBatchMsg* obj, Deserializer& des)
+      {
+         // (the receiver would otherwise stat an unbounded number of chunks in one request)
+         if(unlikely(obj->entries.size() > GETCHUNKFILEATTRSBATCHMSG_MAX_ENTRIES) )
+            des.setBad();
+      }
+
+      // for serialization
+      EntryVec* entriesPtr;
+
+      // for deserialization
+      EntryVec entries;
+
+
+   public:
+      // getters & setters
+      uint16_t getTargetID() const
+      {
+         return targetID;
+      }
+
+      EntryVec& getEntries()
+      {
+         return entries;
+      }
+};
+
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <common/net/message/NetMessage.h>
+#include <common/storage/striping/DynamicFileAttribs.h>
+#include <common/Common.h>
+
+/**
+ * Response to GetChunkFileAttribsBatchMsg with one entry per requested entry (in the same order).
+ */
+class GetChunkFileAttribsBatchRespMsg : public NetMessageSerdes<GetChunkFileAttribsBatchRespMsg>
+{
+   public:
+      struct Entry
+      {
+         int32_t result;
+         DynamicFileAttribs attribs; // storageVersion 0 if the chunk file doesn't exist
+
+         template<typename This, typename Ctx>
+         static void serialize(This obj, Ctx& ctx)
+         {
+            ctx
+               % obj->result
+               % obj->attribs;
+         }
+      };
+
+      typedef std::vector<Entry> EntryVec;
+
+      /**
+       * @param entries not owned by this object!
+       */
+      GetChunkFileAttribsBatchRespMsg(EntryVec* entries) :
+         BaseType(NETMSGTYPE_GetChunkFileAttribsBatchResp), entriesPtr(entries)
+      {
+      }
+
+      /**
+       * For deserialization only!
+       */
+      GetChunkFileAttribsBatchRespMsg() : BaseType(NETMSGTYPE_GetChunkFileAttribsBatchResp)
+      {
+      }
+
+      template<typename This, typename Ctx>
+      static void serialize(This obj, Ctx& ctx)
+      {
+         ctx % serdes::backedPtr(obj->entriesPtr, obj->entries);
+      }
+
+   private:
+      // for serialization
+      EntryVec* entriesPtr;
+
+      // for deserialization
+      EntryVec entries;
+
+
+   public:
+      // getters & setters
+      EntryVec& getEntries()
+      {
+         return entries;
+      }
+};
+
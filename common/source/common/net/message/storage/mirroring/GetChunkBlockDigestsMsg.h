@@ -0,0 +1,90 @@
+#pragma once
+
+#include <common/net/message/NetMessage.h>
+
+#define GETCHUNKBLOCKDIGESTSMSG_FLAG_BUDDYMIRROR   1 /* path is relative to buddy mirror dir */
+
+#define GETCHUNKBLOCKDIGESTSMSG_MAX_BLOCK_SIZE     (4*1024*1024)
+#define GETCHUNKBLOCKDIGESTSMSG_MAX_NUM_BLOCKS     1024
+#define GETCHUNKBLOCKDIGESTSMSG_MAX_TOTAL_LEN      (256*1024*1024) /* max blockSize*numBlocks, to
+                                                                     limit the reads per request */
+
+
+/**
+ * Requests the digests of a range of blocks of a chunk file (see StorageTkEx::getBlockDigest() ),
+ * so that a resync only needs to transfer the blocks that differ.
+ */
+class GetChunkBlockDigestsMsg : public NetMessageSerdes<GetChunkBlockDigestsMsg>
+{
+   public:
+      /**
+       * @param relativePathStr path to the chunk, relative to the "buddymir" or "chunks" dir
+       *    depending on GETCHUNKBLOCKDIGESTSMSG_FLAG_BUDDYMIRROR
+       * @param firstBlock index of the first requested block
+       * @param numBlocks max number of requested blocks (GETCHUNKBLOCKDIGESTSMSG_MAX_NUM_BLOCKS,
+       *    and GETCHUNKBLOCKDIGESTSMSG_MAX_TOTAL_LEN for all blocks together)
+       */
+      GetChunkBlockDigestsMsg(const std::string& relativePathStr, uint16_t targetID,
+         uint32_t blockSize, int64_t firstBlock, uint32_t numBlocks) :
+         BaseType(NETMSGTYPE_GetChunkBlockDigests),
+         relativePathStr(relativePathStr), targetID(targetID), blockSize(blockSize),
+         firstBlock(firstBlock), numBlocks(numBlocks)
+      {
+      }
+
+      /**
+       * For deserialization only!
+       */
+      GetChunkBlockDigestsMsg() : BaseType(NETMSGTYPE_GetChunkBlockDigests) {}
+
+      template<typename This, typename Ctx>
+      static void serialize(This obj, Ctx& ctx)
+      {
+         ctx
+            % serdes::stringAlign4(obj->relativePathStr)
+            % obj->targetID
+            % obj->blockSize
+            % obj->firstBlock
+            % obj->numBlocks;
+      }
+
+      unsigned getSupportedHeaderFeatureFlagsMask() const
+      {
+         return GETCHUNKBLOCKDIGESTSMSG_FLAG_BUDDYMIRROR;
+      }
+
+   private:
+      std::string relativePathStr;
+      uint16_t targetID;
+      uint32_t blockSize;
+      int64_t firstBlock;
+      uint32_t numBlocks;
+
+   public:
+      // getters & setters
+
+      const std::string& getRelativePathStr() const
+      {
+         return relativePathStr;
+      }
+
+      uint16_t getTargetID() const
+      {
+         return targetID;
+      }
+
+      uint32_t getBlockSize() const
+      {
+         return blockSize;
+      }
+
+      int64_t getFirstBlock() const
+      {
+         return firstBlock;
+      }
+
+      uint32_t getNumBlocks() const
+      {
+         return numBlocks;
+      }
+};
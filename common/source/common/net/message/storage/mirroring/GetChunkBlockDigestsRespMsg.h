@@ -0,0 +1,64 @@
+#pragma once
+
+#include <common/net/message/NetMessage.h>
+#include <common/Common.h>
+
+class GetChunkBlockDigestsRespMsg : public NetMessageSerdes<GetChunkBlockDigestsRespMsg>
+{
+   public:
+      /**
+       * @param digests digests of the blocks starting at the requested first block; ends at the
+       *    end of the file. Not owned by this object!
+       */
+      GetChunkBlockDigestsRespMsg(FhgfsOpsErr result, int64_t fileSize, UInt64Vector* digests) :
+         BaseType(NETMSGTYPE_GetChunkBlockDigestsResp)
+      {
+         this->result = result;
+         this->fileSize = fileSize;
+         this->digestsPtr = digests;
+      }
+
+      /**
+       * For deserialization only!
+       */
+      GetChunkBlockDigestsRespMsg() : BaseType(NETMSGTYPE_GetChunkBlockDigestsResp)
+      {
+      }
+
+      template<typename This, typename Ctx>
+      static void serialize(This obj, Ctx& ctx)
+      {
+         ctx
+            % obj->result
+            % obj->fileSize
+            % serdes::backedPtr(obj->digestsPtr, obj->digests);
+      }
+
+   private:
+      int32_t result;
+      int64_t fileSize;
+
+      // for serialization
+      UInt64Vector* digestsPtr;
+
+      // for deserialization
+      UInt64Vector digests;
+
+   public:
+      // getters & setters
+
+      FhgfsOpsErr getResult() const
+      {
+         return (FhgfsOpsErr)result;
+      }
+
+      int64_t getFileSize() const
+      {
+         return fileSize;
+      }
+
+      UInt64Vector& getDigests()
+      {
+         return digests;
+      }
+};
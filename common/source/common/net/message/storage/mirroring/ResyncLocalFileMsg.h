@@ -18,6 +18,10 @@
 
 #define RESYNCLOCALFILEMSG_FLAG_CHUNKBALANCE_BUDDYMIRROR  64 /*check if data should be written to both primary and secondary*/
 
+#define RESYNCLOCALFILEMSG_FLAG_DELTA      128 /* only changed blocks are sent, i.e. don't truncate
+                                                  on the first block and punch holes for sparse
+                                                  areas instead of skipping them */
+
 
 #define RESYNCER_SPARSE_BLOCK_SIZE 4096 //4K
 
@@ -69,8 +73,15 @@ class ResyncLocalFileMsg : public NetMessageSerdes<ResyncLocalFileMsg>
                % obj->chunkAttribs.userID
                % obj->chunkAttribs.groupID;
 
-         ctx
-            % serdes::rawBlock(obj->dataBuf, obj->count);
+         // (the data block is the trailing data when serializing, see getTrailingData() )
+         if(ctx.isReading() )
+            ctx
+               % serdes::rawBlock(obj->dataBuf, obj->count);
+      }
+
+      std::pair<const char*, unsigned> getTrailingData() const override
+      {
+         return {dataBuf, count};
       }
 
       unsigned getSupportedHeaderFeatureFlagsMask() const
@@ -78,7 +89,7 @@ class ResyncLocalFileMsg : public NetMessageSerdes<ResyncLocalFileMsg>
          return RESYNCLOCALFILEMSG_FLAG_SETATTRIBS | RESYNCLOCALFILEMSG_FLAG_NODATA |
 
             RESYNCLOCALFILEMSG_FLAG_TRUNC | RESYNCLOCALFILEMSG_CHECK_SPARSE | RESYNCLOCALFILEMSG_FLAG_BUDDYMIRROR | RESYNCLOCALFILEMSG_FLAG_BUDDYMIRROR_SECOND | 
-            RESYNCLOCALFILEMSG_FLAG_CHUNKBALANCE_BUDDYMIRROR;
+            RESYNCLOCALFILEMSG_FLAG_CHUNKBALANCE_BUDDYMIRROR | RESYNCLOCALFILEMSG_FLAG_DELTA;
       }
 
    private:
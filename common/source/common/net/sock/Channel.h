@@ -5,11 +5,13 @@
 #include <common/nodes/NumNodeID.h>
 #include <common/nodes/NodeType.h>
 
+class StreamListenerV2;
+
 class Channel : public Pollable
 {
    protected:
       Channel()
-         : nodeType(NODETYPE_Invalid)
+         : nodeType(NODETYPE_Invalid), streamListener(NULL)
       {
          this->isDirect = true;
          this->hasActivity = true; // initially active to avoid immediate disconnection
@@ -25,6 +27,7 @@ class Channel : public Pollable
       bool isAuthenticated; // true if valid authentication message received
       NodeType nodeType;
       NumNodeID nodeID;
+      StreamListenerV2* streamListener; // that polls this channel; NULL to find it by FD
 
    public:
       // getters & setters
@@ -68,6 +71,9 @@ class Channel : public Pollable
 
       NumNodeID getNodeID() const { return nodeID; }
       void      setNodeID(NumNodeID value) { nodeID = value; }
+
+      StreamListenerV2* getStreamListener() const { return streamListener; }
+      void              setStreamListener(StreamListenerV2* value) { streamListener = value; }
 };
 
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <common/net/sock/Socket.h>
+#include <common/threading/Mutex.h>
 #include <common/toolkit/Time.h>
 
 
@@ -18,6 +19,10 @@ class PooledSocket : public Socket
       {
          this->available = false;
          this->closeOnRelease = false;
+         this->multiplexCredits = 0;
+         this->multiplexNumInFlight = 0;
+         this->multiplexIsRecvPending = false;
+         this->multiplexIsBroken = false;
       }
 
 
@@ -26,6 +31,14 @@ class PooledSocket : public Socket
       bool closeOnRelease; // if true, close this socket when it is released
       Time expireTimeStart; // 0 means "doesn't expire", otherwise time when conn was established
 
+      // server side of multiplexed conns (see SetChannelMultiplexedMsg)
+      unsigned multiplexCredits; // max requests in flight, 0 if conn is not multiplexed
+      // (only accessed by the stream listener)
+      unsigned multiplexNumInFlight; // requests that were received, but not answered yet
+      bool multiplexIsRecvPending; // true while a worker receives the payload of a request
+      bool multiplexIsBroken; // true if conn is to be deleted when no request is in flight anymore
+      Mutex multiplexSendMutex; // serializes the responses of the workers
+
 
    public:
       // inliners
@@ -77,6 +90,56 @@ class PooledSocket : public Socket
       {
          closeOnRelease = v;
       }
+
+      bool getIsMultiplexed() const
+      {
+         return multiplexCredits != 0;
+      }
+
+      unsigned getMultiplexCredits() const
+      {
+         return multiplexCredits;
+      }
+
+      void setMultiplexCredits(unsigned multiplexCredits)
+      {
+         this->multiplexCredits = multiplexCredits;
+      }
+
+      unsigned getMultiplexNumInFlight() const
+      {
+         return multiplexNumInFlight;
+      }
+
+      void setMultiplexNumInFlight(unsigned multiplexNumInFlight)
+      {
+         this->multiplexNumInFlight = multiplexNumInFlight;
+      }
+
+      bool getMultiplexIsRecvPending() const
+      {
+         return multiplexIsRecvPending;
+      }
+
+      void setMultiplexIsRecvPending(bool multiplexIsRecvPending)
+      {
+         this->multiplexIsRecvPending = multiplexIsRecvPending;
+      }
+
+      bool getMultiplexIsBroken() const
+      {
+         return multiplexIsBroken;
+      }
+
+      void setMultiplexIsBroken()
+      {
+         this->multiplexIsBroken = true;
+      }
+
+      Mutex& getMultiplexSendMutex()
+      {
+         return multiplexSendMutex;
+      }
 };
 
 
@@ -31,6 +31,31 @@ Socket::~Socket()
    // nothing to be done here
 }
 
+/**
+ * Send the given buffers as if they were one contiguous buffer (scatter-gather send).
+ *
+ * Note: This default implementation sends each buffer separately; socket types that can hand
+ * all buffers to the kernel at once override this.
+ * Note: MSG_ZEROCOPY is only a hint and ignored by socket types that don't support it. If it is
+ *    given, the caller must call waitForZeroCopySends() before it reuses the buffers.
+ *
+ * @throw SocketException
+ */
+ssize_t Socket::sendv(const struct iovec* iov, size_t iovLen, int flags)
+{
+   ssize_t numSent = 0;
+
+   for(size_t i = 0; i < iovLen; i++)
+   {
+      if(!iov[i].iov_len)
+         continue;
+
+      numSent += send(iov[i].iov_base, iov[i].iov_len, flags & ~MSG_ZEROCOPY);
+   }
+
+   return numSent;
+}
+
 
 /**
  * @throw SocketException
@@ -15,6 +15,7 @@
 #include "SocketTimeoutException.h"
 
 #include <sched.h>
+#include <sys/uio.h>
 
 
 class Socket : public Channel
@@ -38,6 +39,15 @@ class Socket : public Channel
 
       virtual ssize_t send(const void *buf, size_t len, int flags) = 0;
       virtual ssize_t sendto(const void *buf, size_t len, int flags, const SocketAddress* to) = 0;
+      virtual ssize_t sendv(const struct iovec* iov, size_t iovLen, int flags);
+
+      /**
+       * Wait until the kernel doesn't reference the buffers of previous MSG_ZEROCOPY sends any
+       * longer (see StandardSocket::sendv() ); nothing to do for other socket types.
+       *
+       * @throw SocketException
+       */
+      virtual void waitForZeroCopySends() {}
 
       virtual ssize_t recv(void *buf, size_t len, int flags) = 0;
       virtual ssize_t recvT(void *buf, size_t len, int flags, int timeoutMS) = 0;
@@ -101,6 +111,15 @@ class Socket : public Channel
          return bindPort;
       }
 
+      /**
+       * @return true if this is not a connection, but a single request that was received on a
+       *    multiplexed connection (see MultiplexedRequestSocket)
+       */
+      virtual bool getIsMultiplexedRequest() const
+      {
+         return false;
+      }
+
       // inliners
 
       /**
@@ -8,14 +8,20 @@
 #include "common/net/sock/IPAddress.h"
 #include "IPAddress.h"
 
+#include <linux/errqueue.h>
 #include <netinet/in.h>
+#include <signal.h>
 #include <sys/epoll.h>
+#include <sys/sendfile.h>
 #include <sys/socket.h>
 
 
 #define STANDARDSOCKET_CONNECT_TIMEOUT_MS         5000
 #define STANDARDSOCKET_UDP_COOLING_SLEEP_US      10000
 #define STANDARDSOCKET_UDP_COOLING_RETRIES           5
+#define STANDARDSOCKET_ZEROCOPY_MIN_SIZE      (64*1024) /* smaller sends are cheaper to copy than
+                                                          to wait for their completion */
+#define STANDARDSOCKET_ZEROCOPY_TIMEOUT_MS       60000
 
 /**
  * @throw SocketException
@@ -386,6 +392,281 @@ ssize_t StandardSocket::send(const void *buf, size_t len, int flags)
       "SysErr: " + System::getErrString() );
 }
 
+/**
+ * Scatter-gather version of send(): Sends all buffers with a single syscall, so that the caller
+ * doesn't need to copy them into one contiguous buffer.
+ *
+ * With MSG_ZEROCOPY, the kernel is asked to send the data directly from the given buffers instead
+ * of copying it to socket buffers. As the kernel keeps referencing the buffers until the data was
+ * acknowledged by the peer, the caller must not reuse them before waitForZeroCopySends() returned
+ * (e.g. after it received the response to the sent message, so that the wait doesn't cost a
+ * round trip per send). MSG_ZEROCOPY is ignored for small sends and if the kernel doesn't support
+ * it or reported that it had to copy the data anyway (e.g. for loopback connections).
+ *
+ * Note: This is a synchronous (blocking) version
+ *
+ * @throw SocketException
+ */
+ssize_t StandardSocket::sendv(const struct iovec* iov, size_t iovLen, int flags)
+{
+   size_t len = 0;
+
+   for(size_t i = 0; i < iovLen; i++)
+      len += iov[i].iov_len;
+
+   if(flags & MSG_ZEROCOPY)
+   {
+      flags &= ~MSG_ZEROCOPY;
+
+      if( (len >= STANDARDSOCKET_ZEROCOPY_MIN_SIZE) && enableZeroCopy() )
+         flags |= MSG_ZEROCOPY;
+   }
+
+   // (partial sends advance the iovecs, so we need our own copy of them)
+   std::vector<struct iovec> iovLeft(iov, iov + iovLen);
+   size_t iovOffset = 0;
+
+   size_t numSent = 0;
+   uint32_t numZeroCopySends = 0;
+   int errCode = 0;
+
+   while(numSent < len)
+   {
+      struct msghdr msg = {};
+      msg.msg_iov = &iovLeft[iovOffset];
+      msg.msg_iovlen = iovLen - iovOffset;
+
+      ssize_t sendRes = ::sendmsg(sock, &msg, flags | MSG_NOSIGNAL);
+      if(sendRes == -1)
+      {
+         if(errno == EINTR)
+            continue;
+
+         if( (errno == ENOBUFS) && (flags & MSG_ZEROCOPY) )
+         { // too many zero-copy sends pending (optmem limit) => fall back to copying
+            flags &= ~MSG_ZEROCOPY;
+            continue;
+         }
+
+         errCode = errno;
+         break;
+      }
+
+      if(!sendRes)
+         break;
+
+      numSent += sendRes;
+
+      if(flags & MSG_ZEROCOPY)
+         numZeroCopySends++;
+
+      // skip the buffers that were sent completely and advance into the partially sent one
+      size_t numSkip = sendRes;
+
+      while( (iovOffset < iovLen) && (numSkip >= iovLeft[iovOffset].iov_len) )
+         numSkip -= iovLeft[iovOffset++].iov_len;
+
+      if(numSkip)
+      {
+         iovLeft[iovOffset].iov_base = (char*)iovLeft[iovOffset].iov_base + numSkip;
+         iovLeft[iovOffset].iov_len -= numSkip;
+      }
+   }
+
+   stats->incVals.netSendBytes += numSent;
+
+   numZeroCopyPending += numZeroCopySends;
+
+   if(numSent == len)
+      return len;
+
+   if(!errCode)
+      throw SocketException(
+         std::string("sendv(): Sent only ") + StringTk::int64ToStr(numSent) +
+         std::string(" bytes of the requested ") + StringTk::int64ToStr(len) +
+         std::string(" bytes of data") );
+
+   throw SocketDisconnectException(
+      "Disconnect during sendv() to: " + peername + "; "
+      "SysErr: " + System::getErrString(errCode) );
+}
+
+/**
+ * Enable zero-copy sends on first use.
+ *
+ * @return false if zero-copy sends are not available for this socket
+ */
+bool StandardSocket::enableZeroCopy()
+{
+   if(zeroCopyProbed)
+      return zeroCopyEnabled;
+
+   zeroCopyProbed = true;
+
+   if(isDgramSocket)
+      return false;
+
+   int enable = 1;
+
+   int setRes = setsockopt(sock, SOL_SOCKET, SO_ZEROCOPY, &enable, sizeof(enable) );
+   if(setRes)
+   {
+      LOG(SOCKLIB, DEBUG, "Zero-copy sends not available.", ("peer", peername),
+         ("sysErr", System::getErrString() ) );
+      return false;
+   }
+
+   zeroCopyEnabled = true;
+
+   return true;
+}
+
+/**
+ * Wait for the completion notifications of all MSG_ZEROCOPY sendmsg() calls so far from the
+ * socket error queue, i.e. until the kernel doesn't reference their buffers any longer. Returns
+ * immediately if the notifications already arrived (e.g. because the peer responded).
+ *
+ * Note: The kernel may coalesce notifications of consecutive sends into a single range
+ * [ee_info, ee_data] of send IDs.
+ *
+ * @throw SocketException
+ */
+void StandardSocket::waitForZeroCopySends()
+{
+   bool pollReportedError = false;
+
+   while(numZeroCopyPending)
+   {
+      char controlBuf[CMSG_SPACE(sizeof(struct sock_extended_err) + sizeof(struct sockaddr_in6) )];
+      struct msghdr msg = {};
+      msg.msg_control = controlBuf;
+      msg.msg_controllen = sizeof(controlBuf);
+
+      ssize_t recvRes = ::recvmsg(sock, &msg, MSG_ERRQUEUE | MSG_DONTWAIT);
+      if(recvRes == -1)
+      {
+         if(errno == EINTR)
+            continue;
+
+         if( ( (errno != EAGAIN) && (errno != EWOULDBLOCK) ) || pollReportedError)
+            throw SocketDisconnectException(
+               "Error while waiting for zero-copy send completion from: " + peername + "; "
+               "SysErr: " + System::getErrString() );
+
+         // (error queue events are reported as POLLERR, which doesn't need to be requested)
+         struct pollfd pollStruct = {sock, 0, 0};
+
+         int pollRes = poll(&pollStruct, 1, STANDARDSOCKET_ZEROCOPY_TIMEOUT_MS);
+         if(!pollRes)
+            throw SocketTimeoutException(
+               "Timeout while waiting for zero-copy send completion from: " + peername);
+
+         if( (pollRes == -1) && (errno != EINTR) )
+            throw SocketException(
+               "Error while waiting for zero-copy send completion from: " + peername + "; "
+               "SysErr: " + System::getErrString() );
+
+         if(pollStruct.revents & (POLLHUP | POLLNVAL) )
+            throw SocketDisconnectException(
+               "Hung up while waiting for zero-copy send completion from: " + peername);
+
+         // (POLLERR without anything in the error queue means a pending socket error)
+         pollReportedError = (pollRes > 0) && (pollStruct.revents & POLLERR);
+         continue;
+      }
+
+      pollReportedError = false;
+
+      for(struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg) )
+      {
+         if( !( (cmsg->cmsg_level == SOL_IP) && (cmsg->cmsg_type == IP_RECVERR) ) &&
+             !( (cmsg->cmsg_level == SOL_IPV6) && (cmsg->cmsg_type == IPV6_RECVERR) ) )
+            continue;
+
+         const struct sock_extended_err* extErr = (struct sock_extended_err*)CMSG_DATA(cmsg);
+
+         if( (extErr->ee_origin != SO_EE_ORIGIN_ZEROCOPY) || extErr->ee_errno)
+            continue;
+
+         const uint32_t numCompleted = extErr->ee_data - extErr->ee_info + 1;
+
+         numZeroCopyPending -= std::min(numCompleted, numZeroCopyPending);
+
+         if(extErr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED)
+            zeroCopyEnabled = false; // kernel copied anyway, so waiting doesn't pay off
+      }
+   }
+}
+
+/**
+ * Send file contents directly from the page cache, without copying them to a user space buffer
+ * first.
+ *
+ * Note: There is no MSG_NOSIGNAL for sendfile(), so SIGPIPE is blocked for the calling thread
+ * while sending and a SIGPIPE that was raised by a disconnect is discarded.
+ *
+ * @param offset file offset of the data (the file position of fileFD is not changed)
+ * @throw SocketException, also if the file ends before len bytes were sent; the receiver can't
+ *    tell where the data ended in this case, so the connection must not be used any longer.
+ */
+ssize_t StandardSocket::sendfile(int fileFD, off_t offset, size_t len)
+{
+   sigset_t pipeSignalMask;
+   sigset_t oldSignalMask;
+   sigset_t pendingSignals;
+
+   sigemptyset(&pipeSignalMask);
+   sigaddset(&pipeSignalMask, SIGPIPE);
+
+   // (a SIGPIPE that was already pending before must still be delivered afterwards)
+   sigpending(&pendingSignals);
+   const bool pipeSignalWasPending = sigismember(&pendingSignals, SIGPIPE);
+
+   pthread_sigmask(SIG_BLOCK, &pipeSignalMask, &oldSignalMask);
+
+   size_t numSent = 0;
+   int errCode = 0;
+
+   while(numSent < len)
+   {
+      ssize_t sendRes = ::sendfile(sock, fileFD, &offset, len - numSent);
+      if(sendRes > 0)
+      {
+         numSent += sendRes;
+         continue;
+      }
+
+      if( (sendRes == -1) && (errno == EINTR) )
+         continue;
+
+      errCode = (sendRes == -1) ? errno : 0;
+      break;
+   }
+
+   if( (errCode == EPIPE) && !pipeSignalWasPending)
+   {
+      const struct timespec noWait = {0, 0};
+      sigtimedwait(&pipeSignalMask, NULL, &noWait);
+   }
+
+   pthread_sigmask(SIG_SETMASK, &oldSignalMask, NULL);
+
+   stats->incVals.netSendBytes += numSent;
+
+   if(numSent == len)
+      return len;
+
+   if(!errCode)
+      throw SocketException(
+         std::string("sendfile(): Sent only ") + StringTk::int64ToStr(numSent) +
+         std::string(" bytes of the requested ") + StringTk::int64ToStr(len) +
+         std::string(" bytes of data (end of file)") );
+
+   throw SocketDisconnectException(
+      "Disconnect during sendfile() to: " + peername + "; "
+      "SysErr: " + System::getErrString(errCode) );
+}
+
 /**
  * Note: ENETUNREACH (unreachable network) errors will be silenty discarded and not be returned to
  * the caller.
@@ -722,6 +1003,26 @@ void StandardSocket::setSoReuseAddr(bool enable)
       throw SocketException(std::string("setSoReuseAddr: ") + System::getErrString() );
 }
 
+/**
+ * Allow multiple sockets to bind to the same port, so that the kernel distributes incoming
+ * connections over all of them (all sockets must set this before bind).
+ *
+ * @throw SocketException
+ */
+void StandardSocket::setSoReusePort(bool enable)
+{
+   int reuseVal = (enable ? 1 : 0);
+
+   int setRes = setsockopt(sock,
+      SOL_SOCKET,
+      SO_REUSEPORT,
+      &reuseVal,
+      sizeof(reuseVal) );
+
+   if(setRes == -1)
+      throw SocketException(std::string("setSoReusePort: ") + System::getErrString() );
+}
+
 /**
  * @throw SocketException
  */
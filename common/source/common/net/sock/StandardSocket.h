@@ -30,6 +30,9 @@ class StandardSocket : public PooledSocket
 
       virtual ssize_t send(const void *buf, size_t len, int flags);
       virtual ssize_t sendto(const void *buf, size_t len, int flags, const SocketAddress* to);
+      virtual ssize_t sendv(const struct iovec* iov, size_t iovLen, int flags);
+      virtual void waitForZeroCopySends();
+      ssize_t sendfile(int fileFD, off_t offset, size_t len);
 
       virtual ssize_t recv(void *buf, size_t len, int flags);
       virtual ssize_t recvT(void *buf, size_t len, int flags, int timeoutMS);
@@ -40,6 +43,7 @@ class StandardSocket : public PooledSocket
 
       void setSoKeepAlive(bool enable);
       void setSoReuseAddr(bool enable);
+      void setSoReusePort(bool enable);
       int getSoRcvBuf();
       void setSoRcvBuf(int size);
       void setTcpNoDelay(bool enable);
@@ -57,6 +61,11 @@ class StandardSocket : public PooledSocket
 
    private:
       RandomReentrant rand;
+      bool zeroCopyProbed = false; // true after SO_ZEROCOPY was set (or failed) on first use
+      bool zeroCopyEnabled = false; // may be reset if the kernel reports that it copied anyway
+      uint32_t numZeroCopyPending = 0; // zero-copy sendmsg() calls without completion yet
+
+      bool enableZeroCopy();
 
    public:
       // getters & setters
@@ -27,6 +27,15 @@ class LocalNodeConnPool : public NodeConnPool
       void releaseStreamSocket(Socket* sock);
       void invalidateStreamSocket(Socket* sock);
 
+      /**
+       * Local msgs are processed by own worker threads per conn, so there's nothing to gain from
+       * multiplexing.
+       */
+      std::shared_ptr<MultiplexedConn> acquireMultiplexedConn()
+      {
+         return {};
+      }
+
    private:
       NicAddressList nicList;
       Mutex nicListMutex;
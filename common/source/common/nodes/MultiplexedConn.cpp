@@ -0,0 +1,210 @@
+#include <common/net/message/control/SetChannelMultiplexedMsg.h>
+#include <common/toolkit/MessagingTk.h>
+#include "MultiplexedConn.h"
+
+#include <endian.h>
+
+
+/**
+ * @param sock a conn that was already switched to multiplexed mode (it can't be used for normal
+ *    requests anymore); must stay valid until this object is destroyed.
+ * @param recvTimeoutMS for each response (while requests are in flight).
+ */
+MultiplexedConn::MultiplexedConn(Socket* sock, unsigned numCredits, int recvTimeoutMS) :
+   sock(sock), numCredits(numCredits), recvTimeoutMS(recvTimeoutMS), lastTag(0),
+   isReceiving(false), isBroken(false)
+{
+}
+
+/**
+ * Send a request and wait for its response.
+ *
+ * @param requestBuf a serialized msg (at most NETMSG_MULTIPLEXED_REQUEST_MAXLEN bytes).
+ * @return the serialized response msg.
+ * @throw SocketException on communication error (which breaks the conn for all requests in
+ *    flight).
+ */
+std::vector<char> MultiplexedConn::requestResponse(const std::vector<char>& requestBuf)
+{
+   Request request;
+
+   sendRequest(request, requestBuf);
+
+   return waitResponse(request);
+}
+
+/**
+ * Send a request without waiting for its response. The caller must call waitResponse() for each
+ * sent request (also if a later request fails).
+ *
+ * @param requestBuf a serialized msg (at most NETMSG_MULTIPLEXED_REQUEST_MAXLEN bytes).
+ * @throw SocketException on communication error (which breaks the conn for all requests in
+ *    flight).
+ */
+void MultiplexedConn::sendRequest(Request& request, const std::vector<char>& requestBuf)
+{
+   std::unique_lock<Mutex> lock(mutex); // L O C K
+
+   // wait for a credit (i.e. for the response to another request, which might be one of the
+   // caller's own requests, so we might have to receive it ourselves)
+
+   while(!isBroken && (pendingRequests.size() >= numCredits) )
+      recvOrWaitUnlocked(lock);
+
+   if(unlikely(isBroken) )
+      throw SocketDisconnectException("Multiplexed connection is broken: " + getPeername() );
+
+   request.tag = ++lastTag;
+   request.isDone = false;
+   pendingRequests[request.tag] = &request;
+
+   lock.unlock(); // U N L O C K
+
+   try
+   {
+      uint64_t tagLE = htole64(request.tag);
+
+      struct iovec iov[2] = {
+         {&tagLE, NETMSG_MULTIPLEXED_TAG_LENGTH},
+         {(void*)&requestBuf[0], requestBuf.size()} };
+
+      const std::lock_guard<Mutex> sendLock(sendMutex);
+
+      sock->sendv(iov, 2, 0);
+   }
+   catch(SocketException& e)
+   {
+      lock.lock();
+
+      pendingRequests.erase(request.tag);
+      setBrokenUnlocked();
+
+      throw;
+   }
+}
+
+/**
+ * Wait for the response to a request from sendRequest().
+ *
+ * @return the serialized response msg.
+ * @throw SocketException on communication error (which breaks the conn for all requests in
+ *    flight).
+ */
+std::vector<char> MultiplexedConn::waitResponse(Request& request)
+{
+   std::unique_lock<Mutex> lock(mutex); // L O C K
+
+   // receive responses (also those of other requesters) until our response arrived
+
+   try
+   {
+      while(!request.isDone && !isBroken)
+         recvOrWaitUnlocked(lock);
+   }
+   catch(SocketException& e)
+   {
+      pendingRequests.erase(request.tag);
+      throw;
+   }
+
+   if(unlikely(!request.isDone) )
+   { // conn broke while another requester was receiving
+      pendingRequests.erase(request.tag);
+
+      throw SocketDisconnectException("Multiplexed connection broke: " + getPeername() );
+   }
+
+   return std::move(request.responseBuf);
+}
+
+/**
+ * Break the conn, e.g. because an invalid response was received. Requests in flight will fail.
+ */
+void MultiplexedConn::invalidate()
+{
+   const std::lock_guard<Mutex> lock(mutex);
+
+   setBrokenUnlocked();
+}
+
+/**
+ * Receive a single response if no other requester is receiving, otherwise wait until the other
+ * requester delivered a response or passes on.
+ *
+ * Note: Caller must hold the mutex through the given lock.
+ *
+ * @throw SocketException on communication error (the conn is broken then).
+ */
+void MultiplexedConn::recvOrWaitUnlocked(std::unique_lock<Mutex>& lock)
+{
+   if(isReceiving)
+   {
+      changeCond.wait(&mutex);
+      return;
+   }
+
+   isReceiving = true;
+
+   lock.unlock(); // U N L O C K
+
+   try
+   {
+      recvResponse(recvTimeoutMS);
+   }
+   catch(SocketException& e)
+   {
+      lock.lock();
+
+      isReceiving = false;
+      setBrokenUnlocked();
+
+      throw;
+   }
+
+   lock.lock(); // L O C K
+
+   isReceiving = false;
+
+   changeCond.broadcast(); // (another requester might have to take over receiving now)
+}
+
+/**
+ * Receive a single response and deliver it to its requester.
+ *
+ * @throw SocketException
+ */
+void MultiplexedConn::recvResponse(int timeoutMS)
+{
+   uint64_t tag;
+
+   sock->recvExactT(&tag, sizeof(tag), 0, timeoutMS);
+
+   tag = le64toh(tag);
+
+   auto responseBuf = MessagingTk::recvMsgBufT(*sock, timeoutMS);
+   if(responseBuf.empty() )
+      throw SocketException("Received an invalid multiplexed response from: " + getPeername() );
+
+   const std::lock_guard<Mutex> lock(mutex);
+
+   PendingRequestMap::iterator iter = pendingRequests.find(tag);
+   if(unlikely(iter == pendingRequests.end() ) )
+      throw SocketException("Received a multiplexed response with unknown tag from: " +
+         getPeername() );
+
+   iter->second->responseBuf = std::move(responseBuf);
+   iter->second->isDone = true;
+
+   pendingRequests.erase(iter); // (frees the credit)
+}
+
+/**
+ * Note: Caller must hold the mutex.
+ */
+void MultiplexedConn::setBrokenUnlocked()
+{
+   isBroken = true;
+
+   changeCond.broadcast();
+}
+
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <common/net/sock/PooledSocket.h>
+#include <common/threading/Condition.h>
+#include <common/threading/Mutex.h>
+#include <common/Common.h>
+
+#include <map>
+#include <mutex>
+
+
+/**
+ * Client side of a multiplexed conn (see SetChannelMultiplexedMsg): Requests of multiple threads
+ * are sent over the same conn without waiting for each other's responses, and the responses are
+ * matched to their requests by tag in whatever order the server sends them.
+ *
+ * There is no receiver thread: One of the waiting requesters receives the responses for all
+ * others until its own response arrives, then the next waiting requester takes over.
+ * The number of requests in flight is limited by the credits that the server granted, further
+ * requesters wait for a credit.
+ *
+ * A requester may also have multiple requests in flight (sendRequest() and waitResponse() instead
+ * of requestResponse() ), e.g. to fan out a request to many targets of the same node.
+ *
+ * Note: Any communication error breaks the conn for all requests in flight (they fail like on a
+ * normal conn and the caller retries), NodeConnPool establishes a new one for later requests.
+ * Note: The socket stays owned by the caller (NodeConnPool gives it back to the pool when the last
+ * reference to this object is dropped, see NodeConnPool::acquireMultiplexedConn() ).
+ */
+class MultiplexedConn
+{
+   public:
+      MultiplexedConn(Socket* sock, unsigned numCredits, int recvTimeoutMS);
+
+      MultiplexedConn(const MultiplexedConn&) = delete;
+      MultiplexedConn(MultiplexedConn&&) = delete;
+      MultiplexedConn& operator=(const MultiplexedConn&) = delete;
+      MultiplexedConn& operator=(MultiplexedConn&&) = delete;
+
+      /**
+       * A request in flight. Must not be moved or destroyed until waitResponse() returned.
+       */
+      struct Request
+      {
+         Request() : tag(0), isDone(false) {}
+
+         uint64_t tag;
+         bool isDone;
+         std::vector<char> responseBuf;
+      };
+
+      std::vector<char> requestResponse(const std::vector<char>& requestBuf);
+      void sendRequest(Request& request, const std::vector<char>& requestBuf);
+      std::vector<char> waitResponse(Request& request);
+      void invalidate();
+
+
+   private:
+      typedef std::map<uint64_t, Request*> PendingRequestMap; // key is tag
+
+      Socket* sock;
+      unsigned numCredits; // max requests in flight (as granted by the server)
+      int recvTimeoutMS;
+
+      Mutex sendMutex; // to not mix up the requests of different threads on the stream
+
+      Mutex mutex; // protects the members below
+      Condition changeCond; // signaled when a response was delivered or the conn broke
+      PendingRequestMap pendingRequests; // sent requests that are waiting for their response
+      uint64_t lastTag;
+      bool isReceiving; // true while one of the requesters receives responses
+      bool isBroken;
+
+      void recvOrWaitUnlocked(std::unique_lock<Mutex>& lock);
+      void recvResponse(int timeoutMS);
+      void setBrokenUnlocked();
+
+
+   public:
+      // getters & setters
+
+      bool getIsBroken()
+      {
+         const std::lock_guard<Mutex> lock(mutex);
+
+         return isBroken;
+      }
+
+      /**
+       * @return true if the conn was established over a fallback route and has expired (see
+       *    PooledSocket::getHasExpired() ).
+       */
+      bool getHasExpired(unsigned expireSecs)
+      {
+         return static_cast<PooledSocket*>(sock)->getHasExpired(expireSecs);
+      }
+
+      std::string getPeername()
+      {
+         return sock->getPeername();
+      }
+};
+
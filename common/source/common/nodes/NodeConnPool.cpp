@@ -2,6 +2,8 @@
 #include <common/app/AbstractApp.h>
 #include <common/net/message/control/AuthenticateChannelMsg.h>
 #include <common/net/message/control/SetChannelDirectMsg.h>
+#include <common/net/message/control/SetChannelMultiplexedMsg.h>
+#include <common/net/message/control/SetChannelMultiplexedRespMsg.h>
 #include <common/threading/PThread.h>
 #include <common/toolkit/MessagingTk.h>
 #include "Node.h"
@@ -14,6 +16,7 @@
 #include <boost/lexical_cast.hpp>
 
 #define NODECONNPOOL_SHUTDOWN_WAITTIMEMS              500
+#define NODECONNPOOL_MULTIPLEX_RETRY_MS               (10*60*1000) /* after failed handshake */
 
 
 /**
@@ -24,7 +27,7 @@
  * @param nicList an internal copy will be created.
  */
 NodeConnPool::NodeConnPool(Node& parentNode, uint16_t streamPort, const NicAddressList& nicList):
-   parentNode(parentNode)
+   parentNode(parentNode), multiplexRefusedT(true)
 {
    AbstractApp* app = PThread::getCurrentThreadApp();
    auto cfg = app->getCommonConfig();
@@ -61,6 +64,8 @@ NodeConnPool::~NodeConnPool()
 {
    const char* logContext = "NodeConn (destruct)";
 
+   multiplexedConn.reset(); // (gives its socket back to us)
+
    if(!connList.empty() )
    {
       LogContext(logContext).log(Log_DEBUG,
@@ -344,6 +349,117 @@ Socket* NodeConnPool::acquireStreamSocketEx(bool allowWaiting)
    return sock;
 }
 
+/**
+ * Get the multiplexed conn to this node (see MultiplexedConn), which is established with the
+ * first call.
+ *
+ * Note: Multiplexing is only used if enabled via connMultiplexedRequests and only with meta and
+ * storage nodes (which receive requests through a StreamListenerV2). If the node refuses the
+ * handshake (e.g. because it has multiplexing disabled or is an older version that disconnects on
+ * the unknown msg type), it won't be asked again for some time.
+ *
+ * @return NULL if multiplexing is not possible at the moment (caller should use a normal conn).
+ */
+std::shared_ptr<MultiplexedConn> NodeConnPool::acquireMultiplexedConn()
+{
+   const unsigned numCredits = app->getCommonConfig()->getConnMultiplexedRequests();
+
+   if(!numCredits ||
+      ( (parentNode.getNodeType() != NODETYPE_Meta) &&
+        (parentNode.getNodeType() != NODETYPE_Storage) ) )
+      return {};
+
+   std::shared_ptr<MultiplexedConn> oldConn; // (dropped after unlock, disconnect takes a while)
+
+   const std::lock_guard<Mutex> lock(multiplexMutex);
+
+   if(multiplexedConn)
+   {
+      if(likely(!multiplexedConn->getIsBroken() &&
+         !multiplexedConn->getHasExpired(fallbackExpirationSecs) ) )
+         return multiplexedConn;
+
+      // (requests in flight keep using the old conn until they are done)
+      oldConn = std::move(multiplexedConn);
+   }
+
+   if(!multiplexRefusedT.getIsZero() &&
+      (multiplexRefusedT.elapsedMS() < NODECONNPOOL_MULTIPLEX_RETRY_MS) )
+      return {};
+
+   Socket* sock = NULL;
+
+   try
+   {
+      sock = acquireStreamSocketEx(false);
+      if(!sock)
+         return {}; // all conns in use, try again next time
+
+      if(sock->getSockType() != NICADDRTYPE_STANDARD)
+      { // only TCP conns can be multiplexed
+         releaseStreamSocket(sock);
+         multiplexRefusedT.setToNow();
+         return {};
+      }
+
+      SetChannelMultiplexedMsg requestMsg(numCredits);
+
+      MessagingTk::sendMsg(*sock, requestMsg);
+
+      auto respBuf = MessagingTk::recvMsgBuf(*sock);
+      if(respBuf.empty() )
+         throw SocketException("Invalid response");
+
+      auto respMsg = app->getNetMessageFactory()->createFromBuf(std::move(respBuf) );
+      if(respMsg->getMsgType() != NETMSGTYPE_SetChannelMultiplexedResp)
+         throw SocketException("Invalid response type: " + respMsg->getMsgTypeStr() );
+
+      const int numGranted = static_cast<SetChannelMultiplexedRespMsg&>(*respMsg).getValue();
+      if(numGranted <= 0)
+      { // refused => conn stays in normal mode
+         LOG(COMMUNICATION, DEBUG, "Node refused multiplexed connection.",
+            ("node", parentNode.getNodeIDWithTypeStr() ) );
+
+         releaseStreamSocket(sock);
+         multiplexRefusedT.setToNow();
+         return {};
+      }
+
+      LOG(COMMUNICATION, DEBUG, "Established multiplexed connection.",
+         ("node", parentNode.getNodeIDWithTypeStr() ), ("credits", numGranted) );
+
+      const int recvTimeoutMS = app->getCommonConfig()->getConnMsgLongTimeout();
+
+      // the last requester that drops its reference gives the sock back to us
+      multiplexedConn = std::shared_ptr<MultiplexedConn>(
+         new MultiplexedConn(sock, numGranted, recvTimeoutMS),
+         [this, sock] (MultiplexedConn* conn) {
+            delete(conn);
+
+            // the server won't accept normal requests on this conn anymore => disconnect
+            static_cast<PooledSocket*>(sock)->setCloseOnRelease(true);
+
+            releaseStreamSocket(sock);
+         });
+      multiplexRefusedT = Time(true);
+
+      return multiplexedConn;
+   }
+   catch(SocketException& e)
+   {
+      LOG(COMMUNICATION, NOTICE, "Unable to establish multiplexed connection. "
+         "Using normal connections.", ("node", parentNode.getNodeIDWithTypeStr() ),
+         ("error", e.what() ) );
+   }
+
+   if(sock)
+      invalidateSpecificStreamSocket(sock);
+
+   multiplexRefusedT.setToNow();
+
+   return {};
+}
+
 void NodeConnPool::releaseStreamSocket(Socket* sock)
 {
    PooledSocket* pooledSock = (PooledSocket*)sock;
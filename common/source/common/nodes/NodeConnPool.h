@@ -5,11 +5,13 @@
 #include <common/net/sock/PooledSocket.h>
 #include <common/net/sock/StandardSocket.h>
 #include <common/net/sock/RDMASocket.h>
+#include <common/nodes/MultiplexedConn.h>
 #include <common/threading/Mutex.h>
 #include <common/threading/Condition.h>
 #include <common/Common.h>
 #include <common/net/sock/RoutingTable.h>
 
+#include <memory>
 #include <mutex>
 
 typedef std::list<PooledSocket*> ConnectionList;
@@ -113,6 +115,7 @@ class NodeConnPool
       virtual Socket* acquireStreamSocketEx(bool allowWaiting);
       virtual void releaseStreamSocket(Socket* sock);
       virtual void invalidateStreamSocket(Socket* sock);
+      virtual std::shared_ptr<MultiplexedConn> acquireMultiplexedConn();
 
       unsigned disconnectAndResetIdleStreams();
 
@@ -146,6 +149,10 @@ class NodeConnPool
       Mutex mutex;
       Condition changeCond;
 
+      Mutex multiplexMutex; // for the members below (not mutex, because a handshake takes a while)
+      std::shared_ptr<MultiplexedConn> multiplexedConn; // NULL until first multiplexed request
+      Time multiplexRefusedT; // last failed attempt to establish multiplexedConn (zero if none)
+
       virtual void invalidateSpecificStreamSocket(Socket* sock);
       virtual unsigned invalidateAllAvailableStreams(bool idleStreamsOnly, bool closeOnRelease);
       void resetStreamsIdleFlag();
@@ -0,0 +1,274 @@
+// CRC-32C (Castagnoli), as used by iSCSI, ext4 and btrfs.
+//
+// The hardware variant uses the SSE4.2 crc32 instruction on three interleaved streams to hide the
+// latency of the instruction and combines the stream results by shifting them over the length of
+// the following streams (multiplication with a precomputed GF(2) "zeros" operator). This is the
+// approach of Mark Adler's crc32c.c. Without SSE4.2 we fall back to a slicing-by-8 table
+// implementation.
+
+#include "common/Common.h"
+
+#include "ChecksumTk.h"
+
+#if defined(__x86_64__)
+   #include <nmmintrin.h>
+   #define CHECKSUMTK_HAVE_SSE42_IMPL
+#endif
+
+
+#define CRC32C_POLY        0x82f63b78 /* reversed castagnoli polynomial */
+
+#define CRC32C_LONG_BLOCK  8192 /* stream length for large inputs */
+#define CRC32C_SHORT_BLOCK 256  /* stream length for the rest */
+
+
+namespace {
+
+struct Crc32cTables
+{
+   uint32_t sliced[8][256]; // slicing-by-8 tables for software crc
+
+   uint32_t longZeros[4][256]; // shift operator for CRC32C_LONG_BLOCK zero bytes
+   uint32_t shortZeros[4][256]; // shift operator for CRC32C_SHORT_BLOCK zero bytes
+
+   bool haveSSE42;
+
+   Crc32cTables()
+   {
+      for(unsigned n = 0; n < 256; n++)
+      {
+         uint32_t crc = n;
+
+         for(unsigned k = 0; k < 8; k++)
+            crc = (crc & 1) ? ( (crc >> 1) ^ CRC32C_POLY) : (crc >> 1);
+
+         sliced[0][n] = crc;
+      }
+
+      for(unsigned n = 0; n < 256; n++)
+      {
+         uint32_t crc = sliced[0][n];
+
+         for(unsigned k = 1; k < 8; k++)
+         {
+            crc = sliced[0][crc & 0xff] ^ (crc >> 8);
+            sliced[k][n] = crc;
+         }
+      }
+
+      initZeros(longZeros, CRC32C_LONG_BLOCK);
+      initZeros(shortZeros, CRC32C_SHORT_BLOCK);
+
+      #ifdef CHECKSUMTK_HAVE_SSE42_IMPL
+         haveSSE42 = __builtin_cpu_supports("sse4.2");
+      #else
+         haveSSE42 = false;
+      #endif
+   }
+
+   static uint32_t gf2MatrixTimes(const uint32_t* mat, uint32_t vec)
+   {
+      uint32_t sum = 0;
+
+      for( ; vec; vec >>= 1, mat++)
+      {
+         if(vec & 1)
+            sum ^= *mat;
+      }
+
+      return sum;
+   }
+
+   static void gf2MatrixSquare(uint32_t* square, const uint32_t* mat)
+   {
+      for(unsigned n = 0; n < 32; n++)
+         square[n] = gf2MatrixTimes(mat, mat[n]);
+   }
+
+   /**
+    * Build the operator (32x32 matrix over GF(2) ) for applying len zero bytes to a crc.
+    */
+   static void zerosOperator(uint32_t* even, size_t len)
+   {
+      uint32_t odd[32];
+
+      // operator for one zero bit
+      odd[0] = CRC32C_POLY;
+      for(unsigned n = 1; n < 32; n++)
+         odd[n] = 1U << (n - 1);
+
+      gf2MatrixSquare(even, odd); // two zero bits
+      gf2MatrixSquare(odd, even); // four zero bits
+
+      // square until the bits of len are consumed; operator ends up in even or odd
+      for( ; ; )
+      {
+         gf2MatrixSquare(even, odd);
+         len >>= 1;
+         if(!len)
+            return;
+
+         gf2MatrixSquare(odd, even);
+         len >>= 1;
+         if(!len)
+            break;
+      }
+
+      for(unsigned n = 0; n < 32; n++)
+         even[n] = odd[n];
+   }
+
+   static void initZeros(uint32_t zeros[4][256], size_t len)
+   {
+      uint32_t op[32];
+
+      zerosOperator(op, len);
+
+      for(unsigned n = 0; n < 256; n++)
+      {
+         zeros[0][n] = gf2MatrixTimes(op, n);
+         zeros[1][n] = gf2MatrixTimes(op, n << 8);
+         zeros[2][n] = gf2MatrixTimes(op, n << 16);
+         zeros[3][n] = gf2MatrixTimes(op, n << 24);
+      }
+   }
+};
+
+const Crc32cTables& getTables()
+{
+   static const Crc32cTables tables;
+   return tables;
+}
+
+uint32_t crc32cShift(const uint32_t zeros[4][256], uint32_t crc)
+{
+   return zeros[0][crc & 0xff] ^ zeros[1][(crc >> 8) & 0xff] ^
+      zeros[2][(crc >> 16) & 0xff] ^ zeros[3][crc >> 24];
+}
+
+uint32_t crc32cSoftware(const Crc32cTables& tables, uint32_t crc, const unsigned char* next,
+   size_t len)
+{
+   crc = ~crc;
+
+   for( ; len && ( (uintptr_t)next & 7); len--)
+      crc = tables.sliced[0][(crc ^ *next++) & 0xff] ^ (crc >> 8);
+
+   for( ; len >= 8; len -= 8, next += 8)
+   {
+      uint64_t word;
+      memcpy(&word, next, sizeof(word) );
+
+      #if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+         word = __builtin_bswap64(word);
+      #endif
+
+      word ^= crc;
+
+      crc = tables.sliced[7][word & 0xff] ^
+         tables.sliced[6][(word >> 8) & 0xff] ^
+         tables.sliced[5][(word >> 16) & 0xff] ^
+         tables.sliced[4][(word >> 24) & 0xff] ^
+         tables.sliced[3][(word >> 32) & 0xff] ^
+         tables.sliced[2][(word >> 40) & 0xff] ^
+         tables.sliced[1][(word >> 48) & 0xff] ^
+         tables.sliced[0][word >> 56];
+   }
+
+   for( ; len; len--)
+      crc = tables.sliced[0][(crc ^ *next++) & 0xff] ^ (crc >> 8);
+
+   return ~crc;
+}
+
+#ifdef CHECKSUMTK_HAVE_SSE42_IMPL
+
+/**
+ * Process len bytes (multiple of 3 * blockLen) in three interleaved streams.
+ */
+__attribute__((target("sse4.2")))
+uint64_t crc32cSSE42Streams(const uint32_t zeros[4][256], uint64_t crc0,
+   const unsigned char*& next, size_t& len, size_t blockLen)
+{
+   while(len >= 3 * blockLen)
+   {
+      uint64_t crc1 = 0;
+      uint64_t crc2 = 0;
+      const unsigned char* end = next + blockLen;
+
+      do
+      {
+         uint64_t word0, word1, word2;
+
+         memcpy(&word0, next, sizeof(word0) );
+         memcpy(&word1, next + blockLen, sizeof(word1) );
+         memcpy(&word2, next + 2 * blockLen, sizeof(word2) );
+
+         crc0 = _mm_crc32_u64(crc0, word0);
+         crc1 = _mm_crc32_u64(crc1, word1);
+         crc2 = _mm_crc32_u64(crc2, word2);
+
+         next += 8;
+      } while(next < end);
+
+      crc0 = crc32cShift(zeros, crc0) ^ crc1;
+      crc0 = crc32cShift(zeros, crc0) ^ crc2;
+
+      next += 2 * blockLen;
+      len -= 3 * blockLen;
+   }
+
+   return crc0;
+}
+
+__attribute__((target("sse4.2")))
+uint32_t crc32cSSE42(const Crc32cTables& tables, uint32_t crc, const unsigned char* next,
+   size_t len)
+{
+   uint64_t crc0 = ~crc;
+
+   for( ; len && ( (uintptr_t)next & 7); len--)
+      crc0 = _mm_crc32_u8(crc0, *next++);
+
+   crc0 = crc32cSSE42Streams(tables.longZeros, crc0, next, len, CRC32C_LONG_BLOCK);
+   crc0 = crc32cSSE42Streams(tables.shortZeros, crc0, next, len, CRC32C_SHORT_BLOCK);
+
+   for( ; len >= 8; len -= 8, next += 8)
+   {
+      uint64_t word;
+      memcpy(&word, next, sizeof(word) );
+
+      crc0 = _mm_crc32_u64(crc0, word);
+   }
+
+   for( ; len; len--)
+      crc0 = _mm_crc32_u8(crc0, *next++);
+
+   return ~(uint32_t)crc0;
+}
+
+#endif // CHECKSUMTK_HAVE_SSE42_IMPL
+
+} // namespace
+
+
+/**
+ * Update a CRC-32C with the given data (start with crc 0); crc32c(crc32c(0, a), b) is the crc
+ * of the concatenation of a and b.
+ */
+uint32_t ChecksumTk::crc32c(uint32_t crc, const void* data, size_t len)
+{
+   const Crc32cTables& tables = getTables();
+
+   #ifdef CHECKSUMTK_HAVE_SSE42_IMPL
+      if(likely(tables.haveSSE42) )
+         return crc32cSSE42(tables, crc, (const unsigned char*)data, len);
+   #endif
+
+   return crc32cSoftware(tables, crc, (const unsigned char*)data, len);
+}
+
+bool ChecksumTk::crc32cIsHardwareAccelerated()
+{
+   return getTables().haveSSE42;
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+
+namespace ChecksumTk {
+   uint32_t crc32c(uint32_t crc, const void* data, size_t len);
+
+   bool crc32cIsHardwareAccelerated();
+}
+
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+
+/**
+ * Bookkeeping for a bounded cache of key/value pairs with CLOCK ("second chance") eviction, i.e.
+ * an approximation of LRU that doesn't need to reorder anything when an entry is used.
+ *
+ * All entries are kept on a ring that is traversed by the clock hand on eviction. touch() sets
+ * the "recently used" bit of an entry; the hand clears set bits and evicts the first entry whose
+ * bit is not set. New entries are inserted right behind the hand, so they are examined last.
+ * Lookups are O(1) through a hash index, eviction is O(1) amortized.
+ *
+ * The cache does not own the values and is not thread-safe, callers have to lock. The only
+ * exception is touch(), which is safe to be called concurrently with other touch() or contains()
+ * calls (i.e. under a read lock), but not concurrently with modifying methods.
+ */
+template<typename Key, typename Value, typename Hash = std::hash<Key>>
+class ClockCache
+{
+   private:
+      struct Entry
+      {
+         Entry(const Key& key, const Value& value) :
+            key(key), value(value), recentlyUsed(false)
+         {
+         }
+
+         Key key;
+         Value value;
+         mutable std::atomic<bool> recentlyUsed;
+      };
+
+      typedef std::list<Entry> EntryRing;
+      typedef typename EntryRing::iterator EntryRingIter;
+      typedef std::unordered_map<Key, EntryRingIter, Hash> EntryIndex;
+      typedef typename EntryIndex::iterator EntryIndexIter;
+      typedef typename EntryIndex::const_iterator EntryIndexCIter;
+
+   public:
+      ClockCache() : hand(ring.end() ) {}
+
+      ClockCache(const ClockCache&) = delete;
+      ClockCache& operator=(const ClockCache&) = delete;
+
+      /**
+       * @return false if the key was already cached (value is not updated in this case).
+       */
+      bool insert(const Key& key, const Value& value)
+      {
+         if (index.count(key) )
+            return false;
+
+         EntryRingIter newIter = ring.emplace(hand, key, value);
+         index.emplace(key, newIter);
+
+         return true;
+      }
+
+      /**
+       * @param outValue may be NULL; set to the value of the removed entry if true is returned.
+       * @return false if the key was not cached.
+       */
+      bool remove(const Key& key, Value* outValue)
+      {
+         EntryIndexIter indexIter = index.find(key);
+         if (indexIter == index.end() )
+            return false;
+
+         if (outValue)
+            *outValue = indexIter->second->value;
+
+         eraseEntry(indexIter->second);
+         index.erase(indexIter);
+
+         return true;
+      }
+
+      /**
+       * Pick the next victim with the clock algorithm and remove it from the cache.
+       *
+       * @return false if the cache is empty.
+       */
+      bool evict(Key* outKey, Value* outValue)
+      {
+         if (ring.empty() )
+            return false;
+
+         // terminates after at most one full round, because every visited entry loses its bit
+         for ( ; ; )
+         {
+            if (hand == ring.end() )
+               hand = ring.begin();
+
+            if (!hand->recentlyUsed.exchange(false, std::memory_order_relaxed) )
+               break;
+
+            ++hand;
+         }
+
+         *outKey = hand->key;
+         *outValue = hand->value;
+
+         index.erase(hand->key);
+         hand = ring.erase(hand);
+
+         return true;
+      }
+
+      /**
+       * Mark the entry as recently used, which will protect it from the next eviction round.
+       *
+       * @return false if the key is not cached.
+       */
+      bool touch(const Key& key) const
+      {
+         EntryIndexCIter indexIter = index.find(key);
+         if (indexIter == index.end() )
+            return false;
+
+         indexIter->second->recentlyUsed.store(true, std::memory_order_relaxed);
+         return true;
+      }
+
+      bool contains(const Key& key) const
+      {
+         return index.count(key) > 0;
+      }
+
+      size_t size() const
+      {
+         return index.size();
+      }
+
+      bool empty() const
+      {
+         return index.empty();
+      }
+
+
+   private:
+      EntryRing ring;
+      EntryRingIter hand; // next entry to be examined on eviction
+      EntryIndex index;
+
+      void eraseEntry(EntryRingIter iter)
+      {
+         if (iter == hand)
+            hand = ring.erase(iter);
+         else
+            ring.erase(iter);
+      }
+};
+
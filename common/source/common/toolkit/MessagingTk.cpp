@@ -1,6 +1,7 @@
 #include <common/app/log/LogContext.h>
 #include <common/app/AbstractApp.h>
 #include <common/net/message/control/GenericResponseMsg.h>
+#include <common/net/message/control/SetChannelMultiplexedMsg.h>
 #include <common/net/message/AbstractNetMessageFactory.h>
 #include <common/net/message/NetMessageLogHelper.h>
 #include <common/threading/PThread.h>
@@ -49,21 +50,20 @@ std::unique_ptr<NetMessage> MessagingTk::requestResponse(Node& node, NetMessage&
 }
 
 /**
- * Sends a message to a node and receives a response.
- * Can handle target states and mapped mirror IDs. Node does not need to be referenced by caller.
- *
- * If target states are provided, communication might be skipped for certain states.
+ * Resolves the node for request-response communication (without communicating), i.e. everything
+ * that requestResponseNode() does before sending the request.
  *
- * note: rrArgs->nodeID may optionally be provided when calling this.
- * note: received message and buffer are available through rrArgs in case of success.
+ * @param rrArgs if rrArgs->node is NULL, it will be set to outNode on success.
+ * @param outNode the referenced node if rrArgs->node was NULL; caller must keep it until
+ *    rrArgs->node isn't needed anymore.
+ * @return FhgfsOpsErr_COMMUNICATION if communication should be skipped because of the node
+ *    state, other errors if the node can't be resolved.
  */
-FhgfsOpsErr MessagingTk::requestResponseNode(RequestResponseNode* rrNode,
-   RequestResponseArgs* rrArgs)
+FhgfsOpsErr MessagingTk::referenceNode(RequestResponseNode* rrNode, RequestResponseArgs* rrArgs,
+   NodeHandle& outNode)
 {
    const char* logContext = "Messaging (RPC node)";
 
-   NodeHandle loadedNode;
-
    // select the right targetID
 
    NumNodeID nodeID = rrNode->nodeID; // don't modify caller's nodeID
@@ -133,8 +133,8 @@ FhgfsOpsErr MessagingTk::requestResponseNode(RequestResponseNode* rrNode,
 
    if(!rrArgs->node)
    {
-      loadedNode = rrNode->nodeStore->referenceNode(nodeID);
-      if (!loadedNode)
+      outNode = rrNode->nodeStore->referenceNode(nodeID);
+      if (!outNode)
       {
          LogContext(logContext).log(Log_WARNING, "Unknown nodeID: " + nodeID.str() + "; "
             "type: " + boost::lexical_cast<std::string>(rrNode->nodeStore->getStoreType()));
@@ -142,12 +142,35 @@ FhgfsOpsErr MessagingTk::requestResponseNode(RequestResponseNode* rrNode,
          return FhgfsOpsErr_UNKNOWNNODE;
       }
 
-      rrArgs->node = loadedNode.get();
+      rrArgs->node = outNode.get();
    }
    else
       BEEGFS_BUG_ON_DEBUG(rrArgs->node->getNumID() != nodeID,
          "Mismatch between given rrArgs->node ID and nodeID");
 
+   return FhgfsOpsErr_SUCCESS;
+}
+
+/**
+ * Sends a message to a node and receives a response.
+ * Can handle target states and mapped mirror IDs. Node does not need to be referenced by caller.
+ *
+ * If target states are provided, communication might be skipped for certain states.
+ *
+ * note: rrArgs->nodeID may optionally be provided when calling this.
+ * note: received message and buffer are available through rrArgs in case of success.
+ */
+FhgfsOpsErr MessagingTk::requestResponseNode(RequestResponseNode* rrNode,
+   RequestResponseArgs* rrArgs)
+{
+   NodeHandle loadedNode;
+
+   FhgfsOpsErr refRes = referenceNode(rrNode, rrArgs, loadedNode);
+   if(refRes != FhgfsOpsErr_SUCCESS)
+      return refRes;
+
+   const NumNodeID nodeID = rrArgs->node->getNumID();
+
    // communicate
 
    FhgfsOpsErr commRes = requestResponseComm(rrArgs);
@@ -173,24 +196,22 @@ FhgfsOpsErr MessagingTk::requestResponseNode(RequestResponseNode* rrNode,
 }
 
 /**
- * Sends a message to the owner of a target and receives a response.
- * Can handle target states and mapped mirror IDs. Owner node of target will be resolved and
- * referenced internally.
- *
- * If target states are provided, communication might be skipped for certain states.
+ * Resolves the owner node of a target for request-response communication (without
+ * communicating), i.e. everything that requestResponseTarget() does before sending the request.
  *
  * note: msg header targetID is automatically set to the resolved targetID.
  *
- * @param rrArgs rrArgs->node must be NULL when calling this.
- * @return received message and buffer are available through rrArgs in case of success.
+ * @param rrArgs rrArgs->node must be NULL when calling this; will be set to outNode on success.
+ * @param outNode the referenced owner node; caller must keep it until rrArgs->node isn't needed
+ *    anymore.
+ * @return FhgfsOpsErr_COMMUNICATION if communication should be skipped because of the target
+ *    state, other errors if the target can't be resolved.
  */
-FhgfsOpsErr MessagingTk::requestResponseTarget(RequestResponseTarget* rrTarget,
-   RequestResponseArgs* rrArgs)
+FhgfsOpsErr MessagingTk::referenceTargetNode(RequestResponseTarget* rrTarget,
+   RequestResponseArgs* rrArgs, NodeHandle& outNode)
 {
    const char* logContext = "Messaging (RPC target)";
 
-   BEEGFS_BUG_ON_DEBUG(rrArgs->node, "rrArgs->node was not NULL and will leak now");
-
    // select the right targetID
 
    uint16_t targetID = rrTarget->targetID; // don't modify caller's targetID
@@ -259,15 +280,42 @@ FhgfsOpsErr MessagingTk::requestResponseTarget(RequestResponseTarget* rrTarget,
    }
 
    // reference node
-   auto loadedNode = rrTarget->nodeStore->referenceNodeByTargetID(
-         targetID, rrTarget->targetMapper);
-   if (!loadedNode)
+   outNode = rrTarget->nodeStore->referenceNodeByTargetID(targetID, rrTarget->targetMapper);
+   if (!outNode)
    {
       LOG(COMMUNICATION, WARNING, "Unable to resolve storage server", targetID);
       return FhgfsOpsErr_UNKNOWNNODE;
    }
 
-   rrArgs->node = loadedNode.get();
+   rrArgs->node = outNode.get();
+
+   return FhgfsOpsErr_SUCCESS;
+}
+
+/**
+ * Sends a message to the owner of a target and receives a response.
+ * Can handle target states and mapped mirror IDs. Owner node of target will be resolved and
+ * referenced internally.
+ *
+ * If target states are provided, communication might be skipped for certain states.
+ *
+ * note: msg header targetID is automatically set to the resolved targetID.
+ *
+ * @param rrArgs rrArgs->node must be NULL when calling this.
+ * @return received message and buffer are available through rrArgs in case of success.
+ */
+FhgfsOpsErr MessagingTk::requestResponseTarget(RequestResponseTarget* rrTarget,
+   RequestResponseArgs* rrArgs)
+{
+   BEEGFS_BUG_ON_DEBUG(rrArgs->node, "rrArgs->node was not NULL and will leak now");
+
+   NodeHandle loadedNode;
+
+   FhgfsOpsErr refRes = referenceTargetNode(rrTarget, rrArgs, loadedNode);
+   if(refRes != FhgfsOpsErr_SUCCESS)
+      return refRes;
+
+   const uint16_t targetID = rrArgs->requestMsg->getMsgHeaderTargetID();
 
    // communicate
 
@@ -308,7 +356,6 @@ FhgfsOpsErr MessagingTk::requestResponseTarget(RequestResponseTarget* rrTarget,
 }
 
 std::vector<char> MessagingTk::recvMsgBuf(Socket& socket, int minTimeout)
-try
 {
    AbstractApp* app = PThread::getCurrentThreadApp();
    int connMsgLongTimeout = app->getCommonConfig()->getConnMsgLongTimeout();
@@ -319,11 +366,20 @@ try
       ? -1
       : std::max<int>(minTimeout, RECEIVE_TIMEOUT);
 
+   return recvMsgBufT(socket, recvTimeoutMS);
+}
+
+/**
+ * Like recvMsgBuf(), but with the given timeout (-1 for infinite) instead of the configured one.
+ */
+std::vector<char> MessagingTk::recvMsgBufT(Socket& socket, int timeoutMS)
+try
+{
    std::vector<char> result(MSGBUF_DEFAULT_SIZE);
 
    // receive at least the message header
 
-   unsigned numReceived = socket.recvExactT(&result[0], NETMSG_MIN_LENGTH, 0, recvTimeoutMS);
+   unsigned numReceived = socket.recvExactT(&result[0], NETMSG_MIN_LENGTH, 0, timeoutMS);
 
    unsigned msgLength = NetMessageHeader::extractMsgLengthFromBuf(&result[0], numReceived);
 
@@ -340,7 +396,7 @@ try
    // receive the rest of the message
 
    if (msgLength > numReceived)
-      socket.recvExactT(&result[numReceived], msgLength-numReceived, 0, recvTimeoutMS);
+      socket.recvExactT(&result[numReceived], msgLength-numReceived, 0, timeoutMS);
 
    return result;
 }
@@ -362,25 +418,66 @@ catch (const std::bad_alloc&)
  *    side is suggesting infinite retries.
  */
 FhgfsOpsErr MessagingTk::requestResponseComm(RequestResponseArgs* rrArgs)
+{
+   // simple requests share a multiplexed conn (if enabled), the others get an exclusive conn
+
+   if(isMultiplexable(rrArgs) )
+   {
+      auto multiplexedConn = rrArgs->node->getConnPool()->acquireMultiplexedConn();
+      if(multiplexedConn)
+      {
+         FhgfsOpsErr commRes;
+
+         if(requestResponseMultiplexed(rrArgs, *multiplexedConn, commRes) )
+            return commRes;
+      }
+   }
+
+   Socket* sock;
+
+   FhgfsOpsErr sendRes = sendRequest(rrArgs, true, sock);
+   if(sendRes != FhgfsOpsErr_SUCCESS)
+      return sendRes;
+
+   return recvResponse(rrArgs, sock);
+}
+
+/**
+ * First half of requestResponseComm(): Sends the request message (and extra data) to a node
+ * without waiting for the response, so that the caller can send more requests over other
+ * connections before it calls recvResponse().
+ *
+ * @param rrArgs see requestResponseComm()
+ * @param allowWaiting false to not wait for a connection if all connections of the pool are in
+ *    use (FhgfsOpsErr_AGAIN is returned in this case; e.g. if the caller already holds sockets of
+ *    this pool, as waiting could deadlock then).
+ * @param outSock the socket for recvResponse() in case of success.
+ * @return FhgfsOpsErr_COMMUNICATION on comm error, FhgfsOpsErr_AGAIN if no connection available
+ *    and !allowWaiting.
+ */
+FhgfsOpsErr MessagingTk::sendRequest(RequestResponseArgs* rrArgs, bool allowWaiting,
+   Socket*& outSock)
 {
    const char* logContext = "Messaging (RPC)";
 
    const Node& node = *rrArgs->node;
    NodeConnPool* connPool = node.getConnPool();
-   auto netMessageFactory = PThread::getCurrentThreadApp()->getNetMessageFactory();
 
    FhgfsOpsErr retVal = FhgfsOpsErr_INTERNAL;
 
    // cleanup init
    Socket* sock = NULL;
 
+   outSock = NULL;
+
    try
    {
       // connect
-      sock = connPool->acquireStreamSocket();
+      sock = connPool->acquireStreamSocketEx(allowWaiting);
+      if(!sock)
+         return FhgfsOpsErr_AGAIN; // all connections in use
 
-      const auto sendBuf = createMsgVec(*rrArgs->requestMsg);
-      sock->send(&sendBuf[0], sendBuf.size(), 0);
+      sendMsg(*sock, *rrArgs->requestMsg);
 
       if (rrArgs->sendExtraData)
       {
@@ -389,6 +486,63 @@ FhgfsOpsErr MessagingTk::requestResponseComm(RequestResponseArgs* rrArgs)
             goto err_cleanup;
       }
 
+      outSock = sock;
+
+      return FhgfsOpsErr_SUCCESS;
+   }
+   catch (const std::bad_alloc& e)
+   {
+      LOG(COMMUNICATION, ERR, "Memory allocation for send buffer failed.");
+      retVal = FhgfsOpsErr_OUTOFMEM;
+   }
+   catch(SocketConnectException& e)
+   {
+      if ( !(rrArgs->logFlags & REQUESTRESPONSEARGS_LOGFLAG_CONNESTABLISHFAILED) )
+      {
+         LOG(GENERAL, WARNING, "Unable to connect, is the node offline?", ("node", node.getNodeIDWithTypeStr()),
+               ("Message type", rrArgs->requestMsg->getMsgTypeStr()));
+      }
+
+      retVal = FhgfsOpsErr_COMMUNICATION;
+   }
+   catch(SocketException& e)
+   {
+      LogContext(logContext).logErr("Communication error: " + std::string(e.what() ) + "; " +
+         "Peer: " + node.getNodeIDWithTypeStr() + ". "
+         "(Message type: " + rrArgs->requestMsg->getMsgTypeStr() + ")");
+
+      retVal = FhgfsOpsErr_COMMUNICATION;
+   }
+
+
+err_cleanup:
+
+   // clean up...
+
+   if(sock)
+      connPool->invalidateStreamSocket(sock);
+
+   return retVal;
+}
+
+/**
+ * Second half of requestResponseComm(): Receives the response to a request that was sent via
+ * sendRequest().
+ *
+ * @param sock the socket from sendRequest(); will be released or invalidated by this method.
+ * @return see requestResponseComm()
+ */
+FhgfsOpsErr MessagingTk::recvResponse(RequestResponseArgs* rrArgs, Socket* sock)
+{
+   const char* logContext = "Messaging (RPC)";
+
+   const Node& node = *rrArgs->node;
+   NodeConnPool* connPool = node.getConnPool();
+
+   FhgfsOpsErr retVal = FhgfsOpsErr_INTERNAL;
+
+   try
+   {
       // receive response
       auto respBuf = MessagingTk::recvMsgBuf(*sock, rrArgs->minTimeoutMS);
       if (respBuf.empty())
@@ -403,53 +557,26 @@ FhgfsOpsErr MessagingTk::requestResponseComm(RequestResponseArgs* rrArgs)
       }
 
       // got response => deserialize it
-      rrArgs->outRespMsg = netMessageFactory->createFromBuf(std::move(respBuf));
-
-      if(unlikely(rrArgs->outRespMsg->getMsgType() == NETMSGTYPE_GenericResponse) )
-      { // special control msg received
-         retVal = handleGenericResponse(rrArgs);
-         if(retVal != FhgfsOpsErr_INTERNAL)
-         { // we can re-use the connection
-            connPool->releaseStreamSocket(sock);
-            sock = NULL;
-         }
-
-         goto err_cleanup;
-      }
+      bool keepConn;
 
-      if(unlikely(rrArgs->outRespMsg->getMsgType() != rrArgs->respMsgType) )
-      { // response invalid (wrong msgType)
-         LogContext(logContext).logErr(
-            "Received invalid response type: " + rrArgs->outRespMsg->getMsgTypeStr() + "; "
-            "expected: " + netMessageTypeToStr(rrArgs->respMsgType) + ". "
-            "Disconnecting: " + node.getNodeIDWithTypeStr() + " @ " +
-            sock->getPeername() );
+      retVal = processResponseBuf(rrArgs, std::move(respBuf), sock->getPeername(), keepConn);
 
-         retVal = FhgfsOpsErr_COMMUNICATION;
-         goto err_cleanup;
+      if(keepConn)
+      { // we can re-use the connection
+         connPool->releaseStreamSocket(sock);
+         sock = NULL;
       }
 
-      // got correct response
-
-      connPool->releaseStreamSocket(sock);
+      if(retVal == FhgfsOpsErr_SUCCESS)
+         return FhgfsOpsErr_SUCCESS;
 
-      return FhgfsOpsErr_SUCCESS;
+      goto err_cleanup;
    }
    catch (const std::bad_alloc& e)
    {
-      LOG(COMMUNICATION, ERR, "Memory allocation for send buffer failed.");
+      LOG(COMMUNICATION, ERR, "Memory allocation for receive buffer failed.");
       retVal = FhgfsOpsErr_OUTOFMEM;
    }
-   catch(SocketConnectException& e)
-   {
-      if ( !(rrArgs->logFlags & REQUESTRESPONSEARGS_LOGFLAG_CONNESTABLISHFAILED) )
-      {
-         LOG(GENERAL, WARNING, "Unable to connect, is the node offline?", ("node", node.getNodeIDWithTypeStr()),
-               ("Message type", rrArgs->requestMsg->getMsgTypeStr()));
-      }
-
-      retVal = FhgfsOpsErr_COMMUNICATION;
-   }
    catch(SocketException& e)
    {
       LogContext(logContext).logErr("Communication error: " + std::string(e.what() ) + "; " +
@@ -470,6 +597,157 @@ err_cleanup:
    return retVal;
 }
 
+/**
+ * Deserialize a received response and check whether it is the expected response.
+ *
+ * @param outKeepConn false if the conn should not be used anymore (e.g. because the response was
+ *    invalid).
+ * @return see requestResponseComm()
+ */
+FhgfsOpsErr MessagingTk::processResponseBuf(RequestResponseArgs* rrArgs,
+   std::vector<char> respBuf, const std::string& peername, bool& outKeepConn)
+{
+   const char* logContext = "Messaging (RPC)";
+
+   auto netMessageFactory = PThread::getCurrentThreadApp()->getNetMessageFactory();
+
+   rrArgs->outRespMsg = netMessageFactory->createFromBuf(std::move(respBuf));
+
+   if(unlikely(rrArgs->outRespMsg->getMsgType() == NETMSGTYPE_GenericResponse) )
+   { // special control msg received
+      FhgfsOpsErr retVal = handleGenericResponse(rrArgs);
+
+      outKeepConn = (retVal != FhgfsOpsErr_INTERNAL);
+      return retVal;
+   }
+
+   if(unlikely(rrArgs->outRespMsg->getMsgType() != rrArgs->respMsgType) )
+   { // response invalid (wrong msgType)
+      LogContext(logContext).logErr(
+         "Received invalid response type: " + rrArgs->outRespMsg->getMsgTypeStr() + "; "
+         "expected: " + netMessageTypeToStr(rrArgs->respMsgType) + ". "
+         "Disconnecting: " + rrArgs->node->getNodeIDWithTypeStr() + " @ " + peername);
+
+      outKeepConn = false;
+      return FhgfsOpsErr_COMMUNICATION;
+   }
+
+   // got correct response
+
+   outKeepConn = true;
+   return FhgfsOpsErr_SUCCESS;
+}
+
+/**
+ * Variant of requestResponseComm() that sends the request over a multiplexed conn (see
+ * MultiplexedConn), where other threads may have requests in flight at the same time.
+ *
+ * @param outCommRes the result, see requestResponseComm().
+ * @return false if the request can't be sent over a multiplexed conn (because it's too large),
+ *    so that the caller should use a normal conn.
+ */
+bool MessagingTk::requestResponseMultiplexed(RequestResponseArgs* rrArgs,
+   MultiplexedConn& multiplexedConn, FhgfsOpsErr& outCommRes)
+{
+   MultiplexedConn::Request request;
+
+   if(!sendRequestMultiplexed(rrArgs, multiplexedConn, request, outCommRes) )
+      return false;
+
+   if(outCommRes == FhgfsOpsErr_SUCCESS)
+      outCommRes = recvResponseMultiplexed(rrArgs, multiplexedConn, request);
+
+   return true;
+}
+
+/**
+ * First half of requestResponseMultiplexed(): Sends the request over a multiplexed conn without
+ * waiting for the response, so that the caller can send more requests before it calls
+ * recvResponseMultiplexed().
+ *
+ * @param outRequest must stay valid until recvResponseMultiplexed() returned (which the caller
+ *    must call if outCommRes is FhgfsOpsErr_SUCCESS).
+ * @param outCommRes FhgfsOpsErr_SUCCESS if the request was sent, see requestResponseComm() for
+ *    errors.
+ * @return false if the request can't be sent over a multiplexed conn (because it's too large),
+ *    so that the caller should use a normal conn.
+ */
+bool MessagingTk::sendRequestMultiplexed(RequestResponseArgs* rrArgs,
+   MultiplexedConn& multiplexedConn, MultiplexedConn::Request& outRequest,
+   FhgfsOpsErr& outCommRes)
+{
+   const char* logContext = "Messaging (RPC multiplexed)";
+
+   const Node& node = *rrArgs->node;
+
+   try
+   {
+      const auto requestBuf = createMsgVec(*rrArgs->requestMsg);
+      if(requestBuf.size() > NETMSG_MULTIPLEXED_REQUEST_MAXLEN)
+         return false;
+
+      multiplexedConn.sendRequest(outRequest, requestBuf);
+
+      outCommRes = FhgfsOpsErr_SUCCESS;
+   }
+   catch (const std::bad_alloc& e)
+   {
+      LOG(COMMUNICATION, ERR, "Memory allocation for message buffer failed.");
+      outCommRes = FhgfsOpsErr_OUTOFMEM;
+   }
+   catch(SocketException& e)
+   {
+      LogContext(logContext).logErr("Communication error: " + std::string(e.what() ) + "; " +
+         "Peer: " + node.getNodeIDWithTypeStr() + ". "
+         "(Message type: " + rrArgs->requestMsg->getMsgTypeStr() + ")");
+
+      outCommRes = FhgfsOpsErr_COMMUNICATION;
+   }
+
+   return true;
+}
+
+/**
+ * Second half of requestResponseMultiplexed(), see sendRequestMultiplexed().
+ *
+ * @return see requestResponseComm().
+ */
+FhgfsOpsErr MessagingTk::recvResponseMultiplexed(RequestResponseArgs* rrArgs,
+   MultiplexedConn& multiplexedConn, MultiplexedConn::Request& request)
+{
+   const char* logContext = "Messaging (RPC multiplexed)";
+
+   const Node& node = *rrArgs->node;
+
+   try
+   {
+      auto respBuf = multiplexedConn.waitResponse(request);
+
+      bool keepConn;
+
+      FhgfsOpsErr commRes = processResponseBuf(rrArgs, std::move(respBuf),
+         multiplexedConn.getPeername(), keepConn);
+
+      if(!keepConn)
+         multiplexedConn.invalidate();
+
+      return commRes;
+   }
+   catch (const std::bad_alloc& e)
+   {
+      LOG(COMMUNICATION, ERR, "Memory allocation for message buffer failed.");
+      return FhgfsOpsErr_OUTOFMEM;
+   }
+   catch(SocketException& e)
+   {
+      LogContext(logContext).logErr("Communication error: " + std::string(e.what() ) + "; " +
+         "Peer: " + node.getNodeIDWithTypeStr() + ". "
+         "(Message type: " + rrArgs->requestMsg->getMsgTypeStr() + ")");
+
+      return FhgfsOpsErr_COMMUNICATION;
+   }
+}
+
 std::vector<char> MessagingTk::createMsgVec(NetMessage& msg)
 {
    std::vector<char> result(MSGBUF_SMALL_SIZE);
@@ -487,6 +765,43 @@ std::vector<char> MessagingTk::createMsgVec(NetMessage& msg)
    return result;
 }
 
+/**
+ * Serialize and send a message. The trailing data of the message (if any, see
+ * NetMessage::getTrailingData() ) is sent directly from its own buffer instead of being copied
+ * into the message buffer.
+ *
+ * @param flags e.g. MSG_ZEROCOPY for messages with large trailing data (see Socket::sendv() ); the
+ *    caller must call Socket::waitForZeroCopySends() before it frees the msg in this case.
+ * @throw SocketException, std::bad_alloc
+ */
+void MessagingTk::sendMsg(Socket& sock, NetMessage& msg, int flags)
+{
+   const auto trailingData = msg.getTrailingData();
+
+   if(!trailingData.second)
+   {
+      const auto msgBuf = createMsgVec(msg);
+      sock.send(&msgBuf[0], msgBuf.size(), flags & ~MSG_ZEROCOPY);
+      return;
+   }
+
+   std::vector<char> headBuf(MSGBUF_SMALL_SIZE);
+
+   auto serializeRes = msg.serializeMessageHead(&headBuf[0], headBuf.size() );
+
+   if(!serializeRes.first)
+   {
+      headBuf.resize(serializeRes.second);
+      serializeRes = msg.serializeMessageHead(&headBuf[0], headBuf.size() );
+   }
+
+   struct iovec iov[2] = {
+      {&headBuf[0], serializeRes.second},
+      {(void*)trailingData.first, trailingData.second} };
+
+   sock.sendv(iov, 2, flags);
+}
+
 /**
  * Print log message and determine appropriate return code for requestResponseComm.
  *
@@ -28,12 +28,44 @@ class MessagingTk
          RequestResponseArgs* rrArgs);
 
       static std::vector<char> recvMsgBuf(Socket& socket, int minTimeout = 0);
+      static std::vector<char> recvMsgBufT(Socket& socket, int timeoutMS);
       static std::vector<char> createMsgVec(NetMessage& msg);
+      static void sendMsg(Socket& sock, NetMessage& msg, int flags = 0);
+
+      static FhgfsOpsErr referenceNode(RequestResponseNode* rrNode, RequestResponseArgs* rrArgs,
+         NodeHandle& outNode);
+      static FhgfsOpsErr referenceTargetNode(RequestResponseTarget* rrTarget,
+         RequestResponseArgs* rrArgs, NodeHandle& outNode);
+      static FhgfsOpsErr sendRequest(RequestResponseArgs* rrArgs, bool allowWaiting,
+         Socket*& outSock);
+      static FhgfsOpsErr recvResponse(RequestResponseArgs* rrArgs, Socket* sock);
+      static bool sendRequestMultiplexed(RequestResponseArgs* rrArgs,
+         MultiplexedConn& multiplexedConn, MultiplexedConn::Request& outRequest,
+         FhgfsOpsErr& outCommRes);
+      static FhgfsOpsErr recvResponseMultiplexed(RequestResponseArgs* rrArgs,
+         MultiplexedConn& multiplexedConn, MultiplexedConn::Request& request);
+      static FhgfsOpsErr requestResponseComm(RequestResponseArgs* rrArgs);
 
    private:
       MessagingTk() {}
 
-      static FhgfsOpsErr requestResponseComm(RequestResponseArgs* rrArgs);
       static FhgfsOpsErr handleGenericResponse(RequestResponseArgs* rrArgs);
-};
+      static FhgfsOpsErr processResponseBuf(RequestResponseArgs* rrArgs,
+         std::vector<char> respBuf, const std::string& peername, bool& outKeepConn);
+      static bool requestResponseMultiplexed(RequestResponseArgs* rrArgs,
+         MultiplexedConn& multiplexedConn, FhgfsOpsErr& outCommRes);
 
+
+   public:
+      // inliners
+
+      /**
+       * @return true if the request may share a multiplexed conn with other requests (i.e. it
+       *    doesn't need a conn of its own for extra data or a long timeout).
+       */
+      static bool isMultiplexable(const RequestResponseArgs* rrArgs)
+      {
+         return !rrArgs->sendExtraData && !rrArgs->minTimeoutMS &&
+            !rrArgs->requestMsg->getTrailingData().second;
+      }
+};
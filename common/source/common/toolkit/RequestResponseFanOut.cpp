@@ -0,0 +1,139 @@
+#include "RequestResponseFanOut.h"
+
+
+/**
+ * Send a request to a target. The completion callback may be called from within this method
+ * (e.g. if the target is offline) or from within waitAll().
+ *
+ * @param rrArgs rrArgs->node must be NULL when calling this.
+ */
+void RequestResponseFanOut::add(RequestResponseTarget* rrTarget, RequestResponseArgs* rrArgs,
+   CompletionFn onComplete)
+{
+   Request request = { rrArgs, std::move(onComplete), NodeHandle(), NULL, {}, {} };
+
+   FhgfsOpsErr refRes = MessagingTk::referenceTargetNode(rrTarget, rrArgs, request.node);
+   if(refRes != FhgfsOpsErr_SUCCESS)
+   {
+      complete(request, refRes);
+      return;
+   }
+
+   if(sendMultiplexed(request) )
+      return;
+
+   /* note: we must not wait for a free connection while we hold connections for the requests
+      in flight, as other threads could do the same and we would deadlock if the pool limit is
+      reached. so we receive the outstanding responses first in that case. */
+
+   FhgfsOpsErr sendRes = MessagingTk::sendRequest(rrArgs, inFlight.empty(), request.sock);
+   if(sendRes == FhgfsOpsErr_AGAIN)
+   { // all connections of the pool in use
+      waitAll();
+
+      sendRes = MessagingTk::sendRequest(rrArgs, true, request.sock);
+   }
+
+   if(sendRes == FhgfsOpsErr_SUCCESS)
+      inFlight.push_back(std::move(request) );
+   else
+   if(sendRes == FhgfsOpsErr_COMMUNICATION)
+      retries.push_back(std::move(request) );
+   else
+      complete(request, sendRes);
+}
+
+/**
+ * Receive the responses of all requests and call their completion callbacks.
+ */
+void RequestResponseFanOut::waitAll()
+{
+   // (waiting for a multiplexed response also receives the responses of the other requests to
+   // the same node, so these are usually done when we get to them)
+
+   for(Request& request : inFlight)
+   {
+      FhgfsOpsErr recvRes = request.multiplexedConn
+         ? MessagingTk::recvResponseMultiplexed(request.rrArgs, *request.multiplexedConn,
+              *request.multiplexedRequest)
+         : MessagingTk::recvResponse(request.rrArgs, request.sock);
+
+      request.multiplexedConn.reset();
+
+      if(recvRes == FhgfsOpsErr_COMMUNICATION)
+         retries.push_back(std::move(request) );
+      else
+         complete(request, recvRes);
+   }
+
+   inFlight.clear();
+
+   // one retry in case the connection was already broken when we got it (e.g. peer daemon
+   // restart), like in MessagingTk::requestResponseTarget(). (note: we don't hold any
+   // connections at this point, so it's safe to wait for a connection here.)
+
+   for(Request& request : retries)
+   {
+      LOG(COMMUNICATION, WARNING, "Retrying communication.",
+            ("targetID", request.rrArgs->requestMsg->getMsgHeaderTargetID() ),
+            ("message type", request.rrArgs->requestMsg->getMsgTypeStr() ) );
+
+      complete(request, MessagingTk::requestResponseComm(request.rrArgs) );
+   }
+
+   retries.clear();
+}
+
+/**
+ * Send the request over the multiplexed conn of the node (if possible).
+ *
+ * @return false if the request can't be multiplexed, so that it must be sent over a pooled conn.
+ */
+bool RequestResponseFanOut::sendMultiplexed(Request& request)
+{
+   if(!MessagingTk::isMultiplexable(request.rrArgs) )
+      return false;
+
+   request.multiplexedConn = request.node->getConnPool()->acquireMultiplexedConn();
+   if(!request.multiplexedConn)
+      return false;
+
+   request.multiplexedRequest.reset(new MultiplexedConn::Request() );
+
+   FhgfsOpsErr sendRes;
+
+   if(!MessagingTk::sendRequestMultiplexed(request.rrArgs, *request.multiplexedConn,
+         *request.multiplexedRequest, sendRes) )
+   { // too large
+      request.multiplexedConn.reset();
+      return false;
+   }
+
+   if(sendRes == FhgfsOpsErr_SUCCESS)
+   {
+      inFlight.push_back(std::move(request) );
+      return true;
+   }
+
+   request.multiplexedConn.reset();
+
+   if(sendRes == FhgfsOpsErr_COMMUNICATION)
+      retries.push_back(std::move(request) );
+   else
+      complete(request, sendRes);
+
+   return true;
+}
+
+void RequestResponseFanOut::complete(Request& request, FhgfsOpsErr requestRes)
+{
+   // see MessagingTk::requestResponseTarget() for why we don't return WOULDBLOCK to the caller
+   if(requestRes == FhgfsOpsErr_WOULDBLOCK)
+      requestRes = FhgfsOpsErr_COMMUNICATION;
+
+   request.rrArgs->node = NULL;
+   request.node.reset();
+
+   request.onComplete(requestRes);
+}
+
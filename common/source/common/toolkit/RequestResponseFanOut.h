@@ -0,0 +1,70 @@
+#pragma once
+
+#include <common/toolkit/MessagingTk.h>
+#include <common/Common.h>
+
+#include <functional>
+#include <memory>
+
+
+/**
+ * Sends requests to multiple targets from a single thread, so that the round trips overlap
+ * without handing each request to a separate (comm slave) thread that blocks until its response
+ * arrives.
+ *
+ * add() resolves the target and sends the request over the multiplexed connection of the owner
+ * node (see MultiplexedConn), so that all requests to a node share one connection and their
+ * responses are matched by tag in whatever order the node sends them. Requests that can't be
+ * multiplexed (or if the node doesn't support it) get a pooled connection each, as responses on a
+ * normal connection don't carry an ID to match them with their requests.
+ *
+ * waitAll() receives the responses and calls the completion callbacks of the requests (in the
+ * calling thread), so the overall time is about the time of the slowest round trip.
+ *
+ * Note: rrTarget and rrArgs of add() must stay valid until the completion callback was called.
+ */
+class RequestResponseFanOut
+{
+   public:
+      /**
+       * @param requestRes result of the communication like from
+       *    MessagingTk::requestResponseTarget(); the response is available through the
+       *    rrArgs of the request on success.
+       */
+      typedef std::function<void(FhgfsOpsErr requestRes)> CompletionFn;
+
+      RequestResponseFanOut() {}
+
+      ~RequestResponseFanOut()
+      {
+         waitAll();
+      }
+
+      RequestResponseFanOut(const RequestResponseFanOut&) = delete;
+      RequestResponseFanOut& operator=(const RequestResponseFanOut&) = delete;
+
+      void add(RequestResponseTarget* rrTarget, RequestResponseArgs* rrArgs,
+         CompletionFn onComplete);
+      void waitAll();
+
+
+   private:
+      struct Request
+      {
+         RequestResponseArgs* rrArgs;
+         CompletionFn onComplete;
+
+         NodeHandle node; // referenced owner node of the target
+         Socket* sock; // connection of the request in flight (if not multiplexed)
+
+         std::shared_ptr<MultiplexedConn> multiplexedConn; // NULL if sock is used
+         std::unique_ptr<MultiplexedConn::Request> multiplexedRequest; // (address must be stable)
+      };
+
+      std::vector<Request> inFlight; // sent, waiting for responses (in send order)
+      std::vector<Request> retries; // first attempt failed, will be retried synchronously
+
+      bool sendMultiplexed(Request& request);
+      void complete(Request& request, FhgfsOpsErr requestRes);
+};
+
@@ -0,0 +1,80 @@
+#include <common/toolkit/ChecksumTk.h>
+
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+static uint32_t crc32cBitwise(uint32_t crc, const unsigned char* data, size_t len)
+{
+   crc = ~crc;
+
+   while (len--)
+   {
+      crc ^= *data++;
+
+      for (unsigned k = 0; k < 8; k++)
+         crc = (crc & 1) ? ((crc >> 1) ^ 0x82f63b78) : (crc >> 1);
+   }
+
+   return ~crc;
+}
+
+TEST(ChecksumTk, crc32cKnownValues)
+{
+   const std::string check = "123456789";
+
+   EXPECT_EQ(0u, ChecksumTk::crc32c(0, "", 0));
+   EXPECT_EQ(0xe3069283u, ChecksumTk::crc32c(0, check.data(), check.size()));
+
+   // rfc 3720, B.4: 32 bytes of zeroes
+   const std::vector<unsigned char> zeroes(32, 0);
+   EXPECT_EQ(0x8a9136aau, ChecksumTk::crc32c(0, zeroes.data(), zeroes.size()));
+}
+
+TEST(ChecksumTk, crc32cMatchesReference)
+{
+   std::mt19937 rng(42);
+   std::vector<unsigned char> data(3 * 8192 * 2 + 1000);
+
+   for (auto& byte : data)
+      byte = rng();
+
+   // different lengths and alignments to cover all code paths of the interleaved streams
+   const size_t lengths[] = { 1, 7, 8, 9, 255, 768, 769, 3 * 8192, 3 * 8192 + 777,
+      data.size() - 16 };
+
+   for (size_t len : lengths)
+   {
+      for (size_t offset = 0; offset < 9; offset++)
+      {
+         if (offset + len > data.size())
+            continue;
+
+         EXPECT_EQ(crc32cBitwise(0, &data[offset], len),
+               ChecksumTk::crc32c(0, &data[offset], len))
+            << "len: " << len << "; offset: " << offset;
+      }
+   }
+}
+
+TEST(ChecksumTk, crc32cIncremental)
+{
+   std::mt19937 rng(7);
+   std::vector<unsigned char> data(65536);
+
+   for (auto& byte : data)
+      byte = rng();
+
+   const uint32_t wholeCrc = ChecksumTk::crc32c(0, data.data(), data.size());
+
+   for (size_t split : { size_t(1), size_t(4096), size_t(30000), data.size() - 1 })
+   {
+      uint32_t crc = ChecksumTk::crc32c(0, data.data(), split);
+      crc = ChecksumTk::crc32c(crc, &data[split], data.size() - split);
+
+      EXPECT_EQ(wholeCrc, crc) << "split: " << split;
+   }
+}
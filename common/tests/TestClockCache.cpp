@@ -0,0 +1,93 @@
+#include <common/toolkit/ClockCache.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+
+TEST(ClockCache, insertRemove)
+{
+   ClockCache<std::string, int> cache;
+
+   ASSERT_TRUE(cache.insert("a", 1) );
+   ASSERT_FALSE(cache.insert("a", 2) );
+   ASSERT_TRUE(cache.insert("b", 3) );
+   ASSERT_EQ(cache.size(), 2u);
+
+   int value = 0;
+   ASSERT_TRUE(cache.remove("a", &value) );
+   ASSERT_EQ(value, 1); // not overwritten by the second insert
+   ASSERT_FALSE(cache.remove("a", &value) );
+   ASSERT_FALSE(cache.contains("a") );
+   ASSERT_TRUE(cache.contains("b") );
+   ASSERT_EQ(cache.size(), 1u);
+}
+
+TEST(ClockCache, evictsInInsertionOrderWithoutTouch)
+{
+   ClockCache<int, int> cache;
+
+   for (int i = 0; i < 4; i++)
+      cache.insert(i, i * 10);
+
+   for (int i = 0; i < 4; i++)
+   {
+      int key;
+      int value;
+
+      ASSERT_TRUE(cache.evict(&key, &value) );
+      ASSERT_EQ(key, i);
+      ASSERT_EQ(value, i * 10);
+   }
+
+   int key;
+   int value;
+   ASSERT_FALSE(cache.evict(&key, &value) );
+   ASSERT_TRUE(cache.empty() );
+}
+
+TEST(ClockCache, touchedEntryGetsSecondChance)
+{
+   ClockCache<int, int> cache;
+
+   for (int i = 0; i < 3; i++)
+      cache.insert(i, i);
+
+   ASSERT_TRUE(cache.touch(0) );
+   ASSERT_FALSE(cache.touch(42) );
+
+   int key;
+   int value;
+
+   ASSERT_TRUE(cache.evict(&key, &value) );
+   ASSERT_EQ(key, 1);
+   ASSERT_TRUE(cache.evict(&key, &value) );
+   ASSERT_EQ(key, 2);
+
+   // the second chance was used up by the first eviction round
+   ASSERT_TRUE(cache.evict(&key, &value) );
+   ASSERT_EQ(key, 0);
+}
+
+TEST(ClockCache, removeAtHand)
+{
+   ClockCache<int, int> cache;
+
+   for (int i = 0; i < 3; i++)
+      cache.insert(i, i);
+
+   int key;
+   int value;
+
+   ASSERT_TRUE(cache.evict(&key, &value) );
+   ASSERT_EQ(key, 0);
+
+   // hand now points to 1, removing it must not invalidate the hand
+   ASSERT_TRUE(cache.remove(1, nullptr) );
+   cache.insert(3, 3);
+
+   ASSERT_TRUE(cache.evict(&key, &value) );
+   ASSERT_EQ(key, 2);
+   ASSERT_TRUE(cache.evict(&key, &value) );
+   ASSERT_EQ(key, 3);
+}
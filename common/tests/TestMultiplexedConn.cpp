@@ -0,0 +1,329 @@
+#include <common/net/message/control/SetChannelMultiplexedMsgEx.h>
+#include <common/net/message/control/SetChannelMultiplexedRespMsg.h>
+#include <common/net/sock/StandardSocket.h>
+#include <common/nodes/MultiplexedConn.h>
+#include <common/toolkit/MessagingTk.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include <endian.h>
+#include <poll.h>
+
+/**
+ * The client side is tested against a fake server on the other end of a socket pair, which
+ * receives the tagged requests and sends the tagged responses in any order.
+ */
+class TestMultiplexedConn : public ::testing::Test
+{
+   protected:
+      static const int recvTimeoutMS = 10000;
+
+      std::unique_ptr<StandardSocket> clientSock;
+      std::unique_ptr<StandardSocket> serverSock;
+
+      void SetUp() override
+      {
+         StandardSocket* client;
+         StandardSocket* server;
+
+         StandardSocket::createSocketPair(SOCK_STREAM, 0, &client, &server);
+
+         clientSock.reset(client);
+         serverSock.reset(server);
+      }
+
+      static std::vector<char> makeRequest(int value)
+      {
+         SetChannelMultiplexedMsg msg(value);
+
+         return MessagingTk::createMsgVec(msg);
+      }
+
+      static std::vector<char> makeResponse(int value)
+      {
+         SetChannelMultiplexedRespMsg msg(value);
+
+         return MessagingTk::createMsgVec(msg);
+      }
+
+      /**
+       * @return tag of the received request.
+       */
+      uint64_t recvRequest(std::vector<char>* outRequestBuf = NULL)
+      {
+         uint64_t tag;
+
+         serverSock->recvExactT(&tag, sizeof(tag), 0, recvTimeoutMS);
+
+         std::vector<char> requestBuf = MessagingTk::recvMsgBufT(*serverSock, recvTimeoutMS);
+
+         if(outRequestBuf)
+            *outRequestBuf = std::move(requestBuf);
+
+         return le64toh(tag);
+      }
+
+      void sendResponse(uint64_t tag, std::vector<char> responseBuf)
+      {
+         uint64_t tagLE = htole64(tag);
+
+         struct iovec iov[2] = {
+            {&tagLE, sizeof(tagLE)},
+            {&responseBuf[0], responseBuf.size()} };
+
+         serverSock->sendv(iov, 2, 0);
+      }
+
+      bool serverHasData(int timeoutMS)
+      {
+         struct pollfd pollFD = {serverSock->getFD(), POLLIN, 0};
+
+         return poll(&pollFD, 1, timeoutMS) > 0;
+      }
+};
+
+TEST_F(TestMultiplexedConn, requestResponse)
+{
+   MultiplexedConn conn(clientSock.get(), 4, recvTimeoutMS);
+
+   std::thread server([&] () {
+      std::vector<char> requestBuf;
+      uint64_t tag = recvRequest(&requestBuf);
+
+      EXPECT_EQ(requestBuf, makeRequest(7) );
+
+      sendResponse(tag, makeResponse(7) );
+   });
+
+   ASSERT_EQ(conn.requestResponse(makeRequest(7) ), makeResponse(7) );
+
+   server.join();
+
+   ASSERT_FALSE(conn.getIsBroken() );
+}
+
+TEST_F(TestMultiplexedConn, outOfOrderResponses)
+{
+   const int numRequesters = 8;
+
+   MultiplexedConn conn(clientSock.get(), numRequesters, recvTimeoutMS);
+   std::vector<std::vector<char>> responses(numRequesters);
+   std::vector<std::thread> requesters;
+
+   for(int i = 0; i < numRequesters; i++)
+   {
+      requesters.emplace_back([&, i] () {
+         responses[i] = conn.requestResponse(makeRequest(i) );
+      });
+   }
+
+   // collect all requests (the requesters need all credits), then answer in reverse order
+
+   std::vector<std::pair<uint64_t, int>> requests; // tag and value
+
+   for(int i = 0; i < numRequesters; i++)
+   {
+      std::vector<char> requestBuf;
+      uint64_t tag = recvRequest(&requestBuf);
+
+      for(int value = 0; value < numRequesters; value++)
+      {
+         if(requestBuf == makeRequest(value) )
+            requests.push_back({tag, value});
+      }
+   }
+
+   EXPECT_EQ(requests.size(), size_t(numRequesters) );
+
+   for(auto iter = requests.rbegin(); iter != requests.rend(); iter++)
+      sendResponse(iter->first, makeResponse(iter->second) );
+
+   for(auto& thread : requesters)
+      thread.join();
+
+   for(int i = 0; i < numRequesters; i++)
+      ASSERT_EQ(responses[i], makeResponse(i) ) << "requester " << i;
+}
+
+TEST_F(TestMultiplexedConn, sendRequestWaitResponse)
+{
+   MultiplexedConn conn(clientSock.get(), 4, recvTimeoutMS);
+   MultiplexedConn::Request first;
+   MultiplexedConn::Request second;
+
+   conn.sendRequest(first, makeRequest(1) );
+   conn.sendRequest(second, makeRequest(2) );
+
+   uint64_t firstTag = recvRequest();
+   uint64_t secondTag = recvRequest();
+
+   ASSERT_NE(firstTag, secondTag);
+
+   sendResponse(secondTag, makeResponse(2) );
+   sendResponse(firstTag, makeResponse(1) );
+
+   // receives the response to the second request on the way
+   ASSERT_EQ(conn.waitResponse(first), makeResponse(1) );
+   ASSERT_TRUE(second.isDone);
+   ASSERT_EQ(conn.waitResponse(second), makeResponse(2) );
+}
+
+TEST_F(TestMultiplexedConn, requestsWaitForCredits)
+{
+   MultiplexedConn conn(clientSock.get(), 2, recvTimeoutMS);
+   MultiplexedConn::Request first;
+   MultiplexedConn::Request second;
+   std::vector<char> thirdResponse;
+
+   conn.sendRequest(first, makeRequest(1) );
+   conn.sendRequest(second, makeRequest(2) );
+
+   std::thread requester([&] () {
+      thirdResponse = conn.requestResponse(makeRequest(3) );
+   });
+
+   uint64_t firstTag = recvRequest();
+   uint64_t secondTag = recvRequest();
+
+   // no credit left => the third request must not be sent before a response was received
+   EXPECT_FALSE(serverHasData(200) );
+
+   sendResponse(secondTag, makeResponse(2) );
+
+   std::vector<char> requestBuf;
+   uint64_t thirdTag = recvRequest(&requestBuf);
+
+   EXPECT_EQ(requestBuf, makeRequest(3) );
+
+   sendResponse(thirdTag, makeResponse(3) );
+   requester.join();
+
+   ASSERT_EQ(thirdResponse, makeResponse(3) );
+
+   sendResponse(firstTag, makeResponse(1) );
+
+   ASSERT_EQ(conn.waitResponse(second), makeResponse(2) ); // (received by the other requester)
+   ASSERT_EQ(conn.waitResponse(first), makeResponse(1) );
+}
+
+TEST_F(TestMultiplexedConn, fanOutBeyondCredits)
+{
+   // (like RequestResponseFanOut: one thread sends more requests than the conn has credits)
+   const int numRequests = 6;
+
+   MultiplexedConn conn(clientSock.get(), 2, recvTimeoutMS);
+   MultiplexedConn::Request requests[numRequests];
+
+   std::thread server([&] () {
+      for(int i = 0; i < numRequests; i++)
+      {
+         std::vector<char> requestBuf;
+         uint64_t tag = recvRequest(&requestBuf);
+
+         for(int value = 0; value < numRequests; value++)
+         {
+            if(requestBuf == makeRequest(value) )
+               sendResponse(tag, makeResponse(value) );
+         }
+      }
+   });
+
+   // waiting for a credit must receive the responses to our own requests, nobody else does
+   for(int i = 0; i < numRequests; i++)
+      conn.sendRequest(requests[i], makeRequest(i) );
+
+   for(int i = 0; i < numRequests; i++)
+      ASSERT_EQ(conn.waitResponse(requests[i]), makeResponse(i) ) << "request " << i;
+
+   server.join();
+
+   ASSERT_FALSE(conn.getIsBroken() );
+}
+
+TEST_F(TestMultiplexedConn, unknownTagBreaksConn)
+{
+   MultiplexedConn conn(clientSock.get(), 4, recvTimeoutMS);
+   MultiplexedConn::Request request;
+
+   conn.sendRequest(request, makeRequest(1) );
+
+   uint64_t tag = recvRequest();
+
+   sendResponse(tag + 1, makeResponse(1) );
+
+   ASSERT_THROW(conn.waitResponse(request), SocketException);
+   ASSERT_TRUE(conn.getIsBroken() );
+
+   MultiplexedConn::Request laterRequest;
+
+   ASSERT_THROW(conn.sendRequest(laterRequest, makeRequest(2) ), SocketDisconnectException);
+}
+
+TEST_F(TestMultiplexedConn, brokenConnWakesAllRequesters)
+{
+   const int numRequesters = 4;
+
+   MultiplexedConn conn(clientSock.get(), numRequesters, recvTimeoutMS);
+   std::atomic<int> numFailed(0);
+   std::vector<std::thread> requesters;
+
+   // one requester receives, the others wait for it
+   for(int i = 0; i < numRequesters; i++)
+   {
+      requesters.emplace_back([&, i] () {
+         try
+         {
+            conn.requestResponse(makeRequest(i) );
+         }
+         catch(SocketException& e)
+         {
+            numFailed++;
+         }
+      });
+   }
+
+   for(int i = 0; i < numRequesters; i++)
+      recvRequest();
+
+   serverSock.reset(); // (disconnect)
+
+   for(auto& thread : requesters)
+      thread.join();
+
+   ASSERT_EQ(numFailed, numRequesters);
+   ASSERT_TRUE(conn.getIsBroken() );
+}
+
+TEST_F(TestMultiplexedConn, invalidateFailsRequestsInFlight)
+{
+   MultiplexedConn conn(clientSock.get(), 4, recvTimeoutMS);
+   MultiplexedConn::Request request;
+
+   conn.sendRequest(request, makeRequest(1) );
+
+   conn.invalidate();
+
+   ASSERT_THROW(conn.waitResponse(request), SocketDisconnectException);
+   ASSERT_THROW(conn.sendRequest(request, makeRequest(2) ), SocketDisconnectException);
+}
+
+TEST_F(TestMultiplexedConn, grantCredits)
+{
+   // disabled, invalid request or locally generated msg => conn stays in normal mode
+   ASSERT_EQ(SetChannelMultiplexedMsgEx::grantCredits(serverSock.get(), 8, 0, false), 0u);
+   ASSERT_EQ(SetChannelMultiplexedMsgEx::grantCredits(serverSock.get(), 0, 16, false), 0u);
+   ASSERT_EQ(SetChannelMultiplexedMsgEx::grantCredits(serverSock.get(), -1, 16, false), 0u);
+   ASSERT_EQ(SetChannelMultiplexedMsgEx::grantCredits(serverSock.get(), 8, 16, true), 0u);
+   ASSERT_FALSE(serverSock->getIsMultiplexed() );
+
+   // limited by the config
+   ASSERT_EQ(SetChannelMultiplexedMsgEx::grantCredits(serverSock.get(), 32, 16, false), 16u);
+   ASSERT_EQ(serverSock->getMultiplexCredits(), 16u);
+
+   ASSERT_EQ(SetChannelMultiplexedMsgEx::grantCredits(clientSock.get(), 4, 16, false), 4u);
+   ASSERT_EQ(clientSock->getMultiplexCredits(), 4u);
+}
@@ -0,0 +1,83 @@
+#include <common/net/message/control/SetChannelMultiplexedMsg.h>
+#include <common/net/message/control/SetChannelMultiplexedRespMsg.h>
+#include <common/nodes/NodeStoreServers.h>
+#include <common/nodes/TargetMapper.h>
+#include <common/nodes/TargetStateStore.h>
+#include <common/toolkit/RequestResponseFanOut.h>
+
+#include <gtest/gtest.h>
+
+/**
+ * Requests that can be completed without communication, which the fan-out must complete within
+ * add() with the same results as MessagingTk::requestResponseTarget().
+ */
+class TestRequestResponseFanOut : public ::testing::Test
+{
+   protected:
+      TargetMapper targetMapper;
+      NodeStoreServers nodeStore{NODETYPE_Storage, false};
+      TargetStateStore targetStates{NODETYPE_Storage};
+
+      SetChannelMultiplexedMsg requestMsg{1};
+
+      struct Result
+      {
+         bool isComplete = false;
+         FhgfsOpsErr requestRes = FhgfsOpsErr_SUCCESS;
+      };
+
+      void add(RequestResponseFanOut& fanOut, uint16_t targetID, RequestResponseArgs& rrArgs,
+         Result& result)
+      {
+         RequestResponseTarget rrTarget(targetID, &targetMapper, &nodeStore);
+
+         rrTarget.setTargetStates(&targetStates);
+
+         fanOut.add(&rrTarget, &rrArgs, [&result] (FhgfsOpsErr requestRes) {
+            result.isComplete = true;
+            result.requestRes = requestRes;
+         });
+      }
+};
+
+TEST_F(TestRequestResponseFanOut, offlineTarget)
+{
+   targetStates.addIfNotExists(1,
+      CombinedTargetState(TargetReachabilityState_OFFLINE, TargetConsistencyState_GOOD) );
+
+   RequestResponseFanOut fanOut;
+   RequestResponseArgs rrArgs(NULL, &requestMsg, NETMSGTYPE_SetChannelMultiplexedResp);
+   Result result;
+
+   add(fanOut, 1, rrArgs, result);
+
+   // no need to wait for an offline server
+   ASSERT_TRUE(result.isComplete);
+   ASSERT_EQ(result.requestRes, FhgfsOpsErr_COMMUNICATION);
+   ASSERT_EQ(rrArgs.node, nullptr);
+   ASSERT_EQ(requestMsg.getMsgHeaderTargetID(), 1u);
+}
+
+TEST_F(TestRequestResponseFanOut, unknownTargetAndNode)
+{
+   targetStates.addIfNotExists(2,
+      CombinedTargetState(TargetReachabilityState_ONLINE, TargetConsistencyState_GOOD) );
+
+   RequestResponseFanOut fanOut;
+   RequestResponseArgs unknownTargetArgs(NULL, &requestMsg,
+      NETMSGTYPE_SetChannelMultiplexedResp);
+   RequestResponseArgs unknownNodeArgs(NULL, &requestMsg, NETMSGTYPE_SetChannelMultiplexedResp);
+   Result unknownTargetResult;
+   Result unknownNodeResult;
+
+   add(fanOut, 1, unknownTargetArgs, unknownTargetResult);
+   add(fanOut, 2, unknownNodeArgs, unknownNodeResult); // (target has no owner node)
+
+   ASSERT_TRUE(unknownTargetResult.isComplete);
+   ASSERT_EQ(unknownTargetResult.requestRes, FhgfsOpsErr_UNKNOWNTARGET);
+
+   ASSERT_TRUE(unknownNodeResult.isComplete);
+   ASSERT_EQ(unknownNodeResult.requestRes, FhgfsOpsErr_UNKNOWNNODE);
+
+   fanOut.waitAll(); // (nothing in flight)
+}
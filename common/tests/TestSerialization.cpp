@@ -4,6 +4,7 @@
 #include <common/fsck/FsckDirInode.h>
 #include <common/fsck/FsckFileInode.h>
 #include <common/nodes/Node.h>
+#include <common/net/message/storage/attribs/GetChunkFileAttribsBatchMsg.h>
 #include <common/net/message/storage/attribs/SetXAttrMsg.h>
 #include <common/net/message/storage/creating/MkLocalDirMsg.h>
 #include <common/net/sock/NetworkInterfaceCard.h>
@@ -1138,3 +1139,40 @@ TEST(Serialization, stringCollections)
       testStringCollection<std::set>(expected);
    }
 }
+
+TEST(Serialization, getChunkFileAttribsBatchMaxEntries)
+{
+   for(size_t numEntries : {size_t(GETCHUNKFILEATTRSBATCHMSG_MAX_ENTRIES),
+         size_t(GETCHUNKFILEATTRSBATCHMSG_MAX_ENTRIES + 1)})
+   {
+      GetChunkFileAttribsBatchMsg::EntryVec entries(numEntries);
+
+      for(size_t i = 0; i < numEntries; i++)
+      {
+         entries[i].entryID = "0-5C1D2E3F-" + std::to_string(i);
+         entries[i].pathInfo = PathInfo(i, "root", PATHINFO_FEATURE_ORIG);
+      }
+
+      const GetChunkFileAttribsBatchMsg msg(1, &entries);
+
+      Serializer sizer;
+      GetChunkFileAttribsBatchMsg::serialize(&msg, sizer);
+
+      std::vector<char> buf(sizer.size() );
+      Serializer ser(buf.data(), buf.size() );
+      GetChunkFileAttribsBatchMsg::serialize(&msg, ser);
+      ASSERT_TRUE(ser.good() );
+
+      // the receiver must refuse batches that are larger than the limit
+      GetChunkFileAttribsBatchMsg received;
+      Deserializer des(buf.data(), buf.size() );
+      GetChunkFileAttribsBatchMsg::serialize(&received, des);
+
+      ASSERT_EQ(des.good(), numEntries <= GETCHUNKFILEATTRSBATCHMSG_MAX_ENTRIES);
+
+      if(des.good() )
+      {
+         ASSERT_EQ(received.getEntries().size(), numEntries);
+      }
+   }
+}
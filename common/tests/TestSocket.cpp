@@ -1,9 +1,119 @@
 #include <common/net/sock/Socket.cpp>
+#include <common/net/sock/StandardSocket.h>
+#include <common/toolkit/FDHandle.h>
 
 #include <gtest/gtest.h>
+#include <memory>
+#include <thread>
+#include <unistd.h>
 
 
 class TestSocket : public ::testing::Test
 {
 };
 
+
+TEST_F(TestSocket, sendfile)
+{
+   StandardSocket* sender;
+   StandardSocket* receiver;
+
+   StandardSocket::createSocketPair(SOCK_STREAM, 0, &sender, &receiver);
+
+   std::unique_ptr<StandardSocket> senderPtr(sender);
+   std::unique_ptr<StandardSocket> receiverPtr(receiver);
+
+   char fileName[] = "/tmp/beegfs-sendfile-test-XXXXXX";
+   FDHandle file(mkstemp(fileName) );
+   ASSERT_TRUE(file.valid() );
+   unlink(fileName);
+
+   const std::string data = "0123456789abcdef";
+   ASSERT_EQ(write(*file, data.c_str(), data.size() ), ssize_t(data.size() ) );
+
+   // sends from the given offset and doesn't change the file position
+   ASSERT_EQ(sender->sendfile(*file, 4, 8), 8);
+
+   char buf[8];
+   ASSERT_EQ(receiver->recv(buf, sizeof(buf), MSG_WAITALL), 8);
+   ASSERT_EQ(std::string(buf, sizeof(buf) ), data.substr(4, 8) );
+   ASSERT_EQ(lseek(*file, 0, SEEK_CUR), off_t(data.size() ) );
+
+   // fails if the file ends before len bytes were sent
+   ASSERT_THROW(sender->sendfile(*file, 12, 8), SocketException);
+}
+
+TEST_F(TestSocket, sendv)
+{
+   StandardSocket* sender;
+   StandardSocket* receiver;
+
+   StandardSocket::createSocketPair(SOCK_STREAM, 0, &sender, &receiver);
+
+   std::unique_ptr<StandardSocket> senderPtr(sender);
+   std::unique_ptr<StandardSocket> receiverPtr(receiver);
+
+   std::string head = "head";
+   std::string empty;
+   std::string data = "0123456789abcdef";
+
+   struct iovec iov[3] = {
+      {&head[0], head.size()},
+      {&empty[0], empty.size()},
+      {&data[0], data.size()} };
+
+   // buffers are received as one contiguous stream; MSG_ZEROCOPY is ignored for small sends
+   ASSERT_EQ(sender->sendv(iov, 3, MSG_ZEROCOPY), ssize_t(head.size() + data.size() ) );
+
+   char buf[20];
+   ASSERT_EQ(receiver->recv(buf, sizeof(buf), MSG_WAITALL), ssize_t(sizeof(buf) ) );
+   ASSERT_EQ(std::string(buf, sizeof(buf) ), head + data);
+}
+
+TEST_F(TestSocket, zeroCopySendsAreReapedLater)
+{
+   // (zero-copy needs a TCP connection, unix sockets don't support it)
+   Socket::checkAndCacheIPv6Availability(0, false);
+
+   StandardSocket listener(SOCK_STREAM);
+   listener.bind(0);
+   listener.listen();
+
+   struct sockaddr_storage listenAddr;
+   socklen_t listenAddrLen = sizeof(listenAddr);
+   ASSERT_EQ(getsockname(listener.getFD(), (struct sockaddr*)&listenAddr, &listenAddrLen), 0);
+
+   const uint16_t port = ntohs( (listenAddr.ss_family == AF_INET6) ?
+      ( (struct sockaddr_in6*)&listenAddr)->sin6_port :
+      ( (struct sockaddr_in*)&listenAddr)->sin_port);
+
+   StandardSocket sender(SOCK_STREAM);
+   sender.connect(IPAddress::resolve("127.0.0.1").toSocketAddress(port) );
+
+   struct sockaddr_storage peerAddr;
+   socklen_t peerAddrLen = sizeof(peerAddr);
+   std::unique_ptr<Socket> receiver(listener.accept(&peerAddr, &peerAddrLen) );
+
+   const size_t dataSize = 256 * 1024;
+   std::string data(dataSize, 'a');
+   std::string otherData(dataSize, 'b');
+   std::string received(2 * dataSize, 0);
+
+   std::thread receiverThread([&] () {
+      receiver->recv(&received[0], received.size(), MSG_WAITALL);
+   });
+
+   // several sends can be in flight, their buffers stay untouched until the wait below
+   struct iovec iov = {&data[0], data.size()};
+   ASSERT_EQ(sender.sendv(&iov, 1, MSG_ZEROCOPY), ssize_t(dataSize) );
+
+   iov = {&otherData[0], otherData.size()};
+   ASSERT_EQ(sender.sendv(&iov, 1, MSG_ZEROCOPY), ssize_t(dataSize) );
+
+   receiverThread.join();
+
+   sender.waitForZeroCopySends();
+   sender.waitForZeroCopySends(); // (nothing pending => returns immediately)
+
+   ASSERT_EQ(received, data + otherData);
+}
@@ -0,0 +1,157 @@
+#include <common/components/worker/queue/WorkStealingQueue.h>
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+
+namespace {
+
+class CountingWork : public Work
+{
+   public:
+      CountingWork(bool isDirect) : isDirect(isDirect) {}
+
+      void process(char* bufIn, unsigned bufInLen, char* bufOut, unsigned bufOutLen) override {}
+
+      bool isDirect;
+};
+
+}
+
+TEST(WorkStealingQueue, directWorkersOnlyGetDirectWork)
+{
+   WorkStealingQueue queue(2);
+   PersonalWorkQueue personalQ;
+   HighResolutionStats stats;
+
+   queue.incNumWorkers();
+
+   queue.addIndirectWork(new CountingWork(false) );
+   queue.addDirectWork(new CountingWork(true) );
+
+   ASSERT_EQ(queue.getNumPendingWorks(), 2u);
+
+   Work* work = queue.waitForDirectWork(stats, &personalQ);
+   ASSERT_TRUE(static_cast<CountingWork*>(work)->isDirect);
+   delete work;
+
+   ASSERT_EQ(queue.getDirectWorkListSize(), 0u);
+   ASSERT_EQ(queue.getIndirectWorkListSize(), 1u);
+
+   work = queue.waitForAnyWork(stats, &personalQ);
+   ASSERT_FALSE(static_cast<CountingWork*>(work)->isDirect);
+   delete work;
+
+   ASSERT_EQ(queue.getNumPendingWorks(), 0u);
+}
+
+TEST(WorkStealingQueue, personalWorkIsPreferred)
+{
+   WorkStealingQueue queue(1);
+   PersonalWorkQueue personalQ;
+   HighResolutionStats stats;
+
+   queue.incNumWorkers();
+
+   queue.addIndirectWork(new CountingWork(false) );
+
+   Work* personalWork = new CountingWork(false);
+   queue.addPersonalWork(personalWork, &personalQ);
+   ASSERT_FALSE(queue.getIsPersonalQueueEmpty(&personalQ) );
+
+   Work* work = queue.waitForAnyWork(stats, &personalQ);
+   ASSERT_EQ(work, personalWork);
+   delete work;
+
+   ASSERT_TRUE(queue.getIsPersonalQueueEmpty(&personalQ) );
+   ASSERT_EQ(queue.getNumPendingWorks(), 1u);
+   // (remaining work is deleted by the queue destructor)
+}
+
+TEST(WorkStealingQueue, overflowWhenRingsAreFull)
+{
+   WorkStealingQueue queue(1);
+   PersonalWorkQueue personalQ;
+   HighResolutionStats stats;
+
+   const unsigned numWorks = WORKSTEALINGQUEUE_RING_SIZE + 10;
+
+   for(unsigned i = 0; i < numWorks; i++)
+      queue.addIndirectWork(new CountingWork(false) );
+
+   ASSERT_EQ(queue.getNumPendingWorks(), numWorks);
+
+   for(unsigned i = 0; i < numWorks; i++)
+      delete queue.waitForAnyWork(stats, &personalQ);
+
+   ASSERT_EQ(queue.getNumPendingWorks(), 0u);
+}
+
+TEST(WorkStealingQueue, concurrentProducersAndWorkers)
+{
+   const unsigned numProducers = 4;
+   const unsigned numWorkers = 4;
+   const unsigned numWorksPerProducer = 20000;
+
+   WorkStealingQueue queue(numWorkers);
+   std::atomic<unsigned> numProcessed(0);
+   std::vector<std::thread> threads;
+   PersonalWorkQueue personalQueues[numWorkers];
+
+   for(unsigned i = 0; i < numWorkers; i++)
+   {
+      queue.incNumWorkers();
+
+      threads.emplace_back([&, i] () {
+         HighResolutionStats stats;
+
+         HighResolutionStatsTk::resetStats(&stats);
+
+         for( ; ; )
+         {
+            Work* work = queue.waitForAnyWork(stats, &personalQueues[i]);
+            const bool isStopWork = !static_cast<CountingWork*>(work)->isDirect;
+
+            delete work;
+
+            if(isStopWork)
+               return;
+
+            numProcessed++;
+
+            stats.incVals.workRequests = 1;
+         }
+      });
+   }
+
+   for(unsigned i = 0; i < numProducers; i++)
+   {
+      threads.emplace_back([&] () {
+         for(unsigned j = 0; j < numWorksPerProducer; j++)
+            queue.addDirectWork(new CountingWork(true) );
+      });
+   }
+
+   for(unsigned i = numWorkers; i < numWorkers + numProducers; i++)
+      threads[i].join();
+
+   // workers stop on indirect work, which they only get once the direct works are gone
+   while(queue.getDirectWorkListSize() )
+      std::this_thread::yield();
+
+   for(unsigned i = 0; i < numWorkers; i++)
+      queue.addPersonalWork(new CountingWork(false), &personalQueues[i]);
+
+   for(unsigned i = 0; i < numWorkers; i++)
+      threads[i].join();
+
+   ASSERT_EQ(numProcessed.load(), numProducers * numWorksPerProducer);
+   ASSERT_EQ(queue.getNumPendingWorks(), 0u);
+
+   HighResolutionStats stats;
+   queue.getAndResetStats(&stats);
+
+   ASSERT_EQ(stats.rawVals.busyWorkers, numWorkers); // (workers never waited again)
+   ASSERT_EQ(stats.incVals.workRequests, numProducers * numWorksPerProducer);
+}
@@ -15,6 +15,8 @@
 #include <unistd.h>
 
 #include <optional>
+#include <string>
+#include <vector>
 
 
 #include <beegfs/seqpacket-reader-new-protocol.hpp>
@@ -125,6 +127,13 @@ enum class Packet_Type : uint8_t
    // This is the last message sent by the server.
    // Includes a ConnTerminateReason
    Send_Close,
+   // Server sends a number of (event) messages to client. Sent instead of
+   // Send_Message if we requested protocol version 2.1.
+   // Layout: u16 message count, then for each message its u64 msn, u16 size
+   // and data (see "Protocol 2.1" in documentation_start.md).
+   Send_Message_Batch,
+   // Client requests that only events matching the included filter get sent.
+   Request_Event_Filter,
 };
 
 enum class ConnTerminateReason
@@ -158,6 +167,8 @@ static const char *packet_type_string(Packet_Type packetType)
       PTSTRING(Send_Message);
       PTSTRING(Request_Close);
       PTSTRING(Send_Close);
+      PTSTRING(Send_Message_Batch);
+      PTSTRING(Request_Event_Filter);
       default: return "(invalid packet type)";
    }
 }
@@ -179,12 +190,18 @@ struct FileEventReceiverOptions
 
    std::optional<uint64_t> startmsn;
    std::optional<uint64_t> nmsgs;
+
+   // Event filter, evaluated by the server. Sent if a type mask is given.
+   std::optional<uint64_t> event_types;
+   std::vector<std::string> path_prefixes;
+   std::vector<std::string> entry_id_prefixes;
 };
 
 
 struct Packet_Buffer
 {
-   char data[1024];
+   // large enough for the Send_Message_Batch packets of the server (16 KiB)
+   char data[64 * 1024];
    size_t size = 0;
    // also doubling as a packet writer for now
    bool bad = false;
@@ -201,6 +218,7 @@ struct Conn_State
    uint32_t meta_id = 0;
    uint16_t meta_mirror_id = 0;
    bool handshake_received = false;
+   bool filter_sent = false;
    unsigned conn_id = 0;
    int client_sock = -1;
    uint64_t curmsn = 0;
@@ -209,6 +227,14 @@ struct Conn_State
 
    Packet_Buffer receive_packet;
 
+   // Current event message, points into receive_packet
+   char *event_data = nullptr;
+   size_t event_size = 0;
+
+   // Remaining messages of a Send_Message_Batch packet in receive_packet
+   uint16_t batch_remaining = 0;
+   size_t batch_pos = 0;
+
    bool requested_msn = false;
    bool requested_stream = false;
 
@@ -285,12 +311,98 @@ static bool send_packet(Conn_State *conn, Packet_Buffer const *packet)
    return true;
 }
 
+// Takes the next message from the Send_Message_Batch packet in receive_packet
+// as the current event.
+static bool next_batch_message(Conn_State *conn)
+{
+   Packet_Buffer *packet = &conn->receive_packet;
+   uint64_t msn;
+   uint16_t msg_size;
+
+   if (packet->size - conn->batch_pos < sizeof msn + sizeof msg_size)
+   {
+      msg_f("Bad batch packet: truncated message header");
+      return false;
+   }
+
+   memcpy(&msn, packet->data + conn->batch_pos, sizeof msn);
+   conn->batch_pos += sizeof msn;
+   memcpy(&msg_size, packet->data + conn->batch_pos, sizeof msg_size);
+   conn->batch_pos += sizeof msg_size;
+
+   if (packet->size - conn->batch_pos < msg_size)
+   {
+      msg_f("Bad batch packet: truncated message");
+      return false;
+   }
+
+   conn->event_data = packet->data + conn->batch_pos;
+   conn->event_size = msg_size;
+   conn->batch_pos += msg_size;
+   conn->batch_remaining--;
+   conn->curmsn = msn;  // (not consecutive if we sent an event filter)
+   return true;
+}
+
+static bool report_event(Conn_State *conn)
+{
+   switch (conn->options.report_type)
+   {
+      case Report_Type_Print_Message:
+      {
+         char *buf = conn->event_data;
+         for (int i = 0; i < (int) conn->event_size; i++)
+         {
+            if ((unsigned) buf[i] < 32
+                  || (unsigned) buf[i] >= 127)
+               buf[i] = '.';
+         }
+         msg_f("Got msg %" PRIu64 " (size %zu): %.*s",
+               conn->curmsn, conn->event_size, (int) conn->event_size, buf);
+      }
+      break;
+      case Report_Type_Interactive_Count:
+      {
+         report_count(conn);
+      }
+      break;
+      default:
+      {
+         if (conn->curmsn % 1024 == 0)
+         {
+            msg_f("msg: %" PRIu64 ", size: %d", conn->curmsn, (int) conn->event_size);
+         }
+      }
+      break;
+   }
+
+   conn->nmsgs++;
+   conn->curmsn++;
+
+   if (conn->options.nmsgs.has_value())
+   {
+      if (conn->nmsgs == conn->options.nmsgs.value())
+         return false;
+   }
+
+   return true;
+}
+
 static bool do_message(Conn_State *conn)
 {
+   if (conn->batch_remaining)
+   {
+      if (! next_batch_message(conn))
+         return false;
+      return report_event(conn);
+   }
+
    if (! conn->handshake_sent)
    {
+      // 2.1 is 2.0 plus Send_Message_Batch. The server's handshake response
+      // says 2.0 in any case.
       uint16_t protocol_version_major = 2;
-      uint16_t protocol_version_minor = 0;
+      uint16_t protocol_version_minor = 1;
       Packet_Buffer packet;
       write_header(&packet, Packet_Type::Handshake_Request);
       write_u16(&packet, protocol_version_major);
@@ -300,6 +412,29 @@ static bool do_message(Conn_State *conn)
       conn->handshake_sent = true;
    }
 
+   if (! conn->filter_sent && conn->options.event_types.has_value())
+   {
+      // u64 event type mask, u16 number of path prefixes, u16 number of
+      // entryID prefixes, then all prefixes, each as u16 length and string.
+      FileEventReceiverOptions const& options = conn->options;
+      Packet_Buffer packet;
+      write_header(&packet, Packet_Type::Request_Event_Filter);
+      write_u64(&packet, options.event_types.value());
+      write_u16(&packet, options.path_prefixes.size());
+      write_u16(&packet, options.entry_id_prefixes.size());
+      for (auto const *prefixes : {&options.path_prefixes, &options.entry_id_prefixes})
+      {
+         for (std::string const& prefix : *prefixes)
+         {
+            write_u16(&packet, prefix.size());
+            write_data(&packet, prefix.data(), prefix.size());
+         }
+      }
+      if (! send_packet(conn, &packet))
+         return false;
+      conn->filter_sent = true;
+   }
+
    if (conn->handshake_received)
    {
       if (! conn->startmsn.has_value())
@@ -445,6 +580,36 @@ static bool do_message(Conn_State *conn)
    case Packet_Type::Send_Message:
    {
       //msg_f("Received message!");
+      // 8 byte packet header (type Send_Message)
+      // Send_Message packet:
+      //   8 byte msn
+      //   2 byte message size (should be removed)
+      ssize_t skip_bytes = 8 + 8 + 2;
+      if (nr < skip_bytes)
+      {
+         msg_f("Bad packet!");
+         return false;
+      }
+      conn->event_data = buf + skip_bytes;
+      conn->event_size = nr - skip_bytes;
+      break;
+   }
+   case Packet_Type::Send_Message_Batch:
+   {
+      // 8 byte packet header (type Send_Message_Batch)
+      // Send_Message_Batch packet:
+      //   2 byte message count
+      //   for each message: 8 byte msn, 2 byte message size, message
+      uint16_t count;
+      if (nr < 10 || (count = *(uint16_t *) (buf + 8)) == 0)
+      {
+         msg_f("Bad packet!");
+         return false;
+      }
+      conn->batch_remaining = count;
+      conn->batch_pos = 10;
+      if (! next_batch_message(conn))
+         return false;
       break;
    }
    case Packet_Type::Send_Close:
@@ -467,45 +632,7 @@ static bool do_message(Conn_State *conn)
    }
    }
 
-   switch (conn->options.report_type)
-   {
-      case Report_Type_Print_Message:
-      {
-         for (int i = 0; i < (int) nr; i++)
-         {
-            if ((unsigned) buf[i] < 32
-                  || (unsigned) buf[i] >= 127)
-               buf[i] = '.';
-         }
-         msg_f("Got msg %" PRIu64 " (size %zd): %.*s",
-               conn->curmsn, nr, (int) nr, buf);
-      }
-      break;
-      case Report_Type_Interactive_Count:
-      {
-         report_count(conn);
-      }
-      break;
-      default:
-      {
-         if (conn->curmsn % 1024 == 0)
-         {
-            msg_f("msg: %" PRIu64 ", size: %d", conn->curmsn, (int) nr);
-         }
-      }
-      break;
-   }
-
-   conn->nmsgs++;
-   conn->curmsn++;
-
-   if (conn->options.nmsgs.has_value())
-   {
-      if (conn->nmsgs == conn->options.nmsgs.value())
-         return false;
-   }
-
-   return true;
+   return report_event(conn);
 }
 
 class Arg_Reader
@@ -589,12 +716,43 @@ static bool parse_options(int argc, const char **argv, FileEventReceiverOptions
             return false;
          options->nmsgs.emplace(value);
       }
+      else if (! strcmp(arg, "-types"))
+      {
+         // bit n set: receive events of type n (see FileEventType)
+         arg_reader.consume();
+         uint64_t value;
+         if (! arg_reader.parse_u64(&value))
+            return false;
+         options->event_types.emplace(value);
+      }
+      else if (! strcmp(arg, "-pathprefix") || ! strcmp(arg, "-entryidprefix"))
+      {
+         bool is_path = ! strcmp(arg, "-pathprefix");
+         arg_reader.consume();
+         if (arg_reader.eof())
+         {
+            msg_f("ERROR: Expected prefix after %s", arg);
+            return false;
+         }
+         if (is_path)
+            options->path_prefixes.push_back(arg_reader.get());
+         else
+            options->entry_id_prefixes.push_back(arg_reader.get());
+         arg_reader.consume();
+      }
       else
       {
          msg_f("Invalid arg: '%s'", arg);
          return false;
       }
    }
+
+   if ((! options->path_prefixes.empty() || ! options->entry_id_prefixes.empty())
+         && ! options->event_types.has_value())
+   {
+      options->event_types.emplace(~(uint64_t) 0);
+   }
+
    return true;
 }
 
@@ -630,15 +788,9 @@ bool receive_event(FileEventReceiverNewProtocol *r)
 
 Read_Event get_event(FileEventReceiverNewProtocol *r)
 {
-   Packet_Buffer *packet = &r->conn.receive_packet;
    Read_Event out;
-   // 8 byte packet header (type Send_Message)
-   // Send_Message packet:
-   //   8 byte msn
-   //   2 byte message size (should be removed)
-   int skip_bytes = 8 + 8 + 2;
-   out.buffer = packet->data + skip_bytes;
-   out.size = packet->size - skip_bytes;
+   out.buffer = r->conn.event_data;
+   out.size = r->conn.event_size;
    return out;
 }
 
@@ -724,7 +876,8 @@ FileEventReceiverNewProtocol *FileEventReceiverNewProtocolCreate(int argc, const
    if (! parse_options(argc, argv, &options))
    {
       //msg_f("Usage: ./seqpacket-reader <unix-socket-path> [-startmsn <MSN>] [-print]");
-      msg_f("Failed to parse options for FileEventReceiver. Syntax: <unix-socket-path> [-startmsn <MSN>]");
+      msg_f("Failed to parse options for FileEventReceiver. Syntax: <unix-socket-path> [-startmsn <MSN>]"
+            " [-types <mask>] [-pathprefix <path>]... [-entryidprefix <entryID>]...");
       return nullptr;
    }
 
@@ -65,10 +65,13 @@ App::App(int argc, char** argv)
    this->metaBuddyCapacityPools = NULL;
    this->workQueue = NULL;
    this->commSlaveQueue = NULL;
+   this->chunkFileAttribsBatcher = NULL;
+   this->mirrorForwardPipeline = NULL;
    this->disposalDir = NULL;
    this->buddyMirrorDisposalDir = NULL;
    this->rootDir = NULL;
    this->metaStore = NULL;
+   this->dirListCursorCache = NULL;
    this->ackStore = NULL;
    this->sessions = NULL;
    this->mirroredSessions = NULL;
@@ -125,6 +128,9 @@ App::~App()
    if(this->rootDir && this->metaStore)
       this->metaStore->releaseDir(this->rootDir->getID() );
    SAFE_DELETE(this->metaStore);
+   SAFE_DELETE(this->dirListCursorCache);
+   SAFE_DELETE(this->chunkFileAttribsBatcher);
+   SAFE_DELETE(this->mirrorForwardPipeline);
    SAFE_DELETE(this->commSlaveQueue);
    SAFE_DELETE(this->workQueue);
    SAFE_DELETE(this->clientNodes);
@@ -372,6 +378,10 @@ void App::runNormal()
 
    joinComponents();
 
+   /* write back deferred inode updates that are still in memory, so that open files don't need a
+      size refresh on restart (no refresh of unloaded inodes here, the workers are gone) */
+   metaStore->flushDirtyInodes(true, false);
+
    // clean shutdown (at least no cache loss) => generate a new session file
    if(sessions)
       storeSessions();
@@ -442,6 +452,17 @@ void App::initDataObjects()
 
    if(cfg->getTuneUsePerUserMsgQueues() )
       workQueue->setIndirectWorkList(new UserWorkContainer() );
+   else
+   if(cfg->getTuneUseWorkStealingQueues() )
+      workQueue->enableWorkStealing(cfg->getTuneNumWorkers() );
+
+   if(cfg->getTuneChunkAttribsBatchSize() )
+      this->chunkFileAttribsBatcher = new GetChunkFileAttribsBatcher(commSlaveQueue,
+         cfg->getTuneChunkAttribsBatchSize(), cfg->getTuneChunkAttribsBatchWindowUS() );
+
+   if(cfg->getTuneMirrorPipelineDepth() )
+      this->mirrorForwardPipeline = new MirrorForwardPipeline(
+         cfg->getTuneMirrorPipelineConns(), cfg->getTuneMirrorPipelineDepth() );
 
    this->ackStore = new AcknowledgmentStore();
 
@@ -731,6 +752,7 @@ void App::initRootDir(NumNodeID localNodeNumID)
 {
    // try to load root dir from disk (through metaStore) or create a new one
 
+   this->dirListCursorCache = new DirListCursorCache(cfg->getTuneDirListCursorCacheLimit() );
    this->metaStore = new MetaStore();
 
    // try to reference root directory with buddy mirroring
@@ -872,7 +894,8 @@ void App::initComponents(TargetConsistencyState initialConsistencyState)
 
    unsigned short listenPort = cfg->getConnMetaPort();
 
-   this->connAcceptor = new ConnAcceptor(this, nicList, listenPort);
+   this->connAcceptor = new ConnAcceptor(this, nicList, listenPort,
+      !cfg->getTuneListenerReusePort() );
 
    this->statsCollector = new StatsCollector(workQueue, STATSCOLLECTOR_COLLECT_INTERVAL_MS,
       STATSCOLLECTOR_HISTORY_LENGTH);
@@ -1045,6 +1068,9 @@ void App::streamListenersInit()
 {
    this->numStreamListeners = cfg->getTuneNumStreamListeners();
 
+   if(cfg->getTuneListenerReusePort() )
+      StreamListenerV2::checkTCPListenPortUnused(cfg->getConnMetaPort() );
+
    for(unsigned i=0; i < numStreamListeners; i++)
    {
       StreamListenerV2* listener = new StreamListenerV2(
@@ -1057,6 +1083,9 @@ void App::streamListenersInit()
          listener->setUseAggressivePoll();
 
       streamLisVec.push_back(listener);
+
+      if(cfg->getTuneListenerReusePort() )
+         listener->initTCPListenSock(cfg->getConnMetaPort() );
    }
 }
 
@@ -24,12 +24,15 @@
 #include <components/DatagramListener.h>
 #include <components/FileEventLogger.h>
 #include <components/InternodeSyncer.h>
+#include <components/MirrorForwardPipeline.h>
 #include <components/buddyresyncer/BuddyResyncer.h>
 #include <components/chunkbalancer/ChunkBalancerJob.h>
+#include <components/worker/GetChunkFileAttribsBatcher.h>
 #include <net/message/NetMessageFactory.h>
 #include <nodes/MetaNodeOpStats.h>
 #include <session/SessionStore.h>
 #include <storage/DirInode.h>
+#include <storage/DirListCursorCache.h>
 #include <storage/MetaStore.h>
 #include <storage/SyncedDiskAccessPath.h>
 #include <vector>
@@ -110,8 +113,11 @@ class App : public AbstractApp
 
       MultiWorkQueue* workQueue;
       MultiWorkQueue* commSlaveQueue;
+      GetChunkFileAttribsBatcher* chunkFileAttribsBatcher; // NULL if batching is disabled
+      MirrorForwardPipeline* mirrorForwardPipeline; // NULL if pipelining is disabled
       NetMessageFactory* netMessageFactory;
       MetaStore* metaStore;
+      DirListCursorCache* dirListCursorCache; // open DIR handles of paused dir listings
 
       DirInode* rootDir;
       bool isRootBuddyMirrored;
@@ -380,11 +386,32 @@ class App : public AbstractApp
          return commSlaveQueue;
       }
 
+      /**
+       * @return NULL if batching of chunk attribs requests is disabled
+       */
+      GetChunkFileAttribsBatcher* getChunkFileAttribsBatcher() const
+      {
+         return chunkFileAttribsBatcher;
+      }
+
+      /**
+       * @return NULL if mirrored operations are forwarded to the secondary without pipelining
+       */
+      MirrorForwardPipeline* getMirrorForwardPipeline() const
+      {
+         return mirrorForwardPipeline;
+      }
+
       MetaStore* getMetaStore() const
       {
          return metaStore;
       }
 
+      DirListCursorCache* getDirListCursorCache() const
+      {
+         return dirListCursorCache;
+      }
+
       DirInode* getRootDir() const
       {
          return rootDir;
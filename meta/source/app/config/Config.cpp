@@ -63,21 +63,30 @@ void Config::loadDefaults(bool addDashes)
    configMapRedefine("tuneProcessFDLimit",               "50000");
    configMapRedefine("tuneWorkerNumaAffinity",           "false");
    configMapRedefine("tuneListenerNumaAffinity",         "false");
+   configMapRedefine("tuneListenerReusePort",            "false");
    configMapRedefine("tuneBindToNumaZone",               "");
    configMapRedefine("tuneListenerPrioShift",            "-1");
    configMapRedefine("tuneDirMetadataCacheLimit",        "1024");
+   configMapRedefine("tuneDirListCursorCacheLimit",      "256");
    configMapRedefine("tuneTargetChooser",                TARGETCHOOSERTYPE_RANDOMIZED_STR);
    configMapRedefine("tuneLockGrantWaitMS",              "333");
    configMapRedefine("tuneLockGrantNumRetries",          "15");
    configMapRedefine("tuneRotateMirrorTargets",          "false");
    configMapRedefine("tuneEarlyUnlinkResponse",          "true");
    configMapRedefine("tuneUsePerUserMsgQueues",          "false");
+   configMapRedefine("tuneUseWorkStealingQueues",        "false");
    configMapRedefine("tuneUseAggressiveStreamPoll",      "false");
    configMapRedefine("tuneNumResyncSlaves",              "12");
    configMapRedefine("tuneMirrorTimestamps",             "true");
    configMapRedefine("tuneDisposalGCPeriod",             "0");
    configMapRedefine("tuneChunkBalanceQueueLimit",       "100000");
    configMapRedefine("tuneChunkBalanceLockingTimeLimit", "300");
+   configMapRedefine("tuneChunkAttribsBatchSize",        "0");
+   configMapRedefine("tuneChunkAttribsBatchWindowUS",    "200");
+   configMapRedefine("tuneUseRequestFanOut",             "false");
+   configMapRedefine("tuneMirrorPipelineDepth",          "0");
+   configMapRedefine("tuneMirrorPipelineConns",          "4");
+   configMapRedefine("tuneInodeWriteBackSecs",           "0");
 
 
    configMapRedefine("quotaEarlyChownResponse",    "true");
@@ -162,6 +171,8 @@ void Config::applyConfigMap(bool enableException, bool addDashes)
          tuneWorkerNumaAffinity = StringTk::strToBool(iter->second);
       else if (iter->first == std::string("tuneListenerNumaAffinity"))
          tuneListenerNumaAffinity = StringTk::strToBool(iter->second);
+      else if (iter->first == std::string("tuneListenerReusePort"))
+         tuneListenerReusePort = StringTk::strToBool(iter->second);
       else if (iter->first == std::string("tuneBindToNumaZone"))
       {
          if (iter->second.empty()) // not defined => disable
@@ -173,6 +184,8 @@ void Config::applyConfigMap(bool enableException, bool addDashes)
          tuneListenerPrioShift = StringTk::strToInt(iter->second);
       else if (iter->first == std::string("tuneDirMetadataCacheLimit"))
          tuneDirMetadataCacheLimit = StringTk::strToUInt(iter->second);
+      else if (iter->first == std::string("tuneDirListCursorCacheLimit"))
+         tuneDirListCursorCacheLimit = StringTk::strToUInt(iter->second);
       else if (iter->first == std::string("tuneTargetChooser"))
          tuneTargetChooser = iter->second;
       else if (iter->first == std::string("tuneLockGrantWaitMS"))
@@ -205,6 +218,8 @@ void Config::applyConfigMap(bool enableException, bool addDashes)
          sysAllowUserSetPattern = StringTk::strToBool(iter->second.c_str());
       else if (iter->first == std::string("tuneUsePerUserMsgQueues"))
          tuneUsePerUserMsgQueues = StringTk::strToBool(iter->second);
+      else if (iter->first == std::string("tuneUseWorkStealingQueues"))
+         tuneUseWorkStealingQueues = StringTk::strToBool(iter->second);
       else if (iter->first == std::string("tuneMirrorTimestamps"))
          tuneMirrorTimestamps = StringTk::strToBool(iter->second);
       else if(iter->first == std::string("tuneDisposalGCPeriod"))
@@ -213,6 +228,18 @@ void Config::applyConfigMap(bool enableException, bool addDashes)
          tuneChunkBalanceQueueLimit = StringTk::strToUInt(iter->second);
       else if(iter->first == std::string("tuneChunkBalanceLockingTimeLimit"))
          tuneChunkBalanceLockingTimeLimit = StringTk::strToUInt(iter->second);
+      else if(iter->first == std::string("tuneChunkAttribsBatchSize"))
+         tuneChunkAttribsBatchSize = StringTk::strToUInt(iter->second);
+      else if(iter->first == std::string("tuneChunkAttribsBatchWindowUS"))
+         tuneChunkAttribsBatchWindowUS = StringTk::strToUInt(iter->second);
+      else if(iter->first == std::string("tuneUseRequestFanOut"))
+         tuneUseRequestFanOut = StringTk::strToBool(iter->second);
+      else if(iter->first == std::string("tuneMirrorPipelineDepth"))
+         tuneMirrorPipelineDepth = StringTk::strToUInt(iter->second);
+      else if(iter->first == std::string("tuneMirrorPipelineConns"))
+         tuneMirrorPipelineConns = StringTk::strToUInt(iter->second);
+      else if(iter->first == std::string("tuneInodeWriteBackSecs"))
+         tuneInodeWriteBackSecs = StringTk::strToUInt(iter->second);
       else if (iter->first == std::string("sysFileEventLogTarget"))
          sysFileEventLogTarget = iter->second;
       else if (iter->first == std::string("sysFileEventPersistDirectory"))
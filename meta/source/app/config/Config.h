@@ -50,9 +50,11 @@ class Config : public AbstractConfig
       unsigned          tuneProcessFDLimit; // 0 means "don't touch limit"
       bool              tuneWorkerNumaAffinity;
       bool              tuneListenerNumaAffinity;
+      bool              tuneListenerReusePort; // true for per-listener SO_REUSEPORT accept
       int               tuneBindToNumaZone; // bind all threads to this zone, -1 means no binding
       int               tuneListenerPrioShift; // inc/dec thread priority of listener components
       unsigned          tuneDirMetadataCacheLimit;
+      unsigned          tuneDirListCursorCacheLimit; // 0 disables caching of listing cursors
       std::string       tuneTargetChooser;
       TargetChooserType tuneTargetChooserNum;  // auto-generated based on tuneTargetChooser
       unsigned          tuneLockGrantWaitMS; // time to wait for an ack per retry
@@ -60,12 +62,19 @@ class Config : public AbstractConfig
       bool              tuneRotateMirrorTargets; // true to use rotated targets list as mirrors
       bool              tuneEarlyUnlinkResponse; // true to send response before chunk files unlink
       bool              tuneUsePerUserMsgQueues; // true to use UserWorkContainer for MultiWorkQueue
+      bool              tuneUseWorkStealingQueues; // true to use WorkStealingQueue in MultiWorkQueue
       bool              tuneUseAggressiveStreamPoll; // true to not sleep on epoll in streamlisv2
       unsigned          tuneNumResyncSlaves;
       bool              tuneMirrorTimestamps;
       unsigned          tuneDisposalGCPeriod; // sleep between disposal garbage collector runs [seconds], 0 = disabled
       unsigned          tuneChunkBalanceQueueLimit;  //maximum number of items in chunk balancing queue
       unsigned          tuneChunkBalanceLockingTimeLimit; // maximum time in seconds that a file can be locked for chunk balancing
+      unsigned          tuneChunkAttribsBatchSize; // max entries per batched chunk attribs request, 0 disables batching
+      unsigned          tuneChunkAttribsBatchWindowUS; // time to collect chunk attribs requests for a batch
+      bool              tuneUseRequestFanOut; // true to send storage requests from workers
+      unsigned          tuneMirrorPipelineDepth; // max forwarded requests in flight, 0 = no pipeline
+      unsigned          tuneMirrorPipelineConns; // connections to the secondary for the pipeline
+      unsigned          tuneInodeWriteBackSecs; // max delay of deferred inode updates, 0 = no delay
 
       bool              quotaEarlyChownResponse; // true to send response before chunk files chown
       bool              quotaEnableEnforcement;
@@ -194,6 +203,11 @@ class Config : public AbstractConfig
          return tuneListenerNumaAffinity;
       }
 
+      bool getTuneListenerReusePort() const
+      {
+         return tuneListenerReusePort;
+      }
+
       int getTuneBindToNumaZone() const
       {
          return tuneBindToNumaZone;
@@ -209,6 +223,11 @@ class Config : public AbstractConfig
          return tuneDirMetadataCacheLimit;
       }
 
+      unsigned getTuneDirListCursorCacheLimit() const
+      {
+         return tuneDirListCursorCacheLimit;
+      }
+
       TargetChooserType getTuneTargetChooserNum() const
       {
          return tuneTargetChooserNum;
@@ -239,6 +258,11 @@ class Config : public AbstractConfig
          return tuneUsePerUserMsgQueues;
       }
 
+      bool getTuneUseWorkStealingQueues() const
+      {
+         return tuneUseWorkStealingQueues;
+      }
+
       bool getTuneUseAggressiveStreamPoll() const
       {
          return tuneUseAggressiveStreamPoll;
@@ -287,6 +311,18 @@ class Config : public AbstractConfig
 
       unsigned getTuneChunkBalanceLockingTimeLimit() const { return tuneChunkBalanceLockingTimeLimit; }
 
+      unsigned getTuneChunkAttribsBatchSize() const { return tuneChunkAttribsBatchSize; }
+
+      unsigned getTuneChunkAttribsBatchWindowUS() const { return tuneChunkAttribsBatchWindowUS; }
+
+      bool getTuneUseRequestFanOut() const { return tuneUseRequestFanOut; }
+
+      unsigned getTuneMirrorPipelineDepth() const { return tuneMirrorPipelineDepth; }
+
+      unsigned getTuneMirrorPipelineConns() const { return tuneMirrorPipelineConns; }
+
+      unsigned getTuneInodeWriteBackSecs() const { return tuneInodeWriteBackSecs; }
+
       bool getSysAllowUserSetPattern() const { return sysAllowUserSetPattern; }
 
       bool getLimitXAttrListLength() const { return limitXAttrListLength; }
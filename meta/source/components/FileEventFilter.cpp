@@ -0,0 +1,46 @@
+#include "FileEventFilter.h"
+
+#include <common/toolkit/serialization/Serialization.h>
+
+bool EventFilter::matches(const void *msgData, size_t msgSize) const
+{
+   if (! active)
+      return true;
+
+   // see FileEventLogItem::serialize() in FileEventLogger.cpp
+   uint16_t formatVersion;
+   uint32_t eventFlags;
+   uint64_t numHardlinks;
+   uint32_t type;
+
+   Deserializer des(msgData, msgSize);
+   des % formatVersion % eventFlags % numHardlinks % type;
+
+   if (! des.good() || formatVersion != 2)
+      return true;  // don't hide what we can't parse
+
+   if (type >= 64 || ! (typeMask & (1ull << type)))
+      return false;
+
+   if (pathPrefixes.empty() && entryIdPrefixes.empty())
+      return true;
+
+   const char *entryId, *parentId, *path, *targetPath, *targetParentId;
+   unsigned entryIdLen, parentIdLen, pathLen, targetPathLen, targetParentIdLen;
+
+   des
+      % serdes::rawString(entryId, entryIdLen)
+      % serdes::rawString(parentId, parentIdLen)
+      % serdes::rawString(path, pathLen)
+      % serdes::rawString(targetPath, targetPathLen)
+      % serdes::rawString(targetParentId, targetParentIdLen);
+
+   if (! des.good())
+      return true;
+
+   return matchesAny(pathPrefixes, path, pathLen)
+      || matchesAny(pathPrefixes, targetPath, targetPathLen)
+      || matchesAny(entryIdPrefixes, entryId, entryIdLen)
+      || matchesAny(entryIdPrefixes, parentId, parentIdLen)
+      || matchesAny(entryIdPrefixes, targetParentId, targetParentIdLen);
+}
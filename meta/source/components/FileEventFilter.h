@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+// Filter that a subscriber requested with Request_Event_Filter. It gets
+// evaluated on the serialized events from the PMQ before they get packed into
+// packets. Most events are rejected by the event type bit test alone; the
+// prefixes are compared in place, without deserializing the strings.
+struct EventFilter
+{
+   static constexpr size_t MAX_PREFIXES = 64;
+   static constexpr size_t MAX_PREFIX_LEN = 4096;
+
+   bool active = false;
+   uint64_t typeMask = 0;  // bit n set: pass events of FileEventType n
+   // If both are empty, events pass regardless of their path and IDs.
+   std::vector<std::string> pathPrefixes;  // matched against path and targetPath
+   std::vector<std::string> entryIdPrefixes;  // entryId, parentId, targetParentId
+
+   bool matches(const void *msgData, size_t msgSize) const;
+
+private:
+   static bool matchesAny(std::vector<std::string> const& prefixes, const char *str,
+         unsigned len)
+   {
+      for (auto const& prefix : prefixes)
+      {
+         if (len >= prefix.size() && ! memcmp(str, prefix.data(), prefix.size()))
+            return true;
+      }
+      return false;
+   }
+};
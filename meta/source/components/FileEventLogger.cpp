@@ -1,3 +1,4 @@
+#include "FileEventFilter.h"
 #include "FileEventLogger.h"
 
 #include <common/app/config/AbstractConfig.h>
@@ -273,6 +274,14 @@ enum class PacketType : uint8_t
    // This is the last message sent by the server.
    // Includes a ConnTerminateReason
    Send_Close,
+   // Server sends a number of (event) messages to client.
+   // Replaces Send_Message if the client requested protocol version 2.1.
+   // Layout: u16 message count, then for each message its u64 msn, u16 size
+   // and data (see "Protocol 2.1" in event_listener/documentation_start.md).
+   Send_Message_Batch,
+   // Client requests that only events matching the included filter get sent.
+   // Sent after the handshake, usually before Request_Message_Stream_Start.
+   Request_Event_Filter,
 };
 
 enum class ConnTerminateReason
@@ -306,6 +315,8 @@ static const char *packetTypeString(PacketType packetType)
       PTSTRING(Send_Message);
       PTSTRING(Close_Request);
       PTSTRING(Send_Close);
+      PTSTRING(Send_Message_Batch);
+      PTSTRING(Request_Event_Filter);
       default: return "(invalid packet type)";
    }
 }
@@ -433,6 +444,15 @@ public:
       return getPacket(rd);
    }
 
+   // Like dequeueBegin(), but returns the i-th packet in the queue. Allows to
+   // dequeue multiple packets at once.
+   PacketBuffer *dequeuePeek(uint32_t i)
+   {
+      if (wr - rd <= i)
+         return nullptr;
+      return getPacket(rd + i);
+   }
+
    void dequeueEnd()
    {
       assert(wr - rd > 0);
@@ -442,17 +462,38 @@ public:
 
 
 
+// Sends all packets from the queue (as far as the socket buffer allows), using
+// a single sendmmsg() call for up to SEND_BATCH_MAX packets.
 static void sendPackets(PacketQueue *txQueue, SocketState *socketState)
 {
+   static constexpr unsigned SEND_BATCH_MAX = 8;  // (size of the tx queue)
+
    int fd = socketState->sockFd.get();
 
    for (;;)
    {
-      PacketBuffer *packet = txQueue->dequeueBegin();
-      if (! packet)
+      struct iovec iovs[SEND_BATCH_MAX];
+      struct mmsghdr msgs[SEND_BATCH_MAX];
+      unsigned count = 0;
+
+      for (; count < SEND_BATCH_MAX; count++)
+      {
+         PacketBuffer *packet = txQueue->dequeuePeek(count);
+         if (! packet)
+            break;
+
+         iovs[count].iov_base = packet->data();
+         iovs[count].iov_len = packet->size();
+
+         msgs[count] = {};
+         msgs[count].msg_hdr.msg_iov = &iovs[count];
+         msgs[count].msg_hdr.msg_iovlen = 1;
+      }
+
+      if (count == 0)
          break;
 
-      ssize_t n = ::send(fd, packet->data(), packet->size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+      int n = ::sendmmsg(fd, msgs, count, MSG_NOSIGNAL | MSG_DONTWAIT);
 
       if (n == -1)
       {
@@ -463,7 +504,7 @@ static void sendPackets(PacketQueue *txQueue, SocketState *socketState)
          }
          else if (e == EMSGSIZE)
          {
-            LOG(EVENTLOGGER, WARNING, "Message too large to send over fileevent socket. Ignoring", packet->size());
+            LOG(EVENTLOGGER, WARNING, "Message too large to send over fileevent socket. Ignoring", iovs[0].iov_len);
          }
          else
          {
@@ -473,7 +514,11 @@ static void sendPackets(PacketQueue *txQueue, SocketState *socketState)
          break;
       }
 
-      txQueue->dequeueEnd();
+      for (int i = 0; i < n; i++)
+         txQueue->dequeueEnd();
+
+      if ((unsigned) n < count)
+         break;  // socket buffer is full, try again later
    }
 }
 
@@ -641,30 +686,35 @@ struct MessageStream
 {
    PMQ_Reader_Handle reader;
    PMQ_Read_Result lastPmqError = PMQ_Read_Result_Success;
-   // Currently buffering 1 message only.
-   bool msgIsPresent = false;
-   size_t msgSize = 0;
-   uint64_t msgMsn = 0;
+   // Messages get read in batches (pmq_read_msgs()) and are stored back to
+   // back in msgBuffer. The current message is msgIndex of msgCount.
+   size_t msgCount = 0;
+   size_t msgIndex = 0;
+   size_t msgOffset = 0;  // offset of the current message in msgBuffer
+   uint64_t batchMsn = 0;  // msn of the first message in msgBuffer
    MallocBuffer msgBuffer;
+   std::vector<size_t> msgSizes;
 
 public:
-   bool haveMessage() const { return msgIsPresent; }
-   uint64_t getMsgMsn() const { return msgMsn; }
-   const void *getMsgData() const { return msgBuffer.data(); }
-   size_t getMsgSize() const { return msgSize; }
+   bool haveMessage() const { return msgIndex < msgCount; }
+   uint64_t getMsgMsn() const { return batchMsn + msgIndex; }
+   const void *getMsgData() const { return (const char *) msgBuffer.data() + msgOffset; }
+   size_t getMsgSize() const { return msgSizes[msgIndex]; }
    PMQ_Read_Result getError() const { return lastPmqError; }
    bool haveError() const { return lastPmqError != PMQ_Read_Result_Success && lastPmqError != PMQ_Read_Result_EOF; }
 
    bool init(PMQ *pmq);
    void seek(uint64_t msn);
    bool checkMsg();
-   void clearMsg() { msgIsPresent = false; }
+   void clearMsg() { msgOffset += msgSizes[msgIndex]; msgIndex++; }
+   void dropMsgs() { msgCount = 0; msgIndex = 0; msgOffset = 0; }
 };
 
 bool MessageStream::init(PMQ *pmq)
 {
-   if (! msgBuffer.reset(16 * 1024))
+   if (! msgBuffer.reset(64 * 1024))
       return false;
+   msgSizes.resize(1024);
    reader = pmq_reader_create(pmq);
    return reader.get() != nullptr;
 }
@@ -674,6 +724,8 @@ void MessageStream::seek(uint64_t msn)
    if (lastPmqError != PMQ_Read_Result_Success && lastPmqError != PMQ_Read_Result_EOF)
       return; // should we even get here?
 
+   dropMsgs();
+
    lastPmqError = pmq_reader_seek_to_msg(reader.get(), msn);
 
    switch (lastPmqError)
@@ -690,39 +742,38 @@ void MessageStream::seek(uint64_t msn)
    }
 }
 
-// Lock the queue and read the next message from the queue.
-// While there is no message, we also make sure that the queue gets flushed as scheduled.
-// We try to minimize the time where the queue is locked.
+// Read the next batch of messages from the queue if all buffered messages
+// have been consumed.
 bool MessageStream::checkMsg()
 {
-   if (msgIsPresent)
+   if (haveMessage())
       return true;
 
-   msgSize = 0;
-   msgMsn = pmq_reader_get_current_msn(reader);
+   dropMsgs();
+   batchMsn = pmq_reader_get_current_msn(reader);
 
-   lastPmqError = pmq_read_msg(reader, msgBuffer.data(), msgBuffer.capacity(), &msgSize);
+   lastPmqError = pmq_read_msgs(reader, msgBuffer.data(), msgBuffer.capacity(),
+         msgSizes.data(), msgSizes.size(), &msgCount);
 
    switch (lastPmqError)
    {
-      // The message was successfully read back.
+      // The messages were successfully read back.
       case PMQ_Read_Result_Success:
-         msgIsPresent = true;
-         LOG(EVENTLOGGER, SPAM, "pmq_read_msg() returns PMQ_Read_Result_Success");
+         LOG(EVENTLOGGER, SPAM, "pmq_read_msgs() returns PMQ_Read_Result_Success", msgCount);
          break;
 
       // How to handle all the other cases?
       case PMQ_Read_Result_Buffer_Too_Small:
-         LOG(EVENTLOGGER, SPAM, "pmq_read_msg() returns PMQ_Read_Result_Buffer_Too_Small");
+         LOG(EVENTLOGGER, SPAM, "pmq_read_msgs() returns PMQ_Read_Result_Buffer_Too_Small");
          break;
 
       case PMQ_Read_Result_EOF:
          // why have we been called then?
-         //LOG(EVENTLOGGER, SPAM, "pmq_read_msg() returns PMQ_Read_Result_EOF");
+         //LOG(EVENTLOGGER, SPAM, "pmq_read_msgs() returns PMQ_Read_Result_EOF");
          break;
 
       case PMQ_Read_Result_Out_Of_Bounds:
-         LOG(EVENTLOGGER, DEBUG, "pmq_read_msg() returns PMQ_Read_Result_Out_Of_Bounds");
+         LOG(EVENTLOGGER, DEBUG, "pmq_read_msgs() returns PMQ_Read_Result_Out_Of_Bounds");
          break;
 
       case PMQ_Read_Result_IO_Error:
@@ -738,7 +789,7 @@ bool MessageStream::checkMsg()
          break;
    }
 
-   return msgIsPresent;
+   return haveMessage();
 }
 
 struct Subscriber
@@ -756,6 +807,7 @@ struct Subscriber
 
    FileEventLoggerIds ids;
 
+   EventFilter eventFilter;
    MessageStream messageStream;
    SocketState socketState;
 
@@ -872,11 +924,13 @@ static void processPacket(Subscriber *s, PacketBuffer *packet)
             return;
          }
 
-         if (major != 2 || minor != 0)
+         // 2.1 is 2.0 plus Send_Message_Batch. Our handshake response always says
+         // 2.0 since it may be sent before we know what the subscriber supports.
+         if (major != 2 || minor > 1)
          {
             char version[16];
             snprintf(version, sizeof version, "%u.%u", major, minor);
-            LOG(EVENTLOGGER, WARNING, "Unsupported protocol version requested subscriber: 2.0 required, got:", version);
+            LOG(EVENTLOGGER, WARNING, "Unsupported protocol version requested subscriber: 2.0 or 2.1 required, got:", version);
          }
 
          s->peerMajorVersion = major;
@@ -921,6 +975,57 @@ static void processPacket(Subscriber *s, PacketBuffer *packet)
          s->streaming = true;
       }
       break;
+      case PacketType::Request_Event_Filter:
+      {
+         // u64 event type mask, u16 number of path prefixes, u16 number of
+         // entryID prefixes, then all prefixes, each as u16 length and string.
+         EventFilter filter;
+         uint16_t numPathPrefixes;
+         uint16_t numEntryIdPrefixes;
+
+         read_u64(reader, filter.typeMask);
+         read_u16(reader, numPathPrefixes);
+         read_u16(reader, numEntryIdPrefixes);
+
+         if (! reader.good()
+               || numPathPrefixes + numEntryIdPrefixes > EventFilter::MAX_PREFIXES)
+         {
+            malformedPacket(s, "Invalid Request_Event_Filter packet");
+            return;
+         }
+
+         for (unsigned i = 0; i < numPathPrefixes + numEntryIdPrefixes; i++)
+         {
+            uint16_t len;
+            read_u16(reader, len);
+
+            if (! reader.good() || len > EventFilter::MAX_PREFIX_LEN)
+            {
+               malformedPacket(s, "Invalid prefix in Request_Event_Filter packet");
+               return;
+            }
+
+            std::string prefix(len, '\0');
+            read_slice(reader, WO_Slice(&prefix[0], len));
+
+            if (i < numPathPrefixes)
+               filter.pathPrefixes.push_back(std::move(prefix));
+            else
+               filter.entryIdPrefixes.push_back(std::move(prefix));
+         }
+
+         if (! packetEnd(s, reader))
+            return;
+
+         filter.active = true;
+         s->eventFilter = std::move(filter);
+
+         LOG(EVENTLOGGER, NOTICE, "Subscriber requested event filter.",
+               ("typeMask", s->eventFilter.typeMask),
+               ("pathPrefixes", s->eventFilter.pathPrefixes.size()),
+               ("entryIdPrefixes", s->eventFilter.entryIdPrefixes.size()));
+      }
+      break;
       case PacketType::Close_Request:
       {
          if (! packetEnd(s, reader))
@@ -968,6 +1073,58 @@ static void malformedPacket(Subscriber *s, const char *fmt, ...)  // NOLINT
    subscriberTerminate(s, ConnTerminateReason::Protocol_Error);
 }
 
+// Protocol 2.1: Pack as many messages as fit into each Send_Message_Batch
+// packet (see PacketType for the layout). Each message carries its own msn
+// since the msns have gaps if the subscriber has an event filter.
+static void streamMessageBatches(Subscriber *s)
+{
+   static constexpr size_t MSG_HEADER_SIZE = sizeof(uint64_t) + sizeof(uint16_t);
+
+   while (s->messageStream.checkMsg())
+   {
+      PacketWriter writer;
+      if (! write_begin(writer, &s->txQueue))
+         break;
+
+      write_packet_header(writer, PacketType::Send_Message_Batch);
+
+      Serializer countMark = writer.serializer.mark();
+      uint16_t count = 0;
+      write_u16(writer, count);  // filled in below
+
+      for (;
+            count < UINT16_MAX && s->messageStream.checkMsg();
+            s->messageStream.clearMsg())
+      {
+         const void *msgData = s->messageStream.getMsgData();
+         size_t msgSize = s->messageStream.getMsgSize();
+
+         if (! s->eventFilter.matches(msgData, msgSize))
+            continue;
+
+         if (count > 0
+               && writer.serializer.size() + MSG_HEADER_SIZE + msgSize >= writer.packet->capacity())
+            break; // next packet
+
+         write_u64(writer, s->messageStream.getMsgMsn());
+         write_u16(writer, msgSize);
+         write_slice(writer, RO_Slice(msgData, msgSize));
+         count++;
+      }
+
+      if (count == 0)
+         break;  // all remaining messages were filtered out
+
+      countMark % count;
+
+      if (! write_end(writer))
+      {
+         // can this ever happen?
+         LOG(EVENTLOGGER, ERR, "Failed to serialize message batch of size", writer.serializer.size());
+      }
+   }
+}
+
 static void subscriberDoNonIOWork(Subscriber *s)
 {
    if (! s->handshakeSent)
@@ -1056,7 +1213,11 @@ static void subscriberDoNonIOWork(Subscriber *s)
       }
    }
 
-   if (s->streaming)
+   if (s->streaming && s->peerMinorVersion >= 1)
+   {
+      streamMessageBatches(s);
+   }
+   else if (s->streaming)
    {
       // While there are more messages to read and the packet tx queue isn't
       // full, send more packets.
@@ -1065,14 +1226,17 @@ static void subscriberDoNonIOWork(Subscriber *s)
             s->messageStream.checkMsg();
             s->messageStream.clearMsg())
       {
-         PacketWriter writer;
-         if (! write_begin(writer, &s->txQueue))
-            break;
-
          uint64_t msn = s->messageStream.getMsgMsn();
          const void *msgData = s->messageStream.getMsgData();
          size_t msgSize = s->messageStream.getMsgSize();
 
+         if (! s->eventFilter.matches(msgData, msgSize))
+            continue;
+
+         PacketWriter writer;
+         if (! write_begin(writer, &s->txQueue))
+            break;
+
          write_packet_header(writer, PacketType::Send_Message);
          write_u64(writer, msn);
          write_u16(writer, msgSize);
@@ -1468,8 +1632,6 @@ static constexpr size_t EVENT_BUFFER_SIZE = sizeof (FileEventLogItem::numHardlin
 
 void logEvent(FileEventLogger *logger, const FileEvent& event, const EventContext& eventCtx)
 {
-   LockedView<EventLoggerShared> shared = logger->shared.lockedView();
-
    FileEventLogItem logItem = {
                               eventCtx.eventFlags,
                               eventCtx.linkCount,
@@ -1521,6 +1683,12 @@ void logEvent(FileEventLogger *logger, const FileEvent& event, const EventContex
    }
 
    LOG(EVENTLOGGER, SPAM, "Enqueued message:", itemSize);
+
+   // The enqueue above doesn't need the shared lock (pmq_enqueue_msg() supports concurrent
+   // producers), only the notification does. Readers check for messages under the lock before
+   // they wait, so taking it after the enqueue can't miss a waiting reader.
+   LockedView<EventLoggerShared> shared = logger->shared.lockedView();
+
    // make sure that new messages get flushed regularly.
    {
       if (!shared->flushTimer.isSet())
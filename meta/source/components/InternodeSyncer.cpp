@@ -161,9 +161,15 @@ void InternodeSyncer::syncLoop()
          bool flushTriggered = app->getMetaStore()->cacheSweepAsync();
          currentCacheSweepMS = (flushTriggered ? metaCacheSweepStressedMS : metaCacheSweepNormalMS);
 
+         if(app->getDirListCursorCache() )
+            app->getDirListCursorCache()->sweep(); // (idle cursors of paused listings)
+
          lastMetaCacheSweepT.setToNow();
       }
 
+      if(cfg->getTuneInodeWriteBackSecs() )
+         app->getMetaStore()->flushDirtyInodes(false, true);
+
       if(lastIdleDisconnectT.elapsedMS() > idleDisconnectIntervalMS)
       {
          dropIdleConns();
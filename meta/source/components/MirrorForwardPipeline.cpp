@@ -0,0 +1,605 @@
+#include <common/app/log/LogContext.h>
+#include <common/net/message/control/GenericResponseMsg.h>
+#include <common/threading/PThread.h>
+#include <common/toolkit/MessagingTk.h>
+#include "MirrorForwardPipeline.h"
+
+#include <mutex>
+#include <poll.h>
+
+
+MirrorForwardPipeline::MirrorForwardPipeline(unsigned numConns, unsigned maxInFlight) :
+   maxInFlight(std::max(maxInFlight, 1U) ),
+   numDependencyWaiters(0),
+   isDisabled(false),
+   nextConnIndex(0),
+   slots(MIRRORFORWARDPIPELINE_NUM_SLOTS, Slot{0, 0} )
+{
+   for(unsigned i = 0; i < std::max(numConns, 1U); i++)
+      conns.emplace_back(new Conn() );
+}
+
+/**
+ * Note: All forward() calls must have returned before.
+ */
+MirrorForwardPipeline::~MirrorForwardPipeline()
+{
+   std::lock_guard<Mutex> lock(mutex);
+
+   for(auto& conn : conns)
+   {
+      if(conn->sock)
+         closeSocket(*conn);
+   }
+}
+
+/**
+ * Sends a request to the secondary and receives the response (like
+ * MessagingTk::requestResponseNode() ).
+ *
+ * @param rrArgs rrArgs->node must be NULL when calling this.
+ * @param lockHashes hashes of the EntryLockStore locks that the caller holds for this operation
+ *    (see EntryLockStore::LockHashRecorder); must stay valid until this returns.
+ * @param sentCallback called after the request was sent and before waiting for the response; all
+ *    later forward() calls with one of the same lockHashes will be processed on the secondary
+ *    after this request.
+ * @return received message is available through rrArgs in case of success.
+ */
+FhgfsOpsErr MirrorForwardPipeline::forward(RequestResponseNode* rrNode,
+   RequestResponseArgs* rrArgs, const std::vector<uint32_t>& lockHashes,
+   const std::function<void()>& sentCallback)
+{
+   BEEGFS_BUG_ON_DEBUG(rrArgs->node, "rrArgs->node must be NULL");
+
+   NodeHandle targetNode;
+
+   FhgfsOpsErr refRes = MessagingTk::referenceNode(rrNode, rrArgs, targetNode);
+   if(refRes != FhgfsOpsErr_SUCCESS)
+      return refRes;
+
+   Request request = {rrArgs, &lockHashes, 0, 0, false, false, false, 0, FhgfsOpsErr_INTERNAL};
+   bool mayRetry;
+
+   FhgfsOpsErr sendRes = sendRequest(request, targetNode, mayRetry);
+   // One retry in case the connection was already broken when we got it (e.g. peer daemon restart).
+   if( (sendRes == FhgfsOpsErr_COMMUNICATION) && mayRetry)
+   {
+      LOG(MIRRORING, WARNING, "Retrying communication.",
+            ("peer", targetNode->getNodeIDWithTypeStr() ),
+            ("message type", rrArgs->requestMsg->getMsgTypeStr() ) );
+
+      sendRes = sendRequest(request, targetNode, mayRetry);
+   }
+
+   FhgfsOpsErr retVal;
+
+   if(sendRes == FhgfsOpsErr_SUCCESS)
+   {
+      sentCallback();
+      retVal = waitForResponse(request, targetNode);
+   }
+   else
+   if(sendRes == FhgfsOpsErr_NOTSUPP)
+   { // pipelining is disabled for this connection
+      rrArgs->node = NULL;
+      targetNode.reset();
+
+      return MessagingTk::requestResponseNode(rrNode, rrArgs);
+   }
+   else
+      retVal = sendRes;
+
+   rrArgs->node = NULL;
+
+   return retVal;
+}
+
+/**
+ * Append the request to the stream of requests of a connection to the secondary and send it
+ * (connect if necessary).
+ *
+ * @param targetNode the node of rrArgs->node.
+ * @param outMayRetry true if there was no other request in flight on a connection that failed.
+ * @return FhgfsOpsErr_NOTSUPP if pipelining is disabled; the request wasn't sent in this case.
+ */
+FhgfsOpsErr MirrorForwardPipeline::sendRequest(Request& request, const NodeHandle& targetNode,
+   bool& outMayRetry)
+{
+   std::lock_guard<Mutex> lock(mutex);
+
+   outMayRetry = false;
+
+   if(isDisabled)
+      return FhgfsOpsErr_NOTSUPP;
+
+   enqueueUnlocked(request);
+
+   return transmitUnlocked(request, targetNode, outMayRetry);
+}
+
+/**
+ * Wait until it is the request's turn on its connection and send it (connect if necessary).
+ *
+ * Note: Caller must hold mutex; the mutex is unlocked while connecting and sending.
+ */
+FhgfsOpsErr MirrorForwardPipeline::transmitUnlocked(Request& request,
+   const NodeHandle& targetNode, bool& outMayRetry)
+{
+   const char* logContext = "MirrorForwardPipeline";
+
+   RequestResponseArgs* rrArgs = request.rrArgs;
+   Conn& conn = *conns[request.connIndex];
+
+   outMayRetry = false;
+
+   while(!request.isDone && (conn.nextSendSeqNo != request.seqNo) )
+      conn.stateChangedCond.wait(&mutex);
+
+   if(conn.sock && (conn.sockBroken || (conn.node != targetNode) ) )
+   { // need a new connection (e.g. after a buddy group change) => wait for the old requests
+      while(!request.isDone &&
+         ( (conn.inFlight.front() != &request) || conn.receiverActive) )
+         conn.stateChangedCond.wait(&mutex);
+
+      if(!request.isDone)
+         closeSocket(conn);
+   }
+
+   if(request.isDone)
+      return request.result; // failed together with the earlier requests of the conn
+
+   if(!conn.sock)
+   { // connect (nothing else was sent on this conn, so there is no receiver)
+      NodeConnPool* connPool = rrArgs->node->getConnPool();
+      Socket* newSock;
+
+      mutex.unlock();
+
+      try
+      {
+         newSock = connPool->acquireStreamSocket();
+      }
+      catch(SocketException& e)
+      {
+         LOG(MIRRORING, WARNING, "Unable to connect to secondary.",
+               ("peer", rrArgs->node->getNodeIDWithTypeStr() ), ("error", e.what() ) );
+
+         mutex.lock();
+         failRequestsUnlocked(conn, FhgfsOpsErr_COMMUNICATION);
+         return FhgfsOpsErr_COMMUNICATION;
+      }
+
+      mutex.lock();
+
+      if(newSock->getSockType() != NICADDRTYPE_STANDARD)
+      { // we send and receive concurrently on the socket, which we can only rely on for TCP
+         connPool->releaseStreamSocket(newSock);
+
+         LogContext(logContext).log(Log_NOTICE, "Connection to secondary is not a TCP "
+            "connection. Forwarding mirrored operations without pipelining.");
+
+         isDisabled = true;
+         failRequestsUnlocked(conn, FhgfsOpsErr_NOTSUPP);
+         return FhgfsOpsErr_NOTSUPP;
+      }
+
+      conn.sock = newSock;
+      conn.node = targetNode;
+   }
+
+   Socket* requestSock = conn.sock;
+
+   outMayRetry = (conn.inFlight.front() == &request) && !request.numRetries;
+
+   mutex.unlock();
+
+   bool sendSuccess = false;
+
+   try
+   {
+      const auto sendBuf = MessagingTk::createMsgVec(*rrArgs->requestMsg);
+      requestSock->send(&sendBuf[0], sendBuf.size(), 0);
+
+      FhgfsOpsErr extraDataRes = rrArgs->sendExtraData ?
+         rrArgs->sendExtraData(requestSock, rrArgs->extraDataContext) : FhgfsOpsErr_SUCCESS;
+
+      if(likely(extraDataRes == FhgfsOpsErr_SUCCESS) )
+         sendSuccess = true;
+      else
+      { // the secondary may already have received the complete message => no retry
+         LOG(MIRRORING, WARNING, "Sending extra data to secondary failed.",
+               ("seqNo", request.seqNo), extraDataRes,
+               ("message type", rrArgs->requestMsg->getMsgTypeStr() ) );
+
+         outMayRetry = false;
+      }
+   }
+   catch(const std::bad_alloc& e)
+   {
+      LOG(MIRRORING, ERR, "Memory allocation for send buffer failed.");
+   }
+   catch(SocketException& e)
+   {
+      LOG(MIRRORING, WARNING, "Communication with secondary failed.",
+            ("peer", rrArgs->node->getNodeIDWithTypeStr() ), ("seqNo", request.seqNo),
+            ("error", e.what() ), ("message type", rrArgs->requestMsg->getMsgTypeStr() ) );
+   }
+
+   mutex.lock();
+
+   if(sendSuccess)
+   {
+      conn.nextSendSeqNo = request.seqNo + 1;
+      conn.stateChangedCond.broadcast();
+
+      return FhgfsOpsErr_SUCCESS;
+   }
+
+   // the stream of requests is interrupted => all requests in flight fail
+
+   breakSocket(conn);
+
+   return FhgfsOpsErr_COMMUNICATION;
+}
+
+/**
+ * Wait until the response to the request was received or the request failed. If no other waiter
+ * currently receives responses on the request's connection, the calling thread becomes the
+ * receiver.
+ *
+ * @param targetNode the node of request.rrArgs->node, to send the request again if the secondary
+ *    asks for a retry.
+ */
+FhgfsOpsErr MirrorForwardPipeline::waitForResponse(Request& request,
+   const NodeHandle& targetNode)
+{
+   std::lock_guard<Mutex> lock(mutex);
+
+   while(!request.isDone)
+   {
+      Conn& conn = *conns[request.connIndex];
+
+      if(request.needsResend)
+      {
+         bool mayRetry; // (no retry, the request was sent before)
+
+         request.needsResend = false;
+
+         transmitUnlocked(request, targetNode, mayRetry);
+         continue;
+      }
+
+      if(conn.receiverActive)
+      {
+         conn.stateChangedCond.wait(&mutex);
+         continue;
+      }
+
+      conn.receiverActive = true;
+
+      receiveResponses(conn, request);
+
+      conn.receiverActive = false;
+      conn.stateChangedCond.broadcast();
+   }
+
+   return request.result;
+}
+
+/**
+ * Receive responses (in request order) until the response of ownRequest arrived, ownRequest must
+ * be sent again or the connection broke.
+ *
+ * Note: Caller must hold mutex and set conn.receiverActive; the mutex is unlocked while
+ * receiving.
+ */
+void MirrorForwardPipeline::receiveResponses(Conn& conn, Request& ownRequest)
+{
+   auto netMessageFactory = PThread::getCurrentThreadApp()->getNetMessageFactory();
+
+   Socket* recvSock = conn.sock; // (can't change while we are the receiver)
+
+   while(!ownRequest.isDone && !ownRequest.needsResend)
+   {
+      Request* request = conn.inFlight.front(); // (sent, because ownRequest was sent after it)
+      const int minTimeoutMS = request->rrArgs->minTimeoutMS;
+      std::unique_ptr<NetMessage> respMsg;
+
+      mutex.unlock();
+
+      try
+      {
+         auto respBuf = MessagingTk::recvMsgBuf(*recvSock, minTimeoutMS);
+         if(!respBuf.empty() )
+            respMsg = netMessageFactory->createFromBuf(std::move(respBuf) );
+      }
+      catch(const std::bad_alloc& e)
+      {
+         LOG(MIRRORING, ERR, "Memory allocation for receive buffer failed.");
+      }
+      catch(SocketException& e)
+      {
+         LOG(MIRRORING, WARNING, "Communication with secondary failed.",
+               ("peer", recvSock->getPeername() ), ("error", e.what() ) );
+      }
+
+      mutex.lock();
+
+      if(conn.sockBroken)
+         return; // request was failed by the sender that broke the connection
+
+      if(!respMsg ||
+         ( (respMsg->getMsgType() != request->rrArgs->respMsgType) &&
+           (respMsg->getMsgType() != NETMSGTYPE_GenericResponse) ) )
+      {
+         const std::string respTypeStr = respMsg ? respMsg->getMsgTypeStr() : "none";
+
+         LOG(MIRRORING, ERR, "Failed to receive response from secondary. Disconnecting.",
+               ("peer", recvSock->getPeername() ), ("seqNo", request->seqNo),
+               ("message type", request->rrArgs->requestMsg->getMsgTypeStr() ),
+               ("response type", respTypeStr) );
+
+         breakSocket(conn);
+         return;
+      }
+
+      conn.inFlight.pop_front();
+      conn.doneSeqNo = request->seqNo;
+
+      if(respMsg->getMsgType() == NETMSGTYPE_GenericResponse)
+      {
+         auto& genericResp = static_cast<GenericResponseMsg&>(*respMsg);
+
+         if( (genericResp.getControlCode() == GenericRespMsgCode_TRYAGAIN) &&
+            !request->hasDependents && (request->numRetries < MIRRORFORWARDPIPELINE_MAX_RETRIES) )
+         { // no later request on the same entries was sent yet => the order is still intact
+            LOG(MIRRORING, DEBUG, "Secondary asked to retry forwarded request.",
+                  ("seqNo", request->seqNo), ("reason", genericResp.getLogStr() ),
+                  ("message type", request->rrArgs->requestMsg->getMsgTypeStr() ) );
+
+            requeueUnlocked(conn, *request);
+         }
+         else
+         {
+            LOG(MIRRORING, NOTICE, "Secondary did not process forwarded request.",
+                  ("seqNo", request->seqNo), ("reason", genericResp.getLogStr() ),
+                  ("retries", request->numRetries),
+                  ("message type", request->rrArgs->requestMsg->getMsgTypeStr() ) );
+
+            request->result = FhgfsOpsErr_COMMUNICATION;
+            request->isDone = true;
+         }
+      }
+      else
+      {
+         request->rrArgs->outRespMsg = std::move(respMsg);
+         request->result = FhgfsOpsErr_SUCCESS;
+         request->isDone = true;
+      }
+
+      requestsDoneUnlocked();
+
+      // wake up the waiters of all responses that arrived together before we block again
+      if(request->needsResend || !isResponsePending(recvSock) )
+         conn.stateChangedCond.broadcast();
+   }
+}
+
+/**
+ * Assign the request to a connection and a position in its stream of requests. Waits while the
+ * earlier requests on the same entries are in flight on different connections or while the
+ * connection is full.
+ *
+ * Note: Caller must hold mutex.
+ */
+void MirrorForwardPipeline::enqueueUnlocked(Request& request)
+{
+   for( ; ; )
+   {
+      int depConnIndex = -1;
+      bool multipleDepConns = false;
+
+      for(uint32_t hash : *request.lockHashes)
+      {
+         const Slot& slot = slots[hash % MIRRORFORWARDPIPELINE_NUM_SLOTS];
+
+         if(!isSlotPendingUnlocked(slot) )
+            continue;
+
+         if(depConnIndex == -1)
+            depConnIndex = slot.connIndex;
+         else
+         if(depConnIndex != (int)slot.connIndex)
+            multipleDepConns = true;
+      }
+
+      if(multipleDepConns)
+      {
+         numDependencyWaiters++;
+         requestDoneCond.wait(&mutex);
+         numDependencyWaiters--;
+
+         continue;
+      }
+
+      unsigned connIndex = depConnIndex;
+
+      if(depConnIndex == -1)
+      { // no dependencies => least loaded conn
+         connIndex = nextConnIndex++ % conns.size();
+
+         for(unsigned i = 1; i < conns.size(); i++)
+         {
+            const unsigned currentIndex = (connIndex + i) % conns.size();
+
+            if(conns[currentIndex]->inFlight.size() < conns[connIndex]->inFlight.size() )
+               connIndex = currentIndex;
+         }
+      }
+
+      Conn& conn = *conns[connIndex];
+
+      if(conn.inFlight.size() >= maxInFlight)
+      {
+         conn.stateChangedCond.wait(&mutex);
+         continue;
+      }
+
+      request.connIndex = connIndex;
+      request.seqNo = conn.nextSeqNo++;
+      request.isDone = false;
+      request.needsResend = false;
+      request.hasDependents = false;
+
+      conn.inFlight.push_back(&request);
+
+      for(uint32_t hash : *request.lockHashes)
+      {
+         Slot& slot = slots[hash % MIRRORFORWARDPIPELINE_NUM_SLOTS];
+
+         if(isSlotPendingUnlocked(slot) && (slot.seqNo != request.seqNo) )
+         {
+            Request* depRequest = findInFlightUnlocked(conn, slot.seqNo);
+            if(depRequest)
+               depRequest->hasDependents = true;
+         }
+
+         slot.connIndex = connIndex;
+         slot.seqNo = request.seqNo;
+      }
+
+      return;
+   }
+}
+
+/**
+ * Append a request that the secondary asked to retry to the end of its connection again; its
+ * waiter will send it.
+ *
+ * Note: Caller must hold mutex; the request must not be in conn.inFlight anymore.
+ */
+void MirrorForwardPipeline::requeueUnlocked(Conn& conn, Request& request)
+{
+   const uint64_t oldSeqNo = request.seqNo;
+
+   request.seqNo = conn.nextSeqNo++;
+   request.numRetries++;
+   request.needsResend = true;
+
+   conn.inFlight.push_back(&request);
+
+   // (the slots of the request still point to it, because it has no dependents)
+   for(uint32_t hash : *request.lockHashes)
+   {
+      Slot& slot = slots[hash % MIRRORFORWARDPIPELINE_NUM_SLOTS];
+
+      if( (slot.connIndex == request.connIndex) && (slot.seqNo == oldSeqNo) )
+         slot.seqNo = request.seqNo;
+   }
+}
+
+/**
+ * Note: Caller must hold mutex.
+ */
+void MirrorForwardPipeline::requestsDoneUnlocked()
+{
+   if(numDependencyWaiters)
+      requestDoneCond.broadcast();
+}
+
+/**
+ * Fail all requests of the connection (including the ones that were not sent yet).
+ *
+ * Note: Caller must hold mutex.
+ */
+void MirrorForwardPipeline::failRequestsUnlocked(Conn& conn, FhgfsOpsErr result)
+{
+   for(Request* request : conn.inFlight)
+   {
+      request->result = result;
+      request->isDone = true;
+   }
+
+   conn.inFlight.clear();
+
+   conn.doneSeqNo = conn.nextSeqNo - 1;
+   conn.nextSendSeqNo = conn.nextSeqNo;
+
+   requestsDoneUnlocked();
+   conn.stateChangedCond.broadcast();
+}
+
+/**
+ * Note: Caller must hold mutex.
+ *
+ * @return NULL if the request is not in flight on the conn anymore.
+ */
+MirrorForwardPipeline::Request* MirrorForwardPipeline::findInFlightUnlocked(Conn& conn,
+   uint64_t seqNo)
+{
+   // seqNos in inFlight are consecutive (requests leave it only from the front or all together)
+   if(conn.inFlight.empty() || (seqNo < conn.inFlight.front()->seqNo) )
+      return NULL;
+
+   const uint64_t index = seqNo - conn.inFlight.front()->seqNo;
+
+   if( (index >= conn.inFlight.size() ) || (conn.inFlight[index]->seqNo != seqNo) )
+      return NULL;
+
+   return conn.inFlight[index];
+}
+
+/**
+ * Fail all requests of the connection; the socket will be closed by the next sender.
+ *
+ * Note: Caller must hold mutex.
+ */
+void MirrorForwardPipeline::breakSocket(Conn& conn)
+{
+   if(!conn.sockBroken)
+   {
+      conn.sockBroken = true;
+
+      try
+      {
+         conn.sock->shutdown(); // (so that the secondary disconnects and a receiver returns)
+      }
+      catch(SocketException& e)
+      {
+         // nothing we can do here, the receiver will run into the socket timeout in the worst case
+      }
+   }
+
+   failRequestsUnlocked(conn, FhgfsOpsErr_COMMUNICATION);
+}
+
+/**
+ * Note: Caller must hold mutex; there must be no receiver and nothing in flight on the socket.
+ */
+void MirrorForwardPipeline::closeSocket(Conn& conn)
+{
+   NodeConnPool* connPool = conn.node->getConnPool();
+
+   if(conn.sockBroken)
+      connPool->invalidateStreamSocket(conn.sock);
+   else
+      connPool->releaseStreamSocket(conn.sock);
+
+   conn.sock = NULL;
+   conn.sockBroken = false;
+   conn.node.reset();
+}
+
+/**
+ * @return true if (the beginning of) the next response can be received without waiting.
+ */
+bool MirrorForwardPipeline::isResponsePending(Socket* sock)
+{
+   struct pollfd pollFD;
+
+   pollFD.fd = sock->getFD();
+   pollFD.events = POLLIN;
+   pollFD.revents = 0;
+
+   return (poll(&pollFD, 1, 0) > 0);
+}
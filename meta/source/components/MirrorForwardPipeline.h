@@ -0,0 +1,128 @@
+#pragma once
+
+#include <common/net/sock/Socket.h>
+#include <common/nodes/Node.h>
+#include <common/storage/StorageErrors.h>
+#include <common/threading/Condition.h>
+#include <common/threading/Mutex.h>
+#include <common/toolkit/MessagingTkArgs.h>
+#include <common/Common.h>
+
+#include <deque>
+#include <functional>
+#include <memory>
+
+
+#define MIRRORFORWARDPIPELINE_NUM_SLOTS     65536 // for the lock hashes of forwarded requests
+#define MIRRORFORWARDPIPELINE_MAX_RETRIES   100 // of a request that the secondary asked to retry
+
+
+/**
+ * Forwards mirrored operations from the primary to the secondary of the local meta buddy group
+ * over a few persistent connections, without waiting for the response of one operation before
+ * the next one is sent.
+ *
+ * The secondary processes the requests of a connection strictly one after another, but the
+ * requests of different connections in parallel. The hashes of the EntryLockStore locks that the
+ * caller holds (see EntryLockStore::LockHashRecorder) decide the connection: an operation is sent
+ * over the connection of all earlier operations on the same entries that are still in flight, so
+ * that it is applied on the secondary after them. (If these are in flight on different
+ * connections, it waits until only one of them is left.) Operations without such dependencies go
+ * to the connection with the fewest requests in flight. This allows the caller to release its
+ * locks as soon as the request was sent (see sentCallback of forward() ) instead of holding them
+ * for a full round trip to the secondary.
+ *
+ * Responses of a connection arrive in request order. There is no dedicated receiver thread: one
+ * of the callers that wait for a response on a connection receives the responses for all requests
+ * in flight on it and wakes up the waiters of all responses that arrived together.
+ *
+ * If the secondary asks to retry a request (GenericResponse TRYAGAIN), the request is sent again
+ * at the end of its connection, unless a later operation on the same entries was already sent
+ * after it; it fails in that case, because the secondary has applied the operations in a
+ * different order than the primary.
+ */
+class MirrorForwardPipeline
+{
+   friend class TestMirrorForwardPipeline;
+
+   public:
+      MirrorForwardPipeline(unsigned numConns, unsigned maxInFlight);
+      ~MirrorForwardPipeline();
+
+      FhgfsOpsErr forward(RequestResponseNode* rrNode, RequestResponseArgs* rrArgs,
+         const std::vector<uint32_t>& lockHashes, const std::function<void()>& sentCallback);
+
+
+   private:
+      struct Request
+      {
+         RequestResponseArgs* rrArgs;
+         const std::vector<uint32_t>* lockHashes;
+         unsigned connIndex;
+         uint64_t seqNo; // position in the stream of requests of the conn
+         bool isDone;
+         bool needsResend; // secondary asked to retry, request was appended to the conn again
+         bool hasDependents; // a later request on the same entries must be processed after it
+         unsigned numRetries;
+         FhgfsOpsErr result;
+      };
+
+      struct Conn
+      {
+         Conn() : sock(NULL), sockBroken(false), receiverActive(false), nextSeqNo(1),
+            nextSendSeqNo(1), doneSeqNo(0) {}
+
+         Condition stateChangedCond; // requests done or sent, receiver gone or socket closed
+
+         NodeHandle node; // the secondary that sock belongs to
+         Socket* sock; // NULL if not connected
+         bool sockBroken; // all requests on sock failed; close it when there is no receiver anymore
+         bool receiverActive; // one of the waiters currently receives the responses
+         uint64_t nextSeqNo; // for the next request
+         uint64_t nextSendSeqNo; // requests are sent in the order of their seqNo
+         uint64_t doneSeqNo; // all requests up to this seqNo are done
+         std::deque<Request*> inFlight; // in order of seqNo (including requests not sent yet)
+      };
+
+      struct Slot
+      {
+         unsigned connIndex;
+         uint64_t seqNo; // of the last request that held a lock with this hash; 0 if none
+      };
+
+      unsigned maxInFlight; // per conn
+
+      Mutex mutex; // protects all fields below
+      Condition requestDoneCond; // signaled for numDependencyWaiters
+      unsigned numDependencyWaiters; // wait for the requests of their entries on other conns
+      bool isDisabled; // connection doesn't support pipelining => forward synchronously
+      unsigned nextConnIndex; // to spread requests without dependencies
+
+      std::vector<std::unique_ptr<Conn>> conns;
+      std::vector<Slot> slots; // by lock hash
+
+      FhgfsOpsErr sendRequest(Request& request, const NodeHandle& targetNode,
+         bool& outMayRetry);
+      FhgfsOpsErr transmitUnlocked(Request& request, const NodeHandle& targetNode,
+         bool& outMayRetry);
+      FhgfsOpsErr waitForResponse(Request& request, const NodeHandle& targetNode);
+      void receiveResponses(Conn& conn, Request& ownRequest);
+
+      void enqueueUnlocked(Request& request);
+      void requeueUnlocked(Conn& conn, Request& request);
+      void requestsDoneUnlocked();
+      void failRequestsUnlocked(Conn& conn, FhgfsOpsErr result);
+      Request* findInFlightUnlocked(Conn& conn, uint64_t seqNo);
+
+      void breakSocket(Conn& conn);
+      void closeSocket(Conn& conn);
+      bool isResponsePending(Socket* sock);
+
+      /**
+       * @return true if the slot belongs to a request that is not done yet.
+       */
+      bool isSlotPendingUnlocked(const Slot& slot) const
+      {
+         return slot.seqNo && (slot.seqNo > conns[slot.connIndex]->doneSeqNo);
+      }
+};
@@ -108,6 +108,9 @@ void BuddyResyncJob::run()
       }
       internodeSyncer->setResyncInProgress(true);
 
+      // the slaves sync inodes from disk (no more deferred updates now that resync is in progress)
+      Program::getApp()->getMetaStore()->flushDirtyInodes(true, true);
+
       const bool startGatherSlaveRes = startGatherSlaves();
       if (!startGatherSlaveRes)
       {
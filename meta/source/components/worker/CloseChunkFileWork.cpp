@@ -20,41 +20,62 @@ void CloseChunkFileWork::process(char* bufIn, unsigned bufInLen, char* bufOut, u
 
 FhgfsOpsErr CloseChunkFileWork::communicate()
 {
-   const char* logContext = "Close chunk file work";
+   prepareRequest();
+
+   FhgfsOpsErr requestRes = MessagingTk::requestResponseTarget(rrTarget.get(), rrArgs.get() );
+
+   return processResponse(requestRes);
+}
+
+void CloseChunkFileWork::submit(RequestResponseFanOut& fanOut)
+{
+   prepareRequest();
+
+   fanOut.add(rrTarget.get(), rrArgs.get(),
+      [this] (FhgfsOpsErr requestRes)
+      {
+         *outResult = processResponse(requestRes);
+         counter->incCount();
+      });
+}
 
+void CloseChunkFileWork::prepareRequest()
+{
    App* app = Program::getApp();
 
    // prepare request message
 
-   CloseChunkFileMsg closeMsg(sessionID, fileHandleID, targetID, pathInfoPtr);
+   requestMsg.reset(new CloseChunkFileMsg(sessionID, fileHandleID, targetID, pathInfoPtr) );
 
    if(pattern->getPatternType() == StripePatternType_BuddyMirror)
    {
-      closeMsg.addMsgHeaderFeatureFlag(CLOSECHUNKFILEMSG_FLAG_BUDDYMIRROR);
+      requestMsg->addMsgHeaderFeatureFlag(CLOSECHUNKFILEMSG_FLAG_BUDDYMIRROR);
 
       if(useBuddyMirrorSecond)
       {
-         closeMsg.addMsgHeaderFeatureFlag(CLOSECHUNKFILEMSG_FLAG_NODYNAMICATTRIBS);
-         closeMsg.addMsgHeaderFeatureFlag(CLOSECHUNKFILEMSG_FLAG_BUDDYMIRROR_SECOND);
+         requestMsg->addMsgHeaderFeatureFlag(CLOSECHUNKFILEMSG_FLAG_NODYNAMICATTRIBS);
+         requestMsg->addMsgHeaderFeatureFlag(CLOSECHUNKFILEMSG_FLAG_BUDDYMIRROR_SECOND);
       }
    }
 
-   closeMsg.setMsgHeaderUserID(msgUserID);
+   requestMsg->setMsgHeaderUserID(msgUserID);
 
    // prepare communication
 
-   RequestResponseTarget rrTarget(targetID, app->getTargetMapper(), app->getStorageNodes() );
+   rrTarget.reset(new RequestResponseTarget(targetID, app->getTargetMapper(),
+      app->getStorageNodes() ) );
 
-   rrTarget.setTargetStates(app->getTargetStateStore() );
+   rrTarget->setTargetStates(app->getTargetStateStore() );
 
    if(pattern->getPatternType() == StripePatternType_BuddyMirror)
-      rrTarget.setMirrorInfo(app->getStorageBuddyGroupMapper(), useBuddyMirrorSecond);
-
-   RequestResponseArgs rrArgs(NULL, &closeMsg, NETMSGTYPE_CloseChunkFileResp);
+      rrTarget->setMirrorInfo(app->getStorageBuddyGroupMapper(), useBuddyMirrorSecond);
 
-   // communicate
+   rrArgs.reset(new RequestResponseArgs(NULL, requestMsg.get(), NETMSGTYPE_CloseChunkFileResp) );
+}
 
-   FhgfsOpsErr requestRes = MessagingTk::requestResponseTarget(&rrTarget, &rrArgs);
+FhgfsOpsErr CloseChunkFileWork::processResponse(FhgfsOpsErr requestRes)
+{
+   const char* logContext = "Close chunk file work";
 
    if(unlikely(requestRes != FhgfsOpsErr_SUCCESS) )
    {
@@ -69,7 +90,7 @@ FhgfsOpsErr CloseChunkFileWork::communicate()
    }
 
    // correct response type received
-   CloseChunkFileRespMsg* closeRespMsg = (CloseChunkFileRespMsg*)rrArgs.outRespMsg.get();
+   CloseChunkFileRespMsg* closeRespMsg = (CloseChunkFileRespMsg*)rrArgs->outRespMsg.get();
 
    FhgfsOpsErr closeRemoteRes = closeRespMsg->getResult();
 
@@ -1,15 +1,16 @@
 #pragma once
 
-#include <common/components/worker/Work.h>
+#include <common/net/message/session/opening/CloseChunkFileMsg.h>
 #include <common/net/sock/Socket.h>
 #include <common/storage/striping/StripePattern.h>
 #include <common/storage/StorageErrors.h>
 #include <common/toolkit/SynchronizedCounter.h>
 #include <common/storage/striping/ChunkFileInfo.h>
 #include <common/Common.h>
+#include "FanOutWork.h"
 
 
-class CloseChunkFileWork : public Work
+class CloseChunkFileWork : public FanOutWork
 {
    public:
       /**
@@ -31,6 +32,8 @@ class CloseChunkFileWork : public Work
 
       virtual void process(char* bufIn, unsigned bufInLen, char* bufOut, unsigned bufOutLen);
 
+      virtual void submit(RequestResponseFanOut& fanOut);
+
 
    private:
       NumNodeID sessionID;
@@ -49,7 +52,13 @@ class CloseChunkFileWork : public Work
       unsigned msgUserID;
 
 
+      std::unique_ptr<CloseChunkFileMsg> requestMsg;
+      std::unique_ptr<RequestResponseTarget> rrTarget;
+      std::unique_ptr<RequestResponseArgs> rrArgs;
+
       FhgfsOpsErr communicate();
+      void prepareRequest();
+      FhgfsOpsErr processResponse(FhgfsOpsErr requestRes);
 
 
    public:
@@ -0,0 +1,43 @@
+#include <program/Program.h>
+#include "FanOutWork.h"
+
+
+FanOutWorkDispatcher::FanOutWorkDispatcher() :
+   slaveQueue(NULL)
+{
+   App* app = Program::getApp();
+
+   if(app->getConfig()->getTuneUseRequestFanOut() )
+      fanOut.reset(new RequestResponseFanOut() );
+   else
+      slaveQueue = app->getCommSlaveQueue();
+}
+
+/**
+ * @param work will be owned by this object or the comm slave queue.
+ */
+void FanOutWorkDispatcher::add(FanOutWork* work)
+{
+   if(slaveQueue)
+   {
+      slaveQueue->addDirectWork(work);
+      return;
+   }
+
+   fanOutWorks.push_back(std::unique_ptr<FanOutWork>(work) );
+   work->submit(*fanOut);
+}
+
+/**
+ * Completes the requests of the works that were submitted to the fan-out (no-op if the comm
+ * slaves are used).
+ */
+void FanOutWorkDispatcher::waitAll()
+{
+   if(!fanOut)
+      return;
+
+   fanOut->waitAll();
+   fanOutWorks.clear();
+}
+
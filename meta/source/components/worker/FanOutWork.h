@@ -0,0 +1,48 @@
+#pragma once
+
+#include <common/components/worker/queue/MultiWorkQueue.h>
+#include <common/components/worker/Work.h>
+#include <common/toolkit/RequestResponseFanOut.h>
+#include <common/Common.h>
+
+#include <memory>
+
+
+/**
+ * A work with a single storage server request, which can either be processed by a comm slave or
+ * be submitted to a RequestResponseFanOut by the thread that created it.
+ */
+class FanOutWork : public Work
+{
+   public:
+      /**
+       * Send the request through the given fan-out instead of processing this work in a comm
+       * slave. Results are set and the counter of the work is incremented when the fan-out
+       * completed the request.
+       */
+      virtual void submit(RequestResponseFanOut& fanOut) = 0;
+};
+
+
+/**
+ * Runs the FanOutWorks of an operation either in the comm slaves or (if tuneUseRequestFanOut is
+ * set) through a RequestResponseFanOut from the calling thread, so that a worker doesn't need a
+ * comm slave for each storage target that it talks to.
+ *
+ * Note: Callers must call waitAll() before they wait for the counters of the works.
+ */
+class FanOutWorkDispatcher
+{
+   public:
+      FanOutWorkDispatcher();
+
+      void add(FanOutWork* work);
+      void waitAll();
+
+
+   private:
+      MultiWorkQueue* slaveQueue; // NULL if fanOut is used
+      std::unique_ptr<RequestResponseFanOut> fanOut;
+      std::vector<std::unique_ptr<FanOutWork> > fanOutWorks; // submitted to fanOut
+};
+
@@ -0,0 +1,107 @@
+#include <common/app/log/LogContext.h>
+#include <common/net/message/storage/attribs/GetChunkFileAttribsBatchMsg.h>
+#include <common/net/message/storage/attribs/GetChunkFileAttribsBatchRespMsg.h>
+#include <common/net/message/NetMessage.h>
+#include <program/Program.h>
+#include "GetChunkFileAttribsBatchWork.h"
+
+void GetChunkFileAttribsBatchWork::process(char* bufIn, unsigned bufInLen, char* bufOut,
+   unsigned bufOutLen)
+{
+   FhgfsOpsErr commRes = communicate();
+
+   for(size_t i = 0; i < batch->entries.size(); i++)
+   {
+      if(commRes != FhgfsOpsErr_SUCCESS)
+         *batch->outResults[i] = commRes;
+
+      batch->counters[i]->incCount();
+   }
+}
+
+/**
+ * Sets the per-entry results and dyn attribs on success.
+ *
+ * @return FhgfsOpsErr_SUCCESS if communication successful
+ */
+FhgfsOpsErr GetChunkFileAttribsBatchWork::communicate()
+{
+   const char* logContext = "Stat chunk files batch work";
+
+   App* app = Program::getApp();
+
+   const uint16_t targetID = batch->targetID;
+
+   GetChunkFileAttribsBatchMsg getAttribsMsg(targetID, &batch->entries);
+
+   if(batch->isBuddyMirror)
+      getAttribsMsg.addMsgHeaderFeatureFlag(GETCHUNKFILEATTRSBATCHMSG_FLAG_BUDDYMIRROR);
+
+   getAttribsMsg.setMsgHeaderUserID(batch->msgUserID);
+
+   // prepare communication
+
+   RequestResponseTarget rrTarget(targetID, app->getTargetMapper(), app->getStorageNodes() );
+
+   rrTarget.setTargetStates(app->getTargetStateStore() );
+
+   if(batch->isBuddyMirror)
+      rrTarget.setMirrorInfo(app->getStorageBuddyGroupMapper(), false);
+
+   RequestResponseArgs rrArgs(NULL, &getAttribsMsg, NETMSGTYPE_GetChunkFileAttribsBatchResp);
+
+   // communicate
+
+   FhgfsOpsErr requestRes = MessagingTk::requestResponseTarget(&rrTarget, &rrArgs);
+
+   if(unlikely(requestRes != FhgfsOpsErr_SUCCESS) )
+   { // communication error
+      LogContext(logContext).log(Log_WARNING,
+         "Communication with storage target failed. " +
+         std::string(batch->isBuddyMirror ? "Mirror " : "") +
+         "TargetID: " + StringTk::uintToStr(targetID) + "; "
+         "Number of entries: " + StringTk::uintToStr(batch->entries.size() ) );
+
+      return requestRes;
+   }
+
+   // correct response type received
+   auto* getAttribsRespMsg = (GetChunkFileAttribsBatchRespMsg*)rrArgs.outRespMsg.get();
+
+   GetChunkFileAttribsBatchRespMsg::EntryVec& respEntries = getAttribsRespMsg->getEntries();
+
+   if(unlikely(respEntries.size() != batch->entries.size() ) )
+   {
+      LogContext(logContext).logErr(
+         "Unexpected number of entries in response. " +
+         std::string(batch->isBuddyMirror ? "Mirror " : "") +
+         "TargetID: " + StringTk::uintToStr(targetID) + "; "
+         "Expected: " + StringTk::uintToStr(batch->entries.size() ) + "; "
+         "Received: " + StringTk::uintToStr(respEntries.size() ) );
+
+      return FhgfsOpsErr_COMMUNICATION;
+   }
+
+   for(size_t i = 0; i < respEntries.size(); i++)
+   {
+      FhgfsOpsErr getAttribsResult = (FhgfsOpsErr)respEntries[i].result;
+
+      *batch->outResults[i] = getAttribsResult;
+
+      if(getAttribsResult != FhgfsOpsErr_SUCCESS)
+      {
+         LogContext(logContext).log(Log_WARNING,
+            "Getting chunk file attributes from target failed. " +
+            std::string(batch->isBuddyMirror ? "Mirror " : "") +
+            "TargetID: " + StringTk::uintToStr(targetID) + "; "
+            "EntryID: " + batch->entries[i].entryID);
+
+         continue;
+      }
+
+      *batch->outDynAttribs[i] = respEntries[i].attribs;
+   }
+
+   return FhgfsOpsErr_SUCCESS;
+}
+
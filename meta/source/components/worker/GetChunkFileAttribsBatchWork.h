@@ -0,0 +1,37 @@
+#pragma once
+
+#include <common/components/worker/Work.h>
+#include <common/Common.h>
+#include "GetChunkFileAttribsBatcher.h"
+
+#include <memory>
+
+
+/**
+ * Sends a batch of GetChunkFileAttribsBatcher to its storage target and hands out the results.
+ */
+class GetChunkFileAttribsBatchWork : public Work
+{
+   public:
+      /**
+       * @param batch a closed batch, will be owned by this object
+       */
+      GetChunkFileAttribsBatchWork(GetChunkFileAttribsBatcher::Batch* batch) : batch(batch)
+      {
+         // all assignments done in initializer list
+      }
+
+      virtual ~GetChunkFileAttribsBatchWork()
+      {
+      }
+
+
+      virtual void process(char* bufIn, unsigned bufInLen, char* bufOut, unsigned bufOutLen);
+
+
+   private:
+      std::unique_ptr<GetChunkFileAttribsBatcher::Batch> batch;
+
+      FhgfsOpsErr communicate();
+};
+
@@ -0,0 +1,125 @@
+#include "GetChunkFileAttribsBatcher.h"
+#include "GetChunkFileAttribsBatchWork.h"
+
+#include <mutex>
+#include <thread>
+
+
+GetChunkFileAttribsBatcher::GetChunkFileAttribsBatcher(MultiWorkQueue* slaveQueue,
+   unsigned maxBatchSize, unsigned windowUS) :
+   slaveQueue(slaveQueue),
+   maxBatchSize(std::min(maxBatchSize, (unsigned)GETCHUNKFILEATTRSBATCHMSG_MAX_ENTRIES) ),
+   window(windowUS),
+   lastSeqNum(0)
+{
+}
+
+/**
+ * Add a request to the open batch of the given target (or open a new batch). The result is
+ * stored in outDynAttribs and outResult, afterwards counter is incremented.
+ *
+ * @param outOpenedBatches a newly opened batch is appended; the caller must pass them to
+ *    sendOpenedBatches() after it added all its requests.
+ */
+void GetChunkFileAttribsBatcher::add(uint16_t targetID, bool isBuddyMirror,
+   const std::string& entryID, const PathInfo& pathInfo, DynamicFileAttribs* outDynAttribs,
+   FhgfsOpsErr* outResult, SynchronizedCounter* counter, unsigned msgUserID,
+   OpenedBatchVec& outOpenedBatches)
+{
+   const BatchKey key(targetID, isBuddyMirror);
+   Batch* fullBatch = NULL;
+
+   {
+      std::lock_guard<Mutex> lock(mutex);
+
+      Batch*& batch = openBatches[key];
+
+      if(!batch)
+      {
+         batch = new Batch();
+
+         batch->targetID = targetID;
+         batch->isBuddyMirror = isBuddyMirror;
+         batch->seqNum = ++lastSeqNum;
+         batch->msgUserID = msgUserID;
+         batch->startTime = std::chrono::steady_clock::now();
+
+         outOpenedBatches.push_back({key, batch->seqNum});
+      }
+
+      GetChunkFileAttribsBatchMsg::Entry entry = { entryID, pathInfo };
+
+      batch->entries.push_back(entry);
+      batch->outDynAttribs.push_back(outDynAttribs);
+      batch->outResults.push_back(outResult);
+      batch->counters.push_back(counter);
+
+      if(batch->entries.size() >= maxBatchSize)
+      { // full => send it right away
+         fullBatch = batch;
+         openBatches.erase(key);
+      }
+   }
+
+   if(fullBatch)
+      slaveQueue->addDirectWork(new GetChunkFileAttribsBatchWork(fullBatch) );
+}
+
+/**
+ * Waits for the rest of the batch window of the given batches (unless they are all full already)
+ * and then closes and sends those that are still open.
+ */
+void GetChunkFileAttribsBatcher::sendOpenedBatches(const OpenedBatchVec& openedBatches)
+{
+   std::chrono::steady_clock::time_point deadline;
+   bool anyOpen = false;
+
+   {
+      std::lock_guard<Mutex> lock(mutex);
+
+      for(auto iter = openedBatches.begin(); iter != openedBatches.end(); iter++)
+      {
+         if(!isOpen(*iter) )
+            continue;
+
+         // (all opened by the same request, so the last one has the latest deadline)
+         deadline = openBatches[iter->first]->startTime + window;
+         anyOpen = true;
+      }
+   }
+
+   if(!anyOpen)
+      return;
+
+   std::this_thread::sleep_until(deadline);
+
+   std::vector<Batch*> closedBatches;
+
+   {
+      std::lock_guard<Mutex> lock(mutex);
+
+      for(auto iter = openedBatches.begin(); iter != openedBatches.end(); iter++)
+      {
+         if(!isOpen(*iter) )
+            continue; // filled up and sent in the meantime
+
+         closedBatches.push_back(openBatches[iter->first]);
+         openBatches.erase(iter->first);
+      }
+   }
+
+   for(auto iter = closedBatches.begin(); iter != closedBatches.end(); iter++)
+      slaveQueue->addDirectWork(new GetChunkFileAttribsBatchWork(*iter) );
+}
+
+/**
+ * Note: caller must hold the mutex.
+ *
+ * @return true if the given batch was not closed yet.
+ */
+bool GetChunkFileAttribsBatcher::isOpen(const OpenedBatchVec::value_type& openedBatch)
+{
+   BatchMap::const_iterator iter = openBatches.find(openedBatch.first);
+
+   return (iter != openBatches.end() ) && (iter->second->seqNum == openedBatch.second);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <common/components/worker/queue/MultiWorkQueue.h>
+#include <common/net/message/storage/attribs/GetChunkFileAttribsBatchMsg.h>
+#include <common/storage/striping/DynamicFileAttribs.h>
+#include <common/storage/StorageErrors.h>
+#include <common/threading/Mutex.h>
+#include <common/toolkit/SynchronizedCounter.h>
+#include <common/Common.h>
+
+#include <chrono>
+#include <map>
+#include <vector>
+
+
+/**
+ * Combines concurrent chunk attribs refreshes (see MsgHelperStat::refreshDynAttribsParallel() )
+ * for the same storage target into GetChunkFileAttribsBatchMsgs.
+ *
+ * The first request for a target opens a new batch. Further requests for the target are added to
+ * the open batch until it is full or until the batch window elapsed. Whoever closes a batch queues
+ * a GetChunkFileAttribsBatchWork for it to the comm slaves: the request that filled it or the
+ * request that opened it (in sendOpenedBatches() ). The batch window is spent by the opening
+ * request, which has to wait for its results anyway, so no comm slave waits for a batch.
+ */
+class GetChunkFileAttribsBatcher
+{
+   public:
+      typedef std::pair<uint16_t, bool> BatchKey; // targetID, isBuddyMirror
+      typedef std::vector<std::pair<BatchKey, uint64_t>> OpenedBatchVec; // key, seqNum
+
+      struct Batch
+      {
+         uint16_t targetID;
+         bool isBuddyMirror;
+         uint64_t seqNum; // to recognize the batch in openBatches
+         unsigned msgUserID; // of the first request, only used for msg header info
+         std::chrono::steady_clock::time_point startTime;
+
+         GetChunkFileAttribsBatchMsg::EntryVec entries;
+
+         // per entry
+         std::vector<DynamicFileAttribs*> outDynAttribs;
+         std::vector<FhgfsOpsErr*> outResults;
+         std::vector<SynchronizedCounter*> counters;
+      };
+
+      GetChunkFileAttribsBatcher(MultiWorkQueue* slaveQueue, unsigned maxBatchSize,
+         unsigned windowUS);
+
+      void add(uint16_t targetID, bool isBuddyMirror, const std::string& entryID,
+         const PathInfo& pathInfo, DynamicFileAttribs* outDynAttribs, FhgfsOpsErr* outResult,
+         SynchronizedCounter* counter, unsigned msgUserID, OpenedBatchVec& outOpenedBatches);
+      void sendOpenedBatches(const OpenedBatchVec& openedBatches);
+
+
+   private:
+      typedef std::map<BatchKey, Batch*> BatchMap;
+
+      MultiWorkQueue* slaveQueue;
+      size_t maxBatchSize;
+      std::chrono::microseconds window;
+
+      Mutex mutex;
+      BatchMap openBatches; // owned by the batcher until they are closed
+      uint64_t lastSeqNum;
+
+      bool isOpen(const OpenedBatchVec::value_type& openedBatch);
+};
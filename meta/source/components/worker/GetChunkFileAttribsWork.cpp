@@ -21,36 +21,58 @@ void GetChunkFileAttribsWork::process(char* bufIn, unsigned bufInLen, char* bufO
  */
 FhgfsOpsErr GetChunkFileAttribsWork::communicate()
 {
-   const char* logContext = "Stat chunk file work";
+   prepareRequest();
+
+   FhgfsOpsErr requestRes = MessagingTk::requestResponseTarget(rrTarget.get(), rrArgs.get() );
+
+   return processResponse(requestRes);
+}
+
+void GetChunkFileAttribsWork::submit(RequestResponseFanOut& fanOut)
+{
+   prepareRequest();
+
+   fanOut.add(rrTarget.get(), rrArgs.get(),
+      [this] (FhgfsOpsErr requestRes)
+      {
+         *outResult = processResponse(requestRes);
+         counter->incCount();
+      });
+}
 
+void GetChunkFileAttribsWork::prepareRequest()
+{
    App* app = Program::getApp();
 
-   GetChunkFileAttribsMsg getSizeMsg(entryID, targetID, pathInfo);
+   requestMsg.reset(new GetChunkFileAttribsMsg(entryID, targetID, pathInfo) );
 
    if(pattern->getPatternType() == StripePatternType_BuddyMirror)
    {
-      getSizeMsg.addMsgHeaderFeatureFlag(GETCHUNKFILEATTRSMSG_FLAG_BUDDYMIRROR);
+      requestMsg->addMsgHeaderFeatureFlag(GETCHUNKFILEATTRSMSG_FLAG_BUDDYMIRROR);
 
       if(useBuddyMirrorSecond)
-         getSizeMsg.addMsgHeaderFeatureFlag(GETCHUNKFILEATTRSMSG_FLAG_BUDDYMIRROR_SECOND);
+         requestMsg->addMsgHeaderFeatureFlag(GETCHUNKFILEATTRSMSG_FLAG_BUDDYMIRROR_SECOND);
    }
 
-   getSizeMsg.setMsgHeaderUserID(msgUserID);
+   requestMsg->setMsgHeaderUserID(msgUserID);
 
    // prepare communication
 
-   RequestResponseTarget rrTarget(targetID, app->getTargetMapper(), app->getStorageNodes() );
+   rrTarget.reset(new RequestResponseTarget(targetID, app->getTargetMapper(),
+      app->getStorageNodes() ) );
 
-   rrTarget.setTargetStates(app->getTargetStateStore() );
+   rrTarget->setTargetStates(app->getTargetStateStore() );
 
    if(pattern->getPatternType() == StripePatternType_BuddyMirror)
-      rrTarget.setMirrorInfo(app->getStorageBuddyGroupMapper(), useBuddyMirrorSecond);
-
-   RequestResponseArgs rrArgs(NULL, &getSizeMsg, NETMSGTYPE_GetChunkFileAttribsResp);
+      rrTarget->setMirrorInfo(app->getStorageBuddyGroupMapper(), useBuddyMirrorSecond);
 
-   // communicate
+   rrArgs.reset(new RequestResponseArgs(NULL, requestMsg.get(),
+      NETMSGTYPE_GetChunkFileAttribsResp) );
+}
 
-   FhgfsOpsErr requestRes = MessagingTk::requestResponseTarget(&rrTarget, &rrArgs);
+FhgfsOpsErr GetChunkFileAttribsWork::processResponse(FhgfsOpsErr requestRes)
+{
+   const char* logContext = "Stat chunk file work";
 
    if(unlikely(requestRes != FhgfsOpsErr_SUCCESS) )
    { // communication error
@@ -64,7 +86,7 @@ FhgfsOpsErr GetChunkFileAttribsWork::communicate()
    }
 
    // correct response type received
-   auto* getSizeRespMsg = (GetChunkFileAttribsRespMsg*)rrArgs.outRespMsg.get();
+   auto* getSizeRespMsg = (GetChunkFileAttribsRespMsg*)rrArgs->outRespMsg.get();
 
    FhgfsOpsErr getSizeResult = getSizeRespMsg->getResult();
    if(getSizeResult != FhgfsOpsErr_SUCCESS)
@@ -1,6 +1,6 @@
 #pragma once
 
-#include <common/components/worker/Work.h>
+#include <common/net/message/storage/attribs/GetChunkFileAttribsMsg.h>
 #include <common/net/sock/Socket.h>
 #include <common/storage/striping/StripePattern.h>
 #include <common/storage/PathInfo.h>
@@ -8,9 +8,10 @@
 #include <common/toolkit/SynchronizedCounter.h>
 #include <common/storage/striping/ChunkFileInfo.h>
 #include <common/Common.h>
+#include "FanOutWork.h"
 
 
-class GetChunkFileAttribsWork : public Work
+class GetChunkFileAttribsWork : public FanOutWork
 {
    public:
 
@@ -33,6 +34,8 @@ class GetChunkFileAttribsWork : public Work
 
       virtual void process(char* bufIn, unsigned bufInLen, char* bufOut, unsigned bufOutLen);
 
+      virtual void submit(RequestResponseFanOut& fanOut);
+
 
    private:
       std::string entryID;
@@ -47,7 +50,13 @@ class GetChunkFileAttribsWork : public Work
 
       unsigned msgUserID; // only used for msg header info
 
+      std::unique_ptr<GetChunkFileAttribsMsg> requestMsg;
+      std::unique_ptr<RequestResponseTarget> rrTarget;
+      std::unique_ptr<RequestResponseArgs> rrArgs;
+
       FhgfsOpsErr communicate();
+      void prepareRequest();
+      FhgfsOpsErr processResponse(FhgfsOpsErr requestRes);
 
    public:
       void setMsgUserID(unsigned msgUserID)
@@ -19,39 +19,61 @@ void SetChunkFileAttribsWork::process(char* bufIn, unsigned bufInLen, char* bufO
 
 FhgfsOpsErr SetChunkFileAttribsWork::communicate()
 {
-   const char* logContext = "Set chunk file attribs work";
+   prepareRequest();
+
+   FhgfsOpsErr requestRes = MessagingTk::requestResponseTarget(rrTarget.get(), rrArgs.get() );
+
+   return processResponse(requestRes);
+}
+
+void SetChunkFileAttribsWork::submit(RequestResponseFanOut& fanOut)
+{
+   prepareRequest();
+
+   fanOut.add(rrTarget.get(), rrArgs.get(),
+      [this] (FhgfsOpsErr requestRes)
+      {
+         *outResult = processResponse(requestRes);
+         counter->incCount();
+      });
+}
 
+void SetChunkFileAttribsWork::prepareRequest()
+{
    App* app = Program::getApp();
 
-   SetLocalAttrMsg setAttrMsg(entryID, targetID, pathInfo, validAttribs, attribs, enableCreation);
+   requestMsg.reset(new SetLocalAttrMsg(entryID, targetID, pathInfo, validAttribs, attribs,
+      enableCreation) );
 
    if(pattern->getPatternType() == StripePatternType_BuddyMirror)
    {
-      setAttrMsg.addMsgHeaderFeatureFlag(SETLOCALATTRMSG_FLAG_BUDDYMIRROR);
+      requestMsg->addMsgHeaderFeatureFlag(SETLOCALATTRMSG_FLAG_BUDDYMIRROR);
 
       if(useBuddyMirrorSecond)
-         setAttrMsg.addMsgHeaderFeatureFlag(SETLOCALATTRMSG_FLAG_BUDDYMIRROR_SECOND);
+         requestMsg->addMsgHeaderFeatureFlag(SETLOCALATTRMSG_FLAG_BUDDYMIRROR_SECOND);
    }
 
    if(quotaChown)
-      setAttrMsg.addMsgHeaderFeatureFlag(SETLOCALATTRMSG_FLAG_USE_QUOTA);
+      requestMsg->addMsgHeaderFeatureFlag(SETLOCALATTRMSG_FLAG_USE_QUOTA);
 
-   setAttrMsg.setMsgHeaderUserID(msgUserID);
+   requestMsg->setMsgHeaderUserID(msgUserID);
 
    // prepare communication
 
-   RequestResponseTarget rrTarget(targetID, app->getTargetMapper(), app->getStorageNodes() );
+   rrTarget.reset(new RequestResponseTarget(targetID, app->getTargetMapper(),
+      app->getStorageNodes() ) );
 
-   rrTarget.setTargetStates(app->getTargetStateStore() );
+   rrTarget->setTargetStates(app->getTargetStateStore() );
 
    if(pattern->getPatternType() == StripePatternType_BuddyMirror)
-      rrTarget.setMirrorInfo(app->getStorageBuddyGroupMapper(), useBuddyMirrorSecond);
-
-   RequestResponseArgs rrArgs(NULL, &setAttrMsg, NETMSGTYPE_SetLocalAttrResp);
+      rrTarget->setMirrorInfo(app->getStorageBuddyGroupMapper(), useBuddyMirrorSecond);
 
-   // communicate
+   rrArgs.reset(new RequestResponseArgs(NULL, requestMsg.get(), NETMSGTYPE_SetLocalAttrResp) );
+}
 
-   FhgfsOpsErr requestRes = MessagingTk::requestResponseTarget(&rrTarget, &rrArgs);
+FhgfsOpsErr SetChunkFileAttribsWork::processResponse(FhgfsOpsErr requestRes)
+{
+   const char* logContext = "Set chunk file attribs work";
 
    if(unlikely(requestRes != FhgfsOpsErr_SUCCESS) )
    { // communication error
@@ -65,7 +87,7 @@ FhgfsOpsErr SetChunkFileAttribsWork::communicate()
    }
 
    // correct response type received
-   const auto setRespMsg = (const SetLocalAttrRespMsg*)rrArgs.outRespMsg.get();
+   const auto setRespMsg = (const SetLocalAttrRespMsg*)rrArgs->outRespMsg.get();
 
    FhgfsOpsErr setRespVal = setRespMsg->getResult();
    if(setRespVal != FhgfsOpsErr_SUCCESS)
@@ -1,6 +1,6 @@
 #pragma once
 
-#include <common/components/worker/Work.h>
+#include <common/net/message/storage/attribs/SetLocalAttrMsg.h>
 #include <common/net/sock/Socket.h>
 #include <common/storage/StorageDefinitions.h>
 #include <common/storage/StorageErrors.h>
@@ -8,9 +8,10 @@
 #include <common/storage/striping/StripePattern.h>
 #include <common/toolkit/SynchronizedCounter.h>
 #include <common/Common.h>
+#include "FanOutWork.h"
 
 
-class SetChunkFileAttribsWork : public Work
+class SetChunkFileAttribsWork : public FanOutWork
 {
    public:
 
@@ -35,6 +36,8 @@ class SetChunkFileAttribsWork : public Work
 
       virtual void process(char* bufIn, unsigned bufInLen, char* bufOut, unsigned bufOutLen);
 
+      virtual void submit(RequestResponseFanOut& fanOut);
+
 
    private:
       std::string entryID;
@@ -55,7 +58,13 @@ class SetChunkFileAttribsWork : public Work
 
       unsigned msgUserID; // only used for msg header info
 
+      std::unique_ptr<SetLocalAttrMsg> requestMsg;
+      std::unique_ptr<RequestResponseTarget> rrTarget;
+      std::unique_ptr<RequestResponseArgs> rrArgs;
+
       FhgfsOpsErr communicate();
+      void prepareRequest();
+      FhgfsOpsErr processResponse(FhgfsOpsErr requestRes);
 
 
    public:
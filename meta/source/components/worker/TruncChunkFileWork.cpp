@@ -20,42 +20,63 @@ void TruncChunkFileWork::process(char* bufIn, unsigned bufInLen, char* bufOut, u
 
 FhgfsOpsErr TruncChunkFileWork::communicate()
 {
-   const char* logContext = "Trunc chunk file work";
+   prepareRequest();
+
+   FhgfsOpsErr requestRes = MessagingTk::requestResponseTarget(rrTarget.get(), rrArgs.get() );
+
+   return processResponse(requestRes);
+}
+
+void TruncChunkFileWork::submit(RequestResponseFanOut& fanOut)
+{
+   prepareRequest();
+
+   fanOut.add(rrTarget.get(), rrArgs.get(),
+      [this] (FhgfsOpsErr requestRes)
+      {
+         *outResult = processResponse(requestRes);
+         counter->incCount();
+      });
+}
 
+void TruncChunkFileWork::prepareRequest()
+{
    App* app = Program::getApp();
 
-   TruncLocalFileMsg truncMsg(filesize, entryID, targetID, pathInfo);
+   requestMsg.reset(new TruncLocalFileMsg(filesize, entryID, targetID, pathInfo) );
 
    if(pattern->getPatternType() == StripePatternType_BuddyMirror)
    {
-      truncMsg.addMsgHeaderFeatureFlag(TRUNCLOCALFILEMSG_FLAG_BUDDYMIRROR);
+      requestMsg->addMsgHeaderFeatureFlag(TRUNCLOCALFILEMSG_FLAG_BUDDYMIRROR);
 
       if(useBuddyMirrorSecond)
       {
-         truncMsg.addMsgHeaderFeatureFlag(TRUNCLOCALFILEMSG_FLAG_NODYNAMICATTRIBS);
-         truncMsg.addMsgHeaderFeatureFlag(TRUNCLOCALFILEMSG_FLAG_BUDDYMIRROR_SECOND);
+         requestMsg->addMsgHeaderFeatureFlag(TRUNCLOCALFILEMSG_FLAG_NODYNAMICATTRIBS);
+         requestMsg->addMsgHeaderFeatureFlag(TRUNCLOCALFILEMSG_FLAG_BUDDYMIRROR_SECOND);
       }
    }
 
    if(useQuota)
-      truncMsg.setUserdataForQuota(userID, groupID);
+      requestMsg->setUserdataForQuota(userID, groupID);
 
-   truncMsg.setMsgHeaderUserID(msgUserID);
+   requestMsg->setMsgHeaderUserID(msgUserID);
 
    // prepare communication
 
-   RequestResponseTarget rrTarget(targetID, app->getTargetMapper(), app->getStorageNodes() );
+   rrTarget.reset(new RequestResponseTarget(targetID, app->getTargetMapper(),
+      app->getStorageNodes() ) );
 
-   rrTarget.setTargetStates(app->getTargetStateStore() );
+   rrTarget->setTargetStates(app->getTargetStateStore() );
 
    if(pattern->getPatternType() == StripePatternType_BuddyMirror)
-      rrTarget.setMirrorInfo(app->getStorageBuddyGroupMapper(), useBuddyMirrorSecond);
-
-   RequestResponseArgs rrArgs(NULL, &truncMsg, NETMSGTYPE_TruncLocalFileResp);
+      rrTarget->setMirrorInfo(app->getStorageBuddyGroupMapper(), useBuddyMirrorSecond);
 
-   // communicate
+   rrArgs.reset(new RequestResponseArgs(NULL, requestMsg.get(), NETMSGTYPE_TruncLocalFileResp) );
+}
 
-   FhgfsOpsErr requestRes = MessagingTk::requestResponseTarget(&rrTarget, &rrArgs);
+FhgfsOpsErr TruncChunkFileWork::processResponse(FhgfsOpsErr requestRes)
+{
+   const char* logContext = "Trunc chunk file work";
 
    if(unlikely(requestRes != FhgfsOpsErr_SUCCESS) )
    { // communication error
@@ -69,7 +90,7 @@ FhgfsOpsErr TruncChunkFileWork::communicate()
    }
 
    // correct response type received
-   TruncLocalFileRespMsg* truncRespMsg = (TruncLocalFileRespMsg*)rrArgs.outRespMsg.get();
+   TruncLocalFileRespMsg* truncRespMsg = (TruncLocalFileRespMsg*)rrArgs->outRespMsg.get();
 
    FhgfsOpsErr truncRespVal = truncRespMsg->getResult();
 
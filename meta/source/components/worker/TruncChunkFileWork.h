@@ -1,18 +1,19 @@
 #pragma once
 
-#include <common/components/worker/Work.h>
+#include <common/net/message/storage/TruncLocalFileMsg.h>
 #include <common/net/sock/Socket.h>
 #include <common/storage/striping/StripePattern.h>
 #include <common/storage/StorageErrors.h>
 #include <common/toolkit/SynchronizedCounter.h>
 #include <common/storage/striping/ChunkFileInfo.h>
 #include <common/Common.h>
+#include "FanOutWork.h"
 
 
 /**
  * Truncate file on storage servers
  */
-class TruncChunkFileWork : public Work
+class TruncChunkFileWork : public FanOutWork
 {
    public:
       /**
@@ -33,6 +34,8 @@ class TruncChunkFileWork : public Work
 
       virtual void process(char* bufIn, unsigned bufInLen, char* bufOut, unsigned bufOutLen);
 
+      virtual void submit(RequestResponseFanOut& fanOut);
+
 
    private:
       std::string entryID;
@@ -52,7 +55,13 @@ class TruncChunkFileWork : public Work
 
       unsigned msgUserID; // only used for msg header info
 
+      std::unique_ptr<TruncLocalFileMsg> requestMsg;
+      std::unique_ptr<RequestResponseTarget> rrTarget;
+      std::unique_ptr<RequestResponseArgs> rrArgs;
+
       FhgfsOpsErr communicate();
+      void prepareRequest();
+      FhgfsOpsErr processResponse(FhgfsOpsErr requestRes);
 
 
 
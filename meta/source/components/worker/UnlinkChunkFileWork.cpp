@@ -18,36 +18,57 @@ void UnlinkChunkFileWork::process(char* bufIn, unsigned bufInLen, char* bufOut,
 
 FhgfsOpsErr UnlinkChunkFileWork::communicate()
 {
-   const char* logContext = "Unlink chunk file work";
+   prepareRequest();
+
+   FhgfsOpsErr requestRes = MessagingTk::requestResponseTarget(rrTarget.get(), rrArgs.get() );
+
+   return processResponse(requestRes);
+}
+
+void UnlinkChunkFileWork::submit(RequestResponseFanOut& fanOut)
+{
+   prepareRequest();
+
+   fanOut.add(rrTarget.get(), rrArgs.get(),
+      [this] (FhgfsOpsErr requestRes)
+      {
+         *outResult = processResponse(requestRes);
+         counter->incCount();
+      });
+}
 
+void UnlinkChunkFileWork::prepareRequest()
+{
    App* app = Program::getApp();
 
-   UnlinkLocalFileMsg unlinkMsg(entryID, targetID, pathInfo);
+   requestMsg.reset(new UnlinkLocalFileMsg(entryID, targetID, pathInfo) );
 
    if(pattern->getPatternType() == StripePatternType_BuddyMirror)
    {
-      unlinkMsg.addMsgHeaderFeatureFlag(UNLINKLOCALFILEMSG_FLAG_BUDDYMIRROR);
+      requestMsg->addMsgHeaderFeatureFlag(UNLINKLOCALFILEMSG_FLAG_BUDDYMIRROR);
 
       if(useBuddyMirrorSecond)
-         unlinkMsg.addMsgHeaderFeatureFlag(UNLINKLOCALFILEMSG_FLAG_BUDDYMIRROR_SECOND);
+         requestMsg->addMsgHeaderFeatureFlag(UNLINKLOCALFILEMSG_FLAG_BUDDYMIRROR_SECOND);
    }
 
-   unlinkMsg.setMsgHeaderUserID(msgUserID);
+   requestMsg->setMsgHeaderUserID(msgUserID);
 
    // prepare communication
 
-   RequestResponseTarget rrTarget(targetID, app->getTargetMapper(), app->getStorageNodes() );
+   rrTarget.reset(new RequestResponseTarget(targetID, app->getTargetMapper(),
+      app->getStorageNodes() ) );
 
-   rrTarget.setTargetStates(app->getTargetStateStore() );
+   rrTarget->setTargetStates(app->getTargetStateStore() );
 
    if(pattern->getPatternType() == StripePatternType_BuddyMirror)
-      rrTarget.setMirrorInfo(app->getStorageBuddyGroupMapper(), useBuddyMirrorSecond);
-
-   RequestResponseArgs rrArgs(NULL, &unlinkMsg, NETMSGTYPE_UnlinkLocalFileResp);
+      rrTarget->setMirrorInfo(app->getStorageBuddyGroupMapper(), useBuddyMirrorSecond);
 
-   // communicate
+   rrArgs.reset(new RequestResponseArgs(NULL, requestMsg.get(), NETMSGTYPE_UnlinkLocalFileResp) );
+}
 
-   FhgfsOpsErr requestRes = MessagingTk::requestResponseTarget(&rrTarget, &rrArgs);
+FhgfsOpsErr UnlinkChunkFileWork::processResponse(FhgfsOpsErr requestRes)
+{
+   const char* logContext = "Unlink chunk file work";
 
    if(unlikely(requestRes != FhgfsOpsErr_SUCCESS) )
    { // communication error
@@ -61,7 +82,7 @@ FhgfsOpsErr UnlinkChunkFileWork::communicate()
    }
 
    // correct response type received
-   UnlinkLocalFileRespMsg* unlinkRespMsg = (UnlinkLocalFileRespMsg*)rrArgs.outRespMsg.get();
+   UnlinkLocalFileRespMsg* unlinkRespMsg = (UnlinkLocalFileRespMsg*)rrArgs->outRespMsg.get();
 
    FhgfsOpsErr unlinkResult = unlinkRespMsg->getResult();
    if(unlinkResult != FhgfsOpsErr_SUCCESS)
@@ -1,6 +1,6 @@
 #pragma once
 
-#include <common/components/worker/Work.h>
+#include <common/net/message/storage/creating/UnlinkLocalFileMsg.h>
 #include <common/net/sock/Socket.h>
 #include <common/storage/striping/StripePattern.h>
 #include <common/storage/PathInfo.h>
@@ -8,9 +8,10 @@
 #include <common/toolkit/SynchronizedCounter.h>
 #include <common/storage/striping/ChunkFileInfo.h>
 #include <common/Common.h>
+#include "FanOutWork.h"
 
 
-class UnlinkChunkFileWork : public Work
+class UnlinkChunkFileWork : public FanOutWork
 {
    public:
 
@@ -31,6 +32,8 @@ class UnlinkChunkFileWork : public Work
 
       virtual void process(char* bufIn, unsigned bufInLen, char* bufOut, unsigned bufOutLen);
 
+      virtual void submit(RequestResponseFanOut& fanOut);
+
 
    private:
       std::string entryID;
@@ -44,7 +47,13 @@ class UnlinkChunkFileWork : public Work
 
       unsigned msgUserID;
 
+      std::unique_ptr<UnlinkLocalFileMsg> requestMsg;
+      std::unique_ptr<RequestResponseTarget> rrTarget;
+      std::unique_ptr<RequestResponseArgs> rrArgs;
+
       FhgfsOpsErr communicate();
+      void prepareRequest();
+      FhgfsOpsErr processResponse(FhgfsOpsErr requestRes);
 
 
    public:
@@ -21,6 +21,7 @@ class MirroredMessage : public BaseT
 
       BuddyResyncJob* resyncJob;
       LockStateT lockState;
+      std::vector<uint32_t> lockHashes; // of lockState, for the MirrorForwardPipeline
 
       MirroredMessage():
          resyncJob(nullptr)
@@ -62,6 +63,10 @@ class MirroredMessage : public BaseT
             if (Program::getApp()->getInternodeSyncer()->getResyncInProgress())
                resyncJob = Program::getApp()->getBuddyResyncer()->getResyncJob();
 
+            lockHashes.clear();
+
+            EntryLockStore::LockHashRecorder lockHashRecorder(lockHashes);
+
             lockState = lock(*Program::getApp()->getMirroredSessions()->getEntryLockStore());
          }
 
@@ -304,7 +309,21 @@ class MirroredMessage : public BaseT
          message.addFlag(this->getFlags() & NetMessageHeader::Flag_IsSelectiveAck);
          message.addFlag(this->getFlags() & NetMessageHeader::Flag_HasSequenceNumber);
 
-         FhgfsOpsErr commRes = MessagingTk::requestResponseNode(&rrNode, &rrArgs);
+         FhgfsOpsErr commRes;
+
+         if (MirrorForwardPipeline* pipeline = app->getMirrorForwardPipeline())
+         {
+            // the secondary processes the forwarded requests of a connection in the order in
+            // which they were sent, and the pipeline sends requests on the same entries (by the
+            // hashes of their locks) over the same connection while the entry locks are held. so
+            // once our request is on its way, later operations on the same entries can not
+            // overtake it on the secondary and the locks may be released before the secondary
+            // has answered.
+            commRes = pipeline->forward(&rrNode, &rrArgs, lockHashes,
+               [this] () { lockState = {}; });
+         }
+         else
+            commRes = MessagingTk::requestResponseNode(&rrNode, &rrArgs);
 
          message.removeFlag(NetMessageHeader::Flag_BuddyMirrorSecond);
 
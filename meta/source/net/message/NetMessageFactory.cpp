@@ -2,6 +2,8 @@
 #include <common/net/message/control/AuthenticateChannelMsgEx.h>
 #include <common/net/message/control/GenericResponseMsg.h>
 #include <common/net/message/control/PeerInfoMsgEx.h>
+#include <common/net/message/control/SetChannelMultiplexedMsgEx.h>
+#include <common/net/message/control/SetChannelMultiplexedRespMsg.h>
 #include <net/message/control/AckMsgEx.h>
 #include <net/message/control/SetChannelDirectMsgEx.h>
 
@@ -35,6 +37,7 @@
 
 // storage messages
 #include <common/net/message/storage/attribs/RefreshEntryInfoRespMsg.h>
+#include <common/net/message/storage/attribs/GetChunkFileAttribsBatchRespMsg.h>
 #include <common/net/message/storage/attribs/GetChunkFileAttribsRespMsg.h>
 #include <common/net/message/storage/listing/ListDirFromOffsetRespMsg.h>
 #include <common/net/message/storage/lookup/FindOwnerRespMsg.h>
@@ -188,6 +191,8 @@ std::unique_ptr<NetMessage> NetMessageFactory::createFromMsgType(unsigned short
       case NETMSGTYPE_AuthenticateChannel: { msg = new AuthenticateChannelMsgEx(); } break;
       case NETMSGTYPE_GenericResponse: { msg = new GenericResponseMsg(); } break;
       case NETMSGTYPE_SetChannelDirect: { msg = new SetChannelDirectMsgEx(); } break;
+      case NETMSGTYPE_SetChannelMultiplexed: { msg = new SetChannelMultiplexedMsgEx(); } break;
+      case NETMSGTYPE_SetChannelMultiplexedResp: { msg = new SetChannelMultiplexedRespMsg(); } break;
       case NETMSGTYPE_PeerInfo: { msg = new PeerInfoMsgEx(); } break;
 
       // nodes messages
@@ -224,6 +229,7 @@ std::unique_ptr<NetMessage> NetMessageFactory::createFromMsgType(unsigned short
       case NETMSGTYPE_FindOwner: { msg = new FindOwnerMsgEx(); } break;
       case NETMSGTYPE_FindOwnerResp: { msg = new FindOwnerRespMsg(); } break;
       case NETMSGTYPE_GetChunkFileAttribsResp: { msg = new GetChunkFileAttribsRespMsg(); } break;
+      case NETMSGTYPE_GetChunkFileAttribsBatchResp: { msg = new GetChunkFileAttribsBatchRespMsg(); } break;
       case NETMSGTYPE_GetEntryInfo: { msg = new GetEntryInfoMsgEx(); } break;
       case NETMSGTYPE_GetEntryInfoResp: { msg = new GetEntryInfoRespMsg(); } break;
       case NETMSGTYPE_GetHighResStats: { msg = new GetHighResStatsMsgEx(); } break;
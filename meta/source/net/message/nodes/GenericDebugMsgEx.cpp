@@ -15,6 +15,7 @@
 #define GENDBGMSG_OP_CACHESTATISTICS      "cachestats"
 #define GENDBGMSG_OP_VERSION              "version"
 #define GENDBGMSG_OP_MSGQUEUESTATS        "msgqueuestats"
+#define GENDBGMSG_OP_ENTRYLOCKSTATS       "entrylockstats"
 #define GENDBGMSG_OP_LISTPOOLS            "listpools"
 #define GENDBGMSG_OP_DUMPDENTRY           "dumpdentry"
 #define GENDBGMSG_OP_DUMPINODE            "dumpinode"
@@ -81,6 +82,9 @@ std::string GenericDebugMsgEx::processCommand()
    if(operation == GENDBGMSG_OP_MSGQUEUESTATS)
       responseStr = processOpMsgQueueStats(commandStream);
    else
+   if(operation == GENDBGMSG_OP_ENTRYLOCKSTATS)
+      responseStr = processOpEntryLockStats(commandStream);
+   else
    if(operation == GENDBGMSG_OP_VARLOGMESSAGES)
       responseStr = MsgHelperGenericDebug::processOpVarLogMessages(commandStream);
    else
@@ -411,6 +415,30 @@ std::string GenericDebugMsgEx::processOpMsgQueueStats(std::istringstream& comman
    return responseStream.str();
 }
 
+std::string GenericDebugMsgEx::processOpEntryLockStats(std::istringstream& commandStream)
+{
+   // protocol: optional number of most contended buckets to list per lock type
+
+   App* app = Program::getApp();
+
+   std::ostringstream responseStream;
+   std::string maxBucketsStr;
+   size_t maxBuckets = 10;
+
+   std::getline(commandStream, maxBucketsStr, ' ');
+
+   if(!maxBucketsStr.empty() )
+      maxBuckets = StringTk::strToUInt(maxBucketsStr);
+
+   responseStream << "Non-mirrored sessions:" << std::endl <<
+      app->getSessions()->getEntryLockStore()->getStatsAsStr(maxBuckets) << std::endl;
+
+   responseStream << "Mirrored sessions:" << std::endl <<
+      app->getMirroredSessions()->getEntryLockStore()->getStatsAsStr(maxBuckets);
+
+   return responseStream.str();
+}
+
 /**
  * List internal state of meta and storage capacity pools.
  */
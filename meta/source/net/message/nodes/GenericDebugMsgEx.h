@@ -20,6 +20,7 @@ class GenericDebugMsgEx : public GenericDebugMsg
       std::string processOpCacheStatistics(std::istringstream& commandStream);
       std::string processOpVersion(std::istringstream& commandStream);
       std::string processOpMsgQueueStats(std::istringstream& commandStream);
+      std::string processOpEntryLockStats(std::istringstream& commandStream);
       std::string processOpListPools(std::istringstream& commandStream);
       std::string processOpDumpDentry(std::istringstream& commandStream);
       std::string processOpDumpInode(std::istringstream& commandStream);
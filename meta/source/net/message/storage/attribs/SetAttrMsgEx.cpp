@@ -366,8 +366,6 @@ FhgfsOpsErr SetAttrMsgEx::setChunkFileAttribsParallel(FileInode& inode, bool req
 {
    const char* logContext = "Set chunk file attribs";
 
-   App* app = Program::getApp();
-   MultiWorkQueue* slaveQ = app->getCommSlaveQueue();
    StripePattern* pattern = inode.getStripePattern();
    const UInt16Vector* targetIDs = pattern->getStripeTargetIDs();
 
@@ -377,6 +375,7 @@ FhgfsOpsErr SetAttrMsgEx::setChunkFileAttribsParallel(FileInode& inode, bool req
    DynamicFileAttribsVec dynAttribsVec(numTargetWorks);
    FhgfsOpsErrVec nodeResults(numTargetWorks);
    SynchronizedCounter counter;
+   FanOutWorkDispatcher dispatcher;
 
    PathInfo pathInfo;
    inode.getPathInfo(&pathInfo);
@@ -404,10 +403,11 @@ FhgfsOpsErr SetAttrMsgEx::setChunkFileAttribsParallel(FileInode& inode, bool req
       work->setQuotaChown(isMsgHeaderFeatureFlagSet(SETATTRMSG_FLAG_USE_QUOTA) );
       work->setMsgUserID(getMsgHeaderUserID() );
 
-      slaveQ->addDirectWork(work);
+      dispatcher.add(work);
    }
 
    // wait for work completion...
+   dispatcher.waitAll();
    counter.waitForCount(numTargetWorks);
 
    // we set the dynamic attribs here, no matter if the remote operation suceeded or not. If it
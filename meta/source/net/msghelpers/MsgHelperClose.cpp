@@ -270,8 +270,6 @@ FhgfsOpsErr MsgHelperClose::closeChunkFileParallel(const NumNodeID sessionID,
 {
    const char* logContext = "Close Helper (close chunk files)";
 
-   App* app = Program::getApp();
-   MultiWorkQueue* slaveQ = app->getCommSlaveQueue();
    StripePattern* pattern = inode.getStripePattern();
    const UInt16Vector* targetIDs = pattern->getStripeTargetIDs();
    PathInfo pathInfo;
@@ -284,6 +282,7 @@ FhgfsOpsErr MsgHelperClose::closeChunkFileParallel(const NumNodeID sessionID,
    FhgfsOpsErr retVal = FhgfsOpsErr_SUCCESS;
    FhgfsOpsErrVec nodeResults(numTargetWorks);
    SynchronizedCounter counter;
+   FanOutWorkDispatcher dispatcher;
 
    inode.getPathInfo(&pathInfo);
 
@@ -295,11 +294,12 @@ FhgfsOpsErr MsgHelperClose::closeChunkFileParallel(const NumNodeID sessionID,
 
       work->setMsgUserID(msgUserID);
 
-      slaveQ->addDirectWork(work);
+      dispatcher.add(work);
    }
 
    // wait for work completion...
 
+   dispatcher.waitAll();
    counter.waitForCount(numTargetWorks);
 
    // check target results...
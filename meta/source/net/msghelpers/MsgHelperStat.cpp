@@ -92,6 +92,11 @@ FhgfsOpsErr MsgHelperStat::refreshDynAttribs(EntryInfo* entryInfo, bool makePers
       if(!persistenceRes)
          retVal = FhgfsOpsErr_INTERNAL;
    }
+   else
+   if( (retVal == FhgfsOpsErr_SUCCESS) && !inode->getNumSessionsWrite() )
+   { // no writers => the refreshed attribs are complete, write back a lost deferred update
+      inode->flushDynAttribs(entryInfo, true);
+   }
 
    metaStore->releaseFile(entryInfo->getParentEntryID(), inode);
 
@@ -205,6 +210,8 @@ FhgfsOpsErr MsgHelperStat::refreshDynAttribsSequential(FileInode& inode, const s
 
 /**
  * Note: For buddymirrored files, only group's primary is used.
+ * Note: Requests are combined with concurrent refreshes of other files for the same targets if
+ *    a GetChunkFileAttribsBatcher is enabled.
  */
 FhgfsOpsErr MsgHelperStat::refreshDynAttribsParallel(FileInode& inode, const std::string& entryID,
    unsigned msgUserID)
@@ -214,7 +221,7 @@ FhgfsOpsErr MsgHelperStat::refreshDynAttribsParallel(FileInode& inode, const std
    FhgfsOpsErr retVal = FhgfsOpsErr_SUCCESS; // will be set to node error, if any
 
    App* app = Program::getApp();
-   MultiWorkQueue* slaveQ = app->getCommSlaveQueue();
+   GetChunkFileAttribsBatcher* batcher = app->getChunkFileAttribsBatcher();
    StripePattern* pattern = inode.getStripePattern();
    const UInt16Vector* targetIDs = pattern->getStripeTargetIDs();
 
@@ -224,20 +231,34 @@ FhgfsOpsErr MsgHelperStat::refreshDynAttribsParallel(FileInode& inode, const std
 
    FhgfsOpsErrVec nodeResults(numWorks);
    SynchronizedCounter counter;
+   FanOutWorkDispatcher dispatcher;
+   GetChunkFileAttribsBatcher::OpenedBatchVec openedBatches;
 
    PathInfo pathInfo;
    inode.getPathInfo(&pathInfo);
 
    for(size_t i=0; i < numWorks; i++)
    {
+      if(batcher)
+      { // combine with concurrent requests for the same target
+         batcher->add( (*targetIDs)[i],
+            pattern->getPatternType() == StripePatternType_BuddyMirror, entryID, pathInfo,
+            &(dynAttribsVec[i]), &(nodeResults[i]), &counter, msgUserID, openedBatches);
+         continue;
+      }
+
       GetChunkFileAttribsWork* work = new GetChunkFileAttribsWork(entryID, pattern, (*targetIDs)[i],
          &pathInfo, &(dynAttribsVec[i]), &(nodeResults[i]), &counter);
 
       work->setMsgUserID(msgUserID);
 
-      slaveQ->addDirectWork(work);
+      dispatcher.add(work);
    }
 
+   if(batcher)
+      batcher->sendOpenedBatches(openedBatches);
+
+   dispatcher.waitAll();
    counter.waitForCount(numWorks);
 
    for(size_t i=0; i < numWorks; i++)
@@ -164,8 +164,6 @@ FhgfsOpsErr MsgHelperTrunc::truncChunkFileParallel(FileInode& inode, EntryInfo*
 {
    const char* logContext = "Trunc chunk file helper";
 
-   App* app = Program::getApp();
-   MultiWorkQueue* slaveQ = app->getCommSlaveQueue();
    StripePattern* pattern = inode.getStripePattern();
    const UInt16Vector* targetIDs = pattern->getStripeTargetIDs();
 
@@ -174,6 +172,7 @@ FhgfsOpsErr MsgHelperTrunc::truncChunkFileParallel(FileInode& inode, EntryInfo*
    FhgfsOpsErr retVal = FhgfsOpsErr_SUCCESS;
    FhgfsOpsErrVec nodeResults(numTargetWorks);
    SynchronizedCounter counter;
+   FanOutWorkDispatcher dispatcher;
 
    // generate work for storage targets...
    PathInfo pathInfo;
@@ -193,11 +192,12 @@ FhgfsOpsErr MsgHelperTrunc::truncChunkFileParallel(FileInode& inode, EntryInfo*
 
       work->setMsgUserID(msgUserID);
 
-      slaveQ->addDirectWork(work);
+      dispatcher.add(work);
    }
 
    // wait for work completion...
 
+   dispatcher.waitAll();
    counter.waitForCount(numTargetWorks);
 
    // check target results...
@@ -230,8 +230,6 @@ FhgfsOpsErr MsgHelperUnlink::unlinkChunkFileParallel(FileInode& inode, unsigned
 {
    std::string logContext("Unlink Helper (unlink chunk file [" + inode.getEntryID() + "])");
 
-   App* app = Program::getApp();
-   MultiWorkQueue* slaveQ = app->getCommSlaveQueue();
    StripePattern* pattern = inode.getStripePattern();
    const UInt16Vector* targetIDs = pattern->getStripeTargetIDs();
 
@@ -240,6 +238,7 @@ FhgfsOpsErr MsgHelperUnlink::unlinkChunkFileParallel(FileInode& inode, unsigned
    FhgfsOpsErr retVal = FhgfsOpsErr_SUCCESS;
    FhgfsOpsErrVec nodeResults(numTargetWorks);
    SynchronizedCounter counter;
+   FanOutWorkDispatcher dispatcher;
 
    PathInfo pathInfo;
    inode.getPathInfo(&pathInfo);
@@ -253,11 +252,12 @@ FhgfsOpsErr MsgHelperUnlink::unlinkChunkFileParallel(FileInode& inode, unsigned
 
       work->setMsgUserID(msgUserID);
 
-      slaveQ->addDirectWork(work);
+      dispatcher.add(work);
    }
 
    // wait for work completion...
 
+   dispatcher.waitAll();
    counter.waitForCount(numTargetWorks);
 
    // check target results...
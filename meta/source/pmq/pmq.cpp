@@ -1,6 +1,9 @@
 #include "pmq_common.hpp"
 #include "pmq.hpp"
 
+#include <atomic>
+#include <sched.h>
+
 static constexpr uint64_t PMQ_SLOT_SIZE = 128;
 static constexpr uint64_t PMQ_SLOT_HEADER_SIZE = 16;
 static constexpr uint64_t PMQ_SLOT_SPACE = PMQ_SLOT_SIZE - PMQ_SLOT_HEADER_SIZE;
@@ -50,7 +53,8 @@ struct PMQ_Slot
  * It consists of a ringbuffer of fixed-size slots.
  * A slot has a header and a payload. The size of each slot is PMQ_SLOT_SIZE,
  * and the payload can be up to up to PMQ_SLOT_SPACE bytes.
- * In the future, we might support even concurrent writes.
+ * Multiple enqueuers may write concurrently, each to its own reserved range of
+ * slots (see Enqueuer).
  * This structure needs no locking; its contents are static except when
  * initialization and destroying.
  * Accessing the cursors though needs a mutex lock.
@@ -269,12 +273,38 @@ struct Commit_Record
 };
 
 
-// Data owned by the enqueuer functionality. There can only be 1 enqueuer
-// thread at a time.
+// Data owned by the enqueuer functionality. There can be many enqueuer threads
+// at a time: Each enqueuer reserves a range of slots (reserve_ssn), writes its
+// message there and then commits it by setting the commit mark of the leader
+// slot. Committed messages are published in SSN order by one enqueuer at a
+// time (the one that manages to set the publishing flag). Only an enqueuer that
+// finds the In_Queue full needs to take the enqueue_mutex.
 struct Enqueuer
 {
+   // Protected by pub_in_queue_mutex.
    PMQ_Enqueuer_Stats enqueuer_stats;
+
+   // msn and ssn_mem are owned by the thread that currently publishes,
+   // msn_disk and ssn_disk by the holder of the enqueue_mutex.
    In_Queue_Cursors in_queue_cursors;
+
+   // Start of the next range of slots that will be reserved. The slots from
+   // in_queue_cursors.ssn_mem up to here are currently being written or
+   // waiting to be published.
+   std::atomic<uint64_t> reserve_ssn;
+
+   // Reserved slots must end before this SSN, which is ssn_disk + slot_count.
+   // Only advanced with enqueue_mutex held.
+   std::atomic<uint64_t> reserve_end_ssn;
+
+   // Set while one of the enqueuers publishes committed messages.
+   std::atomic<bool> publishing;
+
+   // Commit marks, one for each slot of the In_Queue. When all slots of a
+   // message have been written, the mark of its leader slot is set to the
+   // leader's SSN + 1.
+   Alloc_Slice<std::atomic<uint64_t>> commit_marks_alloc;
+   Ringbuffer<SSN_Tag, std::atomic<uint64_t>> commit_marks;
 };
 
 // Data owner by the persister functionality. There can only be 1 persister
@@ -316,8 +346,9 @@ struct PMQ
    Mutex_Protected<PMQ_Persister_Stats> pub_persister_stats;
 
 
-   // must be held to guarantee only 1 enqueuer at a time (protects only
-   // In_Queue currently).
+   // must be held to make room in the In_Queue when it is full, i.e. to advance
+   // the enqueuer's ssn_disk. Readers hold it to keep the In_Queue slots that
+   // they read from being overwritten.
    PMQ_PROFILED_MUTEX(enqueue_mutex);
 
    Enqueuer enqueuer;
@@ -339,7 +370,7 @@ void pmq_get_stats(PMQ *q, PMQ_Stats *out_stats)
    PMQ_Stats stats = {};
    stats.persister = q->pub_persister_stats.load();
    {
-      PMQ_PROFILED_LOCK(lock_, q->enqueue_mutex);
+      PMQ_PROFILED_LOCK(lock_, q->pub_in_queue_mutex);
       stats.enqueuer = q->enqueuer.enqueuer_stats;
    }
 
@@ -894,8 +925,156 @@ bool pmq_sync(PMQ *q)
    return ret;
 }
 
+// Helper function for pmq_enqueue_msg().
+// Reserve nslots_req slots in the In_Queue without taking any lock.
+// Returns false if there is not enough room in the In_Queue (as far as
+// reserve_end_ssn tells).
+static bool pmq_reserve_input_slots(PMQ *q, uint64_t nslots_req, SSN *out_ssn)
+{
+   Enqueuer *e = &q->enqueuer;
+
+   uint64_t ssn = e->reserve_ssn.load(std::memory_order_relaxed);
+
+   for (;;)
+   {
+      // acquire: the slots below reserve_end_ssn are no longer read by the
+      // persister.
+      SSN end_ssn = SSN(e->reserve_end_ssn.load(std::memory_order_acquire));
+
+      if (sn64_gt(SSN(ssn) + nslots_req, end_ssn))
+         return false;
+
+      // A plain fetch-add would have to be undone when the In_Queue is full,
+      // so we use a compare-exchange.
+      if (e->reserve_ssn.compare_exchange_weak(ssn, ssn + nslots_req,
+               std::memory_order_relaxed))
+      {
+         *out_ssn = SSN(ssn);
+         return true;
+      }
+   }
+}
+
+// Helper function for pmq_enqueue_msg().
+// Advance the enqueuer's msn and ssn_mem cursors over all messages that have
+// been committed in a row and publish the new cursors. Only one thread
+// publishes at a time; an enqueuer that finds another thread publishing leaves
+// its committed message to that thread.
+static void pmq_publish_committed_msgs(PMQ *q)
+{
+   PMQ_PROFILED_FUNCTION;
+
+   Enqueuer *e = &q->enqueuer;
+   In_Queue_Cursors *ic = &e->in_queue_cursors;
+
+   for (;;)
+   {
+      if (e->publishing.exchange(true))
+         return;
+
+      SSN old_ssn_mem = ic->ssn_mem;
+      MSN old_msn = ic->msn;
+      uint64_t bytes = 0;
+
+      for (;;)
+      {
+         const std::atomic<uint64_t> *mark = e->commit_marks.get_slot_for(ic->ssn_mem);
+         if (mark->load() != ic->ssn_mem.value() + 1)
+            break;
+
+         const PMQ_Slot *slot = q->in_queue.slots.get_slot_for(ic->ssn_mem);
+         uint64_t msgsize = slot->msgsize;
+
+         ic->ssn_mem += (msgsize + PMQ_SLOT_SPACE - 1) / PMQ_SLOT_SPACE;
+         ic->msn += 1;
+         bytes += msgsize;
+      }
+
+      if (ic->ssn_mem != old_ssn_mem)
+      {
+         PMQ_PROFILED_UNIQUE_LOCK(lock_, q->pub_in_queue_mutex);
+
+         In_Queue_Cursors *pub = &q->pub_in_queue_cursors;
+
+         uint64_t new_slot_count = ic->ssn_mem - pub->ssn_disk;
+         uint64_t old_slot_count = old_ssn_mem - pub->ssn_disk;
+
+         bool notify =
+            old_slot_count < q->in_queue.slots_persist_watermark &&
+            new_slot_count >= q->in_queue.slots_persist_watermark;
+
+         e->enqueuer_stats.total_messages_enqueued += ic->msn - old_msn;
+         e->enqueuer_stats.total_bytes_enqueued += bytes;
+
+         pub->msn = ic->msn;
+         pub->ssn_mem = ic->ssn_mem;
+
+         pmq_assert(pub->ssn_mem - pub->ssn_disk <= q->in_queue.slot_count);
+
+         if (notify)
+            q->pub_in_queue_cond.notify_one();
+      }
+
+      // (ic is owned by the next publisher as soon as we clear the flag)
+      SSN ssn_mem = ic->ssn_mem;
+
+      e->publishing.store(false);
+
+      // The enqueuer of a message that got committed after we checked its mark
+      // may have found us still publishing. In that case it's up to us.
+      const std::atomic<uint64_t> *mark = e->commit_marks.get_slot_for(ssn_mem);
+      if (mark->load() != ssn_mem.value() + 1)
+         return;
+   }
+}
+
+// Helper function for pmq_prepare_input_slots()
+// Wait until all messages in slots that were reserved before ssn have been
+// committed and published. Returns the published ssn_mem.
+static SSN pmq_wait_for_published_slots(PMQ *q, SSN ssn)
+{
+   for (;;)
+   {
+      pmq_publish_committed_msgs(q);
+
+      {
+         PMQ_PROFILED_LOCK(lock_, q->pub_in_queue_mutex);
+         SSN ssn_mem = q->pub_in_queue_cursors.ssn_mem;
+         if (sn64_ge(ssn_mem, ssn))
+            return ssn_mem;
+      }
+
+      // the other enqueuers are only copying their messages
+      sched_yield();
+   }
+}
+
+// Helper function for pmq_prepare_input_slots()
+// Set the enqueuer's msn_disk and ssn_disk cursors and hand out the slots
+// below ssn_disk to new reservations.
+// enqueue_mutex must be locked.
+static void pmq_update_disk_cursors(PMQ *q, MSN msn_disk, SSN ssn_disk)
+{
+   In_Queue_Cursors *ic = &q->enqueuer.in_queue_cursors;
+
+   ic->msn_disk = msn_disk;
+   ic->ssn_disk = ssn_disk;
+
+   {
+      PMQ_PROFILED_LOCK(lock_, q->pub_in_queue_mutex);
+      q->pub_in_queue_cursors.msn_disk = msn_disk;
+      q->pub_in_queue_cursors.ssn_disk = ssn_disk;
+   }
+
+   SSN end_ssn = ssn_disk + q->in_queue.slot_count;
+   q->enqueuer.reserve_end_ssn.store(end_ssn.value(), std::memory_order_release);
+}
+
 // Helper function for pmq_enqueue_msg
-// Attempts to make enough room in the In_Queue
+// Attempts to make enough room in the In_Queue to reserve nslots_req slots
+// after all slots that are currently reserved. Other enqueuers may reserve
+// slots concurrently, so the caller has to retry if the reservation fails
+// again.
 // enqueue_mutex must be locked.
 
 static bool __pmq_profiled pmq_prepare_input_slots(PMQ *q, uint64_t nslots_req)
@@ -905,9 +1084,14 @@ static bool __pmq_profiled pmq_prepare_input_slots(PMQ *q, uint64_t nslots_req)
    In_Queue_Cursors *ic = &q->enqueuer.in_queue_cursors;
 
    uint64_t slot_count = q->in_queue.slot_count;
-   SSN next_ssn_mem = ic->ssn_mem + nslots_req;
 
-   pmq_assert(ic->ssn_mem - ic->ssn_disk <= slot_count);
+   // The persister can only compact published messages, so we wait for the
+   // enqueuers that are still writing to their slots.
+   SSN reserve_ssn = SSN(q->enqueuer.reserve_ssn.load());
+   SSN ssn_mem = pmq_wait_for_published_slots(q, reserve_ssn);
+   SSN next_ssn_mem = reserve_ssn + nslots_req;
+
+   pmq_assert(ssn_mem - ic->ssn_disk <= slot_count);
 
    if (next_ssn_mem - ic->ssn_disk <= slot_count)
       return true;
@@ -919,8 +1103,7 @@ static bool __pmq_profiled pmq_prepare_input_slots(PMQ *q, uint64_t nslots_req)
    // time.
    {
       Persist_Cursors pc = q->pub_persist_cursors.load();
-      ic->msn_disk = pc.cks_msn;
-      ic->ssn_disk = pc.cks_ssn;
+      pmq_update_disk_cursors(q, pc.cks_msn, pc.cks_ssn);
    }
 
    if (next_ssn_mem - ic->ssn_disk <= slot_count)
@@ -929,11 +1112,14 @@ static bool __pmq_profiled pmq_prepare_input_slots(PMQ *q, uint64_t nslots_req)
    // Still not enough room, need to switch to persister context (lock
    // it) and flush some more messages.
 
-   q->enqueuer.enqueuer_stats.buffer_full_count += 1;
+   {
+      PMQ_PROFILED_LOCK(lock_, q->pub_in_queue_mutex);
+      q->enqueuer.enqueuer_stats.buffer_full_count += 1;
+   }
 
    PMQ_PROFILED_LOCK(lock_, q->persist_mutex);
 
-   if (! pmq_persist(q, next_ssn_mem - slot_count, ic->ssn_mem))
+   if (! pmq_persist(q, next_ssn_mem - slot_count, ssn_mem))
    {
       return false;
    }
@@ -942,9 +1128,9 @@ static bool __pmq_profiled pmq_prepare_input_slots(PMQ *q, uint64_t nslots_req)
    {
       Chunk_Queue *cq = &q->chunk_queue;
       Persist_Cursors *pc = &q->persister.persist_cursors;
-      pmq_assert(sn64_ge(cq->cq_ssn, ic->ssn_mem));
-      pmq_debug_f("ic->ssn_mem: %" PRIu64 ", cq_ssn - cks_ssn: %" PRIu64,
-            ic->ssn_mem.value(), cq->cq_ssn.value() - pc->cks_ssn.value());
+      pmq_assert(sn64_ge(cq->cq_ssn, ssn_mem));
+      pmq_debug_f("ssn_mem: %" PRIu64 ", cq_ssn - cks_ssn: %" PRIu64,
+            ssn_mem.value(), cq->cq_ssn.value() - pc->cks_ssn.value());
    }
 
    if (false) // NOLINT
@@ -952,38 +1138,31 @@ static bool __pmq_profiled pmq_prepare_input_slots(PMQ *q, uint64_t nslots_req)
       SSN old_ssn_disk = ic->ssn_disk;
       SSN new_ssn_disk = q->persister.persist_cursors.cks_ssn;
 
-      pmq_debug_f("Flushed %" PRIu64 " ssns", ic->ssn_disk - old_ssn_disk);
+      pmq_debug_f("Flushed %" PRIu64 " ssns", new_ssn_disk - old_ssn_disk);
 
       if (sn64_le(new_ssn_disk, old_ssn_disk))
       {
          pmq_perr_f("Something is wrong: %" PRIu64 ", %" PRIu64,
-               old_ssn_disk.value(), ic->ssn_disk.value());
+               old_ssn_disk.value(), new_ssn_disk.value());
       }
-      pmq_assert(slot_count >= (ic->ssn_mem - ic->ssn_disk));
    }
 
    // Update the ssn_disk cursor from the (locked) persister context.
-   {
-      ic->msn_disk = q->persister.persist_cursors.cks_msn;
-      ic->ssn_disk = q->persister.persist_cursors.cks_ssn;
-   }
+   pmq_update_disk_cursors(q, q->persister.persist_cursors.cks_msn,
+         q->persister.persist_cursors.cks_ssn);
 
    pmq_assert(next_ssn_mem - ic->ssn_disk <= slot_count);
    return true;
 }
 
 // Helper function for pmq_enqueue_msg().
-// Serialize message to In_Queue's memory buffer.
-// Expects enqueue_mutex to be taken.
-// Expects that there is enough room to serialize the message (pmq_prepare_input_slots())
-static void pmq_serialize_msg(PMQ *q, const void *data, size_t size)
+// Serialize message to the In_Queue slots that were reserved for it starting
+// at ssn, and commit it.
+static void pmq_serialize_msg(PMQ *q, SSN ssn, const void *data, size_t size)
 {
    PMQ_PROFILED_FUNCTION;
 
-   In_Queue_Cursors *ic = &q->enqueuer.in_queue_cursors;
-
-   SSN ssn_mem = ic->ssn_mem;
-   SSN old_ssn_mem = ic->ssn_mem;
+   SSN ssn_mem = ssn;
 
    uint64_t slot_count = q->in_queue.slot_count;
    pmq_assert(pmq_is_power_of_2(slot_count));
@@ -1015,33 +1194,14 @@ static void pmq_serialize_msg(PMQ *q, const void *data, size_t size)
       ssn_mem += 1;
    }
 
-   // can bump ssn_mem cursor, publish new cursors field, and release lock now
-
-   ic->ssn_mem = ssn_mem;
-   ic->msn += 1;
-
-   q->enqueuer.enqueuer_stats.total_messages_enqueued += 1;
-   q->enqueuer.enqueuer_stats.total_bytes_enqueued += size;
-
-   {
-      uint64_t new_slot_count = ic->ssn_mem - ic->ssn_disk;
-      uint64_t old_slot_count = old_ssn_mem - ic->ssn_disk;
-
-      bool notify =
-         old_slot_count < q->in_queue.slots_persist_watermark &&
-         new_slot_count >= q->in_queue.slots_persist_watermark;
-
-      {
-         PMQ_PROFILED_UNIQUE_LOCK(lock_, q->pub_in_queue_mutex);
-         q->pub_in_queue_cursors = *ic;
-         if (notify)
-            q->pub_in_queue_cond.notify_one();
-      }
-   }
-
-   pmq_assert(ic->ssn_mem - ic->ssn_disk <= slot_count);
+   // commit. The message gets published together with all earlier messages
+   // (by us or by whichever enqueuer is currently publishing).
+   q->enqueuer.commit_marks.get_slot_for(ssn)->store(ssn.value() + 1);
 }
 
+// Enqueue a message. This can be called by many threads concurrently. The
+// message becomes visible to the persister and to readers as soon as all
+// messages that were enqueued concurrently before it have been committed too.
 bool pmq_enqueue_msg(PMQ *q, const void *data, size_t size)
 {
    PMQ_PROFILED_FUNCTION;
@@ -1049,10 +1209,21 @@ bool pmq_enqueue_msg(PMQ *q, const void *data, size_t size)
    pmq_assert(size > 0);
    uint64_t nslots_req = (size + PMQ_SLOT_SPACE - 1) / PMQ_SLOT_SPACE;
 
-   PMQ_PROFILED_LOCK(lock_, q->enqueue_mutex);
-   if (! pmq_prepare_input_slots(q, nslots_req))
-      return false;
-   pmq_serialize_msg(q, data, size);
+   SSN ssn;
+
+   if (! pmq_reserve_input_slots(q, nslots_req, &ssn))
+   {
+      PMQ_PROFILED_LOCK(lock_, q->enqueue_mutex);
+
+      do
+      {
+         if (! pmq_prepare_input_slots(q, nslots_req))
+            return false;
+      } while (! pmq_reserve_input_slots(q, nslots_req, &ssn));
+   }
+
+   pmq_serialize_msg(q, ssn, data, size);
+   pmq_publish_committed_msgs(q);
    return true;
 }
 
@@ -1475,6 +1646,17 @@ static bool pmq_init(PMQ *q, const PMQ_Init_Params *params)
       q->in_queue.slots.reset(Slice<PMQ_Slot>(slots, q->in_queue.slot_count));
    }
 
+   // Set up the enqueuers' commit marks.
+   // A mark of 0 can't be mistaken for a committed message unless the SSN
+   // wraps around.
+   {
+      Enqueuer *e = &q->enqueuer;
+      e->commit_marks_alloc.allocate(q->in_queue.slot_count);
+      for (uint64_t i = 0; i < q->in_queue.slot_count; i++)
+         e->commit_marks_alloc[i].store(0);
+      e->commit_marks.reset(e->commit_marks_alloc.slice());
+   }
+
 
    // Create or load the on-disk database
 
@@ -1525,6 +1707,14 @@ static bool pmq_init(PMQ *q, const PMQ_Init_Params *params)
    q->enqueuer.in_queue_cursors = q->pub_in_queue_cursors;
    q->persister.persist_cursors = q->pub_persist_cursors.load();
 
+   {
+      In_Queue_Cursors *ic = &q->enqueuer.in_queue_cursors;
+      SSN end_ssn = ic->ssn_disk + q->in_queue.slot_count;
+      q->enqueuer.reserve_ssn.store(ic->ssn_mem.value());
+      q->enqueuer.reserve_end_ssn.store(end_ssn.value());
+      q->enqueuer.publishing.store(false);
+   }
+
    // Initialize Chunk_Queue
    {
       Chunk_Queue *cq = &q->chunk_queue;
@@ -2003,17 +2193,23 @@ static PMQ_Read_Result pmq_reader_seek_to_msg_slotsfile(PMQ_Reader *reader, MSN
 
    // To prevent races, we need to check again using the enqueuer's cursors
    // that the MSN that we're looking for is still in the In_Queue.
+   // The disk cursors can't change while we hold the enqueue_mutex, the
+   // published msn might grow but that doesn't matter.
 
-   In_Queue_Cursors *ic = &reader->q->enqueuer.in_queue_cursors;
-   if (sn64_inrange(msn, ic->msn_disk, ic->msn))
+   In_Queue_Cursors ic;
+   {
+      PMQ_PROFILED_LOCK(lock_, reader->q->pub_in_queue_mutex);
+      ic = reader->q->pub_in_queue_cursors;
+   }
+   if (sn64_inrange(msn, ic.msn_disk, ic.msn))
    {
-      if (sn64_inrange(pc.wal_msn, msn, ic->msn))
+      if (sn64_inrange(pc.wal_msn, msn, ic.msn))
          // this is almost guaranteed but there is a race that should be
-         // impossible in practice (requires ic->msn to wrap around between
+         // impossible in practice (requires ic.msn to wrap around between
          // msn and pc.wal_msn).
       {
-         MSN msn_cur = ic->msn_disk;
-         SSN ssn_cur = ic->ssn_disk;
+         MSN msn_cur = ic.msn_disk;
+         SSN ssn_cur = ic.ssn_disk;
 
          while (msn_cur != msn)
          {
@@ -2262,7 +2458,11 @@ static PMQ_Read_Result pmq_read_msg_chunkstore(PMQ_Reader *reader, PMQ_Msg_Outpu
 
    *output.size_out = msgsize;
 
-   if (msgsize <= output.data_size)
+   // Don't advance, like pmq_read_msg_slotsfile(). pmq_read_msgs() relies on
+   // this to stop before the first message that doesn't fit anymore.
+   if (msgsize > output.data_size)
+      return PMQ_Read_Result_Buffer_Too_Small;
+
    {
       Untyped_Slice slice = ckread->cnk_buffer.untyped_slice().offset_bytes(msgoff);
       copy_from_slice(output.data, slice, msgsize);
@@ -2421,6 +2621,67 @@ PMQ_Read_Result pmq_read_msg(PMQ_Reader *reader,
    }
 }
 
+PMQ_Read_Result pmq_read_msgs(PMQ_Reader *reader, void *data, size_t size,
+      size_t *out_sizes, size_t max_msgs, size_t *out_count)
+{
+   *out_count = 0;
+
+   if (reader->last_result != PMQ_Read_Result_Success
+         && reader->last_result != PMQ_Read_Result_EOF)
+   {
+      return reader->last_result;  // need to seek to clear the error!
+   }
+
+   // Updating the cursors only once per batch is what makes this cheaper than
+   // calling pmq_read_msg() repeatedly (besides saving the calls).
+   pmq_reader_update_persist_cursors(reader);
+
+   char *dst = (char *) data;
+   size_t remain = size;
+   PMQ_Read_Result readres = PMQ_Read_Result_Success;
+
+   while (*out_count < max_msgs)
+   {
+      if (sn64_ge(reader->msn, reader->persist_cursors.wal_msn))
+      {
+         if (reader->msn == reader->persist_cursors.wal_msn)
+            readres = PMQ_Read_Result_EOF;
+         else
+            readres = PMQ_Read_Result_Out_Of_Bounds;
+         break;
+      }
+
+      PMQ_Msg_Output output(dst, remain, &out_sizes[*out_count]);
+
+      switch (reader->read_mode)
+      {
+         case PMQ_Read_Mode_Chunkstore:
+            readres = pmq_read_msg_chunkstore(reader, output);
+            break;
+         case PMQ_Read_Mode_Slotsfile:
+            readres = pmq_read_msg_slotsfile(reader, output);
+            break;
+         default:
+            // shouldn't happen.
+            pmq_assert(0);
+            abort();
+      }
+
+      if (readres != PMQ_Read_Result_Success)
+         break;
+
+      size_t msgsize = out_sizes[*out_count];
+      dst += msgsize;
+      remain -= msgsize;
+      *out_count += 1;
+   }
+
+   if (*out_count > 0)
+      return PMQ_Read_Result_Success;
+
+   return readres;
+}
+
 PMQ_Reader *pmq_reader_create(PMQ *q)
 {
    PMQ_Reader *reader = new PMQ_Reader;
@@ -2,6 +2,7 @@
 
 #include <stdint.h>  // uint64_t etc.
 #include <stddef.h>  // size_t
+#include <utility>  // std::swap
 
 struct PMQ_Enqueuer_Stats
 {
@@ -141,6 +142,17 @@ PMQ_Read_Result pmq_reader_seek_to_msg(PMQ_Reader *reader, uint64_t msn);
 PMQ_Read_Result pmq_read_msg(PMQ_Reader *reader,
       void *data, size_t size, size_t *out_size);
 
+/* Bulk version of pmq_read_msg(): Read as many messages as fit into the
+ * buffer, but no more than max_msgs, and advance past them. The messages are
+ * stored back to back in @data, their sizes in @out_sizes and the number of
+ * messages that were read in @out_count.
+ * Returns PMQ_Read_Result_Success if at least one message was read. Otherwise
+ * the result is the same as pmq_read_msg() would have returned for the current
+ * message.
+ */
+PMQ_Read_Result pmq_read_msgs(PMQ_Reader *reader, void *data, size_t size,
+      size_t *out_sizes, size_t max_msgs, size_t *out_count);
+
 uint64_t pmq_reader_get_current_msn(PMQ_Reader *reader);
 
 /* Attempt to find the MSN of the oldest persisted message.
@@ -220,7 +220,8 @@ void pmq_msg_ofv(const PMQ_Msg_Options& opt, const char *fmt, va_list ap)
 #if INTEGRATE_WITH_METADATA_SERVER
    // Integration into metadata server
    Logger *logger = Logger::getLogger();
-   logger->log(LogTopic_EVENTLOGGER, metadata_priority, opt.loc.file, opt.loc.line, log_msg.data);
+   if (logger)  // (not initialized in unit tests)
+      logger->log(LogTopic_EVENTLOGGER, metadata_priority, opt.loc.file, opt.loc.line, log_msg.data);
 #else
 
    log_msg_printf(&log_msg, "\n");
@@ -1,7 +1,12 @@
 #include "EntryLockStore.h"
 
+__thread std::vector<uint32_t>* EntryLockStore::currentHashes = NULL;
+
 ParentNameLockData* EntryLockStore::lock(const std::string& parentID, const std::string& name)
 {
+   recordLockHash(ValueLockHash<std::pair<std::string, std::string> >()(
+      std::pair<const std::string&, const std::string&>(parentID, name) ) );
+
    ParentNameLockData& lock = parentNameLocks.getLockFor(
       std::pair<const std::string&, const std::string&>(parentID, name) );
    lock.getLock().lock();
@@ -10,6 +15,8 @@ ParentNameLockData* EntryLockStore::lock(const std::string& parentID, const std:
 
 FileIDLockData* EntryLockStore::lock(const std::string& fileID, const bool writeLock)
 {
+   recordLockHash(ValueLockHash<std::string>()(fileID) );
+
    FileIDLockData& lock = fileLocks.getLockFor(fileID);
    if(writeLock)
       lock.getLock().writeLock();
@@ -21,6 +28,8 @@ FileIDLockData* EntryLockStore::lock(const std::string& fileID, const bool write
 
 HashDirLockData* EntryLockStore::lock(std::pair<unsigned, unsigned> hashDir)
 {
+   recordLockHash(ValueLockHash<std::pair<unsigned, unsigned> >()(hashDir) );
+
    HashDirLockData& lock = hashDirLocks.getLockFor(hashDir);
    lock.getLock().lock();
    return &lock;
@@ -43,3 +52,43 @@ void EntryLockStore::unlock(HashDirLockData* hashDirLockData)
    hashDirLockData->getLock().unlock();
    hashDirLocks.putLock(*hashDirLockData);
 }
+
+/**
+ * @param maxBuckets number of most contended buckets to list per lock type.
+ */
+std::string EntryLockStore::getStatsAsStr(size_t maxBuckets)
+{
+   std::ostringstream outStream;
+
+   outStream << "ParentNameLocks: " << parentNameLocks.getStats(maxBuckets).toString();
+   outStream << "FileIDLocks: " << fileLocks.getStats(maxBuckets).toString();
+   outStream << "HashDirLocks: " << hashDirLocks.getStats(maxBuckets).toString();
+
+   return outStream.str();
+}
+
+
+std::string ValueLockStoreStats::toString() const
+{
+   std::ostringstream outStream;
+
+   outStream <<
+      "buckets: " << numBuckets << "; " <<
+      "locks: " << numLocks << "; " <<
+      "buffered: " << numBufferedLocks << "; " <<
+      "resizes: " << numResizes << "; " <<
+      "bucket lockings: " << numLockings << "; " <<
+      "contended: " << numContended << std::endl;
+
+   for(std::vector<BucketStats>::const_iterator iter = mostContendedBuckets.begin();
+       iter != mostContendedBuckets.end();
+       iter++)
+   {
+      outStream << "   bucket " << iter->index << ": " <<
+         "locks: " << iter->numLocks << "; " <<
+         "lockings: " << iter->numLockings << "; " <<
+         "contended: " << iter->numContended << std::endl;
+   }
+
+   return outStream.str();
+}
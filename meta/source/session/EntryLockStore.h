@@ -5,14 +5,50 @@
 #include <common/threading/Mutex.h>
 #include <common/threading/RWLock.h>
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+
 template<typename Value>
 struct ValueLockHash;
 
 
 
-// This class implements a hashmap Value -> Lock of size HashSize. To avoid memory allocations
-// and deallocations, each bucket may keep up to BufferSize lock objects that are not currently
-// used.
+#define VALUELOCKSTORE_MAX_LOAD           2
+#define VALUELOCKSTORE_MAX_HASHSIZE       (1U << 20)
+#define VALUELOCKSTORE_MAX_LOOKUP_HOPS    32 // unlocked walks fall back to locked lookup after this
+
+
+/**
+ * Contention counters of a ValueLockStore, see ValueLockStore::getStats().
+ */
+struct ValueLockStoreStats
+{
+   struct BucketStats
+   {
+      size_t index;
+      unsigned numLocks; // currently used lock descriptors in this bucket
+      uint64_t numLockings; // bucket mutex acquisitions since the last resize
+      uint64_t numContended; // bucket mutex acquisitions that had to wait
+   };
+
+   size_t numBuckets;
+   size_t numLocks;
+   size_t numBufferedLocks; // unused descriptors kept for reuse
+   uint64_t numResizes;
+   uint64_t numLockings; // total bucket mutex acquisitions
+   uint64_t numContended; // total bucket mutex acquisitions that had to wait
+   std::vector<BucketStats> mostContendedBuckets; // sorted by numContended (descending)
+
+   std::string toString() const;
+};
+
+
+// This class implements a hashmap Value -> Lock. Lock descriptors are reference counted and kept
+// in intrusive per-bucket chains; descriptors that are not currently used are kept in a per-bucket
+// buffer of at most BufferSize descriptors for reuse, so that no memory allocations are necessary in
+// the steady state.
 //
 // Hashes for values are computed by ValueLockHash<Value>, so an appropriate specialization of this
 // template must exists in order to use this class.
@@ -20,16 +56,33 @@ struct ValueLockHash;
 // Currently the Lock argument is not restricted in any way, but it is intended to only ever be set
 // to types of locking primitives.
 //
-// This implementation does not use boost::unordered_map because we want a fixed-size table and
-// control over the per-bucket value lists, since these lists required memory allocations and
-// insert and deallocations on erase. The allocation overhead per list entry could also be
-// optimized away by using intrusive lists for bucket contents, but currently the lock buffers
-// are sufficient to amortize almost all allocator traffic.
-template<typename Value, typename Lock, unsigned HashSize, unsigned BufferSize = 32>
+// Lookups of descriptors that are currently in use (e.g. the parent directory of many concurrent
+// creates) don't take the bucket mutex: a lookup walks the bucket chain without locking and takes
+// a reference only if the reference count is not zero (descriptors with zero references are about
+// to be reused for another value). Once it holds a reference, the value of a descriptor can't
+// change anymore, so it is compared to the requested value only then. To make the unlocked walk
+// safe, bucket tables are never freed before the store is destroyed, and the walks of a bucket are
+// counted: descriptors that don't fit into the buffer of the bucket anymore are only freed while no
+// walk is active in the bucket (otherwise they stay in the buffer until a later release). An
+// unlocked walk may miss a descriptor that is moved concurrently, it falls back to a lookup under
+// the bucket mutex in this case.
+//
+// The table starts with InitialHashSize buckets and doubles its size when the average number of
+// descriptors per bucket exceeds VALUELOCKSTORE_MAX_LOAD.
+//
+// There is at most one descriptor per value in use at any time, and the store never holds one of
+// its internal mutexes while the caller waits for a Lock, so the lock ordering rules of
+// MirroredMessage are sufficient to avoid deadlocks.
+
+template<typename Value, typename Lock, unsigned InitialHashSize, unsigned BufferSize = 32>
 class ValueLockStore
 {
+   static_assert( (InitialHashSize & (InitialHashSize - 1) ) == 0,
+      "InitialHashSize must be a power of two");
+
    private:
       struct LockBucket;
+      struct BucketTable;
 
    public:
       class ValueLock
@@ -44,14 +97,12 @@ class ValueLockStore
 
          private:
             Lock lock;
-            Value value;
-            LockBucket* bucket;
-            typename std::list<ValueLock*>::iterator iter;
-            unsigned references;
-
-            ValueLock(const Value& value, LockBucket& bucket,
-                  typename std::list<ValueLock*>::iterator iter)
-               : value(value), bucket(&bucket), iter(iter), references(0)
+            Value value; // only valid while references is not zero
+            std::atomic<uint32_t> hash;
+            std::atomic<ValueLock*> next; // next descriptor in bucket chain or buffer
+            std::atomic<unsigned> references;
+
+            ValueLock() : hash(0), next(NULL), references(0)
             {}
 
             ValueLock(const ValueLock&);
@@ -59,68 +110,132 @@ class ValueLockStore
       };
 
    private:
-      struct LockBucket
+      struct alignas(64) LockBucket
       {
          Mutex mtx;
 
-         std::list<ValueLock*> locks;
+         std::atomic<ValueLock*> head; // descriptors in use
+         std::atomic<unsigned> numWalkers; // active unlocked walks that started in this bucket
 
-         std::list<ValueLock*> lockBuffer;
+         ValueLock* lockBuffer; // unused descriptors, linked via next
          unsigned lockBufferSize;
+         unsigned numLocks;
+
+         uint64_t numLockings;
+         uint64_t numContended;
 
          LockBucket()
-            : lockBufferSize(0)
+            : head(NULL), numWalkers(0), lockBuffer(NULL), lockBufferSize(0), numLocks(0),
+              numLockings(0), numContended(0)
+         {}
+      };
+
+      struct BucketTable
+      {
+         size_t size;
+         std::unique_ptr<LockBucket[]> buckets;
+
+         BucketTable(size_t size)
+            : size(size), buckets(new LockBucket[size])
          {}
+
+         LockBucket& bucketFor(uint32_t hash)
+         {
+            return buckets[hash & (size - 1)];
+         }
       };
 
    public:
+      ValueLockStore()
+         : table(new BucketTable(InitialHashSize) ), numLocks(0), numResizes(0),
+           retiredNumLockings(0), retiredNumContended(0)
+      {}
+
+      ~ValueLockStore()
+      {
+         BucketTable* currentTable = table.load(std::memory_order_relaxed);
+
+         for(size_t i = 0; i < currentTable->size; i++)
+         {
+            LockBucket& bucket = currentTable->buckets[i];
+
+            for(ValueLock* lock = bucket.head.load(std::memory_order_relaxed); lock; )
+            {
+               ValueLock* next = lock->next.load(std::memory_order_relaxed);
+               delete lock;
+               lock = next;
+            }
+
+            for(ValueLock* lock = bucket.lockBuffer; lock; )
+            {
+               ValueLock* next = lock->next.load(std::memory_order_relaxed);
+               delete lock;
+               lock = next;
+            }
+         }
+
+         delete currentTable;
+
+         for(size_t i = 0; i < retiredTables.size(); i++)
+            delete retiredTables[i];
+      }
+
       // Acquires a lock descriptor for `value`. The descriptor is only acquired, not locked;
       // locking and unlocking is left to the user. Increments the reference count of the returned
       // descriptor. The descriptor must be released with `putLock` when done.
       ValueLock& getLockFor(const Value& value)
       {
          const uint32_t valueHash = ValueLockHash<Value>()(value);
-         LockBucket& bucket = buckets[valueHash % HashSize];
 
-         ValueLock* lock = NULL;
+         ValueLock* lock = lookupUnlocked(value, valueHash);
+         if(lock)
+            return *lock;
 
-         bucket.mtx.lock();
+         BucketTable* lockedTable;
+         LockBucket& bucket = lockBucket(valueHash, lockedTable);
+         bool needGrow = false;
+
+         // (all descriptors in the chain have references while we hold the bucket mutex)
+         for(lock = bucket.head.load(std::memory_order_relaxed); lock;
+             lock = lock->next.load(std::memory_order_relaxed) )
          {
-            for(typename std::list<ValueLock*>::iterator it = bucket.locks.begin(),
-                     end = bucket.locks.end(); it != end; ++it)
+            if( (lock->hash.load(std::memory_order_relaxed) == valueHash) && (value == lock->value) )
             {
-               if(value == (*it)->value)
-               {
-                  lock = *it;
-                  break;
-               }
+               lock->references.fetch_add(1, std::memory_order_relaxed);
+               break;
             }
+         }
 
-            if(!lock)
+         if(!lock)
+         {
+            if(bucket.lockBuffer)
             {
-               if(bucket.lockBufferSize == 0)
-               {
-                  bucket.locks.push_front(NULL);
-                  lock = new ValueLock(value, bucket, bucket.locks.begin() );
-                  bucket.locks.front() = lock;
-               }
-               else
-               {
-                  bucket.locks.splice(
-                     bucket.locks.begin(),
-                     bucket.lockBuffer,
-                     bucket.lockBuffer.begin() );
-                  bucket.lockBufferSize--;
-
-                  lock = bucket.locks.front();
-                  lock->value = value;
-               }
+               lock = bucket.lockBuffer;
+               bucket.lockBuffer = lock->next.load(std::memory_order_relaxed);
+               bucket.lockBufferSize--;
             }
+            else
+               lock = new ValueLock();
+
+            lock->value = value;
+            lock->hash.store(valueHash, std::memory_order_relaxed);
+            lock->next.store(bucket.head.load(std::memory_order_relaxed),
+               std::memory_order_relaxed);
+            lock->references.store(1, std::memory_order_release);
+
+            bucket.head.store(lock, std::memory_order_release);
+            bucket.numLocks++;
 
-            lock->references++;
+            const size_t numLocksNow = numLocks.fetch_add(1, std::memory_order_relaxed) + 1;
+            needGrow = (numLocksNow > lockedTable->size * VALUELOCKSTORE_MAX_LOAD) &&
+               (lockedTable->size < VALUELOCKSTORE_MAX_HASHSIZE);
          }
+
          bucket.mtx.unlock();
 
+         if(needGrow)
+            grow(lockedTable);
+
          return *lock;
       }
 
@@ -128,34 +243,288 @@ class ValueLockStore
       // When the reference count reaches 0, `lock` is invalidated.
       void putLock(ValueLock& lock)
       {
-         LockBucket& bucket = *lock.bucket;
+         // only the last reference needs the bucket mutex to remove the descriptor from the chain
+         unsigned refs = lock.references.load(std::memory_order_relaxed);
+         while(refs > 1)
+         {
+            if(lock.references.compare_exchange_weak(refs, refs - 1, std::memory_order_release,
+                  std::memory_order_relaxed) )
+               return;
+         }
 
-         bucket.mtx.lock();
-         do {
-            lock.references--;
+         BucketTable* lockedTable;
+         LockBucket& bucket = lockBucket(lock.hash.load(std::memory_order_relaxed), lockedTable);
 
-            if(lock.references > 0)
-               break;
+         if(lock.references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+         {
+            // unlink from the chain. next of the unlinked descriptor stays valid for concurrent
+            // unlocked walks until the descriptor is moved to the buffer below
+            std::atomic<ValueLock*>* link = &bucket.head;
+
+            while(link->load(std::memory_order_relaxed) != &lock)
+               link = &link->load(std::memory_order_relaxed)->next;
+
+            link->store(lock.next.load(std::memory_order_relaxed), std::memory_order_release);
+            bucket.numLocks--;
+
+            numLocks.fetch_sub(1, std::memory_order_relaxed);
+
+            lock.next.store(bucket.lockBuffer, std::memory_order_release);
+            bucket.lockBuffer = &lock;
+            bucket.lockBufferSize++;
+
+            if(bucket.lockBufferSize > BufferSize)
+               trimBufferUnlocked(bucket);
+         }
+
+         bucket.mtx.unlock();
+      }
+
+      // Collects the counters of the store and the maxBuckets buckets with the most contended
+      // mutex acquisitions.
+      ValueLockStoreStats getStats(size_t maxBuckets)
+      {
+         std::lock_guard<Mutex> resizeLock(resizeMutex);
+
+         BucketTable* currentTable = table.load(std::memory_order_relaxed);
+
+         ValueLockStoreStats stats;
+
+         stats.numBuckets = currentTable->size;
+         stats.numLocks = numLocks.load(std::memory_order_relaxed);
+         stats.numBufferedLocks = 0;
+         stats.numResizes = numResizes;
+         stats.numLockings = retiredNumLockings;
+         stats.numContended = retiredNumContended;
+
+         for(size_t i = 0; i < currentTable->size; i++)
+         {
+            LockBucket& bucket = currentTable->buckets[i];
+            ValueLockStoreStats::BucketStats bucketStats;
+
+            bucket.mtx.lock();
+
+            bucketStats.index = i;
+            bucketStats.numLocks = bucket.numLocks;
+            bucketStats.numLockings = bucket.numLockings;
+            bucketStats.numContended = bucket.numContended;
+
+            stats.numBufferedLocks += bucket.lockBufferSize;
+
+            bucket.mtx.unlock();
+
+            stats.numLockings += bucketStats.numLockings;
+            stats.numContended += bucketStats.numContended;
+
+            if(bucketStats.numContended)
+               stats.mostContendedBuckets.push_back(bucketStats);
+         }
+
+         std::sort(stats.mostContendedBuckets.begin(), stats.mostContendedBuckets.end(),
+            [] (const ValueLockStoreStats::BucketStats& a,
+                const ValueLockStoreStats::BucketStats& b) {
+               return a.numContended > b.numContended;
+            });
+
+         if(stats.mostContendedBuckets.size() > maxBuckets)
+            stats.mostContendedBuckets.resize(maxBuckets);
+
+         return stats;
+      }
 
-            if(bucket.lockBufferSize < BufferSize)
+   private:
+      std::atomic<BucketTable*> table;
+      std::atomic<size_t> numLocks;
+
+      Mutex resizeMutex; // serializes grow() and getStats(), protects fields below
+      std::vector<BucketTable*> retiredTables; // (may still be accessed by unlocked walks)
+      uint64_t numResizes;
+      uint64_t retiredNumLockings; // counters of the buckets of retired tables
+      uint64_t retiredNumContended;
+
+      // Finds a descriptor that is currently in use without taking the bucket mutex and
+      // references it.
+      ValueLock* lookupUnlocked(const Value& value, uint32_t valueHash)
+      {
+         BucketTable* currentTable = table.load(std::memory_order_acquire);
+         LockBucket& bucket = currentTable->bucketFor(valueHash);
+         ValueLock* foundLock = NULL;
+         ValueLock* otherLock = NULL; // referenced descriptor of another value with the same hash
+
+         // (pairs with the fences in trimBufferUnlocked() and grow(): either they see this walk, or
+         // the walk sees the chain without the descriptors that they are about to free or move)
+         bucket.numWalkers.fetch_add(1, std::memory_order_relaxed);
+         std::atomic_thread_fence(std::memory_order_seq_cst);
+
+         ValueLock* lock = bucket.head.load(std::memory_order_acquire);
+
+         for(unsigned hops = 0; lock && (hops < VALUELOCKSTORE_MAX_LOOKUP_HOPS);
+             hops++, lock = lock->next.load(std::memory_order_acquire) )
+         {
+            if(lock->hash.load(std::memory_order_relaxed) != valueHash)
+               continue;
+
+            unsigned refs = lock->references.load(std::memory_order_relaxed);
+            bool isReferenced = false;
+
+            while(refs > 0)
             {
-               bucket.lockBuffer.splice(
-                  bucket.lockBuffer.begin(),
-                  bucket.locks,
-                  lock.iter);
-               bucket.lockBufferSize++;
+               if(lock->references.compare_exchange_weak(refs, refs + 1,
+                     std::memory_order_acquire, std::memory_order_relaxed) )
+               {
+                  isReferenced = true;
+                  break;
+               }
             }
+
+            if(!isReferenced)
+               continue; // unused => value may change at any time
+
+            if(value == lock->value)
+               foundLock = lock;
             else
-            {
-               bucket.locks.erase(lock.iter);
-               delete &lock;
+               otherLock = lock;
+
+            break;
+         }
+
+         bucket.numWalkers.fetch_sub(1, std::memory_order_release);
+
+         // (not while the walk is counted, grow() waits for the walks with all bucket mutexes held)
+         if(otherLock)
+            putLock(*otherLock);
+
+         return foundLock;
+      }
+
+      // Frees the buffered descriptors beyond BufferSize, unless an unlocked walk is active in the
+      // bucket that may still be on one of them; a later call frees them in this case. Caller must
+      // hold the bucket mutex.
+      void trimBufferUnlocked(LockBucket& bucket)
+      {
+         // (buffered descriptors were unlinked before this fence, so walks that start after it
+         // can't reach them anymore)
+         std::atomic_thread_fence(std::memory_order_seq_cst);
+
+         if(bucket.numWalkers.load(std::memory_order_acquire) )
+            return;
+
+         while(bucket.lockBufferSize > BufferSize)
+         {
+            ValueLock* lock = bucket.lockBuffer;
+
+            bucket.lockBuffer = lock->next.load(std::memory_order_relaxed);
+            bucket.lockBufferSize--;
+
+            delete lock;
+         }
+      }
+
+      // Locks the bucket for the given hash in the current table. The table doesn't change while
+      // the bucket mutex is held.
+      LockBucket& lockBucket(uint32_t hash, BucketTable*& outTable)
+      {
+         for( ; ; )
+         {
+            BucketTable* currentTable = table.load(std::memory_order_acquire);
+            LockBucket& bucket = currentTable->bucketFor(hash);
+
+            const bool isContended = !bucket.mtx.tryLock();
+            if(isContended)
+               bucket.mtx.lock();
+
+            if(table.load(std::memory_order_relaxed) != currentTable)
+            { // table was replaced while we waited for the bucket
+               bucket.mtx.unlock();
+               continue;
             }
-         } while (0);
-         bucket.mtx.unlock();
+
+            bucket.numLockings++;
+            if(isContended)
+               bucket.numContended++;
+
+            outTable = currentTable;
+            return bucket;
+         }
       }
 
-   private:
-      LockBucket buckets[HashSize];
+      // Doubles the number of buckets. The old table is kept until the store is destroyed,
+      // because unlocked walks and callers of lockBucket() may still access it.
+      void grow(BucketTable* oldTable)
+      {
+         std::lock_guard<Mutex> resizeLock(resizeMutex);
+
+         if(table.load(std::memory_order_relaxed) != oldTable)
+            return; // somebody else was faster
+
+         // (nobody holds more than one bucket mutex, so we can't deadlock here)
+         for(size_t i = 0; i < oldTable->size; i++)
+            oldTable->buckets[i].mtx.lock();
+
+         BucketTable* newTable = new BucketTable(oldTable->size * 2);
+         size_t nextBufferBucket = 0;
+
+         for(size_t i = 0; i < oldTable->size; i++)
+         {
+            LockBucket& oldBucket = oldTable->buckets[i];
+
+            for(ValueLock* lock = oldBucket.head.load(std::memory_order_relaxed); lock; )
+            {
+               ValueLock* next = lock->next.load(std::memory_order_relaxed);
+               LockBucket& newBucket = newTable->bucketFor(
+                  lock->hash.load(std::memory_order_relaxed) );
+
+               lock->next.store(newBucket.head.load(std::memory_order_relaxed),
+                  std::memory_order_relaxed);
+               newBucket.head.store(lock, std::memory_order_relaxed);
+               newBucket.numLocks++;
+
+               lock = next;
+            }
+
+            for(ValueLock* lock = oldBucket.lockBuffer; lock; )
+            { // (spread the buffered descriptors evenly)
+               ValueLock* next = lock->next.load(std::memory_order_relaxed);
+               LockBucket& newBucket = newTable->buckets[nextBufferBucket++ % newTable->size];
+
+               lock->next.store(newBucket.lockBuffer, std::memory_order_relaxed);
+               newBucket.lockBuffer = lock;
+               newBucket.lockBufferSize++;
+
+               lock = next;
+            }
+
+            oldBucket.head.store(NULL, std::memory_order_relaxed);
+            oldBucket.lockBuffer = NULL;
+            oldBucket.lockBufferSize = 0;
+
+            retiredNumLockings += oldBucket.numLockings;
+            retiredNumContended += oldBucket.numContended;
+         }
+
+         // walks that start from now on see the empty old chains and fall back to lockBucket().
+         // the new table is published only when the walks that may still be on the moved
+         // descriptors are done, so that trimBufferUnlocked() only has to consider the walks of
+         // the current table.
+         std::atomic_thread_fence(std::memory_order_seq_cst);
+
+         for(size_t i = 0; i < oldTable->size; i++)
+         {
+            while(oldTable->buckets[i].numWalkers.load(std::memory_order_acquire) )
+               std::this_thread::yield();
+         }
+
+         for(size_t i = 0; i < newTable->size; i++)
+            trimBufferUnlocked(newTable->buckets[i]); // (no walks yet)
+
+         table.store(newTable, std::memory_order_release);
+
+         retiredTables.push_back(oldTable);
+         numResizes++;
+
+         for(size_t i = 0; i < oldTable->size; i++)
+            oldTable->buckets[i].mtx.unlock();
+      }
 };
 
 
@@ -214,6 +583,30 @@ typedef HashDirLockStore::ValueLock HashDirLockData;
 class EntryLockStore
 {
    public:
+      /**
+       * Records the hashes of all values that the current thread locks while it exists, e.g. to
+       * find the earlier forwarded operations on the same entries (see MirrorForwardPipeline).
+       */
+      class LockHashRecorder
+      {
+         public:
+            LockHashRecorder(std::vector<uint32_t>& outHashes) : prevHashes(currentHashes)
+            {
+               currentHashes = &outHashes;
+            }
+
+            ~LockHashRecorder()
+            {
+               currentHashes = prevHashes;
+            }
+
+            LockHashRecorder(const LockHashRecorder&) = delete;
+            LockHashRecorder& operator=(const LockHashRecorder&) = delete;
+
+         private:
+            std::vector<uint32_t>* prevHashes;
+      };
+
       ParentNameLockData* lock(const std::string& parentID, const std::string& name);
       //FileIDLock is used for both files and directories
       FileIDLockData* lock(const std::string& fileID, const bool writeLock);
@@ -223,7 +616,17 @@ class EntryLockStore
       void unlock(FileIDLockData* fileIDLockData);
       void unlock(HashDirLockData* hashDirLockData);
 
+      std::string getStatsAsStr(size_t maxBuckets);
+
    private:
+      static void recordLockHash(uint32_t hash)
+      {
+         if(currentHashes)
+            currentHashes->push_back(hash);
+      }
+
+      static __thread std::vector<uint32_t>* currentHashes; // of the active LockHashRecorder
+
       ParentNameLockStore parentNameLocks;
       FileIDLockStore fileLocks;
       HashDirLockStore hashDirLocks;
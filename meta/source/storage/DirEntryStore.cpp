@@ -138,6 +138,14 @@ bool DirEntryStore::rmDirEntryStoreDir(const std::string& id, bool isBuddyMirror
       "Removing content directory: " + contentsDirStr + "; " "id: " + id + "; isBuddyMirrored: "
       + StringTk::intToStr(isBuddyMirrored));
 
+   // close handles of paused listings (they would keep the removed directories alive)
+   DirListCursorCache* cursorCache = app->getDirListCursorCache();
+   if(cursorCache)
+   {
+      cursorCache->invalidate(contentsDirIDStr);
+      cursorCache->invalidate(contentsDirStr);
+   }
+
    // remove the dirEntryID directory
    int rmdirIdRes = rmdir(contentsDirIDStr.c_str() );
    if(rmdirIdRes)
@@ -475,19 +483,33 @@ FhgfsOpsErr DirEntryStore::listIncrementalEx(int64_t serverOffset,
 
    UniqueRWLock lock(rwlock, SafeRWLock_READ); // L O C K
 
-   DIR* dirHandle = opendir(getDirEntryPathUnlocked().c_str() );
+   DirListCursorCache* cursorCache = Program::getApp()->getDirListCursorCache();
+   bool stoppedBySizeLimit = false;
+   int64_t lastReturnedOffset = serverOffset;
+
+   const uint64_t cursorGeneration = cursorCache ?
+      cursorCache->getGeneration(getDirEntryPathUnlocked() ) : 0;
+
+   // try to continue a previous listing with its still open handle
+   DIR* dirHandle = (serverOffset && cursorCache) ?
+      cursorCache->take(getDirEntryPathUnlocked(), serverOffset, false) : NULL;
+
    if (!dirHandle)
    {
-      LogContext(logContext).logErr(std::string("Unable to open dentry directory: ") +
-         getDirEntryPathUnlocked() + ". SysErr: " + System::getErrString() );
+      dirHandle = opendir(getDirEntryPathUnlocked().c_str() );
+      if (!dirHandle)
+      {
+         LogContext(logContext).logErr(std::string("Unable to open dentry directory: ") +
+            getDirEntryPathUnlocked() + ". SysErr: " + System::getErrString() );
 
-      return retVal;
-   }
+         return retVal;
+      }
 
-   // seek to offset (if provided)
-   if(serverOffset)
-   {
-      seekdir(dirHandle, serverOffset); // (seekdir has no return value)
+      // seek to offset (if provided)
+      if(serverOffset)
+      {
+         seekdir(dirHandle, serverOffset); // (seekdir has no return value)
+      }
    }
 
    // loop over the actual directory entries
@@ -570,6 +592,8 @@ FhgfsOpsErr DirEntryStore::listIncrementalEx(int64_t serverOffset,
             "Current Entry size: " + std::to_string(currEntrySize) + " bytes, "
             "Available: " + std::to_string(availableRespBufSize) + " bytes, "
             "Total Entries returned: " + std::to_string(numEntries));
+
+         stoppedBySizeLimit = true;
          break;
       }
 
@@ -580,6 +604,7 @@ FhgfsOpsErr DirEntryStore::listIncrementalEx(int64_t serverOffset,
          outArgs.outServerOffsets->push_back(dirEntry->d_off);
 
       SAFE_ASSIGN(outArgs.outNewServerOffset, dirEntry->d_off);
+      lastReturnedOffset = dirEntry->d_off;
 
       if(outArgs.outEntryTypes)
          outArgs.outEntryTypes->push_back( (int)entryType);
@@ -602,7 +627,20 @@ FhgfsOpsErr DirEntryStore::listIncrementalEx(int64_t serverOffset,
       retVal = FhgfsOpsErr_SUCCESS;
    }
 
-   closedir(dirHandle);
+   if( (retVal != FhgfsOpsErr_SUCCESS) || !dirEntry || !lastReturnedOffset || !cursorCache)
+   { // error, end of dir reached or nothing to continue from => no need to keep the handle
+      closedir(dirHandle);
+      return retVal;
+   }
+
+   // keep the handle for the next batch of this listing
+
+   if(stoppedBySizeLimit)
+      seekdir(dirHandle, lastReturnedOffset); // un-read the entry that didn't fit into the resp
+
+   cursorCache->put(getDirEntryPathUnlocked(), lastReturnedOffset, false, dirHandle,
+      cursorGeneration);
+
    return retVal;
 }
 
@@ -637,35 +675,53 @@ FhgfsOpsErr DirEntryStore::listIDFilesIncremental(int64_t serverOffset,
    uint64_t numEntries = 0;
    struct dirent* dirEntry = NULL;
 
+   DirListCursorCache* cursorCache = Program::getApp()->getDirListCursorCache();
+   const bool useIncrementalOffset = (serverOffset == -1);
+   const int64_t cursorOffset = useIncrementalOffset ? (int64_t)incrementalOffset : serverOffset;
+   DIR* dirHandle = NULL;
+
    SafeRWLock safeLock(&rwlock, SafeRWLock_READ); // L O C K
 
    std::string path = MetaStorageTk::getMetaDirEntryIDPath(getDirEntryPathUnlocked());
 
-   DIR* dirHandle = opendir(path.c_str() );
-   if(!dirHandle)
+   const uint64_t cursorGeneration = cursorCache ? cursorCache->getGeneration(path) : 0;
+
+   // try to continue a previous listing with its still open handle (this also avoids the slow
+   // incremental seek below)
+   if(cursorOffset && cursorCache)
+      dirHandle = cursorCache->take(path, cursorOffset, useIncrementalOffset);
+
+   if(dirHandle)
+      errno = 0; // recommended by posix (readdir(3p) )
+   else
    {
-      LogContext(logContext).logErr(std::string("Unable to open dentry-by-ID directory: ") +
-         path + ". SysErr: " + System::getErrString() );
+      dirHandle = opendir(path.c_str() );
+      if(!dirHandle)
+      {
+         LogContext(logContext).logErr(std::string("Unable to open dentry-by-ID directory: ") +
+            path + ". SysErr: " + System::getErrString() );
 
-      goto err_unlock;
-   }
+         goto err_unlock;
+      }
 
 
-   errno = 0; // recommended by posix (readdir(3p) )
+      errno = 0; // recommended by posix (readdir(3p) )
 
-   // seek to offset
-   if(serverOffset != -1)
-   { // caller provided direct offset
-      seekdir(dirHandle, serverOffset); // (seekdir has no return value)
-   }
-   else
-   { // slow path: incremental seek to current offset
-      for(uint64_t currentOffset = 0;
-          (currentOffset < incrementalOffset) && (dirEntry=StorageTk::readdirFiltered(dirHandle) );
-          currentOffset++)
-      {
-         // (actual seek work done in loop header)
-         *outArgs.outNewServerOffset = dirEntry->d_off;
+      // seek to offset
+      if(!useIncrementalOffset)
+      { // caller provided direct offset
+         seekdir(dirHandle, serverOffset); // (seekdir has no return value)
+      }
+      else
+      { // slow path: incremental seek to current offset
+         for(uint64_t currentOffset = 0;
+             (currentOffset < incrementalOffset) &&
+                (dirEntry=StorageTk::readdirFiltered(dirHandle) );
+             currentOffset++)
+         {
+            // (actual seek work done in loop header)
+            *outArgs.outNewServerOffset = dirEntry->d_off;
+         }
       }
    }
 
@@ -688,7 +744,16 @@ FhgfsOpsErr DirEntryStore::listIDFilesIncremental(int64_t serverOffset,
    }
 
 
-   closedir(dirHandle);
+   if( (retVal == FhgfsOpsErr_SUCCESS) && dirEntry && numEntries && cursorCache)
+   { // keep the handle for the next batch of this listing
+      const int64_t nextCursorOffset = useIncrementalOffset ?
+         (int64_t)(incrementalOffset + numEntries) : *outArgs.outNewServerOffset;
+
+      cursorCache->put(path, nextCursorOffset, useIncrementalOffset, dirHandle,
+         cursorGeneration);
+   }
+   else
+      closedir(dirHandle);
 
 err_unlock:
    safeLock.unlock(); // U N L O C K
@@ -477,7 +477,8 @@ FhgfsOpsErr DirInode::getEntryData(const std::string& entryName, EntryInfo* outI
    if (retVal == FhgfsOpsErr_SUCCESS && DirEntryType_ISREGULARFILE(outInfo->getEntryType() ) )
    {
       bool inStore = fileStore.isInStore(outInfo->getEntryID() );
-      if (inStore)
+      bool isDirty = outInodeMetaData && outInodeMetaData->getDynAttribsDirty();
+      if (inStore || isDirty)
       {  // hint for the caller not to rely on outInodeMetaData
          retVal = FhgfsOpsErr_DYNAMICATTRIBSOUTDATED;
       }
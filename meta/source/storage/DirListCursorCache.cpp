@@ -0,0 +1,198 @@
+#include "DirListCursorCache.h"
+
+
+/**
+ * @param maxCursors max number of cached DIR handles; 0 disables caching.
+ * @param idleTimeoutMS cursors that have not been used for this long are closed.
+ */
+DirListCursorCache::DirListCursorCache(unsigned maxCursors, unsigned idleTimeoutMS) :
+   maxCursors(maxCursors), idleTimeoutMS(idleTimeoutMS), generations()
+{
+}
+
+DirListCursorCache::~DirListCursorCache()
+{
+   for (CursorMapIter iter = cursors.begin(); iter != cursors.end(); iter++)
+      closedir(iter->second.dirHandle);
+}
+
+/**
+ * Get the current generation of a directory, to be passed to put() later. Must be called before
+ * the listing takes or opens a handle of the directory.
+ */
+uint64_t DirListCursorCache::getGeneration(const std::string& path)
+{
+   const std::lock_guard<Mutex> lock(mutex);
+
+   return generations[getGenerationIndex(path)];
+}
+
+/**
+ * Remove a cursor from the cache to continue a listing with it.
+ *
+ * @param path the listed directory.
+ * @param offset the offset at which the caller wants to continue (as returned by the previous
+ *    batch of the listing).
+ * @param isIncrementalOffset true if offset is a number of entries instead of a native d_off.
+ * @return the open DIR handle positioned right behind offset (caller is responsible for either
+ *    calling closedir() or put() on it) or NULL if no such cursor is cached.
+ */
+DIR* DirListCursorCache::take(const std::string& path, int64_t offset, bool isIncrementalOffset)
+{
+   if (!maxCursors)
+      return NULL;
+
+   DIR* dirHandle = NULL;
+   std::vector<DIR*> closableHandles;
+
+   {
+      const std::lock_guard<Mutex> lock(mutex);
+
+      CursorMapIter iter = cursors.find(CursorKey{path, offset, isIncrementalOffset});
+      if (iter != cursors.end() )
+      {
+         dirHandle = iter->second.dirHandle;
+
+         lruList.erase(iter->second.lruIter);
+         cursors.erase(iter);
+      }
+
+      sweepUnlocked(closableHandles);
+   }
+
+   closeHandles(closableHandles);
+
+   return dirHandle;
+}
+
+/**
+ * Store a cursor so that a later take() with the same key can continue the listing.
+ *
+ * @param dirHandle must be positioned such that the next readdir() returns the entry right
+ *    behind offset; belongs to the cache after calling this (it might be closed immediately).
+ * @param generation as returned by getGeneration() before the listing got its handle; the handle
+ *    is closed if the directory was invalidated in the meantime.
+ */
+void DirListCursorCache::put(const std::string& path, int64_t offset, bool isIncrementalOffset,
+   DIR* dirHandle, uint64_t generation)
+{
+   if (!maxCursors)
+   {
+      closedir(dirHandle);
+      return;
+   }
+
+   std::vector<DIR*> closableHandles;
+
+   {
+      const std::lock_guard<Mutex> lock(mutex);
+
+      if (generation != generations[getGenerationIndex(path)] )
+      { // directory invalidated while this listing was in progress (e.g. removed)
+         closableHandles.push_back(dirHandle);
+      }
+      else
+      {
+         CursorKey key{path, offset, isIncrementalOffset};
+
+         // another worker might have continued an identical listing in the meantime
+         CursorMapIter oldIter = cursors.find(key);
+         if (oldIter != cursors.end() )
+            removeUnlocked(oldIter, closableHandles);
+
+         lruList.push_front(key);
+         cursors.insert(std::make_pair(key, Cursor{dirHandle, Time(), lruList.begin()}));
+      }
+
+      sweepUnlocked(closableHandles);
+   }
+
+   closeHandles(closableHandles); // (syscalls outside of the mutex)
+}
+
+/**
+ * Close all cursors of the given directory, e.g. because it is going to be removed. Handles of
+ * listings that are currently in progress will be closed by put().
+ */
+void DirListCursorCache::invalidate(const std::string& path)
+{
+   if (!maxCursors)
+      return;
+
+   std::vector<DIR*> closableHandles;
+
+   {
+      const std::lock_guard<Mutex> lock(mutex);
+
+      generations[getGenerationIndex(path)]++;
+
+      // keys are ordered by path first, so all cursors of this path are in one range
+      CursorMapIter iter = cursors.lower_bound(
+         CursorKey{path, std::numeric_limits<int64_t>::min(), false});
+
+      while (iter != cursors.end() && iter->first.path == path)
+      {
+         CursorMapIter removeIter = iter++;
+         removeUnlocked(removeIter, closableHandles);
+      }
+   }
+
+   closeHandles(closableHandles);
+}
+
+/**
+ * Close the cursors that have been idle for too long.
+ */
+void DirListCursorCache::sweep()
+{
+   std::vector<DIR*> closableHandles;
+
+   {
+      const std::lock_guard<Mutex> lock(mutex);
+
+      sweepUnlocked(closableHandles);
+   }
+
+   closeHandles(closableHandles);
+}
+
+/**
+ * Note: Caller must hold the mutex.
+ *
+ * @param outClosableHandles the DIR handle of the removed cursor will be added here; caller is
+ *    responsible for closing it (after releasing the mutex).
+ */
+void DirListCursorCache::removeUnlocked(CursorMapIter iter, std::vector<DIR*>& outClosableHandles)
+{
+   outClosableHandles.push_back(iter->second.dirHandle);
+
+   lruList.erase(iter->second.lruIter);
+   cursors.erase(iter);
+}
+
+/**
+ * Remove the least recently stored cursors until the cache is within its limit and all cursors
+ * that have been idle for longer than idleTimeoutMS.
+ *
+ * Note: Caller must hold the mutex.
+ */
+void DirListCursorCache::sweepUnlocked(std::vector<DIR*>& outClosableHandles)
+{
+   while (!lruList.empty() )
+   {
+      CursorMapIter iter = cursors.find(lruList.back() );
+
+      if ( (cursors.size() <= maxCursors) &&
+           (iter->second.lastUseT.elapsedMS() < idleTimeoutMS) )
+         break; // all remaining cursors are more recent than this one
+
+      removeUnlocked(iter, outClosableHandles);
+   }
+}
+
+void DirListCursorCache::closeHandles(const std::vector<DIR*>& dirHandles)
+{
+   for (std::vector<DIR*>::const_iterator iter = dirHandles.begin(); iter != dirHandles.end();
+        iter++)
+      closedir(*iter);
+}
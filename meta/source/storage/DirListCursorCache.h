@@ -0,0 +1,104 @@
+#pragma once
+
+#include <common/Common.h>
+#include <common/threading/Mutex.h>
+#include <common/toolkit/Time.h>
+
+#include <dirent.h>
+#include <functional>
+#include <mutex>
+
+
+#define DIRLISTCURSORCACHE_IDLE_TIMEOUT_MS   (60*1000) /* cursors unused for longer are closed */
+#define DIRLISTCURSORCACHE_NUM_GENERATIONS   64 /* invalidation counters (paths are hashed) */
+
+
+/**
+ * Keeps the open DIR handles of paused incremental directory listings, so that the next batch of
+ * a listing (e.g. the next ListDirFromOffsetMsg of a client) can continue exactly where the
+ * previous batch stopped instead of opening the directory again and seeking (or, for the
+ * incremental offset fallback, reading all preceding entries again).
+ *
+ * Cursors are keyed by the listed directory path and the offset at which the listing continues.
+ * A cursor is removed from the cache while it is being used, so a DIR handle is never shared
+ * between workers.
+ *
+ * Each cursor holds an open file descriptor, so the number of cached cursors is bounded; the
+ * least recently stored cursors and cursors that have been idle for too long are closed first.
+ * Idle cursors are also closed by take() and by sweep(), which is called periodically.
+ *
+ * A listing that is in progress while its directory is invalidated must not store its handle
+ * afterwards. So a listing gets the generation of its path before it takes or opens a handle and
+ * put() drops handles of an older generation.
+ */
+class DirListCursorCache
+{
+   public:
+      DirListCursorCache(unsigned maxCursors,
+         unsigned idleTimeoutMS = DIRLISTCURSORCACHE_IDLE_TIMEOUT_MS);
+      ~DirListCursorCache();
+
+      DirListCursorCache(const DirListCursorCache&) = delete;
+      DirListCursorCache& operator=(const DirListCursorCache&) = delete;
+
+      uint64_t getGeneration(const std::string& path);
+      DIR* take(const std::string& path, int64_t offset, bool isIncrementalOffset);
+      void put(const std::string& path, int64_t offset, bool isIncrementalOffset, DIR* dirHandle,
+         uint64_t generation);
+      void invalidate(const std::string& path);
+      void sweep();
+
+
+   private:
+      struct CursorKey
+      {
+         std::string path;
+         int64_t offset; // d_off of the last returned entry or number of returned entries
+         bool isIncrementalOffset; // true if offset is a number of entries instead of a d_off
+
+         bool operator<(const CursorKey& other) const
+         {
+            return std::tie(path, offset, isIncrementalOffset) <
+               std::tie(other.path, other.offset, other.isIncrementalOffset);
+         }
+      };
+
+      typedef std::list<CursorKey> CursorLRUList; // most recently stored cursors at the front
+
+      struct Cursor
+      {
+         DIR* dirHandle;
+         Time lastUseT;
+         CursorLRUList::iterator lruIter;
+      };
+
+      typedef std::map<CursorKey, Cursor> CursorMap;
+      typedef CursorMap::iterator CursorMapIter;
+
+      unsigned maxCursors; // 0 disables caching
+      unsigned idleTimeoutMS;
+      Mutex mutex;
+      CursorMap cursors;
+      CursorLRUList lruList;
+      uint64_t generations[DIRLISTCURSORCACHE_NUM_GENERATIONS]; // incremented by invalidate()
+
+      void removeUnlocked(CursorMapIter iter, std::vector<DIR*>& outClosableHandles);
+      void sweepUnlocked(std::vector<DIR*>& outClosableHandles);
+      static void closeHandles(const std::vector<DIR*>& dirHandles);
+
+      static size_t getGenerationIndex(const std::string& path)
+      {
+         return std::hash<std::string>()(path) % DIRLISTCURSORCACHE_NUM_GENERATIONS;
+      }
+
+
+   public:
+      // getters & setters
+      size_t getSize()
+      {
+         const std::lock_guard<Mutex> lock(mutex);
+
+         return cursors.size();
+      }
+};
+
@@ -0,0 +1,64 @@
+#include "DirtyInodeStore.h"
+
+#include <mutex>
+
+
+/**
+ * Register an inode with deferred dynamic attribs update or refresh its entryInfo if it is already
+ * registered (the time of the first deferral is kept).
+ */
+void DirtyInodeStore::add(EntryInfo* entryInfo)
+{
+   std::lock_guard<Mutex> lock(mutex);
+
+   // (a new element gets the current time as dirtySince)
+   inodes[entryInfo->getEntryID()].entryInfo = *entryInfo;
+}
+
+/**
+ * Remove and return the inodes that have been dirty for at least the given time.
+ */
+EntryInfoList DirtyInodeStore::takeOlderThan(unsigned ageMS)
+{
+   EntryInfoList outEntries;
+
+   std::lock_guard<Mutex> lock(mutex);
+
+   for(DirtyInodeMap::iterator iter = inodes.begin(); iter != inodes.end(); )
+   {
+      if(iter->second.dirtySince.elapsedMS() < ageMS)
+      {
+         iter++;
+         continue;
+      }
+
+      outEntries.push_back(iter->second.entryInfo);
+      iter = inodes.erase(iter);
+   }
+
+   return outEntries;
+}
+
+/**
+ * Remove and return all inodes.
+ */
+EntryInfoList DirtyInodeStore::takeAll()
+{
+   EntryInfoList outEntries;
+
+   std::lock_guard<Mutex> lock(mutex);
+
+   for(DirtyInodeMap::iterator iter = inodes.begin(); iter != inodes.end(); iter++)
+      outEntries.push_back(iter->second.entryInfo);
+
+   inodes.clear();
+
+   return outEntries;
+}
+
+size_t DirtyInodeStore::getSize()
+{
+   std::lock_guard<Mutex> lock(mutex);
+
+   return inodes.size();
+}
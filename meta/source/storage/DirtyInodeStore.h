@@ -0,0 +1,39 @@
+#pragma once
+
+#include <common/storage/EntryInfo.h>
+#include <common/threading/Mutex.h>
+#include <common/toolkit/Time.h>
+#include <common/Common.h>
+
+#include <map>
+
+
+/**
+ * File inodes whose dynamic attribs were updated only in memory on close (see
+ * FileInode::decNumSessionsAndStore() ), so that they can be written back after a while.
+ *
+ * Note: Entries are not removed when an inode is stored for other reasons (e.g. because the last
+ * writer closed it), flushing an inode that is not dirty anymore is a no-op.
+ */
+class DirtyInodeStore
+{
+   public:
+      void add(EntryInfo* entryInfo);
+      EntryInfoList takeOlderThan(unsigned ageMS);
+      EntryInfoList takeAll();
+      size_t getSize();
+
+
+   private:
+      struct DirtyInode
+      {
+         EntryInfo entryInfo; // from the latest deferred close
+         Time dirtySince; // first deferred close since the last flush
+      };
+
+      typedef std::map<std::string, DirtyInode> DirtyInodeMap; // key is entryID
+
+      Mutex mutex;
+      DirtyInodeMap inodes;
+};
+
@@ -814,7 +814,7 @@ unsigned DiskMetaData::getSupportedDentryFeatureFlags()
 unsigned DiskMetaData::getSupportedDentryV4FileInodeFeatureFlags()
 {
    return FILEINODE_FEATURE_MIRRORED | FILEINODE_FEATURE_BUDDYMIRRORED |
-      FILEINODE_FEATURE_HAS_VERSIONS;
+      FILEINODE_FEATURE_HAS_VERSIONS | FILEINODE_FEATURE_DYNATTRIBS_DIRTY;
 }
 
 /**
@@ -824,7 +824,8 @@ unsigned DiskMetaData::getSupportedDentryV5FileInodeFeatureFlags()
 {
    return FILEINODE_FEATURE_MIRRORED | FILEINODE_FEATURE_BUDDYMIRRORED |
       FILEINODE_FEATURE_HAS_ORIG_PARENTID | FILEINODE_FEATURE_HAS_ORIG_UID |
-      FILEINODE_FEATURE_HAS_VERSIONS | FILEINODE_FEATURE_HAS_RST | FILEINODE_FEATURE_HAS_STATE_FLAGS;
+      FILEINODE_FEATURE_HAS_VERSIONS | FILEINODE_FEATURE_HAS_RST | FILEINODE_FEATURE_HAS_STATE_FLAGS |
+      FILEINODE_FEATURE_DYNATTRIBS_DIRTY;
 }
 
 /**
@@ -33,6 +33,7 @@ FileInode::FileInode(std::string entryID, FileInodeStoreData* inodeDiskData,
    this->exclusiveTID     = 0;
    this->numSessionsRead  = 0;
    this->numSessionsWrite = 0;
+   this->dynAttribsDeferred = false;
 
    initFileInfoVec();
 
@@ -51,6 +52,7 @@ FileInode::FileInode()
    this->exclusiveTID     = 0;
    this->numSessionsRead  = 0;
    this->numSessionsWrite = 0;
+   this->dynAttribsDeferred = false;
 
    this->dentryCompatData.entryType    = DirEntryType_INVALID;
    this->dentryCompatData.featureFlags = 0;
@@ -217,6 +219,14 @@ FhgfsOpsErr FileInode::clearRemoteStorageTarget(EntryInfo* entryInfo)
  * Note: This currently includes persistent metadata update for efficiency reasons (because
  * we already hold the mutex lock here).
  *
+ * If tuneInodeWriteBackSecs is set, the update of a close of a write session (and of any close
+ * while such an update is pending) is deferred. The first deferred update stores the inode with
+ * FILEINODE_FEATURE_DYNATTRIBS_DIRTY, so that the stored dynamic attribs are not trusted until the
+ * inode was written back (see getStatDataUnlocked() ). Later closes only update the inode in
+ * memory until the DirtyInodeStore entry expires (see MetaStore::flushDirtyInodes() ). If the
+ * inode is unloaded after the last close before that, the update is lost and the dynamic attribs
+ * are refreshed from the storage targets instead, by the next stat or by the write-back.
+ *
  * @param accessFlags OPENFILE_ACCESS_... flags
  */
 void FileInode::decNumSessionsAndStore(EntryInfo* entryInfo, unsigned accessFlags)
@@ -248,12 +258,84 @@ void FileInode::decNumSessionsAndStore(EntryInfo* entryInfo, unsigned accessFlag
          this->numSessionsWrite--;
    }
 
-   // dyn attribs have been updated during close, so we save them here
-   storeUpdatedInodeUnlocked(entryInfo);
+   // dyn attribs have been updated during close, so we save them here (or defer that)
+   if(isDynAttribsWriteBackAllowedUnlocked(accessFlags) )
+   {
+      if(!inodeDiskData.getDynAttribsDirty() )
+      {
+         inodeDiskData.setDynAttribsDirty(true);
+         storeUpdatedInodeUnlocked(entryInfo);
+      }
+
+      dynAttribsDeferred = true;
+
+      Program::getApp()->getMetaStore()->getDirtyInodeStore()->add(entryInfo);
+   }
+   else
+   {
+      inodeDiskData.setDynAttribsDirty(false);
+      dynAttribsDeferred = false;
+
+      storeUpdatedInodeUnlocked(entryInfo);
+   }
 
    safeLock.unlock();
 }
 
+/**
+ * Write back the dynamic attribs if their update was deferred by decNumSessionsAndStore().
+ *
+ * @param attribsRefreshed true if the caller just refreshed the dyn attribs from the storage
+ *    targets, so that they can be stored even if the deferred update itself was lost.
+ * @return FhgfsOpsErr_DYNAMICATTRIBSOUTDATED if the stored attribs are dirty, but the deferred
+ *    update is not in memory anymore (the inode was unloaded in the meantime), so they must be
+ *    refreshed from the storage targets first; FhgfsOpsErr_INTERNAL if storing the inode failed.
+ */
+FhgfsOpsErr FileInode::flushDynAttribs(EntryInfo* entryInfo, bool attribsRefreshed)
+{
+   RWLockGuard lock(rwlock, SafeRWLock_WRITE);
+
+   if(!inodeDiskData.getDynAttribsDirty() )
+      return FhgfsOpsErr_SUCCESS;
+
+   if(!dynAttribsDeferred && !attribsRefreshed)
+      return FhgfsOpsErr_DYNAMICATTRIBSOUTDATED;
+
+   inodeDiskData.setDynAttribsDirty(false);
+
+   if(!storeUpdatedInodeUnlocked(entryInfo) )
+   {
+      inodeDiskData.setDynAttribsDirty(true);
+      return FhgfsOpsErr_INTERNAL;
+   }
+
+   dynAttribsDeferred = false;
+
+   return FhgfsOpsErr_SUCCESS;
+}
+
+/**
+ * @param accessFlags OPENFILE_ACCESS_... flags of the closed session
+ * @return true if the dyn attribs update of a close may be kept in memory.
+ */
+bool FileInode::isDynAttribsWriteBackAllowedUnlocked(unsigned accessFlags)
+{
+   App* app = Program::getApp();
+
+   if(!app->getConfig()->getTuneInodeWriteBackSecs() )
+      return false;
+
+   // (a read-only close only changes the atime, it is deferred only if an update is pending anyway)
+   if( (accessFlags & OPENFILE_ACCESS_READ) && !dynAttribsDeferred)
+      return false;
+
+   // a running resync copies the inodes from disk
+   if(getIsBuddyMirroredUnlocked() && app->getInternodeSyncer()->getResyncInProgress() )
+      return false;
+
+   return true;
+}
+
 
 /**
  * Note: This version is compatible with sparse files.
@@ -1878,9 +1960,36 @@ std::pair<bool, LockRangeNotifyList> FileInode::flockRangeUnlocked(RangeLockDeta
          if(lockDetails.allowsWaiting() )
          { // we have conflictors and locker wants to wait
             waitersExclRangeFLock.push_back(lockDetails);
+            waitersExclRangeFLockIndex.insert(lockDetails);
             waitersLockIDsRangeFLock.insert(lockDetails.lockAckID);
          }
       }
+
+      // update statistics
+
+      if(!hasConflicts)
+         rangeFLockStats.numGrantedImmediately++;
+      else
+      if(!lockDetails.allowsWaiting() )
+         rangeFLockStats.numRejected++;
+      else
+      {
+         size_t numWaiters = waitersLockIDsRangeFLock.size();
+
+         rangeFLockStats.numEnqueued++;
+
+         if(numWaiters > rangeFLockStats.maxQueuedWaiters)
+         {
+            rangeFLockStats.maxQueuedWaiters = numWaiters;
+
+            // (log only for each power of two to identify contended files without flooding the log)
+            if( (numWaiters >= FILEINODE_RANGELOCK_CONTENDED_WAITERS) &&
+                !(numWaiters & (numWaiters - 1) ) )
+               LOG(GENERAL, NOTICE, "Range locks of file are contended.",
+                     ("entryID", getEntryIDUnlocked() ), ("queuedWaiters", numWaiters),
+                     ("stats", rangeFLockStats.toString() ) );
+         }
+      }
    }
 
    if (tryNextWaiters)
@@ -1898,6 +2007,7 @@ void FileInode::flockRangeCancelAllWaiters()
 
    waitersLockIDsRangeFLock.clear();
    waitersExclRangeFLock.clear();
+   waitersExclRangeFLockIndex.clear();
    waitersSharedRangeFLock.clear();
 }
 
@@ -1913,47 +2023,19 @@ LockRangeNotifyList FileInode::flockRangeCancelByClientID(NumNodeID clientNumID)
 
    bool tryNextWaiters = false;
 
-   // exclusive locks
+   auto isClientLock = [clientNumID] (const RangeLockDetails& lock) {
+      return (lock.clientNumID == clientNumID);
+   };
 
-   for(RangeLockExclSetIter iter = exclRangeFLocks.begin();
-       iter != exclRangeFLocks.end();
-       /* iter inc'ed inside loop */ )
-   {
-      if(iter->clientNumID == clientNumID)
-      {
-         RangeLockExclSetIter iterNext = iter;
-         iterNext++;
-
-         exclRangeFLocks.erase(iter);
-
-         iter = iterNext;
-         tryNextWaiters = true;
-         continue;
-      }
+   // exclusive locks
 
-      iter++;
-   }
+   if(exclRangeFLocks.eraseIf(isClientLock) )
+      tryNextWaiters = true;
 
    // shared locks
 
-   for(RangeLockSharedSetIter iter = sharedRangeFLocks.begin();
-       iter != sharedRangeFLocks.end();
-       /* iter inc'ed inside loop */ )
-   {
-      if(iter->clientNumID == clientNumID)
-      {
-         RangeLockSharedSetIter iterNext = iter;
-         iterNext++;
-
-         sharedRangeFLocks.erase(iter);
-
-         iter = iterNext;
-         tryNextWaiters = true;
-         continue;
-      }
-
-      iter++;
-   }
+   if(sharedRangeFLocks.eraseIf(isClientLock) )
+      tryNextWaiters = true;
 
    // waiters exlusive
 
@@ -1964,6 +2046,7 @@ LockRangeNotifyList FileInode::flockRangeCancelByClientID(NumNodeID clientNumID)
       if(iter->clientNumID == clientNumID)
       {
          waitersLockIDsRangeFLock.erase(iter->lockAckID);
+         waitersExclRangeFLockIndex.erase(*iter);
          iter = waitersExclRangeFLock.erase(iter);
 
          tryNextWaiters = true;
@@ -2013,47 +2096,19 @@ bool FileInode::flockRangeCancelByHandle(RangeLockDetails& lockDetails)
 
    bool tryNextWaiters = false;
 
-   // exclusive locks
+   auto isHandleLock = [&lockDetails] (const RangeLockDetails& lock) {
+      return lockDetails.equalsHandle(lock);
+   };
 
-   for(RangeLockExclSetIter iter = exclRangeFLocks.begin();
-       iter != exclRangeFLocks.end();
-       /* iter inc'ed inside loop */ )
-   {
-      if(lockDetails.equalsHandle(*iter) )
-      {
-         RangeLockExclSetIter iterNext = iter;
-         iterNext++;
-
-         exclRangeFLocks.erase(iter);
-
-         iter = iterNext;
-         tryNextWaiters = true;
-         continue;
-      }
+   // exclusive locks
 
-      iter++;
-   }
+   if(exclRangeFLocks.eraseIf(isHandleLock) )
+      tryNextWaiters = true;
 
    // shared locks
 
-   for(RangeLockSharedSetIter iter = sharedRangeFLocks.begin();
-       iter != sharedRangeFLocks.end();
-       /* iter inc'ed inside loop */ )
-   {
-      if(lockDetails.equalsHandle(*iter) )
-      {
-         RangeLockSharedSetIter iterNext = iter;
-         iterNext++;
-
-         sharedRangeFLocks.erase(iter);
-
-         iter = iterNext;
-         tryNextWaiters = true;
-         continue;
-      }
-
-      iter++;
-   }
+   if(sharedRangeFLocks.eraseIf(isHandleLock) )
+      tryNextWaiters = true;
 
    // waiters exlusive
 
@@ -2064,6 +2119,7 @@ bool FileInode::flockRangeCancelByHandle(RangeLockDetails& lockDetails)
       if(lockDetails.equalsHandle(*iter) )
       {
          waitersLockIDsRangeFLock.erase(iter->lockAckID);
+         waitersExclRangeFLockIndex.erase(*iter);
          iter = waitersExclRangeFLock.erase(iter);
 
          tryNextWaiters = true;
@@ -2111,11 +2167,11 @@ bool FileInode::flockRangeGetConflictor(RangeLockDetails& lockDetails, RangeLock
 
 /**
  * Note: see flockRangeCheckConflictsEx() for comments (this is just the simple version which
- * checks the whole excl waiters queue and hence is inappropriate for tryNextWaiters() ).
+ * checks against all excl waiters and hence is inappropriate for tryNextWaiters() ).
  */
 bool FileInode::flockRangeCheckConflicts(RangeLockDetails& lockDetails, RangeLockDetails* outConflictor)
 {
-   return flockRangeCheckConflictsEx(lockDetails, -1, outConflictor);
+   return flockRangeCheckConflictsEx(lockDetails, waitersExclRangeFLockIndex, outConflictor);
 }
 
 
@@ -2123,16 +2179,15 @@ bool FileInode::flockRangeCheckConflicts(RangeLockDetails& lockDetails, RangeLoc
  * Note: Automatically ignores self-conflicts (locks that could be up- or downgraded)
  * Note: unlocked, so hold the mutex when calling this
  *
+ * @param exclWaiters the pending excl requests that the given lock must not overtake; only
+ * tryNextWaiters passes a subset of the queue here (the waiters that remain queued before the
+ * checked element), all other callers probably want to pass the whole queue.
  * @param outConflictor first identified conflicting lock (only set if true is returned; can be
  * NULL if caller is not interested)
- * @param maxExclWaitersCheckNum only required by tryNextWaiters to find out how many pending excls
- * in the queue before the checked element should be tested for conflicts (ie for the 5th queue
- * element you will pass 4 here); -1 will check the whole queue, which is what all other callers
- * probably want to do.
  * @return true if there is a conflict with a lock that is not owned by the current lock requestor
  */
-bool FileInode::flockRangeCheckConflictsEx(RangeLockDetails& lockDetails, int maxExclWaitersCheckNum,
-   RangeLockDetails* outConflictor)
+bool FileInode::flockRangeCheckConflictsEx(RangeLockDetails& lockDetails,
+   const RangeLockTree& exclWaiters, RangeLockDetails* outConflictor)
 {
    // note: we also check waiting writers here, because we have writer preference and so we don't
       // want to grant access for a new reader if we have a waiting writer
@@ -2142,60 +2197,21 @@ bool FileInode::flockRangeCheckConflictsEx(RangeLockDetails& lockDetails, int ma
 
    // check conflicting exclusive locks (for shared & exclusive requests)
 
-   for(RangeLockExclSetCIter iterExcl = exclRangeFLocks.begin();
-       (iterExcl != exclRangeFLocks.end() ) && (iterExcl->start <= lockDetails.end);
-       iterExcl++)
-   {
-      if(lockDetails.overlaps(*iterExcl) &&
-         !lockDetails.equalsHandle(*iterExcl) )
-      {
-         SAFE_ASSIGN(outConflictor, *iterExcl);
-         return true;
-      }
-   }
+   if(exclRangeFLocks.findConflict(lockDetails, outConflictor) )
+      return true;
 
    // no conflicting exclusive lock exists
 
-   if(lockDetails.isExclusive() )
-   { // exclusive lock request: check conflicting shared locks
-
-      // check granted shared locks
-
-      for(RangeLockSharedSetCIter iterShared = sharedRangeFLocks.begin();
-          iterShared != sharedRangeFLocks.end();
-          iterShared++)
-      {
-         if(lockDetails.overlaps(*iterShared) &&
-            !lockDetails.equalsHandle(*iterShared) )
-         {
-            SAFE_ASSIGN(outConflictor, *iterShared);
-            return true;
-         }
-      }
-   }
+   // exclusive lock request: check conflicting shared locks
+   if(lockDetails.isExclusive() && sharedRangeFLocks.findConflict(lockDetails, outConflictor) )
+      return true;
 
    // no conflicting shared lock exists
 
    // check waiting writers (for shared reqs to prefer writers and for excl reqs to avoid
       // writer starvation of partially overlapping waiting writers)
 
-   // (note: keep in mind that maxExclWaitersCheckNum can also be -1 for infinite checks)
-
-   for(RangeLockDetailsListCIter iter = waitersExclRangeFLock.begin();
-       (iter != waitersExclRangeFLock.end() ) && (maxExclWaitersCheckNum != 0);
-       iter++, maxExclWaitersCheckNum--)
-   {
-      if(lockDetails.overlaps(*iter) &&
-         !lockDetails.equalsHandle(*iter) )
-      {
-         SAFE_ASSIGN(outConflictor, *iter);
-         return true;
-      }
-   }
-
-
-
-   return false;
+   return exclWaiters.findConflict(lockDetails, outConflictor);
 }
 
 
@@ -2206,38 +2222,7 @@ bool FileInode::flockRangeCheckConflictsEx(RangeLockDetails& lockDetails, int ma
  */
 void FileInode::flockRangeShared(RangeLockDetails& lockDetails)
 {
-   // insert shared lock request...
-   // (avoid duplicates and side-by-side locks for same file handles by merging)
-
-   for(RangeLockSharedSetIter iterShared = sharedRangeFLocks.begin();
-       iterShared != sharedRangeFLocks.end();
-       /* conditional iter increment inside loop */ )
-   {
-      bool incIterAtEnd = true;
-
-      if(lockDetails.equalsHandle(*iterShared) && lockDetails.isMergeable(*iterShared) )
-      { // same handle => merge with existing lock
-
-         // note: all overlaps will be merged into lockDetails, so every other overlapping entry
-            // can be removed here
-
-         lockDetails.merge(*iterShared);
-
-         RangeLockExclSetIter iterSharedNext(iterShared);
-         iterSharedNext++;
-
-         sharedRangeFLocks.erase(iterShared);
-
-         iterShared = iterSharedNext;
-         incIterAtEnd = false;
-      }
-
-      if(incIterAtEnd)
-         iterShared++;
-   }
-
-   // actually insert the new lock
-   sharedRangeFLocks.insert(lockDetails);
+   flockRangeInsertMerged(sharedRangeFLocks, lockDetails);
 }
 
 /**
@@ -2247,39 +2232,41 @@ void FileInode::flockRangeShared(RangeLockDetails& lockDetails)
  */
 void FileInode::flockRangeExclusive(RangeLockDetails& lockDetails)
 {
-   // insert excl lock request...
-   // (avoid duplicates and side-by-side locks for same file handles by merging)
+   flockRangeInsertMerged(exclRangeFLocks, lockDetails);
+}
 
-   // (note: lockDetails.end+1: because we're also looking for extensions, not only overlaps)
-   for(RangeLockExclSetIter iterExcl = exclRangeFLocks.begin();
-       (iterExcl != exclRangeFLocks.end() ) && (iterExcl->start <= (lockDetails.end+1) );
-       /* conditional iter increment inside loop */ )
-   {
-      bool incIterAtEnd = true;
+/**
+ * Insert a lock request into the given granted locks...
+ * (avoid duplicates and side-by-side locks for same file handles by merging)
+ *
+ * Note: unlocked, so hold the mutex when calling this
+ */
+void FileInode::flockRangeInsertMerged(RangeLockTree& locks, RangeLockDetails& lockDetails)
+{
+   // (note: start-1 and end+1: because we're also looking for extensions, not only overlaps)
+   uint64_t searchStart = lockDetails.start ? (lockDetails.start - 1) : 0;
+   uint64_t searchEnd = (lockDetails.end != ~0ULL) ? (lockDetails.end + 1) : lockDetails.end;
 
-      if(lockDetails.equalsHandle(*iterExcl) && lockDetails.isMergeable(*iterExcl) )
+   RangeLockDetailsVec candidates = locks.getOverlaps(searchStart, searchEnd);
+
+   for(RangeLockDetailsVec::const_iterator iter = candidates.begin();
+       iter != candidates.end();
+       iter++)
+   {
+      if(lockDetails.equalsHandle(*iter) && lockDetails.isMergeable(*iter) )
       { // same handle => merge with existing lock
 
          // note: all overlaps will be merged into lockDetails, so every other overlapping entry
             // can be removed here
 
-         lockDetails.merge(*iterExcl);
-
-         RangeLockExclSetIter iterExclNext(iterExcl);
-         iterExclNext++;
-
-         exclRangeFLocks.erase(iterExcl);
+         lockDetails.merge(*iter);
 
-         iterExcl = iterExclNext;
-         incIterAtEnd = false;
+         locks.erase(*iter);
       }
-
-      if(incIterAtEnd)
-         iterExcl++;
    }
 
    // actually insert the new lock
-   exclRangeFLocks.insert(lockDetails);
+   locks.insert(lockDetails);
 }
 
 /**
@@ -2292,123 +2279,42 @@ void FileInode::flockRangeExclusive(RangeLockDetails& lockDetails)
 bool FileInode::flockRangeIsGranted(RangeLockDetails& lockDetails)
 {
    if(lockDetails.isExclusive() )
-   {
-      for(RangeLockExclSetIter iterExcl = exclRangeFLocks.begin();
-          (iterExcl != exclRangeFLocks.end() ) && (iterExcl->start <= lockDetails.end);
-          /* conditional iter increment at end of loop */ )
-      {
-         if(!lockDetails.equalsHandle(*iterExcl) )
-         { // lock owned by another client/process
-            iterExcl++;
-            continue;
-         }
-
-         // found a lock that is owned by the same client/process => check overlap with given lock
-
-         bool incIterAtEnd = true;
-
-         RangeOverlapType overlap = lockDetails.overlapsEx(*iterExcl);
-
-         switch(overlap)
-         {
-            case RangeOverlapType_EQUALS:
-            { // found an exact match => don't need to look any further
-               return true;
-            } break;
-
-            case RangeOverlapType_ISCONTAINED:
-            { /* given range is fully contained in a greater locked area => don't need to look any
-                 further */
-               return true;
-            } break;
-
-            case RangeOverlapType_CONTAINS:
-            { /* found a range which is part of the given lock => given owner cannot currently hold
-                 the lock for the whole given range, otherwise we wouldn't find a partial match
-                 because of our merging => don't need to look any further */
-
-               return false;
-            } break;
-
-            case RangeOverlapType_STARTOVERLAP:
-            case RangeOverlapType_ENDOVERLAP:
-            { /* found a range which is part of the given lock => given owner cannot currently hold
-                 the lock for the whole given range, otherwise we wouldn't find a partial match
-                 because of our merging => don't need to look any further */
+      return flockRangeIsGrantedIn(exclRangeFLocks, lockDetails);
 
-               return false;
-            } break;
-
-            default: break; // no overlap
-
-         } // end of switch(overlap)
-
-         if(incIterAtEnd)
-            iterExcl++;
-      }
-   } // end of exclusive locks check
-   else
    if(lockDetails.isShared() )
-   {
-      for(RangeLockSharedSetIter iterShared = sharedRangeFLocks.begin();
-          iterShared != sharedRangeFLocks.end();
-          /* conditional iter increment at end of loop */ )
-      {
-         if(!lockDetails.equalsHandle(*iterShared) )
-         { // lock owned by another client/process
-            iterShared++;
-            continue;
-         }
-
-         // found a lock that is owned by the same client/process => check overlap with given lock
-
-         bool incIterAtEnd = true;
+      return flockRangeIsGrantedIn(sharedRangeFLocks, lockDetails);
 
-         RangeOverlapType overlap = lockDetails.overlapsEx(*iterShared);
-
-         switch(overlap)
-         {
-            case RangeOverlapType_EQUALS:
-            { // found an exact match => don't need to look any further
-
-               return true;
-            } break;
-
-            case RangeOverlapType_ISCONTAINED:
-            { /* given lock is fully contained in a greater locked area => don't need to look any
-                 further */
-
-               return true;
-            } break;
-
-            case RangeOverlapType_CONTAINS:
-            { /* found a range which is part of the given lock => given owner cannot currently hold
-                 the lock for the whole given range, otherwise we wouldn't find a partial match
-                 because of our merging => don't need to look any further */
-
-               return false;
-            } break;
+   return false;
+}
 
-            case RangeOverlapType_STARTOVERLAP:
-            case RangeOverlapType_ENDOVERLAP:
-            {  /* found a range which is part of the given lock => given owner cannot currently hold
-                 the lock for the whole given range, otherwise we wouldn't find a partial match
-                 because of our merging => don't need to look any further */
+/**
+ * Note: unlocked, hold the read lock when calling this.
+ *
+ * @return true if the range is locked by the given owner in the given granted locks
+ */
+bool FileInode::flockRangeIsGrantedIn(const RangeLockTree& locks, RangeLockDetails& lockDetails)
+{
+   bool isGranted = false;
 
-               return false;
-            } break;
+   locks.forEachOverlap(lockDetails.start, lockDetails.end,
+      [&] (const RangeLockDetails& lock) {
+         if(!lockDetails.equalsHandle(lock) )
+            return true; // lock owned by another client/process
 
-            default: break; // no overlap
+         /* found a lock that is owned by the same client/process. if it is only part of the given
+            lock, the owner cannot currently hold the lock for the whole given range, otherwise
+            we wouldn't find a partial match because of our merging => don't need to look any
+            further */
 
-         } // end of switch(overlap)
+         RangeOverlapType overlap = lockDetails.overlapsEx(lock);
 
-         if(incIterAtEnd)
-            iterShared++;
-      }
-   } // end of shared locks check
+         isGranted = (overlap == RangeOverlapType_EQUALS) ||
+            (overlap == RangeOverlapType_ISCONTAINED);
 
+         return false;
+      });
 
-   return false;
+   return isGranted;
 }
 
 
@@ -2421,215 +2327,99 @@ bool FileInode::flockRangeUnlock(RangeLockDetails& lockDetails)
 {
    bool lockRemoved = false; // return value
 
-   // check exclusive locks...
-   // (quick path: if the whole unlock is entirely covered by an exclusive range, then we don't need
-   // to look any further)
-
-   for(RangeLockExclSetIter iterExcl = exclRangeFLocks.begin();
-       (iterExcl != exclRangeFLocks.end() ) && (iterExcl->start <= lockDetails.end);
-       /* conditional iter increment at end of loop */ )
-   {
-      if(!lockDetails.equalsHandle(*iterExcl) )
-      { // lock owned by another client/process
-         iterExcl++;
-         continue;
-      }
-
-      // found a lock that is owned by the same client/process => check overlap with unlock request
-
-      bool incIterAtEnd = true;
-
-      RangeOverlapType overlap = lockDetails.overlapsEx(*iterExcl);
-
-      switch(overlap)
-      {
-         case RangeOverlapType_EQUALS:
-         { // found an exact match => don't need to look any further
-            exclRangeFLocks.erase(iterExcl);
-
-            return true;
-         } break;
-
-         case RangeOverlapType_ISCONTAINED:
-         { // unlock is fully contained in a greater locked area => don't need to look any further
-
-            // check if 1 or 2 locked areas remain (=> shrink or split)
-
-            if( (lockDetails.start == iterExcl->start) ||
-                (lockDetails.end == iterExcl->end) )
-            { // only one locked area remains
-               RangeLockDetails oldExcl(*iterExcl);
-               oldExcl.trim(lockDetails);
-
-               exclRangeFLocks.erase(iterExcl);
-               exclRangeFLocks.insert(oldExcl);
-            }
-            else
-            { // two locked areas remain
-               RangeLockDetails oldExcl(*iterExcl);
-               RangeLockDetails newExcl;
-
-               oldExcl.split(lockDetails, newExcl);
-
-               exclRangeFLocks.erase(iterExcl);
-               exclRangeFLocks.insert(oldExcl);
-               exclRangeFLocks.insert(newExcl);
-            }
-
-            return true;
-         } break;
+   if(flockRangeUnlockIn(exclRangeFLocks, lockDetails) )
+      lockRemoved = true;
 
-         case RangeOverlapType_CONTAINS:
-         { // full removal of this lock, but there may still be some others that need to be removed
-            RangeLockExclSetIter iterExclNext(iterExcl);
-            iterExclNext++;
+   if(flockRangeUnlockIn(sharedRangeFLocks, lockDetails) )
+      lockRemoved = true;
 
-            exclRangeFLocks.erase(iterExcl);
-
-            lockRemoved = true;
-
-            iterExcl = iterExclNext;
-            incIterAtEnd = false;
-         } break;
-
-         case RangeOverlapType_STARTOVERLAP:
-         case RangeOverlapType_ENDOVERLAP:
-         { // partial removal of this lock and there may still be others that need to be removed
-            // note: might change start and consequently map position => re-insert excl lock
-            RangeLockExclSetIter iterExclNext(iterExcl);
-            iterExclNext++;
-
-            RangeLockDetails oldExcl(*iterExcl);
-            oldExcl.trim(lockDetails);
-
-            exclRangeFLocks.erase(iterExcl);
-            exclRangeFLocks.insert(oldExcl);
-
-            lockRemoved = true;
-
-            iterExcl = iterExclNext;
-            incIterAtEnd = false;
-         } break;
-
-         default: break; // no overlap
-
-      } // end of switch(overlap)
+   return lockRemoved;
+}
 
-      if(incIterAtEnd)
-         iterExcl++;
-   }
+/**
+ * Remove the given range from the locks of the given owner in the given granted locks (by
+ * removing, trimming or splitting the overlapping locks).
+ *
+ * Note: unlocked, so hold the mutex when calling this.
+ *
+ * @return true if an existing lock has been removed
+ */
+bool FileInode::flockRangeUnlockIn(RangeLockTree& locks, RangeLockDetails& lockDetails)
+{
+   bool lockRemoved = false; // return value
 
-   // check shared locks...
-   // (similar to exclusive locks, we can stop here if unlock is entirely covered by one of our
-   // owned shared ranges, because there cannot be another overlapping range which we also own)
+   RangeLockDetailsVec overlaps = locks.getOverlaps(lockDetails.start, lockDetails.end);
 
-   for(RangeLockSharedSetIter iterShared = sharedRangeFLocks.begin();
-       iterShared != sharedRangeFLocks.end();
-       /* conditional iter increment at end of loop */ )
+   for(RangeLockDetailsVec::const_iterator iter = overlaps.begin();
+       iter != overlaps.end();
+       iter++)
    {
-      if(!lockDetails.equalsHandle(*iterShared) )
-      { // lock owned by another client/process
-         iterShared++;
-         continue;
-      }
+      if(!lockDetails.equalsHandle(*iter) )
+         continue; // lock owned by another client/process
 
-      // found a lock that is owned by the same client/process => check overlap with unlock request
+      // found a lock that is owned by the same client/process => remove the unlocked range
 
-      bool incIterAtEnd = true;
+      RangeLockDetails oldLock(*iter);
 
-      RangeOverlapType overlap = lockDetails.overlapsEx(*iterShared);
+      locks.erase(oldLock);
+      lockRemoved = true;
+
+      RangeOverlapType overlap = lockDetails.overlapsEx(oldLock);
 
       switch(overlap)
       {
-         case RangeOverlapType_EQUALS:
-         { // found an exact match => don't need to look any further
-            sharedRangeFLocks.erase(iterShared);
-
-            return true;
-         } break;
-
          case RangeOverlapType_ISCONTAINED:
-         { // unlock is fully contained in a greater locked area => don't need to look any further
+         { // unlock is fully contained in a greater locked area
 
-            // check if 1 or 2 locked areas remain...
+            // check if 1 or 2 locked areas remain (=> shrink or split)
 
-            if( (lockDetails.start == iterShared->start) ||
-                (lockDetails.end == iterShared->end) )
+            if( (lockDetails.start == oldLock.start) ||
+                (lockDetails.end == oldLock.end) )
             { // only one locked area remains
-               RangeLockDetails oldShared(*iterShared);
-               oldShared.trim(lockDetails);
+               oldLock.trim(lockDetails);
 
-               sharedRangeFLocks.erase(iterShared);
-               sharedRangeFLocks.insert(oldShared);
+               locks.insert(oldLock);
             }
             else
             { // two locked areas remain
-               RangeLockDetails oldShared(*iterShared);
-               RangeLockDetails newShared;
+               RangeLockDetails newLock;
 
-               oldShared.split(lockDetails, newShared);
+               oldLock.split(lockDetails, newLock);
 
-               sharedRangeFLocks.erase(iterShared);
-               sharedRangeFLocks.insert(oldShared);
-               sharedRangeFLocks.insert(newShared);
+               locks.insert(oldLock);
+               locks.insert(newLock);
             }
-
-            return true;
-         } break;
-
-         case RangeOverlapType_CONTAINS:
-         { // full removal of this lock, but there may still be some others that need to be removed
-            RangeLockExclSetIter iterExclNext(iterShared);
-            iterExclNext++;
-
-            sharedRangeFLocks.erase(iterShared);
-
-            lockRemoved = true;
-
-            iterShared = iterExclNext;
-            incIterAtEnd = false;
          } break;
 
          case RangeOverlapType_STARTOVERLAP:
          case RangeOverlapType_ENDOVERLAP:
-         { // partial removal of this lock and there may still be others that need to be removed
-            // note: might change start and consequently map position => re-insert excl lock
-            RangeLockExclSetIter iterSharedNext(iterShared);
-            iterSharedNext++;
-
-            RangeLockDetails oldShared(*iterShared);
-            oldShared.trim(lockDetails);
+         { // partial removal of this lock
+            oldLock.trim(lockDetails);
 
-            sharedRangeFLocks.erase(iterShared);
-            sharedRangeFLocks.insert(oldShared);
-
-            lockRemoved = true;
-
-            iterShared = iterSharedNext;
-            incIterAtEnd = false;
+            locks.insert(oldLock);
          } break;
 
-         default: break; // no overlap
+         default: break; // equals or contained in unlock => full removal
 
       } // end of switch(overlap)
-
-      if(incIterAtEnd)
-         iterShared++;
    }
 
-
    return lockRemoved;
 }
 
 /**
- * Remove next requests from waiters queue and try to grant it - until we reach an entry that
- * cannot be granted immediately.
+ * Remove all requests from the waiters queues that can be granted now and grant them.
+ *
+ * All compatible waiters are granted in a single pass over the queues: an excl waiter is granted
+ * if it doesn't conflict with granted locks or with an excl waiter that remains queued before it
+ * (to avoid writer starvation); shared waiters are granted if they don't conflict with granted
+ * locks or any remaining excl waiter (writer preference).
  *
  * Note: unlocked, so hold the mutex when calling this.
  */
 LockRangeNotifyList FileInode::flockRangeTryNextWaiters()
 {
-   int numWaitersBefore = 0; // number of waiters in the queue before the current checked element
+   RangeLockTree blockingExclWaiters; // excl waiters that remain queued before the checked one
 
    LockRangeNotifyList notifyList; // quick stack version to speed up the no waiter granted path
 
@@ -2638,19 +2428,22 @@ LockRangeNotifyList FileInode::flockRangeTryNextWaiters()
        iter != waitersExclRangeFLock.end();
        /* conditional iter inc inside loop */)
    {
-      bool hasConflict = flockRangeCheckConflictsEx(*iter, numWaitersBefore, NULL);
+      bool hasConflict = flockRangeCheckConflictsEx(*iter, blockingExclWaiters, NULL);
       if(hasConflict)
       {
+         blockingExclWaiters.insert(*iter);
          iter++;
-         numWaitersBefore++;
          continue;
       }
 
       // no conflict => grant lock
 
+      waitersExclRangeFLockIndex.erase(*iter); // (before the lock is merged with granted locks)
+
       flockRangeExclusive(*iter);
 
       notifyList.push_back(*iter);
+      rangeFLockStats.numGrantedFromQueue++;
 
       waitersLockIDsRangeFLock.erase(iter->lockAckID);
       iter = waitersExclRangeFLock.erase(iter);
@@ -2672,6 +2465,7 @@ LockRangeNotifyList FileInode::flockRangeTryNextWaiters()
       flockRangeShared(*iter);
 
       notifyList.push_back(*iter);
+      rangeFLockStats.numGrantedFromQueue++;
 
       waitersLockIDsRangeFLock.erase(iter->lockAckID);
       iter = waitersSharedRangeFLock.erase(iter);
@@ -2690,10 +2484,13 @@ std::string FileInode::flockRangeGetAllAsStr()
 
    std::ostringstream outStream;
 
+   const RangeLockDetailsVec exclLocks = exclRangeFLocks.getAll();
+   const RangeLockDetailsVec sharedLocks = sharedRangeFLocks.getAll();
+
    outStream << "Exclusive" << std::endl;
    outStream << "=========" << std::endl;
-   for(RangeLockExclSetCIter iter = exclRangeFLocks.begin();
-       iter != exclRangeFLocks.end();
+   for(RangeLockDetailsVec::const_iterator iter = exclLocks.begin();
+       iter != exclLocks.end();
        iter++)
    {
       outStream << iter->toString() << std::endl;
@@ -2703,8 +2500,8 @@ std::string FileInode::flockRangeGetAllAsStr()
 
    outStream << "Shared" << std::endl;
    outStream << "=========" << std::endl;
-   for(RangeLockSharedSetCIter iter = sharedRangeFLocks.begin();
-       iter != sharedRangeFLocks.end();
+   for(RangeLockDetailsVec::const_iterator iter = sharedLocks.begin();
+       iter != sharedLocks.end();
        iter++)
    {
       outStream << iter->toString() << std::endl;
@@ -2745,6 +2542,12 @@ std::string FileInode::flockRangeGetAllAsStr()
 
    outStream << std::endl;
 
+   outStream << "Statistics" << std::endl;
+   outStream << "=========" << std::endl;
+   outStream << rangeFLockStats.toString() << std::endl;
+
+   outStream << std::endl;
+
    return outStream.str();
 }
 
@@ -2973,6 +2776,7 @@ void FileInode::initLocksRandomForSerializationTests()
       RangeLockDetails lock;
       lock.initRandomForSerializationTests();
       this->waitersExclRangeFLock.push_back(lock);
+      this->waitersExclRangeFLockIndex.insert(lock);
    }
 
    max = rand.getNextInRange(0, 1024);
@@ -17,11 +17,16 @@
 #include <session/LockingNotifier.h>
 #include "Locking.h"
 #include "MetadataEx.h"
+#include "RangeLockTree.h"
 #include "DiskMetaData.h"
 #include "DentryStoreData.h"
 #include "FileInodeStoreData.h"
 
 
+// number of queued range lock requests from which on a file is logged as contended
+#define FILEINODE_RANGELOCK_CONTENDED_WAITERS   64
+
+
 typedef std::vector<DynamicFileAttribs> DynamicFileAttribsVec;
 typedef DynamicFileAttribsVec::iterator DynamicFileAttribsVecIter;
 typedef DynamicFileAttribsVec::const_iterator DynamicFileAttribsVecCIter;
@@ -98,6 +103,7 @@ class FileInode
       FhgfsOpsErr clearRemoteStorageTarget(EntryInfo* entryInfo);
 
       void decNumSessionsAndStore(EntryInfo* entryInfo, unsigned accessFlags);
+      FhgfsOpsErr flushDynAttribs(EntryInfo* entryInfo, bool attribsRefreshed);
       static FileInode* createFromEntryInfo(EntryInfo* entryInfo);
 
       void serializeMetaData(Serializer& ser);
@@ -184,6 +190,8 @@ class FileInode
       uint32_t numSessionsRead; // open read-only
       uint32_t numSessionsWrite; // open for writing or read-write
 
+      bool dynAttribsDeferred; // in-memory dyn attribs are newer than the stored (dirty) ones
+
 
       bool isInlined; // boolean if the inode inlined into the Dentry or a separate file
 
@@ -200,11 +208,13 @@ class FileInode
       StringSet waitersLockIDsFLock; // currently enqueued lockIDs (for fast duplicate check)
 
       // fcntl() flock queues (range-based)
-      RangeLockExclSet exclRangeFLocks; // current exclusiveTID locks
-      RangeLockSharedSet sharedRangeFLocks;  // current shared locks (key is lock, value is dummy)
+      RangeLockTree exclRangeFLocks; // current exclusiveTID locks
+      RangeLockTree sharedRangeFLocks;  // current shared locks
       RangeLockDetailsList waitersExclRangeFLock; // queue (append new to end, pop from top)
       RangeLockDetailsList waitersSharedRangeFLock; // queue (append new to end, pop from top)
+      RangeLockTree waitersExclRangeFLockIndex; // waitersExclRangeFLock (for fast conflict check)
       StringSet waitersLockIDsRangeFLock; // currently enqueued lockIDs (for fast duplicate check)
+      RangeLockStats rangeFLockStats;
 
       RWLock rwlock; // default inode lock
 
@@ -221,6 +231,7 @@ class FileInode
 
       void initFileInfoVec();
       void updateDynamicAttribs(void);
+      bool isDynAttribsWriteBackAllowedUnlocked(unsigned accessFlags);
 
       bool setAttrData(EntryInfo* entryInfo, int validAttribs, SettableFileAttribs* attribs);
       bool incDecNumHardLinks(EntryInfo * entryInfo, int value);
@@ -269,12 +280,15 @@ class FileInode
       bool flockRangeCancelByHandle(RangeLockDetails& lockDetails);
 
       bool flockRangeCheckConflicts(RangeLockDetails& lockDetails, RangeLockDetails* outConflictor);
-      bool flockRangeCheckConflictsEx(RangeLockDetails& lockDetails, int maxExclWaitersCheckNum,
-         RangeLockDetails* outConflictor);
+      bool flockRangeCheckConflictsEx(RangeLockDetails& lockDetails,
+         const RangeLockTree& exclWaiters, RangeLockDetails* outConflictor);
       bool flockRangeIsGranted(RangeLockDetails& lockDetails);
+      bool flockRangeIsGrantedIn(const RangeLockTree& locks, RangeLockDetails& lockDetails);
       bool flockRangeUnlock(RangeLockDetails& lockDetails);
+      bool flockRangeUnlockIn(RangeLockTree& locks, RangeLockDetails& lockDetails);
       void flockRangeShared(RangeLockDetails& lockDetails);
       void flockRangeExclusive(RangeLockDetails& lockDetails);
+      void flockRangeInsertMerged(RangeLockTree& locks, RangeLockDetails& lockDetails);
       LockRangeNotifyList flockRangeTryNextWaiters();
 
 
@@ -590,7 +604,9 @@ class FileInode
             that would be too much overhead; side-effect is that we don't update atime for read-only
             files while they are open. */
 
-         if(numSessionsWrite)
+         /* (dirty stored attribs without a deferred update in memory: the inode was unloaded
+            after a deferred close or the update was lost in a crash) */
+         if(numSessionsWrite || (inodeDiskData.getDynAttribsDirty() && !dynAttribsDeferred) )
             statRes = FhgfsOpsErr_DYNAMICATTRIBSOUTDATED;
 
          return statRes;
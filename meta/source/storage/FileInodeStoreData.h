@@ -22,6 +22,11 @@
 #define FILEINODE_FEATURE_HAS_VERSIONS      128 // file has a cto version counter
 #define FILEINODE_FEATURE_HAS_RST           256 // file has remote targets
 #define FILEINODE_FEATURE_HAS_STATE_FLAGS   512 // file has state flags (access state + data state)
+#define FILEINODE_FEATURE_DYNATTRIBS_DIRTY 1024 // stored dyn attribs may be older than the chunks
+
+/* note: meta servers without support for FILEINODE_FEATURE_DYNATTRIBS_DIRTY refuse to load inodes
+   that have it set. it is cleared by the next stat or write-back of the file, see
+   tuneInodeWriteBackSecs in beegfs-meta.conf before a downgrade. */
 
 enum FileInodeOrigFeature
 {
@@ -224,6 +229,11 @@ class FileInodeStoreData
          setMetaVersionStat(metaVersion);  //update metadata version in StatData
       }
 
+      bool getDynAttribsDirty() const
+      {
+         return (inodeFeatureFlags & FILEINODE_FEATURE_DYNATTRIBS_DIRTY);
+      }
+
    protected:
 
       /**
@@ -288,6 +298,14 @@ class FileInodeStoreData
          return (getInodeFeatureFlags() & FILEINODE_FEATURE_HAS_RST);
       }
 
+      void setDynAttribsDirty(bool dirty)
+      {
+         if (dirty)
+            addInodeFeatureFlag(FILEINODE_FEATURE_DYNATTRIBS_DIRTY);
+         else
+            removeInodeFeatureFlag(FILEINODE_FEATURE_DYNATTRIBS_DIRTY);
+      }
+
       void setFileState(uint8_t value)
       {
          this->rawFileState = value;
@@ -6,8 +6,8 @@
 #include "InodeDirStore.h"
 
 
-#define DIRSTORE_REFCACHE_REMOVE_SKIP_SYNC     (4) /* n-th elements to be removed on sync sweep */
-#define DIRSTORE_REFCACHE_REMOVE_SKIP_ASYNC    (3) /* n-th elements to be removed on async sweep */
+#define DIRSTORE_REFCACHE_ASYNC_EVICT_DIVISOR  (3) /* max 1/n of the elements evicted per async
+                                                     sweep (to limit the lock hold time) */
 
 /**
   * not inlined as we need to include <program/Program.h>
@@ -16,14 +16,18 @@ InodeDirStore::InodeDirStore()
 {
    Config* cfg = Program::getApp()->getConfig();
 
-   this->refCacheSyncLimit = cfg->getTuneDirMetadataCacheLimit();
+   // the configured limit is for the whole store, so split it among the shards
+   const size_t cacheLimit = cfg->getTuneDirMetadataCacheLimit();
+
+   this->refCacheSyncLimit = std::max<size_t>(cacheLimit / DIRSTORE_NUM_SHARDS, 1);
    this->refCacheAsyncLimit = refCacheSyncLimit - (refCacheSyncLimit/2);
 }
 
 bool InodeDirStore::dirInodeInStoreUnlocked(const std::string& dirID)
 {
-   DirectoryMapIter iter = this->dirs.find(dirID);
-   return iter != this->dirs.end();
+   Shard& shard = getShard(dirID);
+
+   return shard.dirs.find(dirID) != shard.dirs.end();
 }
 
 
@@ -43,25 +47,29 @@ DirInode* InodeDirStore::referenceDirInode(const std::string& dirID, bool isBudd
                                * rather expensive.
                                * Note: when set to false we also need a write-lock! */
 
-   UniqueRWLock lock(rwlock, SafeRWLock_READ);
+   Shard& shard = getShard(dirID);
+
+   UniqueRWLock lock(shard.rwlock, SafeRWLock_READ);
 
    DirectoryMapIter iter;
 
-   iter = dirs.find(dirID);
-   if (iter == dirs.end())
+   iter = shard.dirs.find(dirID);
+   if (iter == shard.dirs.end())
    {
       lock.unlock();
       lock.lock(SafeRWLock_WRITE);
-      iter = dirs.find(dirID);
+      iter = shard.dirs.find(dirID);
    }
+   else
+      shard.refCache.touch(dirID); // (safe under read lock)
 
-   if(iter == this->dirs.end() )
+   if(iter == shard.dirs.end() )
    { // Not in map yet => try to load it. We must be write-locked here!
-      iter = insertDirInodeUnlocked(dirID, isBuddyMirrored, forceLoad);
+      iter = insertDirInodeUnlocked(shard, dirID, isBuddyMirrored, forceLoad);
       wasReferenced = false;
    }
 
-   if(iter != this->dirs.end() )
+   if(iter != shard.dirs.end() )
    { // exists in map
       DirectoryReferencer* dirRefer = iter->second;
       DirInode* dirNonRef = dirRefer->getReferencedObject();
@@ -72,7 +80,7 @@ DirInode* InodeDirStore::referenceDirInode(const std::string& dirID, bool isBudd
          LOG_DBG(GENERAL, SPAM,  "referenceDirInode", dir->getID(), dirRefer->getRefCount());
 
          if (!wasReferenced)
-            cacheAddUnlocked(dirID, dirRefer);
+            cacheAddUnlocked(shard, dirID, dirRefer);
       }
 
       // no "else".
@@ -99,16 +107,18 @@ DirInode* InodeDirStore::referenceDirInode(const std::string& dirID, bool isBudd
  */
 void InodeDirStore::releaseDir(const std::string& dirID)
 {
-   RWLockGuard lock(this->rwlock, SafeRWLock_WRITE);
-   releaseDirUnlocked(dirID);
+   Shard& shard = getShard(dirID);
+
+   RWLockGuard lock(shard.rwlock, SafeRWLock_WRITE);
+   releaseDirUnlocked(shard, dirID);
 }
 
-void InodeDirStore::releaseDirUnlocked(const std::string& dirID)
+void InodeDirStore::releaseDirUnlocked(Shard& shard, const std::string& dirID)
 {
    App* app = Program::getApp();
 
-   DirectoryMapIter iter = this->dirs.find(dirID);
-   if(likely(iter != this->dirs.end() ) )
+   DirectoryMapIter iter = shard.dirs.find(dirID);
+   if(likely(iter != shard.dirs.end() ) )
    { // dir exists => decrease refCount
       DirectoryReferencer* dirRefer = iter->second;
 
@@ -132,14 +142,14 @@ void InodeDirStore::releaseDirUnlocked(const std::string& dirID)
             else
             { // as expected, fileStore is empty
                delete(dirRefer);
-               this->dirs.erase(iter);
+               shard.dirs.erase(iter);
             }
          }
       }
       else
       { // attempt to release a Dir without a refCount
          LOG(GENERAL, ERR, "Bug: Refusing to release dir with a zero refCount", dirID);
-         this->dirs.erase(iter);
+         shard.dirs.erase(iter);
       }
    }
    else
@@ -151,12 +161,14 @@ void InodeDirStore::releaseDirUnlocked(const std::string& dirID)
 
 FhgfsOpsErr InodeDirStore::removeDirInode(const std::string& dirID, bool isBuddyMirrored)
 {
-   RWLockGuard lock(rwlock, SafeRWLock_WRITE);
+   Shard& shard = getShard(dirID);
+
+   RWLockGuard lock(shard.rwlock, SafeRWLock_WRITE);
 
-   cacheRemoveUnlocked(dirID); /* we should move this after isRemovable()-check as soon as we can
-      remove referenced dirs */
+   cacheRemoveUnlocked(shard, dirID); /* we should move this after isRemovable()-check as soon as
+      we can remove referenced dirs */
 
-   FhgfsOpsErr removableRes = isRemovableUnlocked(dirID, isBuddyMirrored);
+   FhgfsOpsErr removableRes = isRemovableUnlocked(shard, dirID, isBuddyMirrored);
    if(removableRes != FhgfsOpsErr_SUCCESS)
       return removableRes;
 
@@ -178,12 +190,13 @@ FhgfsOpsErr InodeDirStore::removeDirInode(const std::string& dirID, bool isBuddy
  * check, but we have it here because this method already loads the dir inode, so that we can avoid
  * another inode load in removeDirInodeUnlocked() for mirror checking.)
  */
-FhgfsOpsErr InodeDirStore::isRemovableUnlocked(const std::string& dirID, bool isBuddyMirrored)
+FhgfsOpsErr InodeDirStore::isRemovableUnlocked(Shard& shard, const std::string& dirID,
+   bool isBuddyMirrored)
 {
    const char* logContext = "InodeDirStore check if dir is removable";
-   DirectoryMapCIter iter = dirs.find(dirID);
+   DirectoryMapCIter iter = shard.dirs.find(dirID);
 
-   if(iter != dirs.end() )
+   if(iter != shard.dirs.end() )
    { // dir currently loaded, refuse to let it rmdir'ed
       DirectoryReferencer* dirRefer = iter->second;
       DirInode* dir = dirRefer->getReferencedObject();
@@ -226,8 +239,15 @@ FhgfsOpsErr InodeDirStore::isRemovableUnlocked(const std::string& dirID, bool is
  */
 size_t InodeDirStore::getSize()
 {
-   RWLockGuard lock(rwlock, SafeRWLock_READ);
-   return dirs.size();
+   size_t size = 0;
+
+   for (Shard& shard : shards)
+   {
+      RWLockGuard lock(shard.rwlock, SafeRWLock_READ);
+      size += shard.dirs.size();
+   }
+
+   return size;
 }
 
 /**
@@ -245,10 +265,12 @@ FhgfsOpsErr InodeDirStore::stat(const std::string& dirID, bool isBuddyMirrored,
       ? NumNodeID(app->getMetaBuddyGroupMapper()->getLocalGroupID() )
       : app->getLocalNode().getNumID();
 
-   UniqueRWLock lock(rwlock, SafeRWLock_READ);
+   Shard& shard = getShard(dirID);
+
+   UniqueRWLock lock(shard.rwlock, SafeRWLock_READ);
 
-   DirectoryMapIter iter = dirs.find(dirID);
-   if(iter != dirs.end() )
+   DirectoryMapIter iter = shard.dirs.find(dirID);
+   if(iter != shard.dirs.end() )
    { // dir loaded
       DirectoryReferencer* dirRefer = iter->second;
       DirInode* dir = dirRefer->getReferencedObject();
@@ -296,10 +318,12 @@ FhgfsOpsErr InodeDirStore::stat(const std::string& dirID, bool isBuddyMirrored,
 FhgfsOpsErr InodeDirStore::setAttr(const std::string& dirID, bool isBuddyMirrored, int validAttribs,
    SettableFileAttribs* attribs)
 {
-   RWLockGuard lock(rwlock, SafeRWLock_WRITE);
+   Shard& shard = getShard(dirID);
+
+   RWLockGuard lock(shard.rwlock, SafeRWLock_WRITE);
 
-   DirectoryMapIter iter = dirs.find(dirID);
-   if(iter == dirs.end() )
+   DirectoryMapIter iter = shard.dirs.find(dirID);
+   if(iter == shard.dirs.end() )
    { // not loaded => load, apply, destroy
       DirInode dir(dirID, isBuddyMirrored);
 
@@ -328,14 +352,17 @@ FhgfsOpsErr InodeDirStore::setAttr(const std::string& dirID, bool isBuddyMirrore
 
 void InodeDirStore::invalidateMirroredDirInodes()
 {
-   UniqueRWLock lock(rwlock, SafeRWLock_WRITE);
-
-   for (auto it = dirs.begin(); it != dirs.end(); ++it)
+   for (Shard& shard : shards)
    {
-      DirInode& dir = *it->second->getReferencedObject();
+      UniqueRWLock lock(shard.rwlock, SafeRWLock_WRITE);
+
+      for (auto it = shard.dirs.begin(); it != shard.dirs.end(); ++it)
+      {
+         DirInode& dir = *it->second->getReferencedObject();
 
-      if (dir.getIsBuddyMirrored())
-         dir.invalidate();
+         if (dir.getIsBuddyMirrored())
+            dir.invalidate();
+      }
    }
 }
 
@@ -345,40 +372,43 @@ void InodeDirStore::invalidateMirroredDirInodes()
  * Note: We only need to hold a read-lock here, as we check if inserting an entry into the map
  *       succeeded.
  */
-DirectoryMapIter InodeDirStore::insertDirInodeUnlocked(const std::string& dirID,
+DirectoryMapIter InodeDirStore::insertDirInodeUnlocked(Shard& shard, const std::string& dirID,
    bool isBuddyMirrored, bool forceLoad)
 {
    std::unique_ptr<DirInode> inode(new (std::nothrow) DirInode(dirID, isBuddyMirrored));
    if (unlikely (!inode) )
-      return dirs.end(); // out of memory
+      return shard.dirs.end(); // out of memory
 
    if (forceLoad)
    { // load from disk requested
       if (!inode->loadIfNotLoaded() )
-         return dirs.end();
+         return shard.dirs.end();
    }
 
    std::pair<DirectoryMapIter, bool> pairRes =
-      this->dirs.insert(DirectoryMapVal(dirID, new DirectoryReferencer(inode.release())));
+      shard.dirs.insert(DirectoryMapVal(dirID, new DirectoryReferencer(inode.release())));
 
    return pairRes.first;
 }
 
 void InodeDirStore::clearStoreUnlocked()
 {
-   LOG_DBG(GENERAL, DEBUG, "clearStoreUnlocked", dirs.size());
+   for (Shard& shard : shards)
+   {
+      LOG_DBG(GENERAL, DEBUG, "clearStoreUnlocked", shard.dirs.size());
 
-   cacheRemoveAllUnlocked();
+      cacheRemoveAllUnlocked(shard);
 
-   for(DirectoryMapIter iter = dirs.begin(); iter != dirs.end(); iter++)
-   {
-      DirectoryReferencer* dirRef = iter->second;
+      for(DirectoryMapIter iter = shard.dirs.begin(); iter != shard.dirs.end(); iter++)
+      {
+         DirectoryReferencer* dirRef = iter->second;
 
-      // will also call destructor for dirInode and sub-objects as dirInode->fileStore
-      delete(dirRef);
-   }
+         // will also call destructor for dirInode and sub-objects as dirInode->fileStore
+         delete(dirRef);
+      }
 
-   dirs.clear();
+      shard.dirs.clear();
+   }
 }
 
 /**
@@ -386,7 +416,8 @@ void InodeDirStore::clearStoreUnlocked()
  * (otherwise it might happen that the new element is deleted during sweep if it was cached
  * before and appears to be unneeded now).
  */
-void InodeDirStore::cacheAddUnlocked(const std::string& dirID, DirectoryReferencer* dirRefer)
+void InodeDirStore::cacheAddUnlocked(Shard& shard, const std::string& dirID,
+   DirectoryReferencer* dirRefer)
 {
    Config* cfg = Program::getApp()->getConfig();
 
@@ -396,9 +427,9 @@ void InodeDirStore::cacheAddUnlocked(const std::string& dirID, DirectoryReferenc
       return; // cache disabled by user config
 
    // (we do cache sweeping before insertion to make sure we don't sweep the new entry)
-   cacheSweepUnlocked(true);
+   cacheSweepUnlocked(shard, true);
 
-   if(refCache.insert(DirCacheMapVal(dirID, dirRefer->getReferencedObject()) ).second)
+   if(shard.refCache.insert(dirID, dirRefer->getReferencedObject() ) )
    { // new insert => inc refcount
       dirRefer->reference();
 
@@ -406,75 +437,51 @@ void InodeDirStore::cacheAddUnlocked(const std::string& dirID, DirectoryReferenc
    }
 }
 
-void InodeDirStore::cacheRemoveUnlocked(const std::string& dirID)
+void InodeDirStore::cacheRemoveUnlocked(Shard& shard, const std::string& dirID)
 {
-   DirCacheMapIter iter = refCache.find(dirID);
-   if(iter == refCache.end() )
+   if(!shard.refCache.remove(dirID, NULL) )
       return;
 
-   releaseDirUnlocked(dirID);
-   refCache.erase(iter);
+   releaseDirUnlocked(shard, dirID);
 }
 
-void InodeDirStore::cacheRemoveAllUnlocked()
+void InodeDirStore::cacheRemoveAllUnlocked(Shard& shard)
 {
-   for(DirCacheMapIter iter = refCache.begin(); iter != refCache.end(); /* iter inc inside loop */)
-   {
-      releaseDirUnlocked(iter->first);
-      refCache.erase(iter++);
-   }
+   std::string dirID;
+   DirInode* dir;
+
+   while(shard.refCache.evict(&dirID, &dir) )
+      releaseDirUnlocked(shard, dirID);
 }
 
 /**
- * @param isSyncSweep true if this is a synchronous sweep (e.g. we need to free a few elements to
+ * Evict the least recently used elements (according to the CLOCK algorithm) from the cache of
+ * the given shard.
+ *
+ * @param isSyncSweep true if this is a synchronous sweep (e.g. we need to free an element to
  * allow quick insertion of a new element), false is this is an asynchronous sweep (that might take
  * a bit longer).
  * @return true if a cache flush was triggered, false otherwise
  */
-bool InodeDirStore::cacheSweepUnlocked(bool isSyncSweep)
+bool InodeDirStore::cacheSweepUnlocked(Shard& shard, bool isSyncSweep)
 {
-   // sweeping means we remove every n-th element from the cache, starting with a random element
-   // in the range 0 to n
-   size_t cacheLimit;
-   size_t removeSkipNum;
-
-   // check type of sweep and set removal parameters accordingly
-
-   if(isSyncSweep)
-   { // sync sweep settings
-      cacheLimit = refCacheSyncLimit;
-      removeSkipNum = DIRSTORE_REFCACHE_REMOVE_SKIP_SYNC;
-   }
-   else
-   { // async sweep settings
-      cacheLimit = refCacheAsyncLimit;
-      removeSkipNum = DIRSTORE_REFCACHE_REMOVE_SKIP_ASYNC;
-   }
+   const size_t cacheLimit = isSyncSweep ? refCacheSyncLimit : refCacheAsyncLimit;
+   const size_t cacheSize = shard.refCache.size();
 
-   if(refCache.size() <= cacheLimit)
+   if(cacheSize <= cacheLimit)
       return false;
 
+   size_t numEvict = cacheSize - cacheLimit;
 
-   // pick a random start element (note: the element will be removed in first loop pass below)
+   if(!isSyncSweep)
+      numEvict = std::min(numEvict,
+         std::max<size_t>(cacheSize / DIRSTORE_REFCACHE_ASYNC_EVICT_DIVISOR, 1) );
 
-   unsigned randStart = randGen.getNextInRange(0, removeSkipNum - 1);
-   DirCacheMapIter iter = refCache.begin();
+   std::string dirID;
+   DirInode* dir;
 
-   while(randStart--)
-      iter++;
-
-   // walk over all cached elements and remove every n-th element
-   DirCacheMapSizeT i = 0; // counts elements
-   while (iter != refCache.end() )
-   {
-      if ( (++i % removeSkipNum) == 0)
-      {
-         releaseDirUnlocked(iter->first);
-         refCache.erase(iter++);
-      }
-      else
-         iter++;
-   }
+   while(numEvict-- && shard.refCache.evict(&dirID, &dir) )
+      releaseDirUnlocked(shard, dirID);
 
    return true;
 }
@@ -484,8 +491,17 @@ bool InodeDirStore::cacheSweepUnlocked(bool isSyncSweep)
  */
 bool InodeDirStore::cacheSweepAsync()
 {
-   RWLockGuard lock(rwlock, SafeRWLock_WRITE);
-   return cacheSweepUnlocked(false);
+   bool flushTriggered = false;
+
+   for (Shard& shard : shards)
+   {
+      RWLockGuard lock(shard.rwlock, SafeRWLock_WRITE);
+
+      if(cacheSweepUnlocked(shard, false) )
+         flushTriggered = true;
+   }
+
+   return flushTriggered;
 }
 
 /**
@@ -493,6 +509,13 @@ bool InodeDirStore::cacheSweepAsync()
  */
 size_t InodeDirStore::getCacheSize()
 {
-   RWLockGuard lock(rwlock, SafeRWLock_READ);
-   return refCache.size();
+   size_t size = 0;
+
+   for (Shard& shard : shards)
+   {
+      RWLockGuard lock(shard.rwlock, SafeRWLock_READ);
+      size += shard.refCache.size();
+   }
+
+   return size;
 }
@@ -3,30 +3,32 @@
 #include <common/Common.h>
 #include <common/threading/Mutex.h>
 #include <common/toolkit/AtomicObjectReferencer.h>
+#include <common/toolkit/ClockCache.h>
 #include <common/toolkit/MetadataTk.h>
-#include <common/toolkit/Random.h>
 #include <common/storage/StatData.h>
 #include <common/storage/StorageDefinitions.h>
 #include <common/storage/StorageErrors.h>
 
 class DirInode;
 
+#define DIRSTORE_NUM_SHARDS  16 /* number of independently locked parts of the store */
+
 typedef AtomicObjectReferencer<DirInode*> DirectoryReferencer;
-typedef std::map<std::string, DirectoryReferencer*> DirectoryMap;
+typedef std::unordered_map<std::string, DirectoryReferencer*> DirectoryMap;
 typedef DirectoryMap::iterator DirectoryMapIter;
 typedef DirectoryMap::const_iterator DirectoryMapCIter;
 typedef DirectoryMap::value_type DirectoryMapVal;
 
-typedef std::map<std::string, DirInode*> DirCacheMap; // keys are dirIDs (same as DirMap)
-typedef DirCacheMap::iterator DirCacheMapIter;
-typedef DirCacheMap::const_iterator DirCacheMapCIter;
-typedef DirCacheMap::value_type DirCacheMapVal;
-typedef DirCacheMap::size_type DirCacheMapSizeT;
+typedef ClockCache<std::string, DirInode*> DirRefCache; // keys are dirIDs (same as DirMap)
 
 /**
  * Layer in between our inodes and the data on the underlying file system. So we read/write from/to
  * underlying files and this class is to do this corresponding data access.
  * This object is used for for _directories_ only.
+ *
+ * The directories are distributed over DIRSTORE_NUM_SHARDS shards by the hash of their ID. Each
+ * shard has its own map, reference cache and lock. The reference cache keeps recently used dirs
+ * loaded and evicts with the CLOCK algorithm, so that hot (parent) dirs stay in memory.
  */
 class InodeDirStore
 {
@@ -66,29 +68,38 @@ class InodeDirStore
 
 
    private:
-      DirectoryMap dirs;
+      struct Shard
+      {
+         DirectoryMap dirs;
+         DirRefCache refCache;
+         RWLock rwlock;
+      };
 
-      size_t refCacheSyncLimit; // synchronous access limit (=> async limit plus some grace size)
-      size_t refCacheAsyncLimit; // asynchronous cleanup limit (this is what the user configures)
-      Random randGen; // for random cache removal
-      DirCacheMap refCache;
+      Shard shards[DIRSTORE_NUM_SHARDS];
 
-      RWLock rwlock;
+      size_t refCacheSyncLimit; // per-shard synchronous access limit (=> async limit plus grace)
+      size_t refCacheAsyncLimit; // per-shard asynchronous cleanup limit
 
-      void releaseDirUnlocked(const std::string& dirID);
+      void releaseDirUnlocked(Shard& shard, const std::string& dirID);
 
-      FhgfsOpsErr isRemovableUnlocked(const std::string& dirID, bool isBuddyMirrored);
+      FhgfsOpsErr isRemovableUnlocked(Shard& shard, const std::string& dirID,
+         bool isBuddyMirrored);
 
-      DirectoryMapIter insertDirInodeUnlocked(const std::string& dirID, bool isBuddyMirrored,
-         bool forceLoad);
+      DirectoryMapIter insertDirInodeUnlocked(Shard& shard, const std::string& dirID,
+         bool isBuddyMirrored, bool forceLoad);
 
       FhgfsOpsErr setDirParent(EntryInfo* entryInfo, uint16_t parentNodeID);
 
       void clearStoreUnlocked();
 
-      void cacheAddUnlocked(const std::string& dirID, DirectoryReferencer* dirRefer);
-      void cacheRemoveUnlocked(const std::string& dirID);
-      void cacheRemoveAllUnlocked();
-      bool cacheSweepUnlocked(bool isSyncSweep);
+      void cacheAddUnlocked(Shard& shard, const std::string& dirID, DirectoryReferencer* dirRefer);
+      void cacheRemoveUnlocked(Shard& shard, const std::string& dirID);
+      void cacheRemoveAllUnlocked(Shard& shard);
+      bool cacheSweepUnlocked(Shard& shard, bool isSyncSweep);
+
+      Shard& getShard(const std::string& dirID)
+      {
+         return shards[std::hash<std::string>()(dirID) % DIRSTORE_NUM_SHARDS];
+      }
 };
 
@@ -4,15 +4,27 @@
 #include "InodeFileStore.h"
 
 
+/**
+ * @param numShards number of independently locked parts of the store; more shards reduce lock
+ *    contention for stores with many concurrently used inodes, but each shard has a fixed memory
+ *    overhead.
+ */
+InodeFileStore::InodeFileStore(unsigned numShards) :
+   shards(new Shard[numShards ? numShards : 1]), numShards(numShards ? numShards : 1)
+{
+}
+
 /**
  * check if the given ID is in the store
  *
  */
 bool InodeFileStore::isInStore(const std::string& fileID)
 {
-   RWLockGuard lock(rwlock, SafeRWLock_READ);
+   Shard& shard = getShard(fileID);
+
+   RWLockGuard lock(shard.rwlock, SafeRWLock_READ);
 
-   return inodes.count(fileID) > 0;
+   return shard.inodes.count(fileID) > 0;
 }
 
 /**
@@ -21,14 +33,16 @@ bool InodeFileStore::isInStore(const std::string& fileID)
  */
 FileInodeReferencer* InodeFileStore::getReferencerAndDeleteFromMap(const std::string& fileID)
 {
-   RWLockGuard lock(rwlock, SafeRWLock_WRITE);
+   Shard& shard = getShard(fileID);
 
-   InodeMapIter iter = this->inodes.find(fileID);
+   RWLockGuard lock(shard.rwlock, SafeRWLock_WRITE);
 
-   if(iter != inodes.end() )
+   InodeMapIter iter = shard.inodes.find(fileID);
+
+   if(iter != shard.inodes.end() )
    { // exists in map
       auto fileRefer = iter->second;
-      this->inodes.erase(iter);
+      shard.inodes.erase(iter);
       return fileRefer;
    }
 
@@ -48,12 +62,14 @@ FileInodeReferencer* InodeFileStore::getReferencerAndDeleteFromMap(const std::st
  */
 FileInode* InodeFileStore::referenceLoadedFile(const std::string& entryID)
 {
-   RWLockGuard lock(rwlock, SafeRWLock_READ);
+   Shard& shard = getShard(entryID);
+
+   RWLockGuard lock(shard.rwlock, SafeRWLock_READ);
 
-   InodeMapIter iter = this->inodes.find(entryID);
+   InodeMapIter iter = shard.inodes.find(entryID);
 
-   if(iter != this->inodes.end() )
-      return referenceFileInodeMapIterUnlocked(iter);
+   if(iter != shard.inodes.end() )
+      return referenceFileInodeMapIterUnlocked(shard, iter);
 
    return nullptr;
 }
@@ -70,26 +86,30 @@ FileInode* InodeFileStore::referenceLoadedFile(const std::string& entryID)
  */
 FileInodeRes InodeFileStore::referenceFileInode(EntryInfo* entryInfo, bool loadFromDisk, bool checkLockStore)
 {
-   RWLockGuard lock(rwlock, SafeRWLock_WRITE);
-   return referenceFileInodeUnlocked(entryInfo, loadFromDisk, checkLockStore);
+   Shard& shard = getShard(entryInfo->getEntryID() );
+
+   RWLockGuard lock(shard.rwlock, SafeRWLock_WRITE);
+   return referenceFileInodeUnlocked(shard, entryInfo, loadFromDisk, checkLockStore);
 }
 
 /**
- * Note: this->rwlock needs to be write locked
+ * Note: shard.rwlock needs to be write locked
  *
+ * @param shard            the shard of entryInfo's entryID.
  * @param entryInfo        entry information of the file.
  * @param loadFromDisk     If true, load inode from disk if not already in memory.
  * @param checkLockStore   If true, verify that the inode is not locked by internal meta operations.
  *
  * @return  A pair of FileInode* and the FhgfsOpsErr. FileInode* will be set to nullptr on failure.
  */
-FileInodeRes InodeFileStore::referenceFileInodeUnlocked(EntryInfo* entryInfo, bool loadFromDisk, bool checkLockStore)
+FileInodeRes InodeFileStore::referenceFileInodeUnlocked(Shard& shard, EntryInfo* entryInfo,
+   bool loadFromDisk, bool checkLockStore)
 {
    FileInode* inode = nullptr;
    FhgfsOpsErr retVal = FhgfsOpsErr_PATHNOTEXISTS;
 
-   InodeMapIter iter =  this->inodes.find(entryInfo->getEntryID() );
-   if (iter == this->inodes.end() && loadFromDisk)
+   InodeMapIter iter =  shard.inodes.find(entryInfo->getEntryID() );
+   if (iter == shard.inodes.end() && loadFromDisk)
    {  // inode not in store => attempt to load it
       if (likely(checkLockStore))
       {
@@ -99,7 +119,7 @@ FileInodeRes InodeFileStore::referenceFileInodeUnlocked(EntryInfo* entryInfo, bo
          GlobalInodeLockStore* inodeLockStore = metaStore->getInodeLockStore();
          if (!inodeLockStore->lookupFileInode(entryInfo))
          {  // inode is not locked => try to load it
-            loadAndInsertFileInodeUnlocked(entryInfo, iter);
+            loadAndInsertFileInodeUnlocked(shard, entryInfo, iter);
          }
          else
          {  // inode is locked => return error to caller
@@ -109,13 +129,13 @@ FileInodeRes InodeFileStore::referenceFileInodeUnlocked(EntryInfo* entryInfo, bo
       else
       {
          // checkLockStore=false: skip lock check (used by internal meta operations)
-         loadAndInsertFileInodeUnlocked(entryInfo, iter);
+         loadAndInsertFileInodeUnlocked(shard, entryInfo, iter);
       }
    }
 
-   if (iter != this->inodes.end())
+   if (iter != shard.inodes.end())
    {  // inode exists in store
-      inode = referenceFileInodeMapIterUnlocked(iter);
+      inode = referenceFileInodeMapIterUnlocked(shard, iter);
       if (inode)
       {
          retVal = FhgfsOpsErr_SUCCESS;
@@ -128,19 +148,20 @@ FileInodeRes InodeFileStore::referenceFileInodeUnlocked(EntryInfo* entryInfo, bo
 /**
  * Return an unreferenced inode object. The inode is also not exclusively locked.
  */
-FhgfsOpsErr InodeFileStore::getUnreferencedInodeUnlocked(EntryInfo* entryInfo, FileInode*& outInode)
+FhgfsOpsErr InodeFileStore::getUnreferencedInodeUnlocked(Shard& shard, EntryInfo* entryInfo,
+   FileInode*& outInode)
 {
    FileInode* inode = NULL;
    FhgfsOpsErr retVal = FhgfsOpsErr_PATHNOTEXISTS;
 
-   InodeMapIter iter =  this->inodes.find(entryInfo->getEntryID() );
+   InodeMapIter iter =  shard.inodes.find(entryInfo->getEntryID() );
 
-   if(iter == this->inodes.end() )
+   if(iter == shard.inodes.end() )
    { // not in map yet => try to load it.
-      loadAndInsertFileInodeUnlocked(entryInfo, iter);
+      loadAndInsertFileInodeUnlocked(shard, entryInfo, iter);
    }
 
-   if(iter != this->inodes.end() )
+   if(iter != shard.inodes.end() )
    { // outInode exists => check whether no references etc. exist
       FileInodeReferencer* inodeRefer = iter->second;
       inode = inodeRefer->getReferencedObject();
@@ -173,7 +194,7 @@ FhgfsOpsErr InodeFileStore::getUnreferencedInodeUnlocked(EntryInfo* entryInfo, F
       // Since rename operations only modify the dentry and not the inode itself, and because this
       // inode is non-inlined and already isolated from dentry coupling, we no longer need to retain
       // the exclusive lock. Instead, we simply trigger cleanup for this unreferenced inode.
-      deleteUnreferencedInodeUnlocked(entryInfo->getEntryID() );
+      deleteUnreferencedInodeUnlocked(shard, entryInfo->getEntryID() );
       inode = NULL;
       retVal = FhgfsOpsErr_INUSE;
    }
@@ -184,11 +205,11 @@ FhgfsOpsErr InodeFileStore::getUnreferencedInodeUnlocked(EntryInfo* entryInfo, F
 
 /**
  * referece an a file from InodeMapIter
- * NOTE: iter should have been checked by the caller: iter != this->inodes.end()
+ * NOTE: iter should have been checked by the caller: iter != shard.inodes.end()
  */
-FileInode* InodeFileStore::referenceFileInodeMapIterUnlocked(InodeMapIter& iter)
+FileInode* InodeFileStore::referenceFileInodeMapIterUnlocked(Shard& shard, InodeMapIter& iter)
 {
-   if (unlikely(iter == inodes.end() ) )
+   if (unlikely(iter == shard.inodes.end() ) )
       return nullptr;
 
    FileInodeReferencer* inodeRefer = iter->second;
@@ -212,11 +233,11 @@ FileInode* InodeFileStore::referenceFileInodeMapIterUnlocked(InodeMapIter& iter)
 /**
  * Decrease the inode reference counter using the given iter.
  *
- * Note: InodeFileStore needs to be write-locked.
+ * Note: The shard of iter needs to be write-locked.
  *
  * @return number of inode references after release()
  */
-unsigned InodeFileStore::decreaseInodeRefCountUnlocked(InodeMapIter& iter)
+unsigned InodeFileStore::decreaseInodeRefCountUnlocked(Shard& shard, InodeMapIter& iter)
 {
    // decrease refount
    FileInodeReferencer* inodeRefer = iter->second;
@@ -229,7 +250,7 @@ unsigned InodeFileStore::decreaseInodeRefCountUnlocked(InodeMapIter& iter)
    if(!refCount)
    { // dropped last reference => unload outInode
       delete(inodeRefer);
-      this->inodes.erase(iter);
+      shard.inodes.erase(iter);
    }
 
 
@@ -242,13 +263,15 @@ unsigned InodeFileStore::decreaseInodeRefCountUnlocked(InodeMapIter& iter)
 bool InodeFileStore::closeFile(EntryInfo* entryInfo, FileInode* inode, unsigned accessFlags,
    unsigned* outNumHardlinks, unsigned* outNumRefs, bool& outLastWriterClosed)
 {
-   RWLockGuard lock(rwlock, SafeRWLock_WRITE);
+   Shard& shard = getShard(inode->getEntryID() );
+
+   RWLockGuard lock(shard.rwlock, SafeRWLock_WRITE);
 
    *outNumHardlinks = 1; // (we're careful here about inodes that are not currently open)
    outLastWriterClosed = false;
 
-   InodeMapIter iter = this->inodes.find(inode->getEntryID() );
-   if (iter != this->inodes.end() )
+   InodeMapIter iter = shard.inodes.find(inode->getEntryID() );
+   if (iter != shard.inodes.end() )
    { // outInode exists
 
       *outNumHardlinks = inode->getNumHardlinks();
@@ -264,7 +287,7 @@ bool InodeFileStore::closeFile(EntryInfo* entryInfo, FileInode* inode, unsigned
       if (!(accessFlags & OPENFILE_ACCESS_READ) && !inode->getNumSessionsWrite())
          outLastWriterClosed = true;
 
-      *outNumRefs = decreaseInodeRefCountUnlocked(iter);
+      *outNumRefs = decreaseInodeRefCountUnlocked(shard, iter);
 
       return true;
    }
@@ -278,12 +301,14 @@ bool InodeFileStore::closeFile(EntryInfo* entryInfo, FileInode* inode, unsigned
  */
 bool InodeFileStore::releaseFileInode(FileInode* inode)
 {
-   RWLockGuard lock(rwlock, SafeRWLock_WRITE);
+   Shard& shard = getShard(inode->getEntryID() );
+
+   RWLockGuard lock(shard.rwlock, SafeRWLock_WRITE);
 
-   InodeMapIter iter = this->inodes.find(inode->getEntryID() );
-   if(iter != this->inodes.end() )
+   InodeMapIter iter = shard.inodes.find(inode->getEntryID() );
+   if(iter != shard.inodes.end() )
    { // outInode exists => decrease refCount
-      decreaseInodeRefCountUnlocked(iter);
+      decreaseInodeRefCountUnlocked(shard, iter);
       return true;
    }
 
@@ -297,12 +322,12 @@ bool InodeFileStore::releaseFileInode(FileInode* inode)
  * @return FhgfsOpsErr_SUCCESS when not in use, FhgfsOpsErr_INUSE when the inode is referenced and
  *    FhgfsOpsErr_PATHNOTEXISTS when it is exclusively locked.
  */
-FhgfsOpsErr InodeFileStore::isUnlinkableUnlocked(EntryInfo* entryInfo)
+FhgfsOpsErr InodeFileStore::isUnlinkableUnlocked(Shard& shard, EntryInfo* entryInfo)
 {
    std::string entryID = entryInfo->getEntryID();
 
-   InodeMapCIter iter = inodes.find(entryID);
-   if(iter != inodes.end() )
+   InodeMapCIter iter = shard.inodes.find(entryID);
+   if(iter != shard.inodes.end() )
    {
       FileInodeReferencer* fileRefer = iter->second;
       FileInode* inode = fileRefer->getReferencedObject();
@@ -320,16 +345,18 @@ FhgfsOpsErr InodeFileStore::isUnlinkableUnlocked(EntryInfo* entryInfo)
 
 FhgfsOpsErr InodeFileStore::isUnlinkable(EntryInfo* entryInfo)
 {
-   RWLockGuard lock(rwlock, SafeRWLock_READ);
+   Shard& shard = getShard(entryInfo->getEntryID() );
+
+   RWLockGuard lock(shard.rwlock, SafeRWLock_READ);
 
-   return this->isUnlinkableUnlocked(entryInfo);
+   return this->isUnlinkableUnlocked(shard, entryInfo);
 }
 
 /**
  * @param outInode will be set to the unlinked file and the object must then be deleted by the
  * caller (can be NULL if the caller is not interested in the file)
  */
-FhgfsOpsErr InodeFileStore::unlinkFileInodeUnlocked(EntryInfo* entryInfo,
+FhgfsOpsErr InodeFileStore::unlinkFileInodeUnlocked(Shard& shard, EntryInfo* entryInfo,
       std::unique_ptr<FileInode>* outInode)
 {
    if(outInode)
@@ -337,7 +364,7 @@ FhgfsOpsErr InodeFileStore::unlinkFileInodeUnlocked(EntryInfo* entryInfo,
 
    std::string entryID = entryInfo->getEntryID();
 
-   FhgfsOpsErr unlinkableRes = isUnlinkableUnlocked(entryInfo);
+   FhgfsOpsErr unlinkableRes = isUnlinkableUnlocked(shard, entryInfo);
    if(unlinkableRes != FhgfsOpsErr_SUCCESS)
       return unlinkableRes;
 
@@ -367,9 +394,11 @@ FhgfsOpsErr InodeFileStore::unlinkFileInodeUnlocked(EntryInfo* entryInfo,
 FhgfsOpsErr InodeFileStore::unlinkFileInode(EntryInfo* entryInfo,
       std::unique_ptr<FileInode>* outInode)
 {
-   RWLockGuard lock(rwlock, SafeRWLock_WRITE);
+   Shard& shard = getShard(entryInfo->getEntryID() );
 
-   return unlinkFileInodeUnlocked(entryInfo, outInode);
+   RWLockGuard lock(shard.rwlock, SafeRWLock_WRITE);
+
+   return unlinkFileInodeUnlocked(shard, entryInfo, outInode);
 }
 
 /**
@@ -391,10 +420,12 @@ FhgfsOpsErr InodeFileStore::moveRemoteBegin(EntryInfo* entryInfo, char* buf, siz
       return FhgfsOpsErr_INTERNAL;
    }
 
-   RWLockGuard lock(rwlock, SafeRWLock_WRITE);
+   Shard& shard = getShard(entryInfo->getEntryID() );
+
+   RWLockGuard lock(shard.rwlock, SafeRWLock_WRITE);
 
    FileInode* inode;
-   FhgfsOpsErr retVal = getUnreferencedInodeUnlocked(entryInfo, inode); // does not set refCount
+   FhgfsOpsErr retVal = getUnreferencedInodeUnlocked(shard, entryInfo, inode); // no refCount
    if (retVal == FhgfsOpsErr_SUCCESS)
    {
       /* We got an inode, which is in the map, but is unreferenced. Now we are going to exclusively
@@ -427,22 +458,26 @@ FhgfsOpsErr InodeFileStore::moveRemoteBegin(EntryInfo* entryInfo, char* buf, siz
 FhgfsOpsErr InodeFileStore::moveRemoteComplete(const std::string& entryID)
 {
    // moving succeeded => delete original
-   RWLockGuard lock(rwlock, SafeRWLock_WRITE);
-   return deleteUnreferencedInodeUnlocked(entryID);
+   Shard& shard = getShard(entryID);
+
+   RWLockGuard lock(shard.rwlock, SafeRWLock_WRITE);
+   return deleteUnreferencedInodeUnlocked(shard, entryID);
 }
 
 /**
  * Finish the rename/move operation by deleting the inode object.
  *
+ * @param shard The (write-locked) shard of entryID
  * @param entryID The ID of the inode to delete
  * @return FhgfsOpsErr_SUCCESS if inode is deleted successfully,
  *         FhgfsOpsErr_INUSE if inode is referenced by concurrent operations,
  *         FhgfsOpsErr_PATHNOTEXISTS if inode not found in this store
  */
-FhgfsOpsErr InodeFileStore::deleteUnreferencedInodeUnlocked(const std::string& entryID)
+FhgfsOpsErr InodeFileStore::deleteUnreferencedInodeUnlocked(Shard& shard,
+   const std::string& entryID)
 {
-   InodeMapIter iter = inodes.find(entryID);
-   if (iter != inodes.end() )
+   InodeMapIter iter = shard.inodes.find(entryID);
+   if (iter != shard.inodes.end() )
    {  // inode exists
       FileInodeReferencer* fileRefer = iter->second;
 
@@ -469,7 +504,7 @@ FhgfsOpsErr InodeFileStore::deleteUnreferencedInodeUnlocked(const std::string& e
       }
 
       delete fileRefer;
-      inodes.erase(entryID);
+      shard.inodes.erase(iter);
       return FhgfsOpsErr_SUCCESS;
    }
    return FhgfsOpsErr_PATHNOTEXISTS;
@@ -481,9 +516,16 @@ FhgfsOpsErr InodeFileStore::deleteUnreferencedInodeUnlocked(const std::string& e
  */
 size_t InodeFileStore::getSize()
 {
-   RWLockGuard lock(rwlock, SafeRWLock_READ);
+   size_t size = 0;
 
-   return inodes.size();
+   for (unsigned i = 0; i < numShards; i++)
+   {
+      RWLockGuard lock(shards[i].rwlock, SafeRWLock_READ);
+
+      size += shards[i].inodes.size();
+   }
+
+   return size;
 }
 
 /**
@@ -531,11 +573,12 @@ FhgfsOpsErr InodeFileStore::openFile(EntryInfo* entryInfo, unsigned accessFlags,
 FhgfsOpsErr InodeFileStore::stat(EntryInfo* entryInfo, bool loadFromDisk, StatData& outStatData)
 {
    std::string entryID = entryInfo->getEntryID();
+   Shard& shard = getShard(entryID);
 
-   UniqueRWLock lock(rwlock, SafeRWLock_READ);
+   UniqueRWLock lock(shard.rwlock, SafeRWLock_READ);
 
-   InodeMapIter iter = inodes.find(entryID);
-   if(iter != inodes.end() )
+   InodeMapIter iter = shard.inodes.find(entryID);
+   if(iter != shard.inodes.end() )
    { // inode loaded
       FileInodeReferencer* fileRefer = iter->second;
       FileInode* inode = fileRefer->getReferencedObject();
@@ -560,11 +603,12 @@ FhgfsOpsErr InodeFileStore::setAttr(EntryInfo* entryInfo, int validAttribs,
    SettableFileAttribs* attribs)
 {
    std::string entryID = entryInfo->getEntryID();
+   Shard& shard = getShard(entryID);
 
-   RWLockGuard lock(rwlock, SafeRWLock_WRITE);
+   RWLockGuard lock(shard.rwlock, SafeRWLock_WRITE);
 
-   InodeMapIter iter = inodes.find(entryID);
-   if(iter == inodes.end() )
+   InodeMapIter iter = shard.inodes.find(entryID);
+   if(iter == shard.inodes.end() )
    { // not loaded => load, apply, destroy
 
       // Note: A very uncommon code path, as SetAttrMsgEx::setAttr() references the inode first.
@@ -609,16 +653,19 @@ FhgfsOpsErr InodeFileStore::setAttr(EntryInfo* entryInfo, int validAttribs,
  *
  * Note: Caller must make sure that the element wasn't in the map before.
  *
+ * @param shard the (write-locked) shard of entryInfo's entryID.
  * @return newElemIter only valid if true is returned, untouched otherwise
  */
-bool InodeFileStore::loadAndInsertFileInodeUnlocked(EntryInfo* entryInfo, InodeMapIter& newElemIter)
+bool InodeFileStore::loadAndInsertFileInodeUnlocked(Shard& shard, EntryInfo* entryInfo,
+   InodeMapIter& newElemIter)
 {
    FileInode* inode = FileInode::createFromEntryInfo(entryInfo);
    if(!inode)
       return false;
 
    std::string entryID = entryInfo->getEntryID();
-   newElemIter = inodes.insert(InodeMapVal(entryID, new FileInodeReferencer(inode) ) ).first;
+   newElemIter = shard.inodes.insert(
+      InodeMapVal(entryID, new FileInodeReferencer(inode) ) ).first;
 
    return true;
 }
@@ -630,20 +677,28 @@ bool InodeFileStore::loadAndInsertFileInodeUnlocked(EntryInfo* entryInfo, InodeM
  */
 bool InodeFileStore::insertReferencer(std::string entryID, FileInodeReferencer* fileRefer)
 {
-   RWLockGuard lock(rwlock, SafeRWLock_WRITE);
+   Shard& shard = getShard(entryID);
+
+   RWLockGuard lock(shard.rwlock, SafeRWLock_WRITE);
 
-   return this->inodes.insert(InodeMapVal(entryID, fileRefer) ).second;
+   return shard.inodes.insert(InodeMapVal(entryID, fileRefer) ).second;
 }
 
 
 void InodeFileStore::clearStoreUnlocked()
+{
+   for (unsigned i = 0; i < numShards; i++)
+      clearShardUnlocked(shards[i]);
+}
+
+void InodeFileStore::clearShardUnlocked(Shard& shard)
 {
    App* app = Program::getApp();
 
-   LOG_DBG(GENERAL, DEBUG, "InodeFileStore::clearStoreUnlocked",
-         ("# of loaded entries to be cleared", inodes.size()));
+   LOG_DBG(GENERAL, DEBUG, "InodeFileStore::clearShardUnlocked",
+         ("# of loaded entries to be cleared", shard.inodes.size()));
 
-   for(InodeMapIter iter = inodes.begin(); iter != inodes.end(); iter++)
+   for(InodeMapIter iter = shard.inodes.begin(); iter != shard.inodes.end(); iter++)
    {
       FileInode* file = iter->second->getReferencedObject();
 
@@ -659,7 +714,7 @@ void InodeFileStore::clearStoreUnlocked()
       delete(iter->second);
    }
 
-   inodes.clear();
+   shard.inodes.clear();
 }
 
 /**
@@ -21,14 +21,18 @@ typedef std::pair<FileInode*, FhgfsOpsErr>  FileInodeRes;
  * Layer in between our inodes and the data on the underlying file system. So we read/write from/to
  * underlying inodes and this class is to do this corresponding data access.
  * This object is used for all file types, for example regular files, but NOT directories.
+ *
+ * The inodes are distributed over a number of shards by the hash of their entryID. Each shard has
+ * its own map and lock, so operations on different inodes usually don't contend for the same lock.
  */
 class InodeFileStore
 {
    friend class DirInode;
    friend class MetaStore;
+   friend class TestInodeFileStore;
 
    public:
-      InodeFileStore() {}
+      InodeFileStore(unsigned numShards = 1);
       ~InodeFileStore()
       {
          this->clearStoreUnlocked();
@@ -58,28 +62,37 @@ class InodeFileStore
       FhgfsOpsErr isUnlinkable(EntryInfo* entryInfo);
 
    private:
-      InodeMap inodes;
+      struct Shard
+      {
+         InodeMap inodes;
+         RWLock rwlock;
+      };
 
-      RWLock rwlock;
+      std::unique_ptr<Shard[]> shards;
+      unsigned numShards;
 
-      unsigned decreaseInodeRefCountUnlocked(InodeMapIter& iter);
-      FileInodeRes referenceFileInodeUnlocked(EntryInfo* entryInfo, bool loadFromDisk, bool checkLockStore = true);
-      FhgfsOpsErr getUnreferencedInodeUnlocked(EntryInfo* entryInfo, FileInode*& outInode);
-      FhgfsOpsErr deleteUnreferencedInodeUnlocked(const std::string& entryID);
+      unsigned decreaseInodeRefCountUnlocked(Shard& shard, InodeMapIter& iter);
+      FileInodeRes referenceFileInodeUnlocked(Shard& shard, EntryInfo* entryInfo,
+         bool loadFromDisk, bool checkLockStore = true);
+      FhgfsOpsErr getUnreferencedInodeUnlocked(Shard& shard, EntryInfo* entryInfo,
+         FileInode*& outInode);
+      FhgfsOpsErr deleteUnreferencedInodeUnlocked(Shard& shard, const std::string& entryID);
 
-      FhgfsOpsErr isUnlinkableUnlocked(EntryInfo* entryInfo);
+      FhgfsOpsErr isUnlinkableUnlocked(Shard& shard, EntryInfo* entryInfo);
 
-      FhgfsOpsErr unlinkFileInodeUnlocked(EntryInfo* entryInfo,
+      FhgfsOpsErr unlinkFileInodeUnlocked(Shard& shard, EntryInfo* entryInfo,
             std::unique_ptr<FileInode>* outInode);
 
-      bool loadAndInsertFileInodeUnlocked(EntryInfo* entryInfo, InodeMapIter& newElemIter);
+      bool loadAndInsertFileInodeUnlocked(Shard& shard, EntryInfo* entryInfo,
+         InodeMapIter& newElemIter);
       bool insertReferencer(std::string entryID, FileInodeReferencer* fileRefer);
 
       FileInodeReferencer* getReferencerAndDeleteFromMap(const std::string& fileID);
 
       void clearStoreUnlocked();
+      void clearShardUnlocked(Shard& shard);
 
-      FileInode* referenceFileInodeMapIterUnlocked(InodeMapIter& iter);
+      FileInode* referenceFileInodeMapIterUnlocked(Shard& shard, InodeMapIter& iter);
 
       FhgfsOpsErr incDecLinkCount(FileInode& inode, EntryInfo* entryInfo, int value);
 
@@ -102,6 +115,11 @@ class InodeFileStore
 
       // inliners
 
+      Shard& getShard(const std::string& entryID)
+      {
+         return shards[std::hash<std::string>()(entryID) % numShards];
+      }
+
       /**
        * Create an unreferenced file inode from an existing inode on disk disk.
        */
@@ -309,7 +309,7 @@ struct RangeLockDetails
     */
    bool equalsHandle(const RangeLockDetails& other) const
    {
-      // note: if you make changes here, you (probably) also need to change the MapComparators
+      // note: if you make changes here, you (probably) also need to change RangeLockTree::keyLess
 
       return (ownerPID == other.ownerPID) && (clientNumID == other.clientNumID);
    }
@@ -427,64 +427,45 @@ struct RangeLockDetails
 
       return outStream.str();
    }
+};
 
-   struct MapComparatorShared
-   {
-      /**
-       * Order by file handle, then range start (to make overlap detection for same handle easy).
-       *
-       * @return true if a is smaller than b
-       */
-      bool operator() (const RangeLockDetails& a, const RangeLockDetails& b) const
-      {
-         if(a.ownerPID < b.ownerPID)
-            return true;
-         if(a.ownerPID > b.ownerPID)
-            return false;
 
-         // equal ownerPID
+typedef std::list<RangeLockDetails> RangeLockDetailsList;
+typedef RangeLockDetailsList::iterator RangeLockDetailsListIter;
+typedef RangeLockDetailsList::const_iterator RangeLockDetailsListCIter;
 
-         if(a.clientNumID < b.clientNumID)
-            return true;
-         if(a.clientNumID > b.clientNumID)
-            return false;
 
-         // equal clientID
+/**
+ * Per-inode statistics of range lock requests to identify files with contended range locks.
+ */
+struct RangeLockStats
+{
+   RangeLockStats() :
+      numGrantedImmediately(0), numEnqueued(0), numGrantedFromQueue(0), numRejected(0),
+      maxQueuedWaiters(0)
+   { }
 
-         if(a.start < b.start)
-            return true;
+   uint64_t numGrantedImmediately; // lock requests without conflicts
+   uint64_t numEnqueued; // lock requests that had to wait for conflicting locks
+   uint64_t numGrantedFromQueue; // waiting requests that were granted later
+   uint64_t numRejected; // conflicting requests that didn't want to wait
+   size_t maxQueuedWaiters; // high watermark of the waiters queues
 
-         return false;
-      }
-   };
+   bool isContended() const
+   {
+      return numEnqueued || numRejected;
+   }
 
-   struct MapComparatorExcl
+   std::string toString() const
    {
-      /**
-       * Order by range start (to make general overlap detection easy).
-       *
-       * @return true if a is smaller than b
-       */
-      bool operator() (const RangeLockDetails& a, const RangeLockDetails& b) const
-      {
-         // note: this only works because we cannot have range overlaps for exclusive locks
-         return (a.start < b.start);
-      }
-   };
+      std::ostringstream outStream;
+      outStream <<
+         "granted immediately: " << numGrantedImmediately << "; " <<
+         "enqueued: " << numEnqueued << "; " <<
+         "granted from queue: " << numGrantedFromQueue << "; " <<
+         "rejected: " << numRejected << "; " <<
+         "max queued: " << maxQueuedWaiters;
 
+      return outStream.str();
+   }
 };
-
-
-typedef std::set<RangeLockDetails, RangeLockDetails::MapComparatorShared> RangeLockSharedSet;
-typedef RangeLockSharedSet::iterator RangeLockSharedSetIter;
-typedef RangeLockSharedSet::const_iterator RangeLockSharedSetCIter;
-
-typedef std::set<RangeLockDetails, RangeLockDetails::MapComparatorExcl> RangeLockExclSet;
-typedef RangeLockExclSet::iterator RangeLockExclSetIter;
-typedef RangeLockExclSet::const_iterator RangeLockExclSetCIter;
-
-typedef std::list<RangeLockDetails> RangeLockDetailsList;
-typedef RangeLockDetailsList::iterator RangeLockDetailsListIter;
-typedef RangeLockDetailsList::const_iterator RangeLockDetailsListCIter;
-
-
@@ -1922,6 +1922,49 @@ bool MetaStore::cacheSweepAsync()
    return dirStore.cacheSweepAsync();
 }
 
+/**
+ * Write back deferred dynamic attribs updates of file inodes (see
+ * FileInode::decNumSessionsAndStore() ).
+ *
+ * @param flushAll false to only write back inodes that are dirty for tuneInodeWriteBackSecs.
+ * @param refreshUnloaded true to refresh the dyn attribs from the storage targets if the inode was
+ *    unloaded after a deferred close (needs the workers); otherwise such inodes stay marked dirty
+ *    on disk and are refreshed by the next stat.
+ */
+void MetaStore::flushDirtyInodes(bool flushAll, bool refreshUnloaded)
+{
+   const unsigned writeBackMS = Program::getApp()->getConfig()->getTuneInodeWriteBackSecs() * 1000;
+
+   EntryInfoList dirtyEntries = flushAll ?
+      dirtyInodes.takeAll() : dirtyInodes.takeOlderThan(writeBackMS);
+
+   for(EntryInfoListIter iter = dirtyEntries.begin(); iter != dirtyEntries.end(); iter++)
+   {
+      FhgfsOpsErr flushRes = FhgfsOpsErr_DYNAMICATTRIBSOUTDATED;
+
+      MetaFileHandle inode = referenceLoadedFile(iter->getParentEntryID(),
+         iter->getIsBuddyMirrored(), iter->getEntryID() );
+      if(inode)
+      {
+         flushRes = inode->flushDynAttribs(&*iter, false);
+         releaseFile(iter->getParentEntryID(), inode);
+      }
+
+      if( (flushRes == FhgfsOpsErr_DYNAMICATTRIBSOUTDATED) && refreshUnloaded)
+      { // unloaded after the last close (flushed by the refresh unless it was opened for writing)
+         flushRes = MsgHelperStat::refreshDynAttribs(&*iter, false, 0);
+         if(flushRes == FhgfsOpsErr_PATHNOTEXISTS)
+            flushRes = FhgfsOpsErr_SUCCESS; // unlinked or moved to another dir in the meantime
+      }
+
+      if( (flushRes != FhgfsOpsErr_SUCCESS) &&
+          (flushRes != FhgfsOpsErr_DYNAMICATTRIBSOUTDATED) )
+         LOG(GENERAL, WARNING, "Failed to write back dynamic file attribs.",
+               ("entryID", iter->getEntryID() ), ("parentID", iter->getParentEntryID() ),
+               ("error", flushRes) );
+   }
+}
+
 /**
  * So we failed to delete chunk files and need to create a new disposal file for later cleanup.
  *
@@ -17,6 +17,7 @@
 #include <session/EntryLock.h>
 
 #include "DirEntry.h"
+#include "DirtyInodeStore.h"
 #include "InodeDirStore.h"
 #include "InodeFileStore.h"
 #include "MetadataEx.h"
@@ -24,6 +25,8 @@
 
 typedef std::pair<MetaFileHandle, FhgfsOpsErr>  MetaFileHandleRes;
 
+#define METASTORE_FILESTORE_NUM_SHARDS  64 /* shards of the global (non-inlined) inode store */
+
 /*
  * This is the main class for all client side posix io operations regarding the meta server.
  * So client side net message will do io via this class.
@@ -95,6 +98,7 @@ class MetaStore
       void getCacheStats(size_t* numCachedDirs);
 
       bool cacheSweepAsync();
+      void flushDirtyInodes(bool flushAll, bool refreshUnloaded);
 
       FhgfsOpsErr insertDisposableFile(FileInode* inode);
 
@@ -126,11 +130,13 @@ class MetaStore
       InodeDirStore dirStore;
 
       /* We need to avoid to use that one, as it is a global store, with possible lots of entries.
-       * So access to the map is slow and inserting entries blocks the entire MetaStore */
-      InodeFileStore fileStore;
+       * It is sharded, so that inserting entries only blocks the inodes of one shard. */
+      InodeFileStore fileStore{METASTORE_FILESTORE_NUM_SHARDS};
 
       GlobalInodeLockStore inodeLockStore;
 
+      DirtyInodeStore dirtyInodes; // inodes with deferred dyn attribs updates
+
       RWLock rwlock; /* note: this is mostly not used as a read/write-lock but rather a shared/excl
          lock (because we're not really modifying anyting directly) - especially relevant for the
          mutliple dirStore locking dual-move methods */
@@ -200,6 +206,11 @@ class MetaStore
       {
         return &inodeLockStore;
       }
+
+      DirtyInodeStore* getDirtyInodeStore()
+      {
+         return &dirtyInodes;
+      }
       // inliners
 
 };
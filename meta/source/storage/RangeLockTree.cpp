@@ -0,0 +1,393 @@
+#include <common/toolkit/serialization/Serialization.h>
+#include "RangeLockTree.h"
+
+
+void RangeLockTree::insert(const RangeLockDetails& lock)
+{
+   int32_t newIndex = allocNode(lock);
+
+   root = insertRec(root, newIndex);
+   numLocks++;
+}
+
+/**
+ * Remove the lock with the same range start, owner and lockAckID as the given lock.
+ *
+ * @return false if no such lock exists.
+ */
+bool RangeLockTree::erase(const RangeLockDetails& lock)
+{
+   bool erased = false;
+
+   root = eraseRec(root, lock, erased);
+
+   if(erased)
+      numLocks--;
+
+   return erased;
+}
+
+void RangeLockTree::clear()
+{
+   nodes.clear();
+   freeNodes.clear();
+   root = NIL_INDEX;
+   numLocks = 0;
+}
+
+/**
+ * Find a lock that overlaps the given lock and is not owned by the same handle.
+ *
+ * @param outConflictor may be NULL if the caller is not interested in the conflicting lock.
+ * @return true if a conflicting lock was found.
+ */
+bool RangeLockTree::findConflict(const RangeLockDetails& lock,
+   RangeLockDetails* outConflictor) const
+{
+   bool walkCompleted = forEachOverlap(lock.start, lock.end,
+      [&] (const RangeLockDetails& other) {
+         if(lock.equalsHandle(other) )
+            return true; // locks of the same owner never conflict (up-/downgrades)
+
+         SAFE_ASSIGN(outConflictor, other);
+         return false;
+      });
+
+   return !walkCompleted;
+}
+
+/**
+ * @return copies of all locks that overlap [start, end] in order of range start.
+ */
+RangeLockDetailsVec RangeLockTree::getOverlaps(uint64_t start, uint64_t end) const
+{
+   RangeLockDetailsVec overlaps;
+
+   forEachOverlap(start, end, [&] (const RangeLockDetails& lock) {
+      overlaps.push_back(lock);
+      return true;
+   });
+
+   return overlaps;
+}
+
+/**
+ * @return copies of all locks in order of range start.
+ */
+RangeLockDetailsVec RangeLockTree::getAll() const
+{
+   RangeLockDetailsVec locks;
+
+   locks.reserve(numLocks);
+
+   forEach([&] (const RangeLockDetails& lock) {
+      locks.push_back(lock);
+      return true;
+   });
+
+   return locks;
+}
+
+bool RangeLockTree::operator==(const RangeLockTree& other) const
+{
+   return getAll() == other.getAll();
+}
+
+/**
+ * Check order, AVL balance, heights and maxEnd of all nodes (for unit tests).
+ *
+ * @return false if the tree is corrupt.
+ */
+bool RangeLockTree::checkInvariants() const
+{
+   int32_t height;
+   uint64_t maxEnd;
+   size_t numNodes = 0;
+
+   if(!checkInvariantsRec(root, NULL, NULL, height, maxEnd, numNodes) )
+      return false;
+
+   return (numNodes == numLocks) && (nodes.size() == numLocks + freeNodes.size() );
+}
+
+int32_t RangeLockTree::allocNode(const RangeLockDetails& lock)
+{
+   const Node newNode = {lock, lock.end, NIL_INDEX, NIL_INDEX, 1};
+
+   if(freeNodes.empty() )
+   {
+      nodes.push_back(newNode);
+      return nodes.size() - 1;
+   }
+
+   const int32_t index = freeNodes.back();
+   freeNodes.pop_back();
+
+   nodes[index] = newNode;
+
+   return index;
+}
+
+void RangeLockTree::freeNode(int32_t index)
+{
+   nodes[index].lock.lockAckID.clear();
+   nodes[index].lock.lockAckID.shrink_to_fit();
+
+   freeNodes.push_back(index);
+}
+
+/**
+ * @return new root index of the subtree.
+ */
+int32_t RangeLockTree::insertRec(int32_t index, int32_t newIndex)
+{
+   if(index == NIL_INDEX)
+      return newIndex;
+
+   if(keyLess(nodes[newIndex].lock, nodes[index].lock) )
+   {
+      int32_t left = insertRec(nodes[index].left, newIndex);
+      nodes[index].left = left;
+   }
+   else
+   {
+      int32_t right = insertRec(nodes[index].right, newIndex);
+      nodes[index].right = right;
+   }
+
+   return rebalance(index);
+}
+
+/**
+ * @return new root index of the subtree.
+ */
+int32_t RangeLockTree::eraseRec(int32_t index, const RangeLockDetails& lock, bool& outErased)
+{
+   if(index == NIL_INDEX)
+      return NIL_INDEX;
+
+   if(keyLess(lock, nodes[index].lock) )
+   {
+      int32_t left = eraseRec(nodes[index].left, lock, outErased);
+      nodes[index].left = left;
+   }
+   else
+   if(keyLess(nodes[index].lock, lock) )
+   {
+      int32_t right = eraseRec(nodes[index].right, lock, outErased);
+      nodes[index].right = right;
+   }
+   else
+   { // found it => replace by the smallest node of the right subtree
+      int32_t left = nodes[index].left;
+      int32_t right = nodes[index].right;
+
+      outErased = true;
+      freeNode(index);
+
+      if(right == NIL_INDEX)
+         return left;
+
+      int32_t minIndex;
+      right = detachMin(right, minIndex);
+
+      nodes[minIndex].left = left;
+      nodes[minIndex].right = right;
+
+      return rebalance(minIndex);
+   }
+
+   if(!outErased)
+      return index; // nothing changed in the subtree
+
+   return rebalance(index);
+}
+
+/**
+ * Unlink the smallest node of a subtree.
+ *
+ * @return new root index of the subtree.
+ */
+int32_t RangeLockTree::detachMin(int32_t index, int32_t& outMinIndex)
+{
+   if(nodes[index].left == NIL_INDEX)
+   {
+      outMinIndex = index;
+      return nodes[index].right;
+   }
+
+   int32_t left = detachMin(nodes[index].left, outMinIndex);
+   nodes[index].left = left;
+
+   return rebalance(index);
+}
+
+/**
+ * Restore the AVL property of a node whose subtrees differ by at most 2 in height and update its
+ * height and maxEnd.
+ *
+ * @return new root index of the subtree.
+ */
+int32_t RangeLockTree::rebalance(int32_t index)
+{
+   auto heightOf = [this] (int32_t i) { return (i == NIL_INDEX) ? 0 : nodes[i].height; };
+
+   int32_t balance = heightOf(nodes[index].left) - heightOf(nodes[index].right);
+
+   if(balance > 1)
+   {
+      int32_t left = nodes[index].left;
+
+      if(heightOf(nodes[left].left) < heightOf(nodes[left].right) )
+         nodes[index].left = rotateLeft(left);
+
+      return rotateRight(index);
+   }
+
+   if(balance < -1)
+   {
+      int32_t right = nodes[index].right;
+
+      if(heightOf(nodes[right].right) < heightOf(nodes[right].left) )
+         nodes[index].right = rotateRight(right);
+
+      return rotateLeft(index);
+   }
+
+   update(index);
+
+   return index;
+}
+
+int32_t RangeLockTree::rotateLeft(int32_t index)
+{
+   int32_t newRoot = nodes[index].right;
+
+   nodes[index].right = nodes[newRoot].left;
+   nodes[newRoot].left = index;
+
+   update(index);
+   update(newRoot);
+
+   return newRoot;
+}
+
+int32_t RangeLockTree::rotateRight(int32_t index)
+{
+   int32_t newRoot = nodes[index].left;
+
+   nodes[index].left = nodes[newRoot].right;
+   nodes[newRoot].right = index;
+
+   update(index);
+   update(newRoot);
+
+   return newRoot;
+}
+
+/**
+ * Recompute height and maxEnd of a node from its children.
+ */
+void RangeLockTree::update(int32_t index)
+{
+   Node& node = nodes[index];
+
+   node.height = 1;
+   node.maxEnd = node.lock.end;
+
+   if(node.left != NIL_INDEX)
+   {
+      node.height = nodes[node.left].height + 1;
+      node.maxEnd = BEEGFS_MAX(node.maxEnd, nodes[node.left].maxEnd);
+   }
+
+   if(node.right != NIL_INDEX)
+   {
+      node.height = BEEGFS_MAX(node.height, nodes[node.right].height + 1);
+      node.maxEnd = BEEGFS_MAX(node.maxEnd, nodes[node.right].maxEnd);
+   }
+}
+
+/**
+ * Order by range start, then by owner and lockAckID (to allow overlapping ranges).
+ *
+ * @return true if a is smaller than b
+ */
+bool RangeLockTree::keyLess(const RangeLockDetails& a, const RangeLockDetails& b)
+{
+   if(a.start != b.start)
+      return (a.start < b.start);
+
+   if(a.clientNumID != b.clientNumID)
+      return (a.clientNumID < b.clientNumID);
+
+   if(a.ownerPID != b.ownerPID)
+      return (a.ownerPID < b.ownerPID);
+
+   return (a.lockAckID < b.lockAckID);
+}
+
+/**
+ * @param lowerBound NULL or a lock that all locks of the subtree must not be smaller than.
+ * @param upperBound NULL or a lock that all locks of the subtree must be smaller than.
+ */
+bool RangeLockTree::checkInvariantsRec(int32_t index, const RangeLockDetails* lowerBound,
+   const RangeLockDetails* upperBound, int32_t& outHeight, uint64_t& outMaxEnd,
+   size_t& outNumNodes) const
+{
+   outHeight = 0;
+   outMaxEnd = 0;
+
+   if(index == NIL_INDEX)
+      return true;
+
+   const Node& node = nodes[index];
+
+   if( (lowerBound && keyLess(node.lock, *lowerBound) ) ||
+       (upperBound && !keyLess(node.lock, *upperBound) ) )
+      return false;
+
+   int32_t leftHeight;
+   int32_t rightHeight;
+   uint64_t leftMaxEnd;
+   uint64_t rightMaxEnd;
+
+   if(!checkInvariantsRec(node.left, lowerBound, &node.lock, leftHeight, leftMaxEnd,
+         outNumNodes) ||
+      !checkInvariantsRec(node.right, &node.lock, upperBound, rightHeight, rightMaxEnd,
+         outNumNodes) )
+      return false;
+
+   outHeight = BEEGFS_MAX(leftHeight, rightHeight) + 1;
+   outMaxEnd = BEEGFS_MAX(node.lock.end, BEEGFS_MAX(leftMaxEnd, rightMaxEnd) );
+   outNumNodes++;
+
+   return (node.height == outHeight) && (node.maxEnd == outMaxEnd) &&
+      (std::abs(leftHeight - rightHeight) <= 1);
+}
+
+
+/**
+ * Uses the same format as a std::set of the locks.
+ */
+Serializer& operator%(Serializer& ser, const RangeLockTree& tree)
+{
+   return ser % tree.getAll();
+}
+
+Deserializer& operator%(Deserializer& des, RangeLockTree& tree)
+{
+   RangeLockDetailsVec locks;
+
+   des % locks;
+
+   if(unlikely(!des.good() ) )
+      return des;
+
+   tree.clear();
+
+   for(RangeLockDetailsVec::const_iterator iter = locks.begin(); iter != locks.end(); iter++)
+      tree.insert(*iter);
+
+   return des;
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <common/Common.h>
+#include "Locking.h"
+
+#include <vector>
+
+
+class Serializer;
+class Deserializer;
+
+typedef std::vector<RangeLockDetails> RangeLockDetailsVec;
+
+
+/**
+ * Interval tree of range locks (a balanced AVL tree ordered by range start and augmented with the
+ * maximum range end of each subtree), so that all locks overlapping a given range can be found in
+ * O(log n + number of overlaps) instead of scanning all locks of the file.
+ *
+ * Locks are identified by range start, owner and lockAckID, so overlapping ranges of different
+ * owners (shared locks) or queued requests can be stored in the same tree.
+ *
+ * Nodes are kept in a vector and linked by index, so the tree is copyable and a lock/unlock
+ * cycle doesn't allocate once the vector has grown to the number of locks of the file.
+ *
+ * Note: Not thread-safe, the owning inode's lock protects it.
+ */
+class RangeLockTree
+{
+   public:
+      RangeLockTree() : root(NIL_INDEX), numLocks(0) {}
+
+      void insert(const RangeLockDetails& lock);
+      bool erase(const RangeLockDetails& lock);
+      void clear();
+
+      bool findConflict(const RangeLockDetails& lock, RangeLockDetails* outConflictor) const;
+      RangeLockDetailsVec getOverlaps(uint64_t start, uint64_t end) const;
+      RangeLockDetailsVec getAll() const;
+
+      bool operator==(const RangeLockTree& other) const;
+      bool operator!=(const RangeLockTree& other) const { return !(*this == other); }
+
+      bool checkInvariants() const;
+
+
+   private:
+      static const int32_t NIL_INDEX = -1;
+
+      struct Node
+      {
+         RangeLockDetails lock;
+         uint64_t maxEnd; // max lock.end in the subtree of this node
+         int32_t left;
+         int32_t right;
+         int32_t height;
+      };
+
+      std::vector<Node> nodes;
+      std::vector<int32_t> freeNodes; // indices of unused elements in nodes
+      int32_t root;
+      size_t numLocks;
+
+      int32_t allocNode(const RangeLockDetails& lock);
+      void freeNode(int32_t index);
+
+      int32_t insertRec(int32_t index, int32_t newIndex);
+      int32_t eraseRec(int32_t index, const RangeLockDetails& lock, bool& outErased);
+      int32_t detachMin(int32_t index, int32_t& outMinIndex);
+
+      int32_t rebalance(int32_t index);
+      int32_t rotateLeft(int32_t index);
+      int32_t rotateRight(int32_t index);
+      void update(int32_t index);
+
+      static bool keyLess(const RangeLockDetails& a, const RangeLockDetails& b);
+
+      bool checkInvariantsRec(int32_t index, const RangeLockDetails* lowerBound,
+         const RangeLockDetails* upperBound, int32_t& outHeight, uint64_t& outMaxEnd,
+         size_t& outNumNodes) const;
+
+
+   public:
+      // inliners
+
+      size_t size() const
+      {
+         return numLocks;
+      }
+
+      bool empty() const
+      {
+         return !numLocks;
+      }
+
+      /**
+       * Call fn for each lock that overlaps [start, end] in order of range start.
+       *
+       * @param fn bool(const RangeLockDetails&), returns false to stop.
+       * @return false if fn stopped the walk.
+       */
+      template<typename Fn>
+      bool forEachOverlap(uint64_t start, uint64_t end, Fn fn) const
+      {
+         return forEachOverlapRec(root, start, end, fn);
+      }
+
+      /**
+       * Call fn for each lock in order of range start.
+       *
+       * @param fn bool(const RangeLockDetails&), returns false to stop.
+       */
+      template<typename Fn>
+      void forEach(Fn fn) const
+      {
+         forEachOverlapRec(root, 0, ~0ULL, fn);
+      }
+
+      /**
+       * Remove all locks that match the given predicate.
+       *
+       * @param pred bool(const RangeLockDetails&)
+       * @return true if any lock was removed.
+       */
+      template<typename Pred>
+      bool eraseIf(Pred pred)
+      {
+         RangeLockDetailsVec matches;
+
+         forEach([&] (const RangeLockDetails& lock) {
+            if(pred(lock) )
+               matches.push_back(lock);
+
+            return true;
+         });
+
+         for(RangeLockDetailsVec::const_iterator iter = matches.begin();
+             iter != matches.end();
+             iter++)
+            erase(*iter);
+
+         return !matches.empty();
+      }
+
+
+   private:
+      template<typename Fn>
+      bool forEachOverlapRec(int32_t index, uint64_t start, uint64_t end, Fn& fn) const
+      {
+         if( (index == NIL_INDEX) || (nodes[index].maxEnd < start) )
+            return true; // nothing in this subtree ends at or after start
+
+         const Node& node = nodes[index];
+
+         if(!forEachOverlapRec(node.left, start, end, fn) )
+            return false;
+
+         if(node.lock.start > end)
+            return true; // this node and everything in the right subtree starts after end
+
+         if( (node.lock.end >= start) && !fn(node.lock) )
+            return false;
+
+         return forEachOverlapRec(node.right, start, end, fn);
+      }
+};
+
+
+Serializer& operator%(Serializer& ser, const RangeLockTree& tree);
+Deserializer& operator%(Deserializer& des, RangeLockTree& tree);
+
@@ -0,0 +1,92 @@
+#include <components/worker/GetChunkFileAttribsBatcher.h>
+
+#include <gtest/gtest.h>
+
+class TestChunkFileAttribsBatcher : public ::testing::Test
+{
+   protected:
+      static const unsigned maxBatchSize = 2;
+      static const unsigned windowUS = 50000;
+
+      MultiWorkQueue slaveQueue; // (deletes the queued works)
+      GetChunkFileAttribsBatcher batcher{&slaveQueue, maxBatchSize, windowUS};
+
+      PathInfo pathInfo;
+      DynamicFileAttribs dynAttribs[4];
+      FhgfsOpsErr results[4];
+      SynchronizedCounter counter;
+
+      void add(unsigned index, uint16_t targetID,
+         GetChunkFileAttribsBatcher::OpenedBatchVec& openedBatches)
+      {
+         batcher.add(targetID, false, "entry" + std::to_string(index), pathInfo,
+            &dynAttribs[index], &results[index], &counter, 0, openedBatches);
+      }
+};
+
+TEST_F(TestChunkFileAttribsBatcher, fullBatchIsSentByFillingRequest)
+{
+   GetChunkFileAttribsBatcher::OpenedBatchVec firstOpened;
+   GetChunkFileAttribsBatcher::OpenedBatchVec secondOpened;
+
+   add(0, 1, firstOpened);
+   ASSERT_EQ(firstOpened.size(), 1u);
+   ASSERT_EQ(slaveQueue.getDirectWorkListSize(), 0u); // (no comm slave waits for the window)
+
+   add(1, 1, secondOpened);
+   ASSERT_TRUE(secondOpened.empty() ); // joined the open batch
+   ASSERT_EQ(slaveQueue.getDirectWorkListSize(), 1u);
+
+   // nothing left to send for the opener => no wait for the window
+   auto startTime = std::chrono::steady_clock::now();
+   batcher.sendOpenedBatches(firstOpened);
+
+   ASSERT_LT(std::chrono::steady_clock::now() - startTime, std::chrono::microseconds(windowUS) );
+   ASSERT_EQ(slaveQueue.getDirectWorkListSize(), 1u);
+}
+
+TEST_F(TestChunkFileAttribsBatcher, openerSendsAfterWindow)
+{
+   GetChunkFileAttribsBatcher::OpenedBatchVec opened;
+
+   auto startTime = std::chrono::steady_clock::now();
+
+   add(0, 1, opened);
+   add(1, 2, opened);
+   ASSERT_EQ(opened.size(), 2u);
+
+   batcher.sendOpenedBatches(opened);
+
+   ASSERT_GE(std::chrono::steady_clock::now() - startTime, std::chrono::microseconds(windowUS) );
+   ASSERT_EQ(slaveQueue.getDirectWorkListSize(), 2u);
+
+   // the batches are closed => a new request for the same target opens a new batch
+   GetChunkFileAttribsBatcher::OpenedBatchVec laterOpened;
+
+   add(2, 1, laterOpened);
+   ASSERT_EQ(laterOpened.size(), 1u);
+
+   batcher.sendOpenedBatches(laterOpened);
+   ASSERT_EQ(slaveQueue.getDirectWorkListSize(), 3u);
+}
+
+TEST_F(TestChunkFileAttribsBatcher, refilledBatchIsNotClosedByOldOpener)
+{
+   GetChunkFileAttribsBatcher::OpenedBatchVec firstOpened;
+   GetChunkFileAttribsBatcher::OpenedBatchVec otherOpened;
+   GetChunkFileAttribsBatcher::OpenedBatchVec secondOpened;
+
+   add(0, 1, firstOpened);
+   add(1, 1, otherOpened); // full => sent
+   add(2, 1, secondOpened); // new batch for the same target
+
+   ASSERT_EQ(secondOpened.size(), 1u);
+   ASSERT_NE(secondOpened[0].second, firstOpened[0].second);
+
+   // the first opener must leave the new batch open for its own window
+   batcher.sendOpenedBatches(firstOpened);
+   ASSERT_EQ(slaveQueue.getDirectWorkListSize(), 1u);
+
+   add(3, 1, otherOpened);
+   ASSERT_EQ(slaveQueue.getDirectWorkListSize(), 2u);
+}
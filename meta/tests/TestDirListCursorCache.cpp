@@ -0,0 +1,139 @@
+#include <storage/DirListCursorCache.h>
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+class TestDirListCursorCache : public ::testing::Test
+{
+   protected:
+      std::string dirPath;
+
+      void SetUp() override
+      {
+         char dirTemplate[] = "/tmp/beegfs-test-dirlistcursor.XXXXXX";
+
+         ASSERT_NE(mkdtemp(dirTemplate), nullptr);
+         dirPath = dirTemplate;
+      }
+
+      void TearDown() override
+      {
+         rmdir(dirPath.c_str() );
+      }
+
+      DIR* openTestDir()
+      {
+         DIR* dirHandle = opendir(dirPath.c_str() );
+         EXPECT_NE(dirHandle, nullptr);
+         return dirHandle;
+      }
+};
+
+TEST_F(TestDirListCursorCache, takeReturnsStoredCursor)
+{
+   DirListCursorCache cache(4);
+
+   DIR* dirHandle = openTestDir();
+   cache.put(dirPath, 42, false, dirHandle, 0);
+
+   ASSERT_EQ(cache.getSize(), 1u);
+
+   // wrong offset or offset type must not return the cursor
+   ASSERT_EQ(cache.take(dirPath, 43, false), nullptr);
+   ASSERT_EQ(cache.take(dirPath, 42, true), nullptr);
+
+   ASSERT_EQ(cache.take(dirPath, 42, false), dirHandle);
+   ASSERT_EQ(cache.getSize(), 0u);
+
+   // a cursor can only be taken once
+   ASSERT_EQ(cache.take(dirPath, 42, false), nullptr);
+
+   closedir(dirHandle);
+}
+
+TEST_F(TestDirListCursorCache, leastRecentlyStoredCursorIsEvicted)
+{
+   DirListCursorCache cache(2);
+
+   cache.put(dirPath, 1, false, openTestDir(), 0);
+   cache.put(dirPath, 2, false, openTestDir(), 0);
+   cache.put(dirPath, 3, false, openTestDir(), 0);
+
+   ASSERT_EQ(cache.getSize(), 2u);
+   ASSERT_EQ(cache.take(dirPath, 1, false), nullptr);
+
+   DIR* dirHandle = cache.take(dirPath, 2, false);
+   ASSERT_NE(dirHandle, nullptr);
+   closedir(dirHandle);
+}
+
+TEST_F(TestDirListCursorCache, invalidateRemovesAllCursorsOfPath)
+{
+   DirListCursorCache cache(8);
+
+   cache.put(dirPath, 1, false, openTestDir(), 0);
+   cache.put(dirPath, 2, true, openTestDir(), 0);
+   cache.put(dirPath + "x", 1, false, openTestDir(), 0);
+
+   cache.invalidate(dirPath);
+
+   ASSERT_EQ(cache.getSize(), 1u);
+   ASSERT_EQ(cache.take(dirPath, 1, false), nullptr);
+   ASSERT_EQ(cache.take(dirPath, 2, true), nullptr);
+}
+
+TEST_F(TestDirListCursorCache, disabledCacheStoresNothing)
+{
+   DirListCursorCache cache(0);
+
+   cache.put(dirPath, 1, false, openTestDir(), 0);
+
+   ASSERT_EQ(cache.getSize(), 0u);
+   ASSERT_EQ(cache.take(dirPath, 1, false), nullptr);
+}
+
+TEST_F(TestDirListCursorCache, idleCursorsAreClosedWithoutPut)
+{
+   DirListCursorCache cache(8, 50);
+
+   cache.put(dirPath, 1, false, openTestDir(), 0);
+   cache.put(dirPath, 2, false, openTestDir(), 0);
+
+   std::this_thread::sleep_for(std::chrono::milliseconds(100) );
+
+   // (no listing stored a cursor in the meantime)
+   cache.sweep();
+   ASSERT_EQ(cache.getSize(), 0u);
+
+   cache.put(dirPath, 1, false, openTestDir(), 0);
+
+   std::this_thread::sleep_for(std::chrono::milliseconds(100) );
+
+   ASSERT_EQ(cache.take(dirPath, 2, false), nullptr);
+   ASSERT_EQ(cache.getSize(), 0u);
+}
+
+TEST_F(TestDirListCursorCache, invalidateDuringListingDropsPut)
+{
+   DirListCursorCache cache(8);
+
+   cache.put(dirPath, 1, false, openTestDir(), cache.getGeneration(dirPath) );
+
+   // listing in progress (take) while the dir is removed (invalidate)
+   const uint64_t generation = cache.getGeneration(dirPath);
+   DIR* dirHandle = cache.take(dirPath, 1, false);
+   ASSERT_NE(dirHandle, nullptr);
+
+   cache.invalidate(dirPath);
+
+   cache.put(dirPath, 2, false, dirHandle, generation);
+   ASSERT_EQ(cache.getSize(), 0u);
+
+   // listings that started after the invalidation can store their cursors again
+   cache.put(dirPath, 2, false, openTestDir(), cache.getGeneration(dirPath) );
+   ASSERT_EQ(cache.getSize(), 1u);
+}
@@ -0,0 +1,196 @@
+#include <session/EntryLockStore.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+/**
+ * Values that all have the same hash, to get long bucket chains.
+ */
+struct CollidingValue
+{
+   unsigned id;
+
+   bool operator==(const CollidingValue& other) const
+   {
+      return id == other.id;
+   }
+};
+
+template<>
+struct ValueLockHash<CollidingValue>
+{
+   uint32_t operator()(const CollidingValue& value) const
+   {
+      return 42;
+   }
+};
+
+TEST(EntryLockStore, sameValueSharesDescriptor)
+{
+   ValueLockStore<std::string, Mutex, 4> store;
+
+   auto& first = store.getLockFor("a");
+   auto& second = store.getLockFor("a"); // (found by the unlocked walk)
+   auto& other = store.getLockFor("b");
+
+   ASSERT_EQ(&first, &second);
+   ASSERT_NE(&first, &other);
+   ASSERT_EQ(store.getStats(0).numLocks, 2u);
+
+   store.putLock(first);
+   ASSERT_EQ(store.getStats(0).numLocks, 2u);
+
+   store.putLock(second);
+   store.putLock(other);
+
+   ValueLockStoreStats stats = store.getStats(0);
+   ASSERT_EQ(stats.numLocks, 0u);
+   ASSERT_EQ(stats.numBufferedLocks, 2u);
+
+   // unused descriptors are reused (by values of the same bucket)
+   auto& reused = store.getLockFor("a");
+   ASSERT_EQ(store.getStats(0).numBufferedLocks, 1u);
+
+   store.putLock(reused);
+}
+
+TEST(EntryLockStore, hashCollisions)
+{
+   ValueLockStore<CollidingValue, Mutex, 4> store;
+   std::vector<ValueLockStore<CollidingValue, Mutex, 4>::ValueLock*> locks;
+
+   for(unsigned i = 0; i < 10; i++)
+      locks.push_back(&store.getLockFor(CollidingValue{i}) );
+
+   // the unlocked walk must skip the other values and find the right one (or fall back)
+   for(unsigned i = 0; i < 10; i++)
+   {
+      auto& lock = store.getLockFor(CollidingValue{i});
+
+      ASSERT_EQ(&lock, locks[i]) << "value " << i;
+      store.putLock(lock);
+   }
+
+   ASSERT_EQ(store.getStats(0).numLocks, 10u);
+
+   for(unsigned i = 0; i < 10; i++)
+      store.putLock(*locks[i]);
+
+   ASSERT_EQ(store.getStats(0).numLocks, 0u);
+}
+
+TEST(EntryLockStore, growKeepsDescriptors)
+{
+   ValueLockStore<std::string, Mutex, 4> store;
+   std::vector<ValueLockStore<std::string, Mutex, 4>::ValueLock*> locks;
+
+   for(unsigned i = 0; i < 1000; i++)
+      locks.push_back(&store.getLockFor(std::to_string(i) ) );
+
+   ValueLockStoreStats stats = store.getStats(0);
+
+   ASSERT_GE(stats.numResizes, 7u);
+   ASSERT_GE(stats.numBuckets * VALUELOCKSTORE_MAX_LOAD, 1000u);
+   ASSERT_EQ(stats.numLocks, 1000u);
+
+   for(unsigned i = 0; i < 1000; i++)
+   {
+      auto& lock = store.getLockFor(std::to_string(i) );
+
+      ASSERT_EQ(&lock, locks[i]) << "value " << i;
+      store.putLock(lock);
+   }
+
+   for(unsigned i = 0; i < 1000; i++)
+      store.putLock(*locks[i]);
+
+   ASSERT_EQ(store.getStats(0).numLocks, 0u);
+}
+
+TEST(EntryLockStore, bufferIsBounded)
+{
+   const unsigned bufferSize = 4;
+   ValueLockStore<std::string, Mutex, 1, bufferSize> store;
+   std::vector<ValueLockStore<std::string, Mutex, 1, bufferSize>::ValueLock*> locks;
+
+   for(unsigned i = 0; i < 1000; i++)
+      locks.push_back(&store.getLockFor(std::to_string(i) ) );
+
+   for(unsigned i = 0; i < 1000; i++)
+      store.putLock(*locks[i]);
+
+   ValueLockStoreStats stats = store.getStats(0);
+
+   ASSERT_EQ(stats.numLocks, 0u);
+   ASSERT_GT(stats.numBufferedLocks, 0u);
+   ASSERT_LE(stats.numBufferedLocks, stats.numBuckets * bufferSize);
+}
+
+TEST(EntryLockStore, concurrentLookupsAndGrow)
+{
+   const unsigned numValues = 16;
+   const unsigned numThreads = 8;
+   const unsigned numIterations = 20000;
+
+   ValueLockStore<std::string, Mutex, 4, 2> store;
+   std::vector<std::atomic<bool>> inUse(numValues);
+   std::atomic<bool> exclusionViolated(false);
+   std::atomic<bool> growerDone(false);
+
+   for(auto& flag : inUse)
+      flag = false;
+
+   // forces resizes and frees descriptors while the others walk the chains
+   std::thread grower([&] () {
+      for(unsigned round = 0; round < 5; round++)
+      {
+         std::vector<ValueLockStore<std::string, Mutex, 4, 2>::ValueLock*> locks;
+
+         for(unsigned i = 0; i < 2000; i++)
+            locks.push_back(&store.getLockFor("grow-" + std::to_string(round) + "-" +
+               std::to_string(i) ) );
+
+         for(auto lock : locks)
+            store.putLock(*lock);
+      }
+
+      growerDone = true;
+   });
+
+   std::vector<std::thread> threads;
+
+   for(unsigned thread = 0; thread < numThreads; thread++)
+   {
+      threads.emplace_back([&, thread] () {
+         for(unsigned i = 0; (i < numIterations) || !growerDone; i++)
+         {
+            const unsigned value = (i * 7 + thread) % numValues;
+            auto& lock = store.getLockFor(std::to_string(value) );
+
+            // two descriptors for the same value would allow two owners at once
+            lock.getLock().lock();
+
+            if(inUse[value].exchange(true) )
+               exclusionViolated = true;
+
+            inUse[value] = false;
+
+            lock.getLock().unlock();
+            store.putLock(lock);
+         }
+      });
+   }
+
+   grower.join();
+
+   for(auto& thread : threads)
+      thread.join();
+
+   ValueLockStoreStats stats = store.getStats(0);
+
+   ASSERT_FALSE(exclusionViolated);
+   ASSERT_EQ(stats.numLocks, 0u);
+   ASSERT_GT(stats.numResizes, 0u);
+}
@@ -0,0 +1,121 @@
+#include <common/storage/FileEvent.h>
+#include <components/FileEventFilter.h>
+
+#include <gtest/gtest.h>
+
+class TestFileEventFilter : public ::testing::Test
+{
+   protected:
+      EventFilter filter;
+
+      void SetUp() override
+      {
+         filter.active = true;
+      }
+
+      static uint64_t typeBit(FileEventType type)
+      {
+         return 1ull << unsigned(type);
+      }
+
+      /**
+       * @return the event serialized like FileEventLogItem::serialize() does it.
+       */
+      static std::vector<char> makeEvent(FileEventType type, const std::string& entryId,
+         const std::string& parentId, const std::string& path,
+         const std::string& targetPath = "", const std::string& targetParentId = "",
+         uint16_t formatVersion = 2)
+      {
+         std::vector<char> buf(64 * 1024);
+
+         Serializer ser(&buf[0], buf.size() );
+         ser
+            % formatVersion
+            % uint32_t(0) // eventFlags
+            % uint64_t(1) // numHardlinks
+            % type
+            % entryId
+            % parentId
+            % path
+            % targetPath
+            % targetParentId
+            % unsigned(0) // msgUserId
+            % int64_t(0); // timestamp
+
+         EXPECT_TRUE(ser.good() );
+         buf.resize(ser.size() );
+
+         return buf;
+      }
+
+      bool matches(const std::vector<char>& event) const
+      {
+         return filter.matches(event.data(), event.size() );
+      }
+};
+
+TEST_F(TestFileEventFilter, inactiveFilterPassesAll)
+{
+   filter.active = false;
+
+   ASSERT_TRUE(matches(makeEvent(FileEventType::CREATE, "1-A-1", "root", "/a") ) );
+}
+
+TEST_F(TestFileEventFilter, typeMask)
+{
+   filter.typeMask = typeBit(FileEventType::CREATE) | typeBit(FileEventType::UNLINK);
+
+   ASSERT_TRUE(matches(makeEvent(FileEventType::CREATE, "1-A-1", "root", "/a") ) );
+   ASSERT_TRUE(matches(makeEvent(FileEventType::UNLINK, "1-A-1", "root", "/a") ) );
+   ASSERT_FALSE(matches(makeEvent(FileEventType::FLUSH, "1-A-1", "root", "/a") ) );
+   ASSERT_FALSE(matches(makeEvent(FileEventType::OPEN_READ, "1-A-1", "root", "/a") ) );
+}
+
+TEST_F(TestFileEventFilter, pathPrefixes)
+{
+   filter.typeMask = ~0ull;
+   filter.pathPrefixes = {"/projects/", "/scratch"};
+
+   ASSERT_TRUE(matches(makeEvent(FileEventType::CREATE, "1-A-1", "root", "/projects/x") ) );
+   ASSERT_TRUE(matches(makeEvent(FileEventType::CREATE, "1-A-1", "root", "/scratch2/y") ) );
+   ASSERT_FALSE(matches(makeEvent(FileEventType::CREATE, "1-A-1", "root", "/projects") ) );
+   ASSERT_FALSE(matches(makeEvent(FileEventType::CREATE, "1-A-1", "root", "/home/projects/x") ) );
+
+   // a rename into a matching directory passes because of its target path
+   ASSERT_TRUE(matches(makeEvent(FileEventType::RENAME, "1-A-1", "root", "/home/x",
+      "/projects/x", "2-B-1") ) );
+}
+
+TEST_F(TestFileEventFilter, entryIdPrefixes)
+{
+   filter.typeMask = ~0ull;
+   filter.entryIdPrefixes = {"5-"};
+
+   ASSERT_TRUE(matches(makeEvent(FileEventType::CREATE, "5-A-1", "root", "/a") ) );
+   ASSERT_TRUE(matches(makeEvent(FileEventType::CREATE, "1-A-1", "5-B-1", "/a") ) );
+   ASSERT_TRUE(matches(makeEvent(FileEventType::RENAME, "1-A-1", "2-B-1", "/a", "/b",
+      "5-C-1") ) );
+   ASSERT_FALSE(matches(makeEvent(FileEventType::CREATE, "1-A-1", "2-B-1", "/a") ) );
+}
+
+TEST_F(TestFileEventFilter, typeMaskAppliesBeforePrefixes)
+{
+   filter.typeMask = typeBit(FileEventType::MKDIR);
+   filter.pathPrefixes = {"/a"};
+
+   ASSERT_TRUE(matches(makeEvent(FileEventType::MKDIR, "1-A-1", "root", "/a/b") ) );
+   ASSERT_FALSE(matches(makeEvent(FileEventType::CREATE, "1-A-1", "root", "/a/b") ) );
+   ASSERT_FALSE(matches(makeEvent(FileEventType::MKDIR, "1-A-1", "root", "/b") ) );
+}
+
+TEST_F(TestFileEventFilter, unparsableEventsPass)
+{
+   filter.typeMask = 0;
+
+   // unknown format version
+   ASSERT_TRUE(matches(makeEvent(FileEventType::CREATE, "1-A-1", "root", "/a", "", "", 3) ) );
+
+   // truncated event
+   const std::vector<char> event = makeEvent(FileEventType::CREATE, "1-A-1", "root", "/a");
+   ASSERT_TRUE(filter.matches(event.data(), 4) );
+}
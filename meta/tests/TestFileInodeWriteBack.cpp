@@ -0,0 +1,97 @@
+#include <common/storage/striping/Raid0Pattern.h>
+#include <storage/DirtyInodeStore.h>
+#include <storage/FileInode.h>
+
+#include <gtest/gtest.h>
+
+#include <memory>
+
+class TestFileInodeWriteBack : public ::testing::Test
+{
+   protected:
+      /**
+       * An inode as it is loaded from disk, i.e. without deferred updates in memory.
+       */
+      static std::unique_ptr<FileInode> loadInode(const std::string& entryID, bool isDirty)
+      {
+         Raid0Pattern pattern(512 * 1024, UInt16Vector({1, 2, 3, 4}) );
+         StatData statData(S_IFREG | 0644, 0, 0, pattern.getStripeTargetIDs()->size() );
+         const unsigned featureFlags = FILEINODE_FEATURE_HAS_VERSIONS |
+            (isDirty ? FILEINODE_FEATURE_DYNATTRIBS_DIRTY : 0);
+
+         FileInodeStoreData inodeDiskData(entryID, &statData, &pattern, featureFlags, 0, "",
+            FileInodeOrigFeature_FALSE);
+
+         return std::unique_ptr<FileInode>(
+            new FileInode(entryID, &inodeDiskData, DirEntryType_REGULARFILE, 0) );
+      }
+
+      static EntryInfo entryInfoFor(const std::string& entryID)
+      {
+         return EntryInfo(NumNodeID(1), "root", entryID, "file-" + entryID,
+            DirEntryType_REGULARFILE, 0);
+      }
+};
+
+TEST_F(TestFileInodeWriteBack, statOfDirtyInode)
+{
+   StatData statData;
+
+   std::unique_ptr<FileInode> cleanInode = loadInode("clean", false);
+   ASSERT_EQ(cleanInode->getStatData(statData), FhgfsOpsErr_SUCCESS);
+
+   // stored attribs of a deferred close that is not in memory anymore must not be trusted
+   std::unique_ptr<FileInode> dirtyInode = loadInode("dirty", true);
+   ASSERT_EQ(dirtyInode->getStatData(statData), FhgfsOpsErr_DYNAMICATTRIBSOUTDATED);
+
+   // (as for any file that is open for writing)
+   cleanInode->incNumSessions(OPENFILE_ACCESS_WRITE);
+   ASSERT_EQ(cleanInode->getStatData(statData), FhgfsOpsErr_DYNAMICATTRIBSOUTDATED);
+}
+
+TEST_F(TestFileInodeWriteBack, flushOfUnloadedUpdateNeedsRefresh)
+{
+   std::unique_ptr<FileInode> cleanInode = loadInode("clean", false);
+   EntryInfo cleanInfo = entryInfoFor("clean");
+
+   ASSERT_EQ(cleanInode->flushDynAttribs(&cleanInfo, false), FhgfsOpsErr_SUCCESS);
+
+   // the deferred update was lost when the inode was unloaded => refresh from storage first
+   std::unique_ptr<FileInode> dirtyInode = loadInode("dirty", true);
+   EntryInfo dirtyInfo = entryInfoFor("dirty");
+
+   ASSERT_EQ(dirtyInode->flushDynAttribs(&dirtyInfo, false),
+      FhgfsOpsErr_DYNAMICATTRIBSOUTDATED);
+
+   StatData statData;
+   ASSERT_EQ(dirtyInode->getStatData(statData), FhgfsOpsErr_DYNAMICATTRIBSOUTDATED); // still dirty
+}
+
+TEST_F(TestFileInodeWriteBack, dirtyInodeStore)
+{
+   DirtyInodeStore store;
+   EntryInfo first = entryInfoFor("first");
+   EntryInfo second = entryInfoFor("second");
+
+   store.add(&first);
+   store.add(&second);
+
+   // a second deferred close only refreshes the entry info
+   EntryInfo moved = entryInfoFor("first");
+   moved.setParentEntryID("otherParent");
+   store.add(&moved);
+
+   ASSERT_EQ(store.getSize(), 2u);
+   ASSERT_TRUE(store.takeOlderThan(3600 * 1000).empty() );
+   ASSERT_EQ(store.getSize(), 2u);
+
+   EntryInfoList expired = store.takeOlderThan(0);
+   ASSERT_EQ(expired.size(), 2u);
+   ASSERT_EQ(expired.front().getEntryID(), "first");
+   ASSERT_EQ(expired.front().getParentEntryID(), "otherParent");
+   ASSERT_EQ(store.getSize(), 0u);
+
+   store.add(&first);
+   ASSERT_EQ(store.takeAll().size(), 1u);
+   ASSERT_TRUE(store.takeAll().empty() );
+}
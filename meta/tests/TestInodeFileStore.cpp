@@ -0,0 +1,267 @@
+#include <common/storage/striping/Raid0Pattern.h>
+#include <common/threading/RWLockGuard.h>
+#include <storage/InodeFileStore.h>
+
+#include <gtest/gtest.h>
+
+#include <future>
+#include <set>
+#include <thread>
+
+class TestInodeFileStore : public ::testing::Test
+{
+   protected:
+      /**
+       * Insert an unreferenced inode like loadAndInsertFileInodeUnlocked() does, just without
+       * loading it from disk.
+       */
+      static void insertInode(InodeFileStore& store, const std::string& entryID)
+      {
+         Raid0Pattern pattern(512 * 1024, UInt16Vector({1, 2}) );
+         StatData statData(S_IFREG | 0644, 0, 0, pattern.getStripeTargetIDs()->size() );
+
+         FileInodeStoreData inodeDiskData(entryID, &statData, &pattern,
+            FILEINODE_FEATURE_HAS_VERSIONS, 0, "", FileInodeOrigFeature_FALSE);
+
+         FileInode* inode = new FileInode(entryID, &inodeDiskData, DirEntryType_REGULARFILE, 0);
+
+         ASSERT_TRUE(store.insertReferencer(entryID, new FileInodeReferencer(inode) ) );
+      }
+
+      static FileInodeReferencer* takeReferencer(InodeFileStore& store,
+         const std::string& entryID)
+      {
+         return store.getReferencerAndDeleteFromMap(entryID);
+      }
+
+      static bool insertReferencer(InodeFileStore& store, const std::string& entryID,
+         FileInodeReferencer* fileRefer)
+      {
+         return store.insertReferencer(entryID, fileRefer);
+      }
+
+      static unsigned getNumShards(const InodeFileStore& store)
+      {
+         return store.numShards;
+      }
+
+      static unsigned getShardIndex(InodeFileStore& store, const std::string& entryID)
+      {
+         return &store.getShard(entryID) - &store.shards[0];
+      }
+
+      static bool isInShard(InodeFileStore& store, unsigned shardIndex,
+         const std::string& entryID)
+      {
+         return store.shards[shardIndex].inodes.count(entryID) != 0;
+      }
+
+      static RWLock& getShardLock(InodeFileStore& store, unsigned shardIndex)
+      {
+         return store.shards[shardIndex].rwlock;
+      }
+
+      static unsigned getRefCount(InodeFileStore& store, const std::string& entryID)
+      {
+         InodeFileStore::Shard& shard = store.getShard(entryID);
+
+         return shard.inodes.at(entryID)->getRefCount();
+      }
+
+      static EntryInfo entryInfoFor(const std::string& entryID)
+      {
+         return EntryInfo(NumNodeID(1), "root", entryID, "file-" + entryID,
+            DirEntryType_REGULARFILE, 0);
+      }
+};
+
+TEST_F(TestInodeFileStore, shardSelection)
+{
+   InodeFileStore store(8);
+   InodeFileStore singleShardStore;
+   std::set<unsigned> usedShards;
+
+   ASSERT_EQ(getNumShards(store), 8u);
+   ASSERT_EQ(getNumShards(singleShardStore), 1u);
+   ASSERT_EQ(getNumShards(InodeFileStore(0) ), 1u); // (0 shards would be unusable)
+
+   for(unsigned i = 0; i < 64; i++)
+   {
+      const std::string entryID = "0-5F3A1B2C-" + std::to_string(i);
+      const unsigned shardIndex = getShardIndex(store, entryID);
+
+      insertInode(store, entryID);
+
+      // the same ID always maps to the same shard, which contains the inode
+      ASSERT_EQ(getShardIndex(store, entryID), shardIndex);
+      ASSERT_LT(shardIndex, 8u);
+      ASSERT_TRUE(isInShard(store, shardIndex, entryID) );
+      ASSERT_TRUE(store.isInStore(entryID) );
+
+      usedShards.insert(shardIndex);
+   }
+
+   ASSERT_EQ(store.getSize(), 64u);
+   ASSERT_GT(usedShards.size(), 1u); // (the IDs are spread over the shards)
+
+   ASSERT_FALSE(store.isInStore("0-5F3A1B2C-64") );
+}
+
+TEST_F(TestInodeFileStore, referenceAndRelease)
+{
+   InodeFileStore store(8);
+
+   insertInode(store, "file1");
+   insertInode(store, "file2");
+
+   EntryInfo entryInfo = entryInfoFor("file1");
+
+   FileInode* inode = store.referenceLoadedFile("file1");
+   ASSERT_NE(inode, nullptr);
+   ASSERT_EQ(inode->getEntryID(), "file1");
+   ASSERT_EQ(getRefCount(store, "file1"), 1u);
+   ASSERT_EQ(store.isUnlinkable(&entryInfo), FhgfsOpsErr_INUSE);
+
+   ASSERT_EQ(store.referenceLoadedFile("file1"), inode);
+   ASSERT_EQ(getRefCount(store, "file1"), 2u);
+   ASSERT_EQ(getRefCount(store, "file2"), 0u); // (other inodes are not affected)
+
+   ASSERT_TRUE(store.releaseFileInode(inode) );
+   ASSERT_TRUE(store.isInStore("file1") );
+
+   // dropping the last reference unloads the inode
+   ASSERT_TRUE(store.releaseFileInode(inode) );
+   ASSERT_FALSE(store.isInStore("file1") );
+   ASSERT_TRUE(store.isInStore("file2") );
+   ASSERT_EQ(store.getSize(), 1u);
+
+   ASSERT_EQ(store.referenceLoadedFile("file1"), nullptr);
+   ASSERT_EQ(store.isUnlinkable(&entryInfo), FhgfsOpsErr_SUCCESS);
+}
+
+TEST_F(TestInodeFileStore, moveBetweenStores)
+{
+   // (like MetaStore::moveReferenceToMetaFileStoreUnlocked() from a directory to the global store)
+   InodeFileStore dirStore;
+   InodeFileStore globalStore(64);
+
+   insertInode(dirStore, "moved");
+
+   FileInode* inode = dirStore.referenceLoadedFile("moved");
+   ASSERT_NE(inode, nullptr);
+
+   FileInodeReferencer* inodeRefer = takeReferencer(dirStore, "moved");
+   ASSERT_NE(inodeRefer, nullptr);
+   ASSERT_FALSE(dirStore.isInStore("moved") );
+   ASSERT_EQ(takeReferencer(dirStore, "moved"), nullptr);
+
+   ASSERT_TRUE(insertReferencer(globalStore, "moved", inodeRefer) );
+   ASSERT_TRUE(isInShard(globalStore, getShardIndex(globalStore, "moved"), "moved") );
+
+   // the reference from the old store is kept and can be released in the new one
+   ASSERT_EQ(globalStore.referenceLoadedFile("moved"), inode);
+   ASSERT_EQ(getRefCount(globalStore, "moved"), 2u);
+
+   // a second referencer for the same ID is rejected
+   FileInodeReferencer duplicateRefer(inode, false);
+   ASSERT_FALSE(insertReferencer(globalStore, "moved", &duplicateRefer) );
+
+   ASSERT_TRUE(globalStore.releaseFileInode(inode) );
+   ASSERT_TRUE(globalStore.releaseFileInode(inode) );
+   ASSERT_FALSE(globalStore.isInStore("moved") );
+}
+
+TEST_F(TestInodeFileStore, differentShardsDontBlockEachOther)
+{
+   InodeFileStore store(8);
+   const std::string blockedID = "blocked";
+   std::string otherID;
+
+   insertInode(store, blockedID);
+
+   for(unsigned i = 0; otherID.empty(); i++)
+   {
+      const std::string entryID = "other" + std::to_string(i);
+
+      if(getShardIndex(store, entryID) != getShardIndex(store, blockedID) )
+         otherID = entryID;
+   }
+
+   insertInode(store, otherID);
+
+   std::future<FileInode*> blockedRes;
+
+   {
+      // (e.g. a slow load from disk of another inode in the same shard)
+      RWLockGuard shardLock(getShardLock(store, getShardIndex(store, blockedID) ),
+         SafeRWLock_WRITE);
+
+      auto otherRes = std::async(std::launch::async,
+         [&] () { return store.referenceLoadedFile(otherID); });
+
+      ASSERT_EQ(otherRes.wait_for(std::chrono::seconds(10) ), std::future_status::ready);
+
+      FileInode* otherInode = otherRes.get();
+      ASSERT_NE(otherInode, nullptr);
+      ASSERT_TRUE(store.releaseFileInode(otherInode) );
+
+      // while the same shard is still blocked
+      blockedRes = std::async(std::launch::async,
+         [&] () { return store.referenceLoadedFile(blockedID); });
+
+      ASSERT_EQ(blockedRes.wait_for(std::chrono::milliseconds(50) ),
+         std::future_status::timeout);
+   }
+
+   FileInode* blockedInode = blockedRes.get();
+   ASSERT_NE(blockedInode, nullptr);
+   ASSERT_TRUE(store.releaseFileInode(blockedInode) );
+}
+
+TEST_F(TestInodeFileStore, concurrentReferences)
+{
+   const unsigned numInodes = 4;
+   const unsigned numThreads = 8;
+   const unsigned numRounds = 2000;
+
+   InodeFileStore store(8);
+   std::vector<FileInode*> baseRefs;
+
+   // (the base references keep the inodes loaded, they are shared by two threads each)
+   for(unsigned i = 0; i < numInodes; i++)
+   {
+      insertInode(store, "shared" + std::to_string(i) );
+      baseRefs.push_back(store.referenceLoadedFile("shared" + std::to_string(i) ) );
+   }
+
+   std::vector<std::thread> threads;
+   std::atomic<unsigned> numFailed(0);
+
+   for(unsigned t = 0; t < numThreads; t++)
+   {
+      threads.emplace_back([&, t] () {
+         const std::string entryID = "shared" + std::to_string(t % numInodes);
+
+         for(unsigned round = 0; round < numRounds; round++)
+         {
+            FileInode* inode = store.referenceLoadedFile(entryID);
+
+            if(!inode || !store.releaseFileInode(inode) )
+               numFailed++;
+         }
+      });
+   }
+
+   for(std::thread& thread : threads)
+      thread.join();
+
+   ASSERT_EQ(numFailed, 0u);
+
+   for(unsigned i = 0; i < numInodes; i++)
+   {
+      ASSERT_EQ(getRefCount(store, "shared" + std::to_string(i) ), 1u);
+      ASSERT_TRUE(store.releaseFileInode(baseRefs[i]) );
+   }
+
+   ASSERT_EQ(store.getSize(), 0u);
+}
@@ -0,0 +1,218 @@
+#include <components/MirrorForwardPipeline.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+class TestMirrorForwardPipeline : public ::testing::Test
+{
+   protected:
+      typedef MirrorForwardPipeline::Request Request;
+
+      static constexpr unsigned numConns = 2;
+      static constexpr unsigned maxInFlight = 4;
+
+      MirrorForwardPipeline pipeline{numConns, maxInFlight};
+
+      static Request makeRequest(const std::vector<uint32_t>& lockHashes)
+      {
+         return Request{NULL, &lockHashes, 0, 0, false, false, false, 0, FhgfsOpsErr_INTERNAL};
+      }
+
+      void enqueue(Request& request)
+      {
+         std::lock_guard<Mutex> lock(pipeline.mutex);
+         pipeline.enqueueUnlocked(request);
+      }
+
+      void requeue(Request& request)
+      {
+         std::lock_guard<Mutex> lock(pipeline.mutex);
+
+         auto& conn = *pipeline.conns[request.connIndex];
+
+         ASSERT_EQ(conn.inFlight.front(), &request);
+         conn.inFlight.pop_front();
+         conn.doneSeqNo = request.seqNo;
+
+         pipeline.requeueUnlocked(conn, request);
+      }
+
+      void failConn(unsigned connIndex)
+      {
+         std::lock_guard<Mutex> lock(pipeline.mutex);
+         pipeline.failRequestsUnlocked(*pipeline.conns[connIndex], FhgfsOpsErr_COMMUNICATION);
+      }
+
+      size_t getNumInFlight(unsigned connIndex)
+      {
+         std::lock_guard<Mutex> lock(pipeline.mutex);
+         return pipeline.conns[connIndex]->inFlight.size();
+      }
+
+      /**
+       * @return true if the slot of the hash belongs to the request (i.e. it is the last one that
+       *    held a lock with this hash).
+       */
+      bool isSlotOwner(const Request& request, uint32_t hash)
+      {
+         std::lock_guard<Mutex> lock(pipeline.mutex);
+
+         const auto& slot = pipeline.slots[hash % MIRRORFORWARDPIPELINE_NUM_SLOTS];
+
+         return (slot.connIndex == request.connIndex) && (slot.seqNo == request.seqNo);
+      }
+};
+
+TEST_F(TestMirrorForwardPipeline, independentRequestsAreSpread)
+{
+   const std::vector<uint32_t> firstHashes = {1};
+   const std::vector<uint32_t> secondHashes = {2};
+   const std::vector<uint32_t> thirdHashes = {3};
+
+   Request first = makeRequest(firstHashes);
+   Request second = makeRequest(secondHashes);
+   Request third = makeRequest(thirdHashes);
+
+   enqueue(first);
+   enqueue(second);
+
+   ASSERT_NE(first.connIndex, second.connIndex);
+   ASSERT_EQ(getNumInFlight(0), 1u);
+   ASSERT_EQ(getNumInFlight(1), 1u);
+
+   failConn(second.connIndex);
+
+   // the conn without requests in flight is the least loaded one
+   enqueue(third);
+   ASSERT_EQ(third.connIndex, second.connIndex);
+   ASSERT_FALSE(first.hasDependents);
+}
+
+TEST_F(TestMirrorForwardPipeline, dependentRequestsShareConn)
+{
+   const std::vector<uint32_t> firstHashes = {1, 5};
+   const std::vector<uint32_t> otherHashes = {2};
+   const std::vector<uint32_t> dependentHashes = {5, 7};
+
+   Request first = makeRequest(firstHashes);
+   Request other = makeRequest(otherHashes);
+   Request dependent = makeRequest(dependentHashes);
+
+   enqueue(first);
+   enqueue(other);
+   enqueue(dependent);
+
+   // (the least loaded conn would be the one of other, because first has a lower index)
+   ASSERT_EQ(dependent.connIndex, first.connIndex);
+   ASSERT_EQ(dependent.seqNo, first.seqNo + 1);
+   ASSERT_TRUE(first.hasDependents);
+   ASSERT_FALSE(other.hasDependents);
+
+   ASSERT_TRUE(isSlotOwner(first, 1) );
+   ASSERT_TRUE(isSlotOwner(dependent, 5) );
+   ASSERT_TRUE(isSlotOwner(dependent, 7) );
+}
+
+TEST_F(TestMirrorForwardPipeline, waitForDependenciesOnMultipleConns)
+{
+   const std::vector<uint32_t> firstHashes = {1};
+   const std::vector<uint32_t> secondHashes = {2};
+   const std::vector<uint32_t> bothHashes = {1, 2};
+
+   Request first = makeRequest(firstHashes);
+   Request second = makeRequest(secondHashes);
+   Request both = makeRequest(bothHashes);
+
+   enqueue(first);
+   enqueue(second);
+   ASSERT_NE(first.connIndex, second.connIndex);
+
+   std::atomic<bool> enqueued(false);
+
+   std::thread enqueuer([&] () {
+      enqueue(both);
+      enqueued = true;
+   });
+
+   std::this_thread::sleep_for(std::chrono::milliseconds(100) );
+   EXPECT_FALSE(enqueued);
+
+   // only the request on the conn of second is left in flight => both must follow it
+   failConn(first.connIndex);
+
+   enqueuer.join();
+
+   ASSERT_TRUE(enqueued);
+   ASSERT_EQ(both.connIndex, second.connIndex);
+   ASSERT_TRUE(second.hasDependents);
+}
+
+TEST_F(TestMirrorForwardPipeline, fullConnBlocksDependentRequest)
+{
+   std::vector<std::vector<uint32_t>> hashes(maxInFlight, std::vector<uint32_t>{1});
+   std::vector<Request> requests;
+
+   for(unsigned i = 0; i < maxInFlight; i++)
+      requests.push_back(makeRequest(hashes[i]) );
+
+   for(Request& request : requests)
+      enqueue(request);
+
+   const unsigned connIndex = requests[0].connIndex;
+
+   ASSERT_EQ(getNumInFlight(connIndex), maxInFlight);
+
+   const std::vector<uint32_t> dependentHashes = {1};
+   Request dependent = makeRequest(dependentHashes);
+   std::atomic<bool> enqueued(false);
+
+   std::thread enqueuer([&] () {
+      enqueue(dependent);
+      enqueued = true;
+   });
+
+   std::this_thread::sleep_for(std::chrono::milliseconds(100) );
+   EXPECT_FALSE(enqueued); // (must not use the idle conn)
+
+   failConn(connIndex);
+
+   enqueuer.join();
+
+   // the failed requests are done => no dependencies anymore
+   ASSERT_TRUE(enqueued);
+   ASSERT_EQ(getNumInFlight(0) + getNumInFlight(1), 1u);
+}
+
+TEST_F(TestMirrorForwardPipeline, requeuedRequestKeepsItsSlots)
+{
+   const std::vector<uint32_t> retryHashes = {1};
+   const std::vector<uint32_t> otherHashes = {2};
+   const std::vector<uint32_t> laterHashes = {1};
+
+   Request retry = makeRequest(retryHashes);
+   Request other = makeRequest(otherHashes);
+
+   enqueue(retry);
+   enqueue(other);
+
+   const uint64_t oldSeqNo = retry.seqNo;
+
+   requeue(retry);
+
+   ASSERT_TRUE(retry.needsResend);
+   ASSERT_EQ(retry.numRetries, 1u);
+   ASSERT_GT(retry.seqNo, oldSeqNo);
+   ASSERT_TRUE(isSlotOwner(retry, 1) );
+
+   // a later request on the same entry must follow the resent request
+   Request later = makeRequest(laterHashes);
+
+   enqueue(later);
+
+   ASSERT_EQ(later.connIndex, retry.connIndex);
+   ASSERT_EQ(later.seqNo, retry.seqNo + 1);
+   ASSERT_TRUE(retry.hasDependents);
+}
@@ -0,0 +1,222 @@
+#include <pmq/pmq.hpp>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <stdlib.h>
+
+class TestPMQ : public ::testing::Test
+{
+   protected:
+      std::string dirPath;
+
+      void SetUp() override
+      {
+         char dirTemplate[] = "/tmp/beegfs-test-pmq.XXXXXX";
+
+         ASSERT_NE(mkdtemp(dirTemplate), nullptr);
+         dirPath = dirTemplate;
+      }
+
+      void TearDown() override
+      {
+         const std::string rmCmd = "rm -rf " + dirPath;
+         ASSERT_EQ(system(rmCmd.c_str() ), 0);
+      }
+
+      /**
+       * Message contents are derived from producer and sequence number, so that a reader can
+       * detect messages that were mixed up or torn by concurrent enqueuers. Sizes vary from less
+       * than one slot to several slots.
+       */
+      static std::vector<char> makeMessage(uint32_t producer, uint32_t seq)
+      {
+         const size_t size = 2 * sizeof(uint32_t) + ( (producer * 7919 + seq * 104729) % 400);
+         std::vector<char> msg(size);
+
+         memcpy(&msg[0], &producer, sizeof(producer) );
+         memcpy(&msg[sizeof(producer)], &seq, sizeof(seq) );
+
+         for(size_t i = 2 * sizeof(uint32_t); i < size; i++)
+            msg[i] = (char)(producer + seq + i);
+
+         return msg;
+      }
+};
+
+TEST_F(TestPMQ, concurrentEnqueuers)
+{
+   const uint32_t numProducers = 8;
+   const uint32_t numMessagesPerProducer = 50000;
+
+   const std::string queuePath = dirPath + "/queue"; // (created by pmq_create)
+
+   PMQ_Init_Params params = {};
+   params.basedir_path = queuePath.c_str();
+   params.create_size = 128 << 20;
+
+   PMQ_Handle pmq(pmq_create(&params) );
+   ASSERT_TRUE(pmq);
+
+   PMQ_Reader_Handle reader(pmq_reader_create(pmq) );
+   ASSERT_TRUE(reader);
+   ASSERT_EQ(pmq_reader_seek_to_current(reader), PMQ_Read_Result_Success);
+
+   const uint64_t startMSN = pmq_reader_get_current_msn(reader);
+
+   std::atomic<bool> enqueueFailed(false);
+   std::vector<std::thread> producers;
+
+   for(uint32_t producer = 0; producer < numProducers; producer++)
+   {
+      producers.emplace_back([&, producer] () {
+         for(uint32_t seq = 0; seq < numMessagesPerProducer; seq++)
+         {
+            const std::vector<char> msg = makeMessage(producer, seq);
+
+            if(!pmq_enqueue_msg(pmq, msg.data(), msg.size() ) )
+               enqueueFailed = true;
+         }
+      });
+   }
+
+   for(auto& thread : producers)
+      thread.join();
+
+   ASSERT_FALSE(enqueueFailed);
+   ASSERT_TRUE(pmq_sync(pmq) );
+
+   // every message must be published exactly once, intact, and in the order of its producer
+   std::vector<uint32_t> nextSeqs(numProducers, 0);
+   std::vector<char> buf(4096);
+
+   for(uint64_t i = 0; i < numProducers * numMessagesPerProducer; i++)
+   {
+      size_t msgSize;
+      PMQ_Read_Result readRes;
+
+      do
+      { // (the reader returns EOF once when it switches from the chunk store to the in-queue)
+         readRes = pmq_read_msg(reader, buf.data(), buf.size(), &msgSize);
+      } while( (readRes == PMQ_Read_Result_EOF) && !pmq_reader_eof(reader) );
+
+      ASSERT_EQ(readRes, PMQ_Read_Result_Success) << "message " << i;
+
+      uint32_t producer;
+      uint32_t seq;
+
+      ASSERT_GE(msgSize, 2 * sizeof(uint32_t) );
+      memcpy(&producer, &buf[0], sizeof(producer) );
+      memcpy(&seq, &buf[sizeof(producer)], sizeof(seq) );
+
+      ASSERT_LT(producer, numProducers);
+      ASSERT_EQ(seq, nextSeqs[producer]) << "producer " << producer;
+
+      const std::vector<char> expected = makeMessage(producer, seq);
+      ASSERT_EQ(std::vector<char>(buf.begin(), buf.begin() + msgSize), expected);
+
+      nextSeqs[producer]++;
+   }
+
+   size_t msgSize;
+
+   ASSERT_TRUE(pmq_reader_eof(reader) );
+   ASSERT_EQ(pmq_read_msg(reader, buf.data(), buf.size(), &msgSize), PMQ_Read_Result_EOF);
+   ASSERT_EQ(pmq_reader_get_current_msn(reader),
+      startMSN + numProducers * numMessagesPerProducer);
+
+   PMQ_Stats stats;
+   pmq_get_stats(pmq, &stats);
+
+   ASSERT_EQ(stats.enqueuer.total_messages_enqueued, numProducers * numMessagesPerProducer);
+}
+
+TEST_F(TestPMQ, readBatches)
+{
+   const uint32_t numMessages = 20000;
+   const size_t maxBatchMsgs = 16;
+
+   const std::string queuePath = dirPath + "/queue"; // (created by pmq_create)
+
+   PMQ_Init_Params params = {};
+   params.basedir_path = queuePath.c_str();
+   params.create_size = 128 << 20;
+
+   PMQ_Handle pmq(pmq_create(&params) );
+   ASSERT_TRUE(pmq);
+
+   PMQ_Reader_Handle reader(pmq_reader_create(pmq) );
+   ASSERT_TRUE(reader);
+   ASSERT_EQ(pmq_reader_seek_to_current(reader), PMQ_Read_Result_Success);
+
+   const uint64_t startMSN = pmq_reader_get_current_msn(reader);
+
+   for(uint32_t seq = 0; seq < numMessages; seq++)
+   {
+      const std::vector<char> msg = makeMessage(0, seq);
+      ASSERT_TRUE(pmq_enqueue_msg(pmq, msg.data(), msg.size() ) );
+   }
+
+   ASSERT_TRUE(pmq_sync(pmq) );
+
+   std::vector<char> buf(1024); // (several messages, but usually less than maxBatchMsgs)
+   size_t msgSizes[maxBatchMsgs];
+   size_t numRead;
+
+   // a message that doesn't fit must not be skipped
+   ASSERT_EQ(pmq_read_msgs(reader, buf.data(), sizeof(uint32_t), msgSizes, maxBatchMsgs,
+      &numRead), PMQ_Read_Result_Buffer_Too_Small);
+   ASSERT_EQ(numRead, 0u);
+   ASSERT_EQ(msgSizes[0], makeMessage(0, 0).size() );
+   ASSERT_EQ(pmq_reader_get_current_msn(reader), startMSN);
+
+   uint32_t nextSeq = 0;
+   bool hadPartialBatch = false;
+
+   while(nextSeq < numMessages)
+   {
+      PMQ_Read_Result readRes;
+
+      do
+      { // (the reader returns EOF once when it switches from the chunk store to the in-queue)
+         readRes = pmq_read_msgs(reader, buf.data(), buf.size(), msgSizes, maxBatchMsgs,
+            &numRead);
+      } while( (readRes == PMQ_Read_Result_EOF) && !pmq_reader_eof(reader) );
+
+      ASSERT_EQ(readRes, PMQ_Read_Result_Success) << "message " << nextSeq;
+      ASSERT_GE(numRead, 1u);
+      ASSERT_LE(numRead, maxBatchMsgs);
+
+      if(numRead < maxBatchMsgs)
+         hadPartialBatch = true;
+
+      // messages are stored back to back
+      size_t offset = 0;
+
+      for(size_t i = 0; i < numRead; i++)
+      {
+         const std::vector<char> expected = makeMessage(0, nextSeq);
+
+         ASSERT_LE(offset + msgSizes[i], buf.size() );
+         ASSERT_EQ(std::vector<char>(buf.begin() + offset, buf.begin() + offset + msgSizes[i]),
+            expected) << "message " << nextSeq;
+
+         offset += msgSizes[i];
+         nextSeq++;
+      }
+
+      ASSERT_EQ(pmq_reader_get_current_msn(reader), startMSN + nextSeq);
+   }
+
+   ASSERT_TRUE(hadPartialBatch); // (batches were limited by the buffer size)
+
+   ASSERT_TRUE(pmq_reader_eof(reader) );
+   ASSERT_EQ(pmq_read_msgs(reader, buf.data(), buf.size(), msgSizes, maxBatchMsgs, &numRead),
+      PMQ_Read_Result_EOF);
+   ASSERT_EQ(numRead, 0u);
+}
@@ -0,0 +1,208 @@
+#include <storage/FileInode.h>
+#include <storage/RangeLockTree.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+
+static RangeLockDetails makeLock(unsigned owner, uint64_t start, uint64_t end,
+   int lockTypeFlags = ENTRYLOCKTYPE_EXCLUSIVE)
+{
+   return RangeLockDetails(NumNodeID(1), owner, "ack-" + std::to_string(owner) + "-" +
+      std::to_string(start) + "-" + std::to_string(lockTypeFlags), lockTypeFlags, start, end);
+}
+
+/**
+ * The locks of the vector that overlap [start, end] in tree order (by start, then owner).
+ */
+static RangeLockDetailsVec bruteForceOverlaps(const RangeLockDetailsVec& locks, uint64_t start,
+   uint64_t end)
+{
+   RangeLockDetailsVec overlaps;
+
+   for(auto iter = locks.begin(); iter != locks.end(); iter++)
+   {
+      if( (iter->start <= end) && (iter->end >= start) )
+         overlaps.push_back(*iter);
+   }
+
+   std::sort(overlaps.begin(), overlaps.end(),
+      [] (const RangeLockDetails& a, const RangeLockDetails& b) {
+         if(a.start != b.start)
+            return a.start < b.start;
+
+         return a.ownerPID < b.ownerPID;
+      });
+
+   return overlaps;
+}
+
+TEST(RangeLockTree, sequentialInsertAndErase)
+{
+   RangeLockTree tree;
+
+   // ascending and descending starts need rotations all the time
+   for(unsigned i = 0; i < 1000; i++)
+   {
+      tree.insert(makeLock(i, i * 10, i * 10 + 5) );
+      tree.insert(makeLock(i, 100000 - i * 10, 100000 - i * 10 + 5) );
+
+      ASSERT_TRUE(tree.checkInvariants() ) << "insert " << i;
+   }
+
+   ASSERT_EQ(tree.size(), 2000u);
+
+   // long lock in the middle of the tree must be found through maxEnd of its ancestors
+   tree.insert(makeLock(5000, 5, 99999) );
+   ASSERT_TRUE(tree.checkInvariants() );
+
+   RangeLockDetailsVec overlaps = tree.getOverlaps(99990, 99990);
+   ASSERT_EQ(overlaps.size(), 2u);
+   ASSERT_EQ(overlaps[0].start, 5u);
+   ASSERT_EQ(overlaps[1].start, 99990u);
+
+   for(unsigned i = 0; i < 1000; i += 2)
+   {
+      ASSERT_TRUE(tree.erase(makeLock(i, i * 10, i * 10 + 5) ) );
+      ASSERT_TRUE(tree.checkInvariants() ) << "erase " << i;
+   }
+
+   ASSERT_TRUE(tree.erase(makeLock(5000, 5, 99999) ) );
+   ASSERT_FALSE(tree.erase(makeLock(5000, 5, 99999) ) );
+   ASSERT_TRUE(tree.checkInvariants() );
+
+   ASSERT_EQ(tree.getOverlaps(99990, 99990).size(), 1u);
+   ASSERT_EQ(tree.size(), 1500u);
+}
+
+TEST(RangeLockTree, randomOverlaps)
+{
+   std::mt19937 rand(1234);
+   RangeLockTree tree;
+   RangeLockDetailsVec locks;
+
+   for(unsigned round = 0; round < 5000; round++)
+   {
+      if(locks.empty() || (rand() % 3) )
+      {
+         const uint64_t start = rand() % 10000;
+         const uint64_t len = (rand() % 10) ? rand() % 100 : rand() % 5000;
+         const RangeLockDetails lock = makeLock(round, start, start + len);
+
+         tree.insert(lock);
+         locks.push_back(lock);
+      }
+      else
+      {
+         const size_t index = rand() % locks.size();
+
+         ASSERT_TRUE(tree.erase(locks[index]) );
+         locks.erase(locks.begin() + index);
+      }
+
+      ASSERT_TRUE(tree.checkInvariants() ) << "round " << round;
+      ASSERT_EQ(tree.size(), locks.size() );
+
+      const uint64_t queryStart = rand() % 12000;
+      const uint64_t queryEnd = queryStart + rand() % 200;
+
+      ASSERT_EQ(tree.getOverlaps(queryStart, queryEnd),
+         bruteForceOverlaps(locks, queryStart, queryEnd) ) << "round " << round;
+   }
+
+   ASSERT_EQ(tree.getAll(), bruteForceOverlaps(locks, 0, ~0ULL) );
+}
+
+TEST(RangeLockTree, findConflictIgnoresOwnLocks)
+{
+   RangeLockTree tree;
+   RangeLockDetails conflictor;
+
+   tree.insert(makeLock(1, 0, 99) );
+   tree.insert(makeLock(2, 200, 299) );
+
+   // up-/downgrade of an own lock
+   ASSERT_FALSE(tree.findConflict(makeLock(1, 50, 150), &conflictor) );
+
+   ASSERT_TRUE(tree.findConflict(makeLock(3, 99, 200), &conflictor) );
+   ASSERT_EQ(conflictor.ownerPID, 1);
+
+   ASSERT_FALSE(tree.findConflict(makeLock(3, 100, 199), NULL) );
+   ASSERT_TRUE(tree.findConflict(makeLock(3, 250, ~0ULL), NULL) );
+}
+
+class TestRangeLockWriterPreference : public ::testing::Test
+{
+   protected:
+      FileInode inode; // (range locks don't need the stripe pattern of a fully initialized inode)
+
+      /**
+       * @return true if granted immediately.
+       */
+      bool lock(unsigned owner, uint64_t start, uint64_t end, int lockTypeFlags)
+      {
+         RangeLockDetails lockDetails = makeLock(owner, start, end, lockTypeFlags);
+
+         return inode.flockRange(lockDetails).first;
+      }
+
+      /**
+       * @return the waiters that were granted after the unlock.
+       */
+      LockRangeNotifyList unlock(unsigned owner, uint64_t start, uint64_t end)
+      {
+         RangeLockDetails lockDetails = makeLock(owner, start, end, ENTRYLOCKTYPE_UNLOCK);
+
+         return inode.flockRange(lockDetails).second;
+      }
+
+      static std::vector<int> ownersOf(const LockRangeNotifyList& granted)
+      {
+         std::vector<int> owners;
+
+         for(auto iter = granted.begin(); iter != granted.end(); iter++)
+            owners.push_back(iter->ownerPID);
+
+         return owners;
+      }
+};
+
+TEST_F(TestRangeLockWriterPreference, readerWaitsForQueuedWriter)
+{
+   ASSERT_TRUE(lock(1, 0, 99, ENTRYLOCKTYPE_SHARED) );
+   ASSERT_FALSE(lock(2, 50, 149, ENTRYLOCKTYPE_EXCLUSIVE) );
+
+   // a new reader must not overtake the queued writer, unless they don't overlap
+   ASSERT_FALSE(lock(3, 100, 120, ENTRYLOCKTYPE_SHARED) );
+   ASSERT_TRUE(lock(4, 0, 9, ENTRYLOCKTYPE_SHARED) );
+   ASSERT_FALSE(lock(5, 120, 130, ENTRYLOCKTYPE_SHARED | ENTRYLOCKTYPE_NOWAIT) ); // not queued
+
+   ASSERT_TRUE(unlock(4, 0, 9).empty() ); // writer still blocked by reader 1
+
+   // writer first, then the reader that waited for it
+   ASSERT_EQ(ownersOf(unlock(1, 0, 99) ), std::vector<int>({2}) );
+   ASSERT_EQ(ownersOf(unlock(2, 50, 149) ), std::vector<int>({3}) );
+}
+
+TEST_F(TestRangeLockWriterPreference, writersAreGrantedInQueueOrder)
+{
+   ASSERT_TRUE(lock(1, 0, 999, ENTRYLOCKTYPE_SHARED) );
+
+   ASSERT_FALSE(lock(2, 0, 99, ENTRYLOCKTYPE_EXCLUSIVE) );
+   ASSERT_FALSE(lock(3, 50, 60, ENTRYLOCKTYPE_EXCLUSIVE) ); // overlaps writer 2
+   ASSERT_FALSE(lock(4, 500, 599, ENTRYLOCKTYPE_EXCLUSIVE) ); // independent of the others
+
+   // writer 3 stays behind writer 2, writer 4 doesn't have to wait for them
+   ASSERT_EQ(ownersOf(unlock(1, 0, 999) ), std::vector<int>({2, 4}) );
+   ASSERT_EQ(ownersOf(unlock(2, 0, 99) ), std::vector<int>({3}) );
+
+   // a writer that overlaps a queued writer is queued behind it, even without granted conflicts
+   ASSERT_TRUE(lock(5, 0, 9, ENTRYLOCKTYPE_SHARED) );
+   ASSERT_FALSE(lock(6, 5, 55, ENTRYLOCKTYPE_EXCLUSIVE) ); // waits for reader 5 and writer 3
+   ASSERT_FALSE(lock(7, 0, 10, ENTRYLOCKTYPE_EXCLUSIVE) ); // waits for reader 5 and writer 6
+   ASSERT_TRUE(unlock(5, 0, 9).empty() );
+
+   ASSERT_EQ(ownersOf(unlock(3, 50, 60) ), std::vector<int>({6}) );
+   ASSERT_EQ(ownersOf(unlock(6, 5, 55) ), std::vector<int>({7}) );
+}
@@ -544,6 +544,8 @@ void App::initPostTargetRegistration()
 
       if (cfg->getTuneUsePerUserMsgQueues())
          workQueueMap[mapping.first]->setIndirectWorkList(new UserWorkContainer());
+      else if (cfg->getTuneUseWorkStealingQueues())
+         workQueueMap[mapping.first]->enableWorkStealing(cfg->getTuneNumWorkers());
    };
 
    if (cfg->getTuneUsePerTargetWorkers())
@@ -570,7 +572,8 @@ void App::initComponents()
 
    unsigned short listenPort = cfg->getConnStoragePort();
 
-   this->connAcceptor = new ConnAcceptor(this, nicList, listenPort);
+   this->connAcceptor = new ConnAcceptor(this, nicList, listenPort,
+      !cfg->getTuneListenerReusePort() );
 
    this->statsCollector = new StorageStatsCollector(STATSCOLLECTOR_COLLECT_INTERVAL_MS,
       STATSCOLLECTOR_HISTORY_LENGTH);
@@ -726,6 +729,9 @@ void App::streamListenersInit()
 {
    this->numStreamListeners = cfg->getTuneNumStreamListeners();
 
+   if(cfg->getTuneListenerReusePort() )
+      StreamListenerV2::checkTCPListenPortUnused(cfg->getConnStoragePort() );
+
    for(unsigned i=0; i < numStreamListeners; i++)
    {
       StreamListenerV2* listener = new StorageStreamListenerV2(
@@ -738,6 +744,9 @@ void App::streamListenersInit()
          listener->setUseAggressivePoll();
 
       streamLisVec.push_back(listener);
+
+      if(cfg->getTuneListenerReusePort() )
+         listener->initTCPListenSock(cfg->getConnStoragePort() );
    }
 }
 
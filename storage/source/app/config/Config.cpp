@@ -39,6 +39,7 @@ void Config::loadDefaults(bool addDashes)
    configMapRedefine("tuneProcessFDLimit",            "50000");
    configMapRedefine("tuneWorkerNumaAffinity",        "false");
    configMapRedefine("tuneListenerNumaAffinity",      "false");
+   configMapRedefine("tuneListenerReusePort",         "false");
    configMapRedefine("tuneListenerPrioShift",         "-1");
    configMapRedefine("tuneBindToNumaZone",            "");
    configMapRedefine("tuneFileReadSize",              "32k");
@@ -46,11 +47,19 @@ void Config::loadDefaults(bool addDashes)
    configMapRedefine("tuneFileReadAheadSize",         "0");
    configMapRedefine("tuneFileWriteSize",             "64k");
    configMapRedefine("tuneFileWriteSyncSize",         "0");
+   configMapRedefine("tuneFileWritePipelineDepth",    "0");
+   configMapRedefine("tuneUseIoUring",                "false");
+   configMapRedefine("tuneChunkChecksums",            "false");
+   configMapRedefine("tuneUseZeroCopyRead",           "false");
+   configMapRedefine("tuneUseZeroCopySend",           "false");
    configMapRedefine("tuneUsePerUserMsgQueues",       "false");
+   configMapRedefine("tuneUseWorkStealingQueues",     "false");
    configMapRedefine("tuneDirCacheLimit",             "1024");
    configMapRedefine("tuneEarlyStat",                 "false");
    configMapRedefine("tuneNumResyncSlaves",           "12");
    configMapRedefine("tuneNumResyncGatherSlaves",     "6");
+   configMapRedefine("tuneResyncUseBlockDigests",     "false");
+   configMapRedefine("tuneResyncWindowSize",          "4");
    configMapRedefine("tuneUseAggressiveStreamPoll",   "false");
    configMapRedefine("tuneUsePerTargetWorkers",       "true");
    configMapRedefine("tuneChunkBalanceQueueLimit",    "100000");
@@ -59,6 +68,7 @@ void Config::loadDefaults(bool addDashes)
    configMapRedefine("quotaDisableZfsSupport",        "false");
 
    configMapRedefine("sysResyncSafetyThresholdMins",  "10");
+   configMapRedefine("sysResyncUseJournal",           "false");
    configMapRedefine("sysTargetOfflineTimeoutSecs",   "180");
 
    configMapRedefine("runDaemonized",            "false");
@@ -142,6 +152,8 @@ void Config::applyConfigMap(bool enableException, bool addDashes)
          tuneWorkerNumaAffinity = StringTk::strToBool(iter->second);
       else if (iter->first == std::string("tuneListenerNumaAffinity"))
          tuneListenerNumaAffinity = StringTk::strToBool(iter->second);
+      else if (iter->first == std::string("tuneListenerReusePort"))
+         tuneListenerReusePort = StringTk::strToBool(iter->second);
       else if (iter->first == std::string("tuneBindToNumaZone"))
       {
          if (iter->second.empty()) // not defined => disable
@@ -161,8 +173,20 @@ void Config::applyConfigMap(bool enableException, bool addDashes)
          tuneFileWriteSize = UnitTk::strHumanToInt64(iter->second);
       else if (iter->first == std::string("tuneFileWriteSyncSize"))
          tuneFileWriteSyncSize = UnitTk::strHumanToInt64(iter->second);
+      else if (iter->first == std::string("tuneFileWritePipelineDepth"))
+         tuneFileWritePipelineDepth = StringTk::strToUInt(iter->second);
+      else if (iter->first == std::string("tuneUseIoUring"))
+         tuneUseIoUring = StringTk::strToBool(iter->second);
+      else if (iter->first == std::string("tuneChunkChecksums"))
+         tuneChunkChecksums = StringTk::strToBool(iter->second);
+      else if (iter->first == std::string("tuneUseZeroCopyRead"))
+         tuneUseZeroCopyRead = StringTk::strToBool(iter->second);
+      else if (iter->first == std::string("tuneUseZeroCopySend"))
+         tuneUseZeroCopySend = StringTk::strToBool(iter->second);
       else if (iter->first == std::string("tuneUsePerUserMsgQueues"))
          tuneUsePerUserMsgQueues = StringTk::strToBool(iter->second);
+      else if (iter->first == std::string("tuneUseWorkStealingQueues"))
+         tuneUseWorkStealingQueues = StringTk::strToBool(iter->second);
       else if (iter->first == std::string("tuneDirCacheLimit"))
          tuneDirCacheLimit = StringTk::strToUInt(iter->second);
       else if (iter->first == std::string("tuneEarlyStat"))
@@ -171,6 +195,10 @@ void Config::applyConfigMap(bool enableException, bool addDashes)
          this->tuneNumResyncGatherSlaves = StringTk::strToUInt(iter->second);
       else if (iter->first == std::string("tuneNumResyncSlaves"))
          this->tuneNumResyncSlaves = StringTk::strToUInt(iter->second);
+      else if (iter->first == std::string("tuneResyncUseBlockDigests"))
+         this->tuneResyncUseBlockDigests = StringTk::strToBool(iter->second);
+      else if (iter->first == std::string("tuneResyncWindowSize"))
+         this->tuneResyncWindowSize = StringTk::strToUInt(iter->second);
       else if (iter->first == std::string("tuneUseAggressiveStreamPoll"))
          tuneUseAggressiveStreamPoll = StringTk::strToBool(iter->second);
       else if (iter->first == std::string("tuneUsePerTargetWorkers"))
@@ -183,6 +211,8 @@ void Config::applyConfigMap(bool enableException, bool addDashes)
          quotaDisableZfsSupport = StringTk::strToBool(iter->second);
       else if (iter->first == std::string("sysResyncSafetyThresholdMins"))
          sysResyncSafetyThresholdMins = StringTk::strToInt64(iter->second);
+      else if (iter->first == std::string("sysResyncUseJournal"))
+         sysResyncUseJournal = StringTk::strToBool(iter->second);
       else if (iter->first == std::string("sysTargetOfflineTimeoutSecs"))
       {
          sysTargetOfflineTimeoutSecs = StringTk::strToUInt(iter->second);
@@ -38,6 +38,7 @@ class Config : public AbstractConfig
       unsigned    tuneProcessFDLimit; // 0 means "don't touch limit"
       bool        tuneWorkerNumaAffinity;
       bool        tuneListenerNumaAffinity;
+      bool        tuneListenerReusePort; // true for per-listener SO_REUSEPORT accept
       int         tuneBindToNumaZone; // bind all threads to this zone, -1 means no binding
       int         tuneListenerPrioShift;
       ssize_t     tuneFileReadSize;
@@ -45,11 +46,19 @@ class Config : public AbstractConfig
       ssize_t     tuneFileReadAheadSize; // read-ahead with posix_fadvise(..., POSIX_FADV_WILLNEED)
       ssize_t     tuneFileWriteSize;
       ssize_t     tuneFileWriteSyncSize; // after how many of per session data to sync_file_range()
+      unsigned    tuneFileWritePipelineDepth; // number of buffers for overlapping recv and write
+      bool        tuneUseIoUring; // true to use io_uring for pipelined writes
+      bool        tuneChunkChecksums; // true to store and verify per-block chunk checksums
+      bool        tuneUseZeroCopyRead; // true to sendfile() read data to TCP clients
+      bool        tuneUseZeroCopySend; // true to send resync data with MSG_ZEROCOPY
       bool        tuneUsePerUserMsgQueues; // true to use UserWorkContainer for MultiWorkQueue
+      bool        tuneUseWorkStealingQueues; // true to use WorkStealingQueue in MultiWorkQueue
       unsigned    tuneDirCacheLimit;
       bool        tuneEarlyStat;          // stat the chunk file before closing it
       unsigned    tuneNumResyncGatherSlaves;
       unsigned    tuneNumResyncSlaves;
+      bool        tuneResyncUseBlockDigests; // true to only transfer changed blocks in resync
+      unsigned    tuneResyncWindowSize; // blocks in flight per resynced chunk
       bool        tuneUseAggressiveStreamPoll; // true to not sleep on epoll in streamlisv2
       bool        tuneUsePerTargetWorkers; // true to have tuneNumWorkers separate for each target
       unsigned    tuneChunkBalanceQueueLimit;  //maximum number of items in chunk balancing queue
@@ -59,6 +68,7 @@ class Config : public AbstractConfig
       bool        quotaDisableZfsSupport;
 
       int64_t     sysResyncSafetyThresholdMins; // minutes to add to last buddy comm timestamp
+      bool        sysResyncUseJournal; // record dirty chunks while the buddy needs a resync
       unsigned    sysTargetOfflineTimeoutSecs;
 
       bool        runDaemonized;
@@ -122,6 +132,11 @@ class Config : public AbstractConfig
          return tuneListenerNumaAffinity;
       }
 
+      bool getTuneListenerReusePort() const
+      {
+         return tuneListenerReusePort;
+      }
+
       int getTuneBindToNumaZone() const
       {
          return tuneBindToNumaZone;
@@ -157,11 +172,41 @@ class Config : public AbstractConfig
          return this->tuneFileWriteSyncSize;
       }
 
+      unsigned getTuneFileWritePipelineDepth() const
+      {
+         return tuneFileWritePipelineDepth;
+      }
+
+      bool getTuneUseIoUring() const
+      {
+         return tuneUseIoUring;
+      }
+
+      bool getTuneChunkChecksums() const
+      {
+         return tuneChunkChecksums;
+      }
+
+      bool getTuneUseZeroCopyRead() const
+      {
+         return tuneUseZeroCopyRead;
+      }
+
+      bool getTuneUseZeroCopySend() const
+      {
+         return tuneUseZeroCopySend;
+      }
+
       bool getTuneUsePerUserMsgQueues() const
       {
          return tuneUsePerUserMsgQueues;
       }
 
+      bool getTuneUseWorkStealingQueues() const
+      {
+         return tuneUseWorkStealingQueues;
+      }
+
       bool getRunDaemonized() const
       {
          return runDaemonized;
@@ -207,6 +252,16 @@ class Config : public AbstractConfig
          return tuneNumResyncSlaves;
       }
 
+      bool getTuneResyncUseBlockDigests() const
+      {
+         return tuneResyncUseBlockDigests;
+      }
+
+      unsigned getTuneResyncWindowSize() const
+      {
+         return tuneResyncWindowSize;
+      }
+
       bool getTuneUseAggressiveStreamPoll() const
       {
          return tuneUseAggressiveStreamPoll;
@@ -222,6 +277,11 @@ class Config : public AbstractConfig
          return sysResyncSafetyThresholdMins;
       }
 
+      bool getSysResyncUseJournal() const
+      {
+         return sysResyncUseJournal;
+      }
+
       unsigned getSysTargetOfflineTimeoutSecs() const
       {
          return sysTargetOfflineTimeoutSecs;
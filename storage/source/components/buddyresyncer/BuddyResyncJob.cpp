@@ -92,10 +92,14 @@ void BuddyResyncJob::run()
    bool checkTopLevelDirRes;
    bool walkRes;
 
+   DirtyChunkMap dirtyChunks;
+   bool useJournal;
+
    auto& target = *storageTargets->getTargets().at(targetID);
 
    shallAbort.setZero();
    targetWasOffline = false;
+   numJournalChunks.setZero();
 
    // delete sync candidates and gather queue; just in case there was something from a previous run
    syncCandidates.clear();
@@ -143,6 +147,41 @@ void BuddyResyncJob::run()
       goto cleanup;
    }
 
+   lastBuddyComm = target.getLastBuddyComm();
+   buddyCommIsOverride = lastBuddyComm.first;
+   lastBuddyCommTimeSecs = std::chrono::system_clock::to_time_t(lastBuddyComm.second);
+
+   lastBuddyCommSafetyThresholdSecs = app->getConfig()->getSysResyncSafetyThresholdMins()*60;
+   if ( (lastBuddyCommSafetyThresholdSecs == 0) && (!buddyCommIsOverride) ) // ignore timestamp file
+      lastBuddyCommTimeSecs = 0;
+   else
+   if (lastBuddyCommTimeSecs > lastBuddyCommSafetyThresholdSecs)
+      lastBuddyCommTimeSecs -= lastBuddyCommSafetyThresholdSecs;
+
+   // the journal must be read in any case (stops the recording), but it can only be used if the
+   // primary itself recorded the need for a resync and the user didn't ask for a full check (the
+   // journal also needs to reach back to the safety threshold before the last buddy comm)
+   useJournal = target.getDirtyChunkJournal().startResync(dirtyChunks, lastBuddyCommTimeSecs)
+      && target.getBuddyNeedsResync()
+      && !buddyCommIsOverride
+      && (lastBuddyCommSafetyThresholdSecs != 0);
+
+   if (useJournal)
+   {
+      LOG(MIRRORING, NOTICE, "Using dirty chunk journal for resync.", targetID,
+            ("numChunks", dirtyChunks.size()));
+
+      startSyncSlavesRes = startSyncSlaves();
+      if (!startSyncSlavesRes)
+      {
+         setStatus(BuddyResyncJobState_FAILURE);
+         goto cleanup;
+      }
+
+      queueJournalChunks(dirtyChunks);
+      goto terminate_sync_slaves;
+   }
+
    startGatherSlavesRes = startGatherSlaves(target);
    if (!startGatherSlavesRes)
    {
@@ -170,17 +209,6 @@ void BuddyResyncJob::run()
    targetPath = target.getPath().str();
    chunksPath = targetPath + "/" + CONFIG_BUDDYMIRROR_SUBDIR_NAME;
 
-   lastBuddyComm = target.getLastBuddyComm();
-   buddyCommIsOverride = lastBuddyComm.first;
-   lastBuddyCommTimeSecs = std::chrono::system_clock::to_time_t(lastBuddyComm.second);
-
-   lastBuddyCommSafetyThresholdSecs = app->getConfig()->getSysResyncSafetyThresholdMins()*60;
-   if ( (lastBuddyCommSafetyThresholdSecs == 0) && (!buddyCommIsOverride) ) // ignore timestamp file
-      lastBuddyCommTimeSecs = 0;
-   else
-   if (lastBuddyCommTimeSecs > lastBuddyCommSafetyThresholdSecs)
-      lastBuddyCommTimeSecs -= lastBuddyCommSafetyThresholdSecs;
-
    checkTopLevelDirRes = checkTopLevelDir(chunksPath, lastBuddyCommTimeSecs);
    if (!checkTopLevelDirRes)
    {
@@ -233,6 +261,7 @@ void BuddyResyncJob::run()
 
    joinGatherSlaves();
 
+terminate_sync_slaves:
    // gather slaves have finished => tell sync slaves to stop when work packages are empty and wait
    for(size_t i = 0; i < fileSyncSlaveVec.size(); i++)
    {
@@ -339,6 +368,9 @@ cleanup:
          // still *is* needs-resync. the resync itself has been perfectly successful, but we have
          // to start another one anyway once the target comes back to ensure that no information
          // was lost.
+         if (!targetWasOffline.read())
+            target.getDirtyChunkJournal().finishResync();
+
          target.setBuddyNeedsResync(targetWasOffline.read());
          informBuddy();
 
@@ -390,6 +422,27 @@ void BuddyResyncJob::abort()
    }
 }
 
+/**
+ * Pass the chunks from the dirty chunk journal to the file sync slaves (instead of gathering them
+ * by walking the chunk dirs).
+ */
+void BuddyResyncJob::queueJournalChunks(DirtyChunkMap& dirtyChunks)
+{
+   for (auto& dirtyChunk : dirtyChunks)
+   {
+      if (shallAbort.read() != 0)
+         return;
+
+      numJournalChunks.increase();
+
+      if (dirtyChunk.second.fullSync)
+         syncCandidates.add(ChunkSyncCandidateFile(dirtyChunk.first, targetID), this);
+      else
+         syncCandidates.add(ChunkSyncCandidateFile(dirtyChunk.first, targetID,
+            std::move(dirtyChunk.second.ranges) ), this);
+   }
+}
+
 bool BuddyResyncJob::startGatherSlaves(const StorageTarget& target)
 {
    // create a gather slaves if they don't exist yet and start them
@@ -488,8 +541,8 @@ void BuddyResyncJob::joinSyncSlaves()
 
 void BuddyResyncJob::getJobStats(StorageBuddyResyncJobStatistics& outStats)
 {
-   uint64_t discoveredFiles = 0;
-   uint64_t matchedFiles = 0;
+   uint64_t discoveredFiles = numJournalChunks.read();
+   uint64_t matchedFiles = numJournalChunks.read();
    uint64_t discoveredDirs = numDirsDiscovered.read();
    uint64_t matchedDirs = numDirsMatched.read();
    uint64_t syncedFiles = 0;
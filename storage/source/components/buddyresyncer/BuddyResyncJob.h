@@ -38,6 +38,7 @@ class BuddyResyncJob : public PThread
       // this thread walks over the top dir structures itself, so we need to track that
       AtomicUInt64 numDirsDiscovered;
       AtomicUInt64 numDirsMatched;
+      AtomicUInt64 numJournalChunks; // chunks from the dirty chunk journal (no gather slaves)
 
       AtomicInt16 shallAbort; // quasi-boolean
       AtomicInt16 targetWasOffline;
@@ -46,6 +47,8 @@ class BuddyResyncJob : public PThread
       bool walkDirs(std::string chunksPath, std::string relPath, int level,
          int64_t lastBuddyCommTimeSecs);
 
+      void queueJournalChunks(DirtyChunkMap& dirtyChunks);
+
       bool startGatherSlaves(const StorageTarget& target);
       bool startSyncSlaves();
       void joinGatherSlaves();
@@ -55,7 +55,8 @@ void BuddyResyncerFileSyncSlave::syncLoop()
       // get buddy targetID
       uint16_t buddyTargetID = buddyGroupMapper->getBuddyTargetID(localTargetID);
       // perform sync
-      FhgfsOpsErr resyncRes = ChunkFileResyncer::doResync(relativePath, localTargetID, buddyTargetID, chunkFileResyncerMode);
+      FhgfsOpsErr resyncRes = ChunkFileResyncer::doResync(relativePath, localTargetID, buddyTargetID, chunkFileResyncerMode,
+         candidate.getDirtyRanges() );
       if (resyncRes == FhgfsOpsErr_SUCCESS)
          numChunksSynced.increase();
       else
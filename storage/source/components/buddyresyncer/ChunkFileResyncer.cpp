@@ -1,5 +1,7 @@
 #include <common/net/message/storage/creating/RmChunkPathsMsg.h>
 #include <common/net/message/storage/creating/RmChunkPathsRespMsg.h>
+#include <common/net/message/storage/mirroring/GetChunkBlockDigestsMsg.h>
+#include <common/net/message/storage/mirroring/GetChunkBlockDigestsRespMsg.h>
 #include <common/net/message/storage/mirroring/ResyncLocalFileMsg.h>
 #include <common/net/message/storage/mirroring/ResyncLocalFileRespMsg.h> 
 #include <toolkit/StorageTkEx.h>
@@ -10,6 +12,42 @@
 
 #define PROCESS_AT_ONCE 1
 #define SYNC_BLOCK_SIZE (1024*1024) // 1M
+#define SYNC_DIGESTS_AT_ONCE 256 // number of block digests to request from the destination at once
+
+
+namespace {
+
+uint64_t getZeroBlockDigest()
+{
+   static const uint64_t zeroBlockDigest = []() {
+      boost::scoped_array<char> zeroBuf(new char[SYNC_BLOCK_SIZE]() );
+      return StorageTkEx::getBlockDigest(zeroBuf.get(), SYNC_BLOCK_SIZE);
+   }();
+
+   return zeroBlockDigest;
+}
+
+/**
+ * @param dirtyRanges sorted and merged
+ * @param fromOffset block aligned
+ * @return start of the first block at or after fromOffset that overlaps a dirty range, or -1 if
+ *    there is none.
+ */
+int64_t getNextDirtyBlockOffset(const ChunkRangeVec& dirtyRanges, int64_t fromOffset)
+{
+   for (const auto& range : dirtyRanges)
+   {
+      if (range.second <= fromOffset)
+         continue;
+
+      int64_t start = std::max(range.first, fromOffset);
+      return start - (start % SYNC_BLOCK_SIZE);
+   }
+
+   return -1;
+}
+
+}
 
 ChunkFileResyncer::ChunkFileResyncer(uint16_t targetID, 
          uint8_t  slaveID) :
@@ -55,11 +93,15 @@ void ChunkFileResyncer::run()
    setIsRunning(false);
 }
 
+/**
+ * @param dirtyRanges NULL to sync the whole chunk, otherwise only the blocks that overlap the given
+ *    ranges (from the dirty chunk journal) and the last block are sent.
+ */
 FhgfsOpsErr ChunkFileResyncer::doResync(std::string& chunkPathStr, uint16_t localTargetID,
-   uint16_t destinationTargetID, ChunkFileResyncerMode chunkFileResyncerMode)
+   uint16_t destinationTargetID, ChunkFileResyncerMode chunkFileResyncerMode,
+   const ChunkRangeVec* dirtyRanges)
 {
    FhgfsOpsErr retVal = FhgfsOpsErr_SUCCESS;
-   unsigned msgRetryIntervalMS = 5000;
 
    App* app = Program::getApp();
    TargetMapper* targetMapper = app->getTargetMapper();
@@ -84,14 +126,60 @@ FhgfsOpsErr ChunkFileResyncer::doResync(std::string& chunkPathStr, uint16_t loca
    ssize_t readRes = 0;
    unsigned resyncMsgFlags = 0;
 
+   /* delta mode: only send the blocks that differ from the chunk on the destination (requires
+      that the chunk exists there). haveDigests is cleared if getting the digests fails, so the
+      remaining blocks are all sent. */
+   bool deltaMode = false;
+   bool haveDigests = false;
+   RemoteBlockDigests remoteDigests;
+
+   bool skipToLastBlock = false; // no dirty ranges left => only the last block is sent
+
+   /* blocks in flight (sent, but response not received yet); the chunk stays locked while there
+      are blocks in flight, each block has its own slot in the data buffer */
+   const size_t windowSize = std::max(app->getConfig()->getTuneResyncWindowSize(), 1U);
+   std::vector<InFlightResyncMsg> inFlightMsgs;
+   size_t nextSlot = 0; // (slots are used round-robin, so it's never used by a block in flight)
+
+   boost::scoped_array<char> data(new char[SYNC_BLOCK_SIZE * windowSize]);
+
    LogContext(__func__).log(Log_DEBUG,
       "Copy chunk operation started. chunkPath: " + chunkPathStr + "; localTargetID: "
          + std::to_string(localTargetID) + "; destinationTargetID: "
          + std::to_string(destinationTargetID)+ "; chunkFileResyncerMode: "
          + std::to_string(chunkFileResyncerMode));
 
+   if ( (chunkFileResyncerMode == CHUNKFILERESYNCER_FLAG_BUDDYMIRROR) &&
+      app->getConfig()->getTuneResyncUseBlockDigests() )
+   {
+      FhgfsOpsErr digestsRes = fetchRemoteBlockDigests(*node, chunkPathStr, destinationTargetID,
+         0, remoteDigests);
+
+      deltaMode = (digestsRes == FhgfsOpsErr_SUCCESS);
+      haveDigests = deltaMode;
+
+      if (deltaMode)
+         resyncMsgFlags |= RESYNCLOCALFILEMSG_FLAG_DELTA;
+   }
+
+   if (dirtyRanges)
+   { // blocks outside of the dirty ranges are not sent, so the chunk must not be truncated
+      deltaMode = true;
+      resyncMsgFlags |= RESYNCLOCALFILEMSG_FLAG_DELTA;
+
+      offset = getNextDirtyBlockOffset(*dirtyRanges, 0);
+      skipToLastBlock = (offset == -1);
+
+      if (skipToLastBlock)
+         offset = 0;
+   }
+
    do
    {
+      bool isHoleBlock = false;
+      bool dataFound = false;
+      char* blockBuf = data.get() + nextSlot * SYNC_BLOCK_SIZE;
+
       if (chunkFileResyncerMode == CHUNKFILERESYNCER_FLAG_BUDDYMIRROR)
       {
          resyncMsgFlags |= RESYNCLOCALFILEMSG_FLAG_BUDDYMIRROR; //set buddy mirroring flag 
@@ -101,13 +189,12 @@ FhgfsOpsErr ChunkFileResyncer::doResync(std::string& chunkPathStr, uint16_t loca
          resyncMsgFlags |= RESYNCLOCALFILEMSG_FLAG_BUDDYMIRROR;
          resyncMsgFlags |= RESYNCLOCALFILEMSG_FLAG_CHUNKBALANCE_BUDDYMIRROR;
       }
-      
-      boost::scoped_array<char> data(new char[SYNC_BLOCK_SIZE]);
 
       const auto& target = app->getStorageTargets()->getTargets().at(localTargetID);
 
-      // lock the chunk
-      chunkLockStore->lockChunk(localTargetID, entryID);
+      // lock the chunk (unless it's still locked for the blocks in flight)
+      if (inFlightMsgs.empty() )
+         chunkLockStore->lockChunk(localTargetID, entryID);
       
       fd = openat(getFD(target), chunkPathStr.c_str(), O_RDONLY | O_NOATIME);
    
@@ -153,86 +240,154 @@ FhgfsOpsErr ChunkFileResyncer::doResync(std::string& chunkPathStr, uint16_t loca
             retVal = FhgfsOpsErr_INTERNAL;
          }
 
-         chunkLockStore->unlockChunk(localTargetID, entryID);
+         if (inFlightMsgs.empty() )
+            chunkLockStore->unlockChunk(localTargetID, entryID);
 
          goto cleanup;
       }
 
-      int seekRes = lseek(fd, offset, SEEK_SET);
-
-      if (seekRes == -1)
+      if (skipToLastBlock)
       {
-         LogContext(__func__).logErr(
-            "Seeking in chunk failed. chunkPath: " + chunkPathStr + "; targetID: "
-               + std::to_string(localTargetID) + "; offset: " + StringTk::int64ToStr(offset));
-
-         chunkLockStore->unlockChunk(localTargetID, entryID);
+         struct stat statBuf;
 
-         goto cleanup;
+         if ( (fstat(fd, &statBuf) == 0) && (statBuf.st_size > offset) )
+            offset = statBuf.st_size - (statBuf.st_size % SYNC_BLOCK_SIZE);
       }
 
-      readRes = read(fd, data.get(), SYNC_BLOCK_SIZE);
+      { // check if the block is completely in a hole (but not the last block of the file)
+         struct stat statBuf;
 
-      if (readRes == -1)
-      {
-         LogContext(__func__).logErr("Error during read; "
-            "chunkPath: " + chunkPathStr + "; "
-            "targetID: " + std::to_string(localTargetID) + "; "
-            "TargetNode: " + node->getTypedNodeID() + "; "
-            "DestinationTargetID: " + std::to_string(destinationTargetID) + "; "
-            "Error: " + System::getErrString(errno));
-
-         retVal = FhgfsOpsErr_INTERNAL;
+         if ( (fstat(fd, &statBuf) == 0) && (offset + SYNC_BLOCK_SIZE <= statBuf.st_size) )
+         {
+            off_t dataOffset = lseek(fd, offset, SEEK_DATA);
 
-         goto end_of_loop;
+            isHoleBlock = ( (dataOffset == -1) && (errno == ENXIO) ) ||
+               (dataOffset >= offset + SYNC_BLOCK_SIZE);
+         }
       }
 
-      if (readRes > 0)
+      if (isHoleBlock)
+      { // no need to read the block, it's all zeros
+         readRes = SYNC_BLOCK_SIZE;
+      }
+      else
       {
-         const char zeroBuf[RESYNCER_SPARSE_BLOCK_SIZE] = { 0 };
+         int seekRes = lseek(fd, offset, SEEK_SET);
+
+         if (seekRes == -1)
+         {
+            LogContext(__func__).logErr(
+               "Seeking in chunk failed. chunkPath: " + chunkPathStr + "; targetID: "
+                  + std::to_string(localTargetID) + "; offset: " + StringTk::int64ToStr(offset));
 
-         // check if sparse blocks are in the buffer
-         ssize_t bufPos = 0;
-         bool dataFound = false;
-         while (bufPos < readRes)
+            if (inFlightMsgs.empty() )
+               chunkLockStore->unlockChunk(localTargetID, entryID);
+
+            goto cleanup;
+         }
+
+         readRes = read(fd, blockBuf, SYNC_BLOCK_SIZE);
+
+         if (readRes == -1)
          {
-            size_t cmpLen = BEEGFS_MIN(readRes-bufPos, RESYNCER_SPARSE_BLOCK_SIZE);
+            LogContext(__func__).logErr("Error during read; "
+               "chunkPath: " + chunkPathStr + "; "
+               "targetID: " + std::to_string(localTargetID) + "; "
+               "TargetNode: " + node->getTypedNodeID() + "; "
+               "DestinationTargetID: " + std::to_string(destinationTargetID) + "; "
+               "Error: " + System::getErrString(errno));
+
+            retVal = FhgfsOpsErr_INTERNAL;
+
+            goto end_of_loop;
+         }
 
-            int cmpRes = memcmp(data.get() + bufPos, zeroBuf, cmpLen);
-            if (cmpRes != 0)
-               dataFound = true;
-            else // sparse area detected
+         if (readRes > 0)
+         {
+            const char zeroBuf[RESYNCER_SPARSE_BLOCK_SIZE] = { 0 };
+
+            // check if sparse blocks are in the buffer
+            ssize_t bufPos = 0;
+            while (bufPos < readRes)
             {
-               if (dataFound) // had data before
+               size_t cmpLen = BEEGFS_MIN(readRes-bufPos, RESYNCER_SPARSE_BLOCK_SIZE);
+
+               int cmpRes = memcmp(blockBuf + bufPos, zeroBuf, cmpLen);
+               if (cmpRes != 0)
+                  dataFound = true;
+               else // sparse area detected
                {
-                  resyncMsgFlags |= RESYNCLOCALFILEMSG_CHECK_SPARSE; // let the receiver do a check
-                  break; // and stop checking here
+                  if (dataFound) // had data before
+                  {
+                     resyncMsgFlags |= RESYNCLOCALFILEMSG_CHECK_SPARSE; // let the receiver do a check
+                     break; // and stop checking here
+                  }
                }
-            }
 
-            bufPos += cmpLen;
+               bufPos += cmpLen;
+            }
          }
+      }
 
-         // this inner loop is over and there are only sparse areas
+      if (readRes == SYNC_BLOCK_SIZE)
+      { // (the last block is always sent to set attribs and trunc)
+         if (deltaMode)
+         {
+            uint64_t remoteDigest;
 
+            // (fetching digests needs another conn, so don't wait for it while holding conns)
+            if (haveDigests && !inFlightMsgs.empty() &&
+               !isRemoteBlockDigestCached(remoteDigests, offset / SYNC_BLOCK_SIZE) )
+            {
+               retVal = finishInFlightMsgs(*node, inFlightMsgs, localTargetID,
+                  destinationTargetID);
+
+               if (retVal != FhgfsOpsErr_SUCCESS)
+               {
+                  readRes = -2; // force exiting loop
+                  goto end_of_loop;
+               }
+            }
+
+            if (haveDigests)
+               haveDigests = getRemoteBlockDigest(*node, chunkPathStr, destinationTargetID,
+                  offset / SYNC_BLOCK_SIZE, remoteDigests, remoteDigest);
+
+            if (haveDigests)
+            {
+               uint64_t localDigest = dataFound ?
+                  StorageTkEx::getBlockDigest(blockBuf, readRes) : getZeroBlockDigest();
+
+               if (localDigest == remoteDigest)
+                  goto end_of_loop; // => no transfer needed
+            }
+         }
+         else
          /* make sure we always send a msg at offset==0 to truncate the file and allow concurrent
             writers in a big inital sparse area */
-         if (offset && (readRes > 0) && (readRes == SYNC_BLOCK_SIZE) && !dataFound)
+         if (offset && !dataFound)
          {
             goto end_of_loop;
             // => no transfer needed
          }
-
-         /* let the receiver do a check, because we might be sending a sparse block at beginnig or
-            end of file */
-         if (!dataFound)
-            resyncMsgFlags |= RESYNCLOCALFILEMSG_CHECK_SPARSE;
       }
 
+      if (isHoleBlock)
+         memset(blockBuf, 0, SYNC_BLOCK_SIZE);
+
+      /* let the receiver do a check, because we might be sending a sparse block at beginnig or
+         end of file */
+      if ( (readRes > 0) && !dataFound)
+         resyncMsgFlags |= RESYNCLOCALFILEMSG_CHECK_SPARSE;
+
       {
-         ResyncLocalFileMsg resyncMsg(data.get(), chunkPathStr, destinationTargetID, offset, readRes);
+         bool isLastBlock = !readRes || (readRes < SYNC_BLOCK_SIZE);
+         bool isOrderedBlock = isOrderedResyncBlock(offset, readRes, resyncMsgFlags);
+
+         std::unique_ptr<ResyncLocalFileMsg> resyncMsg(new ResyncLocalFileMsg(blockBuf,
+            chunkPathStr, destinationTargetID, offset, readRes) );
 
-         if (!readRes || (readRes < SYNC_BLOCK_SIZE) ) // last iteration, set attribs and trunc buddy chunk
+         if (isLastBlock) // last iteration, set attribs and trunc buddy chunk
          {
             struct stat statBuf;
             int statRes = fstat(fd, &statBuf);
@@ -242,19 +397,23 @@ FhgfsOpsErr ChunkFileResyncer::doResync(std::string& chunkPathStr, uint16_t loca
                if (statBuf.st_size < offset)
                { // in case someone truncated the file while we're reading at a high offset
                   offset = statBuf.st_size;
-                  resyncMsg.setOffset(offset);
+                  resyncMsg->setOffset(offset);
                }
                else
                if (offset && !readRes)
                   resyncMsgFlags |= RESYNCLOCALFILEMSG_FLAG_TRUNC;
 
+               // the destination chunk wasn't truncated at the first block, so it might be longer
+               if (deltaMode)
+                  resyncMsgFlags |= RESYNCLOCALFILEMSG_FLAG_TRUNC;
+
                int mode = statBuf.st_mode;
                unsigned userID = statBuf.st_uid;
                unsigned groupID = statBuf.st_gid;
                int64_t mtimeSecs = statBuf.st_mtim.tv_sec;
                int64_t atimeSecs = statBuf.st_atim.tv_sec;
                SettableFileAttribs chunkAttribs = {mode, userID,groupID, mtimeSecs, atimeSecs};
-               resyncMsg.setChunkAttribs(chunkAttribs);
+               resyncMsg->setChunkAttribs(chunkAttribs);
                resyncMsgFlags |= RESYNCLOCALFILEMSG_FLAG_SETATTRIBS;
             }
             else
@@ -268,83 +427,31 @@ FhgfsOpsErr ChunkFileResyncer::doResync(std::string& chunkPathStr, uint16_t loca
             }
          }
 
-         resyncMsg.setMsgHeaderFeatureFlags(resyncMsgFlags);
-         resyncMsg.setMsgHeaderTargetID(destinationTargetID);
+         resyncMsg->setMsgHeaderFeatureFlags(resyncMsgFlags);
+         resyncMsg->setMsgHeaderTargetID(destinationTargetID);
 
-         CombinedTargetState state;
-         bool getStateRes =
-            Program::getApp()->getTargetStateStore()->getState(destinationTargetID, state);
-
-         // send request to node and receive response
-         std::unique_ptr<NetMessage> respMsg;
-
-         while ( (!respMsg) && (getStateRes)
-            && (state.reachabilityState != TargetReachabilityState_OFFLINE) )
+         if (isOrderedBlock || (windowSize == 1) )
          {
-            respMsg = MessagingTk::requestResponse(*node, resyncMsg,
-                  NETMSGTYPE_ResyncLocalFileResp);
-
-            if (!respMsg)
-            {
-               LOG_DEBUG(__func__, Log_NOTICE,
-                  "Unable to communicate, but target is not offline; sleeping "
-                  + std::to_string(msgRetryIntervalMS) + "ms before retry. targetID: "
-                  + std::to_string(localTargetID));
+            retVal = finishInFlightMsgs(*node, inFlightMsgs, localTargetID, destinationTargetID);
 
-               PThread::sleepMS(msgRetryIntervalMS);
-
-               // if thread shall terminate, break loop here
-               if ( getSelfTerminateNotIdle() )
-                  break;
-
-               getStateRes =
-                  Program::getApp()->getTargetStateStore()->getState(destinationTargetID, state);
-            }
-         }
-
-         if (!respMsg)
-         { // communication error
-            LogContext(__func__).log(Log_WARNING,
-               "Communication with storage node failed: " + node->getTypedNodeID());
-
-            retVal = FhgfsOpsErr_COMMUNICATION;
-
-            // set readRes to non-zero to force exiting loop
-            readRes = -2;
+            if (retVal == FhgfsOpsErr_SUCCESS)
+               retVal = sendResyncMsg(*node, *resyncMsg, localTargetID, destinationTargetID);
          }
          else
-         if (!getStateRes)
          {
-            LogContext(__func__).log(Log_WARNING,
-               "No valid state for node ID: " + node->getTypedNodeID());
+            retVal = sendResyncMsgAsync(*node, std::move(resyncMsg), inFlightMsgs, localTargetID,
+               destinationTargetID);
 
-            retVal = FhgfsOpsErr_INTERNAL;
+            if (!inFlightMsgs.empty() )
+               nextSlot = (nextSlot + 1) % windowSize;
 
-            // set readRes to non-zero to force exiting loop
-            readRes = -2;
+            if ( (retVal == FhgfsOpsErr_SUCCESS) && (inFlightMsgs.size() == windowSize) )
+               retVal = finishInFlightMsgs(*node, inFlightMsgs, localTargetID,
+                  destinationTargetID);
          }
-         else
-         {
-            // correct response type received
-            ResyncLocalFileRespMsg* respMsgCast = (ResyncLocalFileRespMsg*) respMsg.get();
 
-            FhgfsOpsErr syncRes = respMsgCast->getResult();
-
-            if (syncRes != FhgfsOpsErr_SUCCESS)
-            {
-               LogContext(__func__).log(Log_WARNING, "Error during resync; "
-                  "chunkPath: " + chunkPathStr + "; "
-                  "targetID: " + std::to_string(localTargetID) + "; "
-                  "Destination Node: " + node->getTypedNodeID() + "; "
-                  "DestinationTargetID: " + std::to_string(destinationTargetID) + "; "
-                  "Error: " + boost::lexical_cast<std::string>(syncRes));
-
-               retVal = syncRes;
-
-               // set readRes to non-zero to force exiting loop
-               readRes = -2;
-            }
-         }
+         if (retVal != FhgfsOpsErr_SUCCESS)
+            readRes = -2; // force exiting loop
       }
 
    end_of_loop:
@@ -358,12 +465,23 @@ FhgfsOpsErr ChunkFileResyncer::doResync(std::string& chunkPathStr, uint16_t loca
             "buddyTargetID: " + std::to_string(destinationTargetID) + "; "
             "Error: " + System::getErrString(errno));
       }
-      // unlock the chunk
-      chunkLockStore->unlockChunk(localTargetID, entryID);
+      // unlock the chunk (blocks in flight keep it locked)
+      if (inFlightMsgs.empty() )
+         chunkLockStore->unlockChunk(localTargetID, entryID);
 
       // increment offset for next iteration
       offset += readRes;
 
+      if (dirtyRanges && !skipToLastBlock && (readRes == SYNC_BLOCK_SIZE) )
+      {
+         int64_t nextDirtyOffset = getNextDirtyBlockOffset(*dirtyRanges, offset);
+
+         if (nextDirtyOffset == -1)
+            skipToLastBlock = true;
+         else
+            offset = nextDirtyOffset;
+      }
+
       if ( getSelfTerminateNotIdle() )
       {
          retVal = FhgfsOpsErr_INTERRUPTED;
@@ -373,11 +491,256 @@ FhgfsOpsErr ChunkFileResyncer::doResync(std::string& chunkPathStr, uint16_t loca
    } while (readRes == SYNC_BLOCK_SIZE);
 
 cleanup:
+   if (!inFlightMsgs.empty() )
+   { // loop was left early (e.g. error or termination)
+      FhgfsOpsErr finishRes = finishInFlightMsgs(*node, inFlightMsgs, localTargetID,
+         destinationTargetID);
+
+      if (retVal == FhgfsOpsErr_SUCCESS)
+         retVal = finishRes;
+
+      chunkLockStore->unlockChunk(localTargetID, entryID);
+   }
+
    LogContext(__func__).log(Log_DEBUG, "File sync finished. chunkPath: " + chunkPathStr);
 
    return retVal;
 }
 
+/**
+ * The first block truncates the destination chunk (unless in delta mode) and the last block sets
+ * the attribs, so they must not overlap with other blocks in flight.
+ *
+ * @param readRes number of bytes of the block (less than SYNC_BLOCK_SIZE for the last block)
+ * @return true if the block must be sent synchronously after all blocks in flight are finished
+ */
+bool ChunkFileResyncer::isOrderedResyncBlock(int64_t offset, ssize_t readRes,
+   unsigned resyncMsgFlags)
+{
+   const bool isLastBlock = !readRes || (readRes < SYNC_BLOCK_SIZE);
+
+   return isLastBlock || (!offset && !(resyncMsgFlags & RESYNCLOCALFILEMSG_FLAG_DELTA) );
+}
+
+/**
+ * Send a resync msg and wait for the response; retries until the destination target is marked
+ * offline.
+ *
+ * @return result of the destination or _COMMUNICATION
+ */
+FhgfsOpsErr ChunkFileResyncer::sendResyncMsg(Node& node, ResyncLocalFileMsg& resyncMsg,
+   uint16_t localTargetID, uint16_t destinationTargetID)
+{
+   unsigned msgRetryIntervalMS = 5000;
+
+   CombinedTargetState state;
+   bool getStateRes =
+      Program::getApp()->getTargetStateStore()->getState(destinationTargetID, state);
+
+   // send request to node and receive response
+   std::unique_ptr<NetMessage> respMsg;
+
+   while ( (!respMsg) && (getStateRes)
+      && (state.reachabilityState != TargetReachabilityState_OFFLINE) )
+   {
+      respMsg = MessagingTk::requestResponse(node, resyncMsg,
+            NETMSGTYPE_ResyncLocalFileResp);
+
+      if (!respMsg)
+      {
+         LOG_DEBUG(__func__, Log_NOTICE,
+            "Unable to communicate, but target is not offline; sleeping "
+            + std::to_string(msgRetryIntervalMS) + "ms before retry. targetID: "
+            + std::to_string(localTargetID));
+
+         PThread::sleepMS(msgRetryIntervalMS);
+
+         // if thread shall terminate, break loop here
+         if ( getSelfTerminateNotIdle() )
+            break;
+
+         getStateRes =
+            Program::getApp()->getTargetStateStore()->getState(destinationTargetID, state);
+      }
+   }
+
+   if (!respMsg)
+   { // communication error
+      LogContext(__func__).log(Log_WARNING,
+         "Communication with storage node failed: " + node.getTypedNodeID());
+
+      return FhgfsOpsErr_COMMUNICATION;
+   }
+
+   if (!getStateRes)
+   {
+      LogContext(__func__).log(Log_WARNING,
+         "No valid state for node ID: " + node.getTypedNodeID());
+
+      return FhgfsOpsErr_INTERNAL;
+   }
+
+   // correct response type received
+   ResyncLocalFileRespMsg* respMsgCast = (ResyncLocalFileRespMsg*) respMsg.get();
+
+   FhgfsOpsErr syncRes = respMsgCast->getResult();
+
+   if (syncRes != FhgfsOpsErr_SUCCESS)
+      logResyncError(node, resyncMsg, localTargetID, destinationTargetID, syncRes);
+
+   return syncRes;
+}
+
+/**
+ * Send a resync msg without waiting for the response (which is received by finishInFlightMsgs).
+ * Uses a separate connection for each msg in flight. If no further connection is available right
+ * now or sending fails, the blocks in flight are finished and the msg is sent synchronously.
+ *
+ * Note: The data of the msg must stay valid until the response was received. With
+ *    tuneUseZeroCopySend, the kernel sends it directly from the msg; finishInFlightMsgs() collects
+ *    the completions of those sends after the responses, so that the window isn't limited to one
+ *    block per round trip.
+ */
+FhgfsOpsErr ChunkFileResyncer::sendResyncMsgAsync(Node& node,
+   std::unique_ptr<ResyncLocalFileMsg> resyncMsg, std::vector<InFlightResyncMsg>& inFlightMsgs,
+   uint16_t localTargetID, uint16_t destinationTargetID)
+{
+   NodeConnPool* connPool = node.getConnPool();
+   Socket* sock = NULL;
+
+   try
+   {
+      // (waiting for a conn is only ok if we don't hold any, otherwise slaves could deadlock)
+      sock = connPool->acquireStreamSocketEx(inFlightMsgs.empty() );
+
+      if (sock)
+      {
+         const int sendFlags =
+            Program::getApp()->getConfig()->getTuneUseZeroCopySend() ? MSG_ZEROCOPY : 0;
+
+         MessagingTk::sendMsg(*sock, *resyncMsg, sendFlags);
+
+         inFlightMsgs.push_back({std::move(resyncMsg), sock});
+         return FhgfsOpsErr_SUCCESS;
+      }
+   }
+   catch (SocketException& e)
+   {
+      LOG_DEBUG(__func__, Log_DEBUG, "Sending resync msg failed: " + node.getTypedNodeID() +
+         "; Msg: " + e.what() );
+
+      if (sock)
+         invalidateResyncSock(connPool, sock);
+   }
+
+   FhgfsOpsErr finishRes = finishInFlightMsgs(node, inFlightMsgs, localTargetID,
+      destinationTargetID);
+   if (finishRes != FhgfsOpsErr_SUCCESS)
+      return finishRes;
+
+   return sendResyncMsg(node, *resyncMsg, localTargetID, destinationTargetID);
+}
+
+/**
+ * Receive the responses of all msgs in flight. Msgs with communication errors are resent
+ * synchronously (resync msgs are idempotent).
+ *
+ * @return first error of the msgs in flight (all msgs are finished in any case)
+ */
+FhgfsOpsErr ChunkFileResyncer::finishInFlightMsgs(Node& node,
+   std::vector<InFlightResyncMsg>& inFlightMsgs, uint16_t localTargetID,
+   uint16_t destinationTargetID)
+{
+   NodeConnPool* connPool = node.getConnPool();
+   FhgfsOpsErr retVal = FhgfsOpsErr_SUCCESS;
+
+   for (auto& inFlightMsg : inFlightMsgs)
+   {
+      FhgfsOpsErr msgRes = FhgfsOpsErr_COMMUNICATION;
+
+      try
+      {
+         auto respBuf = MessagingTk::recvMsgBuf(*inFlightMsg.sock);
+
+         if (!respBuf.empty() )
+         {
+            auto respMsg = Program::getApp()->getNetMessageFactory()->createFromBuf(
+               std::move(respBuf) );
+
+            // (other types, like GenericResponse for indirect comm errors, are handled like
+            // comm errors)
+            if (respMsg->getMsgType() == NETMSGTYPE_ResyncLocalFileResp)
+            {
+               // (the peer has the data, so this doesn't wait for the completions of zero-copy
+               // sends anymore)
+               inFlightMsg.sock->waitForZeroCopySends();
+
+               connPool->releaseStreamSocket(inFlightMsg.sock);
+               inFlightMsg.sock = NULL;
+
+               msgRes = ( (ResyncLocalFileRespMsg*)respMsg.get() )->getResult();
+
+               if (msgRes != FhgfsOpsErr_SUCCESS)
+                  logResyncError(node, *inFlightMsg.msg, localTargetID, destinationTargetID,
+                     msgRes);
+            }
+         }
+      }
+      catch (SocketException& e)
+      {
+         LOG_DEBUG(__func__, Log_DEBUG, "Receiving resync response failed: " +
+            node.getTypedNodeID() + "; Msg: " + e.what() );
+      }
+
+      if (inFlightMsg.sock)
+      {
+         invalidateResyncSock(connPool, inFlightMsg.sock);
+         inFlightMsg.sock = NULL;
+
+         if (retVal == FhgfsOpsErr_SUCCESS)
+            msgRes = sendResyncMsg(node, *inFlightMsg.msg, localTargetID, destinationTargetID);
+      }
+
+      if (retVal == FhgfsOpsErr_SUCCESS)
+         retVal = msgRes;
+   }
+
+   inFlightMsgs.clear();
+
+   return retVal;
+}
+
+/**
+ * Invalidate the conn of a resync msg after a communication error. The kernel might still send the
+ * data of previous zero-copy sends on the broken conn, so wait for them first (best effort) before
+ * the msg data is freed or reused.
+ */
+void ChunkFileResyncer::invalidateResyncSock(NodeConnPool* connPool, Socket* sock)
+{
+   try
+   {
+      sock->waitForZeroCopySends();
+   }
+   catch (SocketException& e)
+   {
+      LOG_DEBUG(__func__, Log_DEBUG, std::string("Waiting for zero-copy sends failed: ") +
+         e.what() );
+   }
+
+   connPool->invalidateStreamSocket(sock);
+}
+
+void ChunkFileResyncer::logResyncError(Node& node, ResyncLocalFileMsg& resyncMsg,
+   uint16_t localTargetID, uint16_t destinationTargetID, FhgfsOpsErr syncRes)
+{
+   LogContext(__func__).log(Log_WARNING, "Error during resync; "
+      "chunkPath: " + resyncMsg.getRelativePathStr() + "; "
+      "targetID: " + std::to_string(localTargetID) + "; "
+      "Destination Node: " + node.getTypedNodeID() + "; "
+      "DestinationTargetID: " + std::to_string(destinationTargetID) + "; "
+      "Error: " + boost::lexical_cast<std::string>(syncRes));
+}
+
 /**
  * Note: Chunk has to be locked by caller.
  */
@@ -456,3 +819,94 @@ bool ChunkFileResyncer::removeChunkUnlocked(Node& node, uint16_t localTargetID,
 
    return retVal;
 }
+
+/**
+ * Request the digests of SYNC_DIGESTS_AT_ONCE blocks starting at firstBlock from the destination.
+ *
+ * Note: This doesn't retry on communication errors, the caller falls back to sending all blocks.
+ *
+ * @return FhgfsOpsErr_PATHNOTEXISTS if the chunk doesn't exist on the destination
+ */
+FhgfsOpsErr ChunkFileResyncer::fetchRemoteBlockDigests(Node& node, std::string& chunkPathStr,
+   uint16_t destinationTargetID, int64_t firstBlock, RemoteBlockDigests& outDigests)
+{
+   static_assert( (uint64_t)SYNC_BLOCK_SIZE * SYNC_DIGESTS_AT_ONCE <=
+      GETCHUNKBLOCKDIGESTSMSG_MAX_TOTAL_LEN, "Digest request exceeds the receiver's limit");
+
+   GetChunkBlockDigestsMsg digestsMsg(chunkPathStr, destinationTargetID, SYNC_BLOCK_SIZE,
+      firstBlock, SYNC_DIGESTS_AT_ONCE);
+
+   digestsMsg.addMsgHeaderFeatureFlag(GETCHUNKBLOCKDIGESTSMSG_FLAG_BUDDYMIRROR);
+   digestsMsg.setMsgHeaderTargetID(destinationTargetID);
+
+   std::unique_ptr<NetMessage> respMsg = MessagingTk::requestResponse(node, digestsMsg,
+      NETMSGTYPE_GetChunkBlockDigestsResp);
+
+   if (!respMsg)
+   {
+      LOG_DEBUG(__func__, Log_NOTICE,
+         "Unable to get block digests, sending all blocks. chunkPath: " + chunkPathStr +
+         "; destinationTargetID: " + std::to_string(destinationTargetID) );
+      return FhgfsOpsErr_COMMUNICATION;
+   }
+
+   auto* respMsgCast = (GetChunkBlockDigestsRespMsg*) respMsg.get();
+
+   if (respMsgCast->getResult() != FhgfsOpsErr_SUCCESS)
+      return respMsgCast->getResult();
+
+   outDigests.fileSize = respMsgCast->getFileSize();
+   outDigests.firstBlock = firstBlock;
+   outDigests.digests.swap(respMsgCast->getDigests() );
+
+   return FhgfsOpsErr_SUCCESS;
+}
+
+/**
+ * @return true if getRemoteBlockDigest() doesn't need to fetch digests from the destination.
+ */
+bool ChunkFileResyncer::isRemoteBlockDigestCached(const RemoteBlockDigests& digests,
+   int64_t blockIndex)
+{
+   return (blockIndex * SYNC_BLOCK_SIZE >= digests.fileSize) ||
+      ( (blockIndex >= digests.firstBlock) &&
+        (blockIndex < digests.firstBlock + (int64_t)digests.digests.size() ) );
+}
+
+/**
+ * Get the digest of a block of the chunk on the destination; fetches the next digests from the
+ * destination if the block is not in the given digests.
+ *
+ * Note: Blocks beyond the end of the destination chunk get the digest of a zero block, because
+ * the chunk will be extended with a hole by the final truncate.
+ *
+ * @return false if the digests could not be fetched
+ */
+bool ChunkFileResyncer::getRemoteBlockDigest(Node& node, std::string& chunkPathStr,
+   uint16_t destinationTargetID, int64_t blockIndex, RemoteBlockDigests& digests,
+   uint64_t& outDigest)
+{
+   if (blockIndex * SYNC_BLOCK_SIZE >= digests.fileSize)
+   {
+      outDigest = getZeroBlockDigest();
+      return true;
+   }
+
+   if (!isRemoteBlockDigestCached(digests, blockIndex) )
+   {
+      FhgfsOpsErr fetchRes = fetchRemoteBlockDigests(node, chunkPathStr, destinationTargetID,
+         blockIndex, digests);
+
+      if (fetchRes != FhgfsOpsErr_SUCCESS)
+         return false;
+
+      if (digests.digests.empty() )
+      { // chunk was truncated on the destination in the meantime
+         outDigest = getZeroBlockDigest();
+         return true;
+      }
+   }
+
+   outDigest = digests.digests[blockIndex - digests.firstBlock];
+   return true;
+}
@@ -1,8 +1,10 @@
 #pragma once
 
+#include <common/net/message/storage/mirroring/ResyncLocalFileMsg.h>
 #include <common/nodes/Node.h>
 #include <common/storage/StorageErrors.h>
 #include <common/threading/PThread.h>
+#include <storage/DirtyChunkJournal.h>
 #include <storage/StorageTargets.h>
 #include <mutex>
 
@@ -11,6 +13,7 @@ class ChunkFileResyncer : public PThread
    friend class BuddyResyncer; // (to grant access to internal mutex)     
    friend class BuddyResyncJob; // (to grant access to internal mutex)
    friend class ChunkBalancerJob;  // (to grant access to internal mutex)
+   friend class TestChunkFileResyncer;
 
    public:
       ChunkFileResyncer(uint16_t targetID, 
@@ -44,9 +47,46 @@ class ChunkFileResyncer : public PThread
       virtual void syncLoop()=0;
       virtual int getFD(const std::unique_ptr<StorageTarget> & target)=0;
 
+      /**
+       * Block digests of the chunk on the destination target (for delta transfers).
+       */
+      struct RemoteBlockDigests
+      {
+         int64_t fileSize; // size of the chunk on the destination target
+         int64_t firstBlock; // index of the block of digests[0]
+         UInt64Vector digests;
+      };
+
+      /**
+       * A resync msg that was sent, but of which the response was not received yet.
+       */
+      struct InFlightResyncMsg
+      {
+         std::unique_ptr<ResyncLocalFileMsg> msg;
+         Socket* sock;
+      };
+
       bool removeChunkUnlocked(Node& node, uint16_t localTargetID, uint16_t destinationTargetID, std::string& pathStr);
       FhgfsOpsErr doResync(std::string& chunkPathStr, uint16_t localTargetID,
-         uint16_t destinationTargetID, ChunkFileResyncerMode chunkFileResyncerMode);
+         uint16_t destinationTargetID, ChunkFileResyncerMode chunkFileResyncerMode,
+         const ChunkRangeVec* dirtyRanges = NULL);
+      FhgfsOpsErr fetchRemoteBlockDigests(Node& node, std::string& chunkPathStr,
+         uint16_t destinationTargetID, int64_t firstBlock, RemoteBlockDigests& outDigests);
+      bool getRemoteBlockDigest(Node& node, std::string& chunkPathStr,
+         uint16_t destinationTargetID, int64_t blockIndex, RemoteBlockDigests& digests,
+         uint64_t& outDigest);
+      bool isRemoteBlockDigestCached(const RemoteBlockDigests& digests, int64_t blockIndex);
+      FhgfsOpsErr sendResyncMsg(Node& node, ResyncLocalFileMsg& resyncMsg,
+         uint16_t localTargetID, uint16_t destinationTargetID);
+      FhgfsOpsErr sendResyncMsgAsync(Node& node, std::unique_ptr<ResyncLocalFileMsg> resyncMsg,
+         std::vector<InFlightResyncMsg>& inFlightMsgs, uint16_t localTargetID,
+         uint16_t destinationTargetID);
+      FhgfsOpsErr finishInFlightMsgs(Node& node, std::vector<InFlightResyncMsg>& inFlightMsgs,
+         uint16_t localTargetID, uint16_t destinationTargetID);
+      void logResyncError(Node& node, ResyncLocalFileMsg& resyncMsg, uint16_t localTargetID,
+         uint16_t destinationTargetID, FhgfsOpsErr syncRes);
+      static void invalidateResyncSock(NodeConnPool* connPool, Socket* sock);
+      static bool isOrderedResyncBlock(int64_t offset, ssize_t readRes, unsigned resyncMsgFlags);
 
    public:
 
@@ -3,6 +3,7 @@
 #include <common/storage/mirroring/SyncCandidateStore.h>
 #include <common/storage/EntryInfo.h>
 #include <common/storage/FileEvent.h>
+#include <storage/DirtyChunkJournal.h>
 
 #include <string>
 
@@ -56,7 +57,26 @@ class ChunkSyncCandidateFile : public ChunkSyncCandidateDir
          : ChunkSyncCandidateDir(relativePath, targetID, destinationID, entryInfo, isBuddyMirrorChunk, fileEvent)
       { }
 
+      /**
+       * For chunks from the dirty chunk journal, of which only the given ranges must be synced.
+       */
+      ChunkSyncCandidateFile(const std::string& relativePath, uint16_t targetID,
+         ChunkRangeVec dirtyRanges)
+         : ChunkSyncCandidateDir(relativePath, targetID), hasDirtyRanges(true),
+           dirtyRanges(std::move(dirtyRanges))
+      { }
+
       ChunkSyncCandidateFile() = default;
+
+   private:
+      bool hasDirtyRanges = false; // false to sync the whole chunk
+      ChunkRangeVec dirtyRanges;
+
+   public:
+      const ChunkRangeVec* getDirtyRanges() const
+      {
+         return hasDirtyRanges ? &dirtyRanges : NULL;
+      }
 };
 
 typedef SyncCandidateStore<ChunkSyncCandidateDir, ChunkSyncCandidateFile> ChunkSyncCandidateStore;
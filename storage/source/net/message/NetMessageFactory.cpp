@@ -2,6 +2,8 @@
 #include <common/net/message/control/AuthenticateChannelMsgEx.h>
 #include <common/net/message/control/GenericResponseMsg.h>
 #include <common/net/message/control/PeerInfoMsgEx.h>
+#include <common/net/message/control/SetChannelMultiplexedMsgEx.h>
+#include <common/net/message/control/SetChannelMultiplexedRespMsg.h>
 #include "control/AckMsgEx.h"
 #include "control/SetChannelDirectMsgEx.h"
 
@@ -38,17 +40,20 @@
 #include <common/net/message/storage/creating/UnlinkLocalFileRespMsg.h>
 #include <common/net/message/storage/listing/ListChunkDirIncrementalRespMsg.h>
 #include <common/net/message/storage/lookup/FindOwnerRespMsg.h>
+#include <common/net/message/storage/mirroring/GetChunkBlockDigestsRespMsg.h>
 #include <common/net/message/storage/mirroring/ResyncLocalFileRespMsg.h>
 #include <common/net/message/storage/mirroring/StorageResyncStartedRespMsg.h>
 #include <common/net/message/storage/quota/GetQuotaInfoMsg.h>
 #include <common/net/message/storage/quota/RequestExceededQuotaRespMsg.h>
 #include <common/net/message/storage/TruncLocalFileRespMsg.h>
 #include <common/net/message/storage/SetStorageTargetInfoRespMsg.h>
+#include <net/message/storage/attribs/GetChunkFileAttribsBatchMsgEx.h>
 #include <net/message/storage/attribs/GetChunkFileAttribsMsgEx.h>
 #include <net/message/storage/attribs/SetLocalAttrMsgEx.h>
 #include <net/message/storage/creating/RmChunkPathsMsgEx.h>
 #include <net/message/storage/creating/UnlinkLocalFileMsgEx.h>
 #include <net/message/storage/listing/ListChunkDirIncrementalMsgEx.h>
+#include <net/message/storage/mirroring/GetChunkBlockDigestsMsgEx.h>
 #include <net/message/storage/mirroring/GetStorageResyncStatsMsgEx.h>
 #include <net/message/storage/mirroring/ResyncLocalFileMsgEx.h>
 #include <net/message/storage/mirroring/SetLastBuddyCommOverrideMsgEx.h>
@@ -114,6 +119,8 @@ std::unique_ptr<NetMessage> NetMessageFactory::createFromMsgType(unsigned short
       case NETMSGTYPE_AuthenticateChannel: { msg = new AuthenticateChannelMsgEx(); } break;
       case NETMSGTYPE_GenericResponse: { msg = new GenericResponseMsg(); } break;
       case NETMSGTYPE_SetChannelDirect: { msg = new SetChannelDirectMsgEx(); } break;
+      case NETMSGTYPE_SetChannelMultiplexed: { msg = new SetChannelMultiplexedMsgEx(); } break;
+      case NETMSGTYPE_SetChannelMultiplexedResp: { msg = new SetChannelMultiplexedRespMsg(); } break;
       case NETMSGTYPE_PeerInfo: { msg = new PeerInfoMsgEx(); } break;
 
       // nodes messages
@@ -147,7 +154,10 @@ std::unique_ptr<NetMessage> NetMessageFactory::createFromMsgType(unsigned short
 
       // storage messages
       case NETMSGTYPE_FindOwnerResp: { msg = new FindOwnerRespMsg(); } break;
+      case NETMSGTYPE_GetChunkBlockDigests: { msg = new GetChunkBlockDigestsMsgEx(); } break;
+      case NETMSGTYPE_GetChunkBlockDigestsResp: { msg = new GetChunkBlockDigestsRespMsg(); } break;
       case NETMSGTYPE_GetChunkFileAttribs: { msg = new GetChunkFileAttribsMsgEx(); } break;
+      case NETMSGTYPE_GetChunkFileAttribsBatch: { msg = new GetChunkFileAttribsBatchMsgEx(); } break;
       case NETMSGTYPE_GetHighResStats: { msg = new GetHighResStatsMsgEx(); } break;
       case NETMSGTYPE_GetQuotaInfo: {msg = new GetQuotaInfoMsgEx(); } break;
       case NETMSGTYPE_GetStorageResyncStats: { msg = new GetStorageResyncStatsMsgEx(); } break;
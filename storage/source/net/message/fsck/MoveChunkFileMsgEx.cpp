@@ -82,7 +82,13 @@ unsigned MoveChunkFileMsgEx::moveChunk()
       return 1;
    }
    else if (getIsMirrored())
+   {
       target->setBuddyNeedsResync(true);
 
+      // the chunk was not moved on the secondary, so both paths must be synced completely
+      target->getDirtyChunkJournal().add(DirtyChunkJournal::RecordType_UNLINK, moveFrom, 0, 0);
+      target->getDirtyChunkJournal().add(DirtyChunkJournal::RecordType_UNLINK, moveTo, 0, 0);
+   }
+
    return 0;
 }
@@ -66,6 +66,20 @@ class ReadLocalFileRDMAMsgSender : public ReadLocalFileRDMAMsg
          return writeRes;
       }
 
+      /**
+       * Data is always written from the worker buffer to the remote buffer.
+       */
+      inline bool canSendFile(Socket* sock)
+      {
+         return false;
+      }
+
+      inline ssize_t readStateSendFile(Socket* sock, ReadState& rs, int fd, off_t offset,
+         bool isFinal)
+      {
+         return -1;
+      }
+
       inline ssize_t getReadLength(ReadState& rs, ssize_t len)
       {
          // Cannot RDMA anything larger than WORKER_BUFOUT_SIZE in a single operation
@@ -2,13 +2,14 @@
 #include <common/storage/StorageErrors.h>
 #include <common/toolkit/SessionTk.h>
 #include <net/msghelpers/MsgHelperIO.h>
+#include <storage/ChunkChecksums.h>
 #include <toolkit/StorageTkEx.h>
 #include "ReadLocalFileV2MsgEx.h"
 #ifdef BEEGFS_NVFS
 #include "ReadLocalFileRDMAMsgEx.h"
 #endif
-#include <sys/sendfile.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
 
 #define READ_USE_TUNEFILEREAD_TRIGGER   (4*1024*1024)  /* seq IO trigger for tuneFileReadSize */
 
@@ -196,6 +197,26 @@ release_session:
    return retVal;
 }
 
+/**
+ * Zero-copy counterpart of pread(): only determines how much of the requested data exists, so that
+ * the length info can be sent before the data.
+ *
+ * @return number of bytes that can be sent from the file at offset (less than len at the end of
+ *    the file) or -1 on error (errno is set).
+ */
+static ssize_t getSendFileLength(int fd, size_t len, off_t offset)
+{
+   struct stat statBuf;
+
+   if(fstat(fd, &statBuf) )
+      return -1;
+
+   if(statBuf.st_size <= offset)
+      return 0;
+
+   return BEEGFS_MIN( (off_t)len, statBuf.st_size - offset);
+}
+
 inline size_t ReadLocalFileV2MsgSender::getBuffers(ResponseContext& ctx, char** dataBuf, char** sendBuf)
 {
    *dataBuf = ctx.getBuffer() + READ_BUF_OFFSET; // offset for prepended data length info
@@ -279,12 +300,57 @@ int64_t ReadLocalFileMsgExBase<Msg, ReadState>::incrementalReadStatefulAndSendV2
       return -1;
    }
 
+   std::unique_ptr<ChunkChecksumVerifier> checksumVerifier;
+
+   if(cfg->getTuneChunkChecksums() &&
+      !isMsgHeaderFeatureFlagSet(READLOCALFILEMSG_FLAG_DISABLE_IO) )
+   {
+      checksumVerifier.reset(new ChunkChecksumVerifier(*fd, sessionLocalFile->getTargetID(),
+         sessionLocalFile->getFileID() ) );
+
+      if(!checksumVerifier->isActive() )
+         checksumVerifier.reset(); // chunk has no checksums
+   }
+
+   // send the data directly from the page cache if it doesn't need to pass through our buffer
+   const bool useSendFile = cfg->getTuneUseZeroCopyRead() && !checksumVerifier &&
+      !isMsgHeaderFeatureFlagSet(READLOCALFILEMSG_FLAG_DISABLE_IO) &&
+      !sessionLocalFile->getIsDirectIO() && canSendFile(ctx.getSocket() );
+
+   auto sendData = [&] (off_t dataOffset, bool isFinal) {
+      return useSendFile ?
+         readStateSendFile(ctx.getSocket(), readState, *fd, dataOffset, isFinal) :
+         readStateSendData(ctx.getSocket(), readState, sendBuf, isFinal);
+   };
+
    for( ; ; )
    {
       ssize_t readLength = getReadLength(readState, BEEGFS_MIN(maxReadAtOnceLen, readState.toBeRead));
+      const off_t dataOffset = readOffset;
 
-      readState.readRes = unlikely(isMsgHeaderFeatureFlagSet(READLOCALFILEMSG_FLAG_DISABLE_IO) ) ?
-         readLength : MsgHelperIO::pread(*fd, dataBuf, readLength, readOffset);
+      if(useSendFile)
+         readState.readRes = getSendFileLength(*fd, readLength, readOffset);
+      else
+         readState.readRes = unlikely(isMsgHeaderFeatureFlagSet(READLOCALFILEMSG_FLAG_DISABLE_IO) ) ?
+            readLength : MsgHelperIO::pread(*fd, dataBuf, readLength, readOffset);
+
+      size_t badBlockIndex;
+
+      // verify the data before it is sent (short read means end of file)
+      if(checksumVerifier && (readState.readRes > 0) &&
+         !checksumVerifier->verify(dataBuf, readOffset, readState.readRes,
+            readState.readRes != readLength, badBlockIndex) )
+      {
+         LogContext(logContext).logErr("Chunk file data does not match its checksum. "
+            "FileID: " + sessionLocalFile->getFileID() + "; "
+            "Target: " + StringTk::uintToStr(sessionLocalFile->getTargetID() ) + "; "
+            "Block offset: " +
+               StringTk::int64ToStr( (int64_t)badBlockIndex * CHUNKCHECKSUMS_BLOCK_SIZE) );
+
+         sessionLocalFile->setOffset(-1);
+         sendLengthInfo(ctx.getSocket(), -FhgfsOpsErr_REMOTEIO);
+         return -1;
+      }
 
       LOG_DEBUG(logContext, Log_SPAM,
          "toBeRead: " + StringTk::int64ToStr(readState.toBeRead) + "; "
@@ -306,7 +372,7 @@ int64_t ReadLocalFileMsgExBase<Msg, ReadState>::incrementalReadStatefulAndSendV2
 
          bool isFinal = !readState.toBeRead;
 
-         if (readStateSendData(ctx.getSocket(), readState, sendBuf, isFinal) < 0)
+         if (sendData(dataOffset, isFinal) < 0)
          {
             LogContext(logContext).logErr("readStateSendData failed.");
             sessionLocalFile->setOffset(-1);
@@ -364,7 +430,7 @@ int64_t ReadLocalFileMsgExBase<Msg, ReadState>::incrementalReadStatefulAndSendV2
 
             if(readState.readRes > 0)
             {
-               if (readStateSendData(ctx.getSocket(), readState, sendBuf, true) < 0)
+               if (sendData(dataOffset, true) < 0)
                {
                   LogContext(logContext).logErr("readStateSendData failed.");
                   sessionLocalFile->setOffset(-1);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <common/net/message/session/rw/ReadLocalFileV2Msg.h>
+#include <common/net/sock/StandardSocket.h>
 #include <common/storage/StorageErrors.h>
 #include <session/SessionLocalFileStore.h>
 
@@ -58,6 +59,17 @@ class ReadLocalFileMsgExBase : public Msg
          return static_cast<Msg&>(*this).readStateSendData(sock, rs, buf, isFinal);
       }
 
+      inline bool canSendFile(Socket* sock)
+      {
+         return static_cast<Msg&>(*this).canSendFile(sock);
+      }
+
+      inline ssize_t readStateSendFile(Socket* sock, ReadState& rs, int fd, off_t offset,
+         bool isFinal)
+      {
+         return static_cast<Msg&>(*this).readStateSendFile(sock, rs, fd, offset, isFinal);
+      }
+
       inline bool readStateNext(ReadState& rs)
       {
          return static_cast<Msg&>(*this).readStateNext(rs);
@@ -195,6 +207,37 @@ class ReadLocalFileV2MsgSender : public ReadLocalFileV2Msg
          return sendRes;
       }
 
+      /**
+       * @return true if readStateSendFile() can be used for this connection.
+       */
+      inline bool canSendFile(Socket* sock)
+      {
+         return (sock->getSockType() == NICADDRTYPE_STANDARD) &&
+            !sock->getIsMultiplexedRequest();
+      }
+
+      /**
+       * Send length information and the corresponding data directly from the file (zero-copy
+       * version of readStateSendData() ).
+       *
+       * @param rs.readRes must not be negative and the file must contain that much data at offset
+       * @param offset file offset of the data
+       * @param isFinal true if this is the last send, i.e. we have read all data
+       */
+      inline ssize_t readStateSendFile(Socket* sock, ReadState& rs, int fd, off_t offset,
+         bool isFinal)
+      {
+         int64_t lengthInfo = HOST_TO_LE_64(rs.readRes);
+         sock->send(&lengthInfo, sizeof(int64_t), MSG_MORE);
+
+         ssize_t sendRes = static_cast<StandardSocket*>(sock)->sendfile(fd, offset, rs.readRes);
+
+         if (isFinal)
+            sendLengthInfo(sock, 0);
+
+         return sendRes;
+      }
+
       /**
        * No-op for this implementation.
        */
@@ -2,7 +2,9 @@
 #include <common/toolkit/MessagingTk.h>
 #include <common/toolkit/SessionTk.h>
 #include <common/toolkit/StorageTk.h>
+#include <net/msghelpers/AsyncFileWriter.h>
 #include <net/msghelpers/MsgHelperIO.h>
+#include <storage/ChunkChecksums.h>
 #include <storage/StorageTargets.h>
 #include <toolkit/StorageTkEx.h>
 #include "WriteLocalFileMsgEx.h"
@@ -74,6 +76,10 @@ std::pair<bool, int64_t> WriteLocalFileMsgExBase<Msg, WriteState>::write(NetMess
    ChunkLockStore* chunkLockStore = app->getChunkLockStore();
    bool chunkLocked = false;
 
+   const bool useChecksums = app->getConfig()->getTuneChunkChecksums() &&
+      !isMsgHeaderFeatureFlagSet(WRITELOCALFILEMSG_FLAG_DISABLE_IO);
+   std::unique_ptr<ChunkChecksumWriter> checksumWriter;
+
    // select the right targetID
 
    uint16_t targetID = getTargetID();
@@ -200,9 +206,22 @@ std::pair<bool, int64_t> WriteLocalFileMsgExBase<Msg, WriteState>::write(NetMess
       }
 
 
+      if(useChecksums)
+      { // (the checksum writer locks the chunk itself, unless it's locked for the whole write)
+         checksumWriter.reset(new ChunkChecksumWriter(chunkLocked ? NULL : chunkLockStore,
+            targetID, sessionLocalFile->getFileID(), *sessionLocalFile->getFD(), getOffset(),
+            getCount() ) );
+
+         checksumWriter->begin();
+      }
+
       // the actual write workhorse
 
-      int64_t writeLocalRes = incrementalRecvAndWriteStateful(ctx, sessionLocalFile.get());
+      int64_t writeLocalRes = incrementalRecvAndWriteStateful(ctx, sessionLocalFile.get(),
+         checksumWriter.get() );
+
+      if(checksumWriter)
+         checksumWriter->finish(writeLocalRes == getCount() );
 
       // update client result, offset etc.
 
@@ -232,8 +251,14 @@ std::pair<bool, int64_t> WriteLocalFileMsgExBase<Msg, WriteState>::write(NetMess
 
       sessionLocalFile->setOffset(-1); // invalidate offset
 
+      if(checksumWriter)
+         checksumWriter->finish(false); // we don't know how much was written
+
       finishMirroring(sessionLocalFile.get(), *target);
 
+      if(isMirrorSession)
+         recordDirtyRange(sessionLocalFile.get(), *target);
+
       if (chunkLocked)
       {
          std::string chunkID = sessionLocalFile->getFileID();
@@ -247,6 +272,9 @@ std::pair<bool, int64_t> WriteLocalFileMsgExBase<Msg, WriteState>::write(NetMess
 cleanup:
    finishMirroringRes = finishMirroring(sessionLocalFile.get(), *target);
 
+   if(isMirrorSession)
+      recordDirtyRange(sessionLocalFile.get(), *target);
+
    // check mirroring result (don't overwrite local error code, if any)
    if(likely(writeClientRes > 0) )
    { // no local error => check mirroring result
@@ -298,7 +326,7 @@ ssize_t WriteLocalFileRDMAMsgSender::recvPadding(ResponseContext& ctx, int64_t t
  */
 template <class Msg, typename WriteState>
 int64_t WriteLocalFileMsgExBase<Msg, WriteState>::incrementalRecvAndWriteStateful(NetMessage::ResponseContext& ctx,
-   SessionLocalFile* sessionLocalFile)
+   SessionLocalFile* sessionLocalFile, ChunkChecksumWriter* checksumWriter)
 {
    std::string logContext = Msg::logContextPref + " (write incremental)";
    Config* cfg = Program::getApp()->getConfig();
@@ -314,6 +342,7 @@ int64_t WriteLocalFileMsgExBase<Msg, WriteState>::incrementalRecvAndWriteStatefu
    int64_t oldOffset = sessionLocalFile->getOffset();
    int64_t newOffset = getOffset();
    bool useSyncRange = false; // true if sync_file_range should be called
+   bool usedPipeline = false; // true if the data was written by the AsyncFileWriter
 
    if( (oldOffset < 0) || (oldOffset != newOffset) )
       sessionLocalFile->resetWriteCounter(); // reset sequential write counter
@@ -336,82 +365,107 @@ int64_t WriteLocalFileMsgExBase<Msg, WriteState>::incrementalRecvAndWriteStatefu
    if (!writeStateInit(writeState))
       return -FhgfsOpsErr_COMMUNICATION;
 
-   do
-   {
-      // receive some bytes...
+   writeState.recvBuf = ctx.getBuffer();
+   writeState.checksumWriter = checksumWriter;
 
-      LOG_DEBUG(logContext, Log_SPAM,
-         "receiving... (remaining: " + StringTk::intToStr(writeState.toBeReceived) + ")");
+   // overlap recv and write if the worker buffer has room for multiple write buffers
 
-      ssize_t recvRes = writeStateRecvData(ctx, writeState);
-      if (recvRes < 0)
+   const unsigned numPipelineBufs = BEEGFS_MIN(
+      BEEGFS_MIN(cfg->getTuneFileWritePipelineDepth(), (unsigned)WRITEMSG_PIPELINE_MAX_DEPTH),
+      ctx.getBufferLength() / exactStaticRecvSize);
+
+   if (Msg::supportsPipelinedWrite && (numPipelineBufs > 1) &&
+      (getCount() > exactStaticRecvSize) &&
+      !isMsgHeaderFeatureFlagSet(WRITELOCALFILEMSG_FLAG_DISABLE_IO) )
+   {
+      usedPipeline = true;
+
+      int64_t pipelinedRes = incrementalRecvAndWritePipelined(ctx, writeState, numPipelineBufs);
+      if (pipelinedRes != getCount() )
+         return pipelinedRes;
+   }
+   else
+   {
+      do
       {
-         LogContext(logContext).log(Log_WARNING, "Socket data transfer error occurred. ");
-         return -FhgfsOpsErr_COMMUNICATION;
-      }
+         // receive some bytes...
 
-      // forward to mirror...
+         LOG_DEBUG(logContext, Log_SPAM,
+            "receiving... (remaining: " + StringTk::intToStr(writeState.toBeReceived) + ")");
 
-      FhgfsOpsErr mirrorRes = sendToMirror(ctx.getBuffer(), recvRes,
-         writeState.writeOffset, writeState.toBeReceived, sessionLocalFile);
-      if(unlikely(mirrorRes != FhgfsOpsErr_SUCCESS) )
-      { // mirroring failed
-         incrementalRecvPadding(ctx, writeState.toBeReceived, sessionLocalFile);
+         ssize_t recvRes = writeStateRecvData(ctx, writeState);
+         if (recvRes < 0)
+         {
+            LogContext(logContext).log(Log_WARNING, "Socket data transfer error occurred. ");
+            return -FhgfsOpsErr_COMMUNICATION;
+         }
 
-         return -FhgfsOpsErr_COMMUNICATION;
-      }
+         // forward to mirror...
 
-      // write to underlying file system...
+         FhgfsOpsErr mirrorRes = sendToMirror(ctx.getBuffer(), recvRes,
+            writeState.writeOffset, writeState.toBeReceived, sessionLocalFile);
+         if(unlikely(mirrorRes != FhgfsOpsErr_SUCCESS) )
+         { // mirroring failed
+            incrementalRecvPadding(ctx, writeState.toBeReceived, sessionLocalFile);
 
-      int errCode = 0;
-      ssize_t writeRes = unlikely(isMsgHeaderFeatureFlagSet(WRITELOCALFILEMSG_FLAG_DISABLE_IO) )
-         ? recvRes
-         : doWrite(*fd, ctx.getBuffer(), recvRes, writeState.writeOffset, errCode);
+            return -FhgfsOpsErr_COMMUNICATION;
+         }
 
-      writeState.toBeReceived -= recvRes;
+         // write to underlying file system...
 
-      // handle write errors...
+         int errCode = 0;
+         ssize_t writeRes = unlikely(isMsgHeaderFeatureFlagSet(WRITELOCALFILEMSG_FLAG_DISABLE_IO) )
+            ? recvRes
+            : doWrite(*fd, ctx.getBuffer(), recvRes, writeState.writeOffset, errCode);
 
-      if(unlikely(writeRes != recvRes) )
-      { // didn't write all of the received data
+         writeState.toBeReceived -= recvRes;
 
-         if(writeRes == -1)
-         { // write error occurred
-            LogContext(logContext).log(Log_WARNING, "Write error occurred. "
-               "FileHandleID: " + sessionLocalFile->getFileHandleID() + "."
-               "Target: " + StringTk::uintToStr(sessionLocalFile->getTargetID() ) + ". "
-               "File: " + sessionLocalFile->getFileID() + ". "
-               "SysErr: " + System::getErrString(errCode) );
-            LogContext(logContext).log(Log_NOTICE, std::string("Additional info: "
-               "FD: ") + StringTk::intToStr(*fd) + " " +
-               "OpenFlags: " + StringTk::intToStr(sessionLocalFile->getOpenFlags() ) + " " +
-               "received: " + StringTk::intToStr(recvRes) + ".");
+         // handle write errors...
 
-            incrementalRecvPadding(ctx, writeState.toBeReceived, sessionLocalFile);
+         if(unlikely(writeRes != recvRes) )
+         { // didn't write all of the received data
 
-            return -FhgfsOpsErrTk::fromSysErr(errCode);
-         }
-         else
-         { // wrote only a part of the data, not all of it
-            LogContext(logContext).log(Log_WARNING,
-               "Unable to write all of the received data. "
-               "target: " + StringTk::uintToStr(sessionLocalFile->getTargetID() ) + "; "
-               "file: " + sessionLocalFile->getFileID() + "; "
-               "sysErr: " + System::getErrString(errCode) );
+            if(writeRes == -1)
+            { // write error occurred
+               LogContext(logContext).log(Log_WARNING, "Write error occurred. "
+                  "FileHandleID: " + sessionLocalFile->getFileHandleID() + "."
+                  "Target: " + StringTk::uintToStr(sessionLocalFile->getTargetID() ) + ". "
+                  "File: " + sessionLocalFile->getFileID() + ". "
+                  "SysErr: " + System::getErrString(errCode) );
+               LogContext(logContext).log(Log_NOTICE, std::string("Additional info: "
+                  "FD: ") + StringTk::intToStr(*fd) + " " +
+                  "OpenFlags: " + StringTk::intToStr(sessionLocalFile->getOpenFlags() ) + " " +
+                  "received: " + StringTk::intToStr(recvRes) + ".");
 
-            incrementalRecvPadding(ctx, writeState.toBeReceived, sessionLocalFile);
+               incrementalRecvPadding(ctx, writeState.toBeReceived, sessionLocalFile);
+
+               return -FhgfsOpsErrTk::fromSysErr(errCode);
+            }
+            else
+            { // wrote only a part of the data, not all of it
+               LogContext(logContext).log(Log_WARNING,
+                  "Unable to write all of the received data. "
+                  "target: " + StringTk::uintToStr(sessionLocalFile->getTargetID() ) + "; "
+                  "file: " + sessionLocalFile->getFileID() + "; "
+                  "sysErr: " + System::getErrString(errCode) );
+
+               incrementalRecvPadding(ctx, writeState.toBeReceived, sessionLocalFile);
+
+               // return bytes received so far minus num bytes that were not written with last write
+               return (getCount() - writeState.toBeReceived) - (recvRes - writeRes);
+            }
 
-            // return bytes received so far minus num bytes that were not written with last write
-            return (getCount() - writeState.toBeReceived) - (recvRes - writeRes);
          }
 
-      }
+         if (writeState.checksumWriter)
+            writeState.checksumWriter->update(ctx.getBuffer(), writeRes);
 
-      writeState.writeOffset += writeRes;
-      recvRes = writeStateNext(writeState, writeRes);
-      if (recvRes != 0)
-         return recvRes;
-   } while(writeState.toBeReceived);
+         writeState.writeOffset += writeRes;
+         recvRes = writeStateNext(writeState, writeRes);
+         if (recvRes != 0)
+            return recvRes;
+      } while(writeState.toBeReceived);
+   }
 
    LOG_DEBUG(logContext, Log_SPAM,
       std::string("Received and wrote all the data") );
@@ -428,13 +482,171 @@ int64_t WriteLocalFileMsgExBase<Msg, WriteState>::incrementalRecvAndWriteStatefu
       off64_t syncSize = sessionLocalFile->getWriteCounter();
       off64_t syncOffset = getOffset() + getCount() - syncSize;
 
-      MsgHelperIO::syncFileRange(*fd, syncOffset, syncSize);
+      if (usedPipeline) // (the io_uring backend submits this without waiting for it)
+         AsyncFileWriter::getThreadInstance(ctx.getBuffer(), ctx.getBufferLength() )->
+            syncFileRange(*fd, syncOffset, syncSize);
+      else
+         MsgHelperIO::syncFileRange(*fd, syncOffset, syncSize);
       sessionLocalFile->resetWriteCounter();
    }
 
    return getCount();
 }
 
+/**
+ * Pipelined variant of the recv/write loop in incrementalRecvAndWriteStateful(): The worker
+ * buffer is split into numBufs buffers and each received buffer is written by the AsyncFileWriter
+ * of this worker, while the next buffer is already being received.
+ *
+ * Mirror forwarding and error handling are the same as in the synchronous loop, but a write error
+ * is only noticed when the buffer is about to be reused (or at the end), so more data might have
+ * been received and written behind the failed write. All outstanding writes are completed before
+ * this returns.
+ *
+ * @return number of written bytes (getCount() if everything was written) or negative fhgfs error
+ * code
+ */
+template <class Msg, typename WriteState>
+int64_t WriteLocalFileMsgExBase<Msg, WriteState>::incrementalRecvAndWritePipelined(
+   NetMessage::ResponseContext& ctx, WriteState& writeState, unsigned numBufs)
+{
+   const char* logContext = writeState.logContext;
+   SessionLocalFile* sessionLocalFile = writeState.sessionLocalFile;
+   auto& fd = sessionLocalFile->getFD();
+
+   AsyncFileWriter* writer =
+      AsyncFileWriter::getThreadInstance(ctx.getBuffer(), ctx.getBufferLength() );
+   AsyncFileWriter::Request requests[WRITEMSG_PIPELINE_MAX_DEPTH];
+   unsigned numSubmitted = 0;
+   unsigned numCompleted = 0;
+
+   int64_t retVal = getCount(); // set to the result of the first failure
+   bool recvFailed = false;
+
+   /* the writer still references the requests and buffers of submitted writes, so wait for them
+      before leaving this scope, also when the recv or mirroring throws (errors of the drained
+      writes don't matter in that case, the caller handles the exception) */
+   struct DrainOnExit
+   {
+      AsyncFileWriter* writer;
+      AsyncFileWriter::Request* requests;
+      const unsigned& numSubmitted;
+      unsigned& numCompleted;
+      unsigned numBufs;
+
+      ~DrainOnExit()
+      {
+         while (numCompleted != numSubmitted)
+            writer->waitForCompletion(requests[numCompleted++ % numBufs]);
+      }
+   } drainOnExit = {writer, requests, numSubmitted, numCompleted, numBufs};
+
+   // wait for the oldest outstanding write and check its result (if nothing failed before)
+   auto completeOldestWrite = [&] ()
+   {
+      AsyncFileWriter::Request& request = requests[numCompleted % numBufs];
+
+      writer->waitForCompletion(request);
+      numCompleted++;
+
+      if (likely(request.writeRes == (ssize_t)request.count) || (retVal != getCount() ) )
+         return;
+
+      if (request.writeRes == -1)
+      { // write error occurred
+         LogContext(logContext).log(Log_WARNING, "Write error occurred. "
+            "FileHandleID: " + sessionLocalFile->getFileHandleID() + "."
+            "Target: " + StringTk::uintToStr(sessionLocalFile->getTargetID() ) + ". "
+            "File: " + sessionLocalFile->getFileID() + ". "
+            "SysErr: " + System::getErrString(request.errCode) );
+         LogContext(logContext).log(Log_NOTICE, std::string("Additional info: "
+            "FD: ") + StringTk::intToStr(*fd) + " " +
+            "OpenFlags: " + StringTk::intToStr(sessionLocalFile->getOpenFlags() ) + " " +
+            "received: " + StringTk::intToStr(request.count) + ".");
+
+         retVal = -FhgfsOpsErrTk::fromSysErr(request.errCode);
+      }
+      else
+      { // wrote only a part of the data, not all of it
+         LogContext(logContext).log(Log_WARNING,
+            "Unable to write all of the received data. "
+            "target: " + StringTk::uintToStr(sessionLocalFile->getTargetID() ) + "; "
+            "file: " + sessionLocalFile->getFileID() + "; "
+            "sysErr: " + System::getErrString(request.errCode) );
+
+         // bytes before the failed write plus num bytes that were written with it
+         retVal = (request.offset - getOffset() ) + request.writeRes;
+      }
+   };
+
+   do
+   {
+      if (numSubmitted - numCompleted == numBufs)
+         completeOldestWrite(); // buffer is needed for the next recv
+
+      if (unlikely(retVal != getCount() ) )
+         break; // write failed
+
+      char* buf = ctx.getBuffer() + (numSubmitted % numBufs) * writeState.exactStaticRecvSize;
+
+      // receive some bytes...
+
+      LOG_DEBUG(logContext, Log_SPAM,
+         "receiving... (remaining: " + StringTk::intToStr(writeState.toBeReceived) + ")");
+
+      writeState.recvBuf = buf;
+
+      ssize_t recvRes = writeStateRecvData(ctx, writeState);
+      if (recvRes < 0)
+      {
+         LogContext(logContext).log(Log_WARNING, "Socket data transfer error occurred. ");
+         retVal = -FhgfsOpsErr_COMMUNICATION;
+         recvFailed = true;
+         break;
+      }
+
+      // forward to mirror...
+
+      FhgfsOpsErr mirrorRes = sendToMirror(buf, recvRes,
+         writeState.writeOffset, writeState.toBeReceived, sessionLocalFile);
+      if(unlikely(mirrorRes != FhgfsOpsErr_SUCCESS) )
+      { // mirroring failed
+         retVal = -FhgfsOpsErr_COMMUNICATION;
+         break;
+      }
+
+      // write to underlying file system in the background...
+
+      AsyncFileWriter::Request& request = requests[numSubmitted % numBufs];
+
+      request.fd = *fd;
+      request.buf = buf;
+      request.count = recvRes;
+      request.offset = writeState.writeOffset;
+
+      writer->submit(request);
+      numSubmitted++;
+
+      // (the buffer is not modified by the write, so we can compute its checksums meanwhile)
+      if (writeState.checksumWriter)
+         writeState.checksumWriter->update(buf, recvRes);
+
+      writeState.toBeReceived -= recvRes;
+      writeState.writeOffset += recvRes;
+
+      // (note: writeStateNext() is a no-op for protocols that support pipelined writes)
+   } while(writeState.toBeReceived);
+
+   while (numCompleted != numSubmitted)
+      completeOldestWrite();
+
+   // receive the rest of the data (the buffers are not in use anymore)
+   if (unlikely(retVal != getCount() ) && !recvFailed)
+      incrementalRecvPadding(ctx, writeState.toBeReceived, sessionLocalFile);
+
+   return retVal;
+}
+
 /**
  * Write until everything was written (handle short-writes) or an error occured
  */
@@ -918,6 +1130,27 @@ cleanup_commerr:
    return FhgfsOpsErr_COMMUNICATION;
 }
 
+/**
+ * Record the range of this write in the dirty chunk journal (if the buddy needs a resync or might
+ * need one later).
+ *
+ * Note: Must be called after finishMirroring(), which might have set the buddy to needs-resync.
+ */
+template <class Msg, typename WriteState>
+void WriteLocalFileMsgExBase<Msg, WriteState>::recordDirtyRange(SessionLocalFile* sessionLocalFile,
+   StorageTarget& target)
+{
+   DirtyChunkJournal& journal = target.getDirtyChunkJournal();
+
+   if(!journal.isActive() ||
+      isMsgHeaderFeatureFlagSet(WRITELOCALFILEMSG_FLAG_BUDDYMIRROR_SECOND) )
+      return;
+
+   journal.add(DirtyChunkJournal::RecordType_WRITE,
+      StorageTk::getFileChunkPath(getPathInfo(), sessionLocalFile->getFileID() ),
+      getOffset(), getCount() );
+}
+
 template <class Msg, typename WriteState>
 bool WriteLocalFileMsgExBase<Msg, WriteState>::doSessionCheck()
 { // do session check only when it is not a mirror session
@@ -7,7 +7,9 @@
 
 
 #define WRITEMSG_MIRROR_RETRIES_NUM    1
+#define WRITEMSG_PIPELINE_MAX_DEPTH    8 /* max number of buffers for pipelined recv and write */
 
+class ChunkChecksumWriter;
 class StorageTarget;
 
 /**
@@ -22,6 +24,8 @@ struct WriteStateBase
    int64_t toBeReceived;
    off_t writeOffset;
    SessionLocalFile* sessionLocalFile;
+   char* recvBuf; // buffer for the next writeStateRecvData() call
+   ChunkChecksumWriter* checksumWriter; // NULL if chunk checksums are disabled
 
    WriteStateBase(const char* logContext, ssize_t exactStaticRecvSize,
       int64_t toBeReceived, off_t writeOffset, SessionLocalFile* sessionLocalFile)
@@ -31,6 +35,8 @@ struct WriteStateBase
       this->toBeReceived = toBeReceived;
       this->writeOffset = writeOffset;
       this->sessionLocalFile = sessionLocalFile;
+      this->recvBuf = NULL;
+      this->checksumWriter = NULL;
       recvLength = BEEGFS_MIN(exactStaticRecvSize, toBeReceived);
    }
 
@@ -66,11 +72,14 @@ class WriteLocalFileMsgExBase : public Msg
       FhgfsOpsErr sendToMirror(const char* buf, size_t bufLen, int64_t offset, int64_t toBeMirrored,
          SessionLocalFile* sessionLocalFile);
       FhgfsOpsErr finishMirroring(SessionLocalFile* sessionLocalFile, StorageTarget& target);
+      void recordDirtyRange(SessionLocalFile* sessionLocalFile, StorageTarget& target);
 
       bool doSessionCheck();
 
       int64_t incrementalRecvAndWriteStateful(NetMessage::ResponseContext& ctx,
-         SessionLocalFile* sessionLocalFile);
+         SessionLocalFile* sessionLocalFile, ChunkChecksumWriter* checksumWriter);
+      int64_t incrementalRecvAndWritePipelined(NetMessage::ResponseContext& ctx,
+         WriteState& writeState, unsigned numBufs);
 
       void incrementalRecvPadding(NetMessage::ResponseContext& ctx, int64_t padLen,
          SessionLocalFile* sessionLocalFile);
@@ -181,6 +190,9 @@ class WriteLocalFileMsgSender : public WriteLocalFileMsg
 
       static const std::string logContextPref;
 
+      // received data can be written in the background (see incrementalRecvAndWritePipelined)
+      static const bool supportsPipelinedWrite = true;
+
       ssize_t recvPadding(ResponseContext& ctx, int64_t toBeReceived);
 
       inline void sendResponse(ResponseContext& ctx, int err)
@@ -198,7 +210,7 @@ class WriteLocalFileMsgSender : public WriteLocalFileMsg
          AbstractApp* app = PThread::getCurrentThreadApp();
          int connMsgMediumTimeout = app->getCommonConfig()->getConnMsgMediumTimeout();
          ws.recvLength = BEEGFS_MIN(ws.exactStaticRecvSize, ws.toBeReceived);
-         return ctx.getSocket()->recvExactT(ctx.getBuffer(), ws.recvLength, 0, connMsgMediumTimeout);
+         return ctx.getSocket()->recvExactT(ws.recvBuf, ws.recvLength, 0, connMsgMediumTimeout);
       }
 
       inline size_t writeStateNext(WriteState& ws, ssize_t writeRes)
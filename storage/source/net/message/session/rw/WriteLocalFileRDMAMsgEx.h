@@ -37,6 +37,9 @@ class WriteLocalFileRDMAMsgSender : public WriteLocalFileRDMAMsg
 
       static const std::string logContextPref;
 
+      // writeStateNext() needs the result of each write before the next recv
+      static const bool supportsPipelinedWrite = false;
+
       ssize_t recvPadding(ResponseContext& ctx, int64_t toBeReceived);
 
       inline void sendResponse(ResponseContext& ctx, int err)
@@ -65,7 +68,7 @@ class WriteLocalFileRDMAMsgSender : public WriteLocalFileRDMAMsg
                BEEGFS_MIN(ws.exactStaticRecvSize, ws.toBeReceived),
                (ssize_t)(ws.rLen - ws.rOff)),
             WORKER_BUFIN_SIZE);
-         return ctx.getSocket()->read(ctx.getBuffer(), ws.recvLength, 0, ws.rBuf + ws.rOff, ws.rdma->key);
+         return ctx.getSocket()->read(ws.recvBuf, ws.recvLength, 0, ws.rBuf + ws.rOff, ws.rdma->key);
       }
 
       inline size_t writeStateNext(WriteState& ws, ssize_t writeRes)
@@ -2,6 +2,7 @@
 #include <common/net/message/storage/TruncLocalFileRespMsg.h>
 #include <net/msghelpers/MsgHelperIO.h>
 #include <program/Program.h>
+#include <storage/ChunkChecksums.h>
 #include <toolkit/StorageTkEx.h>
 #include "TruncLocalFileMsgEx.h"
 
@@ -103,7 +104,13 @@ bool TruncLocalFileMsgEx::processIncoming(ResponseContext& ctx)
       // truncate file...
 
       clientErrRes = truncFile(targetID, targetFD, &chunkDirPath, chunkFilePathStr, entryID,
-         hasOrigFeature);
+         hasOrigFeature, chunkLocked);
+
+      if(isMsgHeaderFeatureFlagSet(TRUNCLOCALFILEMSG_FLAG_BUDDYMIRROR) &&
+         !isMsgHeaderFeatureFlagSet(TRUNCLOCALFILEMSG_FLAG_BUDDYMIRROR_SECOND) &&
+         target->getDirtyChunkJournal().isActive() )
+         target->getDirtyChunkJournal().add(DirtyChunkJournal::RecordType_TRUNC,
+            chunkFilePathStr, getFilesize(), 0);
 
       /* clientErrRes == FhgfsOpsErr_PATHNOTEXISTS && !getFileSize() is special we need to fake
        * the attributes, to inform the metaserver about the new file size with storageVersion!=0 */
@@ -186,16 +193,46 @@ int TruncLocalFileMsgEx::getTargetFD(const StorageTarget& target, ResponseContex
    return targetFD;
 }
 
+/**
+ * @param chunkLocked true if the caller already holds the chunk lock (e.g. during buddy resync).
+ */
 FhgfsOpsErr TruncLocalFileMsgEx::truncFile(uint16_t targetId, int targetFD,
    const Path* chunkDirPath, const std::string& chunkFilePathStr, std::string entryID,
-   bool hasOrigFeature)
+   bool hasOrigFeature, bool chunkLocked)
 {
    const char* logContext = "TruncLocalFileMsg incoming";
    App* app = Program::getApp();
 
    FhgfsOpsErr clientErrRes = FhgfsOpsErr_SUCCESS;
 
-   int truncRes = MsgHelperIO::truncateAt(targetFD, chunkFilePathStr.c_str(), getFilesize() );
+   int truncRes;
+
+   if(app->getConfig()->getTuneChunkChecksums() )
+   { // drop the checksums of the truncated blocks (locked against concurrent checksum updates)
+      ChunkLockStore* chunkLockStore = app->getChunkLockStore();
+
+      if(!chunkLocked)
+         chunkLockStore->lockChunk(targetId, entryID);
+
+      truncRes = MsgHelperIO::truncateAt(targetFD, chunkFilePathStr.c_str(), getFilesize() );
+      if(!truncRes)
+      {
+         int fd = MsgHelperIO::openat(targetFD, chunkFilePathStr.c_str(), O_RDONLY, 0);
+         if(fd != -1)
+         {
+            ChunkChecksums::truncate(fd, getFilesize() );
+            MsgHelperIO::close(fd);
+         }
+
+         ChunkChecksumWriter::truncateActiveWrites(targetId, entryID, getFilesize() );
+      }
+
+      if(!chunkLocked)
+         chunkLockStore->unlockChunk(targetId, entryID);
+   }
+   else
+      truncRes = MsgHelperIO::truncateAt(targetFD, chunkFilePathStr.c_str(), getFilesize() );
+
    if(!truncRes)
       return FhgfsOpsErr_SUCCESS; // truncate succeeded
 
@@ -26,7 +26,8 @@ class TruncLocalFileMsgEx : public TruncLocalFileMsg
 
    private:
       FhgfsOpsErr truncFile(uint16_t targetId, int targetFD, const Path* chunkDirPath,
-         const std::string& chunkFilePathStr, std::string entryID, bool hasOrigFeature);
+         const std::string& chunkFilePathStr, std::string entryID, bool hasOrigFeature,
+         bool chunkLocked);
       int getTargetFD(const StorageTarget& target, ResponseContext& ctx, bool* outResponseSent);
       bool getDynamicAttribsByPath(const int dirFD, const char* path, uint16_t targetID,
          std::string fileID, DynamicAttribs& outDynAttribs);
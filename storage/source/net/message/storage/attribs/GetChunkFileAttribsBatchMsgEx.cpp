@@ -0,0 +1,135 @@
+#include <common/net/message/control/GenericResponseMsg.h>
+#include <common/net/message/storage/attribs/GetChunkFileAttribsBatchRespMsg.h>
+#include <program/Program.h>
+#include <toolkit/StorageTkEx.h>
+#include "GetChunkFileAttribsBatchMsgEx.h"
+
+
+bool GetChunkFileAttribsBatchMsgEx::processIncoming(ResponseContext& ctx)
+{
+   const char* logContext = "GetChunkFileAttribsBatchMsg incoming";
+
+   App* app = Program::getApp();
+   SyncedStoragePaths* syncedPaths = app->getSyncedStoragePaths();
+
+   const bool isBuddyMirrorChunk =
+      isMsgHeaderFeatureFlagSet(GETCHUNKFILEATTRSBATCHMSG_FLAG_BUDDYMIRROR);
+
+   EntryVec& entries = getEntries();
+
+   GetChunkFileAttribsBatchRespMsg::EntryVec respEntries(entries.size() );
+
+   FhgfsOpsErr clientErrRes = FhgfsOpsErr_SUCCESS;
+   int targetFD;
+
+   // select the right targetID
+
+   uint16_t targetID = getTargetID();
+
+   if(isBuddyMirrorChunk)
+   { // given targetID refers to a buddy mirror group
+      MirrorBuddyGroupMapper* mirrorBuddies = app->getMirrorBuddyGroupMapper();
+
+      targetID = isMsgHeaderFeatureFlagSet(GETCHUNKFILEATTRSBATCHMSG_FLAG_BUDDYMIRROR_SECOND) ?
+         mirrorBuddies->getSecondaryTargetID(targetID) :
+         mirrorBuddies->getPrimaryTargetID(targetID);
+
+      // note: only log message here, error handling will happen below through unknown target
+      if(unlikely(!targetID) )
+         LogContext(logContext).logErr("Invalid mirror buddy group ID: " +
+            StringTk::uintToStr(getTargetID() ) );
+   }
+
+   auto* const target = app->getStorageTargets()->getTarget(targetID);
+   if (!target)
+   {
+      if (isBuddyMirrorChunk)
+      { /* buddy mirrored file => fail with GenericResp to make the caller retry.
+           mgmt will mark this target as (p)offline in a few moments. */
+         LOG(GENERAL, NOTICE, "Unknown target ID, refusing request.", targetID);
+         ctx.sendResponse(
+               GenericResponseMsg(GenericRespMsgCode_INDIRECTCOMMERR, "Unknown target ID"));
+         goto update_stats;
+      }
+
+      LOG(GENERAL, ERR, "Unknown target ID.", targetID);
+      clientErrRes = FhgfsOpsErr_UNKNOWNTARGET;
+      goto send_response;
+   }
+
+   if(unlikely(target->getConsistencyState() != TargetConsistencyState_GOOD) &&
+      isBuddyMirrorChunk &&
+      !isMsgHeaderFeatureFlagSet(GETCHUNKFILEATTRSBATCHMSG_FLAG_BUDDYMIRROR_SECOND) )
+   { // this is a msg to a non-good primary
+      std::string respMsgLogStr = "Refusing request. Target consistency is not good. "
+         "targetID: " + StringTk::uintToStr(target->getID() );
+
+      ctx.sendResponse(
+            GenericResponseMsg(GenericRespMsgCode_INDIRECTCOMMERR, std::move(respMsgLogStr) ) );
+      goto update_stats;
+   }
+
+   targetFD = isBuddyMirrorChunk ? *target->getMirrorFD() : *target->getChunkFD();
+
+   // stat all chunk files relative to the pre-opened chunks (or mirror) dir of the target
+
+   for(size_t i = 0; i < entries.size(); i++)
+   {
+      const std::string& entryID = entries[i].entryID;
+      GetChunkFileAttribsBatchRespMsg::Entry& respEntry = respEntries[i];
+
+      std::string chunkPath = StorageTk::getFileChunkPath(&entries[i].pathInfo, entryID);
+      struct stat statbuf;
+
+      uint64_t newStorageVersion = syncedPaths->lockPath(entryID, targetID); // L O C K path
+
+      int statRes = fstatat(targetFD, chunkPath.c_str(), &statbuf, 0);
+      int statErrCode = statRes ? errno : 0;
+
+      syncedPaths->unlockPath(entryID, targetID); // U N L O C K path
+
+      respEntry.result = FhgfsOpsErr_SUCCESS;
+
+      if(!statRes)
+      {
+         respEntry.attribs = DynamicFileAttribs(newStorageVersion, statbuf.st_size,
+            statbuf.st_blocks, statbuf.st_mtime, statbuf.st_atime);
+         continue;
+      }
+
+      // note: non-existing file is not an error (storage version is 0, so nothing will be
+      //    updated at the metadata node)
+
+      respEntry.attribs = DynamicFileAttribs(0, 0, 0, 0, 0);
+
+      if(statErrCode != ENOENT)
+      { // error
+         respEntry.result = FhgfsOpsErr_INTERNAL;
+
+         LogContext(logContext).logErr(
+            "Unable to stat file: " + chunkPath + ". " + "SysErr: "
+               + System::getErrString(statErrCode) );
+      }
+   }
+
+send_response:
+   if(clientErrRes != FhgfsOpsErr_SUCCESS)
+   {
+      for(size_t i = 0; i < respEntries.size(); i++)
+      {
+         respEntries[i].result = clientErrRes;
+         respEntries[i].attribs = DynamicFileAttribs(0, 0, 0, 0, 0);
+      }
+   }
+
+   ctx.sendResponse(GetChunkFileAttribsBatchRespMsg(&respEntries) );
+
+update_stats:
+
+   for(size_t i = 0; i < entries.size(); i++)
+      app->getNodeOpStats()->updateNodeOp(ctx.getSocket()->getPeerIP(),
+         StorageOpCounter_GETLOCALFILESIZE, getMsgHeaderUserID() );
+
+   return true;
+}
+
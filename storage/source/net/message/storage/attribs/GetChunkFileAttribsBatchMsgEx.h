@@ -0,0 +1,10 @@
+#pragma once
+
+#include <common/net/message/storage/attribs/GetChunkFileAttribsBatchMsg.h>
+
+class GetChunkFileAttribsBatchMsgEx : public GetChunkFileAttribsBatchMsg
+{
+   public:
+      virtual bool processIncoming(ResponseContext& ctx);
+};
+
@@ -196,6 +196,12 @@ bool SetLocalAttrMsgEx::processIncoming(ResponseContext& ctx)
       }
    }
 
+   if(isMsgHeaderFeatureFlagSet(SETLOCALATTRMSG_FLAG_BUDDYMIRROR) &&
+      !isMsgHeaderFeatureFlagSet(SETLOCALATTRMSG_FLAG_BUDDYMIRROR_SECOND) &&
+      target->getDirtyChunkJournal().isActive() )
+      target->getDirtyChunkJournal().add(DirtyChunkJournal::RecordType_ATTRIBS,
+         StorageTk::getFileChunkPath(getPathInfo(), getEntryID() ), 0, 0);
+
 
 send_response:
 
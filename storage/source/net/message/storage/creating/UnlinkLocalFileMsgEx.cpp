@@ -96,6 +96,12 @@ bool UnlinkLocalFileMsgEx::processIncoming(ResponseContext& ctx)
 
       unlinkRes = unlinkat(targetFD, chunkFilePathStr.c_str(), 0);
 
+      if(isMsgHeaderFeatureFlagSet(UNLINKLOCALFILEMSG_FLAG_BUDDYMIRROR) &&
+         !isMsgHeaderFeatureFlagSet(UNLINKLOCALFILEMSG_FLAG_BUDDYMIRROR_SECOND) &&
+         target->getDirtyChunkJournal().isActive() )
+         target->getDirtyChunkJournal().add(DirtyChunkJournal::RecordType_UNLINK,
+            chunkFilePathStr, 0, 0);
+
       if( (unlinkRes == -1) && (errno != ENOENT) )
       { // error
          LogContext(logContext).logErr("Unable to unlink file: " + chunkFilePathStr + ". " +
@@ -0,0 +1,145 @@
+#include <common/net/message/storage/mirroring/GetChunkBlockDigestsRespMsg.h>
+#include <program/Program.h>
+#include <toolkit/StorageTkEx.h>
+#include "GetChunkBlockDigestsMsgEx.h"
+
+#include <boost/scoped_array.hpp>
+
+
+bool GetChunkBlockDigestsMsgEx::processIncoming(ResponseContext& ctx)
+{
+   App* app = Program::getApp();
+
+   const std::string& relativePathStr = getRelativePathStr();
+   FhgfsOpsErr retVal = FhgfsOpsErr_SUCCESS;
+   int64_t fileSize = 0;
+   UInt64Vector digests;
+
+   auto* const target = app->getStorageTargets()->getTarget(getTargetID() );
+   if (!target)
+   {
+      LogContext(__func__).logErr("Unknown targetID: " + std::to_string(getTargetID() ) +
+         "; chunkPath: " + relativePathStr);
+
+      retVal = FhgfsOpsErr_UNKNOWNTARGET;
+      goto send_response;
+   }
+
+   if ( (getBlockSize() == 0) || (getBlockSize() > GETCHUNKBLOCKDIGESTSMSG_MAX_BLOCK_SIZE) ||
+      (getFirstBlock() < 0) || (getNumBlocks() > GETCHUNKBLOCKDIGESTSMSG_MAX_NUM_BLOCKS) ||
+      ( (uint64_t)getBlockSize() * getNumBlocks() > GETCHUNKBLOCKDIGESTSMSG_MAX_TOTAL_LEN) )
+   {
+      retVal = FhgfsOpsErr_INVAL;
+      goto send_response;
+   }
+
+   {
+      const int targetFD = isMsgHeaderFeatureFlagSet(GETCHUNKBLOCKDIGESTSMSG_FLAG_BUDDYMIRROR)
+         ? *target->getMirrorFD()
+         : *target->getChunkFD();
+
+      int fd = openat(targetFD, relativePathStr.c_str(), O_RDONLY | O_NOATIME);
+      if (fd == -1)
+      {
+         int errCode = errno;
+
+         if (errCode == ENOENT)
+            retVal = FhgfsOpsErr_PATHNOTEXISTS;
+         else
+         {
+            LogContext(__func__).logErr("Unable to open chunk file: " + relativePathStr +
+               "; targetID: " + std::to_string(getTargetID() ) +
+               "; SysErr: " + System::getErrString(errCode) );
+
+            retVal = FhgfsOpsErr_INTERNAL;
+         }
+
+         goto send_response;
+      }
+
+      retVal = getDigests(fd, fileSize, digests);
+
+      close(fd);
+   }
+
+send_response:
+   ctx.sendResponse(GetChunkBlockDigestsRespMsg(retVal, fileSize, &digests) );
+
+   return true;
+}
+
+/**
+ * Compute the digests of the requested blocks that are within the file. Blocks in a hole (detected
+ * via SEEK_DATA) are not read.
+ */
+FhgfsOpsErr GetChunkBlockDigestsMsgEx::getDigests(int fd, int64_t& outFileSize,
+   UInt64Vector& outDigests)
+{
+   const size_t blockSize = getBlockSize();
+
+   struct stat statBuf;
+
+   if (fstat(fd, &statBuf) == -1)
+   {
+      LogContext(__func__).logErr("Unable to stat chunk file: " + getRelativePathStr() +
+         "; SysErr: " + System::getErrString() );
+      return FhgfsOpsErr_INTERNAL;
+   }
+
+   outFileSize = statBuf.st_size;
+
+   boost::scoped_array<char> buf(new char[blockSize]);
+   bool haveZeroDigest = false;
+   uint64_t zeroDigest = 0;
+
+   for (int64_t block = getFirstBlock(); block < getFirstBlock() + getNumBlocks(); block++)
+   {
+      const off_t offset = block * blockSize;
+
+      if (offset >= outFileSize)
+         break;
+
+      const size_t len = BEEGFS_MIN(blockSize, size_t(outFileSize - offset) );
+
+      if (len == blockSize)
+      {
+         off_t dataOffset = lseek(fd, offset, SEEK_DATA);
+
+         if ( ( (dataOffset == -1) && (errno == ENXIO) ) || (dataOffset >= off_t(offset + len) ) )
+         { // block is completely in a hole
+            if (!haveZeroDigest)
+            {
+               memset(buf.get(), 0, blockSize);
+               zeroDigest = StorageTkEx::getBlockDigest(buf.get(), blockSize);
+               haveZeroDigest = true;
+            }
+
+            outDigests.push_back(zeroDigest);
+            continue;
+         }
+      }
+
+      size_t readSum = 0;
+
+      while (readSum < len)
+      {
+         ssize_t readRes = pread(fd, buf.get() + readSum, len - readSum, offset + readSum);
+
+         if (readRes <= 0)
+         {
+            if (readRes == 0)
+               break; // truncated concurrently => last digest won't match, which is fine
+
+            LogContext(__func__).logErr("Unable to read chunk file: " + getRelativePathStr() +
+               "; SysErr: " + System::getErrString() );
+            return FhgfsOpsErr_INTERNAL;
+         }
+
+         readSum += readRes;
+      }
+
+      outDigests.push_back(StorageTkEx::getBlockDigest(buf.get(), readSum) );
+   }
+
+   return FhgfsOpsErr_SUCCESS;
+}
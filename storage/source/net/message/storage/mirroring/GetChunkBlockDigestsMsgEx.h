@@ -0,0 +1,13 @@
+#pragma once
+
+#include <common/net/message/storage/mirroring/GetChunkBlockDigestsMsg.h>
+#include <common/storage/StorageErrors.h>
+
+class GetChunkBlockDigestsMsgEx : public GetChunkBlockDigestsMsg
+{
+   public:
+      virtual bool processIncoming(ResponseContext& ctx);
+
+   private:
+      FhgfsOpsErr getDigests(int fd, int64_t& outFileSize, UInt64Vector& outDigests);
+};
@@ -2,6 +2,7 @@
 #include <common/net/message/storage/mirroring/ResyncLocalFileRespMsg.h>
 #include <common/toolkit/MessagingTk.h>
 #include <net/msghelpers/MsgHelperIO.h>
+#include <storage/ChunkChecksums.h>
 #include <toolkit/StorageTkEx.h>
 
 #include <program/Program.h>
@@ -75,10 +76,29 @@ bool ResyncLocalFileMsgEx::processIncoming(ResponseContext& ctx)
    targetFD = isMsgHeaderFeatureFlagSet(RESYNCLOCALFILEMSG_FLAG_BUDDYMIRROR) 
          ? *target->getMirrorFD()
          : *target->getChunkFD();
-   // always truncate when we write the very first block of a file
-   if (!offset && !isMsgHeaderFeatureFlagSet (RESYNCLOCALFILEMSG_FLAG_NODATA) )
+   // always truncate when we write the very first block of a file (unless only changed blocks
+   // are sent)
+   if (!offset && !isMsgHeaderFeatureFlagSet (RESYNCLOCALFILEMSG_FLAG_NODATA) &&
+      !isMsgHeaderFeatureFlagSet(RESYNCLOCALFILEMSG_FLAG_DELTA) )
       openFlags |= O_TRUNC;
 
+   // chunk balancing to a mirrored target => data might not have been forwarded to the secondary
+   if (isMsgHeaderFeatureFlagSet(RESYNCLOCALFILEMSG_FLAG_CHUNKBALANCE_BUDDYMIRROR) &&
+      !isMsgHeaderFeatureFlagSet(RESYNCLOCALFILEMSG_FLAG_BUDDYMIRROR_SECOND) &&
+      target->getDirtyChunkJournal().isActive() )
+   {
+      if (isMsgHeaderFeatureFlagSet(RESYNCLOCALFILEMSG_FLAG_NODATA) )
+         target->getDirtyChunkJournal().add(DirtyChunkJournal::RecordType_ATTRIBS,
+            relativeChunkPathStr, 0, 0);
+      else
+      if (openFlags & O_TRUNC)
+         target->getDirtyChunkJournal().add(DirtyChunkJournal::RecordType_TRUNC,
+            relativeChunkPathStr, 0, 0);
+      else
+         target->getDirtyChunkJournal().add(DirtyChunkJournal::RecordType_WRITE,
+            relativeChunkPathStr, offset, count);
+   }
+
    openRes = chunkStore->openChunkFile(targetFD, NULL, relativeChunkPathStr, true,
       openFlags, &fd, &quotaInfo, {});
 
@@ -98,7 +118,8 @@ bool ResyncLocalFileMsgEx::processIncoming(ResponseContext& ctx)
       goto set_attribs;
 
    if (isMsgHeaderFeatureFlagSet (RESYNCLOCALFILEMSG_CHECK_SPARSE))
-      writeRes = doWriteSparse(fd, dataBuf, count, offset, writeErrno);
+      writeRes = doWriteSparse(fd, dataBuf, count, offset,
+         isMsgHeaderFeatureFlagSet(RESYNCLOCALFILEMSG_FLAG_DELTA), writeErrno);
    else
       writeRes = doWrite(fd, dataBuf, count, offset, writeErrno);
 
@@ -131,6 +152,10 @@ bool ResyncLocalFileMsgEx::processIncoming(ResponseContext& ctx)
       }
    }
 
+   // data was written without updating the checksums
+   if (app->getConfig()->getTuneChunkChecksums() )
+      ChunkChecksums::invalidate(fd);
+
 set_attribs:
 
    if (isMsgHeaderFeatureFlagSet(RESYNCLOCALFILEMSG_FLAG_SETATTRIBS) &&
@@ -208,9 +233,12 @@ bool ResyncLocalFileMsgEx::doWrite(int fd, const char* buf, size_t count, off_t
 
 /**
  * Write until everything was written (handle short-writes) or an error occured
+ *
+ * @param punchHoles true to punch holes for sparse areas (because the file might contain old data
+ *    there), false to skip them.
  */
 bool ResyncLocalFileMsgEx::doWriteSparse(int fd, const char* buf, size_t count, off_t offset,
-   int& outErrno)
+   bool punchHoles, int& outErrno)
 {
    size_t sumWriteRes = 0;
    const char zeroBuf[ RESYNCER_SPARSE_BLOCK_SIZE ] = { 0 };
@@ -222,6 +250,27 @@ bool ResyncLocalFileMsgEx::doWriteSparse(int fd, const char* buf, size_t count,
 
       if (!cmpRes)
       { // sparse area
+         if (punchHoles)
+         { // extend to the following sparse areas to punch them at once
+            size_t holeLen = cmpLen;
+
+            while (sumWriteRes + holeLen < count)
+            {
+               size_t nextLen = BEEGFS_MIN(count - sumWriteRes - holeLen,
+                  RESYNCER_SPARSE_BLOCK_SIZE);
+
+               if (memcmp(buf + sumWriteRes + holeLen, zeroBuf, nextLen) )
+                  break;
+
+               holeLen += nextLen;
+            }
+
+            if (!doPunchHole(fd, zeroBuf, holeLen, offset + sumWriteRes, outErrno) )
+               return false;
+
+            cmpLen = holeLen;
+         }
+
          sumWriteRes += cmpLen;
 
          if (sumWriteRes == count)
@@ -255,6 +304,35 @@ bool ResyncLocalFileMsgEx::doWriteSparse(int fd, const char* buf, size_t count,
    return true;
 }
 
+/**
+ * Deallocate the given range of the file; falls back to writing zeros if the underlying file system
+ * doesn't support punching holes.
+ */
+bool ResyncLocalFileMsgEx::doPunchHole(int fd, const char* zeroBuf, size_t count, off_t offset,
+   int& outErrno)
+{
+   int fallocRes = fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, offset, count);
+
+   if (likely(fallocRes == 0) )
+      return true;
+
+   if ( (errno != EOPNOTSUPP) && (errno != ENOSYS) )
+   {
+      outErrno = errno;
+      return false;
+   }
+
+   for (size_t sumWriteRes = 0; sumWriteRes < count; sumWriteRes += RESYNCER_SPARSE_BLOCK_SIZE)
+   {
+      size_t writeLen = BEEGFS_MIN(count - sumWriteRes, RESYNCER_SPARSE_BLOCK_SIZE);
+
+      if (!doWrite(fd, zeroBuf, writeLen, offset + sumWriteRes, outErrno) )
+         return false;
+   }
+
+   return true;
+}
+
 bool ResyncLocalFileMsgEx::doTrunc(int fd, off_t length, int& outErrno)
 {
    int truncRes = ftruncate(fd, length);
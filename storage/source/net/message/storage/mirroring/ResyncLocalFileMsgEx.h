@@ -10,7 +10,9 @@ class ResyncLocalFileMsgEx : public ResyncLocalFileMsg
 
    private:
       bool doWrite(int fd, const char* buf, size_t count, off_t offset, int& outErrno);
-      bool doWriteSparse(int fd, const char* buf, size_t count, off_t offset, int& outErrno);
+      bool doWriteSparse(int fd, const char* buf, size_t count, off_t offset, bool punchHoles,
+         int& outErrno);
+      bool doPunchHole(int fd, const char* zeroBuf, size_t count, off_t offset, int& outErrno);
       bool doTrunc(int fd, off_t length, int& outErrno);
       FhgfsOpsErr forwardToSecondary(uint16_t& targetID, StorageTarget& target, ResponseContext& ctx);
 };
@@ -0,0 +1,373 @@
+#include <common/app/log/LogContext.h>
+#include <common/toolkit/Time.h>
+#include "AsyncFileWriter.h"
+#include "MsgHelperIO.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+
+/**
+ * @param workerBuf the buffer of the calling worker (which contains the data of all requests);
+ *    only used on first call.
+ * @return the writer of the calling worker thread; created on first call.
+ */
+AsyncFileWriter* AsyncFileWriter::getThreadInstance(char* workerBuf, size_t workerBufLen)
+{
+   static thread_local std::unique_ptr<AsyncFileWriter> threadWriter;
+   static std::atomic<bool> fallbackLogged(false);
+
+   if(likely(threadWriter) )
+      return threadWriter.get();
+
+   Config* cfg = Program::getApp()->getConfig();
+
+   if(cfg->getTuneUseIoUring() )
+   {
+      std::string errMsg;
+
+      #ifdef BEEGFS_IO_URING_SUPPORTED
+         std::unique_ptr<IoUringAsyncFileWriter> uringWriter(new IoUringAsyncFileWriter() );
+
+         if(uringWriter->init(workerBuf, workerBufLen, errMsg) )
+         {
+            threadWriter = std::move(uringWriter);
+            return threadWriter.get();
+         }
+      #else
+         errMsg = "Not supported by this build.";
+      #endif
+
+      if(!fallbackLogged.exchange(true) )
+         LogContext("AsyncFileWriter").log(Log_WARNING,
+            "io_uring is not usable, falling back to helper threads for background writes. "
+            "Reason: " + errMsg);
+   }
+
+   ThreadAsyncFileWriter* helperWriter =
+      new ThreadAsyncFileWriter(PThread::getCurrentThreadName() + "-Writer");
+
+   threadWriter.reset(helperWriter);
+   helperWriter->start();
+
+   return threadWriter.get();
+}
+
+/**
+ * Write until everything was written (handle short-writes) or an error occured.
+ *
+ * Note: Continues after the request.writeRes bytes which were already written.
+ */
+void AsyncFileWriter::writeFully(Request& request)
+{
+   size_t sumWriteRes = request.writeRes;
+
+   while(sumWriteRes != request.count)
+   {
+      ssize_t writeRes = MsgHelperIO::pwrite(request.fd, request.buf + sumWriteRes,
+         request.count - sumWriteRes, request.offset + sumWriteRes);
+
+      if(unlikely(writeRes == -1) )
+      {
+         request.writeRes = (sumWriteRes > 0) ? (ssize_t)sumWriteRes : writeRes;
+         request.errCode = errno;
+         return;
+      }
+
+      sumWriteRes += writeRes;
+   }
+
+   request.writeRes = sumWriteRes;
+}
+
+
+ThreadAsyncFileWriter::ThreadAsyncFileWriter(const std::string& name) :
+   PThread(name)
+{
+}
+
+/**
+ * Stops and joins the helper thread.
+ *
+ * Note: All submitted requests must have been waited for before.
+ */
+ThreadAsyncFileWriter::~ThreadAsyncFileWriter()
+{
+   {
+      std::lock_guard<Mutex> mutexLock(mutex);
+
+      selfTerminate();
+      newRequestCond.signal();
+   }
+
+   join();
+}
+
+void ThreadAsyncFileWriter::submit(Request& request)
+{
+   request.writeRes = 0;
+   request.errCode = 0;
+   request.isDone = false;
+
+   std::lock_guard<Mutex> mutexLock(mutex);
+
+   pendingRequests.push_back(&request);
+   newRequestCond.signal();
+}
+
+void ThreadAsyncFileWriter::waitForCompletion(Request& request)
+{
+   std::lock_guard<Mutex> mutexLock(mutex);
+
+   while(!request.isDone)
+      requestDoneCond.wait(&mutex);
+}
+
+void ThreadAsyncFileWriter::syncFileRange(int fd, off64_t offset, off64_t nbytes)
+{
+   MsgHelperIO::syncFileRange(fd, offset, nbytes);
+}
+
+void ThreadAsyncFileWriter::run()
+{
+   try
+   {
+      registerSignalHandler();
+
+      for( ; ; )
+      {
+         Request* request;
+
+         {
+            std::lock_guard<Mutex> mutexLock(mutex);
+
+            while(pendingRequests.empty() && !getSelfTerminate() )
+               newRequestCond.wait(&mutex);
+
+            if(pendingRequests.empty() )
+               break; // self-terminate order
+
+            request = pendingRequests.front();
+            pendingRequests.pop_front();
+         }
+
+         writeFully(*request);
+
+         {
+            std::lock_guard<Mutex> mutexLock(mutex);
+
+            request->isDone = true;
+            requestDoneCond.broadcast();
+         }
+      }
+
+      LOG_DEBUG(getName(), Log_DEBUG, "Component stopped.");
+   }
+   catch(std::exception& e)
+   {
+      PThread::getCurrentThreadApp()->handleComponentException(e);
+   }
+}
+
+
+#ifdef BEEGFS_IO_URING_SUPPORTED
+
+IoUringAsyncFileWriter::IoUringAsyncFileWriter() :
+   ringFailed(false), slots(), numSlotsInUse(0),
+   failedRingLogIntervalMS(IOURINGFILEWRITER_FAILED_RING_LOG_MS)
+{
+}
+
+/**
+ * @return false if io_uring is not usable (outErrMsg is set in this case)
+ */
+bool IoUringAsyncFileWriter::init(char* workerBuf, size_t workerBufLen, std::string& outErrMsg)
+{
+   if(!ring.init(IOURINGFILEWRITER_NUM_ENTRIES, outErrMsg) )
+      return false;
+
+   if(!ring.registerBuffer(workerBuf, workerBufLen) )
+   { // not fatal, we just can't use the fixed buffer ops
+      LOG_DEBUG("IoUringAsyncFileWriter", Log_DEBUG,
+         "Unable to register worker buffer: " + System::getErrString() );
+   }
+
+   return true;
+}
+
+/**
+ * Prepare a submission queue entry for the not yet written part of the request in the given
+ * slot.
+ *
+ * @return false if the submission queue is full
+ */
+bool IoUringAsyncFileWriter::prepWrite(unsigned slotIndex)
+{
+   Request& request = *slots[slotIndex].request;
+
+   // (note: count is limited by the worker buffer size, so it always fits into the sqe)
+   return ring.prepWrite(request.fd, request.buf + request.writeRes,
+      request.count - request.writeRes, request.offset + request.writeRes, slotIndex + 1);
+}
+
+void IoUringAsyncFileWriter::submit(Request& request)
+{
+   request.writeRes = 0;
+   request.errCode = 0;
+   request.isDone = false;
+
+   reapCompletions(); // make room in the completion queue
+
+   if(likely(!ringFailed) && (numSlotsInUse < IOURINGFILEWRITER_NUM_ENTRIES) )
+   {
+      unsigned slotIndex = 0;
+
+      while(slots[slotIndex].request)
+         slotIndex++;
+
+      slots[slotIndex].request = &request;
+
+      if(likely(prepWrite(slotIndex) && (ring.submit() != -1) ) )
+      {
+         numSlotsInUse++;
+         return;
+      }
+
+      slots[slotIndex].request = NULL;
+   }
+
+   // (unlikely, as the caller waits for its requests) => write synchronously
+   writeFully(request);
+   request.isDone = true;
+}
+
+/**
+ * Note: Failures of the ring are not passed to the request. The request is completed with
+ * synchronous writes in this case (after the kernel finished its part, see waitForFailedRing() ).
+ */
+void IoUringAsyncFileWriter::waitForCompletion(Request& request)
+{
+   while(!request.isDone)
+   {
+      if(unlikely(ringFailed) )
+      {
+         waitForFailedRing();
+         continue;
+      }
+
+      uint64_t userData;
+      int res;
+
+      if(unlikely(ring.waitCompletion(userData, res) == -1) )
+      { // (EINTR is already handled by the ring)
+         LogContext("IoUringAsyncFileWriter").log(Log_ERR,
+            "Waiting for io_uring completion failed. Falling back to synchronous writes. "
+            "SysErr: " + System::getErrString() );
+
+         ringFailed = true;
+         continue;
+      }
+
+      processCompletion(userData, res);
+   }
+}
+
+/**
+ * Queues a sync_file_range request to the ring, without waiting for it.
+ */
+void IoUringAsyncFileWriter::syncFileRange(int fd, off64_t offset, off64_t nbytes)
+{
+   #ifdef CONFIG_DISTRO_HAS_SYNC_FILE_RANGE
+      reapCompletions();
+
+      // (userData 0 => completion is ignored)
+      if(unlikely(ringFailed || (nbytes > UINT32_MAX) ||
+         !ring.prepSyncFileRange(fd, offset, nbytes, SYNC_FILE_RANGE_WRITE, 0) ||
+         (ring.submit() == -1) ) )
+         MsgHelperIO::syncFileRange(fd, offset, nbytes);
+   #endif // CONFIG_DISTRO_HAS_SYNC_FILE_RANGE
+}
+
+/**
+ * Process all completions that are available without waiting.
+ */
+void IoUringAsyncFileWriter::reapCompletions()
+{
+   uint64_t userData;
+   int res;
+
+   while(ring.peekCompletion(userData, res) )
+      processCompletion(userData, res);
+}
+
+/**
+ * Update the request of the given completion (resubmits the rest of short writes).
+ */
+void IoUringAsyncFileWriter::processCompletion(uint64_t userData, int res)
+{
+   if(!userData)
+      return; // sync_file_range (result is ignored like in the synchronous case)
+
+   Slot& slot = slots[userData - 1];
+   Request* request = slot.request;
+
+   if(unlikely(res < 0) )
+   {
+      request->writeRes = (request->writeRes > 0) ? request->writeRes : -1;
+      request->errCode = -res;
+   }
+   else
+   {
+      request->writeRes += res;
+
+      if(unlikely( (size_t)request->writeRes != request->count) && likely(res != 0) )
+      { // short write => submit the rest (no progress is reported as partial write by the caller)
+         if(likely(!ringFailed && prepWrite(userData - 1) && (ring.submit() != -1) ) )
+            return;
+
+         writeFully(*request);
+      }
+   }
+
+   request->isDone = true;
+
+   slot.request = NULL;
+   numSlotsInUse--;
+}
+
+/**
+ * Called when the ring is not usable anymore: The writes that the kernel already has are still
+ * running and read from the buffers of their requests, so wait for their completions by polling
+ * the completion queue (which works without syscalls). Then all requests are done (with
+ * synchronous writes for the rest).
+ *
+ * Note: There is no time limit, because a request must not be completed while the kernel might
+ * still read from its buffer (the caller would reuse it for the next request).
+ */
+void IoUringAsyncFileWriter::waitForFailedRing()
+{
+   const unsigned sleepMS = 1;
+   Time lastLogT;
+
+   for( ; ; )
+   {
+      reapCompletions();
+
+      if(!numSlotsInUse)
+         return;
+
+      if(unlikely(lastLogT.elapsedMS() >= failedRingLogIntervalMS) )
+      {
+         LogContext("IoUringAsyncFileWriter").log(Log_WARNING,
+            "Still waiting for writes that io_uring didn't complete yet. "
+            "Number of writes: " + StringTk::uintToStr(numSlotsInUse) );
+
+         lastLogT.setToNow();
+      }
+
+      PThread::sleepMS(sleepMS);
+   }
+}
+
+#endif // BEEGFS_IO_URING_SUPPORTED
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <common/threading/Condition.h>
+#include <common/threading/Mutex.h>
+#include <common/threading/PThread.h>
+#include <common/Common.h>
+#include "IoUring.h"
+
+#include <deque>
+
+
+/**
+ * Writes the data of a worker in the background, so that the worker can receive the next part
+ * of the incoming data while the previous part is still being written to disk (see
+ * WriteLocalFileMsgEx).
+ *
+ * Each worker has its own instance (see getThreadInstance() ), which is created on first use and
+ * destroyed when the worker thread exits. Requests are completed in order of submission.
+ *
+ * There are two backends: ThreadAsyncFileWriter runs the pwrite()s in a helper thread and
+ * IoUringAsyncFileWriter submits them to an io_uring of the worker (if tuneUseIoUring is set and
+ * the kernel supports it).
+ */
+class AsyncFileWriter
+{
+   public:
+      struct Request
+      {
+         int fd;
+         const char* buf;
+         size_t count;
+         off_t offset;
+
+         ssize_t writeRes; // number of written bytes (short writes are retried) or -1 on error
+         int errCode; // errno of the failed write
+         bool isDone;
+      };
+
+      virtual ~AsyncFileWriter() {}
+
+      static AsyncFileWriter* getThreadInstance(char* workerBuf, size_t workerBufLen);
+
+      /**
+       * Queue a write request. The request (and its buffer) must not be touched by the caller
+       * until waitForCompletion() returned for it.
+       */
+      virtual void submit(Request& request) = 0;
+      virtual void waitForCompletion(Request& request) = 0;
+
+      /**
+       * Advise the kernel to start writeback of the given range (like
+       * MsgHelperIO::syncFileRange() ); might return before the writeback was started.
+       */
+      virtual void syncFileRange(int fd, off64_t offset, off64_t nbytes) = 0;
+
+
+   protected:
+      AsyncFileWriter() {}
+
+      static void writeFully(Request& request);
+};
+
+
+/**
+ * Runs the pwrite()s in a helper thread.
+ */
+class ThreadAsyncFileWriter : public AsyncFileWriter, public PThread
+{
+   public:
+      ThreadAsyncFileWriter(const std::string& name);
+      virtual ~ThreadAsyncFileWriter();
+
+      virtual void submit(Request& request);
+      virtual void waitForCompletion(Request& request);
+      virtual void syncFileRange(int fd, off64_t offset, off64_t nbytes);
+
+
+   private:
+      Mutex mutex;
+      Condition newRequestCond;
+      Condition requestDoneCond;
+      std::deque<Request*> pendingRequests;
+
+      virtual void run();
+};
+
+
+#ifdef BEEGFS_IO_URING_SUPPORTED
+
+#define IOURINGFILEWRITER_NUM_ENTRIES  32 /* must be at least WRITEMSG_PIPELINE_MAX_DEPTH plus
+                                             some room for sync_file_range requests */
+#define IOURINGFILEWRITER_FAILED_RING_LOG_MS  30000 /* interval of warnings while waiting for the
+                                                       writes that the kernel still has after the
+                                                       ring failed */
+
+/**
+ * Submits the writes to an io_uring, so no extra thread is needed. The worker buffer is
+ * registered with the ring, so that writes from it don't need to map the user pages for each
+ * request.
+ *
+ * If waiting for completions fails (other than by a signal), the ring is not used anymore and
+ * all further writes are done synchronously.
+ */
+class IoUringAsyncFileWriter : public AsyncFileWriter
+{
+   friend class TestIoUringAsyncFileWriter;
+
+   public:
+      IoUringAsyncFileWriter();
+
+      bool init(char* workerBuf, size_t workerBufLen, std::string& outErrMsg);
+
+      virtual void submit(Request& request);
+      virtual void waitForCompletion(Request& request);
+      virtual void syncFileRange(int fd, off64_t offset, off64_t nbytes);
+
+
+   private:
+      /**
+       * A write that the kernel has. The completion refers to its slot (userData is the slot
+       * index + 1). A slot is only freed when the completion of its write was received, because
+       * the kernel reads from the request buffer until then.
+       */
+      struct Slot
+      {
+         Request* request; // NULL if the slot is free
+      };
+
+      IoUring ring;
+      bool ringFailed; // true if the ring is not usable anymore (=> synchronous writes)
+      Slot slots[IOURINGFILEWRITER_NUM_ENTRIES];
+      unsigned numSlotsInUse;
+      unsigned failedRingLogIntervalMS; // see IOURINGFILEWRITER_FAILED_RING_LOG_MS
+
+      bool prepWrite(unsigned slotIndex);
+      void processCompletion(uint64_t userData, int res);
+      void reapCompletions();
+      void waitForFailedRing();
+};
+
+#endif // BEEGFS_IO_URING_SUPPORTED
+
@@ -0,0 +1,325 @@
+#include "IoUring.h"
+
+#ifdef BEEGFS_IO_URING_SUPPORTED
+
+#include <common/system/System.h>
+#include <common/toolkit/StringTk.h>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+
+
+IoUring::IoUring() :
+   ringFD(-1),
+   sqRingPtr(MAP_FAILED), sqRingSize(0),
+   cqRingPtr(MAP_FAILED), cqRingSize(0),
+   sqes( (struct io_uring_sqe*)MAP_FAILED), sqesSize(0),
+   sqHead(NULL), sqTail(NULL), sqArray(NULL), sqMask(0), sqNumEntries(0), sqeTail(0),
+   cqHead(NULL), cqTail(NULL), cqMask(0), cqes(NULL),
+   regBuf(NULL), regBufLen(0)
+{
+}
+
+IoUring::~IoUring()
+{
+   cleanup();
+}
+
+void IoUring::cleanup()
+{
+   if(sqes != MAP_FAILED)
+      munmap(sqes, sqesSize);
+
+   if( (cqRingPtr != MAP_FAILED) && (cqRingPtr != sqRingPtr) )
+      munmap(cqRingPtr, cqRingSize);
+
+   if(sqRingPtr != MAP_FAILED)
+      munmap(sqRingPtr, sqRingSize);
+
+   if(ringFD != -1)
+      close(ringFD); // (also unregisters buffers)
+
+   sqes = (struct io_uring_sqe*)MAP_FAILED;
+   cqRingPtr = MAP_FAILED;
+   sqRingPtr = MAP_FAILED;
+   ringFD = -1;
+}
+
+/**
+ * @param outErrMsg reason if io_uring is not usable (e.g. not supported by the kernel).
+ * @return false if io_uring is not usable
+ */
+bool IoUring::init(unsigned numEntries, std::string& outErrMsg)
+{
+   struct io_uring_params params = {};
+
+   ringFD = syscall(__NR_io_uring_setup, numEntries, &params);
+   if(ringFD == -1)
+   {
+      outErrMsg = "io_uring_setup failed: " + System::getErrString();
+      return false;
+   }
+
+   sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+   cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+   if(params.features & IORING_FEAT_SINGLE_MMAP)
+      sqRingSize = cqRingSize = BEEGFS_MAX(sqRingSize, cqRingSize);
+
+   sqRingPtr = mmap(NULL, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+      ringFD, IORING_OFF_SQ_RING);
+   if(sqRingPtr == MAP_FAILED)
+      goto err_mmap;
+
+   if(params.features & IORING_FEAT_SINGLE_MMAP)
+      cqRingPtr = sqRingPtr;
+   else
+   {
+      cqRingPtr = mmap(NULL, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+         ringFD, IORING_OFF_CQ_RING);
+      if(cqRingPtr == MAP_FAILED)
+         goto err_mmap;
+   }
+
+   sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+   sqes = (struct io_uring_sqe*)mmap(NULL, sqesSize, PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_POPULATE, ringFD, IORING_OFF_SQES);
+   if(sqes == MAP_FAILED)
+      goto err_mmap;
+
+   sqHead = (unsigned*)( (char*)sqRingPtr + params.sq_off.head);
+   sqTail = (unsigned*)( (char*)sqRingPtr + params.sq_off.tail);
+   sqArray = (unsigned*)( (char*)sqRingPtr + params.sq_off.array);
+   sqMask = *(unsigned*)( (char*)sqRingPtr + params.sq_off.ring_mask);
+   sqNumEntries = params.sq_entries;
+   sqeTail = *sqTail;
+
+   cqHead = (unsigned*)( (char*)cqRingPtr + params.cq_off.head);
+   cqTail = (unsigned*)( (char*)cqRingPtr + params.cq_off.tail);
+   cqMask = *(unsigned*)( (char*)cqRingPtr + params.cq_off.ring_mask);
+   cqes = (struct io_uring_cqe*)( (char*)cqRingPtr + params.cq_off.cqes);
+
+   if(!checkOpsSupported(outErrMsg) )
+   {
+      cleanup();
+      return false;
+   }
+
+   return true;
+
+err_mmap:
+   outErrMsg = "Mapping io_uring rings failed: " + System::getErrString();
+   cleanup();
+   return false;
+}
+
+/**
+ * Check that the kernel supports all ops that we use.
+ */
+bool IoUring::checkOpsSupported(std::string& outErrMsg)
+{
+   const unsigned requiredOps[] =
+      { IORING_OP_WRITE, IORING_OP_WRITE_FIXED, IORING_OP_SYNC_FILE_RANGE };
+
+   const size_t probeSize = sizeof(struct io_uring_probe) +
+      IORING_OP_LAST * sizeof(struct io_uring_probe_op);
+
+   std::unique_ptr<char[]> probeBuf(new char[probeSize]() );
+   struct io_uring_probe* probe = (struct io_uring_probe*)probeBuf.get();
+
+   if(syscall(__NR_io_uring_register, ringFD, IORING_REGISTER_PROBE, probe, IORING_OP_LAST) )
+   {
+      outErrMsg = "io_uring probe failed: " + System::getErrString();
+      return false;
+   }
+
+   for(unsigned op : requiredOps)
+   {
+      if( (op > probe->last_op) || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED) )
+      {
+         outErrMsg = "io_uring op not supported by kernel: " + StringTk::uintToStr(op);
+         return false;
+      }
+   }
+
+   return true;
+}
+
+/**
+ * Register the given buffer as fixed buffer index 0 (pins the memory).
+ *
+ * @return false if registration failed (e.g. because of RLIMIT_MEMLOCK); the ring is still
+ * usable with non-fixed ops in this case.
+ */
+bool IoUring::registerBuffer(void* buf, size_t len)
+{
+   struct iovec iov = { buf, len };
+
+   if(syscall(__NR_io_uring_register, ringFD, IORING_REGISTER_BUFFERS, &iov, 1) )
+      return false;
+
+   regBuf = (const char*)buf;
+   regBufLen = len;
+
+   return true;
+}
+
+/**
+ * @return next free submission queue entry (zeroed) or NULL if the queue is full.
+ */
+struct io_uring_sqe* IoUring::getSqe()
+{
+   const unsigned head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+
+   if(sqeTail - head >= sqNumEntries)
+      return NULL;
+
+   struct io_uring_sqe* sqe = &sqes[sqeTail & sqMask];
+   sqeTail++;
+
+   memset(sqe, 0, sizeof(*sqe) );
+
+   return sqe;
+}
+
+/**
+ * Prepare a write of the given buffer (uses the fixed buffer variant if the buffer was
+ * registered).
+ *
+ * @return false if the submission queue is full
+ */
+bool IoUring::prepWrite(int fd, const char* buf, unsigned len, off_t offset, uint64_t userData)
+{
+   struct io_uring_sqe* sqe = getSqe();
+   if(unlikely(!sqe) )
+      return false;
+
+   if(isRegisteredBuffer(buf, len) )
+   {
+      sqe->opcode = IORING_OP_WRITE_FIXED;
+      sqe->buf_index = 0;
+   }
+   else
+      sqe->opcode = IORING_OP_WRITE;
+
+   sqe->fd = fd;
+   sqe->addr = (uintptr_t)buf;
+   sqe->len = len;
+   sqe->off = offset;
+   sqe->user_data = userData;
+
+   return true;
+}
+
+/**
+ * @param flags SYNC_FILE_RANGE_... flags
+ * @return false if the submission queue is full
+ */
+bool IoUring::prepSyncFileRange(int fd, off_t offset, unsigned len, unsigned flags,
+   uint64_t userData)
+{
+   struct io_uring_sqe* sqe = getSqe();
+   if(unlikely(!sqe) )
+      return false;
+
+   sqe->opcode = IORING_OP_SYNC_FILE_RANGE;
+   sqe->fd = fd;
+   sqe->off = offset;
+   sqe->len = len;
+   sqe->sync_range_flags = flags;
+   sqe->user_data = userData;
+
+   return true;
+}
+
+/**
+ * Make prepared entries visible to the kernel.
+ *
+ * @return number of entries to be submitted
+ */
+unsigned IoUring::flushSq()
+{
+   unsigned tail = *sqTail;
+   const unsigned toSubmit = sqeTail - tail;
+
+   for( ; tail != sqeTail; tail++)
+      sqArray[tail & sqMask] = tail & sqMask;
+
+   __atomic_store_n(sqTail, tail, __ATOMIC_RELEASE);
+
+   return toSubmit;
+}
+
+int IoUring::enter(unsigned toSubmit, unsigned minComplete, unsigned flags)
+{
+   int enterRes;
+
+   do
+   {
+      enterRes = syscall(__NR_io_uring_enter, ringFD, toSubmit, minComplete, flags, NULL, 0);
+   } while( (enterRes == -1) && (errno == EINTR) );
+
+   return enterRes;
+}
+
+/**
+ * Submit all prepared entries (in a single syscall).
+ *
+ * @return number of submitted entries or -1 on error (errno is set); the prepared entries are
+ * dropped in the latter case.
+ */
+int IoUring::submit()
+{
+   const unsigned oldTail = *sqTail;
+
+   int enterRes = enter(flushSq(), 0, 0);
+   if(unlikely(enterRes == -1) )
+   { // kernel didn't consume anything (we don't use SQPOLL, so it's safe to take them back)
+      __atomic_store_n(sqTail, oldTail, __ATOMIC_RELEASE);
+      sqeTail = oldTail;
+   }
+
+   return enterRes;
+}
+
+/**
+ * Take the next completion from the completion queue (if any).
+ *
+ * @param outRes result of the request (like the return value of the corresponding syscall, but
+ *    negative errno on error)
+ * @return false if no completion is available right now.
+ */
+bool IoUring::peekCompletion(uint64_t& outUserData, int& outRes)
+{
+   const unsigned head = *cqHead;
+
+   if(head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE) )
+      return false;
+
+   const struct io_uring_cqe* cqe = &cqes[head & cqMask];
+
+   outUserData = cqe->user_data;
+   outRes = cqe->res;
+
+   __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+
+   return true;
+}
+
+/**
+ * Wait for the next completion (also submits prepared entries).
+ *
+ * @return 0 on success or -1 on error (errno is set)
+ */
+int IoUring::waitCompletion(uint64_t& outUserData, int& outRes)
+{
+   while(!peekCompletion(outUserData, outRes) )
+   {
+      if(enter(flushSq(), 1, IORING_ENTER_GETEVENTS) == -1)
+         return -1;
+   }
+
+   return 0;
+}
+
+#endif // BEEGFS_IO_URING_SUPPORTED
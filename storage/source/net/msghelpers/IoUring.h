@@ -0,0 +1,98 @@
+#pragma once
+
+#include <common/Common.h>
+
+/* note: <linux/io_uring.h> is only included in IoUring.cpp, because it pulls in <linux/fs.h>,
+   which defines macros (e.g. BLOCK_SIZE) that collide with our own names. */
+#if __has_include(<linux/io_uring.h>)
+   #include <linux/version.h>
+   #include <sys/syscall.h>
+
+   // (linux-5.7 headers have all the opcodes and features that we need)
+   #if (LINUX_VERSION_CODE >= KERNEL_VERSION(5,7,0) ) && defined(__NR_io_uring_setup)
+      #define BEEGFS_IO_URING_SUPPORTED
+   #endif
+#endif
+
+
+#ifdef BEEGFS_IO_URING_SUPPORTED
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+/**
+ * Minimal wrapper around the raw io_uring syscalls (to avoid a dependency on liburing).
+ *
+ * Usage: prepWrite()/prepSyncFileRange(), submit(); then waitCompletion()/peekCompletion() for
+ * each completion. The userData of a request is returned with its completion.
+ *
+ * Not thread-safe, each instance is meant to be used by a single thread.
+ */
+class IoUring
+{
+   public:
+      IoUring();
+      ~IoUring();
+
+      IoUring(const IoUring&) = delete;
+      IoUring& operator=(const IoUring&) = delete;
+
+      bool init(unsigned numEntries, std::string& outErrMsg);
+      bool registerBuffer(void* buf, size_t len);
+
+      bool prepWrite(int fd, const char* buf, unsigned len, off_t offset, uint64_t userData);
+      bool prepSyncFileRange(int fd, off_t offset, unsigned len, unsigned flags,
+         uint64_t userData);
+      int submit();
+
+      bool peekCompletion(uint64_t& outUserData, int& outRes);
+      int waitCompletion(uint64_t& outUserData, int& outRes);
+
+
+   private:
+      int ringFD;
+
+      void* sqRingPtr;
+      size_t sqRingSize;
+      void* cqRingPtr;
+      size_t cqRingSize;
+      struct io_uring_sqe* sqes;
+      size_t sqesSize;
+
+      unsigned* sqHead;
+      unsigned* sqTail;
+      unsigned* sqArray;
+      unsigned sqMask;
+      unsigned sqNumEntries;
+      unsigned sqeTail; // local tail of prepared, but not yet submitted entries
+
+      unsigned* cqHead;
+      unsigned* cqTail;
+      unsigned cqMask;
+      struct io_uring_cqe* cqes;
+
+      const char* regBuf; // registered buffer (fixed buffer index 0)
+      size_t regBufLen;
+
+      bool checkOpsSupported(std::string& outErrMsg);
+      struct io_uring_sqe* getSqe();
+      int enter(unsigned toSubmit, unsigned minComplete, unsigned flags);
+      unsigned flushSq();
+      void cleanup();
+
+
+   public:
+      // inliners
+
+      /**
+       * @return true if the given range is within the registered buffer (so that the fixed
+       * variants of the read/write ops can be used for it).
+       */
+      bool isRegisteredBuffer(const char* buf, size_t len) const
+      {
+         return regBuf && (buf >= regBuf) && ( (buf + len) <= (regBuf + regBufLen) );
+      }
+};
+
+#endif // BEEGFS_IO_URING_SUPPORTED
+
@@ -0,0 +1,725 @@
+#include <common/app/log/LogContext.h>
+#include <common/toolkit/ChecksumTk.h>
+#include <net/msghelpers/MsgHelperIO.h>
+#include <program/Program.h>
+#include "ChunkChecksums.h"
+
+#include <atomic>
+#include <memory>
+
+#include <sys/xattr.h>
+
+
+namespace {
+
+struct ChunkChecksumsHeader
+{
+   uint32_t formatVersion;
+   uint32_t blockSize;
+};
+
+/**
+ * @return a block-sized buffer of the calling thread, aligned for O_DIRECT reads
+ */
+char* getScratchBuf()
+{
+   static thread_local std::unique_ptr<char, void (*)(void*)> scratchBuf(NULL, free);
+
+   if(unlikely(!scratchBuf) )
+   {
+      void* buf;
+
+      if(posix_memalign(&buf, 4096, CHUNKCHECKSUMS_BLOCK_SIZE) )
+         throw std::bad_alloc();
+
+      scratchBuf.reset( (char*)buf);
+   }
+
+   return scratchBuf.get();
+}
+
+/**
+ * Read a whole block (or less at the end of the file) into the scratch buffer.
+ *
+ * @return number of read bytes or -1 on error
+ */
+ssize_t readBlock(int fd, size_t blockIndex, char*& outBuf)
+{
+   outBuf = getScratchBuf();
+
+   return MsgHelperIO::pread(fd, outBuf, CHUNKCHECKSUMS_BLOCK_SIZE,
+      (off_t)blockIndex * CHUNKCHECKSUMS_BLOCK_SIZE);
+}
+
+} // namespace
+
+
+/**
+ * Load the checksums of all ranges from the xattrs of the chunk file.
+ *
+ * Note: Missing (or unusable) xattrs are not an error, they just mean that the checksums are
+ * unknown.
+ */
+FhgfsOpsErr ChunkChecksums::load(int fd)
+{
+   std::vector<size_t> rangeIndices;
+
+   ranges.clear();
+
+   if(!listRanges(fd, rangeIndices) )
+      return FhgfsOpsErrTk::fromSysErr(errno);
+
+   for(size_t rangeIndex : rangeIndices)
+   {
+      FhgfsOpsErr loadRes = loadRangeIndex(fd, rangeIndex);
+      if(loadRes != FhgfsOpsErr_SUCCESS)
+         return loadRes;
+   }
+
+   return FhgfsOpsErr_SUCCESS;
+}
+
+/**
+ * (Re-)load the checksums of the ranges that contain the given blocks. The other loaded ranges
+ * are kept.
+ */
+FhgfsOpsErr ChunkChecksums::loadRange(int fd, size_t firstBlock, size_t lastBlock)
+{
+   for(size_t rangeIndex = firstBlock / CHUNKCHECKSUMS_RANGE_BLOCKS;
+       rangeIndex <= lastBlock / CHUNKCHECKSUMS_RANGE_BLOCKS; rangeIndex++)
+   {
+      FhgfsOpsErr loadRes = loadRangeIndex(fd, rangeIndex);
+      if(loadRes != FhgfsOpsErr_SUCCESS)
+         return loadRes;
+   }
+
+   return FhgfsOpsErr_SUCCESS;
+}
+
+FhgfsOpsErr ChunkChecksums::loadRangeIndex(int fd, size_t rangeIndex)
+{
+   const std::string xattrName = getXAttrName(rangeIndex);
+   Range& range = ranges[rangeIndex];
+
+   range.entries.clear();
+   range.isDirty = false;
+
+   // (a range has a fixed maximum size, so no need to query the size first)
+   char buf[sizeof(ChunkChecksumsHeader) + CHUNKCHECKSUMS_RANGE_BLOCKS * sizeof(Entry)];
+
+   ssize_t size = fgetxattr(fd, xattrName.c_str(), buf, sizeof(buf) );
+   if(size == -1)
+   {
+      if( (errno == ENODATA) || (errno == ENOTSUP) || (errno == ERANGE) )
+         return FhgfsOpsErr_SUCCESS; // (ERANGE: invalid => unknown, will be overwritten on store)
+
+      return FhgfsOpsErrTk::fromSysErr(errno);
+   }
+
+   ChunkChecksumsHeader header;
+
+   if( ( (size_t)size < sizeof(header) ) || ( (size - sizeof(header) ) % sizeof(Entry) ) )
+      return FhgfsOpsErr_SUCCESS; // invalid => treat as unknown (will be overwritten on store)
+
+   memcpy(&header, buf, sizeof(header) );
+
+   if( (header.formatVersion != CHUNKCHECKSUMS_FORMAT_VERSION) ||
+       (header.blockSize != CHUNKCHECKSUMS_BLOCK_SIZE) )
+      return FhgfsOpsErr_SUCCESS;
+
+   range.entries.resize( (size - sizeof(header) ) / sizeof(Entry) );
+   memcpy(range.entries.data(), buf + sizeof(header), range.entries.size() * sizeof(Entry) );
+
+   return FhgfsOpsErr_SUCCESS;
+}
+
+/**
+ * Store the checksums of the modified ranges in the xattrs of the chunk file. If that is not
+ * possible for a range (e.g. because the file system has no more space for xattrs of the file),
+ * the xattr of the range is removed to not leave outdated checksums behind.
+ *
+ * @return the error of the first range that couldn't be stored (the other ranges are stored
+ *    anyway).
+ */
+FhgfsOpsErr ChunkChecksums::store(int fd)
+{
+   FhgfsOpsErr retVal = FhgfsOpsErr_SUCCESS;
+
+   for(auto& rangeIter : ranges)
+   {
+      if(!rangeIter.second.isDirty)
+         continue;
+
+      FhgfsOpsErr storeRes = storeRangeIndex(fd, rangeIter.first, rangeIter.second);
+      if(retVal == FhgfsOpsErr_SUCCESS)
+         retVal = storeRes;
+   }
+
+   return retVal;
+}
+
+FhgfsOpsErr ChunkChecksums::storeRangeIndex(int fd, size_t rangeIndex, Range& range)
+{
+   static std::atomic<bool> storeErrLogged(false);
+
+   const std::string xattrName = getXAttrName(rangeIndex);
+   std::vector<Entry>& entries = range.entries;
+
+   range.isDirty = false;
+
+   // trailing unknown entries don't need to be stored
+   while(!entries.empty() && !entries.back().len)
+      entries.pop_back();
+
+   if(entries.empty() )
+   {
+      fremovexattr(fd, xattrName.c_str() ); // (ENODATA is fine)
+      return FhgfsOpsErr_SUCCESS;
+   }
+
+   ChunkChecksumsHeader header = { CHUNKCHECKSUMS_FORMAT_VERSION, CHUNKCHECKSUMS_BLOCK_SIZE };
+   char buf[sizeof(header) + CHUNKCHECKSUMS_RANGE_BLOCKS * sizeof(Entry)];
+   const size_t bufLen = sizeof(header) + entries.size() * sizeof(Entry);
+
+   memcpy(buf, &header, sizeof(header) );
+   memcpy(buf + sizeof(header), entries.data(), entries.size() * sizeof(Entry) );
+
+   if(!fsetxattr(fd, xattrName.c_str(), buf, bufLen, 0) )
+      return FhgfsOpsErr_SUCCESS;
+
+   const int errCode = errno;
+
+   if(!storeErrLogged.exchange(true) )
+      LogContext(__func__).log(Log_WARNING, "Unable to store chunk checksums. "
+         "(Logged only once.) "
+         "Range: " + StringTk::uintToStr(rangeIndex) + "; "
+         "SysErr: " + System::getErrString(errCode) );
+
+   fremovexattr(fd, xattrName.c_str() );
+   entries.clear();
+
+   return FhgfsOpsErrTk::fromSysErr(errCode);
+}
+
+/**
+ * @return true if the chunk file has stored checksums for at least one range
+ */
+bool ChunkChecksums::exists(int fd)
+{
+   std::vector<size_t> rangeIndices;
+
+   return listRanges(fd, rangeIndices) && !rangeIndices.empty();
+}
+
+/**
+ * Drop the checksums of all blocks from the block that contains newSize onwards (the last block
+ * might have changed its length and the rest doesn't exist anymore or only contains zeros).
+ */
+void ChunkChecksums::truncate(int fd, off_t newSize)
+{
+   const size_t numKeptBlocks = newSize / CHUNKCHECKSUMS_BLOCK_SIZE;
+   std::vector<size_t> rangeIndices;
+
+   if(!listRanges(fd, rangeIndices) )
+      return; // (no xattr support => nothing stored)
+
+   for(size_t rangeIndex : rangeIndices)
+   {
+      const size_t rangeFirstBlock = rangeIndex * CHUNKCHECKSUMS_RANGE_BLOCKS;
+
+      if(rangeFirstBlock >= numKeptBlocks)
+      { // range is completely cut off
+         fremovexattr(fd, getXAttrName(rangeIndex).c_str() );
+         continue;
+      }
+
+      if(rangeFirstBlock + CHUNKCHECKSUMS_RANGE_BLOCKS <= numKeptBlocks)
+         continue; // range is completely kept
+
+      ChunkChecksums checksums;
+
+      if(checksums.loadRangeIndex(fd, rangeIndex) != FhgfsOpsErr_SUCCESS)
+      {
+         fremovexattr(fd, getXAttrName(rangeIndex).c_str() );
+         continue;
+      }
+
+      Range& range = checksums.ranges[rangeIndex];
+
+      if(range.entries.size() <= numKeptBlocks - rangeFirstBlock)
+         continue; // nothing to do
+
+      range.entries.resize(numKeptBlocks - rangeFirstBlock);
+      range.isDirty = true;
+
+      checksums.store(fd);
+   }
+}
+
+/**
+ * Remove all checksums of the chunk file (e.g. because it was modified without updating them).
+ */
+void ChunkChecksums::invalidate(int fd)
+{
+   std::vector<size_t> rangeIndices;
+
+   listRanges(fd, rangeIndices);
+
+   for(size_t rangeIndex : rangeIndices)
+      fremovexattr(fd, getXAttrName(rangeIndex).c_str() ); // (ENODATA is fine)
+}
+
+/**
+ * Get the indices of the ranges that have an xattr.
+ *
+ * @return false on error (with errno set); a file system without xattr support is not an error.
+ */
+bool ChunkChecksums::listRanges(int fd, std::vector<size_t>& outRangeIndices)
+{
+   const size_t prefixLen = strlen(CHUNKCHECKSUMS_XATTR_PREFIX);
+   std::vector<char> buf;
+   ssize_t size;
+
+   do
+   {
+      size = flistxattr(fd, NULL, 0);
+      if(size == -1)
+         return (errno == ENOTSUP);
+
+      if(!size)
+         return true;
+
+      buf.resize(size);
+
+      size = flistxattr(fd, buf.data(), buf.size() );
+   } while( (size == -1) && (errno == ERANGE) ); // (another xattr was added in between)
+
+   if(size == -1)
+      return false;
+
+   for(const char* name = buf.data(); name < buf.data() + size; name += strlen(name) + 1)
+   {
+      if(strncmp(name, CHUNKCHECKSUMS_XATTR_PREFIX, prefixLen) || !name[prefixLen])
+         continue;
+
+      char* indexEnd;
+      const unsigned long long rangeIndex = strtoull(name + prefixLen, &indexEnd, 10);
+
+      if(!*indexEnd)
+         outRangeIndices.push_back(rangeIndex);
+   }
+
+   return true;
+}
+
+std::string ChunkChecksums::getXAttrName(size_t rangeIndex)
+{
+   return CHUNKCHECKSUMS_XATTR_PREFIX + StringTk::uint64ToStr(rangeIndex);
+}
+
+/**
+ * Note: The range of the block should be loaded, otherwise the other entries of the range are
+ * unknown afterwards.
+ */
+void ChunkChecksums::setEntry(size_t blockIndex, uint32_t crc, uint32_t len)
+{
+   Range& range = ranges[blockIndex / CHUNKCHECKSUMS_RANGE_BLOCKS];
+   const size_t entryIndex = blockIndex % CHUNKCHECKSUMS_RANGE_BLOCKS;
+
+   if(entryIndex >= range.entries.size() )
+      range.entries.resize(entryIndex + 1, Entry{0, 0} );
+
+   range.entries[entryIndex] = Entry{crc, len};
+   range.isDirty = true;
+}
+
+/**
+ * Mark the checksums of all blocks that overlap the given range as unknown (only in the loaded
+ * ranges).
+ *
+ * @return true if a known checksum was affected
+ */
+bool ChunkChecksums::invalidateRange(off_t offset, size_t len)
+{
+   bool retVal = false;
+
+   if(!len)
+      return retVal;
+
+   const size_t firstBlock = offset / CHUNKCHECKSUMS_BLOCK_SIZE;
+   const size_t lastBlock = (offset + len - 1) / CHUNKCHECKSUMS_BLOCK_SIZE;
+
+   for(size_t i = firstBlock; i <= lastBlock; i++)
+   {
+      std::map<size_t, Range>::iterator iter = ranges.find(i / CHUNKCHECKSUMS_RANGE_BLOCKS);
+      if(iter == ranges.end() )
+      { // (skip to the next range)
+         i = (i / CHUNKCHECKSUMS_RANGE_BLOCKS + 1) * CHUNKCHECKSUMS_RANGE_BLOCKS - 1;
+         continue;
+      }
+
+      std::vector<Entry>& entries = iter->second.entries;
+      const size_t entryIndex = i % CHUNKCHECKSUMS_RANGE_BLOCKS;
+
+      if( (entryIndex >= entries.size() ) || !entries[entryIndex].len)
+         continue;
+
+      entries[entryIndex] = Entry{0, 0};
+      iter->second.isDirty = true;
+      retVal = true;
+   }
+
+   return retVal;
+}
+
+
+Mutex ChunkChecksumWriter::activeWritesMutex;
+ChunkChecksumWriter::ActiveWriteMap ChunkChecksumWriter::activeWrites;
+
+/**
+ * @param chunkLockStore to lock the chunk during begin() and finish(); NULL if the caller holds
+ *    the chunk lock anyway.
+ * @param fd of the chunk file (doesn't need to be readable)
+ * @param offset file offset of the write
+ * @param count length of the write (the data is passed via update() )
+ */
+ChunkChecksumWriter::ChunkChecksumWriter(ChunkLockStore* chunkLockStore, uint16_t targetID,
+   const std::string& chunkID, int fd, off_t offset, size_t count) :
+   chunkLockStore(chunkLockStore), targetID(targetID), chunkID(chunkID), fd(fd), offset(offset),
+   count(count), activeWrite(), isActive(false), currentBlock(offset / CHUNKCHECKSUMS_BLOCK_SIZE),
+   currentCrc(0), currentLen(offset % CHUNKCHECKSUMS_BLOCK_SIZE),
+   isCurrentBlockPartial(currentLen != 0)
+{
+}
+
+ChunkChecksumWriter::~ChunkChecksumWriter()
+{
+   std::vector<std::pair<size_t, size_t> > otherBlockRanges;
+
+   // (the checksums of the range stay unknown, as begin() left them)
+   endActiveWrite(otherBlockRanges);
+}
+
+/**
+ * Called before the data is written: Marks the checksums of the written range as unknown.
+ */
+void ChunkChecksumWriter::begin()
+{
+   if(!count)
+      return;
+
+   // reopen the chunk file for reading the partial blocks (sessions of writes are write-only)
+   const std::string procPath = "/proc/self/fd/" + StringTk::intToStr(fd);
+
+   readFD.reset(open(procPath.c_str(), O_RDONLY | O_NOATIME) );
+   if(!readFD.valid() )
+      readFD.reset(open(procPath.c_str(), O_RDONLY) ); // (O_NOATIME needs file ownership)
+
+   activeWrite.firstBlock = offset / CHUNKCHECKSUMS_BLOCK_SIZE;
+   activeWrite.lastBlock = (offset + count - 1) / CHUNKCHECKSUMS_BLOCK_SIZE;
+   activeWrite.overlapped = false;
+
+   lockChunk();
+
+   {
+      const std::lock_guard<Mutex> lock(activeWritesMutex);
+
+      std::list<ActiveWrite*>& chunkWrites = activeWrites[getActiveWriteKey(targetID, chunkID)];
+
+      for(ActiveWrite* otherWrite : chunkWrites)
+      {
+         if( (otherWrite->lastBlock < activeWrite.firstBlock) ||
+             (otherWrite->firstBlock > activeWrite.lastBlock) )
+            continue;
+
+         otherWrite->overlapped = true;
+         activeWrite.overlapped = true;
+      }
+
+      chunkWrites.push_back(&activeWrite);
+      isActive = true;
+   }
+
+   ChunkChecksums checksums;
+
+   if(checksums.loadRange(fd, activeWrite.firstBlock, activeWrite.lastBlock) !=
+      FhgfsOpsErr_SUCCESS)
+      ChunkChecksums::invalidate(fd);
+   else
+   if(checksums.invalidateRange(offset, count) )
+      checksums.store(fd);
+
+   unlockChunk();
+}
+
+/**
+ * Add the next part of the written data.
+ */
+void ChunkChecksumWriter::update(const char* buf, size_t len)
+{
+   while(len)
+   {
+      const size_t updateLen = BEEGFS_MIN(len, CHUNKCHECKSUMS_BLOCK_SIZE - currentLen);
+
+      // (partial blocks are read back in finish(), so no need to compute their crc here)
+      if(!isCurrentBlockPartial)
+         currentCrc = ChecksumTk::crc32c(currentCrc, buf, updateLen);
+
+      currentLen += updateLen;
+
+      buf += updateLen;
+      len -= updateLen;
+
+      if(currentLen == CHUNKCHECKSUMS_BLOCK_SIZE)
+      {
+         if(!isCurrentBlockPartial)
+            newEntries.push_back({currentBlock, {currentCrc, (uint32_t)currentLen} });
+
+         currentBlock++;
+         currentCrc = 0;
+         currentLen = 0;
+         isCurrentBlockPartial = false;
+      }
+   }
+}
+
+/**
+ * Called after the data was written: Sets the checksums of the written range.
+ *
+ * @param writeComplete false if not all of the data was written (or passed to update() ); the
+ * checksums of the whole range stay unknown in this case.
+ */
+void ChunkChecksumWriter::finish(bool writeComplete)
+{
+   if(!isActive)
+      return;
+
+   lockChunk();
+
+   std::vector<std::pair<size_t, size_t> > otherBlockRanges; // of writes that are still active
+
+   const bool overlapped = endActiveWrite(otherBlockRanges);
+
+   if(!writeComplete)
+   {
+      unlockChunk();
+      return;
+   }
+
+   ChunkChecksums checksums;
+
+   if(checksums.loadRange(fd, activeWrite.firstBlock, activeWrite.lastBlock) !=
+      FhgfsOpsErr_SUCCESS)
+   { // (the xattrs might be corrupt, so start with unknown checksums for all blocks)
+      ChunkChecksums::invalidate(fd);
+      checksums = ChunkChecksums();
+   }
+
+   std::vector<std::pair<size_t, ChunkChecksums::Entry> >::const_iterator newEntryIter =
+      newEntries.begin();
+
+   for(size_t blockIndex = activeWrite.firstBlock; blockIndex <= activeWrite.lastBlock;
+       blockIndex++)
+   {
+      while( (newEntryIter != newEntries.end() ) && (newEntryIter->first < blockIndex) )
+         newEntryIter++;
+
+      bool isOtherWriteActive = false;
+
+      for(const auto& blockRange : otherBlockRanges)
+         isOtherWriteActive |= (blockRange.first <= blockIndex) &&
+            (blockRange.second >= blockIndex);
+
+      if(isOtherWriteActive)
+         continue; // (the other write sets the checksum when it finishes)
+
+      if(!overlapped && (newEntryIter != newEntries.end() ) && (newEntryIter->first == blockIndex) )
+      { // block was completely covered by our data and nobody else wrote it meanwhile
+         checksums.setEntry(blockIndex, newEntryIter->second.crc, newEntryIter->second.len);
+         continue;
+      }
+
+      char* blockBuf;
+
+      ssize_t readRes = readFD.valid() ? readBlock(*readFD, blockIndex, blockBuf) : -1;
+      if(unlikely(readRes <= 0) )
+         continue; // (checksum stays unknown)
+
+      checksums.setEntry(blockIndex, ChecksumTk::crc32c(0, blockBuf, readRes), readRes);
+   }
+
+   checksums.store(fd);
+
+   unlockChunk();
+}
+
+void ChunkChecksumWriter::lockChunk()
+{
+   if(chunkLockStore)
+      chunkLockStore->lockChunk(targetID, chunkID);
+}
+
+void ChunkChecksumWriter::unlockChunk()
+{
+   if(chunkLockStore)
+      chunkLockStore->unlockChunk(targetID, chunkID);
+}
+
+/**
+ * Remove this write from the active writes of the chunk.
+ *
+ * @param outOtherBlockRanges first and last block of the other writes of the chunk that are
+ *    still active.
+ * @return true if another write to the same blocks was active during this write.
+ */
+bool ChunkChecksumWriter::endActiveWrite(
+   std::vector<std::pair<size_t, size_t> >& outOtherBlockRanges)
+{
+   if(!isActive)
+      return false;
+
+   const std::lock_guard<Mutex> lock(activeWritesMutex);
+
+   ActiveWriteMap::iterator iter = activeWrites.find(getActiveWriteKey(targetID, chunkID) );
+
+   iter->second.remove(&activeWrite);
+
+   for(const ActiveWrite* otherWrite : iter->second)
+      outOtherBlockRanges.push_back({otherWrite->firstBlock, otherWrite->lastBlock});
+
+   if(iter->second.empty() )
+      activeWrites.erase(iter);
+
+   isActive = false;
+
+   return activeWrite.overlapped;
+}
+
+/**
+ * Called on truncation of a chunk (with the chunk lock held): The active writes to the cut-off
+ * blocks can't use the checksums of their data anymore, as the truncation might have removed some
+ * of it.
+ */
+void ChunkChecksumWriter::truncateActiveWrites(uint16_t targetID, const std::string& chunkID,
+   off_t newSize)
+{
+   const std::lock_guard<Mutex> lock(activeWritesMutex);
+
+   ActiveWriteMap::iterator iter = activeWrites.find(getActiveWriteKey(targetID, chunkID) );
+   if(iter == activeWrites.end() )
+      return;
+
+   for(ActiveWrite* activeWrite : iter->second)
+   {
+      if(activeWrite->lastBlock >= (size_t)newSize / CHUNKCHECKSUMS_BLOCK_SIZE)
+         activeWrite->overlapped = true;
+   }
+}
+
+std::string ChunkChecksumWriter::getActiveWriteKey(uint16_t targetID, const std::string& chunkID)
+{
+   return StringTk::uintToStr(targetID) + "/" + chunkID;
+}
+
+
+ChunkChecksumVerifier::ChunkChecksumVerifier(int fd, uint16_t targetID,
+   const std::string& chunkID) :
+   fd(fd), targetID(targetID), chunkID(chunkID), hasChecksums(ChunkChecksums::exists(fd) ),
+   verifiedEnd(0)
+{
+}
+
+/**
+ * Verify all blocks that overlap the given buffer (unless they were verified before).
+ *
+ * @param buf contains the data of the chunk file at offset
+ * @param isEOF true if the buffer ends at the end of the chunk file
+ * @param outBadBlockIndex index of the block that didn't match its checksum
+ * @return false if a block didn't match its checksum
+ */
+bool ChunkChecksumVerifier::verify(const char* buf, off_t offset, size_t len, bool isEOF,
+   size_t& outBadBlockIndex)
+{
+   if(!len)
+      return true;
+
+   const size_t firstBlock = offset / CHUNKCHECKSUMS_BLOCK_SIZE;
+   const size_t lastBlock = (offset + len - 1) / CHUNKCHECKSUMS_BLOCK_SIZE;
+
+   for(size_t blockIndex = firstBlock; blockIndex <= lastBlock; blockIndex++)
+   {
+      const off_t blockStart = (off_t)blockIndex * CHUNKCHECKSUMS_BLOCK_SIZE;
+
+      if(blockStart < verifiedEnd)
+         continue; // already verified with previous buffer
+
+      verifiedEnd = blockStart + CHUNKCHECKSUMS_BLOCK_SIZE;
+
+      if(!checksums.isLoaded(blockIndex) )
+         checksums.loadRange(fd, blockIndex, blockIndex); // (on error, nothing to verify)
+
+      const ChunkChecksums::Entry* entry = checksums.getEntry(blockIndex);
+      if(!entry)
+         continue; // unknown
+
+      uint32_t crc;
+      size_t blockLen;
+
+      if( (blockStart >= offset) &&
+          ( (blockStart + CHUNKCHECKSUMS_BLOCK_SIZE <= offset + (off_t)len) || isEOF) )
+      { // block is completely contained in the buffer
+         blockLen = BEEGFS_MIN( (off_t)CHUNKCHECKSUMS_BLOCK_SIZE, offset + (off_t)len - blockStart);
+         crc = ChecksumTk::crc32c(0, buf + (blockStart - offset), blockLen);
+      }
+      else
+      { // block is only partially contained in the buffer => read it completely
+         char* blockBuf;
+
+         ssize_t readRes = readBlock(fd, blockIndex, blockBuf);
+         if(unlikely(readRes == -1) )
+            continue; // can't verify (but the buffer was read fine)
+
+         blockLen = readRes;
+         crc = ChecksumTk::crc32c(0, blockBuf, blockLen);
+      }
+
+      if(blockLen != entry->len)
+         continue; // length changed (e.g. file was extended) => checksum unknown
+
+      if(likely(crc == entry->crc) || recheckLocked(blockIndex) )
+         continue;
+
+      outBadBlockIndex = blockIndex;
+      return false;
+   }
+
+   return true;
+}
+
+/**
+ * Re-check a block that didn't match with the chunk lock held, because it might have been
+ * modified by a concurrent write before the writer updated the checksums.
+ *
+ * @return true if the block matches now (or its checksum is unknown now)
+ */
+bool ChunkChecksumVerifier::recheckLocked(size_t blockIndex)
+{
+   ChunkLockStore* chunkLockStore = Program::getApp()->getChunkLockStore();
+   bool retVal = true;
+
+   chunkLockStore->lockChunk(targetID, chunkID);
+
+   checksums.loadRange(fd, blockIndex, blockIndex);
+
+   const ChunkChecksums::Entry* entry = checksums.getEntry(blockIndex);
+   char* blockBuf;
+
+   ssize_t readRes = entry ? readBlock(fd, blockIndex, blockBuf) : -1;
+
+   if( (readRes != -1) && ( (size_t)readRes == entry->len) )
+      retVal = (ChecksumTk::crc32c(0, blockBuf, readRes) == entry->crc);
+
+   chunkLockStore->unlockChunk(targetID, chunkID);
+
+   return retVal;
+}
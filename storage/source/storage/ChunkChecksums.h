@@ -0,0 +1,209 @@
+#pragma once
+
+#include <common/Common.h>
+#include <common/storage/StorageErrors.h>
+#include <common/threading/Mutex.h>
+#include <common/toolkit/FDHandle.h>
+#include <storage/ChunkLockStore.h>
+
+#include <list>
+#include <map>
+#include <vector>
+
+
+#define CHUNKCHECKSUMS_BLOCK_SIZE      (64*1024)
+#define CHUNKCHECKSUMS_RANGE_BLOCKS    256 /* blocks per xattr (16MiB of data in ~2KiB) */
+#define CHUNKCHECKSUMS_XATTR_PREFIX    "user.beegfs.chunkcrc." /* + range index */
+#define CHUNKCHECKSUMS_FORMAT_VERSION  1
+
+
+/**
+ * Per-block CRC32C checksums of a chunk file, stored in xattrs of the chunk file.
+ *
+ * Each block of CHUNKCHECKSUMS_BLOCK_SIZE has an entry with its crc and the length of the data
+ * that the crc covers (shorter than the block size for the last block of a chunk). Entries with
+ * length 0 are unknown, e.g. for blocks that were written before checksums were enabled. A block
+ * with a known entry is only verified if its current length still matches (other changes of the
+ * length, like truncation, invalidate the entries via truncate() ).
+ *
+ * The entries are split into ranges of CHUNKCHECKSUMS_RANGE_BLOCKS blocks with an xattr per
+ * range, so that the xattr values stay small (e.g. ext4 limits a value to a block) and writes
+ * only need to load and store the ranges they touch. Only the loaded ranges are accessible.
+ */
+class ChunkChecksums
+{
+   public:
+      struct Entry
+      {
+         uint32_t crc;
+         uint32_t len; // 0 means unknown
+      };
+
+      ChunkChecksums() {}
+
+      FhgfsOpsErr load(int fd);
+      FhgfsOpsErr loadRange(int fd, size_t firstBlock, size_t lastBlock);
+      FhgfsOpsErr store(int fd);
+
+      static bool exists(int fd);
+      static void truncate(int fd, off_t newSize);
+      static void invalidate(int fd);
+
+      void setEntry(size_t blockIndex, uint32_t crc, uint32_t len);
+      bool invalidateRange(off_t offset, size_t len);
+
+
+   private:
+      struct Range
+      {
+         std::vector<Entry> entries; // (trailing unknown entries might be missing)
+         bool isDirty; // true if modified since load
+      };
+
+      std::map<size_t, Range> ranges; // key: range index; contains the loaded ranges
+
+      FhgfsOpsErr loadRangeIndex(int fd, size_t rangeIndex);
+      FhgfsOpsErr storeRangeIndex(int fd, size_t rangeIndex, Range& range);
+
+      static bool listRanges(int fd, std::vector<size_t>& outRangeIndices);
+      static std::string getXAttrName(size_t rangeIndex);
+
+
+   public:
+      // inliners
+
+      /**
+       * @return NULL if the checksum of the block is unknown (or its range isn't loaded)
+       */
+      const Entry* getEntry(size_t blockIndex) const
+      {
+         std::map<size_t, Range>::const_iterator iter =
+            ranges.find(blockIndex / CHUNKCHECKSUMS_RANGE_BLOCKS);
+
+         if(iter == ranges.end() )
+            return NULL;
+
+         const std::vector<Entry>& entries = iter->second.entries;
+         const size_t entryIndex = blockIndex % CHUNKCHECKSUMS_RANGE_BLOCKS;
+
+         if( (entryIndex >= entries.size() ) || !entries[entryIndex].len)
+            return NULL;
+
+         return &entries[entryIndex];
+      }
+
+      bool isLoaded(size_t blockIndex) const
+      {
+         return ranges.count(blockIndex / CHUNKCHECKSUMS_RANGE_BLOCKS) != 0;
+      }
+};
+
+
+/**
+ * Updates the checksums for a write request: begin() before the data is written, update() with
+ * the written data and finish() afterwards.
+ *
+ * begin() marks the checksums of the written range as unknown, so that readers don't verify
+ * against outdated checksums while the data is being written. finish() sets the new checksums;
+ * they are taken from the data that was passed to update() for blocks that are completely
+ * covered by the write, the partial first and last block are read back from the chunk file.
+ * Writes to the same blocks may run concurrently (the chunk lock is only held during begin()
+ * and finish() ): Blocks that are still being written by another request stay unknown until that
+ * request finishes, and if the blocks of a write were also written by another request in the
+ * meantime, all of them are read back from the chunk file instead.
+ */
+class ChunkChecksumWriter
+{
+   public:
+      ChunkChecksumWriter(ChunkLockStore* chunkLockStore, uint16_t targetID,
+         const std::string& chunkID, int fd, off_t offset, size_t count);
+      ~ChunkChecksumWriter();
+
+      ChunkChecksumWriter(const ChunkChecksumWriter&) = delete;
+      ChunkChecksumWriter& operator=(const ChunkChecksumWriter&) = delete;
+
+      void begin();
+      void update(const char* buf, size_t len);
+      void finish(bool writeComplete);
+
+      static void truncateActiveWrites(uint16_t targetID, const std::string& chunkID,
+         off_t newSize);
+
+
+   private:
+      struct ActiveWrite
+      {
+         size_t firstBlock;
+         size_t lastBlock;
+         bool overlapped; // true if another write to the same blocks was active meanwhile
+      };
+
+      typedef std::map<std::string, std::list<ActiveWrite*> > ActiveWriteMap; // key: target+chunk
+
+      static Mutex activeWritesMutex;
+      static ActiveWriteMap activeWrites; // writes between begin() and finish()
+
+      ChunkLockStore* chunkLockStore; // NULL if the caller holds the chunk lock anyway
+      uint16_t targetID;
+      std::string chunkID;
+      int fd;
+      FDHandle readFD; // the session fd of a write might not be readable
+      off_t offset;
+      size_t count;
+
+      ActiveWrite activeWrite;
+      bool isActive; // true if begin() was called and finish() was not
+
+      size_t currentBlock;
+      uint32_t currentCrc;
+      size_t currentLen; // bytes of currentBlock covered by currentCrc
+      bool isCurrentBlockPartial; // true if the write started in the middle of currentBlock
+
+      std::vector<std::pair<size_t, ChunkChecksums::Entry> > newEntries; // of complete blocks
+
+      void lockChunk();
+      void unlockChunk();
+      bool endActiveWrite(std::vector<std::pair<size_t, size_t> >& outOtherBlockRanges);
+
+      static std::string getActiveWriteKey(uint16_t targetID, const std::string& chunkID);
+};
+
+
+/**
+ * Verifies the data of a read request against the stored checksums. The read data is passed in
+ * sequentially via verify(); blocks that are only partially contained in the given buffer are
+ * read completely from the chunk file to verify them before the data of the buffer is sent.
+ */
+class ChunkChecksumVerifier
+{
+   public:
+      ChunkChecksumVerifier(int fd, uint16_t targetID, const std::string& chunkID);
+
+      bool verify(const char* buf, off_t offset, size_t len, bool isEOF,
+         size_t& outBadBlockIndex);
+
+
+   private:
+      int fd;
+      uint16_t targetID;
+      std::string chunkID;
+
+      ChunkChecksums checksums; // ranges are loaded as the read reaches them
+      bool hasChecksums;
+      off_t verifiedEnd; // end offset of the blocks which were already verified
+
+      bool recheckLocked(size_t blockIndex);
+
+
+   public:
+      // inliners
+
+      /**
+       * @return false if the chunk has no stored checksums (so there's nothing to verify).
+       */
+      bool isActive() const
+      {
+         return hasChecksums;
+      }
+};
+
@@ -5,8 +5,8 @@
 #include "ChunkStore.h"
 
 
-#define CHUNKSTORE_REFCACHE_REMOVE_SKIP_SYNC   (4) /* n-th elements to be removed on sync sweep */
-#define CHUNKSTORE_REFCACHE_REMOVE_SKIP_ASYNC  (3) /* n-th elements to be removed on async sweep */
+#define CHUNKSTORE_REFCACHE_ASYNC_EVICT_DIVISOR  (3) /* max 1/n of the elements evicted per
+                                                       async sweep (to limit lock hold time) */
 
 /**
   * not inlined as we need to include <program/Program.h>
@@ -16,14 +16,18 @@ ChunkStore::ChunkStore()
    App* app = Program::getApp();
    Config* cfg = app->getConfig();
 
-   this->refCacheSyncLimit = cfg->getTuneDirCacheLimit();
+   // the configured limit is for the whole store, so split it among the shards
+   const size_t cacheLimit = cfg->getTuneDirCacheLimit();
+
+   this->refCacheSyncLimit = std::max<size_t>(cacheLimit / CHUNKSTORE_NUM_SHARDS, 1);
    this->refCacheAsyncLimit = refCacheSyncLimit - (refCacheSyncLimit/2);
 }
 
 bool ChunkStore::dirInStoreUnlocked(std::string dirID)
 {
-   DirectoryMapIter iter = this->dirs.find(dirID);
-   return iter != this->dirs.end();
+   Shard& shard = getShard(dirID);
+
+   return shard.dirs.find(dirID) != shard.dirs.end();
 }
 
 
@@ -43,14 +47,16 @@ ChunkDir* ChunkStore::referenceDir(std::string dirID)
                                * rather expensive.
                                * Note: when set to false we also need a write-lock! */
 
-   SafeRWLock safeLock(&this->rwlock, SafeRWLock_READ); // L O C K
+   Shard& shard = getShard(dirID);
+
+   SafeRWLock safeLock(&shard.rwlock, SafeRWLock_READ); // L O C K
 
    DirectoryMapIter iter;
    int retries = 0; // 0 -> read-locked
    while (retries < RWLOCK_LOCK_UPGRADE_RACY_RETRIES) // one as read-lock and one as write-lock
    {
-      iter = this->dirs.find(dirID);
-      if (iter == this->dirs.end() && retries == 0)
+      iter = shard.dirs.find(dirID);
+      if (iter == shard.dirs.end() && retries == 0)
       {
          safeLock.unlock();
          safeLock.lock(SafeRWLock_WRITE);
@@ -58,13 +64,15 @@ ChunkDir* ChunkStore::referenceDir(std::string dirID)
       retries++;
    }
 
-   if(iter == this->dirs.end() )
+   if(iter == shard.dirs.end() )
    { // Not in map yet => try to load it. We must be write-locked here!
-      InsertChunkDirUnlocked(dirID, iter); // (will set "iter != end" if loaded)
+      InsertChunkDirUnlocked(shard, dirID, iter); // (will set "iter != end" if loaded)
       wasReferenced = false;
    }
+   else
+      shard.refCache.touch(dirID); // (safe under read lock)
 
-   if (likely(iter != dirs.end() ) )
+   if (likely(iter != shard.dirs.end() ) )
    { // exists in map
       ChunkDirReferencer* dirRefer = iter->second;
 
@@ -75,7 +83,7 @@ ChunkDir* ChunkStore::referenceDir(std::string dirID)
       IGNORE_UNUSED_VARIABLE(logContext);
 
       if (!wasReferenced)
-         cacheAddUnlocked(dirID, dirRefer);
+         cacheAddUnlocked(shard, dirID, dirRefer);
 
    }
 
@@ -89,19 +97,21 @@ ChunkDir* ChunkStore::referenceDir(std::string dirID)
  */
 void ChunkStore::releaseDir(std::string dirID)
 {
-   SafeRWLock safeLock(&this->rwlock, SafeRWLock_WRITE); // L O C K
+   Shard& shard = getShard(dirID);
+
+   SafeRWLock safeLock(&shard.rwlock, SafeRWLock_WRITE); // L O C K
 
-   releaseDirUnlocked(dirID);
+   releaseDirUnlocked(shard, dirID);
 
    safeLock.unlock(); // U N L O C K
 }
 
-void ChunkStore::releaseDirUnlocked(std::string dirID)
+void ChunkStore::releaseDirUnlocked(Shard& shard, std::string dirID)
 {
    const char* logContext = "DirReferencer releaseChunkDir";
 
-   DirectoryMapIter iter = this->dirs.find(dirID);
-   if(likely(iter != this->dirs.end() ) )
+   DirectoryMapIter iter = shard.dirs.find(dirID);
+   if(likely(iter != shard.dirs.end() ) )
    { // dir exists => decrease refCount
       ChunkDirReferencer* dirRefer = iter->second;
 
@@ -115,7 +125,7 @@ void ChunkStore::releaseDirUnlocked(std::string dirID)
          if(!dirRefer->getRefCount() )
          {  // dropped last reference => unload dir
             delete(dirRefer);
-            this->dirs.erase(iter);
+            shard.dirs.erase(iter);
          }
       }
       else
@@ -123,7 +133,7 @@ void ChunkStore::releaseDirUnlocked(std::string dirID)
          std::string logMsg = std::string("Bug: Refusing to release dir with a zero refCount") +
             std::string("dirID: ") + dirID;
          LogContext(logContext).logErr(logMsg);
-         this->dirs.erase(iter);
+         shard.dirs.erase(iter);
       }
    }
    else
@@ -143,21 +153,22 @@ void ChunkStore::releaseDirUnlocked(std::string dirID)
  *
  * @return newElemIter only valid if true is returned, untouched otherwise
  */
-void ChunkStore::InsertChunkDirUnlocked(std::string dirID, DirectoryMapIter& newElemIter)
+void ChunkStore::InsertChunkDirUnlocked(Shard& shard, std::string dirID,
+   DirectoryMapIter& newElemIter)
 {
    ChunkDir* inode = new ChunkDir(dirID);
    if (unlikely (!inode) )
       return;
 
    std::pair<DirectoryMapIter, bool> pairRes =
-      this->dirs.insert(DirectoryMapVal(dirID, new ChunkDirReferencer(inode) ) );
+      shard.dirs.insert(DirectoryMapVal(dirID, new ChunkDirReferencer(inode) ) );
 
    if (!pairRes.second)
    {
       // element already exists in the map, we raced with another thread
       delete inode;
 
-      newElemIter = this->dirs.find(dirID);
+      newElemIter = shard.dirs.find(dirID);
    }
    else
    {
@@ -169,20 +180,24 @@ void ChunkStore::InsertChunkDirUnlocked(std::string dirID, DirectoryMapIter& new
 
 void ChunkStore::clearStoreUnlocked()
 {
-   LOG_DEBUG("DirectoryStore::clearStoreUnlocked", Log_DEBUG,
-      std::string("# of loaded entries to be cleared: ") + StringTk::intToStr(dirs.size() ) );
+   for (Shard& shard : shards)
+   {
+      LOG_DEBUG("DirectoryStore::clearStoreUnlocked", Log_DEBUG,
+         std::string("# of loaded entries to be cleared: ") +
+         StringTk::intToStr(shard.dirs.size() ) );
 
-   cacheRemoveAllUnlocked();
+      cacheRemoveAllUnlocked(shard);
 
-   for(DirectoryMapIter iter = dirs.begin(); iter != dirs.end(); iter++)
-   {
-      ChunkDirReferencer* dirRef = iter->second;
+      for(DirectoryMapIter iter = shard.dirs.begin(); iter != shard.dirs.end(); iter++)
+      {
+         ChunkDirReferencer* dirRef = iter->second;
 
-      // will also call destructor for dirInode and sub-objects as dirInode->fileStore
-      delete(dirRef);
-   }
+         // will also call destructor for dirInode and sub-objects as dirInode->fileStore
+         delete(dirRef);
+      }
 
-   dirs.clear();
+      shard.dirs.clear();
+   }
 }
 
 /**
@@ -190,14 +205,14 @@ void ChunkStore::clearStoreUnlocked()
  * (otherwise it might happen that the new element is deleted during sweep if it was cached
  * before and appears to be unneeded now).
  */
-void ChunkStore::cacheAddUnlocked(std::string& dirID, ChunkDirReferencer* dirRefer)
+void ChunkStore::cacheAddUnlocked(Shard& shard, std::string& dirID, ChunkDirReferencer* dirRefer)
 {
    const char* logContext = "DirReferencer cache add ChunkDir";
 
    // (we do cache sweeping before insertion to make sure we don't sweep the new entry)
-   cacheSweepUnlocked(true);
+   cacheSweepUnlocked(shard, true);
 
-   if(refCache.insert(DirCacheMapVal(dirID, dirRefer) ).second)
+   if(shard.refCache.insert(dirID, dirRefer) )
    { // new insert => inc refcount
       dirRefer->reference();
 
@@ -208,96 +223,51 @@ void ChunkStore::cacheAddUnlocked(std::string& dirID, ChunkDirReferencer* dirRef
 
 }
 
-void ChunkStore::cacheRemoveUnlocked(std::string& dirID)
+void ChunkStore::cacheRemoveUnlocked(Shard& shard, std::string& dirID)
 {
-   DirCacheMapIter iter = refCache.find(dirID);
-   if(iter == refCache.end() )
+   if(!shard.refCache.remove(dirID, NULL) )
       return;
 
-   releaseDirUnlocked(dirID);
-   refCache.erase(iter);
+   releaseDirUnlocked(shard, dirID);
 }
 
-void ChunkStore::cacheRemoveAllUnlocked()
+void ChunkStore::cacheRemoveAllUnlocked(Shard& shard)
 {
-   for(DirCacheMapIter iter = refCache.begin(); iter != refCache.end(); /* iter inc inside loop */)
-   {
-      releaseDirUnlocked(iter->first);
-
-      DirCacheMapIter iterNext(iter);
-      iterNext++;
-
-      // cppcheck-suppress erase [special comment to mute false cppcheck alarm]
-      refCache.erase(iter);
+   std::string dirID;
+   ChunkDirReferencer* dirRefer;
 
-      iter = iterNext;
-   }
+   while(shard.refCache.evict(&dirID, &dirRefer) )
+      releaseDirUnlocked(shard, dirID);
 }
 
 /**
- * @param isSyncSweep true if this is a synchronous sweep (e.g. we need to free a few elements to
+ * Evict the least recently used elements (according to the CLOCK algorithm) from the cache of
+ * the given shard.
+ *
+ * @param isSyncSweep true if this is a synchronous sweep (e.g. we need to free an element to
  * allow quick insertion of a new element), false is this is an asynchronous sweep (that might take
  * a bit longer).
  * @return true if a cache flush was triggered, false otherwise
  */
-bool ChunkStore::cacheSweepUnlocked(bool isSyncSweep)
+bool ChunkStore::cacheSweepUnlocked(Shard& shard, bool isSyncSweep)
 {
-   // sweeping means we remove every n-th element from the cache, starting with a random element
-      // in the range 0 to n
-   size_t cacheLimit;
-   size_t removeSkipNum;
-
-   // check type of sweep and set removal parameters accordingly
+   const size_t cacheLimit = isSyncSweep ? refCacheSyncLimit : refCacheAsyncLimit;
+   const size_t cacheSize = shard.refCache.size();
 
-   if(isSyncSweep)
-   { // sync sweep settings
-      cacheLimit = refCacheSyncLimit;
-      removeSkipNum = CHUNKSTORE_REFCACHE_REMOVE_SKIP_SYNC;
-   }
-   else
-   { // async sweep settings
-      cacheLimit = refCacheAsyncLimit;
-      removeSkipNum = CHUNKSTORE_REFCACHE_REMOVE_SKIP_ASYNC;
-   }
-
-   if(refCache.size() <= cacheLimit)
+   if(cacheSize <= cacheLimit)
       return false;
 
+   size_t numEvict = cacheSize - cacheLimit;
 
-   // pick a random start element (note: the element will be removed in first loop pass below)
-
-   unsigned randStart = randGen.getNextInRange(0, removeSkipNum - 1);
-   DirCacheMapIter iter = refCache.begin();
+   if(!isSyncSweep)
+      numEvict = std::min(numEvict,
+         std::max<size_t>(cacheSize / CHUNKSTORE_REFCACHE_ASYNC_EVICT_DIVISOR, 1) );
 
-   while(randStart--)
-      iter++;
+   std::string dirID;
+   ChunkDirReferencer* dirRefer;
 
-
-   // walk over all cached elements and remove every n-th element
-
-   unsigned i = removeSkipNum-1; /* counts to every n-th element ("remoteSkipNum-1" to remove the
-      random start element in the first loop pass) */
-
-   while(iter != refCache.end() )
-   {
-      i++;
-
-      if(i == removeSkipNum)
-      {
-         releaseDirUnlocked(iter->first);
-
-         DirCacheMapIter iterNext(iter);
-         iterNext++;
-
-         refCache.erase(iter);
-
-         iter = iterNext;
-
-         i = 0;
-      }
-      else
-         iter++;
-   }
+   while(numEvict-- && shard.refCache.evict(&dirID, &dirRefer) )
+      releaseDirUnlocked(shard, dirID);
 
    return true;
 }
@@ -307,18 +277,17 @@ bool ChunkStore::cacheSweepUnlocked(bool isSyncSweep)
  */
 bool ChunkStore::cacheSweepAsync()
 {
-   const char* logContext = "Async cache sweep";
-
-   //LOG_DEBUG(logContext, Log_SPAM, "Start cache sweep."); // debug in
-   IGNORE_UNUSED_VARIABLE(logContext);
+   bool retVal = false;
 
-   SafeRWLock safeLock(&rwlock, SafeRWLock_WRITE); // L O C K
-
-   bool retVal = cacheSweepUnlocked(false);
+   for (Shard& shard : shards)
+   {
+      SafeRWLock safeLock(&shard.rwlock, SafeRWLock_WRITE); // L O C K
 
-   safeLock.unlock(); // U N L O C K
+      if(cacheSweepUnlocked(shard, false) )
+         retVal = true;
 
-   // LOG_DEBUG(logContext, Log_SPAM, "Stop cache sweep."); // debug in
+      safeLock.unlock(); // U N L O C K
+   }
 
    return retVal;
 }
@@ -328,11 +297,16 @@ bool ChunkStore::cacheSweepAsync()
  */
 size_t ChunkStore::getCacheSize()
 {
-   SafeRWLock safeLock(&rwlock, SafeRWLock_READ); // L O C K
+   size_t dirsSize = 0;
 
-   size_t dirsSize = refCache.size();
+   for (Shard& shard : shards)
+   {
+      SafeRWLock safeLock(&shard.rwlock, SafeRWLock_READ); // L O C K
 
-   safeLock.unlock(); // U N L O C K
+      dirsSize += shard.refCache.size();
+
+      safeLock.unlock(); // U N L O C K
+   }
 
    return dirsSize;
 }
@@ -3,8 +3,8 @@
 #include <common/Common.h>
 #include <common/threading/Mutex.h>
 #include <common/toolkit/AtomicObjectReferencer.h>
+#include <common/toolkit/ClockCache.h>
 #include <common/toolkit/MetadataTk.h>
-#include <common/toolkit/Random.h>
 #include <common/storage/Path.h>
 #include <common/storage/StorageDefinitions.h>
 #include <common/storage/StorageErrors.h>
@@ -14,24 +14,26 @@
 
 #define PATH_DEPTH_IDENTIFIER 'l' // we use 'l' (level) instead of 'd', as d is part of hex numbers
 
+#define CHUNKSTORE_NUM_SHARDS  16 /* number of independently locked parts of the store */
+
 
 class ChunkDir;
 
 typedef AtomicObjectReferencer<ChunkDir*> ChunkDirReferencer;
-typedef std::map<std::string, ChunkDirReferencer*> DirectoryMap;
+typedef std::unordered_map<std::string, ChunkDirReferencer*> DirectoryMap;
 typedef DirectoryMap::iterator DirectoryMapIter;
 typedef DirectoryMap::const_iterator DirectoryMapCIter;
 typedef DirectoryMap::value_type DirectoryMapVal;
 
-typedef std::map<std::string, ChunkDirReferencer*> DirCacheMap; // keys are dirIDs (same as DirMap)
-typedef DirCacheMap::iterator DirCacheMapIter;
-typedef DirCacheMap::const_iterator DirCacheMapCIter;
-typedef DirCacheMap::value_type DirCacheMapVal;
+typedef ClockCache<std::string, ChunkDirReferencer*> DirRefCache; // keys are dirIDs (as DirMap)
 
 /**
  * Layer in between our inodes and the data on the underlying file system. So we read/write from/to
  * underlying files and this class is to do this corresponding data access.
  * This object is used for for _directories_ only.
+ *
+ * The dirs are distributed over CHUNKSTORE_NUM_SHARDS shards by the hash of their ID, each with
+ * its own map, reference cache (with CLOCK eviction) and lock.
  */
 class ChunkStore
 {
@@ -61,25 +63,28 @@ class ChunkStore
 
 
    private:
-      DirectoryMap dirs;
+      struct Shard
+      {
+         DirectoryMap dirs;
+         DirRefCache refCache;
+         RWLock rwlock;
+      };
 
-      size_t refCacheSyncLimit; // synchronous access limit (=> async limit plus some grace size)
-      size_t refCacheAsyncLimit; // asynchronous cleanup limit (this is what the user configures)
-      Random randGen; // for random cache removal
-      DirCacheMap refCache;
+      Shard shards[CHUNKSTORE_NUM_SHARDS];
 
-      RWLock rwlock;
+      size_t refCacheSyncLimit; // per-shard synchronous access limit (=> async limit plus grace)
+      size_t refCacheAsyncLimit; // per-shard asynchronous cleanup limit
 
-      void InsertChunkDirUnlocked(std::string dirID, DirectoryMapIter& newElemIter);
+      void InsertChunkDirUnlocked(Shard& shard, std::string dirID, DirectoryMapIter& newElemIter);
 
-      void releaseDirUnlocked(std::string dirID);
+      void releaseDirUnlocked(Shard& shard, std::string dirID);
 
       void clearStoreUnlocked();
 
-      void cacheAddUnlocked(std::string& dirID, ChunkDirReferencer* dirRefer);
-      void cacheRemoveUnlocked(std::string& dirID);
-      void cacheRemoveAllUnlocked();
-      bool cacheSweepUnlocked(bool isSyncSweep);
+      void cacheAddUnlocked(Shard& shard, std::string& dirID, ChunkDirReferencer* dirRefer);
+      void cacheRemoveUnlocked(Shard& shard, std::string& dirID);
+      void cacheRemoveAllUnlocked(Shard& shard);
+      bool cacheSweepUnlocked(Shard& shard, bool isSyncSweep);
 
       bool mkdirV2ChunkDirPath(int targetFD, const Path* chunkDirPath);
 
@@ -91,6 +96,11 @@ class ChunkStore
 
       // inlined
 
+      Shard& getShard(const std::string& dirID)
+      {
+         return shards[std::hash<std::string>()(dirID) % CHUNKSTORE_NUM_SHARDS];
+      }
+
       /**
        * Return a unique path element identifier.
        *
@@ -0,0 +1,571 @@
+#include <common/app/log/LogContext.h>
+#include "DirtyChunkJournal.h"
+
+#include <algorithm>
+
+
+#define DIRTYCHUNKJOURNAL_MAGIC           0x4a434442 // "BDCJ"
+#define DIRTYCHUNKJOURNAL_VERSION         2 // 2: coverage start time in the header
+#define DIRTYCHUNKJOURNAL_BUF_SIZE        (64*1024) // flush threshold for buffered records
+#define DIRTYCHUNKJOURNAL_READ_BUF_SIZE   (1024*1024)
+
+
+/**
+ * @param path of the journal file
+ * @param isEnabled false to remove an existing journal file (it would miss the changes made while
+ *    journaling is disabled) and not record anything.
+ * @param buddyNeedsResync current state of the buddy; a new journal is only complete if the buddy
+ *    doesn't need a resync.
+ * @param recentWindowSecs how long to remember modified chunks while not recording; 0 to not
+ *    remember them (a resync can't use the journal then).
+ */
+DirtyChunkJournal::DirtyChunkJournal(const std::string& path, bool isEnabled,
+   bool buddyNeedsResync, unsigned recentWindowSecs) :
+   path(path), fd(-1), recentWindowSecs(recentWindowSecs), complete(false), recording(false),
+   tracking(false), coverageStartSecs(0), fileSize(0), numRecordingStarts(0),
+   numRecordingStartsAtResync(0), recentPrunedUpToSecs(time(NULL) ),
+   lastRecentPruneSecs(recentPrunedUpToSecs), recordingStopSecs(0)
+{
+   if(!isEnabled)
+   {
+      if( (unlink(path.c_str() ) == -1) && (errno != ENOENT) )
+         LogContext(__func__).log(Log_WARNING, "Unable to remove dirty chunk journal: " + path +
+            ". SysErr: " + System::getErrString() );
+
+      return;
+   }
+
+   fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, S_IRUSR | S_IWUSR);
+   if(fd == -1)
+   {
+      LogContext(__func__).logErr("Unable to open dirty chunk journal: " + path +
+         ". SysErr: " + System::getErrString() );
+      return;
+   }
+
+   FileHeader header;
+   ssize_t readRes = pread(fd, &header, sizeof(header), 0);
+
+   if(readRes == 0)
+      complete = !buddyNeedsResync; // new journal
+   else
+   if( (readRes == sizeof(header) ) && (header.magic == DIRTYCHUNKJOURNAL_MAGIC) &&
+      (header.version == DIRTYCHUNKJOURNAL_VERSION) )
+   {
+      complete = (header.state & STATE_COMPLETE) && !(header.state & STATE_OPEN);
+      coverageStartSecs = header.coverageStartSecs;
+
+      if(header.state & STATE_OPEN)
+         LogContext(__func__).log(Log_NOTICE, "Dropping dirty chunk journal after unclean "
+            "shutdown. The next buddy resync will check all chunks. Path: " + path);
+   }
+   else
+      LogContext(__func__).log(Log_WARNING, "Dropping invalid dirty chunk journal: " + path);
+
+   struct stat statBuf;
+
+   if(fstat(fd, &statBuf) == 0)
+      fileSize = statBuf.st_size;
+   else
+      complete = false;
+
+   std::lock_guard<Mutex> lock(mutex);
+
+   if(!complete || (fileSize < (off_t)sizeof(FileHeader) ) )
+      resetUnlocked(complete);
+   else
+   if(!writeState(STATE_COMPLETE | STATE_OPEN) )
+      complete = false;
+
+   recording = complete && buddyNeedsResync;
+   tracking = complete && recentWindowSecs;
+
+   // (the changes before this start are unknown if the buddy was marked as needing a resync
+   // without recording)
+   if(recording && !coverageStartSecs)
+      coverageStartSecs = recentPrunedUpToSecs;
+}
+
+/**
+ * Writes the buffered records and marks the journal as cleanly closed.
+ */
+DirtyChunkJournal::~DirtyChunkJournal()
+{
+   if(fd == -1)
+      return;
+
+   {
+      std::lock_guard<Mutex> lock(mutex);
+
+      if(complete && flushUnlocked() )
+         writeState(STATE_COMPLETE);
+      else
+         writeState(0);
+   }
+
+   close(fd);
+}
+
+/**
+ * Record a change of a chunk (if recording is active), or remember it as a recent change.
+ *
+ * @param chunkPath path of the chunk relative to the buddy mirror dir
+ */
+void DirtyChunkJournal::add(RecordType type, const std::string& chunkPath, int64_t offset,
+   int64_t len)
+{
+   if(!isActive() )
+      return;
+
+   std::lock_guard<Mutex> lock(mutex);
+
+   if(unlikely(chunkPath.size() > UINT16_MAX) )
+   {
+      resetUnlocked(false);
+      return;
+   }
+
+   if(recording)
+      addRecordUnlocked(type, chunkPath, offset, len);
+   else
+   if(tracking)
+      addRecentUnlocked(type, chunkPath, offset, len);
+}
+
+/**
+ * Called when the buddy was marked as needing a resync. Turns the recent changes into records,
+ * because the buddy might have lost them.
+ */
+void DirtyChunkJournal::startRecording()
+{
+   numRecordingStarts.fetch_add(1, std::memory_order_relaxed);
+
+   if(recording.load(std::memory_order_relaxed) )
+      return;
+
+   std::lock_guard<Mutex> lock(mutex);
+
+   if(!complete || recording)
+      return;
+
+   // records might already exist if the buddy failed again during a resync, they can only be
+   // combined with the recent changes if nothing was pruned since the recording stopped
+   if(!coverageStartSecs || (recentPrunedUpToSecs > recordingStopSecs) )
+      coverageStartSecs = recentPrunedUpToSecs;
+
+   std::unordered_map<std::string, RecentChunk> recent;
+   recent.swap(recentChunks);
+
+   for(const auto& entry : recent)
+   {
+      if(!complete)
+         break; // (records were lost on flush)
+
+      const DirtyChunk& chunk = entry.second.chunk;
+
+      if(chunk.fullSync)
+         addRecordUnlocked(RecordType_UNLINK, entry.first, 0, 0);
+      else
+      if(chunk.ranges.empty() )
+         addRecordUnlocked(RecordType_ATTRIBS, entry.first, 0, 0);
+
+      for(const auto& range : chunk.ranges)
+         addRecordUnlocked(RecordType_WRITE, entry.first, range.first,
+            range.second - range.first);
+   }
+
+   if(!complete || !writeState(STATE_COMPLETE | STATE_OPEN) )
+   {
+      resetUnlocked(false);
+      return;
+   }
+
+   recording = true;
+
+   // (everything goes to the records now)
+   recentPrunedUpToSecs = time(NULL);
+   lastRecentPruneSecs = recentPrunedUpToSecs;
+}
+
+/**
+ * Stops recording and reads the chunks which were modified since the buddy was last in sync.
+ *
+ * Note: Must be called by a resync before it starts processing chunks (and after all workers
+ * finished the requests which started before the resync).
+ *
+ * @param sinceSecs the journal must contain all changes since this time (last buddy communication
+ *    minus the safety threshold)
+ * @return false if the journal is not complete (so the resync must check all chunks)
+ */
+bool DirtyChunkJournal::startResync(DirtyChunkMap& outDirtyChunks, int64_t sinceSecs)
+{
+   std::lock_guard<Mutex> lock(mutex);
+
+   if(recording)
+      recordingStopSecs = time(NULL);
+
+   recording = false;
+   numRecordingStartsAtResync = numRecordingStarts.load();
+
+   if(!complete || !flushUnlocked() )
+      return false;
+
+   if(!coverageStartSecs || (coverageStartSecs > sinceSecs) )
+   {
+      LogContext(__func__).log(Log_NOTICE, "Dirty chunk journal doesn't reach back to the last "
+         "buddy communication minus the safety threshold, the buddy resync will check all chunks. "
+         "Path: " + path);
+      return false;
+   }
+
+   if(!readDirtyChunks(outDirtyChunks) )
+   {
+      resetUnlocked(false);
+      return false;
+   }
+
+   return true;
+}
+
+/**
+ * Called after a successful resync to drop the records (and to make the journal complete again).
+ * If the buddy failed again during the resync, the journal is kept for the next resync.
+ */
+void DirtyChunkJournal::finishResync()
+{
+   if(fd == -1)
+      return;
+
+   std::lock_guard<Mutex> lock(mutex);
+
+   if(numRecordingStarts.load() != numRecordingStartsAtResync)
+      return;
+
+   resetUnlocked(true);
+}
+
+void DirtyChunkJournal::addRecordUnlocked(RecordType type, const std::string& chunkPath,
+   int64_t offset, int64_t len)
+{
+   if(type == RecordType_WRITE)
+   { // merge with the previous write to the same chunk if the ranges overlap or touch
+      auto iter = bufRecordPos.find(chunkPath);
+
+      if(iter != bufRecordPos.end() )
+      {
+         RecordHeader prev;
+         memcpy(&prev, &buf[iter->second], sizeof(prev) );
+
+         if( (prev.type == RecordType_WRITE) && (offset <= prev.offset + prev.len) &&
+            (offset + len >= prev.offset) )
+         {
+            int64_t start = std::min(offset, prev.offset);
+            int64_t end = std::max(offset + len, prev.offset + prev.len);
+
+            prev.offset = start;
+            prev.len = end - start;
+            memcpy(&buf[iter->second], &prev, sizeof(prev) );
+            return;
+         }
+      }
+   }
+
+   RecordHeader header;
+
+   memset(&header, 0, sizeof(header) );
+   header.pathLen = chunkPath.size();
+   header.type = type;
+   header.offset = offset;
+   header.len = len;
+
+   bufRecordPos[chunkPath] = buf.size();
+
+   buf.insert(buf.end(), (const char*)&header, (const char*)&header + sizeof(header) );
+   buf.insert(buf.end(), chunkPath.begin(), chunkPath.end() );
+
+   if(buf.size() >= DIRTYCHUNKJOURNAL_BUF_SIZE)
+      flushUnlocked();
+}
+
+/**
+ * Remember a change while not recording, in case the buddy failed without noticing it.
+ */
+void DirtyChunkJournal::addRecentUnlocked(RecordType type, const std::string& chunkPath,
+   int64_t offset, int64_t len)
+{
+   const int64_t nowSecs = time(NULL);
+
+   if(nowSecs - lastRecentPruneSecs >= recentWindowSecs / 2)
+      pruneRecentUnlocked(nowSecs);
+
+   RecentChunk& recent = recentChunks[chunkPath];
+   DirtyChunk& chunk = recent.chunk;
+
+   recent.lastChangeSecs = nowSecs;
+
+   if(chunk.fullSync)
+      return;
+
+   switch(type)
+   {
+      case RecordType_WRITE:
+      case RecordType_TRUNC: // (data after the new size might be rewritten later)
+      {
+         const int64_t end = (type == RecordType_WRITE) ? offset + len : INT64_MAX;
+
+         // merge with the last range if they overlap or touch (e.g. appends)
+         if(!chunk.ranges.empty() && (offset <= chunk.ranges.back().second) &&
+            (end >= chunk.ranges.back().first) )
+         {
+            chunk.ranges.back().first = std::min(chunk.ranges.back().first, offset);
+            chunk.ranges.back().second = std::max(chunk.ranges.back().second, end);
+         }
+         else
+            chunk.ranges.push_back(std::make_pair(offset, end) );
+
+         if(chunk.ranges.size() > DIRTYCHUNKJOURNAL_MAX_RANGES)
+         {
+            chunk.fullSync = true;
+            chunk.ranges.clear();
+         }
+      } break;
+
+      case RecordType_UNLINK:
+      {
+         chunk.fullSync = true;
+         chunk.ranges.clear();
+      } break;
+
+      default: // (attribs are always synced)
+         break;
+   }
+
+   if(recentChunks.size() > DIRTYCHUNKJOURNAL_MAX_RECENT)
+   { // too many chunks to remember, a resync that needs them must check all chunks
+      recentChunks.clear();
+      recentPrunedUpToSecs = nowSecs;
+   }
+}
+
+/**
+ * Forget the changes which are older than the window.
+ */
+void DirtyChunkJournal::pruneRecentUnlocked(int64_t nowSecs)
+{
+   const int64_t cutoffSecs = nowSecs - recentWindowSecs;
+
+   for(auto iter = recentChunks.begin(); iter != recentChunks.end(); )
+   {
+      if(iter->second.lastChangeSecs < cutoffSecs)
+         iter = recentChunks.erase(iter);
+      else
+         ++iter;
+   }
+
+   recentPrunedUpToSecs = std::max(recentPrunedUpToSecs, cutoffSecs);
+   lastRecentPruneSecs = nowSecs;
+}
+
+/**
+ * Append the buffered records to the journal file. Makes the journal incomplete on errors or if
+ * it gets too large.
+ *
+ * @return false if the journal is incomplete now
+ */
+bool DirtyChunkJournal::flushUnlocked()
+{
+   if(buf.empty() )
+      return complete;
+
+   if(fileSize + buf.size() > DIRTYCHUNKJOURNAL_MAX_SIZE)
+   {
+      LogContext(__func__).log(Log_NOTICE, "Dirty chunk journal reached its size limit, the "
+         "next buddy resync will check all chunks. Path: " + path);
+
+      resetUnlocked(false);
+      return false;
+   }
+
+   size_t numWritten = 0;
+
+   while(numWritten < buf.size() )
+   {
+      ssize_t writeRes = pwrite(fd, buf.data() + numWritten, buf.size() - numWritten,
+         fileSize + numWritten);
+
+      if(writeRes <= 0)
+      {
+         LogContext(__func__).logErr("Unable to write dirty chunk journal: " + path +
+            ". SysErr: " + System::getErrString() );
+
+         resetUnlocked(false);
+         return false;
+      }
+
+      numWritten += writeRes;
+   }
+
+   fileSize += buf.size();
+   buf.clear();
+   bufRecordPos.clear();
+
+   return true;
+}
+
+/**
+ * Drop all records.
+ *
+ * @param markComplete true if the buddy is in sync now, false if records were lost.
+ */
+void DirtyChunkJournal::resetUnlocked(bool markComplete)
+{
+   buf.clear();
+   bufRecordPos.clear();
+
+   // (changes might not have been remembered while the journal was incomplete)
+   if(!complete)
+      recentPrunedUpToSecs = time(NULL);
+
+   complete = markComplete;
+   coverageStartSecs = 0;
+
+   if( (ftruncate(fd, sizeof(FileHeader) ) == -1) ||
+      !writeState(complete ? (STATE_COMPLETE | STATE_OPEN) : STATE_OPEN) )
+   {
+      LogContext(__func__).logErr("Unable to reset dirty chunk journal: " + path +
+         ". SysErr: " + System::getErrString() );
+
+      complete = false;
+   }
+
+   fileSize = sizeof(FileHeader);
+
+   if(!complete)
+   {
+      recording = false;
+      recentChunks.clear();
+   }
+
+   tracking = complete && recentWindowSecs;
+}
+
+bool DirtyChunkJournal::writeState(uint32_t state)
+{
+   FileHeader header;
+
+   memset(&header, 0, sizeof(header) );
+   header.magic = DIRTYCHUNKJOURNAL_MAGIC;
+   header.version = DIRTYCHUNKJOURNAL_VERSION;
+   header.state = state;
+   header.coverageStartSecs = coverageStartSecs;
+
+   if(pwrite(fd, &header, sizeof(header), 0) != sizeof(header) )
+      return false;
+
+   return fdatasync(fd) == 0;
+}
+
+/**
+ * Read all records from the journal file and merge them per chunk.
+ */
+bool DirtyChunkJournal::readDirtyChunks(DirtyChunkMap& outDirtyChunks)
+{
+   std::vector<char> readBuf(DIRTYCHUNKJOURNAL_READ_BUF_SIZE);
+   size_t bufLen = 0; // valid bytes in readBuf
+   size_t bufPos = 0; // current record in readBuf
+   off_t readOffset = sizeof(FileHeader);
+
+   for( ; ; )
+   {
+      RecordHeader header;
+
+      // make sure that the next record is completely in the buffer
+      if(bufLen - bufPos < sizeof(header) ||
+         bufLen - bufPos < sizeof(header) + ( (RecordHeader*)&readBuf[bufPos])->pathLen)
+      {
+         if(readOffset == fileSize)
+         {
+            if(bufLen != bufPos)
+               return false; // truncated record
+
+            break;
+         }
+
+         memmove(readBuf.data(), &readBuf[bufPos], bufLen - bufPos);
+         bufLen -= bufPos;
+         bufPos = 0;
+
+         size_t readLen = std::min<off_t>(readBuf.size() - bufLen, fileSize - readOffset);
+         ssize_t readRes = pread(fd, &readBuf[bufLen], readLen, readOffset);
+
+         if(readRes <= 0)
+         {
+            LogContext(__func__).logErr("Unable to read dirty chunk journal: " + path +
+               ". SysErr: " + System::getErrString() );
+            return false;
+         }
+
+         bufLen += readRes;
+         readOffset += readRes;
+         continue;
+      }
+
+      memcpy(&header, &readBuf[bufPos], sizeof(header) );
+
+      std::string chunkPath(&readBuf[bufPos + sizeof(header)], header.pathLen);
+      DirtyChunk& chunk = outDirtyChunks[chunkPath];
+
+      bufPos += sizeof(header) + header.pathLen;
+
+      switch(header.type)
+      {
+         case RecordType_WRITE:
+            chunk.ranges.push_back(std::make_pair(header.offset, header.offset + header.len) );
+            break;
+
+         case RecordType_TRUNC: // data after the new size might have been rewritten since
+            chunk.ranges.push_back(std::make_pair(header.offset, INT64_MAX) );
+            break;
+
+         case RecordType_UNLINK: // might have been re-created since
+            chunk.fullSync = true;
+            break;
+
+         case RecordType_ATTRIBS: // (attribs are always synced)
+            break;
+
+         default:
+            return false;
+      }
+   }
+
+   // merge the ranges of each chunk
+
+   for(auto& entry : outDirtyChunks)
+   {
+      DirtyChunk& chunk = entry.second;
+
+      if(chunk.fullSync || (chunk.ranges.size() > DIRTYCHUNKJOURNAL_MAX_RANGES) )
+      {
+         chunk.fullSync = true;
+         chunk.ranges.clear();
+         continue;
+      }
+
+      std::sort(chunk.ranges.begin(), chunk.ranges.end() );
+
+      ChunkRangeVec merged;
+
+      for(const auto& range : chunk.ranges)
+      {
+         if(!merged.empty() && (range.first <= merged.back().second) )
+            merged.back().second = std::max(merged.back().second, range.second);
+         else
+            merged.push_back(range);
+      }
+
+      chunk.ranges.swap(merged);
+   }
+
+   return true;
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <common/Common.h>
+#include <common/threading/Mutex.h>
+
+#include <atomic>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+
+#define DIRTYCHUNKJOURNAL_FILENAME        ".buddyresyncjournal"
+#define DIRTYCHUNKJOURNAL_MAX_SIZE        (256*1024*1024) // larger journals are dropped
+#define DIRTYCHUNKJOURNAL_MAX_RANGES      1024 // per chunk; more ranges mean full sync of the chunk
+#define DIRTYCHUNKJOURNAL_MAX_RECENT      (256*1024) // recently modified chunks kept in memory
+
+
+typedef std::vector<std::pair<int64_t, int64_t> > ChunkRangeVec; // [start, end) byte ranges
+
+/**
+ * A chunk that was modified while the buddy was not in sync.
+ */
+struct DirtyChunk
+{
+   DirtyChunk() : fullSync(false) {}
+
+   bool fullSync; // true if the chunk must be synced completely (e.g. it was unlinked)
+   ChunkRangeVec ranges; // sorted and merged written ranges (if not fullSync)
+};
+
+typedef std::map<std::string, DirtyChunk> DirtyChunkMap; // key: path relative to buddymir dir
+
+
+/**
+ * Append-only journal of the buddy mirrored chunks that were modified on a primary target while
+ * its secondary needs a resync, so that a resync doesn't need to walk the whole chunk tree.
+ *
+ * The journal is "complete" if it contains (at least) all changes since the buddy was last in
+ * sync. It becomes incomplete e.g. after an unclean shutdown (records are buffered in memory) or
+ * if it gets too large, and becomes complete again after the next successful resync.
+ *
+ * Recording starts when the buddy is marked as needing a resync and stops when a resync starts to
+ * consume the journal.
+ *
+ * The buddy might also have lost changes that it acknowledged shortly before it failed (the resync
+ * safety threshold window before the last buddy communication). So while not recording, the
+ * chunks that were modified within the last recentWindowSecs (twice the safety threshold) are
+ * kept in memory and become records when the recording starts. A resync can only use the journal
+ * if it covers all changes since the last buddy communication minus the safety threshold.
+ */
+class DirtyChunkJournal
+{
+   public:
+      enum RecordType
+      {
+         RecordType_WRITE = 1, // offset, len
+         RecordType_TRUNC = 2, // offset is the new size
+         RecordType_UNLINK = 3,
+         RecordType_ATTRIBS = 4,
+      };
+
+      DirtyChunkJournal(const std::string& path, bool isEnabled, bool buddyNeedsResync,
+         unsigned recentWindowSecs);
+      ~DirtyChunkJournal();
+
+      DirtyChunkJournal(const DirtyChunkJournal&) = delete;
+      DirtyChunkJournal& operator=(const DirtyChunkJournal&) = delete;
+
+      void add(RecordType type, const std::string& chunkPath, int64_t offset, int64_t len);
+
+      void startRecording();
+      bool startResync(DirtyChunkMap& outDirtyChunks, int64_t sinceSecs);
+      void finishResync();
+
+
+   private:
+      enum
+      {
+         STATE_COMPLETE = 1,
+         STATE_OPEN = 2, // set while the journal is used (to detect unclean shutdowns)
+      };
+
+      struct FileHeader
+      {
+         uint32_t magic;
+         uint32_t version;
+         uint32_t state;
+         uint32_t coverageStartSecs; // records contain all changes since this time
+      };
+
+      struct RecordHeader
+      {
+         uint16_t pathLen;
+         uint8_t type;
+         uint8_t reserved[5];
+         int64_t offset;
+         int64_t len;
+      };
+
+      struct RecentChunk
+      {
+         int64_t lastChangeSecs;
+         DirtyChunk chunk;
+      };
+
+      std::string path;
+      int fd;
+      unsigned recentWindowSecs;
+
+      Mutex mutex; // protects all below (except the atomics)
+      bool complete;
+      std::atomic<bool> recording;
+      std::atomic<bool> tracking; // complete, so recent changes are kept while not recording
+      int64_t coverageStartSecs; // 0 if unknown
+
+      off_t fileSize; // of the records on disk (including the header)
+
+      // to detect buddy failures during a resync (changes which were not forwarded)
+      std::atomic<uint64_t> numRecordingStarts;
+      uint64_t numRecordingStartsAtResync;
+
+      std::vector<char> buf; // records which are not written yet
+      std::unordered_map<std::string, size_t> bufRecordPos; // chunkPath => last record in buf
+
+      std::unordered_map<std::string, RecentChunk> recentChunks; // modified while not recording
+      int64_t recentPrunedUpToSecs; // recentChunks contain all changes since this time
+      int64_t lastRecentPruneSecs;
+      int64_t recordingStopSecs; // by the last resync (0 if unknown)
+
+      void addRecordUnlocked(RecordType type, const std::string& chunkPath, int64_t offset,
+         int64_t len);
+      void addRecentUnlocked(RecordType type, const std::string& chunkPath, int64_t offset,
+         int64_t len);
+      void pruneRecentUnlocked(int64_t nowSecs);
+      bool flushUnlocked();
+      void resetUnlocked(bool markComplete);
+      bool writeState(uint32_t state);
+      bool readDirtyChunks(DirtyChunkMap& outDirtyChunks);
+
+
+   public:
+      // inliners
+
+      /**
+       * Quick check for the callers of add(), to skip building the chunk path if nothing would
+       * be recorded or kept as a recent change.
+       */
+      bool isActive() const
+      {
+         return recording.load(std::memory_order_relaxed) ||
+            tracking.load(std::memory_order_relaxed);
+      }
+};
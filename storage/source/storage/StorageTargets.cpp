@@ -25,6 +25,10 @@ StorageTarget::StorageTarget(Path path, uint16_t targetID, TimerQueue& timerQueu
    path(std::move(path)), id(targetID),
    buddyNeedsResyncFile((this->path / BUDDY_NEEDS_RESYNC_FILENAME).str(), S_IRUSR | S_IWUSR),
    lastBuddyCommFile((this->path / LAST_BUDDY_COMM_TIMESTAMP_FILENAME).str(), S_IRUSR | S_IWUSR),
+   dirtyChunkJournal((this->path / DIRTYCHUNKJOURNAL_FILENAME).str(),
+      Program::getApp()->getConfig()->getSysResyncUseJournal(), getBuddyNeedsResync(),
+      2 * std::max<int64_t>(0, Program::getApp()->getConfig()->getSysResyncSafetyThresholdMins())
+         * 60),
    timerQueue(timerQueue), mgmtNodes(mgmtNodes),
    buddyGroupMapper(buddyGroupMapper), buddyResyncInProgress(false),
    consistencyState(TargetConsistencyState_GOOD), cleanShutdown(false)
@@ -85,6 +89,11 @@ bool StorageTarget::isTargetDir(const Path& path)
 
 void StorageTarget::setBuddyNeedsResync(bool needsResync)
 {
+   // (also if the buddy is already known to need a resync, because a running resync might have
+   // stopped the recording)
+   if (needsResync)
+      dirtyChunkJournal.startRecording();
+
    const RWLockGuard lock(rwlock, SafeRWLock_WRITE);
 
    const auto oldState = buddyNeedsResyncFile.read().get_value_or(BUDDY_RESYNC_NOT_REQUIRED);
@@ -11,6 +11,7 @@
 #include <common/toolkit/PreallocatedFile.h>
 #include <common/components/TimerQueue.h>
 #include <app/config/Config.h>
+#include <storage/DirtyChunkJournal.h>
 #include <storage/QuotaBlockDevice.h>
 
 #include <boost/optional.hpp>
@@ -41,6 +42,7 @@ class StorageTarget
       const FDHandle& getChunkFD() const { return chunkFD; }
       const FDHandle& getMirrorFD() const { return mirrorFD; }
       const QuotaBlockDevice& getQuotaBlockDevice() const { return quotaBlockDevice; }
+      DirtyChunkJournal& getDirtyChunkJournal() { return dirtyChunkJournal; }
 
       TargetConsistencyState getConsistencyState() const
       {
@@ -171,6 +173,7 @@ class StorageTarget
       FDHandle mirrorFD;
       PreallocatedFile<uint8_t> buddyNeedsResyncFile;
       PreallocatedFile<LastBuddyComm> lastBuddyCommFile;
+      DirtyChunkJournal dirtyChunkJournal; // (after buddyNeedsResyncFile for init order)
       QuotaBlockDevice quotaBlockDevice; // quota related information about the block device
       TimerQueue& timerQueue;
       NodeStoreServers& mgmtNodes;
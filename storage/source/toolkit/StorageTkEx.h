@@ -7,6 +7,8 @@
 #include <common/storage/Storagedata.h>
 #include <common/storage/StorageErrors.h>
 #include <common/threading/Mutex.h>
+#include <common/toolkit/ChecksumTk.h>
+#include <common/toolkit/HashTk.h>
 #include <common/toolkit/StorageTk.h>
 #include <common/threading/SafeRWLock.h>
 
@@ -60,5 +62,15 @@ class StorageTkEx
          
          return true;
       }
+
+      /**
+       * Digest of a chunk file block for the block-digest exchange of a resync. Combines two
+       * independent 32-bit hashes, so that a changed block is missed with a probability of about
+       * 2^-64.
+       */
+      static uint64_t getBlockDigest(const char* buf, size_t len)
+      {
+         return ( (uint64_t)HashTk::hsieh32(buf, len) << 32) | ChecksumTk::crc32c(0, buf, len);
+      }
 };
 
@@ -0,0 +1,95 @@
+#include <net/msghelpers/AsyncFileWriter.h>
+
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+class TestAsyncFileWriter : public ::testing::Test
+{
+   protected:
+      std::string filePath;
+      int fd;
+
+      void SetUp() override
+      {
+         char pathTemplate[] = "/tmp/beegfs-test-asyncwriter.XXXXXX";
+
+         fd = mkstemp(pathTemplate);
+         ASSERT_NE(fd, -1);
+
+         filePath = pathTemplate;
+      }
+
+      void TearDown() override
+      {
+         close(fd);
+         unlink(filePath.c_str() );
+      }
+};
+
+TEST_F(TestAsyncFileWriter, pipelinedWrites)
+{
+   const size_t numRequests = 8;
+   const size_t bufSize = 64 * 1024;
+
+   ThreadAsyncFileWriter writer("TestWriter");
+   writer.start();
+
+   // (like WriteLocalFileMsgEx, all buffers are submitted before the first one is waited for)
+   std::vector<std::vector<char> > bufs;
+   AsyncFileWriter::Request requests[numRequests];
+
+   for(size_t i = 0; i < numRequests; i++)
+   {
+      bufs.push_back(std::vector<char>(bufSize, (char)('a' + i) ) );
+      requests[i] = {fd, &bufs[i][0], bufSize, (off_t)(i * bufSize), 0, 0, false};
+
+      writer.submit(requests[i]);
+   }
+
+   for(size_t i = 0; i < numRequests; i++)
+   {
+      writer.waitForCompletion(requests[i]);
+
+      ASSERT_TRUE(requests[i].isDone);
+      ASSERT_EQ(requests[i].writeRes, (ssize_t)bufSize);
+      ASSERT_EQ(requests[i].errCode, 0);
+   }
+
+   std::vector<char> readBuf(bufSize);
+
+   for(size_t i = 0; i < numRequests; i++)
+   {
+      ASSERT_EQ(pread(fd, &readBuf[0], bufSize, i * bufSize), (ssize_t)bufSize);
+      ASSERT_EQ(readBuf, bufs[i]) << "request " << i;
+   }
+}
+
+TEST_F(TestAsyncFileWriter, failedWrite)
+{
+   ThreadAsyncFileWriter writer("TestWriter");
+   writer.start();
+
+   int readOnlyFD = open(filePath.c_str(), O_RDONLY);
+   ASSERT_NE(readOnlyFD, -1);
+
+   std::vector<char> buf(4096, 'x');
+
+   AsyncFileWriter::Request failingRequest = {readOnlyFD, &buf[0], buf.size(), 0, 0, 0, false};
+   AsyncFileWriter::Request nextRequest = {fd, &buf[0], buf.size(), 0, 0, 0, false};
+
+   writer.submit(failingRequest);
+   writer.submit(nextRequest);
+
+   // the error is reported like a failed pwrite() ...
+   writer.waitForCompletion(failingRequest);
+   ASSERT_EQ(failingRequest.writeRes, -1);
+   ASSERT_EQ(failingRequest.errCode, EBADF);
+
+   // ... and doesn't affect the following requests
+   writer.waitForCompletion(nextRequest);
+   ASSERT_EQ(nextRequest.writeRes, (ssize_t)buf.size() );
+
+   close(readOnlyFD);
+}
@@ -0,0 +1,354 @@
+#include <common/toolkit/ChecksumTk.h>
+#include <storage/ChunkChecksums.h>
+
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/xattr.h>
+#include <unistd.h>
+
+class TestChunkChecksums : public ::testing::Test
+{
+   protected:
+      std::string dirPath;
+      std::string filePath;
+      bool xattrsSupported;
+
+      void SetUp() override
+      {
+         char dirTemplate[] = "/tmp/beegfs-test-chunkchecksums.XXXXXX";
+
+         ASSERT_NE(mkdtemp(dirTemplate), nullptr);
+         dirPath = dirTemplate;
+         filePath = dirPath + "/chunk";
+
+         int fd = open(filePath.c_str(), O_CREAT | O_RDWR, 0600);
+         ASSERT_NE(fd, -1);
+
+         xattrsSupported = !fsetxattr(fd, "user.beegfs.test", "1", 1, 0);
+
+         close(fd);
+      }
+
+      void TearDown() override
+      {
+         unlink(filePath.c_str() );
+         rmdir(dirPath.c_str() );
+      }
+
+      /**
+       * Write like WriteLocalFileMsgEx does: data in multiple parts, checksums on the side.
+       *
+       * @param fd might be write-only, like the fd of a write session
+       */
+      static void writeChunk(int fd, const std::vector<char>& data, off_t offset)
+      {
+         ChunkChecksumWriter writer(NULL, 1, "chunk", fd, offset, data.size() );
+
+         writer.begin();
+
+         for(size_t pos = 0; pos < data.size(); pos += 10000)
+         {
+            const size_t len = std::min<size_t>(10000, data.size() - pos);
+
+            ASSERT_EQ(pwrite(fd, &data[pos], len, offset + pos), (ssize_t)len);
+            writer.update(&data[pos], len);
+         }
+
+         writer.finish(true);
+      }
+
+      static std::vector<char> makeData(size_t len, char seed)
+      {
+         std::vector<char> data(len);
+
+         for(size_t i = 0; i < len; i++)
+            data[i] = (char)(seed + i * 7 + i / 251);
+
+         return data;
+      }
+
+      /**
+       * Check that the stored checksum of the block matches the current file contents.
+       */
+      static void expectBlockMatches(int readFD, size_t blockIndex)
+      {
+         ChunkChecksums checksums;
+         ASSERT_EQ(checksums.load(readFD), FhgfsOpsErr_SUCCESS);
+
+         const ChunkChecksums::Entry* entry = checksums.getEntry(blockIndex);
+         ASSERT_NE(entry, nullptr) << "block " << blockIndex;
+
+         std::vector<char> block(CHUNKCHECKSUMS_BLOCK_SIZE);
+         ssize_t readRes = pread(readFD, block.data(), block.size(),
+            (off_t)blockIndex * CHUNKCHECKSUMS_BLOCK_SIZE);
+
+         ASSERT_EQ(entry->len, (uint32_t)readRes) << "block " << blockIndex;
+         ASSERT_EQ(entry->crc, ChecksumTk::crc32c(0, block.data(), readRes) )
+            << "block " << blockIndex;
+      }
+
+      static bool isBlockKnown(int readFD, size_t blockIndex)
+      {
+         ChunkChecksums checksums;
+         checksums.load(readFD);
+
+         return checksums.getEntry(blockIndex) != NULL;
+      }
+};
+
+TEST_F(TestChunkChecksums, alignedWrite)
+{
+   if(!xattrsSupported)
+      return; // (not testable on this file system)
+
+   int fd = open(filePath.c_str(), O_RDWR);
+   ASSERT_NE(fd, -1);
+
+   writeChunk(fd, makeData(3 * CHUNKCHECKSUMS_BLOCK_SIZE, 1), 0);
+
+   for(size_t i = 0; i < 3; i++)
+      expectBlockMatches(fd, i);
+
+   ASSERT_FALSE(isBlockKnown(fd, 3) );
+
+   // data that doesn't match anymore must be detected
+   char byte = 42;
+   ASSERT_EQ(pwrite(fd, &byte, 1, CHUNKCHECKSUMS_BLOCK_SIZE + 5), 1);
+
+   ChunkChecksums checksums;
+   ASSERT_EQ(checksums.load(fd), FhgfsOpsErr_SUCCESS);
+
+   std::vector<char> block(CHUNKCHECKSUMS_BLOCK_SIZE);
+   ASSERT_EQ(pread(fd, block.data(), block.size(), CHUNKCHECKSUMS_BLOCK_SIZE),
+      CHUNKCHECKSUMS_BLOCK_SIZE);
+   ASSERT_NE(checksums.getEntry(1)->crc, ChecksumTk::crc32c(0, block.data(), block.size() ) );
+
+   close(fd);
+}
+
+TEST_F(TestChunkChecksums, unalignedWriteWithWriteOnlyFD)
+{
+   if(!xattrsSupported)
+      return; // (not testable on this file system)
+
+   int readFD = open(filePath.c_str(), O_RDWR);
+   ASSERT_NE(readFD, -1);
+
+   writeChunk(readFD, makeData(3 * CHUNKCHECKSUMS_BLOCK_SIZE, 1), 0);
+
+   // write sessions are write-only, so the partial blocks must be read back through another fd
+   int writeFD = open(filePath.c_str(), O_WRONLY);
+   ASSERT_NE(writeFD, -1);
+
+   writeChunk(writeFD, makeData(CHUNKCHECKSUMS_BLOCK_SIZE + 1000, 2),
+      CHUNKCHECKSUMS_BLOCK_SIZE / 2);
+
+   for(size_t i = 0; i < 3; i++)
+      expectBlockMatches(readFD, i);
+
+   // write within a single block
+   writeChunk(writeFD, makeData(100, 3), 2 * CHUNKCHECKSUMS_BLOCK_SIZE + 10);
+
+   for(size_t i = 0; i < 3; i++)
+      expectBlockMatches(readFD, i);
+
+   // partial last block at the end of the file
+   writeChunk(writeFD, makeData(CHUNKCHECKSUMS_BLOCK_SIZE, 4),
+      3 * CHUNKCHECKSUMS_BLOCK_SIZE - 10);
+
+   for(size_t i = 0; i < 4; i++)
+      expectBlockMatches(readFD, i);
+
+   close(writeFD);
+   close(readFD);
+}
+
+TEST_F(TestChunkChecksums, incompleteWrite)
+{
+   if(!xattrsSupported)
+      return; // (not testable on this file system)
+
+   int fd = open(filePath.c_str(), O_RDWR);
+   ASSERT_NE(fd, -1);
+
+   writeChunk(fd, makeData(4 * CHUNKCHECKSUMS_BLOCK_SIZE, 1), 0);
+
+   {
+      ChunkChecksumWriter writer(NULL, 1, "chunk", fd, CHUNKCHECKSUMS_BLOCK_SIZE,
+         2 * CHUNKCHECKSUMS_BLOCK_SIZE);
+
+      writer.begin();
+
+      // readers must not verify against the old checksums while the data is being written
+      ASSERT_FALSE(isBlockKnown(fd, 1) );
+      ASSERT_FALSE(isBlockKnown(fd, 2) );
+
+      writer.finish(false);
+   }
+
+   expectBlockMatches(fd, 0);
+   ASSERT_FALSE(isBlockKnown(fd, 1) );
+   ASSERT_FALSE(isBlockKnown(fd, 2) );
+   expectBlockMatches(fd, 3);
+
+   close(fd);
+}
+
+TEST_F(TestChunkChecksums, concurrentWritesToSameBlock)
+{
+   if(!xattrsSupported)
+      return; // (not testable on this file system)
+
+   int fd = open(filePath.c_str(), O_RDWR);
+   ASSERT_NE(fd, -1);
+
+   const std::vector<char> data1 = makeData(CHUNKCHECKSUMS_BLOCK_SIZE, 1);
+   const std::vector<char> data2 = makeData(CHUNKCHECKSUMS_BLOCK_SIZE, 2);
+
+   ChunkChecksumWriter writer1(NULL, 1, "chunk", fd, 0, data1.size() );
+   ChunkChecksumWriter writer2(NULL, 1, "chunk", fd, 0, data2.size() );
+
+   writer1.begin();
+   writer2.begin();
+
+   // writer1 writes its data first, but writer2 finishes first
+   ASSERT_EQ(pwrite(fd, data1.data(), data1.size(), 0), (ssize_t)data1.size() );
+   writer1.update(data1.data(), data1.size() );
+   ASSERT_EQ(pwrite(fd, data2.data(), data2.size(), 0), (ssize_t)data2.size() );
+   writer2.update(data2.data(), data2.size() );
+
+   writer2.finish(true);
+   ASSERT_FALSE(isBlockKnown(fd, 0) ); // writer1 is still active
+
+   writer1.finish(true);
+   expectBlockMatches(fd, 0); // must match data2, not the data of writer1
+
+   close(fd);
+}
+
+TEST_F(TestChunkChecksums, truncate)
+{
+   if(!xattrsSupported)
+      return; // (not testable on this file system)
+
+   int fd = open(filePath.c_str(), O_RDWR);
+   ASSERT_NE(fd, -1);
+
+   writeChunk(fd, makeData(4 * CHUNKCHECKSUMS_BLOCK_SIZE, 1), 0);
+
+   const off_t newSize = 2 * CHUNKCHECKSUMS_BLOCK_SIZE + 100;
+
+   ASSERT_EQ(ftruncate(fd, newSize), 0);
+   ChunkChecksums::truncate(fd, newSize);
+
+   expectBlockMatches(fd, 0);
+   expectBlockMatches(fd, 1);
+   ASSERT_FALSE(isBlockKnown(fd, 2) );
+   ASSERT_FALSE(isBlockKnown(fd, 3) );
+
+   // truncation during a write must not leave the checksums of the write's data behind
+   ChunkChecksumWriter writer(NULL, 1, "chunk", fd, 0, CHUNKCHECKSUMS_BLOCK_SIZE);
+   const std::vector<char> data = makeData(CHUNKCHECKSUMS_BLOCK_SIZE, 2);
+
+   writer.begin();
+   ASSERT_EQ(pwrite(fd, data.data(), data.size(), 0), (ssize_t)data.size() );
+   writer.update(data.data(), data.size() );
+
+   ASSERT_EQ(ftruncate(fd, 10), 0);
+   ChunkChecksums::truncate(fd, 10);
+   ChunkChecksumWriter::truncateActiveWrites(1, "chunk", 10);
+
+   writer.finish(true);
+   expectBlockMatches(fd, 0);
+
+   close(fd);
+}
+
+TEST_F(TestChunkChecksums, verifyIntactData)
+{
+   if(!xattrsSupported)
+      return; // (not testable on this file system)
+
+   int fd = open(filePath.c_str(), O_RDWR);
+   ASSERT_NE(fd, -1);
+
+   const std::vector<char> data = makeData(2 * CHUNKCHECKSUMS_BLOCK_SIZE + 500, 1);
+
+   writeChunk(fd, data, 0);
+
+   ChunkChecksumVerifier verifier(fd, 1, "chunk");
+   size_t badBlockIndex;
+
+   ASSERT_TRUE(verifier.isActive() );
+
+   // buffer that ends in the middle of a block (which is read completely for verification)
+   ASSERT_TRUE(verifier.verify(data.data(), 0, CHUNKCHECKSUMS_BLOCK_SIZE + 10, false,
+      badBlockIndex) );
+   ASSERT_TRUE(verifier.verify(&data[CHUNKCHECKSUMS_BLOCK_SIZE + 10],
+      CHUNKCHECKSUMS_BLOCK_SIZE + 10, data.size() - CHUNKCHECKSUMS_BLOCK_SIZE - 10, true,
+      badBlockIndex) );
+
+   close(fd);
+}
+
+TEST_F(TestChunkChecksums, rangesAreStoredSeparately)
+{
+   if(!xattrsSupported)
+      return; // (not testable on this file system)
+
+   int fd = open(filePath.c_str(), O_RDWR);
+   ASSERT_NE(fd, -1);
+
+   const size_t rangeSize = CHUNKCHECKSUMS_RANGE_BLOCKS * CHUNKCHECKSUMS_BLOCK_SIZE;
+
+   // more blocks than the old single xattr could take on ext4 (the file is sparse)
+   writeChunk(fd, makeData(2 * CHUNKCHECKSUMS_BLOCK_SIZE, 1), 0);
+   writeChunk(fd, makeData(2 * CHUNKCHECKSUMS_BLOCK_SIZE, 2), 5 * rangeSize - 1000);
+
+   const size_t lastRangeFirstBlock = 5 * CHUNKCHECKSUMS_RANGE_BLOCKS;
+
+   expectBlockMatches(fd, 0);
+   expectBlockMatches(fd, 1);
+   expectBlockMatches(fd, lastRangeFirstBlock - 1);
+   expectBlockMatches(fd, lastRangeFirstBlock);
+   expectBlockMatches(fd, lastRangeFirstBlock + 1);
+
+   // a write only touches the xattrs of its ranges
+   const std::string firstRangeXAttr = CHUNKCHECKSUMS_XATTR_PREFIX "0";
+   ASSERT_EQ(fsetxattr(fd, firstRangeXAttr.c_str(), "garbage", 7, 0), 0);
+
+   writeChunk(fd, makeData(CHUNKCHECKSUMS_BLOCK_SIZE, 3), 5 * rangeSize);
+
+   char buf[16];
+   ASSERT_EQ(fgetxattr(fd, firstRangeXAttr.c_str(), buf, sizeof(buf) ), 7);
+   expectBlockMatches(fd, lastRangeFirstBlock);
+
+   // the verifier loads the ranges as needed
+   {
+      ChunkChecksumVerifier verifier(fd, 1, "chunk");
+      size_t badBlockIndex;
+
+      ASSERT_TRUE(verifier.isActive() );
+
+      std::vector<char> data(2 * CHUNKCHECKSUMS_BLOCK_SIZE);
+      ASSERT_EQ(pread(fd, data.data(), data.size(), 5 * rangeSize - CHUNKCHECKSUMS_BLOCK_SIZE),
+         (ssize_t)data.size() );
+
+      ASSERT_TRUE(verifier.verify(data.data(), 5 * rangeSize - CHUNKCHECKSUMS_BLOCK_SIZE,
+         data.size(), false, badBlockIndex) );
+   }
+
+   // truncation drops the xattrs of the cut-off ranges
+   ASSERT_EQ(ftruncate(fd, CHUNKCHECKSUMS_BLOCK_SIZE), 0);
+   ChunkChecksums::truncate(fd, CHUNKCHECKSUMS_BLOCK_SIZE);
+
+   const std::string lastRangeXAttr = CHUNKCHECKSUMS_XATTR_PREFIX "5";
+   ASSERT_EQ(fgetxattr(fd, lastRangeXAttr.c_str(), buf, sizeof(buf) ), -1);
+
+   ChunkChecksums::invalidate(fd);
+   ASSERT_FALSE(ChunkChecksums::exists(fd) );
+
+   close(fd);
+}
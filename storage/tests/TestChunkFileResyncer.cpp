@@ -0,0 +1,41 @@
+#include <components/buddyresyncer/ChunkFileResyncer.h>
+
+#include <gtest/gtest.h>
+
+class TestChunkFileResyncer : public ::testing::Test
+{
+   protected:
+      static const ssize_t blockSize = 1024 * 1024; // (SYNC_BLOCK_SIZE of the resyncer)
+
+      static bool isOrdered(int64_t offset, ssize_t readRes, unsigned resyncMsgFlags)
+      {
+         return ChunkFileResyncer::isOrderedResyncBlock(offset, readRes, resyncMsgFlags);
+      }
+};
+
+TEST_F(TestChunkFileResyncer, blocksInFlight)
+{
+   // (full blocks in the middle of the chunk can be in flight together)
+   ASSERT_FALSE(isOrdered(blockSize, blockSize, 0) );
+   ASSERT_FALSE(isOrdered(7 * blockSize, blockSize, RESYNCLOCALFILEMSG_FLAG_BUDDYMIRROR) );
+   ASSERT_FALSE(isOrdered(blockSize, blockSize, RESYNCLOCALFILEMSG_FLAG_DELTA) );
+}
+
+TEST_F(TestChunkFileResyncer, firstBlockTruncates)
+{
+   // the first block truncates the destination chunk, so no other block may be in flight before
+   ASSERT_TRUE(isOrdered(0, blockSize, 0) );
+   ASSERT_TRUE(isOrdered(0, blockSize, RESYNCLOCALFILEMSG_FLAG_BUDDYMIRROR) );
+
+   // ... except in delta mode, where the destination chunk is not truncated
+   ASSERT_FALSE(isOrdered(0, blockSize, RESYNCLOCALFILEMSG_FLAG_DELTA) );
+}
+
+TEST_F(TestChunkFileResyncer, lastBlockSetsAttribs)
+{
+   // the last (short or empty) block sets the attribs and truncates, also in delta mode
+   ASSERT_TRUE(isOrdered(3 * blockSize, blockSize - 1, 0) );
+   ASSERT_TRUE(isOrdered(3 * blockSize, 0, 0) );
+   ASSERT_TRUE(isOrdered(3 * blockSize, 100, RESYNCLOCALFILEMSG_FLAG_DELTA) );
+   ASSERT_TRUE(isOrdered(0, 0, RESYNCLOCALFILEMSG_FLAG_DELTA) );
+}
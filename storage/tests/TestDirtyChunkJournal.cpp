@@ -0,0 +1,114 @@
+#include <storage/DirtyChunkJournal.h>
+
+#include <gtest/gtest.h>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+class TestDirtyChunkJournal : public ::testing::Test
+{
+   protected:
+      std::string dirPath;
+      std::string journalPath;
+
+      void SetUp() override
+      {
+         char dirTemplate[] = "/tmp/beegfs-test-dirtychunkjournal.XXXXXX";
+
+         ASSERT_NE(mkdtemp(dirTemplate), nullptr);
+         dirPath = dirTemplate;
+         journalPath = dirPath + "/" DIRTYCHUNKJOURNAL_FILENAME;
+      }
+
+      void TearDown() override
+      {
+         unlink(journalPath.c_str() );
+         rmdir(dirPath.c_str() );
+      }
+};
+
+TEST_F(TestDirtyChunkJournal, recentChangesAreRecorded)
+{
+   DirtyChunkJournal journal(journalPath, true, false, 3600);
+   const int64_t startSecs = time(NULL);
+
+   ASSERT_TRUE(journal.isActive() );
+
+   // changes while the buddy is still in sync (which it might lose in a crash)
+   journal.add(DirtyChunkJournal::RecordType_WRITE, "a", 0, 100);
+   journal.add(DirtyChunkJournal::RecordType_WRITE, "a", 100, 100);
+   journal.add(DirtyChunkJournal::RecordType_WRITE, "a", 1000, 10);
+   journal.add(DirtyChunkJournal::RecordType_UNLINK, "b", 0, 0);
+   journal.add(DirtyChunkJournal::RecordType_ATTRIBS, "c", 0, 0);
+   journal.add(DirtyChunkJournal::RecordType_TRUNC, "d", 50, 0);
+
+   journal.startRecording();
+
+   journal.add(DirtyChunkJournal::RecordType_WRITE, "e", 10, 10);
+
+   DirtyChunkMap dirtyChunks;
+
+   ASSERT_TRUE(journal.startResync(dirtyChunks, startSecs) );
+   ASSERT_EQ(dirtyChunks.size(), 5u);
+
+   ASSERT_FALSE(dirtyChunks["a"].fullSync);
+   ASSERT_EQ(dirtyChunks["a"].ranges, ChunkRangeVec({ {0, 200}, {1000, 1010} }) );
+   ASSERT_TRUE(dirtyChunks["b"].fullSync);
+   ASSERT_FALSE(dirtyChunks["c"].fullSync);
+   ASSERT_TRUE(dirtyChunks["c"].ranges.empty() );
+   ASSERT_EQ(dirtyChunks["d"].ranges, ChunkRangeVec({ {50, INT64_MAX} }) );
+   ASSERT_EQ(dirtyChunks["e"].ranges, ChunkRangeVec({ {10, 20} }) );
+
+   // recent changes are remembered again after the resync
+   journal.finishResync();
+   journal.add(DirtyChunkJournal::RecordType_WRITE, "f", 0, 10);
+   journal.startRecording();
+
+   dirtyChunks.clear();
+
+   ASSERT_TRUE(journal.startResync(dirtyChunks, startSecs) );
+   ASSERT_EQ(dirtyChunks.size(), 1u);
+   ASSERT_EQ(dirtyChunks["f"].ranges, ChunkRangeVec({ {0, 10} }) );
+}
+
+TEST_F(TestDirtyChunkJournal, coverageMustReachBack)
+{
+   const int64_t beforeSecs = time(NULL);
+   int64_t startSecs;
+
+   {
+      DirtyChunkJournal journal(journalPath, true, false, 3600);
+
+      startSecs = time(NULL);
+      journal.startRecording();
+      journal.add(DirtyChunkJournal::RecordType_WRITE, "a", 0, 100);
+   }
+
+   // the changes before the journal was opened are unknown
+   DirtyChunkJournal journal(journalPath, true, true, 3600);
+   DirtyChunkMap dirtyChunks;
+
+   ASSERT_FALSE(journal.startResync(dirtyChunks, beforeSecs - 60) );
+
+   dirtyChunks.clear();
+
+   ASSERT_TRUE(journal.startResync(dirtyChunks, startSecs) );
+   ASSERT_EQ(dirtyChunks["a"].ranges, ChunkRangeVec({ {0, 100} }) );
+}
+
+TEST_F(TestDirtyChunkJournal, noRecentWindow)
+{
+   DirtyChunkJournal journal(journalPath, true, false, 0);
+
+   ASSERT_FALSE(journal.isActive() );
+
+   journal.startRecording();
+
+   ASSERT_TRUE(journal.isActive() );
+
+   journal.add(DirtyChunkJournal::RecordType_WRITE, "a", 0, 100);
+
+   DirtyChunkMap dirtyChunks;
+
+   ASSERT_FALSE(journal.startResync(dirtyChunks, time(NULL) - 60) );
+}
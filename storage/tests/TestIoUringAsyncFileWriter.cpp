@@ -0,0 +1,148 @@
+#include <net/msghelpers/AsyncFileWriter.h>
+
+#include <gtest/gtest.h>
+
+#ifdef BEEGFS_IO_URING_SUPPORTED
+
+#include <atomic>
+#include <thread>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+class TestIoUringAsyncFileWriter : public ::testing::Test
+{
+   protected:
+      std::vector<char> workerBuf = std::vector<char>(64 * 1024, 'x');
+      IoUringAsyncFileWriter writer;
+      bool isUsable;
+
+      void SetUp() override
+      {
+         std::string errMsg;
+
+         isUsable = writer.init(&workerBuf[0], workerBuf.size(), errMsg);
+         if(!isUsable)
+            std::cerr << "io_uring not usable, skipping test: " << errMsg << std::endl;
+      }
+
+      void failRing(unsigned logIntervalMS)
+      {
+         writer.ringFailed = true;
+         writer.failedRingLogIntervalMS = logIntervalMS;
+      }
+
+      unsigned getNumSlotsInUse() const
+      {
+         return writer.numSlotsInUse;
+      }
+
+      /**
+       * @return number of bytes that were written to fill the pipe.
+       */
+      static size_t fillPipe(int writeFD)
+      {
+         size_t numFilled = 0;
+         ssize_t writeRes;
+
+         fcntl(writeFD, F_SETFL, O_NONBLOCK);
+
+         while( (writeRes = write(writeFD, "f", 1) ) == 1)
+            numFilled++;
+
+         fcntl(writeFD, F_SETFL, 0);
+
+         return numFilled;
+      }
+};
+
+TEST_F(TestIoUringAsyncFileWriter, writeToFile)
+{
+   if(!isUsable)
+      return;
+
+   char pathTemplate[] = "/tmp/beegfs-test-uringwriter.XXXXXX";
+   int fd = mkstemp(pathTemplate);
+   ASSERT_NE(fd, -1);
+   unlink(pathTemplate);
+
+   AsyncFileWriter::Request request = {fd, &workerBuf[0], workerBuf.size(), 4096, 0, 0, false};
+
+   writer.submit(request);
+   writer.waitForCompletion(request);
+
+   ASSERT_TRUE(request.isDone);
+   ASSERT_EQ(request.writeRes, (ssize_t)workerBuf.size() );
+   ASSERT_EQ(getNumSlotsInUse(), 0u);
+
+   struct stat statBuf;
+   ASSERT_EQ(fstat(fd, &statBuf), 0);
+   ASSERT_EQ(statBuf.st_size, (off_t)(4096 + workerBuf.size() ) );
+
+   close(fd);
+}
+
+TEST_F(TestIoUringAsyncFileWriter, failedRingWaitsForWritesInFlight)
+{
+   if(!isUsable)
+      return;
+
+   const size_t writeSize = 4096;
+   const std::chrono::milliseconds holdTime(300);
+
+   int pipeFDs[2];
+   ASSERT_EQ(pipe(pipeFDs), 0);
+
+   const size_t numFilled = fillPipe(pipeFDs[1]);
+
+   // the kernel can't complete this write until somebody reads from the pipe
+   AsyncFileWriter::Request request = {pipeFDs[1], &workerBuf[0], writeSize, 0, 0, 0, false};
+
+   writer.submit(request);
+
+   ASSERT_FALSE(request.isDone);
+   ASSERT_EQ(getNumSlotsInUse(), 1u);
+
+   // hold the write for several warning intervals (where the writer gave up before)
+   failRing(holdTime.count() / 5);
+
+   std::atomic<bool> drained(false);
+
+   std::thread reader([&] () {
+      std::this_thread::sleep_for(holdTime);
+
+      drained = true;
+
+      std::vector<char> readBuf(numFilled + writeSize);
+      size_t numRead = 0;
+
+      while(numRead < readBuf.size() )
+      {
+         ssize_t readRes = read(pipeFDs[0], &readBuf[numRead], readBuf.size() - numRead);
+         if(readRes <= 0)
+            break;
+
+         numRead += readRes;
+      }
+
+      EXPECT_EQ(numRead, readBuf.size() );
+   });
+
+   const auto startTime = std::chrono::steady_clock::now();
+
+   writer.waitForCompletion(request);
+
+   // the request must not be done while the kernel might still read from its buffer
+   EXPECT_TRUE(drained);
+   EXPECT_GE(std::chrono::steady_clock::now() - startTime, holdTime);
+   EXPECT_TRUE(request.isDone);
+   EXPECT_EQ(request.writeRes, (ssize_t)writeSize);
+   EXPECT_EQ(getNumSlotsInUse(), 0u);
+
+   reader.join();
+
+   close(pipeFDs[0]);
+   close(pipeFDs[1]);
+}
+
+#endif // BEEGFS_IO_URING_SUPPORTED